@@ -13,6 +13,7 @@
  *  If not, see <http://www.gnu.org/licenses/>.
  */
 
+
 #include "autosave.h"
 #include "thread.h"
 #include <stdlib.h>
@@ -20,6 +21,30 @@
 #include <string.h>
 #include <stdio.h>
 #include "general.h"
+#include "file_path.h"
+#include "endianness.h"
+#include "hash.h"
+#include "compat/strl.h"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+/* SRAM is compared and written in blocks of this size. */
+#define AUTOSAVE_BLOCK_SIZE 4096
+
+/* Blocks compared per lock, bounds how long
+ * lock_autosave() can be held up. */
+#define AUTOSAVE_LOCK_BLOCKS 16
+
+#define AUTOSAVE_JOURNAL_MAGIC "RASRAMJ\0"
+#define AUTOSAVE_JOURNAL_HEADER_SIZE 16
 
 struct autosave
 {
@@ -30,13 +55,288 @@ struct autosave
    scond_t *cond;
    sthread_t *thread;
 
-   void *buffer;
-   const void *retro_buffer;
+   /* What was last written to disk, plus dirty blocks. */
+   uint8_t *buffer;
+   const uint8_t *retro_buffer;
    const char *path;
    size_t bufsize;
    unsigned interval;
+
+   bool *dirty;
+   size_t num_blocks;
+
+   /* The file on disk does not match the buffer in size,
+    * so it has to be rewritten as a whole. */
+   bool rewrite;
+
+   uint8_t *journal;
+   size_t journal_cap;
 };
 
+static void autosave_write_le32(uint8_t *out, uint32_t val)
+{
+   val = swap_if_big32(val);
+   memcpy(out, &val, sizeof(val));
+}
+
+static uint32_t autosave_read_le32(const uint8_t *in)
+{
+   uint32_t val;
+   memcpy(&val, in, sizeof(val));
+   return swap_if_big32(val);
+}
+
+static bool autosave_block_differs(const uint8_t *a, const uint8_t *b,
+      size_t size)
+{
+   size_t i = 0;
+
+#if defined(__SSE2__)
+   for (; i + 64 <= size; i += 64)
+   {
+      __m128i x0 = _mm_xor_si128(
+            _mm_loadu_si128((const __m128i*)(a + i +  0)),
+            _mm_loadu_si128((const __m128i*)(b + i +  0)));
+      __m128i x1 = _mm_xor_si128(
+            _mm_loadu_si128((const __m128i*)(a + i + 16)),
+            _mm_loadu_si128((const __m128i*)(b + i + 16)));
+      __m128i x2 = _mm_xor_si128(
+            _mm_loadu_si128((const __m128i*)(a + i + 32)),
+            _mm_loadu_si128((const __m128i*)(b + i + 32)));
+      __m128i x3 = _mm_xor_si128(
+            _mm_loadu_si128((const __m128i*)(a + i + 48)),
+            _mm_loadu_si128((const __m128i*)(b + i + 48)));
+      __m128i x  = _mm_or_si128(_mm_or_si128(x0, x1),
+            _mm_or_si128(x2, x3));
+
+      if (_mm_movemask_epi8(_mm_cmpeq_epi8(x, _mm_setzero_si128()))
+            != 0xffff)
+         return true;
+   }
+#endif
+
+   return memcmp(a + i, b + i, size - i) != 0;
+}
+
+/* Copies changed blocks of SRAM into the buffer and marks them dirty.
+ * The lock is only held for a few blocks at a time, so the copy can
+ * span frames. The core can't expect more anyway, games spread their
+ * own saving over several frames. */
+static size_t autosave_scan(autosave_t *save)
+{
+   size_t block = 0, dirty = 0;
+
+   while (block < save->num_blocks)
+   {
+      size_t end = block + AUTOSAVE_LOCK_BLOCKS;
+      if (end > save->num_blocks)
+         end = save->num_blocks;
+
+      autosave_lock(save);
+      for (; block < end; block++)
+      {
+         size_t offset = block * AUTOSAVE_BLOCK_SIZE;
+         size_t size   = save->bufsize - offset;
+         if (size > AUTOSAVE_BLOCK_SIZE)
+            size = AUTOSAVE_BLOCK_SIZE;
+
+         if (autosave_block_differs(save->buffer + offset,
+                  save->retro_buffer + offset, size))
+         {
+            memcpy(save->buffer + offset, save->retro_buffer + offset, size);
+            save->dirty[block] = true;
+         }
+      }
+      autosave_unlock(save);
+   }
+
+   for (block = 0; block < save->num_blocks; block++)
+      dirty += save->dirty[block];
+   return dirty;
+}
+
+static bool autosave_sync(FILE *file)
+{
+   bool ret = fflush(file) == 0;
+#ifdef _WIN32
+   ret = ret && _commit(_fileno(file)) == 0;
+#else
+   ret = ret && fsync(fileno(file)) == 0;
+#endif
+   return ret;
+}
+
+/* Writes the ranges of a journal into the save file, in place. */
+static bool autosave_apply_journal(const char *path,
+      const uint8_t *journal, size_t size)
+{
+   bool ret = true;
+   const uint8_t *ptr = journal + AUTOSAVE_JOURNAL_HEADER_SIZE;
+   const uint8_t *end = journal + size - sizeof(uint32_t);
+   FILE *file = fopen(path, "r+b");
+   if (!file)
+      return false;
+
+   while (ret && ptr < end)
+   {
+      uint32_t offset = autosave_read_le32(ptr + 0);
+      uint32_t len    = autosave_read_le32(ptr + 4);
+      ptr += 8;
+
+      ret = fseek(file, offset, SEEK_SET) == 0
+         && fwrite(ptr, 1, len, file) == len;
+      ptr += len;
+   }
+
+   /* One sync for all ranges. */
+   ret = autosave_sync(file) && ret;
+   ret = fclose(file) == 0 && ret;
+   return ret;
+}
+
+static bool autosave_check_journal(const uint8_t *journal, size_t size)
+{
+   const uint8_t *ptr, *end;
+
+   if (size < AUTOSAVE_JOURNAL_HEADER_SIZE + sizeof(uint32_t)
+         || memcmp(journal, AUTOSAVE_JOURNAL_MAGIC, 8))
+      return false;
+
+   size -= sizeof(uint32_t);
+   if (crc32_calculate(journal, size) != autosave_read_le32(journal + size))
+      return false;
+
+   /* Ranges must fit into the save file. */
+   ptr = journal + AUTOSAVE_JOURNAL_HEADER_SIZE;
+   end = journal + size;
+   while (ptr < end)
+   {
+      uint32_t offset, len;
+      if (end - ptr < 8)
+         return false;
+
+      offset = autosave_read_le32(ptr + 0);
+      len    = autosave_read_le32(ptr + 4);
+      ptr   += 8;
+
+      if ((size_t)(end - ptr) < len
+            || (uint64_t)offset + len > autosave_read_le32(journal + 8))
+         return false;
+      ptr += len;
+   }
+
+   return true;
+}
+
+/* Writes the dirty blocks to a journal, syncs it, then writes them
+ * into the save file. If that is cut short, the journal is replayed
+ * on the next start by autosave_recover(). */
+static bool autosave_write_journal(autosave_t *save)
+{
+   char journal_path[PATH_MAX];
+   size_t block, size = AUTOSAVE_JOURNAL_HEADER_SIZE;
+   unsigned ranges = 0;
+   uint8_t *ptr;
+   FILE *file;
+   bool ret;
+
+   /* Worst case, every other block is dirty. */
+   size_t cap = AUTOSAVE_JOURNAL_HEADER_SIZE + save->bufsize
+      + 8 * (save->num_blocks / 2 + 1) + sizeof(uint32_t);
+   if (cap > save->journal_cap)
+   {
+      uint8_t *journal = (uint8_t*)realloc(save->journal, cap);
+      if (!journal)
+         return false;
+      save->journal     = journal;
+      save->journal_cap = cap;
+   }
+
+   ptr = save->journal + size;
+   for (block = 0; block < save->num_blocks; )
+   {
+      size_t offset, len, first = block;
+
+      if (!save->dirty[block])
+      {
+         block++;
+         continue;
+      }
+
+      /* Coalesce a run of dirty blocks into one range. */
+      while (block < save->num_blocks && save->dirty[block])
+         block++;
+
+      offset = first * AUTOSAVE_BLOCK_SIZE;
+      len    = block * AUTOSAVE_BLOCK_SIZE;
+      if (len > save->bufsize)
+         len = save->bufsize;
+      len   -= offset;
+
+      autosave_write_le32(ptr + 0, offset);
+      autosave_write_le32(ptr + 4, len);
+      memcpy(ptr + 8, save->buffer + offset, len);
+      ptr  += 8 + len;
+      ranges++;
+   }
+   size = ptr - save->journal;
+
+   memcpy(save->journal, AUTOSAVE_JOURNAL_MAGIC, 8);
+   autosave_write_le32(save->journal +  8, save->bufsize);
+   autosave_write_le32(save->journal + 12, ranges);
+   autosave_write_le32(ptr, crc32_calculate(save->journal, size));
+   size += sizeof(uint32_t);
+
+   snprintf(journal_path, sizeof(journal_path), "%s.journal", save->path);
+   if (!(file = fopen(journal_path, "wb")))
+      return false;
+
+   ret = fwrite(save->journal, 1, size, file) == size;
+   ret = autosave_sync(file) && ret;
+   ret = fclose(file) == 0 && ret;
+
+   ret = ret && autosave_apply_journal(save->path, save->journal, size);
+
+   /* A journal left behind is harmless, replaying it again
+    * writes the same data. */
+   if (ret)
+      remove(journal_path);
+   return ret;
+}
+
+/* Writes the whole file next to the old one and renames it over. */
+static bool autosave_write_full(autosave_t *save)
+{
+   char tmp_path[PATH_MAX];
+   bool ret;
+   FILE *file;
+
+   snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", save->path);
+   if (!(file = fopen(tmp_path, "wb")))
+      return false;
+
+   ret = fwrite(save->buffer, 1, save->bufsize, file) == save->bufsize;
+   ret = autosave_sync(file) && ret;
+   ret = fclose(file) == 0 && ret;
+
+#ifdef _WIN32
+   if (ret)
+      remove(save->path);
+#endif
+   ret = ret && rename(tmp_path, save->path) == 0;
+
+   if (!ret)
+   {
+      remove(tmp_path);
+      return false;
+   }
+
+   /* Left behind by a failed journaled write, now out of date. */
+   snprintf(tmp_path, sizeof(tmp_path), "%s.journal", save->path);
+   remove(tmp_path);
+   return true;
+}
+
 static void autosave_thread(void *data)
 {
    autosave_t *save = (autosave_t*)data;
@@ -45,36 +345,40 @@ static void autosave_thread(void *data)
 
    while (!save->quit)
    {
-      autosave_lock(save);
-      bool differ = memcmp(save->buffer, save->retro_buffer,
-            save->bufsize) != 0;
-      if (differ)
-         memcpy(save->buffer, save->retro_buffer, save->bufsize);
-      autosave_unlock(save);
+      size_t dirty = autosave_scan(save);
 
-      if (differ)
+      if (dirty)
       {
-         /* Should probably deal with this more elegantly. */
-         FILE *file = fopen(save->path, "wb");
-         if (file)
+         bool ret;
+
+         /* Avoid spamming down stderr ... */
+         if (first_log)
          {
-            /* Avoid spamming down stderr ... */
-            if (first_log)
-            {
-               RARCH_LOG("Autosaving SRAM to \"%s\", will continue to check every %u seconds ...\n",
-                     save->path, save->interval);
-               first_log = false;
-            }
-            else
-               RARCH_LOG("SRAM changed ... autosaving ...\n");
-
-            bool failed = false;
-            failed |= fwrite(save->buffer, 1, save->bufsize, file)
-               != save->bufsize;
-            failed |= fflush(file) != 0;
-            failed |= fclose(file) != 0;
-            if (failed)
-               RARCH_WARN("Failed to autosave SRAM. Disk might be full.\n");
+            RARCH_LOG("Autosaving SRAM to \"%s\", will continue to check every %u seconds ...\n",
+                  save->path, save->interval);
+            first_log = false;
+         }
+         else
+            RARCH_LOG("SRAM changed ... autosaving %u of %u blocks ...\n",
+                  (unsigned)dirty, (unsigned)save->num_blocks);
+
+         /* With most of the file dirty, the journal
+          * would only double the writes. */
+         if (save->rewrite || dirty * 2 > save->num_blocks)
+            ret = autosave_write_full(save);
+         else
+            ret = autosave_write_journal(save);
+
+         if (ret)
+         {
+            memset(save->dirty, 0, save->num_blocks * sizeof(*save->dirty));
+            save->rewrite = false;
+         }
+         else
+         {
+            RARCH_WARN("Failed to autosave SRAM. Disk might be full.\n");
+            /* The save file might be half written now. */
+            save->rewrite = true;
          }
       }
 
@@ -91,6 +395,8 @@ static void autosave_thread(void *data)
 autosave_t *autosave_new(const char *path, const void *data, size_t size,
       unsigned interval)
 {
+   void *file = NULL;
+   long len;
    autosave_t *handle = (autosave_t*)calloc(1, sizeof(*handle));
    if (!handle)
       return NULL;
@@ -98,15 +404,30 @@ autosave_t *autosave_new(const char *path, const void *data, size_t size,
    handle->bufsize = size;
    handle->interval = interval;
    handle->path = path;
-   handle->buffer = malloc(size);
-   handle->retro_buffer = data;
+   handle->buffer = (uint8_t*)malloc(size);
+   handle->retro_buffer = (const uint8_t*)data;
+   handle->num_blocks = (size + AUTOSAVE_BLOCK_SIZE - 1) / AUTOSAVE_BLOCK_SIZE;
+   handle->dirty = (bool*)calloc(handle->num_blocks, sizeof(*handle->dirty));
 
-   if (!handle->buffer)
+   if (!handle->buffer || !handle->dirty)
    {
+      free(handle->buffer);
+      free(handle->dirty);
       free(handle);
       return NULL;
    }
-   memcpy(handle->buffer, handle->retro_buffer, handle->bufsize);
+
+   /* Start from what is on disk, so changes made before
+    * autosaving started are written too. */
+   len = read_file(path, &file);
+   if (len == (long)size)
+      memcpy(handle->buffer, file, size);
+   else
+   {
+      memcpy(handle->buffer, handle->retro_buffer, handle->bufsize);
+      handle->rewrite = true;
+   }
+   free(file);
 
    handle->lock = slock_new();
    handle->cond_lock = slock_new();
@@ -129,6 +450,8 @@ void autosave_unlock(autosave_t *handle)
 
 void autosave_free(autosave_t *handle)
 {
+   char journal_path[PATH_MAX];
+
    if (!handle)
       return;
 
@@ -142,10 +465,51 @@ void autosave_free(autosave_t *handle)
    slock_free(handle->cond_lock);
    scond_free(handle->cond);
 
+   /* The SRAM is saved as a whole on exit,
+    * which supersedes a journal left by a failed write. */
+   snprintf(journal_path, sizeof(journal_path), "%s.journal", handle->path);
+   remove(journal_path);
+
    free(handle->buffer);
+   free(handle->dirty);
+   free(handle->journal);
    free(handle);
 }
 
+bool autosave_recover(const char *path)
+{
+   char journal_path[PATH_MAX];
+   void *journal = NULL;
+   long len;
+   bool valid, ret = false;
+
+   snprintf(journal_path, sizeof(journal_path), "%s.journal", path);
+   if (!path_file_exists(journal_path))
+      return false;
+
+   len = read_file(journal_path, &journal);
+
+   /* A journal which was not written completely means
+    * the save file itself was never touched. */
+   valid = len > 0 && autosave_check_journal((const uint8_t*)journal, len);
+   if (valid)
+   {
+      ret = autosave_apply_journal(path, (const uint8_t*)journal, len);
+      if (ret)
+         RARCH_LOG("Finished interrupted autosave of \"%s\".\n", path);
+      else
+         RARCH_WARN("Failed to finish interrupted autosave of \"%s\".\n",
+               path);
+   }
+
+   /* Keep it for the next start if it could not be applied. */
+   if (ret || !valid)
+      remove(journal_path);
+
+   free(journal);
+   return ret;
+}
+
 void lock_autosave(void)
 {
    unsigned i;
@@ -17,6 +17,7 @@
 #define __RARCH_AUTOSAVE_H
 
 #include <stddef.h>
+#include "boolean.h"
 
 typedef struct autosave autosave_t;
 
@@ -29,6 +30,10 @@ void autosave_unlock(autosave_t *handle);
 
 void autosave_free(autosave_t *handle);
 
+/* Finishes an autosave that was cut short, before the
+ * save file is loaded. Returns true if there was one. */
+bool autosave_recover(const char *path);
+
 void lock_autosave(void);
 
 void unlock_autosave(void);
@@ -356,6 +356,7 @@ static void *v4l_init(const char *device, uint64_t caps,
    v4l->scaler.out_fmt = SCALER_FMT_ARGB8888;
    v4l->scaler.in_stride = v4l->pitch;
    v4l->scaler.out_stride = v4l->width * 4;
+   v4l->scaler.threads = rarch_get_cpu_cores();
 
    if (!scaler_ctx_gen_filter(&v4l->scaler))
    {
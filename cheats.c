@@ -17,6 +17,9 @@
 #include "hash.h"
 #include "dynamic.h"
 #include "general.h"
+#include "file_path.h"
+#include "file_map.h"
+#include "endianness.h"
 #include "compat/strl.h"
 #include "compat/posix_string.h"
 
@@ -26,10 +29,17 @@
 
 #include "conf/config_file.h"
 
+#include <stdio.h>
 #include <stdlib.h>
 #include <stddef.h>
+#include <stdint.h>
 #include <string.h>
 
+#ifndef _XBOX
+#include <sys/types.h>
+#include <sys/stat.h>
+#endif
+
 #ifdef HAVE_LIBXML2
 #include <libxml/parser.h>
 #include <libxml/tree.h>
@@ -53,95 +63,566 @@ struct cheat_manager
    unsigned buf_size;
 };
 
-static char *strcat_alloc(char *dest, const char *input)
+/* Cheat index, converted once from the XML database so loading a
+ * game's cheats doesn't parse the whole thing again.
+ * All integers are little endian.
+ *
+ * Header, 32 bytes:
+ *    magic, version, number of cartridges, reserved,
+ *    size and mtime of the XML it was converted from, 64-bit each.
+ * Cartridges, 48 bytes each, sorted by SHA256:
+ *    raw SHA256, offset and size of its data, number of cheats, reserved.
+ * Data of each cartridge, NUL-terminated strings:
+ *    name, then description and code of every cheat. */
+#define CHEAT_INDEX_MAGIC 0x58444943 /* "CIDX" */
+#define CHEAT_INDEX_VERSION 1
+#define CHEAT_INDEX_HEADER_SIZE 32
+#define CHEAT_INDEX_ENTRY_SIZE 48
+
+struct cheat_index_entry
 {
-   size_t dest_len = dest ? strlen(dest) : 0;
-   size_t input_len = strlen(input);
-   size_t required_len = dest_len + input_len + 1;
+   uint8_t sha256[32];
+   uint32_t offset;
+   uint32_t size;
+   uint32_t count;
+};
 
-   char *output = (char*)realloc(dest, required_len);
-   if (!output)
-      return NULL;
+struct cheat_index_source
+{
+   uint64_t size;
+   uint64_t mtime;
+   bool valid;
+};
 
-   if (dest)
-      strlcat(output, input, required_len);
-   else
-      strlcpy(output, input, required_len);
+struct cheat_index
+{
+   const uint8_t *data;
+   size_t size;
 
-   return output;
+   /* The index file, or a freshly built index in buf. */
+   file_map_t file;
+   uint8_t *buf;
+};
+
+struct cheat_index_buf
+{
+   uint8_t *data;
+   size_t size;
+   size_t cap;
+};
+
+static uint32_t cheat_index_load32(const uint8_t *data)
+{
+   uint32_t val;
+   memcpy(&val, data, sizeof(val));
+   return swap_if_big32(val);
 }
 
-static bool xml_grab_cheat(struct cheat *cht, xmlNodePtr ptr)
+static void cheat_index_store32(uint8_t *data, uint32_t val)
 {
-   bool first;
-   if (!ptr)
-      return false;
+   val = swap_if_big32(val);
+   memcpy(data, &val, sizeof(val));
+}
 
-   memset(cht, 0, sizeof(struct cheat));
-   first = true;
+static uint64_t cheat_index_load64(const uint8_t *data)
+{
+   return cheat_index_load32(data) |
+      ((uint64_t)cheat_index_load32(data + 4) << 32);
+}
 
-   for (; ptr; ptr = ptr->next)
+static void cheat_index_store64(uint8_t *data, uint64_t val)
+{
+   cheat_index_store32(data, (uint32_t)val);
+   cheat_index_store32(data + 4, (uint32_t)(val >> 32));
+}
+
+static int cheat_index_hex(char c)
+{
+   if (c >= '0' && c <= '9')
+      return c - '0';
+   if (c >= 'a' && c <= 'f')
+      return c - 'a' + 10;
+   if (c >= 'A' && c <= 'F')
+      return c - 'A' + 10;
+   return -1;
+}
+
+static bool cheat_index_parse_sha256(uint8_t *out, const char *str)
+{
+   unsigned i;
+   for (i = 0; i < 32; i++)
    {
-      if (strcmp((const char*)ptr->name, "description") == 0)
-         cht->desc = (char*)xmlNodeGetContent(ptr);
-      else if (strcmp((const char*)ptr->name, "code") == 0)
-      {
-         xmlChar *code;
-         if (!first)
-         {
-            cht->code = strcat_alloc(cht->code, "+");
-            if (!cht->code)
-               return false;
-         }
-
-         code = (xmlChar*)xmlNodeGetContent(ptr);
-         if (!code)
-            return false;
-
-         cht->code = strcat_alloc(cht->code, (const char*)code);
-         xmlFree(code);
-         if (!cht->code)
-            return false;
-
-         first = false;
-      }
+      int hi = cheat_index_hex(str[2 * i]);
+      int lo = hi < 0 ? -1 : cheat_index_hex(str[2 * i + 1]);
+      if (lo < 0)
+         return false;
+      out[i] = (hi << 4) | lo;
+   }
+
+   return str[64] == '\0';
+}
+
+static bool cheat_index_append(struct cheat_index_buf *buf,
+      const void *data, size_t size)
+{
+   if (buf->size + size > buf->cap)
+   {
+      size_t cap = buf->cap ? buf->cap * 2 : 4096;
+      uint8_t *new_data;
+
+      while (cap < buf->size + size)
+         cap *= 2;
+
+      new_data = (uint8_t*)realloc(buf->data, cap);
+      if (!new_data)
+         return false;
+      buf->data = new_data;
+      buf->cap = cap;
    }
 
+   memcpy(buf->data + buf->size, data, size);
+   buf->size += size;
    return true;
 }
 
-static bool xml_grab_cheats(cheat_manager_t *handle, xmlNodePtr ptr)
+static bool cheat_index_append_string(struct cheat_index_buf *buf,
+      const char *str)
 {
+   if (!str)
+      str = "";
+   return cheat_index_append(buf, str, strlen(str) + 1);
+}
+
+static bool cheat_index_append_node(struct cheat_index_buf *buf,
+      xmlNodePtr node, bool terminate)
+{
+   bool ret;
+   xmlChar *content = xmlNodeGetContent(node);
+   const char *str = content ? (const char*)content : "";
+
+   ret = cheat_index_append(buf, str, strlen(str) + (terminate ? 1 : 0));
+   xmlFree(content);
+   return ret;
+}
+
+/* Description and code of a <cheat>. Multiple <code> elements are
+ * joined with '+'. */
+static bool cheat_index_append_cheat(struct cheat_index_buf *buf,
+      xmlNodePtr ptr)
+{
+   xmlNodePtr node, desc = NULL;
+   bool first = true;
+
+   for (node = ptr; node && !desc; node = node->next)
+   {
+      if (strcmp((const char*)node->name, "description") == 0)
+         desc = node;
+   }
+
+   if (!(desc ? cheat_index_append_node(buf, desc, true)
+            : cheat_index_append_string(buf, NULL)))
+      return false;
+
    for (; ptr; ptr = ptr->next)
    {
-      if (strcmp((const char*)ptr->name, "name") == 0)
+      if (strcmp((const char*)ptr->name, "code") != 0)
+         continue;
+
+      if (!first && !cheat_index_append(buf, "+", 1))
+         return false;
+      if (!cheat_index_append_node(buf, ptr, false))
+         return false;
+      first = false;
+   }
+
+   return cheat_index_append(buf, "", 1);
+}
+
+static int cheat_index_entry_compare(const void *a_, const void *b_)
+{
+   const struct cheat_index_entry *a = (const struct cheat_index_entry*)a_;
+   const struct cheat_index_entry *b = (const struct cheat_index_entry*)b_;
+   int cmp = memcmp(a->sha256, b->sha256, sizeof(a->sha256));
+
+   /* Keep duplicates in database order, the first one wins. */
+   if (cmp == 0)
+      return a->offset < b->offset ? -1 : a->offset > b->offset;
+   return cmp;
+}
+
+/* Converts the XML database to an index in memory. */
+static uint8_t *cheat_index_build(const char *path,
+      const struct cheat_index_source *src, size_t *size)
+{
+   xmlParserCtxtPtr ctx = NULL;
+   xmlDocPtr doc = NULL;
+   xmlNodePtr cur;
+   struct cheat_index_buf blob = {0};
+   struct cheat_index_entry *entries = NULL;
+   size_t num_entries = 0, cap_entries = 0;
+   size_t i, dir_size;
+   uint8_t *out = NULL;
+
+   LIBXML_TEST_VERSION;
+
+   ctx = xmlNewParserCtxt();
+   if (!ctx)
+      goto end;
+
+   doc = xmlCtxtReadFile(ctx, path, NULL, 0);
+   if (!doc)
+   {
+      RARCH_ERR("Failed to parse XML file: %s\n", path);
+      goto end;
+   }
+
+#ifdef HAVE_LIBXML2
+   if (ctx->valid == 0)
+   {
+      RARCH_ERR("Cannot validate XML file: %s\n", path);
+      goto end;
+   }
+#endif
+
+   for (cur = xmlDocGetRootElement(doc); cur; cur = cur->next)
+   {
+      if (cur->type == XML_ELEMENT_NODE
+            && strcmp((const char*)cur->name, "database") == 0)
+         break;
+   }
+
+   if (!cur)
+   {
+      RARCH_ERR("No cheat database in XML file: %s\n", path);
+      goto end;
+   }
+
+   for (cur = cur->children; cur; cur = cur->next)
+   {
+      xmlNodePtr ptr, name = NULL;
+      struct cheat_index_entry *entry;
+      xmlChar *sha256;
+      bool valid;
+
+      if (cur->type != XML_ELEMENT_NODE
+            || strcmp((const char*)cur->name, "cartridge") != 0)
+         continue;
+
+      if (num_entries == cap_entries)
       {
-         xmlChar *name = (xmlChar*)xmlNodeGetContent(ptr);
-         if (name)
-         {
-            RARCH_LOG("Found cheat for game: \"%s\"\n", name);
-            xmlFree(name);
-         }
+         struct cheat_index_entry *new_entries;
+         cap_entries = cap_entries ? cap_entries * 2 : 64;
+         new_entries = (struct cheat_index_entry*)
+            realloc(entries, cap_entries * sizeof(*entries));
+         if (!new_entries)
+            goto end;
+         entries = new_entries;
       }
-      else if (strcmp((const char*)ptr->name, "cheat") == 0)
+
+      entry = &entries[num_entries];
+      sha256 = xmlGetProp(cur, (const xmlChar*)"sha256");
+      valid = sha256 && cheat_index_parse_sha256(entry->sha256,
+            (const char*)sha256);
+      xmlFree(sha256);
+      if (!valid)
+         continue;
+
+      entry->offset = blob.size;
+      entry->count = 0;
+
+      for (ptr = cur->children; ptr && !name; ptr = ptr->next)
       {
-         if (handle->size == handle->buf_size)
-         {
-            handle->buf_size *= 2;
-            handle->cheats = (struct cheat*)
-               realloc(handle->cheats, handle->buf_size * sizeof(struct cheat));
-            if (!handle->cheats)
-               return false;
-         }
-
-         if (xml_grab_cheat(&handle->cheats[handle->size], ptr->children))
-            handle->size++;
+         if (strcmp((const char*)ptr->name, "name") == 0)
+            name = ptr;
       }
+
+      if (!(name ? cheat_index_append_node(&blob, name, true)
+               : cheat_index_append_string(&blob, NULL)))
+         goto end;
+
+      for (ptr = cur->children; ptr; ptr = ptr->next)
+      {
+         if (strcmp((const char*)ptr->name, "cheat") != 0
+               || !ptr->children)
+            continue;
+
+         if (!cheat_index_append_cheat(&blob, ptr->children))
+            goto end;
+         entry->count++;
+      }
+
+      entry->size = blob.size - entry->offset;
+      num_entries++;
+   }
+
+   qsort(entries, num_entries, sizeof(*entries), cheat_index_entry_compare);
+
+   dir_size = CHEAT_INDEX_HEADER_SIZE + num_entries * CHEAT_INDEX_ENTRY_SIZE;
+   if (dir_size + blob.size > UINT32_MAX)
+   {
+      RARCH_ERR("Cheat database is too large: %s\n", path);
+      goto end;
+   }
+
+   out = (uint8_t*)calloc(1, dir_size + blob.size);
+   if (!out)
+      goto end;
+
+   cheat_index_store32(out + 0, CHEAT_INDEX_MAGIC);
+   cheat_index_store32(out + 4, CHEAT_INDEX_VERSION);
+   cheat_index_store32(out + 8, num_entries);
+   cheat_index_store64(out + 16, src->size);
+   cheat_index_store64(out + 24, src->mtime);
+
+   for (i = 0; i < num_entries; i++)
+   {
+      uint8_t *ptr = out + CHEAT_INDEX_HEADER_SIZE
+         + i * CHEAT_INDEX_ENTRY_SIZE;
+      memcpy(ptr, entries[i].sha256, sizeof(entries[i].sha256));
+      cheat_index_store32(ptr + 32, dir_size + entries[i].offset);
+      cheat_index_store32(ptr + 36, entries[i].size);
+      cheat_index_store32(ptr + 40, entries[i].count);
+   }
+
+   if (blob.size)
+      memcpy(out + dir_size, blob.data, blob.size);
+   *size = dir_size + blob.size;
+
+   RARCH_LOG("Converted %u cartridges from cheat database \"%s\".\n",
+         (unsigned)num_entries, path);
+
+end:
+   free(entries);
+   free(blob.data);
+   if (doc)
+      xmlFreeDoc(doc);
+   if (ctx)
+      xmlFreeParserCtxt(ctx);
+   return out;
+}
+
+static void cheat_index_source(struct cheat_index_source *src,
+      const char *path)
+{
+#if defined(_XBOX)
+   src->valid = false;
+#else
+   struct stat buf;
+   src->valid = stat(path, &buf) == 0;
+   src->size  = src->valid ? (uint64_t)buf.st_size : 0;
+   src->mtime = src->valid ? (uint64_t)buf.st_mtime : 0;
+#endif
+}
+
+/* Checks the header and that the cartridge table fits. With src,
+ * also checks that the index is up to date with the XML. */
+static bool cheat_index_check(const struct cheat_index *index,
+      const struct cheat_index_source *src)
+{
+   uint64_t num;
+
+   if (index->size < CHEAT_INDEX_HEADER_SIZE
+         || cheat_index_load32(index->data) != CHEAT_INDEX_MAGIC
+         || cheat_index_load32(index->data + 4) != CHEAT_INDEX_VERSION)
+      return false;
+
+   num = cheat_index_load32(index->data + 8);
+   if (CHEAT_INDEX_HEADER_SIZE + num * CHEAT_INDEX_ENTRY_SIZE > index->size)
+      return false;
+
+   if (src && src->valid &&
+         (cheat_index_load64(index->data + 16) != src->size ||
+          cheat_index_load64(index->data + 24) != src->mtime))
+      return false;
+
+   return true;
+}
+
+/* Reads only the header, since path is usually the XML database. */
+static bool cheat_index_has_magic(const char *path)
+{
+   bool ret;
+   uint8_t header[CHEAT_INDEX_HEADER_SIZE];
+   FILE *file = fopen(path, "rb");
+   if (!file)
+      return false;
+
+   ret = fread(header, 1, sizeof(header), file) == sizeof(header)
+      && cheat_index_load32(header) == CHEAT_INDEX_MAGIC;
+   fclose(file);
+   return ret;
+}
+
+static bool cheat_index_open(struct cheat_index *index, const char *path)
+{
+   if (!file_map_open(&index->file, path, false))
+      return false;
+
+   index->data = index->file.data;
+   index->size = index->file.size;
+   return true;
+}
+
+static void cheat_index_close(struct cheat_index *index)
+{
+   file_map_close(&index->file);
+   free(index->buf);
+   memset(index, 0, sizeof(*index));
+}
+
+/* Opens the index for the database at path, which may also be an
+ * index itself. The index is kept next to the XML database, with
+ * the extension replaced by .idx, and is converted again whenever
+ * the XML changes. If it can't be written, the converted index is
+ * only used for this session. */
+static bool cheat_index_load(struct cheat_index *index, const char *path)
+{
+   char index_path[PATH_MAX], tmp_path[PATH_MAX];
+   struct cheat_index_source src;
+   uint8_t *buf;
+   size_t size = 0;
+
+   if (cheat_index_has_magic(path))
+   {
+      if (cheat_index_open(index, path) && cheat_index_check(index, NULL))
+         return true;
+      cheat_index_close(index);
+      RARCH_ERR("Cheat index is damaged: \"%s\".\n", path);
+      return false;
+   }
+
+   cheat_index_source(&src, path);
+   fill_pathname(index_path, path, ".idx", sizeof(index_path));
+
+   if (cheat_index_open(index, index_path) && cheat_index_check(index, &src))
+      return true;
+   cheat_index_close(index);
+
+   if (!(buf = cheat_index_build(path, &src, &size)))
+      return false;
+
+   /* A truncated temporary path could be renamed over anything,
+    * so rather use the cheats without writing the index. */
+   if (snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", index_path)
+         >= (int)sizeof(tmp_path))
+      RARCH_WARN("Cheat index path \"%s\" is too long, not writing it.\n",
+            index_path);
+   else if (write_file(tmp_path, buf, size) && rename(tmp_path, index_path) == 0)
+      RARCH_LOG("Wrote cheat index to \"%s\".\n", index_path);
+   else
+   {
+      remove(tmp_path);
+      RARCH_WARN("Failed to write cheat index to \"%s\".\n", index_path);
    }
 
+   index->buf  = buf;
+   index->data = buf;
+   index->size = size;
    return true;
 }
 
+/* Binary search for the first cartridge with the hash.
+ * Returns its data or NULL. */
+static const char *cheat_index_find(const struct cheat_index *index,
+      const uint8_t *sha256, uint32_t *size, unsigned *count)
+{
+   const uint8_t *entry;
+   uint32_t offset;
+   size_t lo = 0, hi = cheat_index_load32(index->data + 8);
+   size_t num = hi;
+
+   while (lo < hi)
+   {
+      size_t mid = lo + (hi - lo) / 2;
+      entry = index->data + CHEAT_INDEX_HEADER_SIZE
+         + mid * CHEAT_INDEX_ENTRY_SIZE;
+
+      if (memcmp(entry, sha256, 32) < 0)
+         lo = mid + 1;
+      else
+         hi = mid;
+   }
+
+   if (lo == num)
+      return NULL;
+
+   entry = index->data + CHEAT_INDEX_HEADER_SIZE + lo * CHEAT_INDEX_ENTRY_SIZE;
+   if (memcmp(entry, sha256, 32) != 0)
+      return NULL;
+
+   offset = cheat_index_load32(entry + 32);
+   *size  = cheat_index_load32(entry + 36);
+   *count = cheat_index_load32(entry + 40);
+
+   if (*size == 0 || (uint64_t)offset + *size > index->size
+         || index->data[offset + *size - 1] != '\0')
+      return NULL;
+
+   return (const char*)index->data + offset;
+}
+
+/* Takes the next string out of a cartridge's data. */
+static const char *cheat_index_string(const char **ptr, const char *end)
+{
+   const char *str = *ptr;
+   const char *nul = str < end
+      ? (const char*)memchr(str, '\0', end - str) : NULL;
+
+   if (!nul)
+      return NULL;
+   *ptr = nul + 1;
+   return str;
+}
+
+static bool cheat_manager_grab_cheats(cheat_manager_t *handle,
+      const char *data, uint32_t size, unsigned count)
+{
+   unsigned i;
+   const char *end = data + size;
+   const char *name = cheat_index_string(&data, end);
+
+   if (!name)
+      return false;
+   if (*name)
+      RARCH_LOG("Found cheat for game: \"%s\"\n", name);
+
+   /* The count is only trusted as far as the data goes. */
+   if (count > size / 2)
+      return false;
+
+   handle->cheats = (struct cheat*)calloc(count ? count : 1,
+         sizeof(struct cheat));
+   if (!handle->cheats)
+      return false;
+
+   for (i = 0; i < count; i++)
+   {
+      const char *desc = cheat_index_string(&data, end);
+      const char *code = desc ? cheat_index_string(&data, end) : NULL;
+      if (!code)
+         goto error;
+
+      handle->cheats[i].desc = strdup(desc);
+      handle->cheats[i].code = strdup(code);
+      handle->size++;
+      if (!handle->cheats[i].desc || !handle->cheats[i].code)
+         goto error;
+   }
+
+   return true;
+
+error:
+   /* Leaves size at 0, so that freeing the handle
+    * doesn't save over the user's cheat settings. */
+   for (i = 0; i < handle->size; i++)
+   {
+      free(handle->cheats[i].desc);
+      free(handle->cheats[i].code);
+   }
+   handle->size = 0;
+   return false;
+}
+
 static void cheat_manager_apply_cheats(cheat_manager_t *handle)
 {
    unsigned i, index;
@@ -235,89 +716,29 @@ static void cheat_manager_save_config(cheat_manager_t *handle,
 
 cheat_manager_t *cheat_manager_new(const char *path)
 {
-   xmlParserCtxtPtr ctx;
-   xmlNodePtr head, cur;
-   xmlDocPtr doc;
-   cheat_manager_t *handle;
-
-   LIBXML_TEST_VERSION;
+   struct cheat_index index = {0};
+   uint8_t sha256[32];
+   const char *data;
+   uint32_t size;
+   unsigned count;
+   cheat_manager_t *handle = NULL;
 
    pretro_cheat_reset();
 
-   ctx = NULL;
-   doc = NULL;
-   handle = (cheat_manager_t*)calloc(1, sizeof(struct cheat_manager));
-   if (!handle)
+   if (!cheat_index_parse_sha256(sha256, g_extern.sha256))
       return NULL;
 
-   head = NULL;
-   cur = NULL;
-
-   handle->buf_size = 1;
-   handle->cheats = (struct cheat*)
-      calloc(handle->buf_size, sizeof(struct cheat));
-   if (!handle->cheats)
-   {
-      handle->buf_size = 0;
-      goto error;
-   }
-
-   ctx = xmlNewParserCtxt();
-   if (!ctx)
-      goto error;
-
-   doc = xmlCtxtReadFile(ctx, path, NULL, 0);
-   if (!doc)
-   {
-      RARCH_ERR("Failed to parse XML file: %s\n", path);
-      goto error;
-   }
-
-#ifdef HAVE_LIBXML2
-   if (ctx->valid == 0)
-   {
-      RARCH_ERR("Cannot validate XML file: %s\n", path);
-      goto error;
-   }
-#endif
-
-   head = xmlDocGetRootElement(doc);
-   for (cur = head; cur; cur = cur->next)
-   {
-      if (cur->type == XML_ELEMENT_NODE
-            && strcmp((const char*)cur->name, "database") == 0)
-         break;
-   }
+   if (!cheat_index_load(&index, path))
+      return NULL;
 
-   if (!cur)
+   if (!(data = cheat_index_find(&index, sha256, &size, &count)))
       goto error;
 
-   for (cur = cur->children; cur; cur = cur->next)
-   {
-      if (cur->type != XML_ELEMENT_NODE)
-         continue;
-
-      if (strcmp((const char*)cur->name, "cartridge") == 0)
-      {
-         xmlChar *sha256 = xmlGetProp(cur, (const xmlChar*)"sha256");
-         if (!sha256)
-            continue;
-
-         if (*g_extern.sha256 && strcmp((const char*)sha256,
-                  g_extern.sha256) == 0)
-         {
-            xmlFree(sha256);
-            break;
-         }
-
-         xmlFree(sha256);
-      }
-   }
-
-   if (!cur)
+   handle = (cheat_manager_t*)calloc(1, sizeof(struct cheat_manager));
+   if (!handle)
       goto error;
 
-   if (!xml_grab_cheats(handle, cur->children))
+   if (!cheat_manager_grab_cheats(handle, data, size, count))
    {
       RARCH_ERR("Failed to grab cheats. This should not happen.\n");
       goto error;
@@ -329,19 +750,16 @@ cheat_manager_t *cheat_manager_new(const char *path)
       goto error;
    }
 
+   cheat_index_close(&index);
+
    cheat_manager_load_config(handle,
          g_settings.cheat_settings_path, g_extern.sha256);
 
-   xmlFreeDoc(doc);
-   xmlFreeParserCtxt(ctx);
    return handle;
 
 error:
    cheat_manager_free(handle);
-   if (doc)
-      xmlFreeDoc(doc);
-   if (ctx)
-      xmlFreeParserCtxt(ctx);
+   cheat_index_close(&index);
    return NULL;
 }
 
@@ -353,11 +771,12 @@ void cheat_manager_free(cheat_manager_t *handle)
 
    if (handle->cheats)
    {
-      cheat_manager_save_config(handle,
-            g_settings.cheat_settings_path, g_extern.sha256);
+      if (handle->size)
+         cheat_manager_save_config(handle,
+               g_settings.cheat_settings_path, g_extern.sha256);
       for (i = 0; i < handle->size; i++)
       {
-         xmlFree(handle->cheats[i].desc);
+         free(handle->cheats[i].desc);
          free(handle->cheats[i].code);
       }
 
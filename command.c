@@ -22,6 +22,7 @@
 
 #include "driver.h"
 #include "general.h"
+#include "performance.h"
 #include "compat/strl.h"
 #include "compat/posix_string.h"
 #include "file_path.h"
@@ -246,8 +247,14 @@ static bool cmd_set_shader(const char *arg)
    return driver.video->set_shader(driver.video_data, type, arg);
 }
 
+static bool cmd_perf_trace(const char *arg)
+{
+   return rarch_perf_trace_dump(arg);
+}
+
 static const struct cmd_action_map action_map[] = {
    { "SET_SHADER", cmd_set_shader, "<shader path>" },
+   { "PERF_TRACE", cmd_perf_trace, "<json path>" },
 };
 
 static bool command_get_arg(const char *tok,
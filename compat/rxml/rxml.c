@@ -235,7 +235,7 @@ static struct rxml_node *rxml_parse_node(const char **ptr_)
       goto error;
 
    /* Are spaces between / and > allowed? */
-   is_closing = strstr(ptr, "/>") + 1 == closing;
+   is_closing = closing[-1] == '/';
 
    /* Look for more data. Either child nodes or data. */
    if (!is_closing)
@@ -254,8 +254,12 @@ static struct rxml_node *rxml_parse_node(const char **ptr_)
 
       snprintf(closing_tag, closing_tag_size, "</%s>", node->name);
 
-      cdata_start   = strstr(closing + 1, "<![CDATA[");
       child_start   = strchr(closing + 1, '<');
+      /* Only look at this node's own data, searching the
+       * rest of the document makes parsing quadratic. */
+      if (child_start && !strncmp(child_start, "<![CDATA[",
+               strlen("<![CDATA[")))
+         cdata_start = child_start;
       closing_start = strstr(closing + 1, closing_tag);
 
       if (!closing_start)
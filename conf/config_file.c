@@ -25,6 +25,7 @@
 #include "../file.h"
 #include "../miscellaneous.h"
 #include "../general.h"
+#include "../hash.h"
 
 #if !defined(_WIN32) && !defined(__CELLOS_LV2__) && !defined(_XBOX)
 #include <sys/param.h> /* PATH_MAX */
@@ -61,11 +62,86 @@ struct config_file
    unsigned include_depth;
 
    struct include_list *includes;
+
+   /* Open addressed table of the first entry for every key,
+    * built on the first lookup. */
+   struct config_entry_list **index;
+   uint32_t index_mask;
+   size_t index_count;
 };
 
 static config_file_t *config_file_new_internal(const char *path, unsigned depth);
 void config_file_free(config_file_t *conf);
 
+static void config_index_free(config_file_t *conf)
+{
+   free(conf->index);
+   conf->index       = NULL;
+   conf->index_mask  = 0;
+   conf->index_count = 0;
+}
+
+/* Keys already in the table keep their entry, so lookups
+ * find the first entry in list order, as a scan would. */
+static void config_index_add(config_file_t *conf,
+      struct config_entry_list *entry)
+{
+   uint32_t slot = hash_bucket(djb2_calculate(entry->key), conf->index_mask);
+
+   for (; conf->index[slot]; slot = (slot + 1) & conf->index_mask)
+      if (strcmp(conf->index[slot]->key, entry->key) == 0)
+         return;
+
+   conf->index[slot] = entry;
+   conf->index_count++;
+}
+
+static bool config_index_build(config_file_t *conf)
+{
+   struct config_entry_list *list = NULL;
+   size_t count = 0, size = 16;
+
+   for (list = conf->entries; list; list = list->next)
+      count++;
+   while (size < count * 2)
+      size <<= 1;
+
+   conf->index = (struct config_entry_list**)
+      calloc(size, sizeof(*conf->index));
+   if (!conf->index)
+      return false;
+
+   conf->index_mask  = size - 1;
+   conf->index_count = 0;
+
+   for (list = conf->entries; list; list = list->next)
+      config_index_add(conf, list);
+
+   return true;
+}
+
+static struct config_entry_list *config_find_entry(config_file_t *conf,
+      const char *key)
+{
+   struct config_entry_list *list = NULL;
+   uint32_t slot;
+
+   if (!conf->index && !config_index_build(conf))
+   {
+      for (list = conf->entries; list; list = list->next)
+         if (strcmp(key, list->key) == 0)
+            return list;
+      return NULL;
+   }
+
+   for (slot = hash_bucket(djb2_calculate(key), conf->index_mask);
+         (list = conf->index[slot]); slot = (slot + 1) & conf->index_mask)
+      if (strcmp(key, list->key) == 0)
+         return list;
+
+   return NULL;
+}
+
 static char *getaline(FILE *file)
 {
    char* newline = (char*)malloc(9);
@@ -168,6 +244,7 @@ static void add_child_list(config_file_t *parent, config_file_t *child)
    }
 
    child->entries = NULL;
+   config_index_free(parent);
 
    /* Rebase tail. */
    if (parent->entries)
@@ -365,6 +442,10 @@ bool config_append_file(config_file_t *conf, const char *path)
       new_conf->tail->next = conf->entries;
       conf->entries        = new_conf->entries; /* Pilfer. */
       new_conf->entries    = NULL;
+
+      if (!conf->tail)
+         conf->tail = new_conf->tail;
+      config_index_free(conf);
    }
 
    config_file_free(new_conf);
@@ -517,178 +598,135 @@ void config_file_free(config_file_t *conf)
       free(hold);
    }
 
+   config_index_free(conf);
    free(conf->path);
    free(conf);
 }
 
 bool config_get_double(config_file_t *conf, const char *key, double *in)
 {
-   struct config_entry_list *list = conf->entries;
+   const struct config_entry_list *list = config_find_entry(conf, key);
 
-   while (list)
-   {
-      if (strcmp(key, list->key) == 0)
-      {
-         *in = strtod(list->value, NULL);
-         return true;
-      }
-      list = list->next;
-   }
-   return false;
+   if (!list)
+      return false;
+
+   *in = strtod(list->value, NULL);
+   return true;
 }
 
 bool config_get_float(config_file_t *conf, const char *key, float *in)
 {
-   struct config_entry_list *list = conf->entries;
+   const struct config_entry_list *list = config_find_entry(conf, key);
 
-   while (list)
-   {
-      if (strcmp(key, list->key) == 0)
-      {
-         /* strtof() is C99/POSIX. Just use the more portable kind. */
-         *in = (float)strtod(list->value, NULL);
-         return true;
-      }
-      list = list->next;
-   }
-   return false;
+   if (!list)
+      return false;
+
+   /* strtof() is C99/POSIX. Just use the more portable kind. */
+   *in = (float)strtod(list->value, NULL);
+   return true;
 }
 
 bool config_get_int(config_file_t *conf, const char *key, int *in)
 {
-   struct config_entry_list *list = conf->entries;
+   const struct config_entry_list *list = config_find_entry(conf, key);
 
-   while (list)
+   if (!list)
+      return false;
+
+   errno = 0;
+   int val = strtol(list->value, NULL, 0);
+   if (errno == 0)
    {
-      if (strcmp(key, list->key) == 0)
-      {
-         errno = 0;
-         int val = strtol(list->value, NULL, 0);
-         if (errno == 0)
-         {
-            *in = val;
-            return true;
-         }
-         return false;
-      }
-      list = list->next;
+      *in = val;
+      return true;
    }
    return false;
 }
 
 bool config_get_uint64(config_file_t *conf, const char *key, uint64_t *in)
 {
-   struct config_entry_list *list = conf->entries;
+   const struct config_entry_list *list = config_find_entry(conf, key);
 
-   while (list)
+   if (!list)
+      return false;
+
+   errno = 0;
+   uint64_t val = strtoull(list->value, NULL, 0);
+   if (errno == 0)
    {
-      if (strcmp(key, list->key) == 0)
-      {
-         errno = 0;
-         uint64_t val = strtoull(list->value, NULL, 0);
-         if (errno == 0)
-         {
-            *in = val;
-            return true;
-         }
-         return false;
-      }
-      list = list->next;
+      *in = val;
+      return true;
    }
    return false;
 }
 
 bool config_get_uint(config_file_t *conf, const char *key, unsigned *in)
 {
-   struct config_entry_list *list = conf->entries;
+   const struct config_entry_list *list = config_find_entry(conf, key);
+
+   if (!list)
+      return false;
 
-   while (list != NULL)
+   errno = 0;
+   unsigned val = strtoul(list->value, NULL, 0);
+   if (errno == 0)
    {
-      if (strcmp(key, list->key) == 0)
-      {
-         errno = 0;
-         unsigned val = strtoul(list->value, NULL, 0);
-         if (errno == 0)
-         {
-            *in = val;
-            return true;
-         }
-         return false;
-      }
-      list = list->next;
+      *in = val;
+      return true;
    }
-
    return false;
 }
 
 bool config_get_hex(config_file_t *conf, const char *key, unsigned *in)
 {
-   struct config_entry_list *list = conf->entries;
+   const struct config_entry_list *list = config_find_entry(conf, key);
 
-   while (list)
+   if (!list)
+      return false;
+
+   errno = 0;
+   unsigned val = strtoul(list->value, NULL, 16);
+   if (errno == 0)
    {
-      if (strcmp(key, list->key) == 0)
-      {
-         errno = 0;
-         unsigned val = strtoul(list->value, NULL, 16);
-         if (errno == 0)
-         {
-            *in = val;
-            return true;
-         }
-         return false;
-      }
-      list = list->next;
+      *in = val;
+      return true;
    }
    return false;
 }
 
 bool config_get_char(config_file_t *conf, const char *key, char *in)
 {
-   struct config_entry_list *list = conf->entries;
+   const struct config_entry_list *list = config_find_entry(conf, key);
 
-   while (list)
-   {
-      if (strcmp(key, list->key) == 0)
-      {
-         if (list->value[0] && list->value[1])
-            return false;
-         *in = *list->value;
-         return true;
-      }
-      list = list->next;
-   }
-   return false;
+   if (!list)
+      return false;
+
+   if (list->value[0] && list->value[1])
+      return false;
+   *in = *list->value;
+   return true;
 }
 
 bool config_get_string(config_file_t *conf, const char *key, char **str)
 {
-   struct config_entry_list *list = conf->entries;
+   const struct config_entry_list *list = config_find_entry(conf, key);
 
-   while (list)
-   {
-      if (strcmp(key, list->key) == 0)
-      {
-         *str = strdup(list->value);
-         return true;
-      }
-      list = list->next;
-   }
-   return false;
+   if (!list)
+      return false;
+
+   *str = strdup(list->value);
+   return true;
 }
 
 bool config_get_array(config_file_t *conf, const char *key,
       char *buf, size_t size)
 {
-   struct config_entry_list *list = conf->entries;
+   const struct config_entry_list *list = config_find_entry(conf, key);
 
-   while (list)
-   {
-      if (strcmp(key, list->key) == 0)
-         return strlcpy(buf, list->value, size) < size;
-      list = list->next;
-   }
-   return false;
+   if (!list)
+      return false;
+
+   return strlcpy(buf, list->value, size) < size;
 }
 
 bool config_get_path(config_file_t *conf, const char *key,
@@ -697,77 +735,74 @@ bool config_get_path(config_file_t *conf, const char *key,
 #if defined(RARCH_CONSOLE)
    return config_get_array(conf, key, buf, size);
 #else
-   struct config_entry_list *list = conf->entries;
+   const struct config_entry_list *list = config_find_entry(conf, key);
 
-   while (list)
-   {
-      if (strcmp(key, list->key) == 0)
-      {
-         fill_pathname_expand_special(buf, list->value, size);
-         return true;
-      }
-      list = list->next;
-   }
-   return false;
+   if (!list)
+      return false;
+
+   fill_pathname_expand_special(buf, list->value, size);
+   return true;
 #endif
 }
 
 bool config_get_bool(config_file_t *conf, const char *key, bool *in)
 {
-   struct config_entry_list *list = conf->entries;
+   const struct config_entry_list *list = config_find_entry(conf, key);
 
-   while (list)
-   {
-      if (strcmp(key, list->key) == 0)
-      {
-         if (strcasecmp(list->value, "true") == 0)
-            *in = true;
-         else if (strcasecmp(list->value, "1") == 0)
-            *in = true;
-         else if (strcasecmp(list->value, "false") == 0)
-            *in = false;
-         else if (strcasecmp(list->value, "0") == 0)
-            *in = false;
-         else
-            return false;
+   if (!list)
+      return false;
 
-         return true;
-      }
-      list = list->next;
-   }
-   return false;
+   if (strcasecmp(list->value, "true") == 0)
+      *in = true;
+   else if (strcasecmp(list->value, "1") == 0)
+      *in = true;
+   else if (strcasecmp(list->value, "false") == 0)
+      *in = false;
+   else if (strcasecmp(list->value, "0") == 0)
+      *in = false;
+   else
+      return false;
+
+   return true;
 }
 
 void config_set_string(config_file_t *conf, const char *key, const char *val)
 {
-   struct config_entry_list *list = conf->entries;
-   struct config_entry_list *last = list;
-   while (list)
-   {
-      if (!list->readonly && (strcmp(key, list->key) == 0))
-      {
-         free(list->value);
-         list->value = strdup(val);
-         return;
-      }
+   struct config_entry_list *list = config_find_entry(conf, key);
+   struct config_entry_list *elem = NULL;
 
-      last = list;
+   /* Included entries are read-only, but a later
+    * entry with the same key can still be changed. */
+   while (list && (list->readonly || strcmp(key, list->key) != 0))
       list = list->next;
-   }
 
-   struct config_entry_list *elem = (struct config_entry_list*)
-      calloc(1, sizeof(*elem));
+   if (list)
+   {
+      free(list->value);
+      list->value = strdup(val);
+      return;
+   }
 
+   elem = (struct config_entry_list*)calloc(1, sizeof(*elem));
    if (!elem)
       return;
 
    elem->key = strdup(key);
    elem->value = strdup(val);
 
-   if (last)
-      last->next = elem;
+   if (conf->tail)
+      conf->tail->next = elem;
    else
       conf->entries = elem;
+   conf->tail = elem;
+
+   if (!conf->index)
+      return;
+
+   if ((conf->index_count + 1) * 2 > (size_t)conf->index_mask + 1)
+      config_index_free(conf);
+   else
+      config_index_add(conf, elem);
 }
 
 void config_set_path(config_file_t *conf, const char *entry, const char *val)
@@ -895,16 +930,7 @@ void config_file_dump_all(config_file_t *conf)
 
 bool config_entry_exists(config_file_t *conf, const char *entry)
 {
-   struct config_entry_list *list = conf->entries;
-
-   while (list)
-   {
-      if (strcmp(entry, list->key) == 0)
-         return true;
-      list = list->next;
-   }
-
-   return false;
+   return config_find_entry(conf, entry) != NULL;
 }
 
 bool config_get_entry_list_head(config_file_t *conf,
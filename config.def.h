@@ -387,6 +387,12 @@ static unsigned swap_interval = 1;
  */
 static const bool video_threaded = false;
 
+/* Detects frames the core resubmits unchanged and skips
+ * converting, filtering, recording and uploading them again.
+ * Only the changed rows of other frames are processed.
+ */
+static const bool frame_dupe_detect = false;
+
 /* Set to true if HW render cores should get their private context. */
 static const bool video_shared_context = false;
 
@@ -485,6 +491,11 @@ static const bool gpu_screenshot = true;
 /* Record post-shaded GPU output instead of raw game footage if available. */
 static const bool gpu_record = false;
 
+/* What recording does when the encoder can't keep up:
+ * "block" waits for it, "drop" skips frames,
+ * "dupe" repeats the previous frame to keep A/V sync. */
+static const char *record_backpressure = "block";
+
 /* OSD-messages. */
 static const bool font_enable = true;
 
@@ -557,6 +568,18 @@ static const unsigned rewind_buffer_size = 20 << 20; /* 20MiB */
 /* How many frames to rewind at a time. */
 static const unsigned rewind_granularity = 1;
 
+/* Runs the core ahead to hide its internal input lag.
+ * Needs save state support and costs extra CPU time every frame. */
+static const bool run_ahead_enable = false;
+
+/* How many frames to run ahead. Should match the core's own lag. */
+static const unsigned run_ahead_frames = 1;
+
+/* Runs ahead in a second copy of the core instead of saving and
+ * restoring the main one every frame. Needs a dynamically loaded,
+ * software rendered core. */
+static const bool run_ahead_secondary_instance = false;
+
 /* Pause gameplay when gameplay loses focus. */
 static const bool pause_nonactive = false;
 
@@ -585,6 +608,16 @@ static const bool savestate_auto_index = false;
 static const bool savestate_auto_save = false;
 static const bool savestate_auto_load = false;
 
+/* Compresses savestates. Loading handles both compressed
+ * and uncompressed states. Off by default, as older versions
+ * and external tools can't load compressed states. */
+static const bool savestate_compression = false;
+
+/* Frames between savestates stored in recorded movies.
+ * Playback can seek to any frame by loading the one before it.
+ * 0 only stores the state the movie starts from. */
+static const unsigned movie_keyframe_interval = 600;
+
 /* Slowmotion ratio. */
 static const float slowmotion_ratio = 3.0;
 
@@ -599,6 +632,10 @@ static const bool network_cmd_enable = false;
 static const uint16_t network_cmd_port = 55355;
 static const bool stdin_cmd_enable = false;
 
+/* Enable local control/telemetry socket. */
+static const bool control_socket_enable = false;
+static const uint16_t control_socket_port = 55356;
+
 /* Number of entries that will be kept in content history playlist file. */
 static const unsigned default_content_history_size = 100;
 
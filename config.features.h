@@ -176,6 +176,12 @@ static const bool _ffmpeg_supp = true;
 static const bool _ffmpeg_supp = false;
 #endif
 
+#ifdef HAVE_RLV
+static const bool _rlv_supp = true;
+#else
+static const bool _rlv_supp = false;
+#endif
+
 #ifdef HAVE_FREETYPE
 static const bool _freetype_supp = true;
 #else
@@ -0,0 +1,1041 @@
+/*  RetroArch - A frontend for libretro.
+ *  Copyright (C) 2010-2014 - Hans-Kristian Arntzen
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "control.h"
+#include "netplay_compat.h"
+#include "netplay.h"
+#include "thread.h"
+#include "dynamic.h"
+#include "general.h"
+#include "performance.h"
+#include "compat/strl.h"
+#include "compat/posix_string.h"
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+
+#ifndef _WIN32
+#include <sys/un.h>
+#include <sys/stat.h>
+#endif
+
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0
+#endif
+
+#define CONTROL_MAX_CLIENTS 8
+#define CONTROL_LINE_SIZE 256
+#define CONTROL_MAX_REQUESTS 32
+/* Requests executed per frame. Keeps the main thread cost bounded
+ * no matter how fast clients send. */
+#define CONTROL_REQUESTS_PER_FRAME 4
+/* Largest READ_MEMORY request, in bytes. */
+#define CONTROL_READ_MAX 4096
+/* Pending output per client. Events are dropped and GET_STATE is
+ * refused beyond CONTROL_OUT_MAX - CONTROL_OUT_RESERVE, and no more
+ * requests are read from the client until it catches up. */
+#define CONTROL_OUT_MAX (16 * 1024 * 1024)
+/* Room for replies to requests which were already read. A client
+ * whose reply doesn't fit anyway is disconnected. */
+#define CONTROL_OUT_RESERVE (512 * 1024)
+
+struct control_client
+{
+   int fd;
+   unsigned generation;
+
+   char line[CONTROL_LINE_SIZE];
+   size_t line_ptr;
+   bool line_overflow;
+
+   uint8_t *out;
+   size_t out_ptr;
+   size_t out_size;
+   size_t out_cap;
+
+   unsigned perf_interval;
+   unsigned frames_interval;
+   unsigned frames_count;
+   retro_time_t frames_min;
+   retro_time_t frames_max;
+   retro_time_t frames_total;
+
+   unsigned dropped;
+   /* A reply didn't fit, the client must be disconnected. */
+   bool overflow;
+};
+
+struct control_request
+{
+   unsigned client;
+   unsigned generation;
+   char line[CONTROL_LINE_SIZE];
+};
+
+struct rarch_control
+{
+   int listen_fd;
+#ifndef _WIN32
+   int wake_fd[2];
+   char path[PATH_MAX];
+#endif
+
+   sthread_t *thread;
+   slock_t *lock;
+   bool quit;
+
+   /* Everything below is protected by lock. */
+   struct control_client clients[CONTROL_MAX_CLIENTS];
+   unsigned subscribers;
+
+   struct control_request requests[CONTROL_MAX_REQUESTS];
+   unsigned request_ptr;
+   unsigned request_count;
+
+   /* Main thread only. */
+   uint64_t frame;
+   retro_time_t frame_last;
+   char reply[2 * CONTROL_READ_MAX + 64];
+};
+
+static bool control_socket_nonblock(int fd)
+{
+#ifdef _WIN32
+   u_long mode = 1;
+   return ioctlsocket(fd, FIONBIO, &mode) == 0;
+#else
+   return fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK) == 0;
+#endif
+}
+
+static bool control_would_block(void)
+{
+#ifdef _WIN32
+   return WSAGetLastError() == WSAEWOULDBLOCK;
+#else
+   return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+#endif
+}
+
+static void control_wake(rarch_control_t *handle)
+{
+#ifndef _WIN32
+   char c = 0;
+   /* A full pipe already guarantees a wakeup. */
+   if (write(handle->wake_fd[1], &c, 1) < 0) { }
+#else
+   (void)handle;
+#endif
+}
+
+static void control_count_subscribers(rarch_control_t *handle)
+{
+   unsigned i;
+
+   handle->subscribers = 0;
+   for (i = 0; i < CONTROL_MAX_CLIENTS; i++)
+   {
+      const struct control_client *client = &handle->clients[i];
+      if (client->fd >= 0 && (client->perf_interval || client->frames_interval))
+         handle->subscribers++;
+   }
+}
+
+/* Must be called with lock held. */
+static bool control_client_reading(const struct control_client *client)
+{
+   return client->out_size - client->out_ptr <
+      CONTROL_OUT_MAX - CONTROL_OUT_RESERVE;
+}
+
+/* Must be called with lock held.
+ * Replies may use the reserve, other output may not. */
+static bool control_append(struct control_client *client,
+      const void *data, size_t size, bool reply)
+{
+   size_t pending = client->out_size - client->out_ptr;
+   size_t max     = reply ? CONTROL_OUT_MAX
+      : CONTROL_OUT_MAX - CONTROL_OUT_RESERVE;
+
+   if (pending + size > max)
+      return false;
+
+   if (client->out_ptr && client->out_size + size > client->out_cap)
+   {
+      memmove(client->out, client->out + client->out_ptr, pending);
+      client->out_ptr  = 0;
+      client->out_size = pending;
+   }
+
+   if (client->out_size + size > client->out_cap)
+   {
+      size_t cap   = client->out_cap ? client->out_cap : 4096;
+      uint8_t *out = NULL;
+
+      while (cap < client->out_size + size)
+         cap *= 2;
+
+      if (!(out = (uint8_t*)realloc(client->out, cap)))
+         return false;
+
+      client->out     = out;
+      client->out_cap = cap;
+   }
+
+   memcpy(client->out + client->out_size, data, size);
+   client->out_size += size;
+   return true;
+}
+
+static void control_close_client(rarch_control_t *handle,
+      struct control_client *client)
+{
+   close(client->fd);
+
+   slock_lock(handle->lock);
+   client->fd = -1;
+   client->generation++;
+   client->line_ptr        = 0;
+   client->line_overflow   = false;
+   client->out_ptr         = 0;
+   client->out_size        = 0;
+   client->perf_interval   = 0;
+   client->frames_interval = 0;
+   client->dropped         = 0;
+   client->overflow        = false;
+   control_count_subscribers(handle);
+   slock_unlock(handle->lock);
+}
+
+static void control_queue_line(rarch_control_t *handle,
+      struct control_client *client)
+{
+   static const char busy[]     = "ERR busy\n";
+   static const char too_long[] = "ERR line too long\n";
+
+   slock_lock(handle->lock);
+
+   if (client->line_overflow)
+   {
+      if (!control_append(client, too_long, sizeof(too_long) - 1, true))
+         client->overflow = true;
+   }
+   else if (handle->request_count >= CONTROL_MAX_REQUESTS)
+   {
+      if (!control_append(client, busy, sizeof(busy) - 1, true))
+         client->overflow = true;
+   }
+   else
+   {
+      struct control_request *req = &handle->requests[
+         (handle->request_ptr + handle->request_count++) % CONTROL_MAX_REQUESTS];
+
+      req->client     = client - handle->clients;
+      req->generation = client->generation;
+      memcpy(req->line, client->line, client->line_ptr);
+      req->line[client->line_ptr] = '\0';
+   }
+
+   slock_unlock(handle->lock);
+
+   client->line_ptr      = 0;
+   client->line_overflow = false;
+}
+
+/* Returns false if the client went away. Stops early once the
+ * client's output is backed up, the rest stays in the socket. */
+static bool control_client_read(rarch_control_t *handle,
+      struct control_client *client)
+{
+   for (;;)
+   {
+      char buf[1024];
+      ssize_t i;
+      bool reading;
+      ssize_t ret = recv(client->fd, buf, sizeof(buf), 0);
+
+      if (ret == 0)
+         return false;
+      if (ret < 0)
+         return control_would_block();
+
+      for (i = 0; i < ret; i++)
+      {
+         if (buf[i] == '\n')
+         {
+            if (client->line_ptr && client->line[client->line_ptr - 1] == '\r')
+               client->line_ptr--;
+            if (client->line_ptr || client->line_overflow)
+               control_queue_line(handle, client);
+         }
+         else if (client->line_ptr < CONTROL_LINE_SIZE - 1)
+            client->line[client->line_ptr++] = buf[i];
+         else
+            client->line_overflow = true;
+      }
+
+      slock_lock(handle->lock);
+      reading = control_client_reading(client);
+      slock_unlock(handle->lock);
+
+      if (!reading)
+         return true;
+   }
+}
+
+static bool control_client_write(rarch_control_t *handle,
+      struct control_client *client)
+{
+   bool ret = true;
+
+   slock_lock(handle->lock);
+   while (client->out_ptr < client->out_size)
+   {
+      ssize_t written = send(client->fd,
+            NONCONST_CAST (client->out + client->out_ptr),
+            client->out_size - client->out_ptr, MSG_NOSIGNAL);
+
+      if (written <= 0)
+      {
+         ret = written < 0 && control_would_block();
+         break;
+      }
+
+      client->out_ptr += written;
+   }
+
+   if (client->out_ptr == client->out_size)
+      client->out_ptr = client->out_size = 0;
+   slock_unlock(handle->lock);
+
+   return ret;
+}
+
+static void control_accept(rarch_control_t *handle)
+{
+   unsigned i;
+   int fd = accept(handle->listen_fd, NULL, NULL);
+
+   if (fd < 0)
+      return;
+
+   for (i = 0; i < CONTROL_MAX_CLIENTS; i++)
+   {
+      if (handle->clients[i].fd < 0)
+         break;
+   }
+
+   if (i == CONTROL_MAX_CLIENTS || !control_socket_nonblock(fd))
+   {
+      RARCH_WARN("Control: refusing connection.\n");
+      close(fd);
+      return;
+   }
+
+#ifdef TCP_NODELAY
+   {
+      int yes = 1;
+      setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, CONST_CAST &yes, sizeof(int));
+   }
+#endif
+
+   slock_lock(handle->lock);
+   handle->clients[i].fd = fd;
+   slock_unlock(handle->lock);
+}
+
+static void control_thread(void *data)
+{
+   rarch_control_t *handle = (rarch_control_t*)data;
+
+   for (;;)
+   {
+      unsigned i;
+      fd_set rfds, wfds;
+      int max_fd = handle->listen_fd;
+      struct timeval tv = {0, 10000};
+
+      FD_ZERO(&rfds);
+      FD_ZERO(&wfds);
+      FD_SET(handle->listen_fd, &rfds);
+#ifndef _WIN32
+      FD_SET(handle->wake_fd[0], &rfds);
+      if (handle->wake_fd[0] > max_fd)
+         max_fd = handle->wake_fd[0];
+#endif
+
+      slock_lock(handle->lock);
+      if (handle->quit)
+      {
+         slock_unlock(handle->lock);
+         break;
+      }
+
+      for (i = 0; i < CONTROL_MAX_CLIENTS; i++)
+      {
+         const struct control_client *client = &handle->clients[i];
+         if (client->fd < 0)
+            continue;
+
+         if (control_client_reading(client))
+            FD_SET(client->fd, &rfds);
+         if (client->out_ptr < client->out_size)
+            FD_SET(client->fd, &wfds);
+         if (client->fd > max_fd)
+            max_fd = client->fd;
+      }
+      slock_unlock(handle->lock);
+
+#ifdef _WIN32
+      /* No wakeup pipe, poll for output and shutdown. */
+      if (select(max_fd + 1, &rfds, &wfds, NULL, &tv) <= 0)
+         continue;
+#else
+      (void)tv;
+      if (select(max_fd + 1, &rfds, &wfds, NULL, NULL) <= 0)
+         continue;
+
+      if (FD_ISSET(handle->wake_fd[0], &rfds))
+      {
+         char buf[64];
+         while (read(handle->wake_fd[0], buf, sizeof(buf)) > 0);
+      }
+#endif
+
+      for (i = 0; i < CONTROL_MAX_CLIENTS; i++)
+      {
+         struct control_client *client = &handle->clients[i];
+         bool overflow;
+
+         if (client->fd < 0)
+            continue;
+
+         if ((FD_ISSET(client->fd, &rfds) && !control_client_read(handle, client))
+               || (FD_ISSET(client->fd, &wfds)
+                  && !control_client_write(handle, client)))
+         {
+            control_close_client(handle, client);
+            continue;
+         }
+
+         slock_lock(handle->lock);
+         overflow = client->overflow;
+         slock_unlock(handle->lock);
+
+         if (overflow)
+         {
+            RARCH_WARN("Control: client isn't reading replies, disconnecting.\n");
+            control_close_client(handle, client);
+         }
+      }
+
+      if (FD_ISSET(handle->listen_fd, &rfds))
+         control_accept(handle);
+   }
+}
+
+/* Main thread side. */
+
+static void control_reply(rarch_control_t *handle,
+      const struct control_request *req, const void *data, size_t size)
+{
+   struct control_client *client = &handle->clients[req->client];
+
+   slock_lock(handle->lock);
+   if (client->fd >= 0 && client->generation == req->generation
+         && !control_append(client, data, size, true))
+      client->overflow = true;
+   slock_unlock(handle->lock);
+}
+
+static void control_replyf(rarch_control_t *handle,
+      const struct control_request *req, const char *fmt, ...)
+{
+   int len;
+   va_list ap;
+
+   va_start(ap, fmt);
+   len = vsnprintf(handle->reply, sizeof(handle->reply) - 1, fmt, ap);
+   va_end(ap);
+
+   if (len < 0)
+      return;
+   if (len > (int)sizeof(handle->reply) - 2)
+      len = sizeof(handle->reply) - 2;
+
+   handle->reply[len++] = '\n';
+   control_reply(handle, req, handle->reply, len);
+}
+
+static void control_cmd_ping(rarch_control_t *handle,
+      const struct control_request *req, const char *arg)
+{
+   (void)arg;
+   control_replyf(handle, req, "OK PONG");
+}
+
+static void control_cmd_version(rarch_control_t *handle,
+      const struct control_request *req, const char *arg)
+{
+   (void)arg;
+   control_replyf(handle, req, "OK %s", PACKAGE_VERSION);
+}
+
+static void control_cmd_status(rarch_control_t *handle,
+      const struct control_request *req, const char *arg)
+{
+   unsigned dropped;
+
+   (void)arg;
+
+   slock_lock(handle->lock);
+   dropped = handle->clients[req->client].dropped;
+   slock_unlock(handle->lock);
+
+   control_replyf(handle, req,
+         "OK frame=%llu paused=%d menu=%d content=%d dropped=%u",
+         (unsigned long long)g_extern.frame_count,
+         g_extern.is_paused, g_extern.is_menu,
+         !g_extern.libretro_dummy, dropped);
+}
+
+static void control_cmd_read_memory(rarch_control_t *handle,
+      const struct control_request *req, const char *arg)
+{
+   static const char hex[] = "0123456789abcdef";
+   char *end          = NULL;
+   const uint8_t *mem = (const uint8_t*)
+      pretro_get_memory_data(RETRO_MEMORY_SYSTEM_RAM);
+   size_t mem_size    = pretro_get_memory_size(RETRO_MEMORY_SYSTEM_RAM);
+   unsigned long addr = strtoul(arg, &end, 0);
+   unsigned long len  = strtoul(end, NULL, 0);
+   unsigned long i;
+   char *ptr;
+
+   if (!mem || !mem_size)
+   {
+      control_replyf(handle, req, "ERR no system RAM");
+      return;
+   }
+
+   if (end == arg || !len || len > CONTROL_READ_MAX)
+   {
+      control_replyf(handle, req, "ERR usage: READ_MEMORY <addr> <1-%u>",
+            CONTROL_READ_MAX);
+      return;
+   }
+
+   if (addr >= mem_size || len > mem_size - addr)
+   {
+      control_replyf(handle, req, "ERR out of range (size 0x%lx)",
+            (unsigned long)mem_size);
+      return;
+   }
+
+   ptr  = handle->reply;
+   ptr += snprintf(ptr, 32, "OK 0x%lx ", addr);
+   for (i = 0; i < len; i++)
+   {
+      *ptr++ = hex[mem[addr + i] >> 4];
+      *ptr++ = hex[mem[addr + i] & 15];
+   }
+   *ptr++ = '\n';
+
+   control_reply(handle, req, handle->reply, ptr - handle->reply);
+}
+
+/* Reply is "OK <size>" followed by size bytes of raw state. */
+static void control_cmd_get_state(rarch_control_t *handle,
+      const struct control_request *req, const char *arg)
+{
+   char header[32];
+   size_t header_size;
+   uint8_t *buf;
+   size_t size = pretro_serialize_size();
+   struct control_client *client = &handle->clients[req->client];
+   bool queued = false;
+
+   (void)arg;
+
+   if (!size)
+   {
+      control_replyf(handle, req, "ERR serialization not supported");
+      return;
+   }
+
+   header_size = snprintf(header, sizeof(header),
+         "OK %lu\n", (unsigned long)size);
+
+   if (!(buf = (uint8_t*)malloc(header_size + size)))
+   {
+      control_replyf(handle, req, "ERR out of memory");
+      return;
+   }
+
+   memcpy(buf, header, header_size);
+   if (!pretro_serialize(buf + header_size, size))
+   {
+      free(buf);
+      control_replyf(handle, req, "ERR serialization failed");
+      return;
+   }
+
+   slock_lock(handle->lock);
+   if (client->fd >= 0 && client->generation == req->generation)
+      queued = control_append(client, buf, header_size + size, false);
+   slock_unlock(handle->lock);
+   free(buf);
+
+   if (!queued)
+      control_replyf(handle, req, "ERR busy");
+}
+
+/* Plays the movie forward from the nearest keyframe, without
+ * presenting, up to the given frame. */
+static void control_cmd_movie_seek(rarch_control_t *handle,
+      const struct control_request *req, const char *arg)
+{
+   bool ret;
+   char *end      = NULL;
+   unsigned frame = strtoul(arg, &end, 0);
+
+   if (!g_extern.bsv.movie || !g_extern.bsv.movie_playback)
+   {
+      control_replyf(handle, req, "ERR no movie playing");
+      return;
+   }
+
+   if (end == arg)
+   {
+      control_replyf(handle, req, "ERR usage: MOVIE_SEEK <frame>");
+      return;
+   }
+
+   /* Control requests are handled before the frame takes the
+    * autosave lock, and the seek runs the core. */
+#if defined(HAVE_THREADS)
+   lock_autosave();
+#endif
+   ret = bsv_movie_seek(g_extern.bsv.movie, frame);
+#if defined(HAVE_THREADS)
+   unlock_autosave();
+#endif
+
+   if (!ret)
+   {
+      control_replyf(handle, req, "ERR can't seek to frame %u of %u",
+            frame, bsv_movie_get_num_frames(g_extern.bsv.movie));
+      return;
+   }
+
+   g_extern.bsv.movie_end = false;
+   runahead_invalidate(g_extern.runahead);
+
+   /* States from before the seek can't be rewound into. */
+   if (g_extern.state_manager)
+   {
+      rarch_main_command(RARCH_CMD_REWIND_DEINIT);
+      rarch_main_command(RARCH_CMD_REWIND_INIT);
+   }
+
+   control_replyf(handle, req, "OK %u",
+         bsv_movie_get_frame(g_extern.bsv.movie));
+}
+
+static bool control_parse_stream(const char *arg,
+      bool *perf, bool *frames, unsigned *interval)
+{
+   char *end = NULL;
+   size_t len = strcspn(arg, " ");
+
+   *perf   = len == 4 && !strncmp(arg, "PERF", 4);
+   *frames = len == 6 && !strncmp(arg, "FRAMES", 6);
+   if (len == 3 && !strncmp(arg, "ALL", 3))
+      *perf = *frames = true;
+
+   if (!interval)
+      return *perf || *frames;
+
+   *interval = strtoul(arg + len, &end, 0);
+   return (*perf || *frames) && end != arg + len && *interval;
+}
+
+static void control_cmd_subscribe(rarch_control_t *handle,
+      const struct control_request *req, const char *arg)
+{
+   bool perf, frames;
+   unsigned interval;
+   struct control_client *client = &handle->clients[req->client];
+
+   if (!control_parse_stream(arg, &perf, &frames, &interval))
+   {
+      control_replyf(handle, req,
+            "ERR usage: SUBSCRIBE <PERF|FRAMES|ALL> <frames>");
+      return;
+   }
+
+   slock_lock(handle->lock);
+   if (client->generation == req->generation)
+   {
+      if (perf)
+         client->perf_interval = interval;
+      if (frames)
+      {
+         client->frames_interval = interval;
+         client->frames_count    = 0;
+         client->frames_total    = 0;
+      }
+      control_count_subscribers(handle);
+   }
+   slock_unlock(handle->lock);
+
+   control_replyf(handle, req, "OK");
+}
+
+static void control_cmd_unsubscribe(rarch_control_t *handle,
+      const struct control_request *req, const char *arg)
+{
+   bool perf, frames;
+   struct control_client *client = &handle->clients[req->client];
+
+   if (!control_parse_stream(arg, &perf, &frames, NULL))
+   {
+      control_replyf(handle, req,
+            "ERR usage: UNSUBSCRIBE <PERF|FRAMES|ALL>");
+      return;
+   }
+
+   slock_lock(handle->lock);
+   if (client->generation == req->generation)
+   {
+      if (perf)
+         client->perf_interval = 0;
+      if (frames)
+         client->frames_interval = 0;
+      control_count_subscribers(handle);
+   }
+   slock_unlock(handle->lock);
+
+   control_replyf(handle, req, "OK");
+}
+
+struct control_action_map
+{
+   const char *str;
+   void (*action)(rarch_control_t *handle,
+         const struct control_request *req, const char *arg);
+};
+
+static const struct control_action_map control_map[] = {
+   { "PING",        control_cmd_ping },
+   { "VERSION",     control_cmd_version },
+   { "STATUS",      control_cmd_status },
+   { "READ_MEMORY", control_cmd_read_memory },
+   { "GET_STATE",   control_cmd_get_state },
+   { "MOVIE_SEEK",  control_cmd_movie_seek },
+   { "SUBSCRIBE",   control_cmd_subscribe },
+   { "UNSUBSCRIBE", control_cmd_unsubscribe },
+};
+
+static void control_handle_request(rarch_control_t *handle,
+      const struct control_request *req)
+{
+   unsigned i;
+   size_t len      = strcspn(req->line, " ");
+   const char *arg = req->line + len;
+
+   while (*arg == ' ')
+      arg++;
+
+   for (i = 0; i < ARRAY_SIZE(control_map); i++)
+   {
+      if (strlen(control_map[i].str) == len
+            && !strncmp(req->line, control_map[i].str, len))
+      {
+         control_map[i].action(handle, req, arg);
+         return;
+      }
+   }
+
+   control_replyf(handle, req, "ERR unknown command");
+}
+
+/* Must be called with lock held. */
+static void control_send_perf(rarch_control_t *handle,
+      struct control_client *client,
+      const struct retro_perf_counter **counters, unsigned num)
+{
+   unsigned i;
+
+   for (i = 0; i < num; i++)
+   {
+      char buf[256];
+      int len;
+
+      if (!counters[i] || !counters[i]->call_cnt)
+         continue;
+
+      len = snprintf(buf, sizeof(buf), "EVENT PERF %llu %s %llu %llu\n",
+            (unsigned long long)handle->frame, counters[i]->ident,
+            (unsigned long long)counters[i]->call_cnt,
+            (unsigned long long)counters[i]->total);
+
+      if (len < 0 || len >= (int)sizeof(buf)
+            || !control_append(client, buf, len, false))
+         client->dropped++;
+   }
+}
+
+/* Must be called with lock held. */
+static void control_send_events(rarch_control_t *handle,
+      retro_time_t delta)
+{
+   unsigned i;
+
+   for (i = 0; i < CONTROL_MAX_CLIENTS; i++)
+   {
+      struct control_client *client = &handle->clients[i];
+      if (client->fd < 0)
+         continue;
+
+      if (client->frames_interval && delta)
+      {
+         if (!client->frames_count || delta < client->frames_min)
+            client->frames_min = delta;
+         if (!client->frames_count || delta > client->frames_max)
+            client->frames_max = delta;
+         client->frames_total += delta;
+
+         if (++client->frames_count >= client->frames_interval)
+         {
+            char buf[128];
+            int len = snprintf(buf, sizeof(buf),
+                  "EVENT FRAMES %llu %u %lld %lld %lld\n",
+                  (unsigned long long)handle->frame, client->frames_count,
+                  (long long)client->frames_min,
+                  (long long)(client->frames_total / client->frames_count),
+                  (long long)client->frames_max);
+
+            if (!control_append(client, buf, len, false))
+               client->dropped++;
+
+            client->frames_count = 0;
+            client->frames_total = 0;
+         }
+      }
+
+      if (client->perf_interval
+            && handle->frame % client->perf_interval == 0)
+      {
+         control_send_perf(handle, client,
+               perf_counters_rarch, perf_ptr_rarch);
+         control_send_perf(handle, client,
+               perf_counters_libretro, perf_ptr_libretro);
+      }
+   }
+}
+
+void rarch_control_frame(rarch_control_t *handle)
+{
+   unsigned i;
+   unsigned num_requests = 0;
+   bool wake             = false;
+   retro_time_t time     = rarch_get_time_usec();
+   retro_time_t delta    = handle->frame_last ? time - handle->frame_last : 0;
+   struct control_request requests[CONTROL_REQUESTS_PER_FRAME];
+
+   handle->frame_last = time;
+   handle->frame++;
+
+   slock_lock(handle->lock);
+   while (handle->request_count && num_requests < CONTROL_REQUESTS_PER_FRAME)
+   {
+      requests[num_requests++] = handle->requests[handle->request_ptr];
+      handle->request_ptr = (handle->request_ptr + 1) % CONTROL_MAX_REQUESTS;
+      handle->request_count--;
+   }
+
+   if (handle->subscribers)
+   {
+      control_send_events(handle, delta);
+      wake = true;
+   }
+   slock_unlock(handle->lock);
+
+   for (i = 0; i < num_requests; i++)
+      control_handle_request(handle, &requests[i]);
+
+   if (wake || num_requests)
+      control_wake(handle);
+}
+
+static bool control_init_tcp(rarch_control_t *handle, uint16_t port)
+{
+   int yes = 1;
+   struct sockaddr_in addr;
+
+   memset(&addr, 0, sizeof(addr));
+   addr.sin_family      = AF_INET;
+   addr.sin_port        = htons(port);
+   addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+   if ((handle->listen_fd = socket(AF_INET, SOCK_STREAM, 0)) < 0)
+      return false;
+
+   setsockopt(handle->listen_fd, SOL_SOCKET,
+         SO_REUSEADDR, CONST_CAST &yes, sizeof(int));
+
+   if (bind(handle->listen_fd, (struct sockaddr*)&addr, sizeof(addr)) < 0)
+   {
+      RARCH_ERR("Control: failed to bind port %hu.\n", (unsigned short)port);
+      return false;
+   }
+
+   RARCH_LOG("Control: listening on 127.0.0.1:%hu.\n", (unsigned short)port);
+   return true;
+}
+
+#ifndef _WIN32
+static bool control_init_unix(rarch_control_t *handle, const char *path)
+{
+   struct stat st;
+   struct sockaddr_un addr;
+
+   memset(&addr, 0, sizeof(addr));
+   addr.sun_family = AF_UNIX;
+
+   if (strlen(path) >= sizeof(addr.sun_path))
+   {
+      RARCH_ERR("Control: socket path \"%s\" is too long.\n", path);
+      return false;
+   }
+   strlcpy(addr.sun_path, path, sizeof(addr.sun_path));
+
+   if ((handle->listen_fd = socket(AF_UNIX, SOCK_STREAM, 0)) < 0)
+      return false;
+
+   /* Remove a socket left behind by a previous run,
+    * but nothing else that happens to be in the way. */
+   if (lstat(path, &st) == 0)
+   {
+      if (!S_ISSOCK(st.st_mode))
+      {
+         RARCH_ERR("Control: \"%s\" exists and is not a socket.\n", path);
+         return false;
+      }
+      unlink(path);
+   }
+
+   if (bind(handle->listen_fd, (struct sockaddr*)&addr, sizeof(addr)) < 0)
+   {
+      RARCH_ERR("Control: failed to bind \"%s\".\n", path);
+      return false;
+   }
+
+   strlcpy(handle->path, path, sizeof(handle->path));
+   RARCH_LOG("Control: listening on \"%s\".\n", path);
+   return true;
+}
+#endif
+
+rarch_control_t *rarch_control_new(const char *path, uint16_t port)
+{
+   unsigned i;
+   bool ret;
+   rarch_control_t *handle = (rarch_control_t*)calloc(1, sizeof(*handle));
+   if (!handle)
+      return NULL;
+
+   handle->listen_fd = -1;
+#ifndef _WIN32
+   handle->wake_fd[0] = handle->wake_fd[1] = -1;
+#endif
+   for (i = 0; i < CONTROL_MAX_CLIENTS; i++)
+      handle->clients[i].fd = -1;
+
+   if (!netplay_init_network())
+      goto error;
+
+#ifndef _WIN32
+   if (path && *path)
+      ret = control_init_unix(handle, path);
+   else
+#endif
+      ret = control_init_tcp(handle, port);
+
+   if (!ret || listen(handle->listen_fd, CONTROL_MAX_CLIENTS) < 0
+         || !control_socket_nonblock(handle->listen_fd))
+      goto error;
+
+#ifndef _WIN32
+   if (pipe(handle->wake_fd) < 0
+         || !control_socket_nonblock(handle->wake_fd[0])
+         || !control_socket_nonblock(handle->wake_fd[1]))
+      goto error;
+#endif
+
+   if (!(handle->lock = slock_new()))
+      goto error;
+   if (!(handle->thread = sthread_create(control_thread, handle)))
+      goto error;
+
+   return handle;
+
+error:
+   rarch_control_free(handle);
+   return NULL;
+}
+
+void rarch_control_free(rarch_control_t *handle)
+{
+   unsigned i;
+
+   if (!handle)
+      return;
+
+   if (handle->thread)
+   {
+      slock_lock(handle->lock);
+      handle->quit = true;
+      slock_unlock(handle->lock);
+      control_wake(handle);
+      sthread_join(handle->thread);
+   }
+
+   for (i = 0; i < CONTROL_MAX_CLIENTS; i++)
+   {
+      if (handle->clients[i].fd >= 0)
+         close(handle->clients[i].fd);
+      free(handle->clients[i].out);
+   }
+
+   if (handle->listen_fd >= 0)
+      close(handle->listen_fd);
+
+#ifndef _WIN32
+   if (handle->path[0])
+      unlink(handle->path);
+   if (handle->wake_fd[0] >= 0)
+      close(handle->wake_fd[0]);
+   if (handle->wake_fd[1] >= 0)
+      close(handle->wake_fd[1]);
+#endif
+
+   if (handle->lock)
+      slock_free(handle->lock);
+   free(handle);
+}
@@ -0,0 +1,56 @@
+/*  RetroArch - A frontend for libretro.
+ *  Copyright (C) 2010-2014 - Hans-Kristian Arntzen
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef RARCH_CONTROL_H__
+#define RARCH_CONTROL_H__
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <stdint.h>
+#include "boolean.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Local request/response control server.
+ *
+ * Clients connect over TCP (loopback only) or a Unix domain socket
+ * and send newline terminated requests. Every request gets exactly
+ * one reply line starting with "OK" or "ERR", in order. Subscriptions
+ * additionally stream "EVENT" lines.
+ *
+ * Socket I/O lives on its own thread. Requests are executed on the
+ * main thread from rarch_control_frame(), which handles a bounded
+ * number of them per frame. */
+typedef struct rarch_control rarch_control_t;
+
+/* Listens on the Unix socket at path if it is non-empty,
+ * otherwise on 127.0.0.1:port. */
+rarch_control_t *rarch_control_new(const char *path, uint16_t port);
+
+void rarch_control_free(rarch_control_t *handle);
+
+/* Call once per main loop iteration. */
+void rarch_control_frame(rarch_control_t *handle);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
+
@@ -16,14 +16,19 @@
 #include "core_options.h"
 #include "general.h"
 #include "file.h"
+#include "hash.h"
 #include "compat/posix_string.h"
 
 struct core_option
 {
    char *desc;
    char *key;
+   uint32_t hash;
    struct string_list *vals;
    size_t index;
+
+   /* Value last handed to the core, to only log changes. */
+   const char *reported;
 };
 
 struct core_option_manager
@@ -34,8 +39,40 @@ struct core_option_manager
    struct core_option *opts;
    size_t size;
    bool updated;
+   /* Bumped on every change, for callers other than the core
+    * which can't use the updated flag. */
+   unsigned generation;
+
+   /* See hash_bucket(). Cores may query options every frame. */
+   uint32_t *index;
+   size_t index_mask;
 };
 
+static bool core_option_index_init(core_option_manager_t *opt)
+{
+   size_t i, slots = 16;
+
+   while (slots < opt->size * 2)
+      slots *= 2;
+
+   opt->index = (uint32_t*)calloc(slots, sizeof(*opt->index));
+   if (!opt->index)
+      return false;
+   opt->index_mask = slots - 1;
+
+   /* Inserted in order, so with duplicate keys
+    * the first one is found, as before. */
+   for (i = 0; i < opt->size; i++)
+   {
+      size_t slot = hash_bucket(opt->opts[i].hash, opt->index_mask);
+      while (opt->index[slot])
+         slot = (slot + 1) & opt->index_mask;
+      opt->index[slot] = i + 1;
+   }
+
+   return true;
+}
+
 void core_option_free(core_option_manager_t *opt)
 {
    size_t i;
@@ -52,23 +89,51 @@ void core_option_free(core_option_manager_t *opt)
    if (opt->conf)
       config_file_free(opt->conf);
    free(opt->opts);
+   free(opt->index);
    free(opt);
 }
 
-void core_option_get(core_option_manager_t *opt, struct retro_variable *var)
+static struct core_option *core_option_find(core_option_manager_t *opt,
+      const char *key)
 {
-   size_t i;
+   uint32_t hash = djb2_calculate(key);
+   size_t slot   = hash_bucket(hash, opt->index_mask);
+
+   for (; opt->index[slot]; slot = (slot + 1) & opt->index_mask)
+   {
+      struct core_option *option = &opt->opts[opt->index[slot] - 1];
+
+      if (option->hash == hash && strcmp(option->key, key) == 0)
+         return option;
+   }
+
+   return NULL;
+}
+
+bool core_option_get(core_option_manager_t *opt, struct retro_variable *var)
+{
+   struct core_option *option = core_option_find(opt, var->key);
+
    opt->updated = false;
-   for (i = 0; i < opt->size; i++)
+
+   if (!option)
    {
-      if (strcmp(opt->opts[i].key, var->key) == 0)
-      {
-         var->value = core_option_get_val(opt, i);
-         return;
-      }
+      var->value = NULL;
+      return false;
    }
 
-   var->value = NULL;
+   var->value = option->vals->elems[option->index].data;
+   if (option->reported == var->value)
+      return false;
+
+   option->reported = var->value;
+   return true;
+}
+
+const char *core_option_lookup(core_option_manager_t *opt, const char *key)
+{
+   struct core_option *option = core_option_find(opt, key);
+   return option ? option->vals->elems[option->index].data : NULL;
 }
 
 static bool parse_variable(core_option_manager_t *opt, size_t index,
@@ -77,6 +142,7 @@ static bool parse_variable(core_option_manager_t *opt, size_t index,
    size_t i;
    struct core_option *option = (struct core_option*)&opt->opts[index];
    option->key = strdup(var->key);
+   option->hash = djb2_calculate(var->key);
 
    char *value = strdup(var->value);
    char *desc_end = strstr(value, "; ");
@@ -164,6 +230,9 @@ core_option_manager_t *core_option_new(const char *conf_path,
          goto error;
    }
 
+   if (!core_option_index_init(opt))
+      goto error;
+
    return opt;
 
 error:
@@ -176,6 +245,11 @@ bool core_option_updated(core_option_manager_t *opt)
    return opt->updated;
 }
 
+unsigned core_option_generation(core_option_manager_t *opt)
+{
+   return opt->generation;
+}
+
 void core_option_flush(core_option_manager_t *opt)
 {
    size_t i;
@@ -215,6 +289,7 @@ void core_option_set_val(core_option_manager_t *opt,
    struct core_option *option= (struct core_option*)&opt->opts[index];
    option->index = val_index % option->vals->size;
    opt->updated = true;
+   opt->generation++;
 }
 
 void core_option_next(core_option_manager_t *opt, size_t index)
@@ -222,6 +297,7 @@ void core_option_next(core_option_manager_t *opt, size_t index)
    struct core_option *option = (struct core_option*)&opt->opts[index];
    option->index = (option->index + 1) % option->vals->size;
    opt->updated = true;
+   opt->generation++;
 }
 
 void core_option_prev(core_option_manager_t *opt, size_t index)
@@ -230,12 +306,14 @@ void core_option_prev(core_option_manager_t *opt, size_t index)
    option->index = (option->index + option->vals->size - 1) %
       option->vals->size;
    opt->updated = true;
+   opt->generation++;
 }
 
 void core_option_set_default(core_option_manager_t *opt, size_t index)
 {
    opt->opts[index].index = 0;
    opt->updated = true;
+   opt->generation++;
 }
 
 
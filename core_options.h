@@ -31,11 +31,21 @@ core_option_manager_t *core_option_new(const char *conf_path,
 
 bool core_option_updated(core_option_manager_t *opt);
 
+/* Changes with every option change. Unlike core_option_updated(),
+ * it isn't reset by core_option_get(). */
+unsigned core_option_generation(core_option_manager_t *opt);
+
 void core_option_flush(core_option_manager_t *opt);
 
 void core_option_free(core_option_manager_t *opt);
 
-void core_option_get(core_option_manager_t *opt, struct retro_variable *var);
+/* Sets var->value, or NULL if the key is unknown. Returns true
+ * if the value differs from what was last returned for this key. */
+bool core_option_get(core_option_manager_t *opt, struct retro_variable *var);
+
+/* Current value of an option, or NULL if the key is unknown. Unlike
+ * core_option_get(), it doesn't count as the core having seen it. */
+const char *core_option_lookup(core_option_manager_t *opt, const char *key);
 
 /* Returns total number of options. */
 size_t core_option_size(core_option_manager_t *opt);
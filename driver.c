@@ -991,7 +991,7 @@ static void init_audio(void)
          RARCH_WARN("Audio rate control was desired, but driver does not support needed features.\n");
    }
 
-   rarch_main_command(RARCH_CMD_DSP_FILTER_DEINIT);
+   rarch_main_command(RARCH_CMD_DSP_FILTER_INIT);
 
    g_extern.measure_data.buffer_free_samples_count = 0;
 
@@ -1467,6 +1467,10 @@ static void uninit_video_input(void)
 
    deinit_pixel_converter();
 
+   if (driver.frame_dupe.dupes)
+      RARCH_LOG("Detected %u duplicate frames.\n", driver.frame_dupe.dupes);
+   frame_dupe_free(&driver.frame_dupe);
+
    deinit_video_filter();
 
    rarch_main_command(RARCH_CMD_SHADER_DIR_DEINIT);
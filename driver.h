@@ -25,6 +25,7 @@
 #include <stdint.h>
 #include "msvc/msvc_compat.h"
 #include "gfx/scaler/scaler.h"
+#include "gfx/frame_dupe.h"
 #include "gfx/image/image.h"
 #include "gfx/filters/softfilter.h"
 #include "gfx/shader/shader_parse.h"
@@ -51,6 +52,10 @@
 #include "command.h"
 #endif
 
+#ifdef HAVE_CONTROL
+#include "control.h"
+#endif
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -381,6 +386,11 @@ typedef struct video_poke_interface
    void (*grab_mouse_toggle)(void *data);
 
    struct gfx_shader *(*get_current_shader)(void *data);
+
+   /* Only rows [y, y + height) of the next frame differ from the
+    * previous frame passed to frame(). Applies to the next frame()
+    * call only. Can be NULL, drivers then always update everything. */
+   void (*set_frame_dirty)(void *data, unsigned y, unsigned height);
 } video_poke_interface_t;
 
 typedef struct video_driver
@@ -506,6 +516,9 @@ typedef struct driver
 
 #ifdef HAVE_COMMAND
    rarch_cmd_t *command;
+#endif
+#ifdef HAVE_CONTROL
+   rarch_control_t *control;
 #endif
    bool stdin_claimed;
    bool block_hotkey;
@@ -527,6 +540,9 @@ typedef struct driver
    struct scaler_ctx scaler;
    void *scaler_out;
 
+   /* Turns frames the core resubmits unchanged into dupes. */
+   struct frame_dupe frame_dupe;
+
    /* Graphics driver requires RGBA byte order data (ABGR on little-endian)
     * for 32-bit.
     * This takes effect for overlay and shader cores that wants to load
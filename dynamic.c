@@ -93,6 +93,7 @@ void *(*pretro_get_memory_data)(unsigned);
 size_t (*pretro_get_memory_size)(unsigned);
 
 static bool ignore_environment_cb;
+static unsigned get_variable_misses;
 
 #ifdef HAVE_DYNAMIC
 static bool *load_no_content_hook;
@@ -392,6 +393,7 @@ void uninit_libretro_sym(void)
       core_option_flush(g_extern.system.core_options);
       core_option_free(g_extern.system.core_options);
    }
+   get_variable_misses = 0;
 
    /* No longer valid. */
    free(g_extern.system.special);
@@ -518,15 +520,28 @@ bool rarch_environment_cb(unsigned cmd, void *data)
 
       case RETRO_ENVIRONMENT_GET_VARIABLE:
       {
+         /* Some cores ask every frame. Only log values
+          * the core hasn't seen yet, and the first few misses. */
+         bool changed = false;
          struct retro_variable *var = (struct retro_variable*)data;
-         RARCH_LOG("Environ GET_VARIABLE %s:\n", var->key);
+         RARCH_PERFORMANCE_INIT(environ_get_variable);
+         RARCH_PERFORMANCE_START(environ_get_variable);
 
          if (g_extern.system.core_options)
-            core_option_get(g_extern.system.core_options, var);
+            changed = core_option_get(g_extern.system.core_options, var);
          else
             var->value = NULL;
 
-         RARCH_LOG("\t%s\n", var->value ? var->value : "N/A");
+         RARCH_PERFORMANCE_STOP(environ_get_variable);
+
+         if (changed)
+            RARCH_LOG("Environ GET_VARIABLE %s: %s\n", var->key, var->value);
+         else if (!var->value && get_variable_misses < 16)
+         {
+            RARCH_LOG("Environ GET_VARIABLE %s: N/A%s\n", var->key,
+                  ++get_variable_misses == 16 ?
+                  " (not logging further misses)" : "");
+         }
          break;
       }
 
@@ -557,6 +572,7 @@ bool rarch_environment_cb(unsigned cmd, void *data)
             options_path = buf;
          }
          g_extern.system.core_options = core_option_new(options_path, vars);
+         get_variable_misses = 0;
 
          break;
       }
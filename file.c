@@ -26,6 +26,7 @@
 #include "compat/strl.h"
 #include "hash.h"
 #include "file_extract.h"
+#include "file_map.h"
 
 #ifdef _WIN32
 #ifdef _XBOX
@@ -39,24 +40,104 @@
 #endif
 #endif
 
-static void patch_content(uint8_t **buf, ssize_t *size)
+/* Content or patch being patched. Mapped where possible, so
+ * patching doesn't read the whole source up front. Files inside
+ * archives are extracted with read_file(). */
+struct patch_file
 {
-   uint8_t *ret_buf = *buf;
-   ssize_t ret_size = *size;
+   const uint8_t *data;
+   size_t size;
+
+   file_map_t file;
+   void *buf;
+};
+
+static bool patch_file_open(struct patch_file *file, const char *path)
+{
+   ssize_t size;
+
+   if (!path_contains_compressed_file(path))
+   {
+      if (!file_map_open(&file->file, path, false))
+         return false;
+
+      file->data = file->file.data;
+      file->size = file->file.size;
+      return true;
+   }
 
+   size = read_file(path, &file->buf);
+   if (size < 0)
+      return false;
+
+   file->data = (const uint8_t*)file->buf;
+   file->size = size;
+   return true;
+}
+
+static void patch_file_close(struct patch_file *file)
+{
+   file_map_close(&file->file);
+   free(file->buf);
+   memset(file, 0, sizeof(*file));
+}
+
+/* Patched content is cached by the CRC32s of the content and the
+ * patch, so an unchanged pair doesn't get patched again. */
+static void patch_cache_path(char *path, size_t size,
+      const char *content_path,
+      const struct patch_file *content, const struct patch_file *patch)
+{
+   char name[PATH_MAX];
+   uint32_t content_crc = crc32_calculate(content->data, content->size);
+   uint32_t patch_crc = crc32_calculate(patch->data, patch->size);
+
+   snprintf(name, sizeof(name), "%s.%08x-%08x.patched",
+         path_basename(content_path),
+         (unsigned)content_crc, (unsigned)patch_crc);
+   fill_pathname_join(path, g_settings.patch_cache_directory, name, size);
+}
+
+static void patch_cache_write(const char *path,
+      const uint8_t *data, size_t size)
+{
+   char tmp_path[PATH_MAX];
+
+   /* A truncated temporary path could be renamed over anything. */
+   if (snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", path)
+         >= (int)sizeof(tmp_path))
+      RARCH_WARN("Patch cache path \"%s\" is too long, not caching.\n",
+            path);
+   else if (write_file(tmp_path, data, size) && rename(tmp_path, path) == 0)
+      RARCH_LOG("Cached patched content in \"%s\".\n", path);
+   else
+   {
+      remove(tmp_path);
+      RARCH_WARN("Failed to cache patched content in \"%s\".\n", path);
+   }
+}
+
+/* Patches the content with the UPS, BPS or IPS patch found for it.
+ * Returns the size of the patched content in buf, or -1 if there
+ * was no patch or patching failed. */
+static ssize_t patch_content(const char *path, uint8_t **buf)
+{
+   struct patch_file patch = {0};
+   struct patch_file content = {0};
    const char *patch_desc = NULL;
    const char *patch_path = NULL;
    patch_error_t err = PATCH_UNKNOWN;
    patch_func_t func = NULL;
-
-   ssize_t patch_size = 0;
-   void *patch_data = NULL;
-   bool success = false;
+   patch_size_func_t size_func = NULL;
+   char cache_path[PATH_MAX] = {0};
+   uint8_t *patched_content = NULL;
+   size_t target_size;
+   ssize_t ret = -1;
 
    if (g_extern.ups_pref + g_extern.bps_pref + g_extern.ips_pref > 1)
    {
       RARCH_WARN("Several patches are explicitly defined, ignoring all ...\n");
-      return;
+      return -1;
    }
 
    bool allow_bps = !g_extern.ups_pref && !g_extern.ips_pref;
@@ -64,83 +145,109 @@ static void patch_content(uint8_t **buf, ssize_t *size)
    bool allow_ips = !g_extern.ups_pref && !g_extern.bps_pref;
 
    if (allow_ups && *g_extern.ups_name
-         && (patch_size = read_file(g_extern.ups_name, &patch_data)) >= 0)
+         && patch_file_open(&patch, g_extern.ups_name))
    {
       patch_desc = "UPS";
       patch_path = g_extern.ups_name;
       func = ups_apply_patch;
+      size_func = ups_get_target_size;
    }
    else if (allow_bps && *g_extern.bps_name
-         && (patch_size = read_file(g_extern.bps_name, &patch_data)) >= 0)
+         && patch_file_open(&patch, g_extern.bps_name))
    {
       patch_desc = "BPS";
       patch_path = g_extern.bps_name;
       func = bps_apply_patch;
+      size_func = bps_get_target_size;
    }
    else if (allow_ips && *g_extern.ips_name
-         && (patch_size = read_file(g_extern.ips_name, &patch_data)) >= 0)
+         && patch_file_open(&patch, g_extern.ips_name))
    {
       patch_desc = "IPS";
       patch_path = g_extern.ips_name;
       func = ips_apply_patch;
+      size_func = ips_get_target_size;
    }
    else
    {
       RARCH_LOG("Did not find a valid content patch.\n");
-      return;
+      return -1;
    }
 
    RARCH_LOG("Found %s file in \"%s\", attempting to patch ...\n",
          patch_desc, patch_path);
 
-   size_t target_size = ret_size * 4; /* Just to be sure. */
-   uint8_t *patched_content = (uint8_t*)malloc(target_size);
+   if (!patch_file_open(&content, path))
+      goto end;
+
+   if (*g_settings.patch_cache_directory)
+   {
+      void *cached = NULL;
+      ssize_t cached_size;
+
+      patch_cache_path(cache_path, sizeof(cache_path),
+            path, &content, &patch);
+
+      if (path_file_exists(cache_path)
+            && (cached_size = read_file(cache_path, &cached)) >= 0)
+      {
+         RARCH_LOG("Loaded patched content from \"%s\".\n", cache_path);
+         *buf = (uint8_t*)cached;
+         ret = cached_size;
+         goto end;
+      }
+   }
+
+   target_size = size_func(patch.data, patch.size, content.size);
+   patched_content = (uint8_t*)malloc(target_size ? target_size : 1);
    if (!patched_content)
    {
       RARCH_ERR("Failed to allocate memory for patched content ...\n");
-      goto error;
+      goto end;
    }
 
-   err = func((const uint8_t*)patch_data, patch_size, ret_buf,
-         ret_size, patched_content, &target_size);
+   err = func(patch.data, patch.size, content.data, content.size,
+         patched_content, &target_size);
 
-   if (err == PATCH_SUCCESS)
+   if (err != PATCH_SUCCESS)
    {
-      RARCH_LOG("Content patched successfully (%s).\n", patch_desc);
-      success = true;
-   }
-   else
       RARCH_ERR("Failed to patch %s: Error #%u\n", patch_desc,
             (unsigned)err);
-
-   if (success)
-   {
-      free(ret_buf);
-      *buf = patched_content;
-      *size = target_size;
+      free(patched_content);
+      goto end;
    }
 
-   free(patch_data);
-   return;
+   RARCH_LOG("Content patched successfully (%s).\n", patch_desc);
 
-error:
-   *buf = ret_buf;
-   *size = ret_size;
-   free(patch_data);
+   if (*cache_path)
+      patch_cache_write(cache_path, patched_content, target_size);
+
+   *buf = patched_content;
+   ret = target_size;
+
+end:
+   patch_file_close(&content);
+   patch_file_close(&patch);
+   return ret;
 }
 
 static ssize_t read_content_file(const char *path, void **buf)
 {
    uint8_t *ret_buf = NULL;
    ssize_t ret = -1;
-   ret = read_file(path, (void**) &ret_buf);
-
-   if (ret <= 0)
-      return ret;
 
    /* Attempt to apply a patch. */
    if (!g_extern.block_patch)
-      patch_content(&ret_buf, &ret);
+      ret = patch_content(path, &ret_buf);
+
+   if (ret < 0)
+      ret = read_file(path, (void**) &ret_buf);
+
+   if (ret <= 0)
+   {
+      free(ret_buf);
+      return ret;
+   }
    
    g_extern.content_crc = crc32_calculate(ret_buf, ret);
    sha256_hash(g_extern.sha256, ret_buf, ret);
@@ -186,14 +293,23 @@ error:
    RARCH_WARN("Failed ... Cannot recover save file.\n");
 }
 
+/* Only serializes on the calling thread. Compressing and writing
+ * the state happens on the state writer's thread. */
 bool save_state(const char *path)
 {
+   void *data;
+   bool ret;
+
    RARCH_LOG("Saving state: \"%s\".\n", path);
    size_t size = pretro_serialize_size();
    if (size == 0)
       return false;
 
-   void *data = malloc(size);
+   if (!g_extern.state_writer)
+      g_extern.state_writer = savestate_writer_new();
+
+   data = g_extern.state_writer ?
+      savestate_writer_buffer(g_extern.state_writer, size) : NULL;
    if (!data)
    {
       RARCH_ERR("Failed to allocate memory for save state buffer.\n");
@@ -201,14 +317,14 @@ bool save_state(const char *path)
    }
 
    RARCH_LOG("State size: %d bytes.\n", (int)size);
-   bool ret = pretro_serialize(data, size);
+   ret = pretro_serialize(data, size);
    if (ret)
-      ret = write_file(path, data, size);
+      ret = savestate_writer_submit(g_extern.state_writer, path, size,
+            g_settings.savestate_compression);
 
    if (!ret)
       RARCH_ERR("Failed to save state to \"%s\".\n", path);
 
-   free(data);
    return ret;
 }
 
@@ -222,19 +338,22 @@ struct sram_block
 bool load_state(const char *path)
 {
    unsigned i;
-   void *buf = NULL;
-   ssize_t size = read_file(path, &buf);
+   struct savestate_data state;
+
+   /* A save to the same path might still be in flight. */
+   if (g_extern.state_writer)
+      savestate_writer_flush(g_extern.state_writer);
 
    RARCH_LOG("Loading state: \"%s\".\n", path);
 
-   if (size < 0)
+   if (!savestate_open(&state, path))
    {
       RARCH_ERR("Failed to load state from \"%s\".\n", path);
       return false;
    }
 
    bool ret = true;
-   RARCH_LOG("State size: %u bytes.\n", (unsigned)size);
+   RARCH_LOG("State size: %u bytes.\n", (unsigned)state.size);
 
    struct sram_block *blocks = NULL;
    unsigned num_blocks = 0;
@@ -272,7 +391,9 @@ bool load_state(const char *path)
       }
    }
 
-   ret = pretro_unserialize(buf, size);
+   ret = pretro_unserialize(state.data, state.size);
+   runahead_invalidate(g_extern.runahead);
+   savestate_close(&state);
 
    /* Flush back. */
    for (i = 0; i < num_blocks; i++)
@@ -347,6 +468,9 @@ static bool load_content(const struct retro_subsystem_info *special,
    if (!info)
       return false;
 
+   /* Only known for content loaded into memory. */
+   g_extern.content_crc = 0;
+
    for (i = 0; i < content->size; i++)
    {
       const char *path = content->elems[i].data;
@@ -421,6 +545,13 @@ static bool load_content(const struct retro_subsystem_info *special,
 
    if (!ret)
       RARCH_ERR("Failed to load game.\n");
+   else if (g_settings.run_ahead_enable &&
+         g_settings.run_ahead_secondary_instance)
+   {
+      /* The secondary run-ahead core loads the same content later. */
+      runahead_set_content(special || *content->elems[0].data ? info : NULL,
+            content->size, special != NULL, special ? special->id : 0);
+   }
 
 end:
    for (i = 0; i < content->size; i++)
@@ -22,6 +22,26 @@
 #include "msvc/msvc_compat.h"
 #include "general.h"
 
+/* Copies the live strings to a fresh block, dropping
+ * the ones released by pops and relabels. */
+static void file_list_compact(file_list_t *list)
+{
+   size_t i;
+
+   if (!string_arena_compact_begin(&list->arena))
+      return;
+
+   for (i = 0; i < list->size; i++)
+   {
+      struct item_file *item = &list->list[i];
+      item->path  = string_arena_strdup(&list->arena, item->path);
+      item->label = string_arena_strdup(&list->arena, item->label);
+      item->alt   = string_arena_strdup(&list->arena, item->alt);
+   }
+
+   string_arena_compact_end(&list->arena);
+}
+
 void file_list_push(file_list_t *list,
       const char *path, const char *label,
       unsigned type, size_t directory_ptr)
@@ -39,8 +59,8 @@ void file_list_push(file_list_t *list,
       driver.menu_ctx->list_insert(list, path, label, list->size);
 #endif
 
-   list->list[list->size].label = strdup(label);
-   list->list[list->size].path = strdup(path);
+   list->list[list->size].label = string_arena_strdup(&list->arena, label);
+   list->list[list->size].path = string_arena_strdup(&list->arena, path);
    list->list[list->size].alt = NULL;
    list->list[list->size].type = type;
    list->list[list->size].directory_ptr = directory_ptr;
@@ -67,8 +87,14 @@ void file_list_pop(file_list_t *list, size_t *directory_ptr)
          driver.menu_ctx->list_delete(list, list->size);
 #endif
       --list->size;
-      free(list->list[list->size].path);
-      free(list->list[list->size].label);
+      string_arena_release(&list->arena, list->list[list->size].path);
+      string_arena_release(&list->arena, list->list[list->size].label);
+      string_arena_release(&list->arena, list->list[list->size].alt);
+
+      if (list->size == 0)
+         string_arena_clear(&list->arena);
+      else if (string_arena_should_compact(&list->arena))
+         file_list_compact(list);
    }
 
    if (directory_ptr)
@@ -82,30 +108,17 @@ void file_list_pop(file_list_t *list, size_t *directory_ptr)
 
 void file_list_free(file_list_t *list)
 {
-   size_t i;
-
    if (!list)
       return;
 
-   for (i = 0; i < list->size; i++)
-   {
-      free(list->list[i].path);
-      free(list->list[i].label);
-   }
+   string_arena_free(&list->arena);
    free(list->list);
    free(list);
 }
 
 void file_list_clear(file_list_t *list)
 {
-   size_t i;
-
-   for (i = 0; i < list->size; i++)
-   {
-      free(list->list[i].path);
-      free(list->list[i].label);
-      free(list->list[i].alt);
-   }
+   string_arena_clear(&list->arena);
 
 #ifdef HAVE_MENU
    if (driver.menu_ctx && driver.menu_ctx->list_clear)
@@ -117,8 +130,11 @@ void file_list_clear(file_list_t *list)
 void file_list_set_label_at_offset(file_list_t *list, size_t index,
       const char *label)
 {
-   free(list->list[index].label);
-   list->list[index].label = strdup(label);
+   string_arena_release(&list->arena, list->list[index].label);
+   list->list[index].label = string_arena_strdup(&list->arena, label);
+
+   if (string_arena_should_compact(&list->arena))
+      file_list_compact(list);
 }
 
 void file_list_get_label_at_offset(const file_list_t *list, size_t index,
@@ -132,8 +148,11 @@ void file_list_get_label_at_offset(const file_list_t *list, size_t index,
 void file_list_set_alt_at_offset(file_list_t *list, size_t index,
       const char *alt)
 {
-   free(list->list[index].alt);
-   list->list[index].alt = strdup(alt);
+   string_arena_release(&list->arena, list->list[index].alt);
+   list->list[index].alt = string_arena_strdup(&list->arena, alt);
+
+   if (string_arena_should_compact(&list->arena))
+      file_list_compact(list);
 }
 
 void file_list_get_alt_at_offset(const file_list_t *list, size_t index,
@@ -153,9 +172,48 @@ static int file_list_alt_cmp(const void *a_, const void *b_)
    return strcasecmp(cmp_a, cmp_b);
 }
 
+static int file_list_alt_ptr_cmp(const void *a_, const void *b_)
+{
+   return file_list_alt_cmp(*(const struct item_file**)a_,
+         *(const struct item_file**)b_);
+}
+
+/* Sorts pointers rather than moving whole entries around
+ * on every swap, then lays the entries out once. */
 void file_list_sort_on_alt(file_list_t *list)
 {
-   qsort(list->list, list->size, sizeof(list->list[0]), file_list_alt_cmp);
+   size_t i;
+   struct item_file **order = NULL;
+   struct item_file *sorted = NULL;
+
+   if (list->size < 2)
+      return;
+
+   order  = (struct item_file**)malloc(list->size * sizeof(*order));
+   sorted = (struct item_file*)malloc(list->capacity * sizeof(*sorted));
+
+   if (!order || !sorted)
+   {
+      free(order);
+      free(sorted);
+      qsort(list->list, list->size, sizeof(list->list[0]), file_list_alt_cmp);
+      return;
+   }
+
+   for (i = 0; i < list->size; i++)
+      order[i] = &list->list[i];
+
+   qsort(order, list->size, sizeof(*order), file_list_alt_ptr_cmp);
+
+   for (i = 0; i < list->size; i++)
+      sorted[i] = *order[i];
+   /* file_list_pop() reads back the entry past the end. */
+   memcpy(sorted + list->size, list->list + list->size,
+         (list->capacity - list->size) * sizeof(*sorted));
+
+   free(list->list);
+   list->list = sorted;
+   free(order);
 }
 
 void file_list_get_at_offset(const file_list_t *list, size_t index,
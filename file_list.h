@@ -22,6 +22,7 @@ extern "C" {
 #endif
 
 #include "boolean.h"
+#include "string_list.h"
 
 struct item_file
 {
@@ -32,12 +33,16 @@ struct item_file
    size_t directory_ptr;
 };
 
+/* Strings are owned by the list's arena; a zeroed file_list_t is
+ * an empty list. */
 typedef struct file_list
 {
    struct item_file *list;
 
    size_t capacity;
    size_t size;
+
+   struct string_arena arena;
 } file_list_t;
 
 
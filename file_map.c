@@ -0,0 +1,132 @@
+/*  RetroArch - A frontend for libretro.
+ *  Copyright (C) 2010-2014 - Hans-Kristian Arntzen
+ * 
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "file_map.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef HAVE_MMAP
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+/* Setting up and tearing down a mapping costs more than reading
+ * a small file. */
+#define FILE_MAP_MIN_SIZE (64 * 1024)
+
+static bool file_map_fd(file_map_t *file, int fd, size_t size,
+      bool sequential)
+{
+   size_t pos = 0;
+
+   if (size >= FILE_MAP_MIN_SIZE)
+   {
+      void *map = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+      if (map != MAP_FAILED)
+      {
+#ifdef MADV_SEQUENTIAL
+         if (sequential)
+            madvise(map, size, MADV_SEQUENTIAL);
+#endif
+         file->map  = map;
+         file->data = (const uint8_t*)map;
+         file->size = size;
+         return true;
+      }
+   }
+
+   /* One more byte, so that an empty file still has a buffer. */
+   if (!(file->buf = malloc(size + 1)))
+      return false;
+
+   while (pos < size)
+   {
+      ssize_t ret = read(fd, (uint8_t*)file->buf + pos, size - pos);
+      if (ret <= 0)
+      {
+         free(file->buf);
+         file->buf = NULL;
+         return false;
+      }
+      pos += ret;
+   }
+
+   file->data = (const uint8_t*)file->buf;
+   file->size = size;
+   return true;
+}
+
+bool file_map_open(file_map_t *file, const char *path, bool sequential)
+{
+   struct stat fds;
+   bool ret = false;
+   int fd   = open(path, O_RDONLY);
+
+   memset(file, 0, sizeof(*file));
+   if (fd < 0)
+      return false;
+
+   if (fstat(fd, &fds) == 0 && S_ISREG(fds.st_mode))
+      ret = file_map_fd(file, fd, fds.st_size, sequential);
+
+   close(fd);
+   return ret;
+}
+#else
+bool file_map_open(file_map_t *file, const char *path, bool sequential)
+{
+   long len;
+   FILE *fp = fopen(path, "rb");
+
+   (void)sequential;
+   memset(file, 0, sizeof(*file));
+   if (!fp)
+      return false;
+
+   if (fseek(fp, 0, SEEK_END) != 0 || (len = ftell(fp)) < 0)
+      goto error;
+   rewind(fp);
+
+   /* One more byte, so that an empty file still has a buffer. */
+   if (!(file->buf = malloc(len + 1)))
+      goto error;
+
+   if (fread(file->buf, 1, len, fp) != (size_t)len)
+      goto error;
+
+   fclose(fp);
+   file->data = (const uint8_t*)file->buf;
+   file->size = len;
+   return true;
+
+error:
+   fclose(fp);
+   free(file->buf);
+   file->buf = NULL;
+   return false;
+}
+#endif
+
+void file_map_close(file_map_t *file)
+{
+#ifdef HAVE_MMAP
+   if (file->map)
+      munmap(file->map, file->size);
+#endif
+   free(file->buf);
+   memset(file, 0, sizeof(*file));
+}
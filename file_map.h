@@ -0,0 +1,53 @@
+/*  RetroArch - A frontend for libretro.
+ *  Copyright (C) 2010-2014 - Hans-Kristian Arntzen
+ * 
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __RARCH_FILE_MAP_H
+#define __RARCH_FILE_MAP_H
+
+#include "boolean.h"
+#include <stdint.h>
+#include <stddef.h>
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* A whole file in memory, mapped with mmap() where possible and
+ * read into a heap buffer otherwise, e.g. for small files or on
+ * platforms without mmap(). Has no dependencies on the rest of
+ * RetroArch, so standalone tools can use it. */
+typedef struct file_map
+{
+   const uint8_t *data;
+   size_t size;
+
+   void *map;
+   void *buf;
+} file_map_t;
+
+/* Set sequential if the data will be read once from start to end,
+ * so the kernel can read ahead. */
+bool file_map_open(file_map_t *file, const char *path, bool sequential);
+void file_map_close(file_map_t *file);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -99,6 +99,8 @@ void main_exit(args_type() args)
    }
 
    rarch_perf_log();
+   if (*g_extern.perfcnt_trace_path)
+      rarch_perf_trace_dump(g_extern.perfcnt_trace_path);
 
 #if defined(HAVE_LOGGER) && !defined(ANDROID)
    logger_shutdown();
@@ -518,6 +518,8 @@ int menu_action_setting_set(unsigned id, const char *label,
       {
          g_settings.input.libretro_device[port] = current_device;
          pretro_set_controller_port_device(port, current_device);
+         runahead_set_controller_port_device(g_extern.runahead,
+               port, current_device);
       }
 
    }
@@ -94,11 +94,6 @@ bool load_menu_content(void)
          snprintf(str, sizeof(str), "INFO - Loading %s ...", tmp);
          msg_queue_push(g_extern.msg_queue, str, 1, 1);
       }
-
-      content_playlist_push(g_defaults.history,
-            g_extern.fullpath,
-            g_settings.libretro,
-            g_extern.menu.info.library_name);
    }
 
    /* redraw menu frame */
@@ -135,6 +130,15 @@ bool load_menu_content(void)
    menu_shader_manager_init(driver.menu);
 
    rarch_main_command(RARCH_CMD_HISTORY_INIT);
+
+   /* Pushed once loaded, so the content CRC is known. */
+   if (*g_extern.fullpath || (driver.menu && driver.menu->load_no_content))
+      content_playlist_push(g_defaults.history,
+            *g_extern.fullpath ? g_extern.fullpath : NULL,
+            g_settings.libretro,
+            g_extern.menu.info.library_name,
+            g_extern.content_crc);
+
    rarch_main_command(RARCH_CMD_VIDEO_SET_ASPECT_RATIO);
    rarch_main_command(RARCH_CMD_RESUME);
 
@@ -29,6 +29,7 @@
 #include "../../input/keyboard_line.h"
 #include "menu_input_line_cb.h"
 #include "../../settings_data.h"
+#include "../../playlist.h"
 
 void menu_key_start_line(void *data, const char *label,
       const char *label_setting, input_keyboard_line_complete_t cb)
@@ -61,9 +62,18 @@ static void menu_key_end_line(void *data)
 
 static void menu_search_callback(void *userdata, const char *str)
 {
+   size_t idx = 0;
+   const char *label = NULL;
    menu_handle_t *menu = (menu_handle_t*)userdata;
 
-   if (str && *str)
+   file_list_get_last(menu->menu_stack, NULL, &label, NULL);
+
+   /* History entries line up with the playlist, so use its
+    * name index instead of scanning the labels. */
+   if (str && *str && label && !strcmp(label, "history_list")
+         && content_playlist_find_prefix(g_defaults.history, str, &idx, 1))
+      menu->selection_ptr = idx;
+   else if (str && *str)
       file_list_search(menu->selection_buf, str, &menu->selection_ptr);
    menu_key_end_line(menu);
 }
@@ -37,7 +37,8 @@ void rarch_playlist_push(content_playlist_t *playlist,
       content_playlist_push(playlist,
             *tmp ? tmp : NULL,
             g_settings.libretro,
-            g_extern.system.info.library_name);
+            g_extern.system.info.library_name,
+            *tmp ? g_extern.content_crc : 0);
 }
 
 void rarch_playlist_load_content(content_playlist_t *playlist,
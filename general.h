@@ -24,6 +24,8 @@
 #include "driver.h"
 #include "message_queue.h"
 #include "rewind.h"
+#include "runahead.h"
+#include "savestate.h"
 #include "movie.h"
 #include "autosave.h"
 #include "dynamic.h"
@@ -103,6 +105,9 @@ enum basic_event
    RARCH_CMD_REWIND_DEINIT,
    RARCH_CMD_REWIND_INIT,
    RARCH_CMD_REWIND_TOGGLE,
+   RARCH_CMD_RUNAHEAD_DEINIT,
+   RARCH_CMD_RUNAHEAD_INIT,
+   RARCH_CMD_RUNAHEAD_TOGGLE,
    RARCH_CMD_AUTOSAVE_DEINIT,
    RARCH_CMD_AUTOSAVE_INIT,
    RARCH_CMD_AUTOSAVE_STATE,
@@ -152,6 +157,8 @@ enum basic_event
    RARCH_CMD_BSV_MOVIE_DEINIT,
    RARCH_CMD_COMMAND_INIT,
    RARCH_CMD_COMMAND_DEINIT,
+   RARCH_CMD_CONTROL_INIT,
+   RARCH_CMD_CONTROL_DEINIT,
    RARCH_CMD_DRIVERS_DEINIT,
    RARCH_CMD_DRIVERS_INIT,
    RARCH_CMD_TEMPORARY_CONTENT_DEINIT,
@@ -254,6 +261,7 @@ struct settings
       char softfilter_plugin[PATH_MAX];
       float refresh_rate;
       bool threaded;
+      bool frame_dupe_detect;
 
       char filter_dir[PATH_MAX];
       char shader_dir[PATH_MAX];
@@ -271,6 +279,7 @@ struct settings
 
       bool post_filter_record;
       bool gpu_record;
+      char record_backpressure[32];
       bool gpu_screenshot;
 
       bool allow_rotate;
@@ -378,12 +387,17 @@ struct settings
    char system_directory[PATH_MAX];
 
    char extraction_directory[PATH_MAX];
+   char patch_cache_directory[PATH_MAX];
    char playlist_directory[PATH_MAX];
 
    bool rewind_enable;
    size_t rewind_buffer_size;
    unsigned rewind_granularity;
 
+   bool run_ahead_enable;
+   unsigned run_ahead_frames;
+   bool run_ahead_secondary_instance;
+
    float slowmotion_ratio;
    float fastforward_ratio;
    bool fastforward_ratio_throttle_enable;
@@ -395,11 +409,17 @@ struct settings
    bool savestate_auto_index;
    bool savestate_auto_save;
    bool savestate_auto_load;
+   bool savestate_compression;
+   unsigned movie_keyframe_interval;
 
    bool network_cmd_enable;
    uint16_t network_cmd_port;
    bool stdin_cmd_enable;
 
+   bool control_socket_enable;
+   uint16_t control_socket_port;
+   char control_socket_path[PATH_MAX];
+
    char content_directory[PATH_MAX];
    char assets_directory[PATH_MAX];
    char menu_config_directory[PATH_MAX];
@@ -443,6 +463,7 @@ struct global
 {
    bool verbosity;
    bool perfcnt_enable;
+   char perfcnt_trace_path[PATH_MAX];
    bool force_fullscreen;
    bool core_shutdown_initiated;
 
@@ -619,6 +640,10 @@ struct global
    size_t state_size;
    bool frame_is_reverse;
 
+   /* Run-ahead support. */
+   runahead_t *runahead;
+   savestate_writer_t *state_writer;
+
    /* Movie playback/recording support. */
    struct
    {
@@ -654,6 +679,11 @@ struct global
    uint16_t turbo_enable[MAX_PLAYERS];
    unsigned turbo_count;
 
+   /* Keys held this frame as polled by rarch_main_iterate(),
+    * a bitmask of RARCH_BIND_LIST indices for player 1. 
+    * Lets others avoid querying the input driver again. */
+   uint64_t frame_input;
+
    /* Autosave support. */
    autosave_t **autosave;
    unsigned num_autosave;
@@ -690,6 +720,26 @@ struct global
    unsigned frame_count;
    unsigned max_frames;
 
+   /* Headless benchmark mode, see --benchmark. */
+   struct
+   {
+      char path[PATH_MAX];
+      unsigned start_frame;
+      retro_time_t start_usec;
+      retro_perf_tick_t start_tick;
+   } benchmark;
+
+   /* State hashes for comparing replays, see --checkpoints. */
+   struct
+   {
+      char path[PATH_MAX];
+      unsigned interval;
+      unsigned frame;
+      FILE *file;
+      void *buf;
+      size_t size;
+   } checkpoint;
+
    char title_buf[64];
 
    struct
@@ -815,6 +865,7 @@ void rarch_main_set_state(unsigned action);
 bool rarch_main_command(unsigned action);
 int rarch_main_iterate(void);
 void rarch_main_deinit(void);
+void rarch_main_checkpoint(void);
 void rarch_render_cached_frame(void);
 bool rarch_check_fullscreen(bool pressed);
 void rarch_disk_control_set_eject(bool state, bool log);
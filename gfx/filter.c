@@ -263,7 +263,9 @@ static bool append_softfilter_plugs(rarch_softfilter_t *filt,
          continue;
       }
 
-      if (impl->api_version != SOFTFILTER_API_VERSION)
+      /* Version 3 only appended optional members. */
+      if (impl->api_version < 2 ||
+            impl->api_version > SOFTFILTER_API_VERSION)
       {
          dylib_close(lib);
          continue;
@@ -448,16 +450,10 @@ enum retro_pixel_format rarch_softfilter_get_output_format(
    return filt->out_pix_fmt;
 }
 
-void rarch_softfilter_process(rarch_softfilter_t *filt,
-      void *output, size_t output_stride,
-      const void *input, unsigned width, unsigned height, size_t input_stride)
+static void softfilter_run_packets(rarch_softfilter_t *filt)
 {
    unsigned i;
 
-   if (filt && filt->impl && filt->impl->get_work_packets)
-      filt->impl->get_work_packets(filt->impl_data, filt->packets,
-            output, output_stride, input, width, height, input_stride);
-   
 #ifdef HAVE_THREADS
    /* Fire off workers */
    for (i = 0; i < filt->threads; i++)
@@ -489,3 +485,42 @@ void rarch_softfilter_process(rarch_softfilter_t *filt,
 #endif
 }
 
+void rarch_softfilter_process(rarch_softfilter_t *filt,
+      void *output, size_t output_stride,
+      const void *input, unsigned width, unsigned height, size_t input_stride)
+{
+   if (filt && filt->impl && filt->impl->get_work_packets)
+      filt->impl->get_work_packets(filt->impl_data, filt->packets,
+            output, output_stride, input, width, height, input_stride);
+
+   softfilter_run_packets(filt);
+}
+
+void rarch_softfilter_process_dirty(rarch_softfilter_t *filt,
+      void *output, size_t output_stride,
+      const void *input, unsigned width, unsigned height, size_t input_stride,
+      unsigned dirty_y, unsigned dirty_height,
+      unsigned *out_dirty_y, unsigned *out_dirty_height)
+{
+   unsigned out_width = 0;
+
+   if (dirty_height && dirty_height < height &&
+         filt && filt->impl && filt->impl->api_version >= 3 &&
+         filt->impl->get_work_packets_dirty)
+   {
+      filt->impl->get_work_packets_dirty(filt->impl_data, filt->packets,
+            output, output_stride, input, width, height, input_stride,
+            dirty_y, dirty_height, out_dirty_y, out_dirty_height);
+      softfilter_run_packets(filt);
+      return;
+   }
+
+   rarch_softfilter_process(filt, output, output_stride,
+         input, width, height, input_stride);
+
+   *out_dirty_y = 0;
+   *out_dirty_height = 0;
+   rarch_softfilter_get_output_size(filt, &out_width, out_dirty_height,
+         width, height);
+}
+
@@ -45,6 +45,17 @@ void rarch_softfilter_process(rarch_softfilter_t *filt,
       void *output, size_t output_stride,
       const void *input, unsigned width, unsigned height, size_t input_stride);
 
+/* Same as rarch_softfilter_process(), but only input rows
+ * [dirty_y, dirty_y + dirty_height) changed since the previous call
+ * and output still holds its result. The output rows which changed are
+ * returned in out_dirty_y/out_dirty_height. Filters which cannot
+ * process partial frames process the whole frame instead. */
+void rarch_softfilter_process_dirty(rarch_softfilter_t *filt,
+      void *output, size_t output_stride,
+      const void *input, unsigned width, unsigned height, size_t input_stride,
+      unsigned dirty_y, unsigned dirty_height,
+      unsigned *out_dirty_y, unsigned *out_dirty_height);
+
 const char *rarch_softfilter_get_name(void *data);
 
 #endif
@@ -135,25 +135,27 @@ static void darken_work_cb_rgb565(void *data, void *thread_data)
          output[x] = (input[x] >> 2) & ((0x7 << 0) | (0xf << 5) | (0x7 << 11));
 }
 
-static void darken_packets(void *data,
+/* Splits rows [y_begin, y_end) over the worker threads. */
+static void darken_packets_rows(struct filter_data *filt,
       struct softfilter_work_packet *packets,
       void *output, size_t output_stride,
-      const void *input, unsigned width, unsigned height, size_t input_stride)
+      const void *input, unsigned width, size_t input_stride,
+      unsigned y_begin, unsigned y_end)
 {
    unsigned i;
-   struct filter_data *filt = (struct filter_data*)data;
+   unsigned rows = y_end - y_begin;
    for (i = 0; i < filt->threads; i++)
    {
       struct softfilter_thread_data *thr = 
          (struct softfilter_thread_data*)&filt->workers[i];
-      unsigned y_start = (height * i) / filt->threads;
-      unsigned y_end = (height * (i + 1)) / filt->threads;
+      unsigned y_start = y_begin + (rows * i) / filt->threads;
+      unsigned y_stop = y_begin + (rows * (i + 1)) / filt->threads;
       thr->out_data = (uint8_t*)output + y_start * output_stride;
       thr->in_data = (const uint8_t*)input + y_start * input_stride;
       thr->out_pitch = output_stride;
       thr->in_pitch = input_stride;
       thr->width = width;
-      thr->height = y_end - y_start;
+      thr->height = y_stop - y_start;
 
       if (filt->in_fmt == SOFTFILTER_FMT_XRGB8888)
          packets[i].work = darken_work_cb_xrgb8888;
@@ -163,6 +165,31 @@ static void darken_packets(void *data,
    }
 }
 
+static void darken_packets(void *data,
+      struct softfilter_work_packet *packets,
+      void *output, size_t output_stride,
+      const void *input, unsigned width, unsigned height, size_t input_stride)
+{
+   darken_packets_rows((struct filter_data*)data, packets,
+         output, output_stride, input, width, input_stride, 0, height);
+}
+
+/* Every output pixel only depends on the input pixel below it. */
+static void darken_packets_dirty(void *data,
+      struct softfilter_work_packet *packets,
+      void *output, size_t output_stride,
+      const void *input, unsigned width, unsigned height, size_t input_stride,
+      unsigned dirty_y, unsigned dirty_height,
+      unsigned *out_dirty_y, unsigned *out_dirty_height)
+{
+   darken_packets_rows((struct filter_data*)data, packets,
+         output, output_stride, input, width, input_stride,
+         dirty_y, dirty_y + dirty_height);
+
+   *out_dirty_y = dirty_y;
+   *out_dirty_height = dirty_height;
+}
+
 static const struct softfilter_implementation darken = {
    darken_input_fmts,
    darken_output_fmts,
@@ -176,6 +203,7 @@ static const struct softfilter_implementation darken = {
    SOFTFILTER_API_VERSION,
    "Darken",
    "darken",
+   darken_packets_dirty,
 };
 
 const struct softfilter_implementation *softfilter_get_implementation(
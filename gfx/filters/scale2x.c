@@ -199,32 +199,34 @@ static void scale2x_work_cb_rgb565(void *data, void *thread_data)
          thr->out_pitch / SOFTFILTER_BPP_RGB565);
 }
 
-static void scale2x_generic_packets(void *data,
+/* Splits input rows [y_begin, y_end) over the worker threads. */
+static void scale2x_generic_packets_rows(struct filter_data *filt,
       struct softfilter_work_packet *packets,
       void *output, size_t output_stride,
-      const void *input, unsigned width, unsigned height, size_t input_stride)
+      const void *input, unsigned width, unsigned height, size_t input_stride,
+      unsigned y_begin, unsigned y_end)
 {
-   struct filter_data *filt = (struct filter_data*)data;
    unsigned i;
+   unsigned rows = y_end - y_begin;
    for (i = 0; i < filt->threads; i++)
    {
       struct softfilter_thread_data *thr = 
          (struct softfilter_thread_data*)&filt->workers[i];
 
-      unsigned y_start = (height * i) / filt->threads;
-      unsigned y_end = (height * (i + 1)) / filt->threads;
+      unsigned y_start = y_begin + (rows * i) / filt->threads;
+      unsigned y_stop = y_begin + (rows * (i + 1)) / filt->threads;
       thr->out_data = (uint8_t*)output + y_start * 
          SCALE2X_SCALE * output_stride;
       thr->in_data = (const uint8_t*)input + y_start * input_stride;
       thr->out_pitch = output_stride;
       thr->in_pitch = input_stride;
       thr->width = width;
-      thr->height = y_end - y_start;
+      thr->height = y_stop - y_start;
 
       /* Workers need to know if they can access pixels 
        * outside their given buffer. */
-      thr->first = y_start;
-      thr->last = y_end == height;
+      thr->first = y_start == 0;
+      thr->last = y_stop == height;
 
       if (filt->in_fmt == SOFTFILTER_FMT_XRGB8888)
          packets[i].work = scale2x_work_cb_xrgb8888;
@@ -234,6 +236,38 @@ static void scale2x_generic_packets(void *data,
    }
 }
 
+static void scale2x_generic_packets(void *data,
+      struct softfilter_work_packet *packets,
+      void *output, size_t output_stride,
+      const void *input, unsigned width, unsigned height, size_t input_stride)
+{
+   scale2x_generic_packets_rows((struct filter_data*)data, packets,
+         output, output_stride, input, width, height, input_stride,
+         0, height);
+}
+
+/* An output pixel depends on the input rows directly above and
+ * below it, so a changed row also changes its neighbours' output. */
+static void scale2x_generic_packets_dirty(void *data,
+      struct softfilter_work_packet *packets,
+      void *output, size_t output_stride,
+      const void *input, unsigned width, unsigned height, size_t input_stride,
+      unsigned dirty_y, unsigned dirty_height,
+      unsigned *out_dirty_y, unsigned *out_dirty_height)
+{
+   unsigned y_begin = dirty_y ? dirty_y - 1 : 0;
+   unsigned y_end   = dirty_y + dirty_height;
+   if (y_end < height)
+      y_end++;
+
+   scale2x_generic_packets_rows((struct filter_data*)data, packets,
+         output, output_stride, input, width, height, input_stride,
+         y_begin, y_end);
+
+   *out_dirty_y = y_begin * SCALE2X_SCALE;
+   *out_dirty_height = (y_end - y_begin) * SCALE2X_SCALE;
+}
+
 static const struct softfilter_implementation scale2x_generic = {
    scale2x_generic_input_fmts,
    scale2x_generic_output_fmts,
@@ -247,6 +281,7 @@ static const struct softfilter_implementation scale2x_generic = {
    SOFTFILTER_API_VERSION,
    "Scale2x",
    "scale2x",
+   scale2x_generic_packets_dirty,
 };
 
 const struct softfilter_implementation *softfilter_get_implementation(
@@ -92,7 +92,7 @@ typedef const struct softfilter_implementation
 const struct softfilter_implementation *softfilter_get_implementation(
       softfilter_simd_mask_t simd);
 
-#define SOFTFILTER_API_VERSION  2
+#define SOFTFILTER_API_VERSION  3
 
 /* Required base color formats */
 
@@ -159,6 +159,23 @@ typedef void (*softfilter_get_work_packets_t)(void *data,
  * compared to the value passed to create(). */
 typedef unsigned (*softfilter_query_num_threads_t)(void *data);
 
+/* Optional, since API version 3.
+ * Same as softfilter_get_work_packets_t, but only input rows
+ * [dirty_y, dirty_y + dirty_height) changed since the previous call,
+ * which had the same input size. output still holds the result of
+ * the previous call and the filter only needs to redo the output rows
+ * affected by the changed rows. It reports those rows in
+ * out_dirty_y and out_dirty_height.
+ *
+ * dirty_height is never 0. Filters which depend on anything
+ * but the current input (e.g. previous frames) must not implement this. */
+typedef void (*softfilter_get_work_packets_dirty_t)(void *data,
+      struct softfilter_work_packet *packets,
+      void *output, size_t output_stride,
+      const void *input, unsigned width, unsigned height, size_t input_stride,
+      unsigned dirty_y, unsigned dirty_height,
+      unsigned *out_dirty_y, unsigned *out_dirty_height);
+
 struct softfilter_implementation
 {
    softfilter_query_input_formats_t query_input_formats;
@@ -171,13 +188,17 @@ struct softfilter_implementation
    softfilter_query_output_size_t query_output_size;
    softfilter_get_work_packets_t get_work_packets;
 
-   /* Must be SOFTFILTER_API_VERSION. */
+   /* Must be SOFTFILTER_API_VERSION.
+    * Version 2 implementations end after short_ident. */
    unsigned api_version;
    /* Human readable identifier of implementation. */
    const char *ident;
    /* Computer-friendly short version of ident.
     * Lower case, no spaces and special characters, etc. */
    const char *short_ident;
+
+   /* Can be NULL. */
+   softfilter_get_work_packets_dirty_t get_work_packets_dirty;
 };
 
 #ifdef __cplusplus
@@ -0,0 +1,113 @@
+/*  RetroArch - A frontend for libretro.
+ *  Copyright (C) 2010-2014 - Hans-Kristian Arntzen
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "frame_dupe.h"
+#include <stdlib.h>
+#include <string.h>
+
+/* Compares rows with memcmp(), which is vectorized in any
+ * reasonable libc and stops at the first difference. The last changed
+ * row is searched from the bottom, so a frame is read at most once.
+ * Only the rows in between need copying. */
+bool frame_dupe_check(struct frame_dupe *dupe, const void *data,
+      unsigned width, unsigned height, size_t pitch, size_t line_size)
+{
+   unsigned y = 0;
+   unsigned y_end = height;
+   const uint8_t *in = (const uint8_t*)data;
+   uint8_t *out;
+   size_t size = line_size * height;
+
+   if (dupe->valid && dupe->width == width && dupe->height == height &&
+         dupe->line_size == line_size)
+   {
+      for (y = 0, out = dupe->frame; y < height;
+            y++, in += pitch, out += line_size)
+         if (memcmp(out, in, line_size) != 0)
+            break;
+
+      if (y == height)
+      {
+         dupe->dirty_y      = 0;
+         dupe->dirty_height = 0;
+         dupe->dupes++;
+         return true;
+      }
+
+      while (y_end - 1 > y &&
+            memcmp(dupe->frame + (y_end - 1) * line_size,
+               (const uint8_t*)data + (y_end - 1) * pitch, line_size) == 0)
+         y_end--;
+   }
+   else
+   {
+      if (size > dupe->size)
+      {
+         uint8_t *frame = (uint8_t*)realloc(dupe->frame, size);
+         if (!frame)
+         {
+            frame_dupe_invalidate(dupe);
+            dupe->dirty_y      = 0;
+            dupe->dirty_height = height;
+            return false;
+         }
+
+         dupe->frame = frame;
+         dupe->size  = size;
+      }
+
+      dupe->width     = width;
+      dupe->height    = height;
+      dupe->line_size = line_size;
+      dupe->valid     = true;
+   }
+
+   dupe->dirty_y      = y;
+   dupe->dirty_height = y_end - y;
+
+   for (out = dupe->frame + y * line_size; y < y_end;
+         y++, in += pitch, out += line_size)
+      memcpy(out, in, line_size);
+
+   return false;
+}
+
+bool frame_dupe_update(struct frame_dupe *dupe, bool check,
+      const void *data, unsigned width, unsigned height,
+      size_t pitch, size_t line_size)
+{
+   if (check)
+      return frame_dupe_check(dupe, data, width, height, pitch, line_size);
+
+   frame_dupe_invalidate(dupe);
+   dupe->dirty_y      = 0;
+   dupe->dirty_height = height;
+   return false;
+}
+
+void frame_dupe_invalidate(struct frame_dupe *dupe)
+{
+   dupe->valid = false;
+}
+
+void frame_dupe_free(struct frame_dupe *dupe)
+{
+   free(dupe->frame);
+   dupe->frame = NULL;
+   dupe->size  = 0;
+   dupe->valid = false;
+   dupe->dupes = 0;
+}
@@ -0,0 +1,68 @@
+/*  RetroArch - A frontend for libretro.
+ *  Copyright (C) 2010-2014 - Hans-Kristian Arntzen
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef RARCH_FRAME_DUPE_H__
+#define RARCH_FRAME_DUPE_H__
+
+#include <stddef.h>
+#include <stdint.h>
+#include "../boolean.h"
+
+/* Detects frames the core resubmits unchanged, so they can be
+ * passed on as dupes (NULL frames) and skip all processing.
+ * For changed frames it tracks the band of rows which differ from
+ * the previous frame, so later stages can skip the rest. */
+struct frame_dupe
+{
+   uint8_t *frame;
+   size_t size;
+
+   unsigned width;
+   unsigned height;
+   size_t line_size;
+   bool valid;
+
+   /* Rows which changed in the last checked frame.
+    * The whole frame if there is no previous frame to compare with,
+    * dirty_height is 0 for a duplicate. */
+   unsigned dirty_y;
+   unsigned dirty_height;
+
+   /* Number of frames detected as duplicates. */
+   unsigned dupes;
+};
+
+/* Returns true if the frame is identical to the previous one.
+ * Otherwise the frame is remembered for the next call.
+ * Sets dirty_y and dirty_height in both cases.
+ * line_size is the number of bytes per row holding pixels. */
+bool frame_dupe_check(struct frame_dupe *dupe, const void *data,
+      unsigned width, unsigned height, size_t pitch, size_t line_size);
+
+/* Like frame_dupe_check(), but only if check is true. Otherwise the
+ * previous frame is forgotten and the whole frame is dirty, since
+ * frames shown in the meantime weren't compared or remembered. */
+bool frame_dupe_update(struct frame_dupe *dupe, bool check,
+      const void *data, unsigned width, unsigned height,
+      size_t pitch, size_t line_size);
+
+/* Forgets the previous frame, e.g. when the video driver lost it. */
+void frame_dupe_invalidate(struct frame_dupe *dupe);
+
+/* Frees the frame copy and resets the counter. */
+void frame_dupe_free(struct frame_dupe *dupe);
+
+#endif
@@ -22,6 +22,7 @@
 #include "../driver.h"
 #include "../performance.h"
 #include "scaler/scaler.h"
+#include "scaler/pixconv.h"
 #include "image/image.h"
 #include "../file.h"
 
@@ -1156,6 +1157,8 @@ static inline void gl_convert_frame_argb8888_abgr8888(gl_t *gl,
 static void gl_init_textures_data(gl_t *gl)
 {
    unsigned i;
+
+   gl->frame_uploaded = false;
    for (i = 0; i < gl->textures; i++)
    {
       gl->last_width[i]  = gl->tex_w;
@@ -1257,8 +1260,19 @@ static void gl_init_textures(gl_t *gl, const video_info_t *video)
 static inline void gl_copy_frame(gl_t *gl, const void *frame,
       unsigned width, unsigned height, unsigned pitch)
 {
+   unsigned y = 0;
+
    RARCH_PERFORMANCE_INIT(copy_frame);
    RARCH_PERFORMANCE_START(copy_frame);
+
+   /* Only upload the rows which changed. */
+   if (gl->frame_dirty_height)
+   {
+      y      = gl->frame_dirty_y;
+      height = gl->frame_dirty_height;
+      frame  = (const uint8_t*)frame + y * pitch;
+   }
+
 #if defined(HAVE_OPENGLES2)
 #if defined(HAVE_EGL)
    if (gl->egl_images)
@@ -1285,17 +1299,22 @@ static inline void gl_copy_frame(gl_t *gl, const void *frame,
       /* Fallback for GLES devices without GL_BGRA_EXT. */
       if (gl->base_size == 4 && driver.gfx_use_rgba)
       {
-         gl_convert_frame_argb8888_abgr8888(gl, gl->conv_buffer,
-               frame, width, height, pitch);
+         /* Don't regenerate the scaler for every band height. */
+         if (gl->frame_dirty_height)
+            conv_argb8888_abgr8888(gl->conv_buffer, frame,
+                  width, height, width * sizeof(uint32_t), pitch);
+         else
+            gl_convert_frame_argb8888_abgr8888(gl, gl->conv_buffer,
+                  frame, width, height, pitch);
          glTexSubImage2D(GL_TEXTURE_2D,
-               0, 0, 0, width, height, gl->texture_type,
+               0, 0, y, width, height, gl->texture_type,
                gl->texture_fmt, gl->conv_buffer);
       }
       else if (gl->support_unpack_row_length)
       {
          glPixelStorei(GL_UNPACK_ROW_LENGTH, pitch / gl->base_size);
          glTexSubImage2D(GL_TEXTURE_2D,
-               0, 0, 0, width, height, gl->texture_type,
+               0, 0, y, width, height, gl->texture_type,
                gl->texture_fmt, frame);
 
          glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
@@ -1324,7 +1343,7 @@ static inline void gl_copy_frame(gl_t *gl, const void *frame,
          }
 
          glTexSubImage2D(GL_TEXTURE_2D,
-               0, 0, 0, width, height, gl->texture_type,
+               0, 0, y, width, height, gl->texture_type,
                gl->texture_fmt, data_buf);         
       }
    }
@@ -1336,7 +1355,8 @@ static inline void gl_copy_frame(gl_t *gl, const void *frame,
    size_t frame_copy_size    = width * gl->base_size;
 
    uint8_t *buffer = (uint8_t*)glMapBuffer(
-         GL_TEXTURE_REFERENCE_BUFFER_SCE, GL_READ_WRITE) + buffer_addr;
+         GL_TEXTURE_REFERENCE_BUFFER_SCE, GL_READ_WRITE) + buffer_addr
+      + y * buffer_stride;
    for (h = 0; h < height; h++, buffer += buffer_stride, frame_copy += pitch)
       memcpy(buffer, frame_copy, frame_copy_size);
 
@@ -1347,16 +1367,21 @@ static inline void gl_copy_frame(gl_t *gl, const void *frame,
 
    if (gl->base_size == 2 && !gl->have_es2_compat)
    {
-      /* Convert to 32-bit textures on desktop GL. */
-      gl_convert_frame_rgb16_32(gl, gl->conv_buffer,
-            frame, width, height, pitch);
+      /* Convert to 32-bit textures on desktop GL.
+       * Don't regenerate the scaler for every band height. */
+      if (gl->frame_dirty_height)
+         conv_rgb565_argb8888(gl->conv_buffer, frame,
+               width, height, width * sizeof(uint32_t), pitch);
+      else
+         gl_convert_frame_rgb16_32(gl, gl->conv_buffer,
+               frame, width, height, pitch);
       data_buf = gl->conv_buffer;
    }
    else
       glPixelStorei(GL_UNPACK_ROW_LENGTH, pitch / gl->base_size);
 
    glTexSubImage2D(GL_TEXTURE_2D,
-         0, 0, 0, width, height, gl->texture_type,
+         0, 0, y, width, height, gl->texture_type,
          gl->texture_fmt, data_buf);
 
    glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
@@ -1519,8 +1544,17 @@ static bool gl_frame(void *data, const void *frame,
       if (!gl->hw_render_fbo_init)
 #endif
       {
+         /* A partial update needs the previous frame, of the same size,
+          * in the same texture. */
+         if (!gl->frame_uploaded || gl->textures > 1 || gl->egl_images ||
+               width != gl->last_width[gl->tex_index] ||
+               height != gl->last_height[gl->tex_index] ||
+               gl->frame_dirty_y + gl->frame_dirty_height > height)
+            gl->frame_dirty_height = 0;
+
          gl_update_input_size(gl, width, height, pitch, true);
          gl_copy_frame(gl, frame, width, height, pitch);
+         gl->frame_uploaded = true;
       }
 
       /* No point regenerating mipmaps 
@@ -1528,6 +1562,7 @@ static bool gl_frame(void *data, const void *frame,
       if (gl->tex_mipmap)
          glGenerateMipmap(GL_TEXTURE_2D);
    }
+   gl->frame_dirty_height = 0;
 
    /* Have to reset rendering state which libretro core 
     * could easily have overridden. */
@@ -2936,6 +2971,13 @@ static retro_proc_address_t gl_get_proc_address(void *data, const char *sym)
 }
 #endif
 
+static void gl_set_frame_dirty(void *data, unsigned y, unsigned height)
+{
+   gl_t *gl = (gl_t*)data;
+   gl->frame_dirty_y      = y;
+   gl->frame_dirty_height = height;
+}
+
 static void gl_set_aspect_ratio(void *data, unsigned aspect_ratio_idx)
 {
    gl_t *gl = (gl_t*)data;
@@ -3084,6 +3126,7 @@ static const video_poke_interface_t gl_poke_interface = {
    NULL,
 
    gl_get_current_shader,
+   gl_set_frame_dirty,
 };
 
 static void gl_get_poke_interface(void *data,
@@ -222,6 +222,14 @@ typedef struct gl
    unsigned last_width[MAX_TEXTURES];
    unsigned last_height[MAX_TEXTURES];
    unsigned tex_w, tex_h;
+
+   /* Rows of the next frame which changed, see set_frame_dirty.
+    * If frame_dirty_height is 0, the whole frame is uploaded. */
+   unsigned frame_dirty_y;
+   unsigned frame_dirty_height;
+   /* The texture holds the last frame, so only changed rows
+    * of the next frame need uploading. */
+   bool frame_uploaded;
    math_matrix mvp, mvp_no_rot;
 
    struct gl_coords coords;
@@ -36,6 +36,9 @@ static bool null_gfx_frame(void *data, const void *frame,
    (void)pitch;
    (void)msg;
 
+   /* Needed for --max-frames, as with every other driver. */
+   g_extern.frame_count++;
+
    return true;
 }
 
@@ -14,6 +14,7 @@
  */
 
 #include "rpng.h"
+#include "../../file_map.h"
 
 #include <zlib.h>
 
@@ -25,6 +26,12 @@
 #include <malloc.h>
 #endif
 
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON__)
+#include <arm_neon.h>
+#endif
+
 #ifdef RARCH_INTERNAL
 #include "../../hash.h"
 #else
@@ -53,7 +60,7 @@ struct png_chunk
 {
    uint32_t size;
    char type[4];
-   uint8_t *data;
+   const uint8_t *data;
 };
 
 struct png_ihdr
@@ -82,17 +89,23 @@ static uint32_t dword_be(const uint8_t *buf)
    return (buf[0] << 24) | (buf[1] << 16) | (buf[2] << 8) | (buf[3] << 0);
 }
 
-static bool read_chunk_header(FILE *file, struct png_chunk *chunk)
+static bool png_read_chunk(const uint8_t **buf, const uint8_t *end,
+      struct png_chunk *chunk)
 {
-   uint8_t dword[4] = {0};
-   if (fread(dword, 1, 4, file) != 4)
+   const uint8_t *ptr = *buf;
+   if (end - ptr < 8)
       return false;
 
-   chunk->size = dword_be(dword);
+   chunk->size = dword_be(ptr);
+   memcpy(chunk->type, ptr + 4, 4);
+   ptr += 8;
 
-   if (fread(chunk->type, 1, 4, file) != 4)
+   /* Payload plus CRC32. Ignore CRC. */
+   if ((size_t)(end - ptr) < (size_t)chunk->size + sizeof(uint32_t))
       return false;
 
+   chunk->data = ptr;
+   *buf = ptr + chunk->size + sizeof(uint32_t);
    return true;
 }
 
@@ -107,12 +120,6 @@ struct
    { "PLTE", PNG_CHUNK_PLTE },
 };
 
-struct idat_buffer
-{
-   uint8_t *data;
-   size_t size;
-};
-
 static enum png_chunk_type png_chunk_type(const struct png_chunk *chunk)
 {
    unsigned i;
@@ -125,40 +132,11 @@ static enum png_chunk_type png_chunk_type(const struct png_chunk *chunk)
    return PNG_CHUNK_NOOP;
 }
 
-static bool png_read_chunk(FILE *file, struct png_chunk *chunk)
-{
-   free(chunk->data);
-   chunk->data = (uint8_t*)calloc(1, chunk->size + sizeof(uint32_t)); /* CRC32 */
-   if (!chunk->data)
-      return false;
-
-   if (fread(chunk->data, 1, chunk->size + 
-            sizeof(uint32_t), file) != (chunk->size + sizeof(uint32_t)))
-   {
-      free(chunk->data);
-      return false;
-   }
-
-   /* Ignore CRC. */
-   return true;
-}
-
-static void png_free_chunk(struct png_chunk *chunk)
-{
-   if (!chunk)
-      return;
-
-   free(chunk->data);
-   chunk->data = NULL;
-}
-
-static bool png_parse_ihdr(FILE *file,
-      struct png_chunk *chunk, struct png_ihdr *ihdr)
+static bool png_parse_ihdr(const struct png_chunk *chunk,
+      struct png_ihdr *ihdr)
 {
    unsigned i;
    bool ret = true;
-   if (!png_read_chunk(file, chunk))
-      return false;
 
    if (chunk->size != 13)
       GOTO_END_ERROR();
@@ -174,7 +152,7 @@ static bool png_parse_ihdr(FILE *file,
    if (ihdr->width == 0 || ihdr->height == 0)
       GOTO_END_ERROR();
 
-   if (ihdr->color_type == 2 || 
+   if (ihdr->color_type == 2 ||
          ihdr->color_type == 4 || ihdr->color_type == 6)
    {
       if (ihdr->depth != 8 && ihdr->depth != 16)
@@ -231,7 +209,6 @@ static bool png_parse_ihdr(FILE *file,
    //   GOTO_END_ERROR();
 
 end:
-   png_free_chunk(chunk);
    return ret;
 }
 
@@ -250,6 +227,347 @@ static inline int paeth(int a, int b, int c)
    return c;
 }
 
+/* Scanline unfiltering. All filters work in-place on the filtered
+ * line; prev is the previous unfiltered line (all zero for the first
+ * line of a pass). Sub, Average and Paeth carry a dependency on the
+ * pixel to the left, so the SIMD variants work a pixel at a time for
+ * 3 and 4 byte pixels, which covers RGB8 and RGBA8 images. Pixels are
+ * always loaded as 4 bytes, so the kernels stop short of the last
+ * RGB8 pixel and leave it to the scalar loop.
+ */
+static void unfilter_sub_c(uint8_t *line, unsigned start,
+      unsigned pitch, unsigned bpp)
+{
+   unsigned i;
+   for (i = start; i < pitch; i++)
+      line[i] += i >= bpp ? line[i - bpp] : 0;
+}
+
+static void unfilter_up_c(uint8_t *line, const uint8_t *prev,
+      unsigned start, unsigned pitch)
+{
+   unsigned i;
+   for (i = start; i < pitch; i++)
+      line[i] += prev[i];
+}
+
+static void unfilter_avg_c(uint8_t *line, const uint8_t *prev,
+      unsigned start, unsigned pitch, unsigned bpp)
+{
+   unsigned i;
+   for (i = start; i < pitch; i++)
+      line[i] += ((i >= bpp ? line[i - bpp] : 0) + prev[i]) >> 1;
+}
+
+static void unfilter_paeth_c(uint8_t *line, const uint8_t *prev,
+      unsigned start, unsigned pitch, unsigned bpp)
+{
+   unsigned i;
+   for (i = start; i < pitch; i++)
+   {
+      if (i >= bpp)
+         line[i] += paeth(line[i - bpp], prev[i], prev[i - bpp]);
+      else
+         line[i] += paeth(0, prev[i], 0);
+   }
+}
+
+#if defined(__SSE2__)
+static inline __m128i load_px_sse2(const uint8_t *ptr)
+{
+   uint32_t px;
+   memcpy(&px, ptr, sizeof(px));
+   return _mm_cvtsi32_si128(px);
+}
+
+static inline void store_px_sse2(uint8_t *ptr, __m128i px, unsigned bpp)
+{
+   uint32_t val = _mm_cvtsi128_si32(px);
+   memcpy(ptr, &val, bpp);
+}
+
+static inline unsigned unfilter_up_sse2(uint8_t *line, const uint8_t *prev,
+      unsigned pitch)
+{
+   unsigned i;
+   for (i = 0; i + 16 <= pitch; i += 16)
+   {
+      __m128i x = _mm_loadu_si128((const __m128i*)(line + i));
+      __m128i b = _mm_loadu_si128((const __m128i*)(prev + i));
+      _mm_storeu_si128((__m128i*)(line + i), _mm_add_epi8(x, b));
+   }
+   return i;
+}
+
+static inline unsigned unfilter_sub_sse2(uint8_t *line,
+      unsigned pitch, unsigned bpp)
+{
+   unsigned i;
+   __m128i a = _mm_setzero_si128();
+
+   if (bpp == 4)
+   {
+      /* Prefix sum over the four pixels in a vector,
+       * then carry in the last pixel of the previous vector. */
+      for (i = 0; i + 16 <= pitch; i += 16)
+      {
+         __m128i x = _mm_loadu_si128((const __m128i*)(line + i));
+         x = _mm_add_epi8(x, _mm_slli_si128(x, 4));
+         x = _mm_add_epi8(x, _mm_slli_si128(x, 8));
+         x = _mm_add_epi8(x, a);
+         _mm_storeu_si128((__m128i*)(line + i), x);
+         a = _mm_shuffle_epi32(x, _MM_SHUFFLE(3, 3, 3, 3));
+      }
+      return i;
+   }
+
+   for (i = 0; i + 4 <= pitch; i += bpp)
+   {
+      a = _mm_add_epi8(a, load_px_sse2(line + i));
+      store_px_sse2(line + i, a, bpp);
+   }
+   return i;
+}
+
+static inline unsigned unfilter_avg_sse2(uint8_t *line, const uint8_t *prev,
+      unsigned pitch, unsigned bpp)
+{
+   unsigned i;
+   __m128i a = _mm_setzero_si128();
+   const __m128i one = _mm_set1_epi8(1);
+
+   for (i = 0; i + 4 <= pitch; i += bpp)
+   {
+      __m128i b = load_px_sse2(prev + i);
+      __m128i x = load_px_sse2(line + i);
+
+      /* _mm_avg_epu8 rounds up, PNG wants (a + b) >> 1. */
+      __m128i avg = _mm_avg_epu8(a, b);
+      avg = _mm_sub_epi8(avg, _mm_and_si128(_mm_xor_si128(a, b), one));
+
+      a = _mm_add_epi8(x, avg);
+      store_px_sse2(line + i, a, bpp);
+   }
+   return i;
+}
+
+static inline __m128i abs_i16_sse2(__m128i x)
+{
+   return _mm_max_epi16(x, _mm_sub_epi16(_mm_setzero_si128(), x));
+}
+
+static inline __m128i select_sse2(__m128i mask, __m128i a, __m128i b)
+{
+   return _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b));
+}
+
+static inline unsigned unfilter_paeth_sse2(uint8_t *line, const uint8_t *prev,
+      unsigned pitch, unsigned bpp)
+{
+   unsigned i;
+   const __m128i zero = _mm_setzero_si128();
+   __m128i a = zero;
+   __m128i c = zero;
+
+   /* Work in 16-bit lanes so the predictor distances don't overflow. */
+   for (i = 0; i + 4 <= pitch; i += bpp)
+   {
+      __m128i b = _mm_unpacklo_epi8(load_px_sse2(prev + i), zero);
+      __m128i x = _mm_unpacklo_epi8(load_px_sse2(line + i), zero);
+
+      __m128i pa = _mm_sub_epi16(b, c);
+      __m128i pb = _mm_sub_epi16(a, c);
+      __m128i pc = _mm_add_epi16(pa, pb);
+      __m128i smallest, nearest;
+
+      pa = abs_i16_sse2(pa);
+      pb = abs_i16_sse2(pb);
+      pc = abs_i16_sse2(pc);
+
+      /* Ties favor a over b over c. */
+      smallest = _mm_min_epi16(pc, _mm_min_epi16(pa, pb));
+      nearest  = select_sse2(_mm_cmpeq_epi16(smallest, pa), a,
+            select_sse2(_mm_cmpeq_epi16(smallest, pb), b, c));
+
+      /* Byte-wise add wraps mod 256, high bytes stay zero. */
+      a = _mm_add_epi8(x, nearest);
+      store_px_sse2(line + i, _mm_packus_epi16(a, a), bpp);
+      c = b;
+   }
+   return i;
+}
+#elif defined(__ARM_NEON__)
+static inline uint8x8_t load_px_neon(const uint8_t *ptr)
+{
+   uint32_t px;
+   memcpy(&px, ptr, sizeof(px));
+   return vreinterpret_u8_u32(vdup_n_u32(px));
+}
+
+static inline void store_px_neon(uint8_t *ptr, uint8x8_t px, unsigned bpp)
+{
+   uint32_t val = vget_lane_u32(vreinterpret_u32_u8(px), 0);
+   memcpy(ptr, &val, bpp);
+}
+
+static inline unsigned unfilter_up_neon(uint8_t *line, const uint8_t *prev,
+      unsigned pitch)
+{
+   unsigned i;
+   for (i = 0; i + 16 <= pitch; i += 16)
+      vst1q_u8(line + i, vaddq_u8(vld1q_u8(line + i), vld1q_u8(prev + i)));
+   return i;
+}
+
+static inline unsigned unfilter_sub_neon(uint8_t *line,
+      unsigned pitch, unsigned bpp)
+{
+   unsigned i;
+   uint8x8_t a = vdup_n_u8(0);
+   for (i = 0; i + 4 <= pitch; i += bpp)
+   {
+      a = vadd_u8(a, load_px_neon(line + i));
+      store_px_neon(line + i, a, bpp);
+   }
+   return i;
+}
+
+static inline unsigned unfilter_avg_neon(uint8_t *line, const uint8_t *prev,
+      unsigned pitch, unsigned bpp)
+{
+   unsigned i;
+   uint8x8_t a = vdup_n_u8(0);
+   for (i = 0; i + 4 <= pitch; i += bpp)
+   {
+      /* vhadd truncates, which is exactly (a + b) >> 1. */
+      uint8x8_t avg = vhadd_u8(a, load_px_neon(prev + i));
+      a = vadd_u8(load_px_neon(line + i), avg);
+      store_px_neon(line + i, a, bpp);
+   }
+   return i;
+}
+
+static inline unsigned unfilter_paeth_neon(uint8_t *line, const uint8_t *prev,
+      unsigned pitch, unsigned bpp)
+{
+   unsigned i;
+   uint8x8_t a = vdup_n_u8(0);
+   uint8x8_t c = vdup_n_u8(0);
+
+   for (i = 0; i + 4 <= pitch; i += bpp)
+   {
+      uint8x8_t b    = load_px_neon(prev + i);
+      uint16x8_t p1  = vaddl_u8(a, b);
+      uint16x8_t pc  = vaddl_u8(c, c);
+      uint16x8_t pa  = vabdl_u8(b, c);
+      uint16x8_t pb  = vabdl_u8(a, c);
+      uint8x8_t use_b, use_a, nearest;
+
+      pc = vabdq_u16(p1, pc);
+
+      /* Ties favor a over b over c. */
+      use_a   = vmovn_u16(vandq_u16(vcleq_u16(pa, pb), vcleq_u16(pa, pc)));
+      use_b   = vmovn_u16(vcleq_u16(pb, pc));
+      nearest = vbsl_u8(use_a, a, vbsl_u8(use_b, b, c));
+
+      a = vadd_u8(load_px_neon(line + i), nearest);
+      store_px_neon(line + i, a, bpp);
+      c = b;
+   }
+   return i;
+}
+#endif
+
+#if defined(__SSE2__) || defined(__ARM_NEON__)
+#if defined(__SSE2__)
+#define UNFILTER_SIMD(filter) unfilter_##filter##_sse2
+#else
+#define UNFILTER_SIMD(filter) unfilter_##filter##_neon
+#endif
+
+/* Instantiates the kernels with a constant pixel size so the
+ * pixel loads and stores compile down to plain moves.
+ * Returns how many bytes of the line were unfiltered. */
+static unsigned png_unfilter_line_simd(uint8_t *line, const uint8_t *prev,
+      unsigned filter, unsigned pitch, unsigned bpp)
+{
+   if (bpp == 4)
+   {
+      switch (filter)
+      {
+         case 1:
+            return UNFILTER_SIMD(sub)(line, pitch, 4);
+         case 2:
+            return UNFILTER_SIMD(up)(line, prev, pitch);
+         case 3:
+            return UNFILTER_SIMD(avg)(line, prev, pitch, 4);
+         case 4:
+            return UNFILTER_SIMD(paeth)(line, prev, pitch, 4);
+      }
+   }
+   else if (bpp == 3)
+   {
+      switch (filter)
+      {
+         case 1:
+            return UNFILTER_SIMD(sub)(line, pitch, 3);
+         case 2:
+            return UNFILTER_SIMD(up)(line, prev, pitch);
+         case 3:
+            return UNFILTER_SIMD(avg)(line, prev, pitch, 3);
+         case 4:
+            return UNFILTER_SIMD(paeth)(line, prev, pitch, 3);
+      }
+   }
+
+   return 0;
+}
+#endif
+
+#ifdef RPNG_TEST
+bool rpng_test_disable_simd;
+#endif
+
+static bool png_unfilter_line(uint8_t *line, const uint8_t *prev,
+      unsigned filter, unsigned pitch, unsigned bpp)
+{
+   unsigned start = 0;
+
+   if (filter > 4)
+      return false;
+
+#if defined(__SSE2__) || defined(__ARM_NEON__)
+#ifdef RPNG_TEST
+   if (!rpng_test_disable_simd)
+#endif
+      start = png_unfilter_line_simd(line, prev, filter, pitch, bpp);
+#endif
+
+   switch (filter)
+   {
+      case 1: /* Sub */
+         unfilter_sub_c(line, start, pitch, bpp);
+         break;
+
+      case 2: /* Up */
+         unfilter_up_c(line, prev, start, pitch);
+         break;
+
+      case 3: /* Average */
+         unfilter_avg_c(line, prev, start, pitch, bpp);
+         break;
+
+      case 4: /* Paeth */
+         unfilter_paeth_c(line, prev, start, pitch, bpp);
+         break;
+
+      default: /* None */
+         break;
+   }
+
+   return true;
+}
+
 static inline void copy_line_rgb(uint32_t *data,
       const uint8_t *decoded, unsigned width, unsigned bpp)
 {
@@ -270,9 +588,29 @@ static inline void copy_line_rgb(uint32_t *data,
 static inline void copy_line_rgba(uint32_t *data,
       const uint8_t *decoded, unsigned width, unsigned bpp)
 {
-   unsigned i;
+   unsigned i = 0;
+
+#if defined(__SSE2__)
+   if (bpp == 8)
+   {
+      /* RGBA bytes to ARGB words is an R/B swap within each pixel. */
+      const __m128i mask_ag = _mm_set1_epi32(0xff00ff00);
+      const __m128i mask_b  = _mm_set1_epi32(0x000000ff);
+      for (; i + 4 <= width; i += 4)
+      {
+         __m128i px = _mm_loadu_si128((const __m128i*)(decoded + 4 * i));
+         __m128i ag = _mm_and_si128(px, mask_ag);
+         __m128i r  = _mm_and_si128(_mm_srli_epi32(px, 16), mask_b);
+         __m128i b  = _mm_slli_epi32(_mm_and_si128(px, mask_b), 16);
+         _mm_storeu_si128((__m128i*)(data + i),
+               _mm_or_si128(ag, _mm_or_si128(r, b)));
+      }
+      decoded += 4 * i;
+   }
+#endif
+
    bpp /= 8;
-   for (i = 0; i < width; i++)
+   for (; i < width; i++)
    {
       uint32_t r = *decoded;
       decoded += bpp;
@@ -349,6 +687,23 @@ static inline void copy_line_plt(uint32_t *data,
    }
 }
 
+static void png_copy_line(uint32_t *data, const struct png_ihdr *ihdr,
+      const uint8_t *decoded, const uint32_t *palette)
+{
+   if (ihdr->color_type == 0)
+      copy_line_bw(data, decoded, ihdr->width, ihdr->depth);
+   else if (ihdr->color_type == 2)
+      copy_line_rgb(data, decoded, ihdr->width, ihdr->depth);
+   else if (ihdr->color_type == 3)
+      copy_line_plt(data, decoded, ihdr->width,
+            ihdr->depth, palette);
+   else if (ihdr->color_type == 4)
+      copy_line_gray_alpha(data, decoded, ihdr->width,
+            ihdr->depth);
+   else if (ihdr->color_type == 6)
+      copy_line_rgba(data, decoded, ihdr->width, ihdr->depth);
+}
+
 static void png_pass_geom(const struct png_ihdr *ihdr,
       unsigned width, unsigned height,
       unsigned *bpp_out, unsigned *pitch_out, size_t *pass_size)
@@ -396,94 +751,43 @@ static void png_pass_geom(const struct png_ihdr *ihdr,
       *pitch_out = pitch;
 }
 
-
+/* Unfilters a whole pass in-place. Only used for Adam7 images,
+ * progressive images are unfiltered while they are inflated. */
 static bool png_reverse_filter(uint32_t *data, const struct png_ihdr *ihdr,
-      const uint8_t *inflate_buf, size_t inflate_buf_size,
+      uint8_t *inflate_buf, size_t inflate_buf_size,
       const uint32_t *palette)
 {
-   unsigned i, h;
+   unsigned h;
    bool ret = true;
 
    unsigned bpp;
    unsigned pitch;
    size_t pass_size;
+   const uint8_t *prev_scanline = NULL;
+   uint8_t *zero_scanline       = NULL;
    png_pass_geom(ihdr, ihdr->width, ihdr->height, &bpp, &pitch, &pass_size);
 
    if (inflate_buf_size < pass_size)
       return false;
 
-   uint8_t *prev_scanline    = (uint8_t*)calloc(1, pitch);
-   uint8_t *decoded_scanline = (uint8_t*)calloc(1, pitch);
-
-   if (!prev_scanline || !decoded_scanline)
+   zero_scanline = (uint8_t*)calloc(1, pitch);
+   if (!zero_scanline)
       GOTO_END_ERROR();
 
+   prev_scanline = zero_scanline;
    for (h = 0; h < ihdr->height;
-         h++, inflate_buf += pitch, data += ihdr->width)
+         h++, inflate_buf += pitch + 1, data += ihdr->width)
    {
-      unsigned filter = *inflate_buf++;
-      switch (filter)
-      {
-         case 0: /* None */
-            memcpy(decoded_scanline, inflate_buf, pitch);
-            break;
-
-         case 1: /* Sub */
-            for (i = 0; i < bpp; i++)
-               decoded_scanline[i] = inflate_buf[i];
-            for (i = bpp; i < pitch; i++)
-               decoded_scanline[i] = decoded_scanline[i - bpp] + inflate_buf[i];
-            break;
-
-         case 2: /* Up */
-            for (i = 0; i < pitch; i++)
-               decoded_scanline[i] = prev_scanline[i] + inflate_buf[i];
-            break;
-
-         case 3: /* Average */
-            for (i = 0; i < bpp; i++)
-            {
-               uint8_t avg = prev_scanline[i] >> 1;
-               decoded_scanline[i] = avg + inflate_buf[i];
-            }
-            for (i = bpp; i < pitch; i++)
-            {
-               uint8_t avg = (decoded_scanline[i - bpp] + prev_scanline[i]) >> 1;
-               decoded_scanline[i] = avg + inflate_buf[i];
-            }
-            break;
-
-         case 4: /* Paeth */
-            for (i = 0; i < bpp; i++)
-               decoded_scanline[i] = paeth(0, prev_scanline[i], 0) + inflate_buf[i];
-            for (i = bpp; i < pitch; i++)
-               decoded_scanline[i] = paeth(decoded_scanline[i - bpp],
-                     prev_scanline[i], prev_scanline[i - bpp]) + inflate_buf[i];
-            break;
-
-         default:
-            GOTO_END_ERROR();
-      }
+      if (!png_unfilter_line(inflate_buf + 1, prev_scanline,
+               inflate_buf[0], pitch, bpp))
+         GOTO_END_ERROR();
 
-      if (ihdr->color_type == 0)
-         copy_line_bw(data, decoded_scanline, ihdr->width, ihdr->depth);
-      else if (ihdr->color_type == 2)
-         copy_line_rgb(data, decoded_scanline, ihdr->width, ihdr->depth);
-      else if (ihdr->color_type == 3)
-         copy_line_plt(data, decoded_scanline, ihdr->width,
-               ihdr->depth, palette);
-      else if (ihdr->color_type == 4)
-         copy_line_gray_alpha(data, decoded_scanline, ihdr->width,
-               ihdr->depth);
-      else if (ihdr->color_type == 6)
-         copy_line_rgba(data, decoded_scanline, ihdr->width, ihdr->depth);
-
-      memcpy(prev_scanline, decoded_scanline, pitch);
+      png_copy_line(data, ihdr, inflate_buf + 1, palette);
+      prev_scanline = inflate_buf + 1;
    }
 
 end:
-   free(decoded_scanline);
-   free(prev_scanline);
+   free(zero_scanline);
    return ret;
 }
 
@@ -512,7 +816,7 @@ static void deinterlace_pass(uint32_t *data, const struct png_ihdr *ihdr,
 
 static bool png_reverse_filter_adam7(uint32_t *data,
       const struct png_ihdr *ihdr,
-      const uint8_t *inflate_buf, size_t inflate_buf_size,
+      uint8_t *inflate_buf, size_t inflate_buf_size,
       const uint32_t *palette)
 {
    unsigned pass;
@@ -532,9 +836,9 @@ static bool png_reverse_filter_adam7(uint32_t *data,
             ihdr->height <= passes[pass].y) /* Empty pass */
          continue;
 
-      unsigned pass_width  = (ihdr->width - 
+      unsigned pass_width  = (ihdr->width -
             passes[pass].x + passes[pass].stride_x - 1) / passes[pass].stride_x;
-      unsigned pass_height = (ihdr->height - passes[pass].y + 
+      unsigned pass_height = (ihdr->height - passes[pass].y +
             passes[pass].stride_y - 1) / passes[pass].stride_y;
 
       uint32_t *tmp_data = (uint32_t*)
@@ -575,96 +879,216 @@ static bool png_reverse_filter_adam7(uint32_t *data,
    return true;
 }
 
-static bool png_append_idat(FILE *file,
-      const struct png_chunk *chunk, struct idat_buffer *buf)
+/* Inflate state shared across IDAT chunks. Progressive images are
+ * inflated one scanline at a time and each scanline is unfiltered and
+ * converted as soon as it is complete, so the full inflated image is
+ * never held in memory. Adam7 images still need every pass before
+ * they can be deinterlaced, so they are inflated into one buffer. */
+struct png_decoder
 {
-   uint8_t *new_buffer = (uint8_t*)realloc(buf->data, buf->size + chunk->size);
-   if (!new_buffer)
-      return false;
+   struct png_ihdr ihdr;
+   const uint32_t *palette;
+   z_stream stream;
+   bool stream_init;
+   bool stream_end;
+
+   unsigned bpp;
+   unsigned pitch;
 
-   buf->data  = new_buffer;
-   if (fread(buf->data + buf->size, 1, chunk->size, file) != chunk->size)
+   /* Progressive. Filter type byte followed by pitch bytes. */
+   uint8_t *line;
+   uint8_t *prev_line;
+   size_t line_fill;
+   unsigned rows;
+   uint32_t *out;
+
+   /* Adam7. */
+   uint8_t *inflate_buf;
+   size_t inflate_buf_size;
+};
+
+static bool png_decoder_init(struct png_decoder *dec,
+      const struct png_ihdr *ihdr, const uint32_t *palette, uint32_t *out)
+{
+   dec->ihdr    = *ihdr;
+   dec->palette = palette;
+   dec->out     = out;
+
+   if (inflateInit(&dec->stream) != Z_OK)
       return false;
-   if (fseek(file, sizeof(uint32_t), SEEK_CUR) < 0)
+   dec->stream_init = true;
+
+   png_pass_geom(ihdr, ihdr->width, ihdr->height,
+         &dec->bpp, &dec->pitch, &dec->inflate_buf_size);
+
+   if (ihdr->interlace == 1)
+   {
+      dec->inflate_buf_size *= 2; /* To be sure. */
+      dec->inflate_buf = (uint8_t*)malloc(dec->inflate_buf_size);
+      return dec->inflate_buf;
+   }
+
+   dec->line      = (uint8_t*)calloc(1, dec->pitch + 1);
+   dec->prev_line = (uint8_t*)calloc(1, dec->pitch + 1);
+   return dec->line && dec->prev_line;
+}
+
+static void png_decoder_free(struct png_decoder *dec)
+{
+   if (dec->stream_init)
+      inflateEnd(&dec->stream);
+   free(dec->line);
+   free(dec->prev_line);
+   free(dec->inflate_buf);
+}
+
+static bool png_decoder_process_line(struct png_decoder *dec)
+{
+   uint8_t *tmp;
+
+   if (!png_unfilter_line(dec->line + 1, dec->prev_line + 1,
+            dec->line[0], dec->pitch, dec->bpp))
       return false;
-   buf->size += chunk->size;
+
+   png_copy_line(dec->out, &dec->ihdr, dec->line + 1, dec->palette);
+   dec->out += dec->ihdr.width;
+   dec->rows++;
+
+   tmp            = dec->prev_line;
+   dec->prev_line = dec->line;
+   dec->line      = tmp;
+   dec->line_fill = 0;
    return true;
 }
 
-static bool png_read_plte(FILE *file, uint32_t *buffer, unsigned entries)
+/* Inflates as much of the pending input as there is room for. */
+static bool png_decoder_inflate(struct png_decoder *dec)
 {
-   unsigned i;
-   if (entries > 256)
+   while (!dec->stream_end)
+   {
+      int err;
+
+      if (dec->inflate_buf)
+      {
+         dec->stream.next_out  = dec->inflate_buf + dec->stream.total_out;
+         dec->stream.avail_out = dec->inflate_buf_size - dec->stream.total_out;
+      }
+      else
+      {
+         if (dec->rows >= dec->ihdr.height)
+            return true;
+         dec->stream.next_out  = dec->line + dec->line_fill;
+         dec->stream.avail_out = dec->pitch + 1 - dec->line_fill;
+      }
+
+      if (!dec->stream.avail_out)
+         return false;
+
+      err = inflate(&dec->stream, Z_NO_FLUSH);
+      if (err == Z_STREAM_END)
+         dec->stream_end = true;
+      else if (err == Z_BUF_ERROR)
+         return true; /* Needs more input. */
+      else if (err != Z_OK)
+         return false;
+
+      if (!dec->inflate_buf)
+      {
+         dec->line_fill = dec->pitch + 1 - dec->stream.avail_out;
+         if (dec->line_fill == dec->pitch + 1 &&
+               !png_decoder_process_line(dec))
+            return false;
+      }
+
+      /* Stopped for lack of input rather than lack of room. */
+      if (!dec->stream.avail_in && dec->stream.avail_out)
+         return true;
+   }
+
+   return true;
+}
+
+static bool png_decoder_feed(struct png_decoder *dec,
+      const uint8_t *data, size_t size)
+{
+   dec->stream.next_in  = (Bytef*)data;
+   dec->stream.avail_in = size;
+   return png_decoder_inflate(dec);
+}
+
+static bool png_decoder_finish(struct png_decoder *dec)
+{
+   if (!png_decoder_inflate(dec))
       return false;
 
-   uint8_t buf[256 * 3];
-   if (fread(buf, 3, entries, file) != entries)
+   if (dec->inflate_buf)
+   {
+      return png_reverse_filter_adam7(dec->out, &dec->ihdr,
+            dec->inflate_buf, dec->stream.total_out, dec->palette);
+   }
+
+   return dec->rows == dec->ihdr.height;
+}
+
+static bool png_read_plte(const uint8_t *data,
+      uint32_t *buffer, unsigned entries)
+{
+   unsigned i;
+   if (entries > 256)
       return false;
 
    for (i = 0; i < entries; i++)
    {
-      uint32_t r = buf[3 * i + 0];
-      uint32_t g = buf[3 * i + 1];
-      uint32_t b = buf[3 * i + 2];
+      uint32_t r = data[3 * i + 0];
+      uint32_t g = data[3 * i + 1];
+      uint32_t b = data[3 * i + 2];
       buffer[i] = (r << 16) | (g << 8) | (b << 0) | (0xffu << 24);
    }
 
-   if (fseek(file, sizeof(uint32_t), SEEK_CUR) < 0)
-      return false;
-
    return true;
 }
 
 bool rpng_load_image_argb(const char *path, uint32_t **data,
       unsigned *width, unsigned *height)
 {
-   long pos;
+   const uint8_t *buf, *buf_end;
    *data   = NULL;
    *width  = 0;
    *height = 0;
 
    bool ret = true;
-   FILE *file = fopen(path, "rb");
-   if (!file)
+   file_map_t file;
+   if (!file_map_open(&file, path, true))
       return false;
 
-   fseek(file, 0, SEEK_END);
-   long file_len = ftell(file);
-   rewind(file);
-
    bool has_ihdr = false;
    bool has_idat = false;
    bool has_iend = false;
    bool has_plte = false;
-   uint8_t *inflate_buf = NULL;
-   size_t inflate_buf_size = 0;
-   z_stream stream = {0};
 
-   struct idat_buffer idat_buf = {0};
+   struct png_decoder dec = {{0}};
    struct png_ihdr ihdr = {0};
    uint32_t palette[256] = {0};
 
-   char header[8];
-   if (fread(header, 1, sizeof(header), file) != sizeof(header))
+   if (file.size < sizeof(png_magic))
       GOTO_END_ERROR();
 
-   if (memcmp(header, png_magic, sizeof(png_magic)) != 0)
+   if (memcmp(file.data, png_magic, sizeof(png_magic)) != 0)
       GOTO_END_ERROR();
 
-   /* feof() apparently isn't triggered after a seek (IEND). */
-   for (pos = ftell(file); 
-         pos < file_len && pos >= 0; pos = ftell(file))
+   buf     = file.data + sizeof(png_magic);
+   buf_end = file.data + file.size;
+
+   while (buf < buf_end && !has_iend)
    {
       struct png_chunk chunk = {0};
-      if (!read_chunk_header(file, &chunk))
+      if (!png_read_chunk(&buf, buf_end, &chunk))
          GOTO_END_ERROR();
 
       switch (png_chunk_type(&chunk))
       {
          case PNG_CHUNK_NOOP:
          default:
-            if (fseek(file, chunk.size + sizeof(uint32_t), SEEK_CUR) < 0)
-               GOTO_END_ERROR();
             break;
 
          case PNG_CHUNK_ERROR:
@@ -674,7 +1098,7 @@ bool rpng_load_image_argb(const char *path, uint32_t **data,
             if (has_ihdr || has_idat || has_iend)
                GOTO_END_ERROR();
 
-            if (!png_parse_ihdr(file, &chunk, &ihdr))
+            if (!png_parse_ihdr(&chunk, &ihdr))
                GOTO_END_ERROR();
 
             has_ihdr = true;
@@ -687,7 +1111,7 @@ bool rpng_load_image_argb(const char *path, uint32_t **data,
             if (chunk.size % 3)
                GOTO_END_ERROR();
 
-            if (!png_read_plte(file, palette, chunk.size / 3))
+            if (!png_read_plte(chunk.data, palette, chunk.size / 3))
                GOTO_END_ERROR();
 
             has_plte = true;
@@ -697,7 +1121,22 @@ bool rpng_load_image_argb(const char *path, uint32_t **data,
             if (!has_ihdr || has_iend || (ihdr.color_type == 3 && !has_plte))
                GOTO_END_ERROR();
 
-            if (!png_append_idat(file, &chunk, &idat_buf))
+            if (!has_idat)
+            {
+#ifdef GEKKO
+               /* we often use these in textures, make sure they're 32-byte aligned */
+               *data = (uint32_t*)memalign(32, ihdr.width * ihdr.height * sizeof(uint32_t));
+#else
+               *data = (uint32_t*)malloc(ihdr.width * ihdr.height * sizeof(uint32_t));
+#endif
+               if (!*data)
+                  GOTO_END_ERROR();
+
+               if (!png_decoder_init(&dec, &ihdr, palette, *data))
+                  GOTO_END_ERROR();
+            }
+
+            if (!png_decoder_feed(&dec, chunk.data, chunk.size))
                GOTO_END_ERROR();
 
             has_idat = true;
@@ -707,9 +1146,6 @@ bool rpng_load_image_argb(const char *path, uint32_t **data,
             if (!has_ihdr || !has_idat)
                GOTO_END_ERROR();
 
-            if (fseek(file, sizeof(uint32_t), SEEK_CUR) < 0)
-               GOTO_END_ERROR();
-
             has_iend = true;
             break;
       }
@@ -718,57 +1154,20 @@ bool rpng_load_image_argb(const char *path, uint32_t **data,
    if (!has_ihdr || !has_idat || !has_iend)
       GOTO_END_ERROR();
 
-   if (inflateInit(&stream) != Z_OK)
-      GOTO_END_ERROR();
-
-   png_pass_geom(&ihdr, ihdr.width, ihdr.height, NULL, NULL, &inflate_buf_size);
-   if (ihdr.interlace == 1) /* To be sure. */
-      inflate_buf_size *= 2;
-
-   inflate_buf = (uint8_t*)malloc(inflate_buf_size);
-   if (!inflate_buf)
-      GOTO_END_ERROR();
-
-   stream.next_in   = idat_buf.data;
-   stream.avail_in  = idat_buf.size;
-   stream.avail_out = inflate_buf_size;
-   stream.next_out  = inflate_buf;
-
-   if (inflate(&stream, Z_FINISH) != Z_STREAM_END)
-   {
-      inflateEnd(&stream);
+   if (!png_decoder_finish(&dec))
       GOTO_END_ERROR();
-   }
-   inflateEnd(&stream);
 
    *width  = ihdr.width;
    *height = ihdr.height;
-#ifdef GEKKO
-   /* we often use these in textures, make sure they're 32-byte aligned */
-   *data = (uint32_t*)memalign(32, ihdr.width * ihdr.height * sizeof(uint32_t));
-#else
-   *data = (uint32_t*)malloc(ihdr.width * ihdr.height * sizeof(uint32_t));
-#endif
-   if (!*data)
-      GOTO_END_ERROR();
-
-   if (ihdr.interlace == 1)
-   {
-      if (!png_reverse_filter_adam7(*data,
-               &ihdr, inflate_buf, stream.total_out, palette))
-         GOTO_END_ERROR();
-   }
-   else if (!png_reverse_filter(*data,
-            &ihdr, inflate_buf, stream.total_out, palette))
-      GOTO_END_ERROR();
 
 end:
-   if (file)
-      fclose(file);
+   png_decoder_free(&dec);
+   file_map_close(&file);
    if (!ret)
+   {
       free(*data);
-   free(idat_buf.data);
-   free(inflate_buf);
+      *data = NULL;
+   }
    return ret;
 }
 
@@ -31,6 +31,15 @@ extern "C" {
 bool rpng_load_image_argb(const char *path, uint32_t **data,
       unsigned *width, unsigned *height);
 
+#ifdef RPNG_TEST
+/* Forces the scalar unfilter path so it can be benchmarked. */
+extern bool rpng_test_disable_simd;
+
+/* The previous decoder, see rpng_reference.c. */
+bool rpng_reference_load_image_argb(const char *path, uint32_t **data,
+      unsigned *width, unsigned *height);
+#endif
+
 #ifdef HAVE_ZLIB_DEFLATE
 bool rpng_save_image_argb(const char *path, const uint32_t *data,
       unsigned width, unsigned height, unsigned pitch);
@@ -1,6 +1,6 @@
 /*  RetroArch - A frontend for libretro.
  *  Copyright (C) 2010-2014 - Hans-Kristian Arntzen
- * 
+ *
  *  RetroArch is free software: you can redistribute it and/or modify it under the terms
  *  of the GNU General Public License as published by the Free Software Found-
  *  ation, either version 3 of the License, or (at your option) any later version.
@@ -18,17 +18,55 @@
 #include <stdlib.h>
 #include <stdint.h>
 #include <string.h>
+#include <time.h>
 #include <Imlib2.h>
 
+static double get_time(void)
+{
+   struct timespec tv;
+   clock_gettime(CLOCK_MONOTONIC, &tv);
+   return tv.tv_sec + tv.tv_nsec / 1000000000.0;
+}
+
+typedef bool (*load_image_t)(const char *path, uint32_t **data,
+      unsigned *width, unsigned *height);
+
+/* Decodes the image repeatedly and returns decoded MB/s (ARGB output). */
+static double benchmark(const char *path, unsigned iterations,
+      load_image_t load, bool simd)
+{
+   unsigned i;
+   double start, elapsed;
+   size_t bytes = 0;
+
+   rpng_test_disable_simd = !simd;
+
+   start = get_time();
+   for (i = 0; i < iterations; i++)
+   {
+      uint32_t *data = NULL;
+      unsigned width = 0, height = 0;
+      if (!load(path, &data, &width, &height))
+         return 0.0;
+      bytes += width * height * sizeof(uint32_t);
+      free(data);
+   }
+   elapsed = get_time() - start;
+
+   rpng_test_disable_simd = false;
+   return elapsed > 0.0 ? bytes / (elapsed * 1000000.0) : 0.0;
+}
+
 int main(int argc, char *argv[])
 {
-   if (argc > 2)
+   if (argc > 3)
    {
-      fprintf(stderr, "Usage: %s <png file>\n", argv[0]);
+      fprintf(stderr, "Usage: %s <png file> [iterations]\n", argv[0]);
       return 1;
    }
 
-   const char *in_path = argc == 2 ? argv[1] : "/tmp/test.png";
+   const char *in_path = argc >= 2 ? argv[1] : "/tmp/test.png";
+   unsigned iterations = argc == 3 ? strtoul(argv[2], NULL, 0) : 100;
 
    const uint32_t test_data[] = {
       0xff000000 | 0x50, 0xff000000 | 0x80,
@@ -45,6 +83,7 @@ int main(int argc, char *argv[])
       return 1;
 
    uint32_t *data = NULL;
+   uint32_t *scalar_data = NULL;
    unsigned width = 0;
    unsigned height = 0;
 
@@ -64,6 +103,30 @@ int main(int argc, char *argv[])
    }
 #endif
 
+   /* The SIMD unfilters must match the scalar reference bit for bit. */
+   rpng_test_disable_simd = true;
+   if (!rpng_load_image_argb(in_path, &scalar_data, &width, &height))
+      return 2;
+   rpng_test_disable_simd = false;
+
+   if (memcmp(scalar_data, data, width * height * sizeof(uint32_t)) != 0)
+   {
+      fprintf(stderr, "SIMD and scalar RPNG differs!\n");
+      return 3;
+   }
+   free(scalar_data);
+
+   /* And the decoder it replaces. */
+   if (!rpng_reference_load_image_argb(in_path, &scalar_data, &width, &height))
+      return 2;
+
+   if (memcmp(scalar_data, data, width * height * sizeof(uint32_t)) != 0)
+   {
+      fprintf(stderr, "Previous and new RPNG differs!\n");
+      return 3;
+   }
+   free(scalar_data);
+
    // Validate with imlib2 as well.
    Imlib_Image img = imlib_load_image(in_path);
    if (!img)
@@ -94,5 +157,22 @@ int main(int argc, char *argv[])
 
    imlib_free_image();
    free(data);
-}
 
+   if (iterations)
+   {
+      double old_mbps    = benchmark(in_path, iterations,
+            rpng_reference_load_image_argb, false);
+      double scalar_mbps = benchmark(in_path, iterations,
+            rpng_load_image_argb, false);
+      double simd_mbps   = benchmark(in_path, iterations,
+            rpng_load_image_argb, true);
+
+      fprintf(stderr, "Decode (previous): %.2f MB/s.\n", old_mbps);
+      fprintf(stderr, "Decode (scalar):   %.2f MB/s (%.2fx).\n", scalar_mbps,
+            old_mbps > 0.0 ? scalar_mbps / old_mbps : 0.0);
+      fprintf(stderr, "Decode (SIMD):     %.2f MB/s (%.2fx).\n", simd_mbps,
+            old_mbps > 0.0 ? simd_mbps / old_mbps : 0.0);
+   }
+
+   return 0;
+}
@@ -14,547 +14,1698 @@
  */
 
 #include "pixconv.h"
+#include "../../libretro.h"
+#include "../../boolean.h"
+#ifdef RARCH_INTERNAL
+#include "../../performance.h"
+#else
+/* Standalone users of the scaler provide their own CPU detection. */
+uint64_t rarch_get_cpu_features(void);
+#endif
 #include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
 #include <stdio.h>
 
-#ifdef SCALER_NO_SIMD
-#undef __SSE2__
-#endif
+/* Every converter has a C reference version, and SIMD versions which are
+ * all built regardless of compiler flags. The fastest one the CPU supports
+ * is picked at runtime, so one binary gets the fast paths everywhere. */
+
+#if !defined(SCALER_NO_SIMD) && (defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86))
+#define PIXCONV_X86
+#include <emmintrin.h>
+#include <tmmintrin.h>
+#include <immintrin.h>
+#if defined(__GNUC__)
+#define TARGET_SSE2  __attribute__((target("sse2")))
+#define TARGET_SSSE3 __attribute__((target("ssse3")))
+#define TARGET_AVX2  __attribute__((target("avx2")))
+#else
+#define TARGET_SSE2
+#define TARGET_SSSE3
+#define TARGET_AVX2
+#endif
+#endif
+
+#if !defined(SCALER_NO_SIMD) && (defined(__ARM_NEON__) || defined(__aarch64__))
+#define PIXCONV_NEON
+#include <arm_neon.h>
+#endif
+
+typedef void (*conv_func_t)(void *output, const void *input,
+      int width, int height, int out_stride, int in_stride);
+
+static inline uint16_t px_rgb565_0rgb1555(uint16_t col)
+{
+   return ((col >> 1) & 0x7fe0) | (col & 0x1f);
+}
+
+static inline uint16_t px_0rgb1555_rgb565(uint16_t col)
+{
+   uint16_t rg   = (col << 1) & ((0x1f << 11) | (0x1f << 6));
+   uint16_t b    = col & 0x1f;
+   uint16_t glow = (col >> 4) & (1 << 5);
+   return rg | b | glow;
+}
+
+static inline uint32_t px_0rgb1555_argb8888(uint32_t col)
+{
+   uint32_t r = (col >> 10) & 0x1f;
+   uint32_t g = (col >>  5) & 0x1f;
+   uint32_t b = (col >>  0) & 0x1f;
+   r = (r << 3) | (r >> 2);
+   g = (g << 3) | (g >> 2);
+   b = (b << 3) | (b >> 2);
+
+   return (0xffu << 24) | (r << 16) | (g << 8) | (b << 0);
+}
+
+static inline uint32_t px_rgb565_argb8888(uint32_t col)
+{
+   uint32_t r = (col >> 11) & 0x1f;
+   uint32_t g = (col >>  5) & 0x3f;
+   uint32_t b = (col >>  0) & 0x1f;
+   r = (r << 3) | (r >> 2);
+   g = (g << 2) | (g >> 4);
+   b = (b << 3) | (b >> 2);
+
+   return (0xffu << 24) | (r << 16) | (g << 8) | (b << 0);
+}
+
+static inline uint32_t px_rgba4444_argb8888(uint32_t col)
+{
+   uint32_t r = (col >> 12) & 0xf;
+   uint32_t g = (col >>  8) & 0xf;
+   uint32_t b = (col >>  4) & 0xf;
+   uint32_t a = (col >>  0) & 0xf;
+   r = (r << 4) | r;
+   g = (g << 4) | g;
+   b = (b << 4) | b;
+   a = (a << 4) | a;
+
+   return (a << 24) | (r << 16) | (g << 8) | (b << 0);
+}
+
+static inline uint16_t px_argb8888_0rgb1555(uint32_t col)
+{
+   uint16_t r = (col >> 19) & 0x1f;
+   uint16_t g = (col >> 11) & 0x1f;
+   uint16_t b = (col >>  3) & 0x1f;
+   return (r << 10) | (g << 5) | (b << 0);
+}
+
+static inline uint16_t px_argb8888_rgb565(uint32_t col)
+{
+   uint16_t r = (col >> 19) & 0x1f;
+   uint16_t g = (col >> 10) & 0x3f;
+   uint16_t b = (col >>  3) & 0x1f;
+   return (r << 11) | (g << 5) | (b << 0);
+}
+
+static inline uint32_t px_argb8888_abgr8888(uint32_t col)
+{
+   return ((col << 16) & 0xff0000) |
+      ((col >> 16) & 0xff) | (col & 0xff00ff00);
+}
+
+static inline void px_store_bgr24(uint8_t *out, uint32_t col)
+{
+   out[0] = (uint8_t)(col >>  0);
+   out[1] = (uint8_t)(col >>  8);
+   out[2] = (uint8_t)(col >> 16);
+}
+
+#define YUV_SHIFT 6
+#define YUV_OFFSET (1 << (YUV_SHIFT - 1))
+#define YUV_MAT_Y (1 << 6)
+#define YUV_MAT_U_G (-22)
+#define YUV_MAT_U_B (113)
+#define YUV_MAT_V_R (90)
+#define YUV_MAT_V_G (-46)
+
+/* Converts one YUYV macropixel (two pixels). */
+static inline void px_yuyv_argb8888(uint32_t *dst, const uint8_t *src)
+{
+   int y0 = src[0];
+   int  u = src[1] - 128;
+   int y1 = src[2];
+   int  v = src[3] - 128;
+
+   uint8_t r0 = clamp_8bit((YUV_MAT_Y * y0 +                   YUV_MAT_V_R * v + YUV_OFFSET) >> YUV_SHIFT);
+   uint8_t g0 = clamp_8bit((YUV_MAT_Y * y0 + YUV_MAT_U_G * u + YUV_MAT_V_G * v + YUV_OFFSET) >> YUV_SHIFT);
+   uint8_t b0 = clamp_8bit((YUV_MAT_Y * y0 + YUV_MAT_U_B * u                   + YUV_OFFSET) >> YUV_SHIFT);
+
+   uint8_t r1 = clamp_8bit((YUV_MAT_Y * y1 +                   YUV_MAT_V_R * v + YUV_OFFSET) >> YUV_SHIFT);
+   uint8_t g1 = clamp_8bit((YUV_MAT_Y * y1 + YUV_MAT_U_G * u + YUV_MAT_V_G * v + YUV_OFFSET) >> YUV_SHIFT);
+   uint8_t b1 = clamp_8bit((YUV_MAT_Y * y1 + YUV_MAT_U_B * u                   + YUV_OFFSET) >> YUV_SHIFT);
+
+   dst[0] = 0xff000000u | (r0 << 16) | (g0 << 8) | (b0 << 0);
+   dst[1] = 0xff000000u | (r1 << 16) | (g1 << 8) | (b1 << 0);
+}
+
+/* C reference versions. */
+
+static void conv_rgb565_0rgb1555_c(void *output_, const void *input_,
+      int width, int height,
+      int out_stride, int in_stride)
+{
+   int h, w;
+   const uint16_t *input = (const uint16_t*)input_;
+   uint16_t *output = (uint16_t*)output_;
+
+   for (h = 0; h < height;
+         h++, output += out_stride >> 1, input += in_stride >> 1)
+      for (w = 0; w < width; w++)
+         output[w] = px_rgb565_0rgb1555(input[w]);
+}
+
+static void conv_0rgb1555_rgb565_c(void *output_, const void *input_,
+      int width, int height,
+      int out_stride, int in_stride)
+{
+   int h, w;
+   const uint16_t *input = (const uint16_t*)input_;
+   uint16_t *output = (uint16_t*)output_;
+
+   for (h = 0; h < height;
+         h++, output += out_stride >> 1, input += in_stride >> 1)
+      for (w = 0; w < width; w++)
+         output[w] = px_0rgb1555_rgb565(input[w]);
+}
+
+static void conv_0rgb1555_argb8888_c(void *output_, const void *input_,
+      int width, int height,
+      int out_stride, int in_stride)
+{
+   int h, w;
+   const uint16_t *input = (const uint16_t*)input_;
+   uint32_t *output      = (uint32_t*)output_;
+
+   for (h = 0; h < height;
+         h++, output += out_stride >> 2, input += in_stride >> 1)
+      for (w = 0; w < width; w++)
+         output[w] = px_0rgb1555_argb8888(input[w]);
+}
+
+static void conv_rgb565_argb8888_c(void *output_, const void *input_,
+      int width, int height,
+      int out_stride, int in_stride)
+{
+   int h, w;
+   const uint16_t *input = (const uint16_t*)input_;
+   uint32_t *output      = (uint32_t*)output_;
+
+   for (h = 0; h < height;
+         h++, output += out_stride >> 2, input += in_stride >> 1)
+      for (w = 0; w < width; w++)
+         output[w] = px_rgb565_argb8888(input[w]);
+}
+
+static void conv_rgba4444_argb8888_c(void *output_, const void *input_,
+      int width, int height,
+      int out_stride, int in_stride)
+{
+   int h, w;
+   const uint16_t *input = (const uint16_t*)input_;
+   uint32_t *output      = (uint32_t*)output_;
+
+   for (h = 0; h < height;
+         h++, output += out_stride >> 2, input += in_stride >> 1)
+      for (w = 0; w < width; w++)
+         output[w] = px_rgba4444_argb8888(input[w]);
+}
+
+static void conv_0rgb1555_bgr24_c(void *output_, const void *input_,
+      int width, int height,
+      int out_stride, int in_stride)
+{
+   int h, w;
+   const uint16_t *input = (const uint16_t*)input_;
+   uint8_t *output       = (uint8_t*)output_;
+
+   for (h = 0; h < height;
+         h++, output += out_stride, input += in_stride >> 1)
+      for (w = 0; w < width; w++)
+         px_store_bgr24(output + 3 * w, px_0rgb1555_argb8888(input[w]));
+}
+
+static void conv_rgb565_bgr24_c(void *output_, const void *input_,
+      int width, int height,
+      int out_stride, int in_stride)
+{
+   int h, w;
+   const uint16_t *input = (const uint16_t*)input_;
+   uint8_t *output       = (uint8_t*)output_;
+
+   for (h = 0; h < height;
+         h++, output += out_stride, input += in_stride >> 1)
+      for (w = 0; w < width; w++)
+         px_store_bgr24(output + 3 * w, px_rgb565_argb8888(input[w]));
+}
+
+static void conv_bgr24_argb8888_c(void *output_, const void *input_,
+      int width, int height,
+      int out_stride, int in_stride)
+{
+   int h, w;
+   const uint8_t *input = (const uint8_t*)input_;
+   uint32_t *output     = (uint32_t*)output_;
+
+   for (h = 0; h < height;
+         h++, output += out_stride >> 2, input += in_stride)
+   {
+      const uint8_t *inp = input;
+      for (w = 0; w < width; w++)
+      {
+         uint32_t b = *inp++;
+         uint32_t g = *inp++;
+         uint32_t r = *inp++;
+         output[w] = (0xffu << 24) | (r << 16) | (g << 8) | (b << 0);
+      }
+   }
+}
+
+static void conv_argb8888_0rgb1555_c(void *output_, const void *input_,
+      int width, int height,
+      int out_stride, int in_stride)
+{
+   int h, w;
+   const uint32_t *input = (const uint32_t*)input_;
+   uint16_t *output      = (uint16_t*)output_;
+
+   for (h = 0; h < height;
+         h++, output += out_stride >> 1, input += in_stride >> 2)
+      for (w = 0; w < width; w++)
+         output[w] = px_argb8888_0rgb1555(input[w]);
+}
+
+static void conv_argb8888_rgb565_c(void *output_, const void *input_,
+      int width, int height,
+      int out_stride, int in_stride)
+{
+   int h, w;
+   const uint32_t *input = (const uint32_t*)input_;
+   uint16_t *output      = (uint16_t*)output_;
+
+   for (h = 0; h < height;
+         h++, output += out_stride >> 1, input += in_stride >> 2)
+      for (w = 0; w < width; w++)
+         output[w] = px_argb8888_rgb565(input[w]);
+}
+
+static void conv_argb8888_bgr24_c(void *output_, const void *input_,
+      int width, int height,
+      int out_stride, int in_stride)
+{
+   int h, w;
+   const uint32_t *input = (const uint32_t*)input_;
+   uint8_t *output       = (uint8_t*)output_;
+
+   for (h = 0; h < height;
+         h++, output += out_stride, input += in_stride >> 2)
+      for (w = 0; w < width; w++)
+         px_store_bgr24(output + 3 * w, input[w]);
+}
+
+static void conv_argb8888_abgr8888_c(void *output_, const void *input_,
+      int width, int height,
+      int out_stride, int in_stride)
+{
+   int h, w;
+   const uint32_t *input = (const uint32_t*)input_;
+   uint32_t *output      = (uint32_t*)output_;
+
+   for (h = 0; h < height;
+         h++, output += out_stride >> 2, input += in_stride >> 2)
+      for (w = 0; w < width; w++)
+         output[w] = px_argb8888_abgr8888(input[w]);
+}
+
+static void conv_yuyv_argb8888_c(void *output_, const void *input_,
+      int width, int height,
+      int out_stride, int in_stride)
+{
+   int h, w;
+   const uint8_t *input = (const uint8_t*)input_;
+   uint32_t *output     = (uint32_t*)output_;
+
+   for (h = 0; h < height;
+         h++, output += out_stride >> 2, input += in_stride)
+      for (w = 0; w < width; w += 2)
+         px_yuyv_argb8888(output + w, input + 2 * w);
+}
+
+#ifdef PIXCONV_X86
+/* SSE2 versions. */
+
+/* Interleaves 8 pixels worth of 8-bit R, G and B
+ * (one per 16-bit lane) into opaque ARGB8888. */
+static inline TARGET_SSE2 void pack_argb_sse2(__m128i r, __m128i g,
+      __m128i b, __m128i *lo, __m128i *hi)
+{
+   const __m128i a = _mm_set1_epi16(0x00ff);
+
+   __m128i res_lo_bg = _mm_unpacklo_epi8(b, g);
+   __m128i res_hi_bg = _mm_unpackhi_epi8(b, g);
+   __m128i res_lo_ra = _mm_unpacklo_epi8(r, a);
+   __m128i res_hi_ra = _mm_unpackhi_epi8(r, a);
+
+   *lo = _mm_or_si128(res_lo_bg, _mm_slli_si128(res_lo_ra, 2));
+   *hi = _mm_or_si128(res_hi_bg, _mm_slli_si128(res_hi_ra, 2));
+}
+
+static inline TARGET_SSE2 void expand_0rgb1555_sse2(__m128i in,
+      __m128i *lo, __m128i *hi)
+{
+   const __m128i pix_mask_r  = _mm_set1_epi16(0x1f << 10);
+   const __m128i pix_mask_gb = _mm_set1_epi16(0x1f <<  5);
+   const __m128i mul15_mid   = _mm_set1_epi16(0x4200);
+   const __m128i mul15_hi    = _mm_set1_epi16(0x0210);
+
+   __m128i r = _mm_and_si128(in, pix_mask_r);
+   __m128i g = _mm_and_si128(in, pix_mask_gb);
+   __m128i b = _mm_and_si128(_mm_slli_epi16(in, 5), pix_mask_gb);
+
+   r = _mm_mulhi_epi16(r, mul15_hi);
+   g = _mm_mulhi_epi16(g, mul15_mid);
+   b = _mm_mulhi_epi16(b, mul15_mid);
+
+   pack_argb_sse2(r, g, b, lo, hi);
+}
+
+static inline TARGET_SSE2 void expand_rgb565_sse2(__m128i in,
+      __m128i *lo, __m128i *hi)
+{
+   const __m128i pix_mask_r = _mm_set1_epi16(0x1f << 10);
+   const __m128i pix_mask_g = _mm_set1_epi16(0x3f <<  5);
+   const __m128i pix_mask_b = _mm_set1_epi16(0x1f <<  5);
+   const __m128i mul16_r    = _mm_set1_epi16(0x0210);
+   const __m128i mul16_g    = _mm_set1_epi16(0x2080);
+   const __m128i mul16_b    = _mm_set1_epi16(0x4200);
+
+   __m128i r = _mm_and_si128(_mm_srli_epi16(in, 1), pix_mask_r);
+   __m128i g = _mm_and_si128(in, pix_mask_g);
+   __m128i b = _mm_and_si128(_mm_slli_epi16(in, 5), pix_mask_b);
+
+   r = _mm_mulhi_epi16(r, mul16_r);
+   g = _mm_mulhi_epi16(g, mul16_g);
+   b = _mm_mulhi_epi16(b, mul16_b);
+
+   pack_argb_sse2(r, g, b, lo, hi);
+}
+
+/* :( TODO: Make this saner. */
+static inline TARGET_SSE2 void store_bgr24_sse2(void *output, __m128i a,
+      __m128i b, __m128i c, __m128i d)
+{
+   const __m128i mask_0 = _mm_set_epi32(0, 0, 0, 0x00ffffff);
+   const __m128i mask_1 = _mm_set_epi32(0, 0, 0x00ffffff, 0);
+   const __m128i mask_2 = _mm_set_epi32(0, 0x00ffffff, 0, 0);
+   const __m128i mask_3 = _mm_set_epi32(0x00ffffff, 0, 0, 0);
+
+   __m128i a0 = _mm_and_si128(a, mask_0);
+   __m128i a1 = _mm_srli_si128(_mm_and_si128(a, mask_1),  1);
+   __m128i a2 = _mm_srli_si128(_mm_and_si128(a, mask_2),  2);
+   __m128i a3 = _mm_srli_si128(_mm_and_si128(a, mask_3),  3);
+   __m128i a4 = _mm_slli_si128(_mm_and_si128(b, mask_0), 12);
+   __m128i a5 = _mm_slli_si128(_mm_and_si128(b, mask_1), 11);
+
+   __m128i b0 = _mm_srli_si128(_mm_and_si128(b, mask_1), 5);
+   __m128i b1 = _mm_srli_si128(_mm_and_si128(b, mask_2), 6);
+   __m128i b2 = _mm_srli_si128(_mm_and_si128(b, mask_3), 7);
+   __m128i b3 = _mm_slli_si128(_mm_and_si128(c, mask_0), 8);
+   __m128i b4 = _mm_slli_si128(_mm_and_si128(c, mask_1), 7);
+   __m128i b5 = _mm_slli_si128(_mm_and_si128(c, mask_2), 6);
+
+   __m128i c0 = _mm_srli_si128(_mm_and_si128(c, mask_2), 10);
+   __m128i c1 = _mm_srli_si128(_mm_and_si128(c, mask_3), 11);
+   __m128i c2 = _mm_slli_si128(_mm_and_si128(d, mask_0),  4);
+   __m128i c3 = _mm_slli_si128(_mm_and_si128(d, mask_1),  3);
+   __m128i c4 = _mm_slli_si128(_mm_and_si128(d, mask_2),  2);
+   __m128i c5 = _mm_slli_si128(_mm_and_si128(d, mask_3),  1);
+
+   __m128i *out = (__m128i*)output;
+
+   _mm_storeu_si128(out + 0,
+         _mm_or_si128(a0, _mm_or_si128(a1, _mm_or_si128(a2,
+                  _mm_or_si128(a3, _mm_or_si128(a4, a5))))));
+
+   _mm_storeu_si128(out + 1,
+         _mm_or_si128(b0, _mm_or_si128(b1, _mm_or_si128(b2,
+                  _mm_or_si128(b3, _mm_or_si128(b4, b5))))));
+
+   _mm_storeu_si128(out + 2,
+         _mm_or_si128(c0, _mm_or_si128(c1, _mm_or_si128(c2,
+                  _mm_or_si128(c3, _mm_or_si128(c4, c5))))));
+}
+
+static TARGET_SSE2 void conv_rgb565_0rgb1555_sse2(void *output_,
+      const void *input_, int width, int height,
+      int out_stride, int in_stride)
+{
+   int h, w;
+   const uint16_t *input = (const uint16_t*)input_;
+   uint16_t *output = (uint16_t*)output_;
+
+   const __m128i hi_mask   = _mm_set1_epi16(0x7fe0);
+   const __m128i lo_mask   = _mm_set1_epi16(0x1f);
+
+   for (h = 0; h < height;
+         h++, output += out_stride >> 1, input += in_stride >> 1)
+   {
+      for (w = 0; w + 8 <= width; w += 8)
+      {
+         const __m128i in = _mm_loadu_si128((const __m128i*)(input + w));
+         __m128i hi = _mm_and_si128(_mm_srli_epi16(in, 1), hi_mask);
+         __m128i lo = _mm_and_si128(in, lo_mask);
+         _mm_storeu_si128((__m128i*)(output + w), _mm_or_si128(hi, lo));
+      }
+
+      for (; w < width; w++)
+         output[w] = px_rgb565_0rgb1555(input[w]);
+   }
+}
+
+static TARGET_SSE2 void conv_0rgb1555_rgb565_sse2(void *output_,
+      const void *input_, int width, int height,
+      int out_stride, int in_stride)
+{
+   int h, w;
+   const uint16_t *input = (const uint16_t*)input_;
+   uint16_t *output = (uint16_t*)output_;
+
+   const __m128i hi_mask   = _mm_set1_epi16(
+         (int16_t)((0x1f << 11) | (0x1f << 6)));
+   const __m128i lo_mask   = _mm_set1_epi16(0x1f);
+   const __m128i glow_mask = _mm_set1_epi16(1 << 5);
+
+   for (h = 0; h < height;
+         h++, output += out_stride >> 1, input += in_stride >> 1)
+   {
+      for (w = 0; w + 8 <= width; w += 8)
+      {
+         const __m128i in = _mm_loadu_si128((const __m128i*)(input + w));
+         __m128i rg   = _mm_and_si128(_mm_slli_epi16(in, 1), hi_mask);
+         __m128i b    = _mm_and_si128(in, lo_mask);
+         __m128i glow = _mm_and_si128(_mm_srli_epi16(in, 4), glow_mask);
+         _mm_storeu_si128((__m128i*)(output + w),
+               _mm_or_si128(rg, _mm_or_si128(b, glow)));
+      }
+
+      for (; w < width; w++)
+         output[w] = px_0rgb1555_rgb565(input[w]);
+   }
+}
+
+static TARGET_SSE2 void conv_0rgb1555_argb8888_sse2(void *output_,
+      const void *input_, int width, int height,
+      int out_stride, int in_stride)
+{
+   int h, w;
+   const uint16_t *input = (const uint16_t*)input_;
+   uint32_t *output      = (uint32_t*)output_;
+
+   for (h = 0; h < height;
+         h++, output += out_stride >> 2, input += in_stride >> 1)
+   {
+      for (w = 0; w + 8 <= width; w += 8)
+      {
+         __m128i res_lo, res_hi;
+         expand_0rgb1555_sse2(
+               _mm_loadu_si128((const __m128i*)(input + w)),
+               &res_lo, &res_hi);
+         _mm_storeu_si128((__m128i*)(output + w + 0), res_lo);
+         _mm_storeu_si128((__m128i*)(output + w + 4), res_hi);
+      }
+
+      for (; w < width; w++)
+         output[w] = px_0rgb1555_argb8888(input[w]);
+   }
+}
+
+static TARGET_SSE2 void conv_rgb565_argb8888_sse2(void *output_,
+      const void *input_, int width, int height,
+      int out_stride, int in_stride)
+{
+   int h, w;
+   const uint16_t *input = (const uint16_t*)input_;
+   uint32_t *output      = (uint32_t*)output_;
+
+   for (h = 0; h < height;
+         h++, output += out_stride >> 2, input += in_stride >> 1)
+   {
+      for (w = 0; w + 8 <= width; w += 8)
+      {
+         __m128i res_lo, res_hi;
+         expand_rgb565_sse2(
+               _mm_loadu_si128((const __m128i*)(input + w)),
+               &res_lo, &res_hi);
+         _mm_storeu_si128((__m128i*)(output + w + 0), res_lo);
+         _mm_storeu_si128((__m128i*)(output + w + 4), res_hi);
+      }
+
+      for (; w < width; w++)
+         output[w] = px_rgb565_argb8888(input[w]);
+   }
+}
+
+static TARGET_SSE2 void conv_rgba4444_argb8888_sse2(void *output_,
+      const void *input_, int width, int height,
+      int out_stride, int in_stride)
+{
+   int h, w;
+   const uint16_t *input = (const uint16_t*)input_;
+   uint32_t *output      = (uint32_t*)output_;
+
+   const __m128i lo_nibble = _mm_set1_epi16(0x000f);
+   const __m128i hi_nibble = _mm_set1_epi16(0x0f00);
+
+   for (h = 0; h < height;
+         h++, output += out_stride >> 2, input += in_stride >> 1)
+   {
+      for (w = 0; w + 8 <= width; w += 8)
+      {
+         const __m128i in = _mm_loadu_si128((const __m128i*)(input + w));
+
+         /* B and G (resp. R and A) as the two nibbles of a 16-bit lane,
+          * then replicate each nibble into a full byte. */
+         __m128i bg = _mm_or_si128(
+               _mm_and_si128(_mm_srli_epi16(in, 4), lo_nibble),
+               _mm_and_si128(in, hi_nibble));
+         __m128i ra = _mm_or_si128(_mm_srli_epi16(in, 12),
+               _mm_and_si128(_mm_slli_epi16(in, 8), hi_nibble));
+         bg = _mm_or_si128(bg, _mm_slli_epi16(bg, 4));
+         ra = _mm_or_si128(ra, _mm_slli_epi16(ra, 4));
+
+         _mm_storeu_si128((__m128i*)(output + w + 0),
+               _mm_unpacklo_epi16(bg, ra));
+         _mm_storeu_si128((__m128i*)(output + w + 4),
+               _mm_unpackhi_epi16(bg, ra));
+      }
+
+      for (; w < width; w++)
+         output[w] = px_rgba4444_argb8888(input[w]);
+   }
+}
+
+static TARGET_SSE2 void conv_0rgb1555_bgr24_sse2(void *output_,
+      const void *input_, int width, int height,
+      int out_stride, int in_stride)
+{
+   int h, w;
+   const uint16_t *input = (const uint16_t*)input_;
+   uint8_t *output       = (uint8_t*)output_;
+
+   for (h = 0; h < height;
+         h++, output += out_stride, input += in_stride >> 1)
+   {
+      uint8_t *out = output;
+
+      for (w = 0; w + 16 <= width; w += 16, out += 48)
+      {
+         __m128i res_lo0, res_hi0, res_lo1, res_hi1;
+         expand_0rgb1555_sse2(
+               _mm_loadu_si128((const __m128i*)(input + w + 0)),
+               &res_lo0, &res_hi0);
+         expand_0rgb1555_sse2(
+               _mm_loadu_si128((const __m128i*)(input + w + 8)),
+               &res_lo1, &res_hi1);
+
+         /* Non-POT pixel sizes ftl :( */
+         store_bgr24_sse2(out, res_lo0, res_hi0, res_lo1, res_hi1);
+      }
+
+      for (; w < width; w++, out += 3)
+         px_store_bgr24(out, px_0rgb1555_argb8888(input[w]));
+   }
+}
+
+static TARGET_SSE2 void conv_rgb565_bgr24_sse2(void *output_,
+      const void *input_, int width, int height,
+      int out_stride, int in_stride)
+{
+   int h, w;
+   const uint16_t *input = (const uint16_t*)input_;
+   uint8_t *output       = (uint8_t*)output_;
+
+   for (h = 0; h < height;
+         h++, output += out_stride, input += in_stride >> 1)
+   {
+      uint8_t *out = output;
+
+      for (w = 0; w + 16 <= width; w += 16, out += 48)
+      {
+         __m128i res_lo0, res_hi0, res_lo1, res_hi1;
+         expand_rgb565_sse2(
+               _mm_loadu_si128((const __m128i*)(input + w + 0)),
+               &res_lo0, &res_hi0);
+         expand_rgb565_sse2(
+               _mm_loadu_si128((const __m128i*)(input + w + 8)),
+               &res_lo1, &res_hi1);
+
+         store_bgr24_sse2(out, res_lo0, res_hi0, res_lo1, res_hi1);
+      }
+
+      for (; w < width; w++, out += 3)
+         px_store_bgr24(out, px_rgb565_argb8888(input[w]));
+   }
+}
+
+/* Packs 8 ARGB8888 pixels into 16-bit pixels. The shifted values are
+ * sign-extended first so the signed saturating pack passes all 16 bits. */
+static inline TARGET_SSE2 __m128i pack_16bit_sse2(__m128i lo, __m128i hi)
+{
+   lo = _mm_srai_epi32(_mm_slli_epi32(lo, 16), 16);
+   hi = _mm_srai_epi32(_mm_slli_epi32(hi, 16), 16);
+   return _mm_packs_epi32(lo, hi);
+}
+
+static inline TARGET_SSE2 __m128i shrink_0rgb1555_sse2(__m128i in)
+{
+   const __m128i mask_r = _mm_set1_epi32(0x1f << 10);
+   const __m128i mask_g = _mm_set1_epi32(0x1f <<  5);
+   const __m128i mask_b = _mm_set1_epi32(0x1f <<  0);
+
+   return _mm_or_si128(
+         _mm_and_si128(_mm_srli_epi32(in, 9), mask_r),
+         _mm_or_si128(_mm_and_si128(_mm_srli_epi32(in, 6), mask_g),
+            _mm_and_si128(_mm_srli_epi32(in, 3), mask_b)));
+}
+
+static inline TARGET_SSE2 __m128i shrink_rgb565_sse2(__m128i in)
+{
+   const __m128i mask_r = _mm_set1_epi32(0x1f << 11);
+   const __m128i mask_g = _mm_set1_epi32(0x3f <<  5);
+   const __m128i mask_b = _mm_set1_epi32(0x1f <<  0);
+
+   return _mm_or_si128(
+         _mm_and_si128(_mm_srli_epi32(in, 8), mask_r),
+         _mm_or_si128(_mm_and_si128(_mm_srli_epi32(in, 5), mask_g),
+            _mm_and_si128(_mm_srli_epi32(in, 3), mask_b)));
+}
+
+static TARGET_SSE2 void conv_argb8888_0rgb1555_sse2(void *output_,
+      const void *input_, int width, int height,
+      int out_stride, int in_stride)
+{
+   int h, w;
+   const uint32_t *input = (const uint32_t*)input_;
+   uint16_t *output      = (uint16_t*)output_;
+
+   for (h = 0; h < height;
+         h++, output += out_stride >> 1, input += in_stride >> 2)
+   {
+      for (w = 0; w + 8 <= width; w += 8)
+      {
+         __m128i lo = shrink_0rgb1555_sse2(
+               _mm_loadu_si128((const __m128i*)(input + w + 0)));
+         __m128i hi = shrink_0rgb1555_sse2(
+               _mm_loadu_si128((const __m128i*)(input + w + 4)));
+         _mm_storeu_si128((__m128i*)(output + w), _mm_packs_epi32(lo, hi));
+      }
+
+      for (; w < width; w++)
+         output[w] = px_argb8888_0rgb1555(input[w]);
+   }
+}
+
+static TARGET_SSE2 void conv_argb8888_rgb565_sse2(void *output_,
+      const void *input_, int width, int height,
+      int out_stride, int in_stride)
+{
+   int h, w;
+   const uint32_t *input = (const uint32_t*)input_;
+   uint16_t *output      = (uint16_t*)output_;
+
+   for (h = 0; h < height;
+         h++, output += out_stride >> 1, input += in_stride >> 2)
+   {
+      for (w = 0; w + 8 <= width; w += 8)
+      {
+         __m128i lo = shrink_rgb565_sse2(
+               _mm_loadu_si128((const __m128i*)(input + w + 0)));
+         __m128i hi = shrink_rgb565_sse2(
+               _mm_loadu_si128((const __m128i*)(input + w + 4)));
+         _mm_storeu_si128((__m128i*)(output + w), pack_16bit_sse2(lo, hi));
+      }
+
+      for (; w < width; w++)
+         output[w] = px_argb8888_rgb565(input[w]);
+   }
+}
+
+static TARGET_SSE2 void conv_argb8888_bgr24_sse2(void *output_,
+      const void *input_, int width, int height,
+      int out_stride, int in_stride)
+{
+   int h, w;
+   const uint32_t *input = (const uint32_t*)input_;
+   uint8_t *output       = (uint8_t*)output_;
+
+   for (h = 0; h < height;
+         h++, output += out_stride, input += in_stride >> 2)
+   {
+      uint8_t *out = output;
+
+      for (w = 0; w + 16 <= width; w += 16, out += 48)
+      {
+         store_bgr24_sse2(out,
+               _mm_loadu_si128((const __m128i*)(input + w +  0)),
+               _mm_loadu_si128((const __m128i*)(input + w +  4)),
+               _mm_loadu_si128((const __m128i*)(input + w +  8)),
+               _mm_loadu_si128((const __m128i*)(input + w + 12)));
+      }
+
+      for (; w < width; w++, out += 3)
+         px_store_bgr24(out, input[w]);
+   }
+}
+
+static TARGET_SSE2 void conv_argb8888_abgr8888_sse2(void *output_,
+      const void *input_, int width, int height,
+      int out_stride, int in_stride)
+{
+   int h, w;
+   const uint32_t *input = (const uint32_t*)input_;
+   uint32_t *output      = (uint32_t*)output_;
+
+   const __m128i mask_rb = _mm_set1_epi32(0x00ff00ff);
+   const __m128i mask_ga = _mm_set1_epi32(0xff00ff00);
+
+   for (h = 0; h < height;
+         h++, output += out_stride >> 2, input += in_stride >> 2)
+   {
+      for (w = 0; w + 4 <= width; w += 4)
+      {
+         const __m128i in = _mm_loadu_si128((const __m128i*)(input + w));
+         __m128i rb = _mm_and_si128(in, mask_rb);
+         rb = _mm_or_si128(_mm_slli_epi32(rb, 16), _mm_srli_epi32(rb, 16));
+         _mm_storeu_si128((__m128i*)(output + w),
+               _mm_or_si128(rb, _mm_and_si128(in, mask_ga)));
+      }
+
+      for (; w < width; w++)
+         output[w] = px_argb8888_abgr8888(input[w]);
+   }
+}
+
+static TARGET_SSE2 void conv_yuyv_argb8888_sse2(void *output_,
+      const void *input_, int width, int height,
+      int out_stride, int in_stride)
+{
+   int h, w;
+   const uint8_t *input = (const uint8_t*)input_;
+   uint32_t *output     = (uint32_t*)output_;
+
+   const __m128i mask_y = _mm_set1_epi16(0xffu);
+   const __m128i mask_u = _mm_set1_epi32(0xffu << 8);
+   const __m128i mask_v = _mm_set1_epi32(0xffu << 24);
+   const __m128i chroma_offset = _mm_set1_epi16(128);
+   const __m128i round_offset = _mm_set1_epi16(YUV_OFFSET);
+
+   const __m128i yuv_mul = _mm_set1_epi16(YUV_MAT_Y);
+   const __m128i u_g_mul = _mm_set1_epi16(YUV_MAT_U_G);
+   const __m128i u_b_mul = _mm_set1_epi16(YUV_MAT_U_B);
+   const __m128i v_r_mul = _mm_set1_epi16(YUV_MAT_V_R);
+   const __m128i v_g_mul = _mm_set1_epi16(YUV_MAT_V_G);
+   const __m128i a       = _mm_cmpeq_epi16(_mm_setzero_si128(),
+         _mm_setzero_si128());
+
+   for (h = 0; h < height; h++, output += out_stride >> 2, input += in_stride)
+   {
+      const uint8_t *src = input;
+      uint32_t *dst = output;
+
+      /* Each loop processes 16 pixels. */
+      for (w = 0; w + 16 <= width; w += 16, src += 32, dst += 16)
+      {
+         __m128i yuv0 = _mm_loadu_si128((const __m128i*)(src +  0)); /* [Y0, U0, Y1, V0, Y2, U1, Y3, V1, ...] */
+         __m128i yuv1 = _mm_loadu_si128((const __m128i*)(src + 16)); /* [Y0, U0, Y1, V0, Y2, U1, Y3, V1, ...] */
+
+         __m128i y0 = _mm_and_si128(yuv0, mask_y); /* [Y0, Y1, Y2, ...] (16-bit) */
+         __m128i u0 = _mm_and_si128(yuv0, mask_u); /* [0, U0, 0, 0, 0, U1, 0, 0, ...] */
+         __m128i v0 = _mm_and_si128(yuv0, mask_v); /* [0, 0, 0, V1, 0, , 0, V1, ...] */
+         __m128i y1 = _mm_and_si128(yuv1, mask_y); /* [Y0, Y1, Y2, ...] (16-bit) */
+         __m128i u1 = _mm_and_si128(yuv1, mask_u); /* [0, U0, 0, 0, 0, U1, 0, 0, ...] */
+         __m128i v1 = _mm_and_si128(yuv1, mask_v); /* [0, 0, 0, V1, 0, , 0, V1, ...] */
+
+         /* Juggle around to get U and V in the same 16-bit format as Y. */
+         u0 = _mm_srli_si128(u0, 1);
+         v0 = _mm_srli_si128(v0, 3);
+         u1 = _mm_srli_si128(u1, 1);
+         v1 = _mm_srli_si128(v1, 3);
+         __m128i u = _mm_packs_epi32(u0, u1);
+         __m128i v = _mm_packs_epi32(v0, v1);
+
+         /* Apply YUV offsets (U, V) -= (-128, -128). */
+         u = _mm_sub_epi16(u, chroma_offset);
+         v = _mm_sub_epi16(v, chroma_offset);
+
+         /* Upscale chroma horizontally (nearest). */
+         u0 = _mm_unpacklo_epi16(u, u);
+         u1 = _mm_unpackhi_epi16(u, u);
+         v0 = _mm_unpacklo_epi16(v, v);
+         v1 = _mm_unpackhi_epi16(v, v);
+
+         /* Apply transformations. */
+         y0 = _mm_mullo_epi16(y0, yuv_mul);
+         y1 = _mm_mullo_epi16(y1, yuv_mul);
+         __m128i u0_g   = _mm_mullo_epi16(u0, u_g_mul);
+         __m128i u1_g   = _mm_mullo_epi16(u1, u_g_mul);
+         __m128i u0_b   = _mm_mullo_epi16(u0, u_b_mul);
+         __m128i u1_b   = _mm_mullo_epi16(u1, u_b_mul);
+         __m128i v0_r   = _mm_mullo_epi16(v0, v_r_mul);
+         __m128i v1_r   = _mm_mullo_epi16(v1, v_r_mul);
+         __m128i v0_g   = _mm_mullo_epi16(v0, v_g_mul);
+         __m128i v1_g   = _mm_mullo_epi16(v1, v_g_mul);
+
+         /* Add contibutions from the transformed components. */
+         __m128i r0 = _mm_srai_epi16(_mm_adds_epi16(_mm_adds_epi16(y0, v0_r),
+                  round_offset), YUV_SHIFT);
+         __m128i g0 = _mm_srai_epi16(_mm_adds_epi16(
+                  _mm_adds_epi16(_mm_adds_epi16(y0, v0_g), u0_g), round_offset), YUV_SHIFT);
+         __m128i b0 = _mm_srai_epi16(_mm_adds_epi16(
+                  _mm_adds_epi16(y0, u0_b), round_offset), YUV_SHIFT);
+
+         __m128i r1 = _mm_srai_epi16(_mm_adds_epi16(
+                  _mm_adds_epi16(y1, v1_r), round_offset), YUV_SHIFT);
+         __m128i g1 = _mm_srai_epi16(_mm_adds_epi16(
+                  _mm_adds_epi16(_mm_adds_epi16(y1, v1_g), u1_g), round_offset), YUV_SHIFT);
+         __m128i b1 = _mm_srai_epi16(_mm_adds_epi16(
+                  _mm_adds_epi16(y1, u1_b), round_offset), YUV_SHIFT);
+
+         /* Saturate into 8-bit. */
+         r0 = _mm_packus_epi16(r0, r1);
+         g0 = _mm_packus_epi16(g0, g1);
+         b0 = _mm_packus_epi16(b0, b1);
+
+         /* Interleave into ARGB. */
+         __m128i res_lo_bg = _mm_unpacklo_epi8(b0, g0);
+         __m128i res_hi_bg = _mm_unpackhi_epi8(b0, g0);
+         __m128i res_lo_ra = _mm_unpacklo_epi8(r0, a);
+         __m128i res_hi_ra = _mm_unpackhi_epi8(r0, a);
+         __m128i res0 = _mm_unpacklo_epi16(res_lo_bg, res_lo_ra);
+         __m128i res1 = _mm_unpackhi_epi16(res_lo_bg, res_lo_ra);
+         __m128i res2 = _mm_unpacklo_epi16(res_hi_bg, res_hi_ra);
+         __m128i res3 = _mm_unpackhi_epi16(res_hi_bg, res_hi_ra);
+
+         _mm_storeu_si128((__m128i*)(dst +  0), res0);
+         _mm_storeu_si128((__m128i*)(dst +  4), res1);
+         _mm_storeu_si128((__m128i*)(dst +  8), res2);
+         _mm_storeu_si128((__m128i*)(dst + 12), res3);
+      }
+
+      /* Finish off the rest (if any) in C. */
+      for (; w < width; w += 2, src += 4, dst += 2)
+         px_yuyv_argb8888(dst, src);
+   }
+}
+
+/* SSSE3 versions. */
+
+static TARGET_SSSE3 void conv_bgr24_argb8888_ssse3(void *output_,
+      const void *input_, int width, int height,
+      int out_stride, int in_stride)
+{
+   int h, w;
+   const uint8_t *input = (const uint8_t*)input_;
+   uint32_t *output     = (uint32_t*)output_;
+
+   /* Spreads 4 packed BGR pixels into ARGB lanes. The variant with
+    * offset 4 takes the last 4 pixels of a 16-pixel block from a load
+    * that ends exactly at the block's end, so we never read past it. */
+   const __m128i shuf0 = _mm_setr_epi8(0, 1, 2, -1, 3, 4, 5, -1,
+         6, 7, 8, -1, 9, 10, 11, -1);
+   const __m128i shuf4 = _mm_setr_epi8(4, 5, 6, -1, 7, 8, 9, -1,
+         10, 11, 12, -1, 13, 14, 15, -1);
+   const __m128i a     = _mm_set1_epi32(0xff000000);
+
+   for (h = 0; h < height;
+         h++, output += out_stride >> 2, input += in_stride)
+   {
+      const uint8_t *inp = input;
+
+      for (w = 0; w + 16 <= width; w += 16, inp += 48)
+      {
+         __m128i in0 = _mm_loadu_si128((const __m128i*)(inp +  0));
+         __m128i in1 = _mm_loadu_si128((const __m128i*)(inp + 12));
+         __m128i in2 = _mm_loadu_si128((const __m128i*)(inp + 24));
+         __m128i in3 = _mm_loadu_si128((const __m128i*)(inp + 32));
+
+         _mm_storeu_si128((__m128i*)(output + w +  0),
+               _mm_or_si128(_mm_shuffle_epi8(in0, shuf0), a));
+         _mm_storeu_si128((__m128i*)(output + w +  4),
+               _mm_or_si128(_mm_shuffle_epi8(in1, shuf0), a));
+         _mm_storeu_si128((__m128i*)(output + w +  8),
+               _mm_or_si128(_mm_shuffle_epi8(in2, shuf0), a));
+         _mm_storeu_si128((__m128i*)(output + w + 12),
+               _mm_or_si128(_mm_shuffle_epi8(in3, shuf4), a));
+      }
+
+      for (; w < width; w++, inp += 3)
+         output[w] = 0xff000000u |
+            (inp[2] << 16) | (inp[1] << 8) | (inp[0] << 0);
+   }
+}
+
+/* AVX2 versions. Most 256-bit instructions work on two independent
+ * 128-bit lanes, so results are put back in order with lane permutes. */
+
+/* 16 pixels of 8-bit R, G and B (one per 16-bit lane)
+ * to opaque ARGB8888, pixels 0-7 in *lo and 8-15 in *hi. */
+static inline TARGET_AVX2 void pack_argb_avx2(__m256i r, __m256i g,
+      __m256i b, __m256i *lo, __m256i *hi)
+{
+   const __m256i a = _mm256_set1_epi16(0x00ff);
+
+   __m256i res_lo = _mm256_or_si256(_mm256_unpacklo_epi8(b, g),
+         _mm256_slli_si256(_mm256_unpacklo_epi8(r, a), 2));
+   __m256i res_hi = _mm256_or_si256(_mm256_unpackhi_epi8(b, g),
+         _mm256_slli_si256(_mm256_unpackhi_epi8(r, a), 2));
+
+   *lo = _mm256_permute2x128_si256(res_lo, res_hi, 0x20);
+   *hi = _mm256_permute2x128_si256(res_lo, res_hi, 0x31);
+}
+
+static inline TARGET_AVX2 void expand_0rgb1555_avx2(__m256i in,
+      __m256i *lo, __m256i *hi)
+{
+   const __m256i pix_mask_r  = _mm256_set1_epi16(0x1f << 10);
+   const __m256i pix_mask_gb = _mm256_set1_epi16(0x1f <<  5);
+   const __m256i mul15_mid   = _mm256_set1_epi16(0x4200);
+   const __m256i mul15_hi    = _mm256_set1_epi16(0x0210);
 
-#if defined(__SSE2__)
-#include <emmintrin.h>
-#endif
+   __m256i r = _mm256_and_si256(in, pix_mask_r);
+   __m256i g = _mm256_and_si256(in, pix_mask_gb);
+   __m256i b = _mm256_and_si256(_mm256_slli_epi16(in, 5), pix_mask_gb);
 
-#if defined(__SSE2_)
-void conv_rgb565_0rgb1555(void *output_, const void *input_,
-      int width, int height,
+   r = _mm256_mulhi_epi16(r, mul15_hi);
+   g = _mm256_mulhi_epi16(g, mul15_mid);
+   b = _mm256_mulhi_epi16(b, mul15_mid);
+
+   pack_argb_avx2(r, g, b, lo, hi);
+}
+
+static inline TARGET_AVX2 void expand_rgb565_avx2(__m256i in,
+      __m256i *lo, __m256i *hi)
+{
+   const __m256i pix_mask_r = _mm256_set1_epi16(0x1f << 10);
+   const __m256i pix_mask_g = _mm256_set1_epi16(0x3f <<  5);
+   const __m256i pix_mask_b = _mm256_set1_epi16(0x1f <<  5);
+   const __m256i mul16_r    = _mm256_set1_epi16(0x0210);
+   const __m256i mul16_g    = _mm256_set1_epi16(0x2080);
+   const __m256i mul16_b    = _mm256_set1_epi16(0x4200);
+
+   __m256i r = _mm256_and_si256(_mm256_srli_epi16(in, 1), pix_mask_r);
+   __m256i g = _mm256_and_si256(in, pix_mask_g);
+   __m256i b = _mm256_and_si256(_mm256_slli_epi16(in, 5), pix_mask_b);
+
+   r = _mm256_mulhi_epi16(r, mul16_r);
+   g = _mm256_mulhi_epi16(g, mul16_g);
+   b = _mm256_mulhi_epi16(b, mul16_b);
+
+   pack_argb_avx2(r, g, b, lo, hi);
+}
+
+/* Drops the alpha byte of 8 ARGB8888 pixels and writes 24 bytes. */
+static inline TARGET_AVX2 void store_bgr24_avx2(uint8_t *out, __m256i in)
+{
+   const __m256i shuf = _mm256_setr_epi8(
+         0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1,
+         0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1);
+   const __m256i perm = _mm256_setr_epi32(0, 1, 2, 4, 5, 6, 3, 7);
+
+   __m256i res = _mm256_permutevar8x32_epi32(
+         _mm256_shuffle_epi8(in, shuf), perm);
+
+   _mm_storeu_si128((__m128i*)out, _mm256_castsi256_si128(res));
+   _mm_storel_epi64((__m128i*)(out + 16),
+         _mm256_extracti128_si256(res, 1));
+}
+
+static TARGET_AVX2 void conv_rgb565_0rgb1555_avx2(void *output_,
+      const void *input_, int width, int height,
       int out_stride, int in_stride)
 {
    int h, w;
    const uint16_t *input = (const uint16_t*)input_;
    uint16_t *output = (uint16_t*)output_;
 
-   int max_width = width - 7;
-
-   const __m128i hi_mask   = _mm_set1_epi16(0x7fe0);
-   const __m128i lo_mask   = _mm_set1_epi16(0x1f);
+   const __m256i hi_mask = _mm256_set1_epi16(0x7fe0);
+   const __m256i lo_mask = _mm256_set1_epi16(0x1f);
 
    for (h = 0; h < height;
          h++, output += out_stride >> 1, input += in_stride >> 1)
    {
-      for (w = 0; w < max_width; w += 8)
+      for (w = 0; w + 16 <= width; w += 16)
       {
-         const __m128i in = _mm_loadu_si128((const __m128i*)(input + w));
-         __m128i hi = _mm_and_si128(_mm_slli_epi16(in, 1), hi_mask);
-         __m128i lo = _mm_and_si128(in, lo_mask);
-         _mm_storeu_si128((__m128i*)(output + w), _mm_or_si128(hi, lo));
+         const __m256i in = _mm256_loadu_si256((const __m256i*)(input + w));
+         __m256i hi = _mm256_and_si256(_mm256_srli_epi16(in, 1), hi_mask);
+         __m256i lo = _mm256_and_si256(in, lo_mask);
+         _mm256_storeu_si256((__m256i*)(output + w),
+               _mm256_or_si256(hi, lo));
       }
 
       for (; w < width; w++)
-      {
-         uint16_t col = input[w];
-         uint16_t hi = (col >> 1) & 0x7fe0;
-         uint16_t lo = col & 0x1f;
-         output[w] = hi | lo;
-      }
+         output[w] = px_rgb565_0rgb1555(input[w]);
    }
 }
-#else
-void conv_rgb565_0rgb1555(void *output_, const void *input_,
-      int width, int height,
+
+static TARGET_AVX2 void conv_0rgb1555_rgb565_avx2(void *output_,
+      const void *input_, int width, int height,
       int out_stride, int in_stride)
 {
    int h, w;
    const uint16_t *input = (const uint16_t*)input_;
    uint16_t *output = (uint16_t*)output_;
 
+   const __m256i hi_mask   = _mm256_set1_epi16(
+         (int16_t)((0x1f << 11) | (0x1f << 6)));
+   const __m256i lo_mask   = _mm256_set1_epi16(0x1f);
+   const __m256i glow_mask = _mm256_set1_epi16(1 << 5);
+
    for (h = 0; h < height;
          h++, output += out_stride >> 1, input += in_stride >> 1)
    {
-      for (w = 0; w < width; w++)
+      for (w = 0; w + 16 <= width; w += 16)
       {
-         uint16_t col = input[w];
-         uint16_t hi = (col >> 1) & 0x7fe0;
-         uint16_t lo = col & 0x1f;
-         output[w] = hi | lo;
+         const __m256i in = _mm256_loadu_si256((const __m256i*)(input + w));
+         __m256i rg   = _mm256_and_si256(_mm256_slli_epi16(in, 1), hi_mask);
+         __m256i b    = _mm256_and_si256(in, lo_mask);
+         __m256i glow = _mm256_and_si256(_mm256_srli_epi16(in, 4), glow_mask);
+         _mm256_storeu_si256((__m256i*)(output + w),
+               _mm256_or_si256(rg, _mm256_or_si256(b, glow)));
       }
+
+      for (; w < width; w++)
+         output[w] = px_0rgb1555_rgb565(input[w]);
    }
 }
 
-#endif
-
-#if defined(__SSE2__)
-void conv_0rgb1555_rgb565(void *output_, const void *input_,
-      int width, int height,
+static TARGET_AVX2 void conv_0rgb1555_argb8888_avx2(void *output_,
+      const void *input_, int width, int height,
       int out_stride, int in_stride)
 {
    int h, w;
    const uint16_t *input = (const uint16_t*)input_;
-   uint16_t *output = (uint16_t*)output_;
-
-   int max_width = width - 7;
-
-   const __m128i hi_mask   = _mm_set1_epi16(
-         (int16_t)((0x1f << 11) | (0x1f << 6)));
-   const __m128i lo_mask   = _mm_set1_epi16(0x1f);
-   const __m128i glow_mask = _mm_set1_epi16(1 << 5);
+   uint32_t *output      = (uint32_t*)output_;
 
    for (h = 0; h < height;
-         h++, output += out_stride >> 1, input += in_stride >> 1)
+         h++, output += out_stride >> 2, input += in_stride >> 1)
    {
-      for (w = 0; w < max_width; w += 8)
+      for (w = 0; w + 16 <= width; w += 16)
       {
-         const __m128i in = _mm_loadu_si128((const __m128i*)(input + w));
-         __m128i rg   = _mm_and_si128(_mm_slli_epi16(in, 1), hi_mask);
-         __m128i b    = _mm_and_si128(in, lo_mask);
-         __m128i glow = _mm_and_si128(_mm_srli_epi16(in, 4), glow_mask);
-         _mm_storeu_si128((__m128i*)(output + w),
-               _mm_or_si128(rg, _mm_or_si128(b, glow)));
+         __m256i res_lo, res_hi;
+         expand_0rgb1555_avx2(
+               _mm256_loadu_si256((const __m256i*)(input + w)),
+               &res_lo, &res_hi);
+         _mm256_storeu_si256((__m256i*)(output + w + 0), res_lo);
+         _mm256_storeu_si256((__m256i*)(output + w + 8), res_hi);
       }
 
       for (; w < width; w++)
-      {
-         uint16_t col = input[w];
-         uint16_t rg = (col << 1) & ((0x1f << 11) | (0x1f << 6));
-         uint16_t b = col & 0x1f;
-         uint16_t glow = (col >> 4) & (1 << 5);
-         output[w] = rg | b | glow;
-      }
+         output[w] = px_0rgb1555_argb8888(input[w]);
    }
 }
-#else
-void conv_0rgb1555_rgb565(void *output_, const void *input_,
-      int width, int height,
+
+static TARGET_AVX2 void conv_rgb565_argb8888_avx2(void *output_,
+      const void *input_, int width, int height,
       int out_stride, int in_stride)
 {
    int h, w;
    const uint16_t *input = (const uint16_t*)input_;
-   uint16_t *output = (uint16_t*)output_;
+   uint32_t *output      = (uint32_t*)output_;
 
    for (h = 0; h < height;
-         h++, output += out_stride >> 1, input += in_stride >> 1)
+         h++, output += out_stride >> 2, input += in_stride >> 1)
    {
-      for (w = 0; w < width; w++)
+      for (w = 0; w + 16 <= width; w += 16)
       {
-         uint16_t col = input[w];
-         uint16_t rg = (col << 1) & ((0x1f << 11) | (0x1f << 6));
-         uint16_t b = col & 0x1f;
-         uint16_t glow = (col >> 4) & (1 << 5);
-         output[w] = rg | b | glow;
+         __m256i res_lo, res_hi;
+         expand_rgb565_avx2(
+               _mm256_loadu_si256((const __m256i*)(input + w)),
+               &res_lo, &res_hi);
+         _mm256_storeu_si256((__m256i*)(output + w + 0), res_lo);
+         _mm256_storeu_si256((__m256i*)(output + w + 8), res_hi);
       }
+
+      for (; w < width; w++)
+         output[w] = px_rgb565_argb8888(input[w]);
    }
 }
-#endif
 
-#if defined(__SSE2__)
-void conv_0rgb1555_argb8888(void *output_, const void *input_,
-      int width, int height,
+static TARGET_AVX2 void conv_rgba4444_argb8888_avx2(void *output_,
+      const void *input_, int width, int height,
       int out_stride, int in_stride)
 {
    int h, w;
    const uint16_t *input = (const uint16_t*)input_;
    uint32_t *output      = (uint32_t*)output_;
 
-   const __m128i pix_mask_r  = _mm_set1_epi16(0x1f << 10);
-   const __m128i pix_mask_gb = _mm_set1_epi16(0x1f <<  5);
-   const __m128i mul15_mid   = _mm_set1_epi16(0x4200);
-   const __m128i mul15_hi    = _mm_set1_epi16(0x0210);
-   const __m128i a           = _mm_set1_epi16(0x00ff);
-
-   int max_width = width - 7;
+   const __m256i lo_nibble = _mm256_set1_epi16(0x000f);
+   const __m256i hi_nibble = _mm256_set1_epi16(0x0f00);
 
    for (h = 0; h < height;
          h++, output += out_stride >> 2, input += in_stride >> 1)
    {
-      for (w = 0; w < max_width; w += 8)
+      for (w = 0; w + 16 <= width; w += 16)
       {
-         const __m128i in = _mm_loadu_si128((const __m128i*)(input + w));
-         __m128i r = _mm_and_si128(in, pix_mask_r);
-         __m128i g = _mm_and_si128(in, pix_mask_gb);
-         __m128i b = _mm_and_si128(_mm_slli_epi16(in, 5), pix_mask_gb);
-
-         r = _mm_mulhi_epi16(r, mul15_hi);
-         g = _mm_mulhi_epi16(g, mul15_mid);
-         b = _mm_mulhi_epi16(b, mul15_mid);
+         const __m256i in = _mm256_loadu_si256((const __m256i*)(input + w));
+
+         __m256i bg = _mm256_or_si256(
+               _mm256_and_si256(_mm256_srli_epi16(in, 4), lo_nibble),
+               _mm256_and_si256(in, hi_nibble));
+         __m256i ra = _mm256_or_si256(_mm256_srli_epi16(in, 12),
+               _mm256_and_si256(_mm256_slli_epi16(in, 8), hi_nibble));
+         bg = _mm256_or_si256(bg, _mm256_slli_epi16(bg, 4));
+         ra = _mm256_or_si256(ra, _mm256_slli_epi16(ra, 4));
+
+         __m256i res_lo = _mm256_unpacklo_epi16(bg, ra);
+         __m256i res_hi = _mm256_unpackhi_epi16(bg, ra);
+
+         _mm256_storeu_si256((__m256i*)(output + w + 0),
+               _mm256_permute2x128_si256(res_lo, res_hi, 0x20));
+         _mm256_storeu_si256((__m256i*)(output + w + 8),
+               _mm256_permute2x128_si256(res_lo, res_hi, 0x31));
+      }
 
-         __m128i res_lo_bg = _mm_unpacklo_epi8(b, g);
-         __m128i res_hi_bg = _mm_unpackhi_epi8(b, g);
-         __m128i res_lo_ra = _mm_unpacklo_epi8(r, a);
-         __m128i res_hi_ra = _mm_unpackhi_epi8(r, a);
+      for (; w < width; w++)
+         output[w] = px_rgba4444_argb8888(input[w]);
+   }
+}
 
-         __m128i res_lo = _mm_or_si128(res_lo_bg,
-               _mm_slli_si128(res_lo_ra, 2));
-         __m128i res_hi = _mm_or_si128(res_hi_bg,
-               _mm_slli_si128(res_hi_ra, 2));
+static TARGET_AVX2 void conv_0rgb1555_bgr24_avx2(void *output_,
+      const void *input_, int width, int height,
+      int out_stride, int in_stride)
+{
+   int h, w;
+   const uint16_t *input = (const uint16_t*)input_;
+   uint8_t *output       = (uint8_t*)output_;
 
-         _mm_storeu_si128((__m128i*)(output + w + 0), res_lo);
-         _mm_storeu_si128((__m128i*)(output + w + 4), res_hi);
-      }
+   for (h = 0; h < height;
+         h++, output += out_stride, input += in_stride >> 1)
+   {
+      uint8_t *out = output;
 
-      for (; w < width; w++)
+      for (w = 0; w + 16 <= width; w += 16, out += 48)
       {
-         uint32_t col = input[w];
-         uint32_t r = (col >> 10) & 0x1f;
-         uint32_t g = (col >>  5) & 0x1f;
-         uint32_t b = (col >>  0) & 0x1f;
-         r = (r << 3) | (r >> 2);
-         g = (g << 3) | (g >> 2);
-         b = (b << 3) | (b >> 2);
-
-         output[w] = (0xff << 24) | (r << 16) | (g << 8) | (b << 0);
+         __m256i res_lo, res_hi;
+         expand_0rgb1555_avx2(
+               _mm256_loadu_si256((const __m256i*)(input + w)),
+               &res_lo, &res_hi);
+         store_bgr24_avx2(out +  0, res_lo);
+         store_bgr24_avx2(out + 24, res_hi);
       }
+
+      for (; w < width; w++, out += 3)
+         px_store_bgr24(out, px_0rgb1555_argb8888(input[w]));
    }
 }
-#else
-void conv_0rgb1555_argb8888(void *output_, const void *input_,
-      int width, int height,
+
+static TARGET_AVX2 void conv_rgb565_bgr24_avx2(void *output_,
+      const void *input_, int width, int height,
       int out_stride, int in_stride)
 {
    int h, w;
    const uint16_t *input = (const uint16_t*)input_;
-   uint32_t *output      = (uint32_t*)output_;
+   uint8_t *output       = (uint8_t*)output_;
 
    for (h = 0; h < height;
-         h++, output += out_stride >> 2, input += in_stride >> 1)
+         h++, output += out_stride, input += in_stride >> 1)
    {
-      for (w = 0; w < width; w++)
-      {
-         uint32_t col = input[w];
-         uint32_t r = (col >> 10) & 0x1f;
-         uint32_t g = (col >>  5) & 0x1f;
-         uint32_t b = (col >>  0) & 0x1f;
-         r = (r << 3) | (r >> 2);
-         g = (g << 3) | (g >> 2);
-         b = (b << 3) | (b >> 2);
+      uint8_t *out = output;
 
-         output[w] = (0xffu << 24) | (r << 16) | (g << 8) | (b << 0);
+      for (w = 0; w + 16 <= width; w += 16, out += 48)
+      {
+         __m256i res_lo, res_hi;
+         expand_rgb565_avx2(
+               _mm256_loadu_si256((const __m256i*)(input + w)),
+               &res_lo, &res_hi);
+         store_bgr24_avx2(out +  0, res_lo);
+         store_bgr24_avx2(out + 24, res_hi);
       }
+
+      for (; w < width; w++, out += 3)
+         px_store_bgr24(out, px_rgb565_argb8888(input[w]));
    }
 }
-#endif
 
-#if defined(__SSE2__)
-void conv_rgb565_argb8888(void *output_, const void *input_,
-      int width, int height,
+static TARGET_AVX2 void conv_bgr24_argb8888_avx2(void *output_,
+      const void *input_, int width, int height,
       int out_stride, int in_stride)
 {
    int h, w;
-   const uint16_t *input = (const uint16_t*)input_;
-   uint32_t *output      = (uint32_t*)output_;
-
-   const __m128i pix_mask_r = _mm_set1_epi16(0x1f << 10);
-   const __m128i pix_mask_g = _mm_set1_epi16(0x3f <<  5);
-   const __m128i pix_mask_b = _mm_set1_epi16(0x1f <<  5);
-   const __m128i mul16_r    = _mm_set1_epi16(0x0210);
-   const __m128i mul16_g    = _mm_set1_epi16(0x2080);
-   const __m128i mul16_b    = _mm_set1_epi16(0x4200);
-   const __m128i a          = _mm_set1_epi16(0x00ff);
+   const uint8_t *input = (const uint8_t*)input_;
+   uint32_t *output     = (uint32_t*)output_;
 
-   int max_width = width - 7;
+   /* Same scheme as the SSSE3 version, two 128-bit loads per register. */
+   const __m256i shuf0 = _mm256_setr_epi8(
+         0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1,
+         0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1);
+   const __m256i shuf4 = _mm256_setr_epi8(
+         0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1,
+         4, 5, 6, -1, 7, 8, 9, -1, 10, 11, 12, -1, 13, 14, 15, -1);
+   const __m256i a     = _mm256_set1_epi32(0xff000000);
 
    for (h = 0; h < height;
-         h++, output += out_stride >> 2, input += in_stride >> 1)
+         h++, output += out_stride >> 2, input += in_stride)
    {
-      for (w = 0; w < max_width; w += 8)
+      const uint8_t *inp = input;
+
+      for (w = 0; w + 16 <= width; w += 16, inp += 48)
       {
-         const __m128i in = _mm_loadu_si128((const __m128i*)(input + w));
-         __m128i r = _mm_and_si128(_mm_srli_epi16(in, 1), pix_mask_r);
-         __m128i g = _mm_and_si128(in, pix_mask_g);
-         __m128i b = _mm_and_si128(_mm_slli_epi16(in, 5), pix_mask_b);
+         __m256i in0 = _mm256_inserti128_si256(_mm256_castsi128_si256(
+                  _mm_loadu_si128((const __m128i*)(inp +  0))),
+               _mm_loadu_si128((const __m128i*)(inp + 12)), 1);
+         __m256i in1 = _mm256_inserti128_si256(_mm256_castsi128_si256(
+                  _mm_loadu_si128((const __m128i*)(inp + 24))),
+               _mm_loadu_si128((const __m128i*)(inp + 32)), 1);
+
+         _mm256_storeu_si256((__m256i*)(output + w + 0),
+               _mm256_or_si256(_mm256_shuffle_epi8(in0, shuf0), a));
+         _mm256_storeu_si256((__m256i*)(output + w + 8),
+               _mm256_or_si256(_mm256_shuffle_epi8(in1, shuf4), a));
+      }
+
+      for (; w < width; w++, inp += 3)
+         output[w] = 0xff000000u |
+            (inp[2] << 16) | (inp[1] << 8) | (inp[0] << 0);
+   }
+}
+
+static inline TARGET_AVX2 __m256i shrink_0rgb1555_avx2(__m256i in)
+{
+   const __m256i mask_r = _mm256_set1_epi32(0x1f << 10);
+   const __m256i mask_g = _mm256_set1_epi32(0x1f <<  5);
+   const __m256i mask_b = _mm256_set1_epi32(0x1f <<  0);
+
+   return _mm256_or_si256(
+         _mm256_and_si256(_mm256_srli_epi32(in, 9), mask_r),
+         _mm256_or_si256(_mm256_and_si256(_mm256_srli_epi32(in, 6), mask_g),
+            _mm256_and_si256(_mm256_srli_epi32(in, 3), mask_b)));
+}
 
-         r = _mm_mulhi_epi16(r, mul16_r);
-         g = _mm_mulhi_epi16(g, mul16_g);
-         b = _mm_mulhi_epi16(b, mul16_b);
+static inline TARGET_AVX2 __m256i shrink_rgb565_avx2(__m256i in)
+{
+   const __m256i mask_r = _mm256_set1_epi32(0x1f << 11);
+   const __m256i mask_g = _mm256_set1_epi32(0x3f <<  5);
+   const __m256i mask_b = _mm256_set1_epi32(0x1f <<  0);
 
-         __m128i res_lo_bg = _mm_unpacklo_epi8(b, g);
-         __m128i res_hi_bg = _mm_unpackhi_epi8(b, g);
-         __m128i res_lo_ra = _mm_unpacklo_epi8(r, a);
-         __m128i res_hi_ra = _mm_unpackhi_epi8(r, a);
+   __m256i res = _mm256_or_si256(
+         _mm256_and_si256(_mm256_srli_epi32(in, 8), mask_r),
+         _mm256_or_si256(_mm256_and_si256(_mm256_srli_epi32(in, 5), mask_g),
+            _mm256_and_si256(_mm256_srli_epi32(in, 3), mask_b)));
 
-         __m128i res_lo = _mm_or_si128(res_lo_bg,
-               _mm_slli_si128(res_lo_ra, 2));
-         __m128i res_hi = _mm_or_si128(res_hi_bg,
-               _mm_slli_si128(res_hi_ra, 2));
+   /* Sign-extend so the signed saturating pack keeps all 16 bits. */
+   return _mm256_srai_epi32(_mm256_slli_epi32(res, 16), 16);
+}
 
-         _mm_storeu_si128((__m128i*)(output + w + 0), res_lo);
-         _mm_storeu_si128((__m128i*)(output + w + 4), res_hi);
+/* Packs pixels 0-7 and 8-15 into 16-bit pixels 0-15. */
+static inline TARGET_AVX2 __m256i pack_16bit_avx2(__m256i lo, __m256i hi)
+{
+   return _mm256_permute4x64_epi64(_mm256_packs_epi32(lo, hi),
+         _MM_SHUFFLE(3, 1, 2, 0));
+}
+
+static TARGET_AVX2 void conv_argb8888_0rgb1555_avx2(void *output_,
+      const void *input_, int width, int height,
+      int out_stride, int in_stride)
+{
+   int h, w;
+   const uint32_t *input = (const uint32_t*)input_;
+   uint16_t *output      = (uint16_t*)output_;
+
+   for (h = 0; h < height;
+         h++, output += out_stride >> 1, input += in_stride >> 2)
+   {
+      for (w = 0; w + 16 <= width; w += 16)
+      {
+         __m256i lo = shrink_0rgb1555_avx2(
+               _mm256_loadu_si256((const __m256i*)(input + w + 0)));
+         __m256i hi = shrink_0rgb1555_avx2(
+               _mm256_loadu_si256((const __m256i*)(input + w + 8)));
+         _mm256_storeu_si256((__m256i*)(output + w),
+               pack_16bit_avx2(lo, hi));
       }
 
       for (; w < width; w++)
-      {
-         uint32_t col = input[w];
-         uint32_t r = (col >> 11) & 0x1f;
-         uint32_t g = (col >>  5) & 0x3f;
-         uint32_t b = (col >>  0) & 0x1f;
-         r = (r << 3) | (r >> 2);
-         g = (g << 2) | (g >> 4);
-         b = (b << 3) | (b >> 2);
+         output[w] = px_argb8888_0rgb1555(input[w]);
+   }
+}
+
+static TARGET_AVX2 void conv_argb8888_rgb565_avx2(void *output_,
+      const void *input_, int width, int height,
+      int out_stride, int in_stride)
+{
+   int h, w;
+   const uint32_t *input = (const uint32_t*)input_;
+   uint16_t *output      = (uint16_t*)output_;
 
-         output[w] = (0xff << 24) | (r << 16) | (g << 8) | (b << 0);
+   for (h = 0; h < height;
+         h++, output += out_stride >> 1, input += in_stride >> 2)
+   {
+      for (w = 0; w + 16 <= width; w += 16)
+      {
+         __m256i lo = shrink_rgb565_avx2(
+               _mm256_loadu_si256((const __m256i*)(input + w + 0)));
+         __m256i hi = shrink_rgb565_avx2(
+               _mm256_loadu_si256((const __m256i*)(input + w + 8)));
+         _mm256_storeu_si256((__m256i*)(output + w),
+               pack_16bit_avx2(lo, hi));
       }
+
+      for (; w < width; w++)
+         output[w] = px_argb8888_rgb565(input[w]);
    }
 }
-#else
-void conv_rgb565_argb8888(void *output_, const void *input_,
-      int width, int height,
+
+static TARGET_AVX2 void conv_argb8888_bgr24_avx2(void *output_,
+      const void *input_, int width, int height,
       int out_stride, int in_stride)
 {
    int h, w;
-   const uint16_t *input = (const uint16_t*)input_;
-   uint32_t *output      = (uint32_t*)output_;
+   const uint32_t *input = (const uint32_t*)input_;
+   uint8_t *output       = (uint8_t*)output_;
 
    for (h = 0; h < height;
-         h++, output += out_stride >> 2, input += in_stride >> 1)
+         h++, output += out_stride, input += in_stride >> 2)
    {
-      for (w = 0; w < width; w++)
-      {
-         uint32_t col = input[w];
-         uint32_t r = (col >> 11) & 0x1f;
-         uint32_t g = (col >>  5) & 0x3f;
-         uint32_t b = (col >>  0) & 0x1f;
-         r = (r << 3) | (r >> 2);
-         g = (g << 2) | (g >> 4);
-         b = (b << 3) | (b >> 2);
+      uint8_t *out = output;
 
-         output[w] = (0xffu << 24) | (r << 16) | (g << 8) | (b << 0);
-      }
+      for (w = 0; w + 8 <= width; w += 8, out += 24)
+         store_bgr24_avx2(out,
+               _mm256_loadu_si256((const __m256i*)(input + w)));
+
+      for (; w < width; w++, out += 3)
+         px_store_bgr24(out, input[w]);
    }
 }
-#endif
 
-void conv_rgba4444_argb8888(void *output_, const void *input_,
-      int width, int height,
+static TARGET_AVX2 void conv_argb8888_abgr8888_avx2(void *output_,
+      const void *input_, int width, int height,
       int out_stride, int in_stride)
 {
    int h, w;
-   const uint16_t *input = (const uint16_t*)input_;
+   const uint32_t *input = (const uint32_t*)input_;
    uint32_t *output      = (uint32_t*)output_;
 
+   const __m256i shuf = _mm256_setr_epi8(
+         2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15,
+         2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15);
+
    for (h = 0; h < height;
-         h++, output += out_stride >> 2, input += in_stride >> 1)
+         h++, output += out_stride >> 2, input += in_stride >> 2)
    {
-      for (w = 0; w < width; w++)
+      for (w = 0; w + 8 <= width; w += 8)
+         _mm256_storeu_si256((__m256i*)(output + w), _mm256_shuffle_epi8(
+                  _mm256_loadu_si256((const __m256i*)(input + w)), shuf));
+
+      for (; w < width; w++)
+         output[w] = px_argb8888_abgr8888(input[w]);
+   }
+}
+
+static TARGET_AVX2 void conv_yuyv_argb8888_avx2(void *output_,
+      const void *input_, int width, int height,
+      int out_stride, int in_stride)
+{
+   int h, w;
+   const uint8_t *input = (const uint8_t*)input_;
+   uint32_t *output     = (uint32_t*)output_;
+
+   const __m256i mask_y = _mm256_set1_epi16(0xffu);
+   const __m256i mask_u = _mm256_set1_epi32(0xffu << 8);
+   const __m256i mask_v = _mm256_set1_epi32(0xffu << 24);
+   const __m256i chroma_offset = _mm256_set1_epi16(128);
+   const __m256i round_offset = _mm256_set1_epi16(YUV_OFFSET);
+
+   const __m256i yuv_mul = _mm256_set1_epi16(YUV_MAT_Y);
+   const __m256i u_g_mul = _mm256_set1_epi16(YUV_MAT_U_G);
+   const __m256i u_b_mul = _mm256_set1_epi16(YUV_MAT_U_B);
+   const __m256i v_r_mul = _mm256_set1_epi16(YUV_MAT_V_R);
+   const __m256i v_g_mul = _mm256_set1_epi16(YUV_MAT_V_G);
+   const __m256i a       = _mm256_set1_epi16(-1);
+
+   for (h = 0; h < height; h++, output += out_stride >> 2, input += in_stride)
+   {
+      const uint8_t *src = input;
+      uint32_t *dst = output;
+
+      /* Each loop processes 32 pixels. Lanes of y0 hold pixels 0-7 and
+       * 8-15, y1 16-23 and 24-31. The per-lane chroma pack and unpack
+       * below end up in the same order, so only the output is permuted. */
+      for (w = 0; w + 32 <= width; w += 32, src += 64, dst += 32)
       {
-         uint32_t col = input[w];
-         uint32_t r = (col >> 12) & 0xf;
-         uint32_t g = (col >>  8) & 0xf;
-         uint32_t b = (col >>  4) & 0xf;
-         uint32_t a = (col >>  0) & 0xf;
-         r = (r << 4) | r;
-         g = (g << 4) | g;
-         b = (b << 4) | b;
-         a = (a << 4) | a;
+         __m256i yuv0 = _mm256_loadu_si256((const __m256i*)(src +  0));
+         __m256i yuv1 = _mm256_loadu_si256((const __m256i*)(src + 32));
+
+         __m256i y0 = _mm256_and_si256(yuv0, mask_y);
+         __m256i u0 = _mm256_srli_si256(_mm256_and_si256(yuv0, mask_u), 1);
+         __m256i v0 = _mm256_srli_si256(_mm256_and_si256(yuv0, mask_v), 3);
+         __m256i y1 = _mm256_and_si256(yuv1, mask_y);
+         __m256i u1 = _mm256_srli_si256(_mm256_and_si256(yuv1, mask_u), 1);
+         __m256i v1 = _mm256_srli_si256(_mm256_and_si256(yuv1, mask_v), 3);
+
+         __m256i u = _mm256_sub_epi16(_mm256_packs_epi32(u0, u1),
+               chroma_offset);
+         __m256i v = _mm256_sub_epi16(_mm256_packs_epi32(v0, v1),
+               chroma_offset);
+
+         u0 = _mm256_unpacklo_epi16(u, u);
+         u1 = _mm256_unpackhi_epi16(u, u);
+         v0 = _mm256_unpacklo_epi16(v, v);
+         v1 = _mm256_unpackhi_epi16(v, v);
+
+         y0 = _mm256_mullo_epi16(y0, yuv_mul);
+         y1 = _mm256_mullo_epi16(y1, yuv_mul);
+
+         __m256i r0 = _mm256_srai_epi16(_mm256_adds_epi16(_mm256_adds_epi16(
+                     y0, _mm256_mullo_epi16(v0, v_r_mul)),
+                  round_offset), YUV_SHIFT);
+         __m256i g0 = _mm256_srai_epi16(_mm256_adds_epi16(_mm256_adds_epi16(
+                     _mm256_adds_epi16(y0, _mm256_mullo_epi16(v0, v_g_mul)),
+                     _mm256_mullo_epi16(u0, u_g_mul)),
+                  round_offset), YUV_SHIFT);
+         __m256i b0 = _mm256_srai_epi16(_mm256_adds_epi16(_mm256_adds_epi16(
+                     y0, _mm256_mullo_epi16(u0, u_b_mul)),
+                  round_offset), YUV_SHIFT);
+
+         __m256i r1 = _mm256_srai_epi16(_mm256_adds_epi16(_mm256_adds_epi16(
+                     y1, _mm256_mullo_epi16(v1, v_r_mul)),
+                  round_offset), YUV_SHIFT);
+         __m256i g1 = _mm256_srai_epi16(_mm256_adds_epi16(_mm256_adds_epi16(
+                     _mm256_adds_epi16(y1, _mm256_mullo_epi16(v1, v_g_mul)),
+                     _mm256_mullo_epi16(u1, u_g_mul)),
+                  round_offset), YUV_SHIFT);
+         __m256i b1 = _mm256_srai_epi16(_mm256_adds_epi16(_mm256_adds_epi16(
+                     y1, _mm256_mullo_epi16(u1, u_b_mul)),
+                  round_offset), YUV_SHIFT);
 
-         output[w] = (a << 24) | (r << 16) | (g << 8) | (b << 0);
+         r0 = _mm256_packus_epi16(r0, r1);
+         g0 = _mm256_packus_epi16(g0, g1);
+         b0 = _mm256_packus_epi16(b0, b1);
+
+         __m256i res_lo_bg = _mm256_unpacklo_epi8(b0, g0);
+         __m256i res_hi_bg = _mm256_unpackhi_epi8(b0, g0);
+         __m256i res_lo_ra = _mm256_unpacklo_epi8(r0, a);
+         __m256i res_hi_ra = _mm256_unpackhi_epi8(r0, a);
+         __m256i res0 = _mm256_unpacklo_epi16(res_lo_bg, res_lo_ra);
+         __m256i res1 = _mm256_unpackhi_epi16(res_lo_bg, res_lo_ra);
+         __m256i res2 = _mm256_unpacklo_epi16(res_hi_bg, res_hi_ra);
+         __m256i res3 = _mm256_unpackhi_epi16(res_hi_bg, res_hi_ra);
+
+         _mm256_storeu_si256((__m256i*)(dst +  0),
+               _mm256_permute2x128_si256(res0, res1, 0x20));
+         _mm256_storeu_si256((__m256i*)(dst +  8),
+               _mm256_permute2x128_si256(res0, res1, 0x31));
+         _mm256_storeu_si256((__m256i*)(dst + 16),
+               _mm256_permute2x128_si256(res2, res3, 0x20));
+         _mm256_storeu_si256((__m256i*)(dst + 24),
+               _mm256_permute2x128_si256(res2, res3, 0x31));
       }
+
+      for (; w < width; w += 2, src += 4, dst += 2)
+         px_yuyv_argb8888(dst, src);
    }
 }
+#endif
 
-#if defined(__SSE2__)
-/* :( TODO: Make this saner. */
-static inline void store_bgr24_sse2(void *output, __m128i a,
-      __m128i b, __m128i c, __m128i d)
+#ifdef PIXCONV_NEON
+/* NEON versions. The structured loads and stores (de)interleave
+ * channels for free, so these work on 8 pixels per plane. */
+
+static inline uint8x8_t expand5_neon(uint8x8_t x)
 {
-   const __m128i mask_0 = _mm_set_epi32(0, 0, 0, 0x00ffffff);
-   const __m128i mask_1 = _mm_set_epi32(0, 0, 0x00ffffff, 0);
-   const __m128i mask_2 = _mm_set_epi32(0, 0x00ffffff, 0, 0);
-   const __m128i mask_3 = _mm_set_epi32(0x00ffffff, 0, 0, 0);
+   return vorr_u8(vshl_n_u8(x, 3), vshr_n_u8(x, 2));
+}
 
-   __m128i a0 = _mm_and_si128(a, mask_0);
-   __m128i a1 = _mm_srli_si128(_mm_and_si128(a, mask_1),  1);
-   __m128i a2 = _mm_srli_si128(_mm_and_si128(a, mask_2),  2);
-   __m128i a3 = _mm_srli_si128(_mm_and_si128(a, mask_3),  3);
-   __m128i a4 = _mm_slli_si128(_mm_and_si128(b, mask_0), 12);
-   __m128i a5 = _mm_slli_si128(_mm_and_si128(b, mask_1), 11);
+static inline uint8x8_t expand6_neon(uint8x8_t x)
+{
+   return vorr_u8(vshl_n_u8(x, 2), vshr_n_u8(x, 4));
+}
 
-   __m128i b0 = _mm_srli_si128(_mm_and_si128(b, mask_1), 5);
-   __m128i b1 = _mm_srli_si128(_mm_and_si128(b, mask_2), 6);
-   __m128i b2 = _mm_srli_si128(_mm_and_si128(b, mask_3), 7);
-   __m128i b3 = _mm_slli_si128(_mm_and_si128(c, mask_0), 8);
-   __m128i b4 = _mm_slli_si128(_mm_and_si128(c, mask_1), 7);
-   __m128i b5 = _mm_slli_si128(_mm_and_si128(c, mask_2), 6);
+static inline uint8x8_t expand4_neon(uint8x8_t x)
+{
+   return vorr_u8(vshl_n_u8(x, 4), x);
+}
 
-   __m128i c0 = _mm_srli_si128(_mm_and_si128(c, mask_2), 10);
-   __m128i c1 = _mm_srli_si128(_mm_and_si128(c, mask_3), 11);
-   __m128i c2 = _mm_slli_si128(_mm_and_si128(d, mask_0),  4);
-   __m128i c3 = _mm_slli_si128(_mm_and_si128(d, mask_1),  3);
-   __m128i c4 = _mm_slli_si128(_mm_and_si128(d, mask_2),  2);
-   __m128i c5 = _mm_slli_si128(_mm_and_si128(d, mask_3),  1);
+static inline uint8x8x4_t expand_0rgb1555_neon(uint16x8_t in)
+{
+   const uint8x8_t mask5 = vdup_n_u8(0x1f);
+   uint8x8x4_t res;
+   res.val[0] = expand5_neon(vand_u8(vmovn_u16(in), mask5));
+   res.val[1] = expand5_neon(vand_u8(vmovn_u16(vshrq_n_u16(in, 5)), mask5));
+   res.val[2] = expand5_neon(vand_u8(vmovn_u16(vshrq_n_u16(in, 10)), mask5));
+   res.val[3] = vdup_n_u8(0xff);
+   return res;
+}
 
-   __m128i *out = (__m128i*)output;
+static inline uint8x8x4_t expand_rgb565_neon(uint16x8_t in)
+{
+   uint8x8x4_t res;
+   res.val[0] = expand5_neon(vand_u8(vmovn_u16(in), vdup_n_u8(0x1f)));
+   res.val[1] = expand6_neon(vand_u8(vmovn_u16(vshrq_n_u16(in, 5)),
+            vdup_n_u8(0x3f)));
+   res.val[2] = expand5_neon(vmovn_u16(vshrq_n_u16(in, 11)));
+   res.val[3] = vdup_n_u8(0xff);
+   return res;
+}
+
+static inline uint8x8x3_t drop_alpha_neon(uint8x8x4_t in)
+{
+   uint8x8x3_t res;
+   res.val[0] = in.val[0];
+   res.val[1] = in.val[1];
+   res.val[2] = in.val[2];
+   return res;
+}
+
+static void conv_rgb565_0rgb1555_neon(void *output_, const void *input_,
+      int width, int height,
+      int out_stride, int in_stride)
+{
+   int h, w;
+   const uint16_t *input = (const uint16_t*)input_;
+   uint16_t *output = (uint16_t*)output_;
 
-   _mm_storeu_si128(out + 0,
-         _mm_or_si128(a0, _mm_or_si128(a1, _mm_or_si128(a2,
-                  _mm_or_si128(a3, _mm_or_si128(a4, a5))))));
+   const uint16x8_t hi_mask = vdupq_n_u16(0x7fe0);
+   const uint16x8_t lo_mask = vdupq_n_u16(0x1f);
 
-   _mm_storeu_si128(out + 1,
-         _mm_or_si128(b0, _mm_or_si128(b1, _mm_or_si128(b2,
-                  _mm_or_si128(b3, _mm_or_si128(b4, b5))))));
+   for (h = 0; h < height;
+         h++, output += out_stride >> 1, input += in_stride >> 1)
+   {
+      for (w = 0; w + 8 <= width; w += 8)
+      {
+         uint16x8_t in = vld1q_u16(input + w);
+         vst1q_u16(output + w, vorrq_u16(
+                  vandq_u16(vshrq_n_u16(in, 1), hi_mask),
+                  vandq_u16(in, lo_mask)));
+      }
 
-   _mm_storeu_si128(out + 2,
-         _mm_or_si128(c0, _mm_or_si128(c1, _mm_or_si128(c2,
-                  _mm_or_si128(c3, _mm_or_si128(c4, c5))))));
+      for (; w < width; w++)
+         output[w] = px_rgb565_0rgb1555(input[w]);
+   }
 }
 
-void conv_0rgb1555_bgr24(void *output_, const void *input_,
+static void conv_0rgb1555_rgb565_neon(void *output_, const void *input_,
       int width, int height,
       int out_stride, int in_stride)
 {
    int h, w;
    const uint16_t *input = (const uint16_t*)input_;
-   uint8_t *output       = (uint8_t*)output_;
-
-   const __m128i pix_mask_r  = _mm_set1_epi16(0x1f << 10);
-   const __m128i pix_mask_gb = _mm_set1_epi16(0x1f <<  5);
-   const __m128i mul15_mid   = _mm_set1_epi16(0x4200);
-   const __m128i mul15_hi    = _mm_set1_epi16(0x0210);
-   const __m128i a           = _mm_set1_epi16(0x00ff);
+   uint16_t *output = (uint16_t*)output_;
 
-   int max_width = width - 15;
+   const uint16x8_t hi_mask   = vdupq_n_u16((0x1f << 11) | (0x1f << 6));
+   const uint16x8_t lo_mask   = vdupq_n_u16(0x1f);
+   const uint16x8_t glow_mask = vdupq_n_u16(1 << 5);
 
    for (h = 0; h < height;
-         h++, output += out_stride, input += in_stride >> 1)
+         h++, output += out_stride >> 1, input += in_stride >> 1)
    {
-      uint8_t *out = output;
-
-      for (w = 0; w < max_width; w += 16, out += 48)
-      {
-         const __m128i in0 = _mm_loadu_si128((const __m128i*)(input + w + 0));
-         const __m128i in1 = _mm_loadu_si128((const __m128i*)(input + w + 8));
-         __m128i r0 = _mm_and_si128(in0, pix_mask_r);
-         __m128i r1 = _mm_and_si128(in1, pix_mask_r);
-         __m128i g0 = _mm_and_si128(in0, pix_mask_gb);
-         __m128i g1 = _mm_and_si128(in1, pix_mask_gb);
-         __m128i b0 = _mm_and_si128(_mm_slli_epi16(in0, 5), pix_mask_gb);
-         __m128i b1 = _mm_and_si128(_mm_slli_epi16(in1, 5), pix_mask_gb);
-
-         r0 = _mm_mulhi_epi16(r0, mul15_hi);
-         r1 = _mm_mulhi_epi16(r1, mul15_hi);
-         g0 = _mm_mulhi_epi16(g0, mul15_mid);
-         g1 = _mm_mulhi_epi16(g1, mul15_mid);
-         b0 = _mm_mulhi_epi16(b0, mul15_mid);
-         b1 = _mm_mulhi_epi16(b1, mul15_mid);
-
-         __m128i res_lo_bg0 = _mm_unpacklo_epi8(b0, g0);
-         __m128i res_lo_bg1 = _mm_unpacklo_epi8(b1, g1);
-         __m128i res_hi_bg0 = _mm_unpackhi_epi8(b0, g0);
-         __m128i res_hi_bg1 = _mm_unpackhi_epi8(b1, g1);
-         __m128i res_lo_ra0 = _mm_unpacklo_epi8(r0, a);
-         __m128i res_lo_ra1 = _mm_unpacklo_epi8(r1, a);
-         __m128i res_hi_ra0 = _mm_unpackhi_epi8(r0, a);
-         __m128i res_hi_ra1 = _mm_unpackhi_epi8(r1, a);
-
-         __m128i res_lo0 = _mm_or_si128(res_lo_bg0,
-               _mm_slli_si128(res_lo_ra0, 2));
-         __m128i res_lo1 = _mm_or_si128(res_lo_bg1,
-               _mm_slli_si128(res_lo_ra1, 2));
-         __m128i res_hi0 = _mm_or_si128(res_hi_bg0,
-               _mm_slli_si128(res_hi_ra0, 2));
-         __m128i res_hi1 = _mm_or_si128(res_hi_bg1,
-               _mm_slli_si128(res_hi_ra1, 2));
-
-         /* Non-POT pixel sizes ftl :( */
-         store_bgr24_sse2(out, res_lo0, res_hi0, res_lo1, res_hi1);
+      for (w = 0; w + 8 <= width; w += 8)
+      {
+         uint16x8_t in   = vld1q_u16(input + w);
+         uint16x8_t rg   = vandq_u16(vshlq_n_u16(in, 1), hi_mask);
+         uint16x8_t b    = vandq_u16(in, lo_mask);
+         uint16x8_t glow = vandq_u16(vshrq_n_u16(in, 4), glow_mask);
+         vst1q_u16(output + w, vorrq_u16(rg, vorrq_u16(b, glow)));
       }
 
       for (; w < width; w++)
-      {
-         uint32_t col = input[w];
-         uint32_t b = (col >>  0) & 0x1f;
-         uint32_t g = (col >>  5) & 0x1f;
-         uint32_t r = (col >> 10) & 0x1f;
-         b = (b << 3) | (b >> 2);
-         g = (g << 3) | (g >> 2);
-         r = (r << 3) | (r >> 2);
-
-         *out++ = b;
-         *out++ = g;
-         *out++ = r;
-      }
+         output[w] = px_0rgb1555_rgb565(input[w]);
    }
 }
 
-void conv_rgb565_bgr24(void *output_, const void *input_,
+static void conv_0rgb1555_argb8888_neon(void *output_, const void *input_,
       int width, int height,
       int out_stride, int in_stride)
 {
    int h, w;
    const uint16_t *input = (const uint16_t*)input_;
-   uint8_t *output      = (uint8_t*)output_;
+   uint32_t *output      = (uint32_t*)output_;
 
-   const __m128i pix_mask_r = _mm_set1_epi16(0x1f << 10);
-   const __m128i pix_mask_g = _mm_set1_epi16(0x3f <<  5);
-   const __m128i pix_mask_b = _mm_set1_epi16(0x1f <<  5);
-   const __m128i mul16_r    = _mm_set1_epi16(0x0210);
-   const __m128i mul16_g    = _mm_set1_epi16(0x2080);
-   const __m128i mul16_b    = _mm_set1_epi16(0x4200);
-   const __m128i a          = _mm_set1_epi16(0x00ff);
+   for (h = 0; h < height;
+         h++, output += out_stride >> 2, input += in_stride >> 1)
+   {
+      for (w = 0; w + 8 <= width; w += 8)
+         vst4_u8((uint8_t*)(output + w),
+               expand_0rgb1555_neon(vld1q_u16(input + w)));
+
+      for (; w < width; w++)
+         output[w] = px_0rgb1555_argb8888(input[w]);
+   }
+}
 
-   int max_width = width - 15;
+static void conv_rgb565_argb8888_neon(void *output_, const void *input_,
+      int width, int height,
+      int out_stride, int in_stride)
+{
+   int h, w;
+   const uint16_t *input = (const uint16_t*)input_;
+   uint32_t *output      = (uint32_t*)output_;
 
-   for (h = 0; h < height; h++, output += out_stride, input += in_stride >> 1)
+   for (h = 0; h < height;
+         h++, output += out_stride >> 2, input += in_stride >> 1)
    {
-      uint8_t *out = output;
+      for (w = 0; w + 8 <= width; w += 8)
+         vst4_u8((uint8_t*)(output + w),
+               expand_rgb565_neon(vld1q_u16(input + w)));
 
-      for (w = 0; w < max_width; w += 16, out += 48)
-      {
-         const __m128i in0 = _mm_loadu_si128((const __m128i*)(input + w));
-         const __m128i in1 = _mm_loadu_si128((const __m128i*)(input + w + 8));
-         __m128i r0 = _mm_and_si128(_mm_srli_epi16(in0, 1), pix_mask_r);
-         __m128i g0 = _mm_and_si128(in0, pix_mask_g);
-         __m128i b0 = _mm_and_si128(_mm_slli_epi16(in0, 5), pix_mask_b);
-         __m128i r1 = _mm_and_si128(_mm_srli_epi16(in1, 1), pix_mask_r);
-         __m128i g1 = _mm_and_si128(in1, pix_mask_g);
-         __m128i b1 = _mm_and_si128(_mm_slli_epi16(in1, 5), pix_mask_b);
-
-         r0 = _mm_mulhi_epi16(r0, mul16_r);
-         g0 = _mm_mulhi_epi16(g0, mul16_g);
-         b0 = _mm_mulhi_epi16(b0, mul16_b);
-         r1 = _mm_mulhi_epi16(r1, mul16_r);
-         g1 = _mm_mulhi_epi16(g1, mul16_g);
-         b1 = _mm_mulhi_epi16(b1, mul16_b);
-
-         __m128i res_lo_bg0 = _mm_unpacklo_epi8(b0, g0);
-         __m128i res_hi_bg0 = _mm_unpackhi_epi8(b0, g0);
-         __m128i res_lo_ra0 = _mm_unpacklo_epi8(r0, a);
-         __m128i res_hi_ra0 = _mm_unpackhi_epi8(r0, a);
-         __m128i res_lo_bg1 = _mm_unpacklo_epi8(b1, g1);
-         __m128i res_hi_bg1 = _mm_unpackhi_epi8(b1, g1);
-         __m128i res_lo_ra1 = _mm_unpacklo_epi8(r1, a);
-         __m128i res_hi_ra1 = _mm_unpackhi_epi8(r1, a);
-
-         __m128i res_lo0 = _mm_or_si128(res_lo_bg0,
-               _mm_slli_si128(res_lo_ra0, 2));
-         __m128i res_hi0 = _mm_or_si128(res_hi_bg0,
-               _mm_slli_si128(res_hi_ra0, 2));
-         __m128i res_lo1 = _mm_or_si128(res_lo_bg1,
-               _mm_slli_si128(res_lo_ra1, 2));
-         __m128i res_hi1 = _mm_or_si128(res_hi_bg1,
-               _mm_slli_si128(res_hi_ra1, 2));
+      for (; w < width; w++)
+         output[w] = px_rgb565_argb8888(input[w]);
+   }
+}
 
-         store_bgr24_sse2(out, res_lo0, res_hi0, res_lo1, res_hi1);
-      }
+static void conv_rgba4444_argb8888_neon(void *output_, const void *input_,
+      int width, int height,
+      int out_stride, int in_stride)
+{
+   int h, w;
+   const uint16_t *input = (const uint16_t*)input_;
+   uint32_t *output      = (uint32_t*)output_;
 
-      for (; w < width; w++)
-      {
-         uint32_t col = input[w];
-         uint32_t r = (col >> 11) & 0x1f;
-         uint32_t g = (col >>  5) & 0x3f;
-         uint32_t b = (col >>  0) & 0x1f;
-         r = (r << 3) | (r >> 2);
-         g = (g << 2) | (g >> 4);
-         b = (b << 3) | (b >> 2);
+   const uint8x8_t mask4 = vdup_n_u8(0xf);
 
-         *out++ = b;
-         *out++ = g;
-         *out++ = r;
+   for (h = 0; h < height;
+         h++, output += out_stride >> 2, input += in_stride >> 1)
+   {
+      for (w = 0; w + 8 <= width; w += 8)
+      {
+         uint16x8_t in = vld1q_u16(input + w);
+         uint8x8x4_t res;
+         res.val[0] = expand4_neon(vand_u8(vmovn_u16(vshrq_n_u16(in, 4)), mask4));
+         res.val[1] = expand4_neon(vand_u8(vmovn_u16(vshrq_n_u16(in, 8)), mask4));
+         res.val[2] = expand4_neon(vmovn_u16(vshrq_n_u16(in, 12)));
+         res.val[3] = expand4_neon(vand_u8(vmovn_u16(in), mask4));
+         vst4_u8((uint8_t*)(output + w), res);
       }
+
+      for (; w < width; w++)
+         output[w] = px_rgba4444_argb8888(input[w]);
    }
 }
-#else
-void conv_0rgb1555_bgr24(void *output_, const void *input_,
+
+static void conv_0rgb1555_bgr24_neon(void *output_, const void *input_,
       int width, int height,
       int out_stride, int in_stride)
 {
@@ -566,24 +1717,17 @@ void conv_0rgb1555_bgr24(void *output_, const void *input_,
          h++, output += out_stride, input += in_stride >> 1)
    {
       uint8_t *out = output;
-      for (w = 0; w < width; w++)
-      {
-         uint32_t col = input[w];
-         uint32_t b = (col >>  0) & 0x1f;
-         uint32_t g = (col >>  5) & 0x1f;
-         uint32_t r = (col >> 10) & 0x1f;
-         b = (b << 3) | (b >> 2);
-         g = (g << 3) | (g >> 2);
-         r = (r << 3) | (r >> 2);
 
-         *out++ = b;
-         *out++ = g;
-         *out++ = r;
-      }
+      for (w = 0; w + 8 <= width; w += 8, out += 24)
+         vst3_u8(out, drop_alpha_neon(
+                  expand_0rgb1555_neon(vld1q_u16(input + w))));
+
+      for (; w < width; w++, out += 3)
+         px_store_bgr24(out, px_0rgb1555_argb8888(input[w]));
    }
 }
 
-void conv_rgb565_bgr24(void *output_, const void *input_,
+static void conv_rgb565_bgr24_neon(void *output_, const void *input_,
       int width, int height,
       int out_stride, int in_stride)
 {
@@ -595,25 +1739,17 @@ void conv_rgb565_bgr24(void *output_, const void *input_,
          h++, output += out_stride, input += in_stride >> 1)
    {
       uint8_t *out = output;
-      for (w = 0; w < width; w++)
-      {
-         uint32_t col = input[w];
-         uint32_t b = (col >>  0) & 0x1f;
-         uint32_t g = (col >>  5) & 0x3f;
-         uint32_t r = (col >> 11) & 0x1f;
-         b = (b << 3) | (b >> 2);
-         g = (g << 2) | (g >> 4);
-         r = (r << 3) | (r >> 2);
 
-         *out++ = b;
-         *out++ = g;
-         *out++ = r;
-      }
+      for (w = 0; w + 8 <= width; w += 8, out += 24)
+         vst3_u8(out, drop_alpha_neon(
+                  expand_rgb565_neon(vld1q_u16(input + w))));
+
+      for (; w < width; w++, out += 3)
+         px_store_bgr24(out, px_rgb565_argb8888(input[w]));
    }
 }
-#endif
 
-void conv_bgr24_argb8888(void *output_, const void *input_,
+static void conv_bgr24_argb8888_neon(void *output_, const void *input_,
       int width, int height,
       int out_stride, int in_stride)
 {
@@ -625,17 +1761,25 @@ void conv_bgr24_argb8888(void *output_, const void *input_,
          h++, output += out_stride >> 2, input += in_stride)
    {
       const uint8_t *inp = input;
-      for (w = 0; w < width; w++)
+
+      for (w = 0; w + 8 <= width; w += 8, inp += 24)
       {
-         uint32_t b = *inp++;
-         uint32_t g = *inp++;
-         uint32_t r = *inp++;
-         output[w] = (0xffu << 24) | (r << 16) | (g << 8) | (b << 0);
+         uint8x8x3_t in = vld3_u8(inp);
+         uint8x8x4_t res;
+         res.val[0] = in.val[0];
+         res.val[1] = in.val[1];
+         res.val[2] = in.val[2];
+         res.val[3] = vdup_n_u8(0xff);
+         vst4_u8((uint8_t*)(output + w), res);
       }
+
+      for (; w < width; w++, inp += 3)
+         output[w] = 0xff000000u |
+            (inp[2] << 16) | (inp[1] << 8) | (inp[0] << 0);
    }
 }
 
-void conv_argb8888_0rgb1555(void *output_, const void *input_,
+static void conv_argb8888_0rgb1555_neon(void *output_, const void *input_,
       int width, int height,
       int out_stride, int in_stride)
 {
@@ -646,53 +1790,46 @@ void conv_argb8888_0rgb1555(void *output_, const void *input_,
    for (h = 0; h < height;
          h++, output += out_stride >> 1, input += in_stride >> 2)
    {
-      for (w = 0; w < width; w++)
+      for (w = 0; w + 8 <= width; w += 8)
       {
-         uint32_t col = input[w];
-         uint16_t r = (col >> 19) & 0x1f;
-         uint16_t g = (col >> 11) & 0x1f;
-         uint16_t b = (col >>  3) & 0x1f;
-         output[w] = (r << 10) | (g << 5) | (b << 0);
+         uint8x8x4_t in = vld4_u8((const uint8_t*)(input + w));
+         uint16x8_t r = vshlq_n_u16(vmovl_u8(vshr_n_u8(in.val[2], 3)), 10);
+         uint16x8_t g = vshlq_n_u16(vmovl_u8(vshr_n_u8(in.val[1], 3)), 5);
+         uint16x8_t b = vmovl_u8(vshr_n_u8(in.val[0], 3));
+         vst1q_u16(output + w, vorrq_u16(r, vorrq_u16(g, b)));
       }
+
+      for (; w < width; w++)
+         output[w] = px_argb8888_0rgb1555(input[w]);
    }
 }
 
-#if defined(__SSE2__)
-void conv_argb8888_bgr24(void *output_, const void *input_,
+static void conv_argb8888_rgb565_neon(void *output_, const void *input_,
       int width, int height,
       int out_stride, int in_stride)
 {
    int h, w;
    const uint32_t *input = (const uint32_t*)input_;
-   uint8_t *output       = (uint8_t*)output_;
-
-   int max_width = width - 15;
+   uint16_t *output      = (uint16_t*)output_;
 
    for (h = 0; h < height;
-         h++, output += out_stride, input += in_stride >> 2)
+         h++, output += out_stride >> 1, input += in_stride >> 2)
    {
-      uint8_t *out = output;
-
-      for (w = 0; w < max_width; w += 16, out += 48)
+      for (w = 0; w + 8 <= width; w += 8)
       {
-         store_bgr24_sse2(out,
-               _mm_loadu_si128((const __m128i*)(input + w +  0)),
-               _mm_loadu_si128((const __m128i*)(input + w +  4)),
-               _mm_loadu_si128((const __m128i*)(input + w +  8)),
-               _mm_loadu_si128((const __m128i*)(input + w + 12)));
+         uint8x8x4_t in = vld4_u8((const uint8_t*)(input + w));
+         uint16x8_t r = vshlq_n_u16(vmovl_u8(vshr_n_u8(in.val[2], 3)), 11);
+         uint16x8_t g = vshlq_n_u16(vmovl_u8(vshr_n_u8(in.val[1], 2)), 5);
+         uint16x8_t b = vmovl_u8(vshr_n_u8(in.val[0], 3));
+         vst1q_u16(output + w, vorrq_u16(r, vorrq_u16(g, b)));
       }
 
       for (; w < width; w++)
-      {
-         uint32_t col = input[w];
-         *out++ = (uint8_t)(col >>  0);
-         *out++ = (uint8_t)(col >>  8);
-         *out++ = (uint8_t)(col >> 16);
-      }
+         output[w] = px_argb8888_rgb565(input[w]);
    }
 }
-#else
-void conv_argb8888_bgr24(void *output_, const void *input_,
+
+static void conv_argb8888_bgr24_neon(void *output_, const void *input_,
       int width, int height,
       int out_stride, int in_stride)
 {
@@ -704,18 +1841,17 @@ void conv_argb8888_bgr24(void *output_, const void *input_,
          h++, output += out_stride, input += in_stride >> 2)
    {
       uint8_t *out = output;
-      for (w = 0; w < width; w++)
-      {
-         uint32_t col = input[w];
-         *out++ = (uint8_t)(col >>  0);
-         *out++ = (uint8_t)(col >>  8);
-         *out++ = (uint8_t)(col >> 16);
-      }
+
+      for (w = 0; w + 8 <= width; w += 8, out += 24)
+         vst3_u8(out, drop_alpha_neon(
+                  vld4_u8((const uint8_t*)(input + w))));
+
+      for (; w < width; w++, out += 3)
+         px_store_bgr24(out, input[w]);
    }
 }
-#endif
 
-void conv_argb8888_abgr8888(void *output_, const void *input_,
+static void conv_argb8888_abgr8888_neon(void *output_, const void *input_,
       int width, int height,
       int out_stride, int in_stride)
 {
@@ -726,24 +1862,21 @@ void conv_argb8888_abgr8888(void *output_, const void *input_,
    for (h = 0; h < height;
          h++, output += out_stride >> 2, input += in_stride >> 2)
    {
-      for (w = 0; w < width; w++)
+      for (w = 0; w + 8 <= width; w += 8)
       {
-         uint32_t col = input[w];
-         output[w] = ((col << 16) & 0xff0000) | 
-            ((col >> 16) & 0xff) | (col & 0xff00ff00);
+         uint8x8x4_t in = vld4_u8((const uint8_t*)(input + w));
+         uint8x8_t tmp  = in.val[0];
+         in.val[0]      = in.val[2];
+         in.val[2]      = tmp;
+         vst4_u8((uint8_t*)(output + w), in);
       }
+
+      for (; w < width; w++)
+         output[w] = px_argb8888_abgr8888(input[w]);
    }
 }
 
-#define YUV_SHIFT 6
-#define YUV_OFFSET (1 << (YUV_SHIFT - 1))
-#define YUV_MAT_Y (1 << 6)
-#define YUV_MAT_U_G (-22)
-#define YUV_MAT_U_B (113)
-#define YUV_MAT_V_R (90)
-#define YUV_MAT_V_G (-46)
-#if defined(__SSE2__)
-void conv_yuyv_argb8888(void *output_, const void *input_,
+static void conv_yuyv_argb8888_neon(void *output_, const void *input_,
       int width, int height,
       int out_stride, int in_stride)
 {
@@ -751,161 +1884,153 @@ void conv_yuyv_argb8888(void *output_, const void *input_,
    const uint8_t *input = (const uint8_t*)input_;
    uint32_t *output     = (uint32_t*)output_;
 
-   const __m128i mask_y = _mm_set1_epi16(0xffu);
-   const __m128i mask_u = _mm_set1_epi32(0xffu << 8);
-   const __m128i mask_v = _mm_set1_epi32(0xffu << 24);
-   const __m128i chroma_offset = _mm_set1_epi16(128);
-   const __m128i round_offset = _mm_set1_epi16(YUV_OFFSET);
-
-   const __m128i yuv_mul = _mm_set1_epi16(YUV_MAT_Y);
-   const __m128i u_g_mul = _mm_set1_epi16(YUV_MAT_U_G);
-   const __m128i u_b_mul = _mm_set1_epi16(YUV_MAT_U_B);
-   const __m128i v_r_mul = _mm_set1_epi16(YUV_MAT_V_R);
-   const __m128i v_g_mul = _mm_set1_epi16(YUV_MAT_V_G);
-   const __m128i a       = _mm_cmpeq_epi16(_mm_setzero_si128(),
-         _mm_setzero_si128());
+   const int16x8_t chroma_offset = vdupq_n_s16(128);
 
-   for (h = 0; h < height; h++, output += out_stride >> 2, input += in_stride)
+   for (h = 0; h < height;
+         h++, output += out_stride >> 2, input += in_stride)
    {
       const uint8_t *src = input;
       uint32_t *dst = output;
 
-      /* Each loop processes 16 pixels. */
+      /* Each loop processes 16 pixels, even and odd ones separately. */
       for (w = 0; w + 16 <= width; w += 16, src += 32, dst += 16)
       {
-         __m128i yuv0 = _mm_loadu_si128((const __m128i*)(src +  0)); /* [Y0, U0, Y1, V0, Y2, U1, Y3, V1, ...] */
-         __m128i yuv1 = _mm_loadu_si128((const __m128i*)(src + 16)); /* [Y0, U0, Y1, V0, Y2, U1, Y3, V1, ...] */
-
-         __m128i y0 = _mm_and_si128(yuv0, mask_y); /* [Y0, Y1, Y2, ...] (16-bit) */
-         __m128i u0 = _mm_and_si128(yuv0, mask_u); /* [0, U0, 0, 0, 0, U1, 0, 0, ...] */
-         __m128i v0 = _mm_and_si128(yuv0, mask_v); /* [0, 0, 0, V1, 0, , 0, V1, ...] */
-         __m128i y1 = _mm_and_si128(yuv1, mask_y); /* [Y0, Y1, Y2, ...] (16-bit) */
-         __m128i u1 = _mm_and_si128(yuv1, mask_u); /* [0, U0, 0, 0, 0, U1, 0, 0, ...] */
-         __m128i v1 = _mm_and_si128(yuv1, mask_v); /* [0, 0, 0, V1, 0, , 0, V1, ...] */
-
-         /* Juggle around to get U and V in the same 16-bit format as Y. */
-         u0 = _mm_srli_si128(u0, 1);
-         v0 = _mm_srli_si128(v0, 3);
-         u1 = _mm_srli_si128(u1, 1);
-         v1 = _mm_srli_si128(v1, 3);
-         __m128i u = _mm_packs_epi32(u0, u1);
-         __m128i v = _mm_packs_epi32(v0, v1);
-
-         /* Apply YUV offsets (U, V) -= (-128, -128). */
-         u = _mm_sub_epi16(u, chroma_offset);
-         v = _mm_sub_epi16(v, chroma_offset);
-
-         /* Upscale chroma horizontally (nearest). */
-         u0 = _mm_unpacklo_epi16(u, u);
-         u1 = _mm_unpackhi_epi16(u, u);
-         v0 = _mm_unpacklo_epi16(v, v);
-         v1 = _mm_unpackhi_epi16(v, v);
-
-         /* Apply transformations. */
-         y0 = _mm_mullo_epi16(y0, yuv_mul);
-         y1 = _mm_mullo_epi16(y1, yuv_mul);
-         __m128i u0_g   = _mm_mullo_epi16(u0, u_g_mul);
-         __m128i u1_g   = _mm_mullo_epi16(u1, u_g_mul);
-         __m128i u0_b   = _mm_mullo_epi16(u0, u_b_mul);
-         __m128i u1_b   = _mm_mullo_epi16(u1, u_b_mul);
-         __m128i v0_r   = _mm_mullo_epi16(v0, v_r_mul);
-         __m128i v1_r   = _mm_mullo_epi16(v1, v_r_mul);
-         __m128i v0_g   = _mm_mullo_epi16(v0, v_g_mul);
-         __m128i v1_g   = _mm_mullo_epi16(v1, v_g_mul);
-
-         /* Add contibutions from the transformed components. */
-         __m128i r0 = _mm_srai_epi16(_mm_adds_epi16(_mm_adds_epi16(y0, v0_r),
-                  round_offset), YUV_SHIFT);
-         __m128i g0 = _mm_srai_epi16(_mm_adds_epi16(
-                  _mm_adds_epi16(_mm_adds_epi16(y0, v0_g), u0_g), round_offset), YUV_SHIFT);
-         __m128i b0 = _mm_srai_epi16(_mm_adds_epi16(
-                  _mm_adds_epi16(y0, u0_b), round_offset), YUV_SHIFT);
-
-         __m128i r1 = _mm_srai_epi16(_mm_adds_epi16(
-                  _mm_adds_epi16(y1, v1_r), round_offset), YUV_SHIFT);
-         __m128i g1 = _mm_srai_epi16(_mm_adds_epi16(
-                  _mm_adds_epi16(_mm_adds_epi16(y1, v1_g), u1_g), round_offset), YUV_SHIFT);
-         __m128i b1 = _mm_srai_epi16(_mm_adds_epi16(
-                  _mm_adds_epi16(y1, u1_b), round_offset), YUV_SHIFT);
-
-         /* Saturate into 8-bit. */
-         r0 = _mm_packus_epi16(r0, r1);
-         g0 = _mm_packus_epi16(g0, g1);
-         b0 = _mm_packus_epi16(b0, b1);
-
-         /* Interleave into ARGB. */
-         __m128i res_lo_bg = _mm_unpacklo_epi8(b0, g0);
-         __m128i res_hi_bg = _mm_unpackhi_epi8(b0, g0);
-         __m128i res_lo_ra = _mm_unpacklo_epi8(r0, a);
-         __m128i res_hi_ra = _mm_unpackhi_epi8(r0, a);
-         __m128i res0 = _mm_unpacklo_epi16(res_lo_bg, res_lo_ra);
-         __m128i res1 = _mm_unpackhi_epi16(res_lo_bg, res_lo_ra);
-         __m128i res2 = _mm_unpacklo_epi16(res_hi_bg, res_hi_ra);
-         __m128i res3 = _mm_unpackhi_epi16(res_hi_bg, res_hi_ra);
-
-         _mm_storeu_si128((__m128i*)(dst +  0), res0);
-         _mm_storeu_si128((__m128i*)(dst +  4), res1);
-         _mm_storeu_si128((__m128i*)(dst +  8), res2);
-         _mm_storeu_si128((__m128i*)(dst + 12), res3);
+         uint8x8x4_t yuv = vld4_u8(src); /* [Y0, U, Y1, V] planes */
+         int16x8_t ye = vmulq_n_s16(vreinterpretq_s16_u16(
+                  vmovl_u8(yuv.val[0])), YUV_MAT_Y);
+         int16x8_t yo = vmulq_n_s16(vreinterpretq_s16_u16(
+                  vmovl_u8(yuv.val[2])), YUV_MAT_Y);
+         int16x8_t u  = vsubq_s16(vreinterpretq_s16_u16(
+                  vmovl_u8(yuv.val[1])), chroma_offset);
+         int16x8_t v  = vsubq_s16(vreinterpretq_s16_u16(
+                  vmovl_u8(yuv.val[3])), chroma_offset);
+
+         int16x8_t r = vmulq_n_s16(v, YUV_MAT_V_R);
+         int16x8_t g = vmlaq_n_s16(vmulq_n_s16(u, YUV_MAT_U_G),
+               v, YUV_MAT_V_G);
+         int16x8_t b = vmulq_n_s16(u, YUV_MAT_U_B);
+
+         /* The rounding shift adds YUV_OFFSET, and saturates like clamp_8bit. */
+         uint8x8x2_t rr = vzip_u8(
+               vqrshrun_n_s16(vaddq_s16(ye, r), YUV_SHIFT),
+               vqrshrun_n_s16(vaddq_s16(yo, r), YUV_SHIFT));
+         uint8x8x2_t gg = vzip_u8(
+               vqrshrun_n_s16(vaddq_s16(ye, g), YUV_SHIFT),
+               vqrshrun_n_s16(vaddq_s16(yo, g), YUV_SHIFT));
+         uint8x8x2_t bb = vzip_u8(
+               vqrshrun_n_s16(vaddq_s16(ye, b), YUV_SHIFT),
+               vqrshrun_n_s16(vaddq_s16(yo, b), YUV_SHIFT));
+
+         uint8x8x4_t res;
+         res.val[3] = vdup_n_u8(0xff);
+
+         res.val[0] = bb.val[0];
+         res.val[1] = gg.val[0];
+         res.val[2] = rr.val[0];
+         vst4_u8((uint8_t*)(dst + 0), res);
+
+         res.val[0] = bb.val[1];
+         res.val[1] = gg.val[1];
+         res.val[2] = rr.val[1];
+         vst4_u8((uint8_t*)(dst + 8), res);
       }
 
-      /* Finish off the rest (if any) in C. */
       for (; w < width; w += 2, src += 4, dst += 2)
-      {
-         int y0 = src[0];
-         int  u = src[1] - 128;
-         int y1 = src[2];
-         int  v = src[3] - 128;
-
-         uint8_t r0 = clamp_8bit((YUV_MAT_Y * y0 +                   YUV_MAT_V_R * v + YUV_OFFSET) >> YUV_SHIFT);
-         uint8_t g0 = clamp_8bit((YUV_MAT_Y * y0 + YUV_MAT_U_G * u + YUV_MAT_V_G * v + YUV_OFFSET) >> YUV_SHIFT);
-         uint8_t b0 = clamp_8bit((YUV_MAT_Y * y0 + YUV_MAT_U_B * u                   + YUV_OFFSET) >> YUV_SHIFT);
-
-         uint8_t r1 = clamp_8bit((YUV_MAT_Y * y1 +                   YUV_MAT_V_R * v + YUV_OFFSET) >> YUV_SHIFT);
-         uint8_t g1 = clamp_8bit((YUV_MAT_Y * y1 + YUV_MAT_U_G * u + YUV_MAT_V_G * v + YUV_OFFSET) >> YUV_SHIFT);
-         uint8_t b1 = clamp_8bit((YUV_MAT_Y * y1 + YUV_MAT_U_B * u                   + YUV_OFFSET) >> YUV_SHIFT);
-
-         dst[0] = 0xff000000u | (r0 << 16) | (g0 << 8) | (b0 << 0);
-         dst[1] = 0xff000000u | (r1 << 16) | (g1 << 8) | (b1 << 0);
-      }
+         px_yuyv_argb8888(dst, src);
    }
 }
-#else
-void conv_yuyv_argb8888(void *output_, const void *input_,
-      int width, int height,
-      int out_stride, int in_stride)
-{
-   int h, w;
-   const uint8_t *input = (const uint8_t*)input_;
-   uint32_t *output     = (uint32_t*)output_;
+#endif
 
-   for (h = 0; h < height;
-         h++, output += out_stride >> 2, input += in_stride)
+static struct
+{
+   conv_func_t rgb565_0rgb1555;
+   conv_func_t _0rgb1555_rgb565;
+   conv_func_t _0rgb1555_argb8888;
+   conv_func_t rgb565_argb8888;
+   conv_func_t rgba4444_argb8888;
+   conv_func_t _0rgb1555_bgr24;
+   conv_func_t rgb565_bgr24;
+   conv_func_t bgr24_argb8888;
+   conv_func_t argb8888_0rgb1555;
+   conv_func_t argb8888_rgb565;
+   conv_func_t argb8888_bgr24;
+   conv_func_t argb8888_abgr8888;
+   conv_func_t yuyv_argb8888;
+   bool init;
+} conv_impl;
+
+#define CONV_SET(suffix) do { \
+   conv_impl.rgb565_0rgb1555    = conv_rgb565_0rgb1555_##suffix; \
+   conv_impl._0rgb1555_rgb565   = conv_0rgb1555_rgb565_##suffix; \
+   conv_impl._0rgb1555_argb8888 = conv_0rgb1555_argb8888_##suffix; \
+   conv_impl.rgb565_argb8888    = conv_rgb565_argb8888_##suffix; \
+   conv_impl.rgba4444_argb8888  = conv_rgba4444_argb8888_##suffix; \
+   conv_impl._0rgb1555_bgr24    = conv_0rgb1555_bgr24_##suffix; \
+   conv_impl.rgb565_bgr24       = conv_rgb565_bgr24_##suffix; \
+   conv_impl.argb8888_0rgb1555  = conv_argb8888_0rgb1555_##suffix; \
+   conv_impl.argb8888_rgb565    = conv_argb8888_rgb565_##suffix; \
+   conv_impl.argb8888_bgr24     = conv_argb8888_bgr24_##suffix; \
+   conv_impl.argb8888_abgr8888  = conv_argb8888_abgr8888_##suffix; \
+   conv_impl.yuyv_argb8888      = conv_yuyv_argb8888_##suffix; \
+} while(0)
+
+void conv_init(uint64_t simd_mask)
+{
+   CONV_SET(c);
+   conv_impl.bgr24_argb8888 = conv_bgr24_argb8888_c;
+
+#ifdef PIXCONV_X86
+   if (simd_mask & RETRO_SIMD_SSE2)
+      CONV_SET(sse2);
+   if (simd_mask & RETRO_SIMD_SSSE3)
+      conv_impl.bgr24_argb8888 = conv_bgr24_argb8888_ssse3;
+   if (simd_mask & RETRO_SIMD_AVX2)
    {
-      const uint8_t *src = input;
-      uint32_t *dst = output;
+      CONV_SET(avx2);
+      conv_impl.bgr24_argb8888 = conv_bgr24_argb8888_avx2;
+   }
+#endif
 
-      for (w = 0; w < width; w += 2, src += 4, dst += 2)
-      {
-         int y0 = src[0];
-         int  u = src[1] - 128;
-         int y1 = src[2];
-         int  v = src[3] - 128;
+#ifdef PIXCONV_NEON
+   if (simd_mask & RETRO_SIMD_NEON)
+   {
+      CONV_SET(neon);
+      conv_impl.bgr24_argb8888 = conv_bgr24_argb8888_neon;
+   }
+#endif
 
-         uint8_t r0 = clamp_8bit((YUV_MAT_Y * y0 +                   YUV_MAT_V_R * v + YUV_OFFSET) >> YUV_SHIFT);
-         uint8_t g0 = clamp_8bit((YUV_MAT_Y * y0 + YUV_MAT_U_G * u + YUV_MAT_V_G * v + YUV_OFFSET) >> YUV_SHIFT);
-         uint8_t b0 = clamp_8bit((YUV_MAT_Y * y0 + YUV_MAT_U_B * u                   + YUV_OFFSET) >> YUV_SHIFT);
+   (void)simd_mask;
+   conv_impl.init = true;
+}
 
-         uint8_t r1 = clamp_8bit((YUV_MAT_Y * y1 +                   YUV_MAT_V_R * v + YUV_OFFSET) >> YUV_SHIFT);
-         uint8_t g1 = clamp_8bit((YUV_MAT_Y * y1 + YUV_MAT_U_G * u + YUV_MAT_V_G * v + YUV_OFFSET) >> YUV_SHIFT);
-         uint8_t b1 = clamp_8bit((YUV_MAT_Y * y1 + YUV_MAT_U_B * u                   + YUV_OFFSET) >> YUV_SHIFT);
+void conv_init_host(void)
+{
+   if (!conv_impl.init)
+      conv_init(rarch_get_cpu_features());
+}
 
-         dst[0] = 0xff000000u | (r0 << 16) | (g0 << 8) | (b0 << 0);
-         dst[1] = 0xff000000u | (r1 << 16) | (g1 << 8) | (b1 << 0);
-      }
-   }
+#define CONV_WRAPPER(name, member) \
+void conv_##name(void *output, const void *input, \
+      int width, int height, \
+      int out_stride, int in_stride) \
+{ \
+   conv_init_host(); \
+   conv_impl.member(output, input, width, height, out_stride, in_stride); \
 }
-#endif
+
+CONV_WRAPPER(rgb565_0rgb1555,    rgb565_0rgb1555)
+CONV_WRAPPER(0rgb1555_rgb565,    _0rgb1555_rgb565)
+CONV_WRAPPER(0rgb1555_argb8888,  _0rgb1555_argb8888)
+CONV_WRAPPER(rgb565_argb8888,    rgb565_argb8888)
+CONV_WRAPPER(rgba4444_argb8888,  rgba4444_argb8888)
+CONV_WRAPPER(0rgb1555_bgr24,     _0rgb1555_bgr24)
+CONV_WRAPPER(rgb565_bgr24,       rgb565_bgr24)
+CONV_WRAPPER(bgr24_argb8888,     bgr24_argb8888)
+CONV_WRAPPER(argb8888_0rgb1555,  argb8888_0rgb1555)
+CONV_WRAPPER(argb8888_rgb565,    argb8888_rgb565)
+CONV_WRAPPER(argb8888_bgr24,     argb8888_bgr24)
+CONV_WRAPPER(argb8888_abgr8888,  argb8888_abgr8888)
+CONV_WRAPPER(yuyv_argb8888,      yuyv_argb8888)
 
 void conv_copy(void *output_, const void *input_,
       int width, int height,
@@ -923,4 +2048,3 @@ void conv_copy(void *output_, const void *input_,
          h++, output += out_stride, input += in_stride)
       memcpy(output, input, copy_len);
 }
-
@@ -18,6 +18,14 @@
 
 #include "scaler_common.h"
 
+/* Selects the converter implementations for a RETRO_SIMD_* mask.
+ * The converters pick the host CPU's features on first use;
+ * call conv_init_host() up front to do so before converting
+ * from several threads. */
+void conv_init(uint64_t simd_mask);
+
+void conv_init_host(void);
+
 void conv_0rgb1555_argb8888(void *output, const void *input,
       int width, int height,
       int out_stride, int in_stride);
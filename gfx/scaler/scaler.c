@@ -17,6 +17,9 @@
 #include "scaler_int.h"
 #include "filter.h"
 #include "pixconv.h"
+#ifdef HAVE_THREADS
+#include "scaler_pool.h"
+#endif
 #include <stdlib.h>
 #include <string.h>
 #include <stdio.h>
@@ -24,6 +27,9 @@
 #include "../../libretro.h"
 #include "../../performance.h"
 
+/* Smallest slice worth handing to another thread. */
+#define SCALER_MIN_SLICE_ROWS 32
+
 // In case aligned allocs are needed later ...
 void *scaler_alloc(size_t elem_size, size_t size)
 {
@@ -35,40 +41,130 @@ void scaler_free(void *ptr)
    free(ptr);
 }
 
-static bool allocate_frames(struct scaler_ctx *ctx)
+static bool allocate_slice(struct scaler_ctx *ctx,
+      struct scaler_slice *slice)
 {
-   ctx->scaled.stride = ((ctx->out_width + 7) & ~7) * sizeof(uint64_t);
-   ctx->scaled.width  = ctx->out_width;
-   ctx->scaled.height = ctx->in_height;
-   ctx->scaled.frame  = (uint64_t*)
-      scaler_alloc(sizeof(uint64_t),
-            (ctx->scaled.stride * ctx->scaled.height) >> 3);
-   if (!ctx->scaled.frame)
-      return false;
+   if (ctx->unscaled)
+      return true;
+
+   if (!ctx->scaler_special)
+   {
+      slice->scaled.stride = ((ctx->out_width + 7) & ~7) * sizeof(uint64_t);
+      slice->scaled.width  = ctx->out_width;
+      slice->scaled.height = ctx->vert.filter_len;
+      slice->scaled.frame  = (uint64_t*)
+         scaler_alloc(sizeof(uint64_t),
+               (slice->scaled.stride * slice->scaled.height) >> 3);
+      slice->scaled.taps   = (const uint64_t**)
+         scaler_alloc(sizeof(uint64_t*), slice->scaled.height);
+      if (!slice->scaled.frame || !slice->scaled.taps)
+         return false;
+   }
 
    if (ctx->in_fmt != SCALER_FMT_ARGB8888)
    {
-      ctx->input.stride = ((ctx->in_width + 7) & ~7) * sizeof(uint32_t);
-      ctx->input.frame = (uint32_t*)
-         scaler_alloc(sizeof(uint32_t),
-               (ctx->input.stride * ctx->in_height) >> 2);
-      if (!ctx->input.frame)
+      slice->input.stride = ((ctx->in_width + 7) & ~7) * sizeof(uint32_t);
+      slice->input.frame  = (uint32_t*)
+         scaler_alloc(sizeof(uint32_t), slice->input.stride >> 2);
+      if (!slice->input.frame)
          return false;
    }
 
    if (ctx->out_fmt != SCALER_FMT_ARGB8888)
    {
-      ctx->output.stride = ((ctx->out_width + 7) & ~7) * sizeof(uint32_t);
-      ctx->output.frame  = (uint32_t*)
-         scaler_alloc(sizeof(uint32_t),
-               (ctx->output.stride * ctx->out_height) >> 2);
-      if (!ctx->output.frame)
+      slice->output.stride = ((ctx->out_width + 7) & ~7) * sizeof(uint32_t);
+      slice->output.frame  = (uint32_t*)
+         scaler_alloc(sizeof(uint32_t), slice->output.stride >> 2);
+      if (!slice->output.frame)
          return false;
    }
 
    return true;
 }
 
+static void free_slice(struct scaler_slice *slice)
+{
+   scaler_free(slice->scaled.frame);
+   scaler_free((void*)slice->scaled.taps);
+   scaler_free(slice->input.frame);
+   scaler_free(slice->output.frame);
+}
+
+/* First input row the filter windows of output row y read. */
+static int slice_in_start(const struct scaler_ctx *ctx, int y)
+{
+   if (ctx->unscaled)
+      return y;
+   else if (ctx->scaler_special)
+   {
+      int y_pos = (1 << 15) * ctx->in_height / ctx->out_height - (1 << 15);
+      if (y_pos < 0)
+         y_pos = 0;
+      return (y_pos + y * ((1 << 16) * ctx->in_height / ctx->out_height)) >> 16;
+   }
+
+   return ctx->vert.filter_pos[y];
+}
+
+static void scaler_ctx_scale_slice(struct scaler_ctx *ctx,
+      struct scaler_slice *slice, uint8_t *output, const void *input);
+
+#ifdef HAVE_THREADS
+static void scaler_ctx_slice_work(void *data, unsigned index)
+{
+   struct scaler_ctx *ctx = (struct scaler_ctx*)data;
+   scaler_ctx_scale_slice(ctx, &ctx->slices[index],
+         (uint8_t*)ctx->job_output, ctx->job_input);
+}
+#endif
+
+static bool allocate_slices(struct scaler_ctx *ctx)
+{
+   unsigned i;
+   unsigned num_slices = 1;
+
+#ifdef HAVE_THREADS
+   /* Not worth waking up threads for a handful of rows. */
+   if (ctx->threads > 1)
+   {
+      num_slices = ctx->out_height / SCALER_MIN_SLICE_ROWS;
+      if (num_slices > ctx->threads)
+         num_slices = ctx->threads;
+      if (num_slices < 1)
+         num_slices = 1;
+   }
+#endif
+
+   ctx->slices = (struct scaler_slice*)
+      scaler_alloc(sizeof(*ctx->slices), num_slices);
+   if (!ctx->slices)
+      return false;
+   ctx->num_slices = num_slices;
+
+   for (i = 0; i < num_slices; i++)
+   {
+      struct scaler_slice *slice = &ctx->slices[i];
+
+      slice->out_start = ctx->out_height * i / num_slices;
+      slice->out_end   = ctx->out_height * (i + 1) / num_slices;
+      slice->in_start  = slice_in_start(ctx, slice->out_start);
+
+      if (!allocate_slice(ctx, slice))
+         return false;
+   }
+
+#ifdef HAVE_THREADS
+   if (num_slices > 1)
+   {
+      ctx->pool = scaler_pool_new(num_slices - 1, scaler_ctx_slice_work, ctx);
+      if (!ctx->pool)
+         return false;
+   }
+#endif
+
+   return true;
+}
+
 static bool set_direct_pix_conv(struct scaler_ctx *ctx)
 {
    if (ctx->in_fmt == ctx->out_fmt)
@@ -168,6 +264,9 @@ bool scaler_ctx_gen_filter(struct scaler_ctx *ctx)
 {
    scaler_ctx_gen_reset(ctx);
 
+   /* Resolve the converters here, before any slice worker uses them. */
+   conv_init_host();
+
    if (ctx->in_width == ctx->out_width && ctx->in_height == ctx->out_height)
       ctx->unscaled = true; /* Only pixel format conversion ... */
    else
@@ -179,9 +278,6 @@ bool scaler_ctx_gen_filter(struct scaler_ctx *ctx)
 
    ctx->scaler_special = NULL;
 
-   if (!allocate_frames(ctx))
-      return false;
-
    if (ctx->unscaled)
    {
       if (!set_direct_pix_conv(ctx))
@@ -193,101 +289,184 @@ bool scaler_ctx_gen_filter(struct scaler_ctx *ctx)
          return false;
    }
 
+   /* Scratch rows and slice windows depend on the filter. */
    if (!ctx->unscaled && !scaler_gen_filter(ctx))
       return false;
 
-   return true;
+   return allocate_slices(ctx);
 }
 
 void scaler_ctx_gen_reset(struct scaler_ctx *ctx)
 {
+   unsigned i;
+
+#ifdef HAVE_THREADS
+   if (ctx->pool)
+      scaler_pool_free(ctx->pool);
+#endif
+   ctx->pool = NULL;
+
+   for (i = 0; i < ctx->num_slices; i++)
+      free_slice(&ctx->slices[i]);
+   scaler_free(ctx->slices);
+   ctx->slices     = NULL;
+   ctx->num_slices = 0;
+
    scaler_free(ctx->horiz.filter);
    scaler_free(ctx->horiz.filter_pos);
    scaler_free(ctx->vert.filter);
    scaler_free(ctx->vert.filter_pos);
-   scaler_free(ctx->scaled.frame);
-   scaler_free(ctx->input.frame);
-   scaler_free(ctx->output.frame);
 
    memset(&ctx->horiz, 0, sizeof(ctx->horiz));
    memset(&ctx->vert, 0, sizeof(ctx->vert));
-   memset(&ctx->scaled, 0, sizeof(ctx->scaled));
-   memset(&ctx->input, 0, sizeof(ctx->input));
-   memset(&ctx->output, 0, sizeof(ctx->output));
 }
 
-void scaler_ctx_scale(struct scaler_ctx *ctx,
-      void *output, const void *input)
+/* Returns input row y as ARGB8888, converting it if needed. */
+static const uint32_t *scaler_input_row(const struct scaler_ctx *ctx,
+      struct scaler_slice *slice, const void *input, int y)
 {
-   if (ctx->unscaled)
+   const uint8_t *row = (const uint8_t*)input + y * ctx->in_stride;
+
+   if (ctx->in_fmt == SCALER_FMT_ARGB8888)
+      return (const uint32_t*)row;
+
+   ctx->in_pixconv(slice->input.frame, row,
+         ctx->in_width, 1, slice->input.stride, ctx->in_stride);
+   return slice->input.frame;
+}
+
+/* Row to write ARGB8888 output row to, before scaler_output_row(). */
+static uint32_t *scaler_output_target(const struct scaler_ctx *ctx,
+      struct scaler_slice *slice, uint8_t *output)
+{
+   if (ctx->out_fmt == SCALER_FMT_ARGB8888)
+      return (uint32_t*)output;
+   return slice->output.frame;
+}
+
+static void scaler_output_row(const struct scaler_ctx *ctx,
+      struct scaler_slice *slice, uint8_t *output)
+{
+   if (ctx->out_fmt != SCALER_FMT_ARGB8888)
+      ctx->out_pixconv(output, slice->output.frame,
+            ctx->out_width, 1, ctx->out_stride, slice->output.stride);
+}
+
+static void scaler_ctx_scale_special(const struct scaler_ctx *ctx,
+      struct scaler_slice *slice, uint8_t *output, const void *input)
+{
+   int h;
+   int last_y          = -1;
+   const uint32_t *inp = NULL;
+   /* Same row stepping as scaler_argb8888_point_special(). */
+   int y_pos  = (1 << 15) * ctx->in_height / ctx->out_height - (1 << 15);
+   int y_step = (1 << 16) * ctx->in_height / ctx->out_height;
+
+   if (y_pos < 0)
+      y_pos = 0;
+   y_pos += slice->out_start * y_step;
+
+   for (h = slice->out_start; h < slice->out_end; h++, y_pos += y_step,
+         output += ctx->out_stride)
    {
-      /* Just perform straight pixel conversion. */
-      ctx->direct_pixconv(output, input,
-            ctx->out_width, ctx->out_height,
+      int y = y_pos >> 16;
+
+      /* Upscaling repeats input rows, only convert them once. */
+      if (y != last_y)
+         inp = scaler_input_row(ctx, slice, input, y);
+      last_y = y;
+
+      ctx->scaler_special(ctx, scaler_output_target(ctx, slice, output), inp,
+            ctx->out_width, 1, ctx->in_width, 1,
             ctx->out_stride, ctx->in_stride);
+      scaler_output_row(ctx, slice, output);
    }
-   else if (ctx->scaler_special)
+}
+
+static void scaler_ctx_scale_generic(const struct scaler_ctx *ctx,
+      struct scaler_slice *slice, uint8_t *output, const void *input)
+{
+   int h, y;
+   int next                   = slice->in_start;
+   const int taps             = ctx->vert.filter_len;
+   const int16_t *filter_vert = ctx->vert.filter +
+      slice->out_start * ctx->vert.filter_stride;
+   uint64_t *ring             = slice->scaled.frame;
+   const int ring_stride      = slice->scaled.stride >> 3;
+
+   for (h = slice->out_start; h < slice->out_end; h++,
+         filter_vert += ctx->vert.filter_stride, output += ctx->out_stride)
    {
-      /* Take some special, and (hopefully) more optimized path. */
-      const void *inp = input;
-      int in_stride   = ctx->in_stride;
+      int pos = ctx->vert.filter_pos[h];
 
-      if (ctx->in_fmt != SCALER_FMT_ARGB8888)
-      {
-         ctx->in_pixconv(ctx->input.frame, input,
-               ctx->in_width, ctx->in_height,
-               ctx->input.stride, ctx->in_stride);
+      /* filter_pos never decreases, so a ring of one row per tap is
+       * enough. Rows skipped over when downscaling are never touched. */
+      if (next < pos)
+         next = pos;
 
-         inp       = ctx->input.frame;
-         in_stride = ctx->input.stride;
-      }
+      for (; next < pos + taps; next++)
+         ctx->scaler_horiz(ctx, ring + (next % taps) * ring_stride,
+               scaler_input_row(ctx, slice, input, next));
 
-      bool conv_out  = ctx->out_fmt != SCALER_FMT_ARGB8888;
-      void *outp     = output;
-      int out_stride = ctx->out_stride;
+      for (y = 0; y < taps; y++)
+         slice->scaled.taps[y] = ring + ((pos + y) % taps) * ring_stride;
 
-      if (conv_out)
-      {
-         outp       = ctx->output.frame;
-         out_stride = ctx->output.stride;
-      }
+      ctx->scaler_vert(ctx, scaler_output_target(ctx, slice, output),
+            slice->scaled.taps, filter_vert);
+      scaler_output_row(ctx, slice, output);
+   }
+}
 
-      ctx->scaler_special(ctx, outp, inp,
-            ctx->out_width, ctx->out_height,
-            ctx->in_width, ctx->in_height,
-            out_stride, in_stride);
+static void scaler_ctx_scale_slice(struct scaler_ctx *ctx,
+      struct scaler_slice *slice, uint8_t *output, const void *input)
+{
+   output += slice->out_start * ctx->out_stride;
 
-      if (conv_out)
-      {
-         ctx->out_pixconv(output, ctx->output.frame,
-               ctx->out_width, ctx->out_height,
-               ctx->out_stride, ctx->output.stride);
-      }
+   if (ctx->unscaled)
+   {
+      /* Just perform straight pixel conversion. */
+      ctx->direct_pixconv(output,
+            (const uint8_t*)input + slice->out_start * ctx->in_stride,
+            ctx->out_width, slice->out_end - slice->out_start,
+            ctx->out_stride, ctx->in_stride);
+   }
+   else if (ctx->scaler_special)
+   {
+      /* Take some special, and (hopefully) more optimized path. */
+      scaler_ctx_scale_special(ctx, slice, output, input);
    }
    else
    {
       /* Take generic filter path. */
-      if (ctx->in_fmt != SCALER_FMT_ARGB8888)
-      {
-         ctx->in_pixconv(ctx->input.frame, input,
-               ctx->in_width, ctx->in_height,
-               ctx->input.stride, ctx->in_stride);
-
-         ctx->scaler_horiz(ctx, ctx->input.frame, ctx->input.stride);
-      }
-      else
-         ctx->scaler_horiz(ctx, input, ctx->in_stride);
+      scaler_ctx_scale_generic(ctx, slice, output, input);
+   }
+}
 
-      if (ctx->out_fmt != SCALER_FMT_ARGB8888)
+void scaler_ctx_scale(struct scaler_ctx *ctx,
+      void *output, const void *input)
+{
+   /* Plain pixel conversion contexts are commonly reused for
+    * other sizes without regenerating them. */
+   if (ctx->unscaled)
+   {
+      unsigned i;
+      for (i = 0; i < ctx->num_slices; i++)
       {
-         ctx->scaler_vert(ctx, ctx->output.frame, ctx->output.stride);
-
-         ctx->out_pixconv(output, ctx->output.frame,
-               ctx->out_width, ctx->out_height,
-               ctx->out_stride, ctx->output.stride);
+         ctx->slices[i].out_start = ctx->out_height * i / ctx->num_slices;
+         ctx->slices[i].out_end   =
+            ctx->out_height * (i + 1) / ctx->num_slices;
       }
-      else
-         ctx->scaler_vert(ctx, output, ctx->out_stride);
    }
-}
 
+#ifdef HAVE_THREADS
+   if (ctx->pool)
+   {
+      ctx->job_output = output;
+      ctx->job_input  = input;
+      scaler_pool_run(ctx->pool, ctx->num_slices);
+      return;
+   }
+#endif
+
+   scaler_ctx_scale_slice(ctx, &ctx->slices[0], (uint8_t*)output, input);
+}
@@ -50,6 +50,43 @@ struct scaler_filter
    int *filter_pos;
 };
 
+/* A horizontal band of output rows, scaled independently of the others.
+ * Scaling streams through it a row at a time, so the scratch buffers
+ * only hold a few rows. */
+struct scaler_slice
+{
+   /* Output rows [out_start, out_end). */
+   int out_start;
+   int out_end;
+
+   /* First input row read by the slice's filter windows. */
+   int in_start;
+
+   struct
+   {
+      uint32_t *frame;
+      int stride;
+   } input;
+
+   /* Ring of horizontally scaled rows, one per vertical tap. */
+   struct
+   {
+      uint64_t *frame;
+      const uint64_t **taps;
+      int width;
+      int height;
+      int stride;
+   } scaled;
+
+   struct
+   {
+      uint32_t *frame;
+      int stride;
+   } output;
+};
+
+struct scaler_pool;
+
 struct scaler_ctx
 {
    int in_width;
@@ -65,9 +102,9 @@ struct scaler_ctx
    enum scaler_type scaler_type;
 
    void (*scaler_horiz)(const struct scaler_ctx*,
-         const void*, int);
+         uint64_t*, const uint32_t*);
    void (*scaler_vert)(const struct scaler_ctx*,
-         void*, int);
+         uint32_t*, const uint64_t * const*, const int16_t*);
    void (*scaler_special)(const struct scaler_ctx*,
          void*, const void*, int, int, int, int, int, int);
 
@@ -78,25 +115,16 @@ struct scaler_ctx
    bool unscaled;
    struct scaler_filter horiz, vert;
 
-   struct
-   {
-      uint32_t *frame;
-      int stride;
-   } input;
+   /* Worker threads to split large scales over, in horizontal slices.
+    * 0 or 1 scales on the calling thread. Set before scaler_ctx_gen_filter(). */
+   unsigned threads;
 
-   struct
-   {
-      uint64_t *frame;
-      int width;
-      int height;
-      int stride;
-   } scaled;
+   struct scaler_slice *slices;
+   unsigned num_slices;
 
-   struct
-   {
-      uint32_t *frame;
-      int stride;
-   } output;
+   struct scaler_pool *pool;
+   void *job_output;
+   const void *job_input;
 };
 
 bool scaler_ctx_gen_filter(struct scaler_ctx *ctx);
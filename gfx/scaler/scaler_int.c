@@ -17,13 +17,19 @@
 
 #ifdef SCALER_NO_SIMD
 #undef __SSE2__
+#undef __AVX2__
+#undef __ARM_NEON__
 #endif
 
-#if defined(__SSE2__)
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
 #include <emmintrin.h>
 #ifdef _WIN32
 #include <intrin.h>
 #endif
+#elif defined(__ARM_NEON__)
+#include <arm_neon.h>
 #endif
 
 // ARGB8888 scaler is split in two:
@@ -43,151 +49,277 @@
 //
 // The C version of scalers perform the exact same operations as the SIMD code for testing purposes.
 
+// Both passes work on a single row at a time, so scaler_ctx_scale() can stream
+// rows through a small ring buffer instead of going through a full scratch frame.
+
 #if defined(__SSE2__)
-void scaler_argb8888_vert(const struct scaler_ctx *ctx, void *output_, int stride)
+static inline __m128i vert_taps_sse2(const uint64_t * const *rows,
+      const int16_t *filter_vert, int taps, int w, bool two)
 {
-   int h, w, y;
-   const uint64_t *input = ctx->scaled.frame;
-   uint32_t *output = (uint32_t*)output_;
+   int y;
+   __m128i res = _mm_setzero_si128();
+
+   for (y = 0; y < taps; y++)
+   {
+      __m128i coeff = _mm_set1_epi16(filter_vert[y]);
+      __m128i col   = two ?
+         _mm_loadu_si128((const __m128i*)(rows[y] + w)) :
+         _mm_loadl_epi64((const __m128i*)(rows[y] + w));
+
+      res = _mm_adds_epi16(_mm_mulhi_epi16(col, coeff), res);
+   }
+
+   return _mm_srai_epi16(res, (7 - 2 - 2));
+}
+#endif
 
-   const int16_t *filter_vert = ctx->vert.filter;
+#if defined(__AVX2__)
+void scaler_argb8888_vert(const struct scaler_ctx *ctx, uint32_t *output,
+      const uint64_t * const *rows, const int16_t *filter_vert)
+{
+   int w, y;
+   const int taps = ctx->vert.filter_len;
 
-   for (h = 0; h < ctx->out_height; h++, filter_vert += ctx->vert.filter_stride, output += stride >> 2)
+   for (w = 0; w + 4 <= ctx->out_width; w += 4)
    {
-      const uint64_t *input_base = input + ctx->vert.filter_pos[h] * (ctx->scaled.stride >> 3);
+      __m256i res = _mm256_setzero_si256();
 
-      for (w = 0; w < ctx->out_width; w++)
+      for (y = 0; y < taps; y++)
       {
-         __m128i res = _mm_setzero_si128();
-
-         const uint64_t *input_base_y = input_base + w;
+         __m256i coeff = _mm256_set1_epi16(filter_vert[y]);
+         __m256i col   = _mm256_loadu_si256((const __m256i*)(rows[y] + w));
 
-         for (y = 0; (y + 1) < ctx->vert.filter_len; y += 2, input_base_y += (ctx->scaled.stride >> 2))
-         {
-            __m128i coeff = _mm_set_epi64x(filter_vert[y + 1] * 0x0001000100010001ll, filter_vert[y + 0] * 0x0001000100010001ll);
-            __m128i col   = _mm_set_epi64x(input_base_y[ctx->scaled.stride >> 3], input_base_y[0]);
+         res = _mm256_adds_epi16(_mm256_mulhi_epi16(col, coeff), res);
+      }
 
-            res = _mm_adds_epi16(_mm_mulhi_epi16(col, coeff), res);
-         }
+      res = _mm256_srai_epi16(res, (7 - 2 - 2));
 
-         for (; y < ctx->vert.filter_len; y++, input_base_y += (ctx->scaled.stride >> 3))
-         {
-            __m128i coeff = _mm_set_epi64x(0, filter_vert[y] * 0x0001000100010001ll);
-            __m128i col   = _mm_set_epi64x(0, input_base_y[0]);
+      // Packing works per 128-bit lane, gather the low quadword of both lanes.
+      __m256i final = _mm256_permute4x64_epi64(_mm256_packus_epi16(res, res), 0x08);
+      _mm_storeu_si128((__m128i*)(output + w), _mm256_castsi256_si128(final));
+   }
 
-            res = _mm_adds_epi16(_mm_mulhi_epi16(col, coeff), res);
-         }
+   for (; w + 2 <= ctx->out_width; w += 2)
+   {
+      __m128i res = vert_taps_sse2(rows, filter_vert, taps, w, true);
+      _mm_storel_epi64((__m128i*)(output + w), _mm_packus_epi16(res, res));
+   }
 
-         res = _mm_adds_epi16(_mm_srli_si128(res, 8), res);
-         res = _mm_srai_epi16(res, (7 - 2 - 2));
+   for (; w < ctx->out_width; w++)
+   {
+      __m128i res = vert_taps_sse2(rows, filter_vert, taps, w, false);
+      output[w] = _mm_cvtsi128_si32(_mm_packus_epi16(res, res));
+   }
+}
+#elif defined(__SSE2__)
+void scaler_argb8888_vert(const struct scaler_ctx *ctx, uint32_t *output,
+      const uint64_t * const *rows, const int16_t *filter_vert)
+{
+   int w;
+   const int taps = ctx->vert.filter_len;
 
-         __m128i final = _mm_packus_epi16(res, res);
+   for (w = 0; w + 2 <= ctx->out_width; w += 2)
+   {
+      __m128i res = vert_taps_sse2(rows, filter_vert, taps, w, true);
+      _mm_storel_epi64((__m128i*)(output + w), _mm_packus_epi16(res, res));
+   }
 
-         output[w] = _mm_cvtsi128_si32(final);
-      }
+   for (; w < ctx->out_width; w++)
+   {
+      __m128i res = vert_taps_sse2(rows, filter_vert, taps, w, false);
+      output[w] = _mm_cvtsi128_si32(_mm_packus_epi16(res, res));
    }
 }
-#else
-void scaler_argb8888_vert(const struct scaler_ctx *ctx, void *output_, int stride)
+#elif defined(__ARM_NEON__)
+// vmull + narrowing shift is the NEON equivalent of mulhi.
+static inline int16x4_t mulhi_s16(int16x4_t a, int16_t coeff)
 {
-   int h, w, y;
-   const uint64_t *input = ctx->scaled.frame;
-   uint32_t *output = (uint32_t*)output_;
+   return vshrn_n_s32(vmull_n_s16(a, coeff), 16);
+}
 
-   const int16_t *filter_vert = ctx->vert.filter;
+void scaler_argb8888_vert(const struct scaler_ctx *ctx, uint32_t *output,
+      const uint64_t * const *rows, const int16_t *filter_vert)
+{
+   int w, y;
+   const int taps = ctx->vert.filter_len;
 
-   for (h = 0; h < ctx->out_height; h++, filter_vert += ctx->vert.filter_stride, output += stride >> 2)
+   for (w = 0; w + 2 <= ctx->out_width; w += 2)
    {
-      const uint64_t *input_base = input + ctx->vert.filter_pos[h] * (ctx->scaled.stride >> 3);
+      int16x8_t res = vdupq_n_s16(0);
 
-      for (w = 0; w < ctx->out_width; w++)
+      for (y = 0; y < taps; y++)
       {
-         int16_t res_a = 0;
-         int16_t res_r = 0;
-         int16_t res_g = 0;
-         int16_t res_b = 0;
+         int16x8_t col = vld1q_s16((const int16_t*)(rows[y] + w));
+         res = vqaddq_s16(res, vcombine_s16(
+                  mulhi_s16(vget_low_s16(col), filter_vert[y]),
+                  mulhi_s16(vget_high_s16(col), filter_vert[y])));
+      }
 
-         const uint64_t *input_base_y = input_base + w;
-         for (y = 0; y < ctx->vert.filter_len; y++, input_base_y += (ctx->scaled.stride >> 3))
-         {
-            uint64_t col = *input_base_y;
+      vst1_u8((uint8_t*)(output + w),
+            vqmovun_s16(vshrq_n_s16(res, (7 - 2 - 2))));
+   }
 
-            int16_t a = (col >> 48) & 0xffff;
-            int16_t r = (col >> 32) & 0xffff;
-            int16_t g = (col >> 16) & 0xffff;
-            int16_t b = (col >>  0) & 0xffff;
+   for (; w < ctx->out_width; w++)
+   {
+      int16x4_t res = vdup_n_s16(0);
 
-            int16_t coeff = filter_vert[y];
+      for (y = 0; y < taps; y++)
+         res = vqadd_s16(res, mulhi_s16(
+                  vld1_s16((const int16_t*)(rows[y] + w)), filter_vert[y]));
 
-            res_a += (a * coeff) >> 16;
-            res_r += (r * coeff) >> 16;
-            res_g += (g * coeff) >> 16;
-            res_b += (b * coeff) >> 16;
-         }
+      output[w] = vget_lane_u32(vreinterpret_u32_u8(
+               vqmovun_s16(vcombine_s16(vshr_n_s16(res, (7 - 2 - 2)),
+                     vdup_n_s16(0)))), 0);
+   }
+}
+#else
+void scaler_argb8888_vert(const struct scaler_ctx *ctx, uint32_t *output,
+      const uint64_t * const *rows, const int16_t *filter_vert)
+{
+   int w, y;
 
-         res_a >>= (7 - 2 - 2);
-         res_r >>= (7 - 2 - 2);
-         res_g >>= (7 - 2 - 2);
-         res_b >>= (7 - 2 - 2);
+   for (w = 0; w < ctx->out_width; w++)
+   {
+      int16_t res_a = 0;
+      int16_t res_r = 0;
+      int16_t res_g = 0;
+      int16_t res_b = 0;
 
-         output[w] = (clamp_8bit(res_a) << 24) | (clamp_8bit(res_r) << 16) | (clamp_8bit(res_g) << 8) | (clamp_8bit(res_b) << 0);
+      for (y = 0; y < ctx->vert.filter_len; y++)
+      {
+         uint64_t col = rows[y][w];
+
+         int16_t a = (col >> 48) & 0xffff;
+         int16_t r = (col >> 32) & 0xffff;
+         int16_t g = (col >> 16) & 0xffff;
+         int16_t b = (col >>  0) & 0xffff;
+
+         int16_t coeff = filter_vert[y];
+
+         res_a += (a * coeff) >> 16;
+         res_r += (r * coeff) >> 16;
+         res_g += (g * coeff) >> 16;
+         res_b += (b * coeff) >> 16;
       }
+
+      res_a >>= (7 - 2 - 2);
+      res_r >>= (7 - 2 - 2);
+      res_g >>= (7 - 2 - 2);
+      res_b >>= (7 - 2 - 2);
+
+      output[w] = (clamp_8bit(res_a) << 24) | (clamp_8bit(res_r) << 16) | (clamp_8bit(res_g) << 8) | (clamp_8bit(res_b) << 0);
    }
 }
 #endif
 
 #if defined(__SSE2__)
-void scaler_argb8888_horiz(const struct scaler_ctx *ctx, const void *input_, int stride)
+static inline void store_argb64(uint64_t *output, __m128i res)
 {
-   int h, w, x;
-   const uint32_t *input = (const uint32_t*)input_;
-   uint64_t *output      = ctx->scaled.frame;
+#ifdef __x86_64__
+   *output = _mm_cvtsi128_si64(res);
+#else // 32-bit doesn't have si64. Do it in two steps.
+   union
+   {
+      uint32_t *u32;
+      uint64_t *u64;
+   } u;
+   u.u64 = output;
+   u.u32[0] = _mm_cvtsi128_si32(res);
+   u.u32[1] = _mm_cvtsi128_si32(_mm_srli_si128(res, 4));
+#endif
+}
+
+void scaler_argb8888_horiz(const struct scaler_ctx *ctx, uint64_t *output,
+      const uint32_t *input)
+{
+   int w, x;
+   const int16_t *filter_horiz = ctx->horiz.filter;
 
-   for (h = 0; h < ctx->scaled.height; h++, input += stride >> 2, output += ctx->scaled.stride >> 3)
+   for (w = 0; w < ctx->out_width; w++, filter_horiz += ctx->horiz.filter_stride)
    {
-      const int16_t *filter_horiz = ctx->horiz.filter;
+      __m128i res = _mm_setzero_si128();
 
-      for (w = 0; w < ctx->scaled.width; w++, filter_horiz += ctx->horiz.filter_stride)
-      {
-         __m128i res = _mm_setzero_si128();
+      const uint32_t *input_base_x = input + ctx->horiz.filter_pos[w];
 
-         const uint32_t *input_base_x = input + ctx->horiz.filter_pos[w];
+      x = 0;
+#if defined(__AVX2__)
+      if (ctx->horiz.filter_len >= 4)
+      {
+         __m256i res256 = _mm256_setzero_si256();
 
-         for (x = 0; (x + 1) < ctx->horiz.filter_len; x += 2)
+         for (; (x + 3) < ctx->horiz.filter_len; x += 4)
          {
-            __m128i coeff = _mm_set_epi64x(filter_horiz[x + 1] * 0x0001000100010001ll, filter_horiz[x + 0] * 0x0001000100010001ll);
+            __m256i coeff = _mm256_set_epi64x(
+                  filter_horiz[x + 3] * 0x0001000100010001ll,
+                  filter_horiz[x + 2] * 0x0001000100010001ll,
+                  filter_horiz[x + 1] * 0x0001000100010001ll,
+                  filter_horiz[x + 0] * 0x0001000100010001ll);
+            __m256i col = _mm256_cvtepu8_epi16(
+                  _mm_loadu_si128((const __m128i*)(input_base_x + x)));
+
+            col    = _mm256_slli_epi16(col, 7);
+            res256 = _mm256_adds_epi16(_mm256_mulhi_epi16(col, coeff), res256);
+         }
 
-            __m128i col = _mm_unpacklo_epi8(_mm_set_epi64x(0,
-                     ((uint64_t)input_base_x[x + 1] << 32) | input_base_x[x + 0]), _mm_setzero_si128());
+         res = _mm_adds_epi16(_mm256_castsi256_si128(res256),
+               _mm256_extracti128_si256(res256, 1));
+      }
+#endif
 
-            col = _mm_slli_epi16(col, 7);
-            res = _mm_adds_epi16(_mm_mulhi_epi16(col, coeff), res);
-         }
+      for (; (x + 1) < ctx->horiz.filter_len; x += 2)
+      {
+         __m128i coeff = _mm_set_epi64x(filter_horiz[x + 1] * 0x0001000100010001ll, filter_horiz[x + 0] * 0x0001000100010001ll);
 
-         for (; x < ctx->horiz.filter_len; x++)
-         {
-            __m128i coeff = _mm_set_epi64x(0, filter_horiz[x] * 0x0001000100010001ll);
-            __m128i col   = _mm_unpacklo_epi8(_mm_set_epi32(0, 0, 0, input_base_x[x]), _mm_setzero_si128());
+         __m128i col = _mm_unpacklo_epi8(_mm_loadl_epi64(
+                  (const __m128i*)(input_base_x + x)), _mm_setzero_si128());
 
-            col = _mm_slli_epi16(col, 7);
-            res = _mm_adds_epi16(_mm_mulhi_epi16(col, coeff), res);
-         }
+         col = _mm_slli_epi16(col, 7);
+         res = _mm_adds_epi16(_mm_mulhi_epi16(col, coeff), res);
+      }
 
-         res       = _mm_adds_epi16(_mm_srli_si128(res, 8), res);
+      for (; x < ctx->horiz.filter_len; x++)
+      {
+         __m128i coeff = _mm_set_epi64x(0, filter_horiz[x] * 0x0001000100010001ll);
+         __m128i col   = _mm_unpacklo_epi8(_mm_cvtsi32_si128(input_base_x[x]), _mm_setzero_si128());
 
-#ifdef __x86_64__
-         output[w] = _mm_cvtsi128_si64(res);
-#else // 32-bit doesn't have si64. Do it in two steps.
-         union
-         {
-            uint32_t *u32;
-            uint64_t *u64;
-         } u;
-         u.u64 = output + w;
-         u.u32[0] = _mm_cvtsi128_si32(res);
-         u.u32[1] = _mm_cvtsi128_si32(_mm_srli_si128(res, 4));
-#endif
+         col = _mm_slli_epi16(col, 7);
+         res = _mm_adds_epi16(_mm_mulhi_epi16(col, coeff), res);
       }
+
+      store_argb64(output + w, _mm_adds_epi16(_mm_srli_si128(res, 8), res));
+   }
+}
+#elif defined(__ARM_NEON__)
+void scaler_argb8888_horiz(const struct scaler_ctx *ctx, uint64_t *output,
+      const uint32_t *input)
+{
+   int w, x;
+   const int16_t *filter_horiz = ctx->horiz.filter;
+
+   for (w = 0; w < ctx->out_width; w++, filter_horiz += ctx->horiz.filter_stride)
+   {
+      int16x4_t res = vdup_n_s16(0);
+
+      const uint32_t *input_base_x = input + ctx->horiz.filter_pos[w];
+
+      for (x = 0; (x + 1) < ctx->horiz.filter_len; x += 2)
+      {
+         int16x8_t col = vreinterpretq_s16_u16(vshlq_n_u16(vmovl_u8(
+                     vld1_u8((const uint8_t*)(input_base_x + x))), 7));
+
+         res = vqadd_s16(res, mulhi_s16(vget_low_s16(col), filter_horiz[x + 0]));
+         res = vqadd_s16(res, mulhi_s16(vget_high_s16(col), filter_horiz[x + 1]));
+      }
+
+      for (; x < ctx->horiz.filter_len; x++)
+      {
+         int16x4_t col = vreinterpret_s16_u16(vshl_n_u16(vget_low_u16(vmovl_u8(
+                     vreinterpret_u8_u32(vdup_n_u32(input_base_x[x])))), 7));
+
+         res = vqadd_s16(res, mulhi_s16(col, filter_horiz[x]));
+      }
+
+      vst1_s16((int16_t*)(output + w), res);
    }
 }
 #else
@@ -196,44 +328,39 @@ static inline uint64_t build_argb64(uint16_t a, uint16_t r, uint16_t g, uint16_t
    return ((uint64_t)a << 48) | ((uint64_t)r << 32) | ((uint64_t)g << 16) | ((uint64_t)b << 0);
 }
 
-void scaler_argb8888_horiz(const struct scaler_ctx *ctx, const void *input_, int stride)
+void scaler_argb8888_horiz(const struct scaler_ctx *ctx, uint64_t *output,
+      const uint32_t *input)
 {
-   int h, w, x;
-   const uint32_t *input = (uint32_t*)input_;
-   uint64_t *output      = ctx->scaled.frame;
+   int w, x;
+   const int16_t *filter_horiz = ctx->horiz.filter;
 
-   for (h = 0; h < ctx->scaled.height; h++, input += stride >> 2, output += ctx->scaled.stride >> 3)
+   for (w = 0; w < ctx->out_width; w++, filter_horiz += ctx->horiz.filter_stride)
    {
-      const int16_t *filter_horiz = ctx->horiz.filter;
-
-      for (w = 0; w < ctx->scaled.width; w++, filter_horiz += ctx->horiz.filter_stride)
-      {
-         const uint32_t *input_base_x = input + ctx->horiz.filter_pos[w];
+      const uint32_t *input_base_x = input + ctx->horiz.filter_pos[w];
 
-         int16_t res_a = 0;
-         int16_t res_r = 0;
-         int16_t res_g = 0;
-         int16_t res_b = 0;
+      int16_t res_a = 0;
+      int16_t res_r = 0;
+      int16_t res_g = 0;
+      int16_t res_b = 0;
 
-         for (x = 0; x < ctx->horiz.filter_len; x++)
-         {
-            uint32_t col = input_base_x[x];
+      for (x = 0; x < ctx->horiz.filter_len; x++)
+      {
+         uint32_t col = input_base_x[x];
 
-            int16_t a = (col >> (24 - 7)) & (0xff << 7);
-            int16_t r = (col >> (16 - 7)) & (0xff << 7);
-            int16_t g = (col >> ( 8 - 7)) & (0xff << 7);
-            int16_t b = (col << ( 0 + 7)) & (0xff << 7);
+         int16_t a = (col >> (24 - 7)) & (0xff << 7);
+         int16_t r = (col >> (16 - 7)) & (0xff << 7);
+         int16_t g = (col >> ( 8 - 7)) & (0xff << 7);
+         int16_t b = (col << ( 0 + 7)) & (0xff << 7);
 
-            int16_t coeff = filter_horiz[x];
+         int16_t coeff = filter_horiz[x];
 
-            res_a += (a * coeff) >> 16;
-            res_r += (r * coeff) >> 16;
-            res_g += (g * coeff) >> 16;
-            res_b += (b * coeff) >> 16;
-         }
-
-         output[w] = build_argb64(res_a, res_r, res_g, res_b);
+         res_a += (a * coeff) >> 16;
+         res_r += (r * coeff) >> 16;
+         res_g += (g * coeff) >> 16;
+         res_b += (b * coeff) >> 16;
       }
+
+      output[w] = build_argb64(res_a, res_r, res_g, res_b);
    }
 }
 #endif
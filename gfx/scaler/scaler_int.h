@@ -18,11 +18,13 @@
 
 #include "scaler.h"
 
-void scaler_argb8888_vert(const struct scaler_ctx *ctx,
-      void *output, int stride);
+/* Vertically filters one output row from filter_len horizontally scaled rows. */
+void scaler_argb8888_vert(const struct scaler_ctx *ctx, uint32_t *output,
+      const uint64_t * const *rows, const int16_t *filter_vert);
 
-void scaler_argb8888_horiz(const struct scaler_ctx *ctx,
-      const void *input, int stride);
+/* Horizontally scales one ARGB8888 input row. */
+void scaler_argb8888_horiz(const struct scaler_ctx *ctx, uint64_t *output,
+      const uint32_t *input);
 
 void scaler_argb8888_point_special(const struct scaler_ctx *ctx,
       void *output, const void *input,
@@ -0,0 +1,152 @@
+/*  RetroArch - A frontend for libretro.
+ *  Copyright (C) 2010-2014 - Hans-Kristian Arntzen
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "scaler_pool.h"
+#include "../../thread.h"
+#include "../../boolean.h"
+#include <stdlib.h>
+
+struct scaler_pool
+{
+   sthread_t **threads;
+   unsigned num_threads;
+
+   slock_t *lock;
+   scond_t *work_cond;
+   scond_t *done_cond;
+
+   scaler_pool_work_t work;
+   void *userdata;
+
+   /* Work items of the current run. */
+   unsigned next;
+   unsigned count;
+   unsigned pending;
+
+   bool quit;
+};
+
+/* Lock must be held. Returns false when there's nothing left to grab. */
+static bool pool_do_work(scaler_pool_t *pool)
+{
+   unsigned index;
+
+   if (pool->next >= pool->count)
+      return false;
+
+   index = pool->next++;
+
+   slock_unlock(pool->lock);
+   pool->work(pool->userdata, index);
+   slock_lock(pool->lock);
+
+   if (--pool->pending == 0)
+      scond_signal(pool->done_cond);
+
+   return true;
+}
+
+static void pool_thread(void *data)
+{
+   scaler_pool_t *pool = (scaler_pool_t*)data;
+
+   slock_lock(pool->lock);
+
+   while (!pool->quit)
+   {
+      if (!pool_do_work(pool))
+         scond_wait(pool->work_cond, pool->lock);
+   }
+
+   slock_unlock(pool->lock);
+}
+
+scaler_pool_t *scaler_pool_new(unsigned num_workers,
+      scaler_pool_work_t work, void *userdata)
+{
+   unsigned i;
+   scaler_pool_t *pool = (scaler_pool_t*)calloc(1, sizeof(*pool));
+   if (!pool)
+      return NULL;
+
+   pool->work      = work;
+   pool->userdata  = userdata;
+   pool->lock      = slock_new();
+   pool->work_cond = scond_new();
+   pool->done_cond = scond_new();
+   pool->threads   = (sthread_t**)calloc(num_workers, sizeof(*pool->threads));
+
+   if (!pool->lock || !pool->work_cond || !pool->done_cond || !pool->threads)
+      goto error;
+
+   for (i = 0; i < num_workers; i++)
+   {
+      pool->threads[i] = sthread_create(pool_thread, pool);
+      if (!pool->threads[i])
+         goto error;
+      pool->num_threads++;
+   }
+
+   return pool;
+
+error:
+   scaler_pool_free(pool);
+   return NULL;
+}
+
+void scaler_pool_free(scaler_pool_t *pool)
+{
+   unsigned i;
+   if (!pool)
+      return;
+
+   if (pool->num_threads)
+   {
+      slock_lock(pool->lock);
+      pool->quit = true;
+      scond_broadcast(pool->work_cond);
+      slock_unlock(pool->lock);
+   }
+
+   for (i = 0; i < pool->num_threads; i++)
+      sthread_join(pool->threads[i]);
+
+   if (pool->lock)
+      slock_free(pool->lock);
+   if (pool->work_cond)
+      scond_free(pool->work_cond);
+   if (pool->done_cond)
+      scond_free(pool->done_cond);
+
+   free(pool->threads);
+   free(pool);
+}
+
+void scaler_pool_run(scaler_pool_t *pool, unsigned count)
+{
+   slock_lock(pool->lock);
+
+   pool->next    = 0;
+   pool->count   = count;
+   pool->pending = count;
+   scond_broadcast(pool->work_cond);
+
+   while (pool_do_work(pool));
+
+   while (pool->pending)
+      scond_wait(pool->done_cond, pool->lock);
+
+   slock_unlock(pool->lock);
+}
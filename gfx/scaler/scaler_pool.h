@@ -0,0 +1,35 @@
+/*  RetroArch - A frontend for libretro.
+ *  Copyright (C) 2010-2014 - Hans-Kristian Arntzen
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef SCALER_POOL_H__
+#define SCALER_POOL_H__
+
+/* Small fork-join pool the scaler splits its slices over. */
+typedef struct scaler_pool scaler_pool_t;
+
+typedef void (*scaler_pool_work_t)(void *userdata, unsigned index);
+
+/* Spawns num_workers threads. Returns NULL on failure. */
+scaler_pool_t *scaler_pool_new(unsigned num_workers,
+      scaler_pool_work_t work, void *userdata);
+
+void scaler_pool_free(scaler_pool_t *pool);
+
+/* Calls work(userdata, i) for every i in [0, count) and returns once
+ * all of them are done. The calling thread takes part in the work. */
+void scaler_pool_run(scaler_pool_t *pool, unsigned count);
+
+#endif
+
@@ -0,0 +1,411 @@
+/*  RetroArch - A frontend for libretro.
+ *  Copyright (C) 2010-2014 - Hans-Kristian Arntzen
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Checks that sliced, multithreaded scaling is bit-identical to serial
+ * scaling, and that the SIMD pixel converters match the C ones,
+ * and benchmarks them. */
+
+#include "scaler.h"
+#include "pixconv.h"
+#include "../../libretro.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+
+static const char *fmt_names[] = {
+   "ARGB8888", "ABGR8888", "0RGB1555", "RGB565", "BGR24", "YUYV", "RGBA4444",
+};
+
+static const char *type_names[] = {
+   "unscaled", "point", "bilinear", "sinc",
+};
+
+typedef void (*conv_func_t)(void *output, const void *input,
+      int width, int height, int out_stride, int in_stride);
+
+static const struct
+{
+   const char *name;
+   conv_func_t func;
+   unsigned in_size, out_size;
+} convs[] = {
+   { "0RGB1555 -> ARGB8888", conv_0rgb1555_argb8888, 2, 4 },
+   { "0RGB1555 -> RGB565",   conv_0rgb1555_rgb565,   2, 2 },
+   { "RGB565   -> 0RGB1555", conv_rgb565_0rgb1555,   2, 2 },
+   { "RGB565   -> ARGB8888", conv_rgb565_argb8888,   2, 4 },
+   { "RGBA4444 -> ARGB8888", conv_rgba4444_argb8888, 2, 4 },
+   { "BGR24    -> ARGB8888", conv_bgr24_argb8888,    3, 4 },
+   { "ARGB8888 -> 0RGB1555", conv_argb8888_0rgb1555, 4, 2 },
+   { "ARGB8888 -> RGB565",   conv_argb8888_rgb565,   4, 2 },
+   { "ARGB8888 -> BGR24",    conv_argb8888_bgr24,    4, 3 },
+   { "ARGB8888 -> ABGR8888", conv_argb8888_abgr8888, 4, 4 },
+   { "0RGB1555 -> BGR24",    conv_0rgb1555_bgr24,    2, 3 },
+   { "RGB565   -> BGR24",    conv_rgb565_bgr24,      2, 3 },
+   { "YUYV     -> ARGB8888", conv_yuyv_argb8888,     2, 4 },
+};
+
+/* The scaler leaves CPU detection to its user. */
+uint64_t rarch_get_cpu_features(void)
+{
+   uint64_t cpu = 0;
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+   __builtin_cpu_init();
+   if (__builtin_cpu_supports("sse2"))
+      cpu |= RETRO_SIMD_SSE2;
+   if (__builtin_cpu_supports("ssse3"))
+      cpu |= RETRO_SIMD_SSSE3;
+   if (__builtin_cpu_supports("avx2"))
+      cpu |= RETRO_SIMD_AVX2;
+#elif defined(__ARM_NEON__)
+   cpu |= RETRO_SIMD_NEON;
+#endif
+   return cpu;
+}
+
+static double get_time(void)
+{
+   struct timespec tv;
+   clock_gettime(CLOCK_MONOTONIC, &tv);
+   return tv.tv_sec + tv.tv_nsec / 1000000000.0;
+}
+
+static unsigned fmt_size(enum scaler_pix_fmt fmt)
+{
+   switch (fmt)
+   {
+      case SCALER_FMT_0RGB1555:
+      case SCALER_FMT_RGB565:
+      case SCALER_FMT_YUYV:
+      case SCALER_FMT_RGBA4444:
+         return 2;
+      case SCALER_FMT_BGR24:
+         return 3;
+      default:
+         return 4;
+   }
+}
+
+static bool init_ctx(struct scaler_ctx *ctx, unsigned threads,
+      enum scaler_type type, enum scaler_pix_fmt in_fmt,
+      enum scaler_pix_fmt out_fmt,
+      int in_width, int in_height, int out_width, int out_height)
+{
+   memset(ctx, 0, sizeof(*ctx));
+   ctx->threads     = threads;
+   ctx->scaler_type = type;
+   ctx->in_fmt      = in_fmt;
+   ctx->out_fmt     = out_fmt;
+   ctx->in_width    = in_width;
+   ctx->in_height   = in_height;
+   ctx->in_stride   = in_width * fmt_size(in_fmt) + 32;
+   ctx->out_width   = out_width;
+   ctx->out_height  = out_height;
+   ctx->out_stride  = out_width * fmt_size(out_fmt) + 32;
+
+   if (scaler_ctx_gen_filter(ctx))
+      return true;
+
+   scaler_ctx_gen_reset(ctx);
+   return false;
+}
+
+/* Returns output megapixels per second. */
+static double benchmark(struct scaler_ctx *ctx, void *output,
+      const void *input, unsigned iterations)
+{
+   unsigned i;
+   double start = get_time(), elapsed;
+
+   for (i = 0; i < iterations; i++)
+      scaler_ctx_scale(ctx, output, input);
+
+   elapsed = get_time() - start;
+   return elapsed > 0.0 ? (double)ctx->out_width * ctx->out_height *
+      iterations / (elapsed * 1000000.0) : 0.0;
+}
+
+static int run(unsigned threads, enum scaler_type type,
+      int in_width, int in_height, int out_width, int out_height,
+      unsigned iterations)
+{
+   int in_fmt, out_fmt;
+   int failed = 0;
+
+   for (in_fmt = SCALER_FMT_ARGB8888; in_fmt <= SCALER_FMT_RGBA4444; in_fmt++)
+   {
+      for (out_fmt = SCALER_FMT_ARGB8888; out_fmt <= SCALER_FMT_RGBA4444; out_fmt++)
+      {
+         size_t i, in_size, out_size;
+         uint8_t *input, *serial_out, *threaded_out;
+         struct scaler_ctx serial, threaded;
+         double serial_mps, threaded_mps;
+
+         if (!init_ctx(&serial, 1, type, in_fmt, out_fmt,
+                  in_width, in_height, out_width, out_height))
+            continue;
+
+         if (!init_ctx(&threaded, threads, type, in_fmt, out_fmt,
+                  in_width, in_height, out_width, out_height))
+         {
+            fprintf(stderr, "Threaded scaler failed to init.\n");
+            scaler_ctx_gen_reset(&serial);
+            failed++;
+            continue;
+         }
+
+         in_size      = (size_t)serial.in_stride * in_height;
+         out_size     = (size_t)serial.out_stride * out_height;
+         input        = (uint8_t*)malloc(in_size);
+         serial_out   = (uint8_t*)calloc(1, out_size);
+         threaded_out = (uint8_t*)calloc(1, out_size);
+
+         for (i = 0; i < in_size; i++)
+            input[i] = (i * 2654435761u) >> 13;
+
+         scaler_ctx_scale(&serial, serial_out, input);
+         scaler_ctx_scale(&threaded, threaded_out, input);
+
+         if (memcmp(serial_out, threaded_out, out_size) != 0)
+         {
+            fprintf(stderr, "%-8s %-8s -> %-8s: threaded output differs!\n",
+                  type_names[serial.unscaled ? 0 : type],
+                  fmt_names[in_fmt], fmt_names[out_fmt]);
+            failed++;
+         }
+         else if (iterations)
+         {
+            serial_mps   = benchmark(&serial, serial_out, input, iterations);
+            threaded_mps = benchmark(&threaded, threaded_out, input, iterations);
+
+            fprintf(stderr, "%-8s %-8s -> %-8s: %8.1f MP/s, %u slices %8.1f MP/s (%.2fx).\n",
+                  type_names[serial.unscaled ? 0 : type],
+                  fmt_names[in_fmt], fmt_names[out_fmt],
+                  serial_mps, threaded.num_slices, threaded_mps,
+                  serial_mps > 0.0 ? threaded_mps / serial_mps : 0.0);
+         }
+
+         free(input);
+         free(serial_out);
+         free(threaded_out);
+         scaler_ctx_gen_reset(&serial);
+         scaler_ctx_gen_reset(&threaded);
+      }
+   }
+
+   return failed;
+}
+
+/* The frontend generates its 0RGB1555 converter without a size,
+ * then sets the size of every frame before converting it. */
+static int run_unsized(unsigned threads)
+{
+   size_t i, in_size, out_size;
+   uint8_t *input, *sized_out, *unsized_out;
+   struct scaler_ctx sized, unsized;
+   int failed = 0;
+
+   if (!init_ctx(&sized, threads, SCALER_TYPE_POINT,
+            SCALER_FMT_0RGB1555, SCALER_FMT_RGB565, 320, 240, 320, 240))
+      return 1;
+   if (!init_ctx(&unsized, threads, SCALER_TYPE_POINT,
+            SCALER_FMT_0RGB1555, SCALER_FMT_RGB565, 0, 0, 0, 0))
+   {
+      scaler_ctx_gen_reset(&sized);
+      return 1;
+   }
+
+   unsized.in_width   = sized.in_width;
+   unsized.in_height  = sized.in_height;
+   unsized.in_stride  = sized.in_stride;
+   unsized.out_width  = sized.out_width;
+   unsized.out_height = sized.out_height;
+   unsized.out_stride = sized.out_stride;
+
+   in_size     = (size_t)sized.in_stride * sized.in_height;
+   out_size    = (size_t)sized.out_stride * sized.out_height;
+   input       = (uint8_t*)malloc(in_size);
+   sized_out   = (uint8_t*)calloc(1, out_size);
+   unsized_out = (uint8_t*)calloc(1, out_size);
+
+   for (i = 0; i < in_size; i++)
+      input[i] = (i * 2654435761u) >> 13;
+
+   scaler_ctx_scale(&sized, sized_out, input);
+   scaler_ctx_scale(&unsized, unsized_out, input);
+
+   if (memcmp(sized_out, unsized_out, out_size) != 0)
+   {
+      fprintf(stderr, "Converter sized per frame differs, %u threads!\n",
+            threads);
+      failed++;
+   }
+
+   free(input);
+   free(sized_out);
+   free(unsized_out);
+   scaler_ctx_gen_reset(&sized);
+   scaler_ctx_gen_reset(&unsized);
+   return failed;
+}
+
+/* Converts with the C versions and with the given SIMD mask,
+ * for all widths up to a couple of vectors and a full frame. */
+static int run_conv(uint64_t simd_mask, const char *simd_name,
+      unsigned iterations)
+{
+   unsigned i;
+   int failed = 0;
+
+   for (i = 0; i < sizeof(convs) / sizeof(convs[0]); i++)
+   {
+      int width, j;
+      const int height     = 1080;
+      const int in_stride  = 1920 * convs[i].in_size + 16;
+      const int out_stride = 1920 * convs[i].out_size + 16;
+      uint8_t *input       = (uint8_t*)malloc(in_stride * height);
+      uint8_t *ref_out     = (uint8_t*)malloc(out_stride * height);
+      uint8_t *simd_out    = (uint8_t*)malloc(out_stride * height);
+      double c_mps = 0.0, simd_mps = 0.0;
+
+      for (j = 0; j < in_stride * height; j++)
+         input[j] = (j * 2654435761u) >> 13;
+
+      for (width = 1; width <= 1920; width += width < 96 ? 1 : 1920 - 96)
+      {
+         int rows = width < 96 ? 3 : height;
+
+         /* YUYV comes in pixel pairs. */
+         if (convs[i].func == conv_yuyv_argb8888 && (width & 1))
+            continue;
+
+         /* Fill with different junk, so untouched bytes show up too. */
+         memset(ref_out, 0x5a, out_stride * rows);
+         memset(simd_out, 0xa5, out_stride * rows);
+
+         conv_init(0);
+         convs[i].func(ref_out, input, width, rows, out_stride, in_stride);
+         conv_init(simd_mask);
+         convs[i].func(simd_out, input, width, rows, out_stride, in_stride);
+
+         for (j = 0; j < rows; j++)
+         {
+            if (memcmp(ref_out + j * out_stride, simd_out + j * out_stride,
+                     width * convs[i].out_size) != 0)
+            {
+               fprintf(stderr, "%s %s: output differs at width %d!\n",
+                     convs[i].name, simd_name, width);
+               failed++;
+               break;
+            }
+         }
+      }
+
+      if (iterations)
+      {
+         unsigned k;
+         double start;
+
+         conv_init(0);
+         start = get_time();
+         for (k = 0; k < iterations; k++)
+            convs[i].func(ref_out, input, 1920, height, out_stride, in_stride);
+         c_mps = 1920.0 * height * iterations / ((get_time() - start) * 1000000.0);
+
+         conv_init(simd_mask);
+         start = get_time();
+         for (k = 0; k < iterations; k++)
+            convs[i].func(simd_out, input, 1920, height, out_stride, in_stride);
+         simd_mps = 1920.0 * height * iterations / ((get_time() - start) * 1000000.0);
+
+         fprintf(stderr, "%-20s: C %8.1f MP/s, %-5s %8.1f MP/s (%.2fx).\n",
+               convs[i].name, c_mps, simd_name, simd_mps, simd_mps / c_mps);
+      }
+
+      free(input);
+      free(ref_out);
+      free(simd_out);
+   }
+
+   conv_init(rarch_get_cpu_features());
+   return failed;
+}
+
+int main(int argc, char *argv[])
+{
+   int failed = 0;
+   unsigned threads, iterations;
+
+   if (argc > 3)
+   {
+      fprintf(stderr, "Usage: %s [threads] [iterations]\n", argv[0]);
+      return 1;
+   }
+
+   threads    = argc >= 2 ? strtoul(argv[1], NULL, 0) : 4;
+   iterations = argc == 3 ? strtoul(argv[2], NULL, 0) : 20;
+
+   {
+      uint64_t cpu = rarch_get_cpu_features();
+
+      if (cpu & RETRO_SIMD_SSE2)
+      {
+         fprintf(stderr, "Pixel conversion, SSE2:\n");
+         failed += run_conv(RETRO_SIMD_SSE2 | (cpu & RETRO_SIMD_SSSE3),
+               "SSE2", iterations);
+      }
+      if (cpu & RETRO_SIMD_AVX2)
+      {
+         fprintf(stderr, "\nPixel conversion, AVX2:\n");
+         failed += run_conv(cpu, "AVX2", iterations);
+      }
+      if (cpu & RETRO_SIMD_NEON)
+      {
+         fprintf(stderr, "Pixel conversion, NEON:\n");
+         failed += run_conv(cpu, "NEON", iterations);
+      }
+   }
+
+   fprintf(stderr, "\n1920x1080 -> 640x360:\n");
+   failed += run(threads, SCALER_TYPE_POINT, 1920, 1080, 640, 360, iterations);
+   failed += run(threads, SCALER_TYPE_BILINEAR, 1920, 1080, 640, 360, iterations);
+   failed += run(threads, SCALER_TYPE_SINC, 1920, 1080, 640, 360, iterations);
+
+   fprintf(stderr, "\n320x240 -> 1280x960:\n");
+   failed += run(threads, SCALER_TYPE_POINT, 320, 240, 1280, 960, iterations);
+   failed += run(threads, SCALER_TYPE_BILINEAR, 320, 240, 1280, 960, iterations);
+   failed += run(threads, SCALER_TYPE_SINC, 320, 240, 1280, 960, iterations);
+
+   fprintf(stderr, "\n1280x720 unscaled:\n");
+   failed += run(threads, SCALER_TYPE_POINT, 1280, 720, 1280, 720, iterations);
+
+   /* Odd sizes, where slices don't split evenly. */
+   failed += run(threads, SCALER_TYPE_BILINEAR, 257, 223, 1021, 767, 0);
+   failed += run(threads, SCALER_TYPE_SINC, 1023, 767, 301, 199, 0);
+
+   failed += run_unsized(1);
+   failed += run_unsized(threads);
+
+   if (failed)
+   {
+      fprintf(stderr, "%d tests failed!\n", failed);
+      return 2;
+   }
+
+   fprintf(stderr, "\nThreaded scaling is bit-identical to serial scaling, "
+         "SIMD conversion to C conversion.\n");
+   return 0;
+}
@@ -24,24 +24,27 @@
 #include "py_state/py_state.h"
 #endif
 
+/* An import, compiled by state_tracker_init(). */
 struct state_tracker_internal
 {
    char id[64];
 
-   bool is_input;
-   const uint16_t *input_ptr;
-   const uint8_t *ptr;
+   /* Position in the uniforms array. */
+   unsigned index;
+   /* Index into state_tracker::values. */
+   unsigned source;
 #ifdef HAVE_PYTHON
    py_state_t *py;
 #endif
 
-   uint32_t addr;
    uint16_t mask;
-
    uint16_t equal;
 
    enum state_tracker_type type;
 
+   /* Value of the uniform after the last update. */
+   float value;
+
    uint32_t prev[2];
    int frame_count;
    int frame_count_prev;
@@ -49,21 +52,51 @@ struct state_tracker_internal
    int transition_count;
 };
 
+/* values[] starts with the two input slots,
+ * followed by one entry per distinct memory address. */
+#define STATE_SOURCE_INPUT_SLOT1 0
+#define STATE_SOURCE_INPUT_SLOT2 1
+#define STATE_SOURCE_MEMORY      2
+
 struct state_tracker
 {
+   /* Imports, sorted by type. Imports of type t are
+    * [t ? type_end[t - 1] : 0, type_end[t]). */
    struct state_tracker_internal *info;
    unsigned info_elem;
+   unsigned type_end[RARCH_STATE_PYTHON + 1];
 
-   uint16_t input_state[2];
+   /* Every address is read once per frame, 
+    * no matter how many imports use it. */
+   const uint8_t **sources;
+   unsigned num_sources;
+   uint16_t *values;
+
+   bool input_used[2];
 
 #ifdef HAVE_PYTHON
    py_state_t *py;
 #endif
 };
 
+/* Returns the index into values[] reading from addr,
+ * adding it to the sources if needed. */
+static unsigned state_tracker_add_source(state_tracker_t *tracker,
+      const uint8_t *addr)
+{
+   unsigned i;
+   for (i = 0; i < tracker->num_sources; i++)
+      if (tracker->sources[i] == addr)
+         return STATE_SOURCE_MEMORY + i;
+
+   tracker->sources[tracker->num_sources] = addr;
+   return STATE_SOURCE_MEMORY + tracker->num_sources++;
+}
+
 state_tracker_t* state_tracker_init(const struct state_tracker_info *info)
 {
    unsigned i;
+   unsigned type_begin[RARCH_STATE_PYTHON + 1] = {0};
    state_tracker_t *tracker = (state_tracker_t*)calloc(1, sizeof(*tracker));
    if (!tracker)
       return NULL;
@@ -85,59 +118,83 @@ state_tracker_t* state_tracker_init(const struct state_tracker_info *info)
 
    tracker->info = (struct state_tracker_internal*)
       calloc(info->info_elem, sizeof(struct state_tracker_internal));
+   tracker->sources = (const uint8_t**)
+      calloc(info->info_elem, sizeof(*tracker->sources));
+   tracker->values = (uint16_t*)
+      calloc(STATE_SOURCE_MEMORY + info->info_elem, sizeof(uint16_t));
 
-   if (!tracker->info)
+   if (!tracker->info || !tracker->sources || !tracker->values)
    {
       RARCH_ERR("Allocation of state tracker info failed.\n");
-      free(tracker);
+      state_tracker_free(tracker);
       return NULL;
    }
 
    tracker->info_elem = info->info_elem;
 
+   /* Counting sort by type, keeping the original order within a type. */
+   for (i = 0; i < info->info_elem; i++)
+   {
+      if (info->info[i].type > RARCH_STATE_PYTHON)
+      {
+         RARCH_ERR("Invalid state tracker type %d for \"%s\".\n",
+               info->info[i].type, info->info[i].id);
+         state_tracker_free(tracker);
+         return NULL;
+      }
+      tracker->type_end[info->info[i].type]++;
+   }
+   for (i = 1; i <= RARCH_STATE_PYTHON; i++)
+   {
+      type_begin[i] = tracker->type_end[i - 1];
+      tracker->type_end[i] += tracker->type_end[i - 1];
+   }
+
    for (i = 0; i < info->info_elem; i++)
    {
-      strlcpy(tracker->info[i].id, info->info[i].id,
-            sizeof(tracker->info[i].id));
-      tracker->info[i].addr  = info->info[i].addr;
-      tracker->info[i].type  = info->info[i].type;
-      tracker->info[i].mask  = (info->info[i].mask == 0) 
+      /* If we don't have a valid pointer. */
+      static const uint8_t empty = 0;
+      struct state_tracker_internal *elem = 
+         &tracker->info[type_begin[info->info[i].type]++];
+
+      strlcpy(elem->id, info->info[i].id, sizeof(elem->id));
+      elem->index = i;
+      elem->type  = info->info[i].type;
+      elem->mask  = (info->info[i].mask == 0) 
          ? 0xffff : info->info[i].mask;
-      tracker->info[i].equal = info->info[i].equal;
+      elem->equal = info->info[i].equal;
 
 #ifdef HAVE_PYTHON
       if (info->info[i].type == RARCH_STATE_PYTHON)
       {
          if (!tracker->py)
          {
-            free(tracker->info);
-            free(tracker);
+            state_tracker_free(tracker);
             RARCH_ERR("Python semantic was requested, but Python tracker is not loaded.\n");
             return NULL;
          }
-         tracker->info[i].py = tracker->py;
+         elem->py = tracker->py;
+         continue;
       }
 #endif
 
-      /* If we don't have a valid pointer. */
-      static const uint8_t empty = 0;
-
       switch (info->info[i].ram_type)
       {
          case RARCH_STATE_WRAM:
-            tracker->info[i].ptr = info->wram ? info->wram : &empty;
+            elem->source = state_tracker_add_source(tracker, info->wram ?
+                  info->wram + info->info[i].addr : &empty);
             break;
          case RARCH_STATE_INPUT_SLOT1:
-            tracker->info[i].input_ptr = &tracker->input_state[0];
-            tracker->info[i].is_input = true;
+            elem->source = STATE_SOURCE_INPUT_SLOT1;
+            tracker->input_used[0] = true;
             break;
          case RARCH_STATE_INPUT_SLOT2:
-            tracker->info[i].input_ptr = &tracker->input_state[1];
-            tracker->info[i].is_input = true;
+            elem->source = STATE_SOURCE_INPUT_SLOT2;
+            tracker->input_used[1] = true;
             break;
 
          default:
-            tracker->info[i].ptr = &empty;
+            elem->source = state_tracker_add_source(tracker, &empty);
       }
    }
 
@@ -149,6 +206,8 @@ void state_tracker_free(state_tracker_t *tracker)
    if (tracker)
    {
       free(tracker->info);
+      free(tracker->sources);
+      free(tracker->values);
 #ifdef HAVE_PYTHON
       py_state_free(tracker->py);
 #endif
@@ -157,15 +216,10 @@ void state_tracker_free(state_tracker_t *tracker)
    free(tracker);
 }
 
-static inline uint16_t fetch(const struct state_tracker_internal *info)
+static inline uint16_t fetch(const state_tracker_t *tracker,
+      const struct state_tracker_internal *info)
 {
-   uint16_t val = 0;
-   if (info->is_input)
-      val = *info->input_ptr;
-   else
-      val = info->ptr[info->addr];
-
-   val &= info->mask;
+   uint16_t val = tracker->values[info->source] & info->mask;
 
    if (info->equal && val != info->equal)
       val = 0;
@@ -173,123 +227,64 @@ static inline uint16_t fetch(const struct state_tracker_internal *info)
    return val;
 }
 
-static void update_element(
-      struct state_tracker_uniform *uniform,
-      struct state_tracker_internal *info,
-      unsigned frame_count)
-{
-   uniform->id = info->id;
-
-   switch (info->type)
-   {
-      case RARCH_STATE_CAPTURE:
-         uniform->value = fetch(info);
-         break;
-
-      case RARCH_STATE_CAPTURE_PREV:
-         if (info->prev[0] != fetch(info))
-         {
-            info->prev[1] = info->prev[0];
-            info->prev[0] = fetch(info);
-         }
-         uniform->value = info->prev[1];
-         break;
-
-      case RARCH_STATE_TRANSITION:
-         if (info->old_value != fetch(info))
-         {
-            info->old_value = fetch(info);
-            info->frame_count = frame_count;
-         }
-         uniform->value = info->frame_count;
-         break;
-
-      case RARCH_STATE_TRANSITION_COUNT:
-         if (info->old_value != fetch(info))
-         {
-            info->old_value = fetch(info);
-            info->transition_count++;
-         }
-         uniform->value = info->transition_count;
-         break;
-
-      case RARCH_STATE_TRANSITION_PREV:
-         if (info->old_value != fetch(info))
-         {
-            info->old_value = fetch(info);
-            info->frame_count_prev = info->frame_count;
-            info->frame_count = frame_count;
-         }
-         uniform->value = info->frame_count_prev;
-         break;
-      
-#ifdef HAVE_PYTHON
-      case RARCH_STATE_PYTHON:
-         uniform->value = py_state_get(info->py, info->id, frame_count);
-         break;
-#endif
-      
-      default:
-         break;
-   }
-}
+/* SNES bit order of the RetroPad buttons, starting at bit 4. */
+static const unsigned state_tracker_buttons[] = {
+   RETRO_DEVICE_ID_JOYPAD_R,
+   RETRO_DEVICE_ID_JOYPAD_L,
+   RETRO_DEVICE_ID_JOYPAD_X,
+   RETRO_DEVICE_ID_JOYPAD_A,
+   RETRO_DEVICE_ID_JOYPAD_RIGHT,
+   RETRO_DEVICE_ID_JOYPAD_LEFT,
+   RETRO_DEVICE_ID_JOYPAD_DOWN,
+   RETRO_DEVICE_ID_JOYPAD_UP,
+   RETRO_DEVICE_ID_JOYPAD_START,
+   RETRO_DEVICE_ID_JOYPAD_SELECT,
+   RETRO_DEVICE_ID_JOYPAD_Y,
+   RETRO_DEVICE_ID_JOYPAD_B,
+};
 
-/* Updates 16-bit input in same format as SNES itself. */
+/* Updates 16-bit input in same format as SNES itself.
+ * Player 1 comes from the input the main loop polled this frame,
+ * player 2 is only queried if an import uses it. */
 static void update_input(state_tracker_t *tracker)
 {
    unsigned i;
-   if (driver.input == NULL)
-      return;
-
-   static const unsigned buttons[] = {
-      RETRO_DEVICE_ID_JOYPAD_R,
-      RETRO_DEVICE_ID_JOYPAD_L,
-      RETRO_DEVICE_ID_JOYPAD_X,
-      RETRO_DEVICE_ID_JOYPAD_A,
-      RETRO_DEVICE_ID_JOYPAD_RIGHT,
-      RETRO_DEVICE_ID_JOYPAD_LEFT,
-      RETRO_DEVICE_ID_JOYPAD_DOWN,
-      RETRO_DEVICE_ID_JOYPAD_UP,
-      RETRO_DEVICE_ID_JOYPAD_START,
-      RETRO_DEVICE_ID_JOYPAD_SELECT,
-      RETRO_DEVICE_ID_JOYPAD_Y,
-      RETRO_DEVICE_ID_JOYPAD_B,
-   };
-
-   /* Only bind for up to two players for now. */
-   static const struct retro_keybind *binds[2] = {
-      g_settings.input.binds[0],
-      g_settings.input.binds[1],
-   };
-
-   for (i = 0; i < 2; i++)
-      input_push_analog_dpad(g_settings.input.binds[i],
-            g_settings.input.analog_dpad_mode[i]);
-   for (i = 0; i < MAX_PLAYERS; i++)
-      input_push_analog_dpad(g_settings.input.autoconf_binds[i],
-            g_settings.input.analog_dpad_mode[i]);
-
    uint16_t state[2] = {0};
+
    if (!driver.block_libretro_input)
    {
-      for (i = 4; i < 16; i++)
+      if (tracker->input_used[0])
       {
-         state[0] |= (driver.input->input_state(
-                  driver.input_data, binds, 0, 
-                  RETRO_DEVICE_JOYPAD, 0, buttons[i - 4]) ? 1 : 0) << i;
-         state[1] |= (driver.input->input_state(
-                  driver.input_data, binds, 1, 
-                  RETRO_DEVICE_JOYPAD, 0, buttons[i - 4]) ? 1 : 0) << i;
+         for (i = 4; i < 16; i++)
+            state[0] |= ((g_extern.frame_input >>
+                     state_tracker_buttons[i - 4]) & 1) << i;
       }
-   }
 
-   for (i = 0; i < 2; i++)
-      input_pop_analog_dpad(g_settings.input.binds[i]);
-   for (i = 0; i < MAX_PLAYERS; i++)
-      input_pop_analog_dpad(g_settings.input.autoconf_binds[i]);
+      if (tracker->input_used[1] && driver.input)
+      {
+         const struct retro_keybind *binds[2] = {
+            g_settings.input.binds[0],
+            g_settings.input.binds[1],
+         };
+
+         input_push_analog_dpad(g_settings.input.binds[1],
+               g_settings.input.analog_dpad_mode[1]);
+         input_push_analog_dpad(g_settings.input.autoconf_binds[1],
+               g_settings.input.analog_dpad_mode[1]);
+
+         for (i = 4; i < 16; i++)
+            state[1] |= (driver.input->input_state(
+                     driver.input_data, binds, 1, 
+                     RETRO_DEVICE_JOYPAD, 0,
+                     state_tracker_buttons[i - 4]) ? 1 : 0) << i;
+
+         input_pop_analog_dpad(g_settings.input.binds[1]);
+         input_pop_analog_dpad(g_settings.input.autoconf_binds[1]);
+      }
+   }
 
-   for (i = 0; i < 2; i++)
-      tracker->input_state[i] = state[i];
+   tracker->values[STATE_SOURCE_INPUT_SLOT1] = state[0];
+   tracker->values[STATE_SOURCE_INPUT_SLOT2] = state[1];
 }
 
 unsigned state_get_uniform(state_tracker_t *tracker,
@@ -297,13 +292,78 @@ unsigned state_get_uniform(state_tracker_t *tracker,
       unsigned elem, unsigned frame_count)
 {
    unsigned i, elems;
+   struct state_tracker_internal *info = tracker->info;
+   const unsigned *end = tracker->type_end;
    elems = tracker->info_elem < elem ? tracker->info_elem : elem;
 
-   update_input(tracker);
+   if (tracker->input_used[0] || tracker->input_used[1])
+      update_input(tracker);
+
+   for (i = 0; i < tracker->num_sources; i++)
+      tracker->values[STATE_SOURCE_MEMORY + i] = *tracker->sources[i];
+
+   for (i = 0; i < end[RARCH_STATE_CAPTURE]; i++)
+      info[i].value = fetch(tracker, &info[i]);
+
+   for (; i < end[RARCH_STATE_CAPTURE_PREV]; i++)
+   {
+      uint16_t val = fetch(tracker, &info[i]);
+      if (info[i].prev[0] != val)
+      {
+         info[i].prev[1] = info[i].prev[0];
+         info[i].prev[0] = val;
+      }
+      info[i].value = info[i].prev[1];
+   }
+
+   for (; i < end[RARCH_STATE_TRANSITION]; i++)
+   {
+      uint16_t val = fetch(tracker, &info[i]);
+      if (info[i].old_value != val)
+      {
+         info[i].old_value = val;
+         info[i].frame_count = frame_count;
+      }
+      info[i].value = info[i].frame_count;
+   }
+
+   for (; i < end[RARCH_STATE_TRANSITION_COUNT]; i++)
+   {
+      uint16_t val = fetch(tracker, &info[i]);
+      if (info[i].old_value != val)
+      {
+         info[i].old_value = val;
+         info[i].transition_count++;
+      }
+      info[i].value = info[i].transition_count;
+   }
+
+   for (; i < end[RARCH_STATE_TRANSITION_PREV]; i++)
+   {
+      uint16_t val = fetch(tracker, &info[i]);
+      if (info[i].old_value != val)
+      {
+         info[i].old_value = val;
+         info[i].frame_count_prev = info[i].frame_count;
+         info[i].frame_count = frame_count;
+      }
+      info[i].value = info[i].frame_count_prev;
+   }
+
+#ifdef HAVE_PYTHON
+   for (; i < end[RARCH_STATE_PYTHON]; i++)
+      info[i].value = py_state_get(info[i].py, info[i].id, frame_count);
+#endif
+
+   /* Write out in the order the imports were given. */
+   for (i = 0; i < tracker->info_elem; i++)
+   {
+      if (info[i].index >= elems)
+         continue;
 
-   for (i = 0; i < elems; i++)
-      update_element(&uniforms[i], &tracker->info[i], frame_count);
+      uniforms[info[i].index].id    = info[i].id;
+      uniforms[info[i].index].value = info[i].value;
+   }
 
    return elems;
 }
-
@@ -91,11 +91,16 @@ static void thread_loop(void *data)
    {
       bool ret = false;
       bool updated = false;
+      unsigned dirty_y = 0, dirty_end = 0;
       slock_lock(thr->lock);
       while (thr->send_cmd == CMD_NONE && !thr->frame.updated)
          scond_wait(thr->cond_thread, thr->lock);
       if (thr->frame.updated)
+      {
          updated = true;
+         dirty_y = thr->frame.dirty_y;
+         dirty_end = thr->frame.dirty_end;
+      }
 
       /* To avoid race condition where send_cmd is updated 
        * right after the switch is checked. */
@@ -292,10 +297,20 @@ static void thread_loop(void *data)
          bool alive = false;
          bool focus = false;
          struct rarch_viewport vp = {0};
+         const void *frame = thr->frame.buffer;
+
+         if (thr->frame.driver_stale)
+            thr->frame.driver_stale = false;
+         else if (dirty_y >= dirty_end)
+            frame = NULL; /* The driver still has this frame. */
+         else if ((dirty_y > 0 || dirty_end < thr->frame.height) &&
+               thr->poke && thr->poke->set_frame_dirty)
+            thr->poke->set_frame_dirty(thr->driver_data,
+                  dirty_y, dirty_end - dirty_y);
 
          if (thr->driver && thr->driver->frame)
             ret = thr->driver->frame(thr->driver_data,
-               thr->frame.buffer, thr->frame.width, thr->frame.height,
+               frame, thr->frame.width, thr->frame.height,
                thr->frame.pitch, *thr->frame.msg ? thr->frame.msg : NULL);
 
          slock_unlock(thr->frame.lock);
@@ -375,6 +390,10 @@ static bool thread_frame(void *data, const void *frame_,
    {
       thread_update_driver_state(thr);
 
+      thr->frame.next_y = 0;
+      thr->frame.next_end = UINT_MAX;
+      thr->frame.driver_stale = true;
+
       if (thr->driver && thr->driver->frame)
          return thr->driver->frame(thr->driver_data, frame_,
                width, height, pitch, msg);
@@ -390,6 +409,13 @@ static bool thread_frame(void *data, const void *frame_,
    const uint8_t *src = (const uint8_t*)frame_;
    uint8_t *dst = thr->frame.buffer;
 
+   /* Only rows which changed need copying. */
+   unsigned dirty_y = thr->frame.next_y;
+   unsigned dirty_end = thr->frame.next_end < height ?
+      thr->frame.next_end : height;
+   thr->frame.next_y = 0;
+   thr->frame.next_end = UINT_MAX;
+
    slock_lock(thr->lock);
 
    if (!thr->nonblock)
@@ -419,10 +445,37 @@ static bool thread_frame(void *data, const void *frame_,
       if (src)
       {
          unsigned h;
-         for (h = 0; h < height; h++, src += pitch, dst += copy_stride)
+
+         /* Rows changed in dropped frames are outdated in buffer too. */
+         if (thr->frame.dropped_y < dirty_y)
+            dirty_y = thr->frame.dropped_y;
+         if (thr->frame.dropped_end > dirty_end)
+            dirty_end = thr->frame.dropped_end < height ?
+               thr->frame.dropped_end : height;
+         thr->frame.dropped_y = UINT_MAX;
+         thr->frame.dropped_end = 0;
+
+         if (width != thr->frame.width || height != thr->frame.height)
+         {
+            dirty_y = 0;
+            dirty_end = height;
+         }
+
+         src += dirty_y * pitch;
+         dst += dirty_y * copy_stride;
+         for (h = dirty_y; h < dirty_end;
+               h++, src += pitch, dst += copy_stride)
             memcpy(dst, src, copy_stride);
       }
+      else
+      {
+         /* Dupe, buffer is unchanged. */
+         dirty_y = UINT_MAX;
+         dirty_end = 0;
+      }
 
+      thr->frame.dirty_y = dirty_y;
+      thr->frame.dirty_end = dirty_end;
       thr->frame.updated = true;
       thr->frame.width  = width;
       thr->frame.height = height;
@@ -445,7 +498,16 @@ static bool thread_frame(void *data, const void *frame_,
       thr->hit_count++;
    }
    else
+   {
+      if (src)
+      {
+         if (dirty_y < thr->frame.dropped_y)
+            thr->frame.dropped_y = dirty_y;
+         if (dirty_end > thr->frame.dropped_end)
+            thr->frame.dropped_end = dirty_end;
+      }
       thr->miss_count++;
+   }
 
    slock_unlock(thr->lock);
 
@@ -483,6 +545,8 @@ static bool thread_init(thread_video_t *thr, const video_info_t *info,
       return false;
 
    memset(thr->frame.buffer, 0x80, max_size);
+   thr->frame.next_end = UINT_MAX;
+   thr->frame.dropped_y = UINT_MAX;
 
    thr->last_time = rarch_get_time_usec();
 
@@ -748,6 +812,13 @@ static struct gfx_shader *thread_get_current_shader(void *data)
    return thr->poke ? thr->poke->get_current_shader(thr->driver_data) : NULL;
 }
 
+static void thread_set_frame_dirty(void *data, unsigned y, unsigned height)
+{
+   thread_video_t *thr = (thread_video_t*)data;
+   thr->frame.next_y = y;
+   thr->frame.next_end = y + height;
+}
+
 static const video_poke_interface_t thread_poke = {
    thread_set_filtering,
 #ifdef HAVE_FBO
@@ -766,6 +837,7 @@ static const video_poke_interface_t thread_poke = {
    NULL,
 
    thread_get_current_shader,
+   thread_set_frame_dirty,
 };
 
 static void thread_get_poke_interface(void *data,
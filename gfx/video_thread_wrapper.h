@@ -173,6 +173,19 @@ typedef struct thread_video
       bool updated;
       bool within_thread;
       char msg[PATH_MAX];
+
+      /* Rows [next_y, next_end) of the next frame changed,
+       * as told by set_frame_dirty. */
+      unsigned next_y;
+      unsigned next_end;
+      /* Rows changed in frames dropped since buffer was written. */
+      unsigned dropped_y;
+      unsigned dropped_end;
+      /* Rows of buffer which changed since the driver last got it. */
+      unsigned dirty_y;
+      unsigned dirty_end;
+      /* The driver last rendered something other than buffer. */
+      bool driver_stale;
    } frame;
 
    video_driver_t video_thread;
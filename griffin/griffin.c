@@ -206,6 +206,7 @@ VIDEO DRIVER
 #endif
 
 #include "../gfx/gfx_common.c"
+#include "../gfx/frame_dupe.c"
 
 #ifdef _XBOX
 #include "../xdk/xdk_resources.cpp"
@@ -491,6 +492,9 @@ SCALERS
 #include "../gfx/scaler/pixconv.c"
 #include "../gfx/scaler/scaler.c"
 #include "../gfx/scaler/scaler_int.c"
+#ifdef HAVE_THREADS
+#include "../gfx/scaler/scaler_pool.c"
+#endif
 
 /*============================================================
 FILTERS
@@ -530,6 +534,7 @@ DYNAMIC
 FILE
 ============================================================ */
 #include "../file.c"
+#include "../file_map.c"
 #include "../dir_list.c"
 #include "../string_list.c"
 #include "../file_path.c"
@@ -554,6 +559,8 @@ SETTINGS
 REWIND
 ============================================================ */
 #include "../rewind.c"
+#include "../runahead.c"
+#include "../savestate.c"
 
 /*============================================================
 FRONTEND
@@ -606,6 +613,14 @@ RECORDING
 #include "../movie.c"
 #include "../record/ffemu.c"
 
+#ifdef HAVE_THREADS
+#include "../record/frame_pool.c"
+#endif
+
+#ifdef HAVE_RLV
+#include "../record/rlv.c"
+#endif
+
 /*============================================================
 THREAD
 ============================================================ */
@@ -684,6 +699,10 @@ MENU
 #include "../command.c"
 #endif
 
+#ifdef HAVE_CONTROL
+#include "../control.c"
+#endif
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -52,6 +52,35 @@
  * for comparing with the cheat XML values. */
 void sha256_hash(char *out, const uint8_t *in, size_t size);
 
+/* djb2 hash of a string, NULL hashes like an empty string.
+ * Playlists store it, so it must not change. */
+static inline uint32_t djb2_calculate(const char *str)
+{
+   uint32_t hash = 5381;
+
+   if (str)
+   {
+      while (*str)
+         hash = (hash << 5) + hash + (uint8_t)*str++;
+   }
+
+   return hash;
+}
+
+/* Home slot of a hash in an open addressed table of mask + 1 slots.
+ * Mixes in the high bits first, which djb2 leaves similar for
+ * similar keys.
+ *
+ * Such tables probe linearly from the home slot. Most store the entry
+ * index plus one in each slot, so 0 is empty. */
+static inline size_t hash_bucket(uint32_t hash, size_t mask)
+{
+   hash ^= hash >> 16;
+   hash *= 0x45d9f3bu;
+   hash ^= hash >> 16;
+   return hash & mask;
+}
+
 #ifdef HAVE_ZLIB
 #include <zlib.h>
 
@@ -19,8 +19,16 @@
 #include <string.h>
 #include <stdlib.h>
 #include <ctype.h>
+#include <time.h>
 
 #include "../general.h"
+#include "../dir_list.h"
+#include "../hash.h"
+
+#ifndef _XBOX
+#include <sys/types.h>
+#include <sys/stat.h>
+#endif
 
 static void input_autoconfigure_joypad_conf(config_file_t *conf,
       struct retro_keybind *binds)
@@ -93,11 +101,301 @@ found:
    return true;
 }
 
+/* Identifying keys of one autoconfig profile. Profiles are
+ * indexed by vendor/product ID and by device name, so a hotplug
+ * only has to parse the one profile that matches. */
+struct autoconfig_entry
+{
+   char *path;
+   unsigned builtin;
+   char *ident;
+   char *driver;
+   int32_t vid;
+   int32_t pid;
+};
+
+struct autoconfig_index
+{
+   struct autoconfig_entry *entries;
+   size_t size;
+   size_t capacity;
+
+   /* See hash_bucket(). */
+   uint32_t *by_name;
+   uint32_t *by_id;
+   size_t mask;
+
+   char dir[PATH_MAX];
+   time_t mtime;
+   bool valid;
+};
+
+#if defined(HAVE_BUILTIN_AUTOCONFIG) && (!defined(_WIN32) || defined(HAVE_WINXINPUT))
+#define HAVE_AUTOCONFIG_BUILTINS
+static struct autoconfig_index autoconfig_builtin;
+#endif
+static struct autoconfig_index autoconfig_files;
+
+static uint32_t autoconfig_hash_id(int32_t vid, int32_t pid)
+{
+   return (uint32_t)vid * 65599u + (uint32_t)pid;
+}
+
+static void autoconfig_index_free(struct autoconfig_index *index)
+{
+   size_t i;
+
+   for (i = 0; i < index->size; i++)
+   {
+      free(index->entries[i].path);
+      free(index->entries[i].ident);
+      free(index->entries[i].driver);
+   }
+
+   free(index->entries);
+   free(index->by_name);
+   free(index->by_id);
+   index->entries  = NULL;
+   index->by_name  = NULL;
+   index->by_id    = NULL;
+   index->size     = 0;
+   index->capacity = 0;
+   index->valid    = false;
+}
+
+static void autoconfig_index_add(struct autoconfig_index *index,
+      config_file_t *conf, const char *path, unsigned builtin)
+{
+   char ident[PATH_MAX], driver[PATH_MAX];
+   struct autoconfig_entry *entry;
+
+   if (!conf)
+      return;
+
+   if (index->size == index->capacity)
+   {
+      size_t capacity = index->capacity ? index->capacity * 2 : 64;
+      struct autoconfig_entry *entries = (struct autoconfig_entry*)
+         realloc(index->entries, capacity * sizeof(*entries));
+      if (!entries)
+         return;
+      index->entries  = entries;
+      index->capacity = capacity;
+   }
+
+   *ident = *driver = '\0';
+   entry = &index->entries[index->size];
+   memset(entry, 0, sizeof(*entry));
+
+   config_get_array(conf, "input_device", ident, sizeof(ident));
+   config_get_array(conf, "input_driver", driver, sizeof(driver));
+   config_get_int(conf, "input_vendor_id", &entry->vid);
+   config_get_int(conf, "input_product_id", &entry->pid);
+
+   entry->path    = path ? strdup(path) : NULL;
+   entry->builtin = builtin;
+   entry->ident   = strdup(ident);
+   entry->driver  = strdup(driver);
+
+   if (!entry->ident || !entry->driver || (path && !entry->path))
+   {
+      free(entry->path);
+      free(entry->ident);
+      free(entry->driver);
+      return;
+   }
+
+   index->size++;
+}
+
+static void autoconfig_index_insert(struct autoconfig_index *index,
+      uint32_t *table, uint32_t hash, size_t entry)
+{
+   size_t slot = hash_bucket(hash, index->mask);
+
+   while (table[slot])
+      slot = (slot + 1) & index->mask;
+   table[slot] = entry + 1;
+}
+
+static bool autoconfig_index_finish(struct autoconfig_index *index)
+{
+   size_t i, slots = 16;
+
+   while (slots < index->size * 2)
+      slots *= 2;
+
+   index->mask    = slots - 1;
+   index->by_name = (uint32_t*)calloc(slots, sizeof(uint32_t));
+   index->by_id   = (uint32_t*)calloc(slots, sizeof(uint32_t));
+   if (!index->by_name || !index->by_id)
+   {
+      autoconfig_index_free(index);
+      return false;
+   }
+
+   for (i = 0; i < index->size; i++)
+   {
+      const struct autoconfig_entry *entry = &index->entries[i];
+
+      autoconfig_index_insert(index, index->by_name,
+            djb2_calculate(entry->ident), i);
+      if (entry->vid && entry->pid)
+         autoconfig_index_insert(index, index->by_id,
+               autoconfig_hash_id(entry->vid, entry->pid), i);
+   }
+
+   index->valid = true;
+   return true;
+}
+
+#ifdef HAVE_AUTOCONFIG_BUILTINS
+static void autoconfig_index_builtins(void)
+{
+   unsigned i;
+   struct autoconfig_index *index = &autoconfig_builtin;
+
+   if (index->valid)
+      return;
+
+   for (i = 0; input_builtin_autoconfs[i]; i++)
+   {
+      config_file_t *conf = (config_file_t*)
+         config_file_new_from_string(input_builtin_autoconfs[i]);
+      autoconfig_index_add(index, conf, NULL, i);
+      config_file_free(conf);
+   }
+
+   autoconfig_index_finish(index);
+}
+#endif
+
+static bool autoconfig_dir_mtime(const char *dir, time_t *mtime)
+{
+#if defined(_XBOX)
+   return false;
+#else
+   struct stat buf;
+   if (stat(dir, &buf) < 0)
+      return false;
+   *mtime = buf.st_mtime;
+   return true;
+#endif
+}
+
+/* Adding, removing or renaming a profile changes the directory's
+ * mtime. Profiles edited in place are caught when they are loaded. */
+static void autoconfig_index_dir(const char *dir)
+{
+   size_t i;
+   time_t mtime = 0;
+   struct string_list *list;
+   struct autoconfig_index *index = &autoconfig_files;
+   bool have_mtime = autoconfig_dir_mtime(dir, &mtime);
+
+   if (index->valid && have_mtime && mtime == index->mtime
+         && !strcmp(index->dir, dir))
+      return;
+
+   autoconfig_index_free(index);
+
+   if (!(list = dir_list_new(dir, "cfg", false)))
+      return;
+
+   /* readdir() order is arbitrary, keep which profile
+    * wins stable between runs. */
+   dir_list_sort(list, false);
+
+   for (i = 0; i < list->size; i++)
+   {
+      config_file_t *conf = config_file_new(list->elems[i].data);
+      autoconfig_index_add(index, conf, list->elems[i].data, 0);
+      if (conf)
+         config_file_free(conf);
+   }
+
+   string_list_free(list);
+
+   if (!autoconfig_index_finish(index))
+      return;
+
+   strlcpy(index->dir, dir, sizeof(index->dir));
+   index->mtime = mtime;
+
+   /* Without an mtime, or if the directory was changed within the
+    * second we looked at it, the next lookup can't trust it. */
+   if (!have_mtime || time(NULL) <= mtime)
+      index->valid = false;
+
+   RARCH_LOG("Indexed %u autoconfig profiles in \"%s\".\n",
+         (unsigned)index->size, dir);
+}
+
+/* The first profile, in the order they were indexed, which matches
+ * by vendor and product ID, by "<name>_p<port>", or by name and
+ * driver. Returns -1 if there is none. */
+static int autoconfig_index_find(const struct autoconfig_index *index,
+      unsigned port, const char *name, const char *driver,
+      int32_t vid, int32_t pid)
+{
+   size_t slot, best = SIZE_MAX;
+   char suffix[32];
+   size_t name_len   = strlen(name);
+   size_t suffix_len;
+
+   if (!index->size || !index->by_name)
+      return -1;
+
+   if (vid && pid)
+   {
+      uint32_t hash = autoconfig_hash_id(vid, pid);
+      for (slot = hash_bucket(hash, index->mask); index->by_id[slot];
+            slot = (slot + 1) & index->mask)
+      {
+         size_t i = index->by_id[slot] - 1;
+         if (i < best && index->entries[i].vid == vid
+               && index->entries[i].pid == pid)
+            best = i;
+      }
+   }
+
+   for (slot = hash_bucket(djb2_calculate(name), index->mask);
+         index->by_name[slot]; slot = (slot + 1) & index->mask)
+   {
+      size_t i = index->by_name[slot] - 1;
+      if (i < best && !strcmp(index->entries[i].ident, name)
+            && !strcmp(index->entries[i].driver, driver))
+         best = i;
+   }
+
+   snprintf(suffix, sizeof(suffix), "_p%u", port);
+   suffix_len = strlen(suffix);
+
+   if (name_len > suffix_len
+         && !strcmp(name + name_len - suffix_len, suffix))
+   {
+      char ident[PATH_MAX];
+      strlcpy(ident, name, sizeof(ident));
+      ident[name_len - suffix_len] = '\0';
+
+      for (slot = hash_bucket(djb2_calculate(ident), index->mask);
+            index->by_name[slot]; slot = (slot + 1) & index->mask)
+      {
+         size_t i = index->by_name[slot] - 1;
+         if (i < best && !strcmp(index->entries[i].ident, ident))
+            best = i;
+      }
+   }
+
+   return best == SIZE_MAX ? -1 : (int)best;
+}
+
 void input_config_autoconfigure_joypad(unsigned index,
       const char *name, int32_t vid, int32_t pid,
       const char *driver)
 {
    size_t i;
+   int found;
 
    if (!g_settings.input.autodetect_enable)
       return;
@@ -117,44 +415,54 @@ void input_config_autoconfigure_joypad(unsigned index,
    if (!name)
       return;
 
+   if (!driver)
+      driver = "";
+
    /* false = load from both cfg files and internal */
    bool internal_only = !*g_settings.input.autoconfig_dir;
 
-#if defined(HAVE_BUILTIN_AUTOCONFIG) && (!defined(_WIN32) || defined(HAVE_WINXINPUT))
+#ifdef HAVE_AUTOCONFIG_BUILTINS
    /* First internal */
-   for (i = 0; input_builtin_autoconfs[i]; i++)
+   autoconfig_index_builtins();
+   found = autoconfig_index_find(&autoconfig_builtin, index, name, driver,
+         vid, pid);
+   if (found >= 0)
    {
-      config_file_t *conf = (config_file_t*)
-         config_file_new_from_string(input_builtin_autoconfs[i]);
-      bool success = input_try_autoconfigure_joypad_from_conf(conf,
+      config_file_t *conf = (config_file_t*)config_file_new_from_string(
+            input_builtin_autoconfs[autoconfig_builtin.entries[found].builtin]);
+      input_try_autoconfigure_joypad_from_conf(conf,
             index, name, driver, vid, pid, block_osd_spam);
       config_file_free(conf);
-      if (success)
-         break;
    }
 #endif
 
    /* Now try files */
    if (!internal_only)
    {
-      struct string_list *list = dir_list_new(
-            g_settings.input.autoconfig_dir, "cfg", false);
-      if (!list)
-         return;
+      unsigned attempt;
 
-      for (i = 0; i < list->size; i++)
+      for (attempt = 0; attempt < 2; attempt++)
       {
-         config_file_t *conf = config_file_new(list->elems[i].data);
-         if (!conf)
-            continue;
-         bool success = input_try_autoconfigure_joypad_from_conf(conf,
+         config_file_t *conf;
+         bool success;
+
+         autoconfig_index_dir(g_settings.input.autoconfig_dir);
+         found = autoconfig_index_find(&autoconfig_files, index, name,
+               driver, vid, pid);
+         if (found < 0)
+            break;
+
+         conf = config_file_new(autoconfig_files.entries[found].path);
+         success = input_try_autoconfigure_joypad_from_conf(conf,
                index, name, driver, vid, pid, block_osd_spam);
-         config_file_free(conf);
+         if (conf)
+            config_file_free(conf);
          if (success)
             break;
-      }
 
-      string_list_free(list);
+         /* The profile changed since it was indexed. */
+         autoconfig_files.valid = false;
+      }
    }
 }
 
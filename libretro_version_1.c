@@ -28,12 +28,16 @@
 #include "input/keyboard_line.h"
 #include "audio/utils.h"
 #include "retroarch_logger.h"
+#include "gfx/scaler/pixconv.h"
 #include "intl/intl.h"
 
 static void video_frame(const void *data, unsigned width,
       unsigned height, size_t pitch)
 {
    const char *msg = NULL;
+   /* Rows which changed since the previous frame. */
+   unsigned dirty_y = 0;
+   unsigned dirty_height = height;
 
    if (!driver.video_active)
       return;
@@ -43,21 +47,58 @@ static void video_frame(const void *data, unsigned width,
    g_extern.frame_cache.height = height;
    g_extern.frame_cache.pitch  = pitch;
 
+   {
+      size_t line_size = width *
+         (g_extern.system.pix_fmt == RETRO_PIXEL_FORMAT_XRGB8888 ?
+          sizeof(uint32_t) : sizeof(uint16_t));
+      /* Frames which aren't checked still reset the previous frame,
+       * otherwise toggling detection would compare against a stale one. */
+      bool check = g_settings.video.frame_dupe_detect &&
+         data && data != RETRO_HW_FRAME_BUFFER_VALID;
+      bool dupe;
+
+      RARCH_PERFORMANCE_INIT(video_frame_dupe);
+      RARCH_PERFORMANCE_START(video_frame_dupe);
+      dupe = frame_dupe_update(&driver.frame_dupe, check, data,
+            width, height, pitch, line_size);
+      RARCH_PERFORMANCE_STOP(video_frame_dupe);
+
+      /* Same as if the core had duped the frame itself. */
+      if (dupe)
+         data = NULL;
+
+      dirty_y      = driver.frame_dupe.dirty_y;
+      dirty_height = driver.frame_dupe.dirty_height;
+   }
+
    if (g_extern.system.pix_fmt == RETRO_PIXEL_FORMAT_0RGB1555 &&
          data && data != RETRO_HW_FRAME_BUFFER_VALID)
    {
+      size_t out_stride = width * sizeof(uint16_t);
+
       RARCH_PERFORMANCE_INIT(video_frame_conv);
       RARCH_PERFORMANCE_START(video_frame_conv);
-      driver.scaler.in_width = width;
-      driver.scaler.in_height = height;
-      driver.scaler.out_width = width;
-      driver.scaler.out_height = height;
-      driver.scaler.in_stride = pitch;
-      driver.scaler.out_stride = width * sizeof(uint16_t);
-
-      scaler_ctx_scale(&driver.scaler, driver.scaler_out, data);
+      if (dirty_height < height)
+      {
+         /* scaler_out still holds the rest of the previous frame. */
+         conv_0rgb1555_rgb565(
+               (uint8_t*)driver.scaler_out + dirty_y * out_stride,
+               (const uint8_t*)data + dirty_y * pitch,
+               width, dirty_height, out_stride, pitch);
+      }
+      else
+      {
+         driver.scaler.in_width = width;
+         driver.scaler.in_height = height;
+         driver.scaler.out_width = width;
+         driver.scaler.out_height = height;
+         driver.scaler.in_stride = pitch;
+         driver.scaler.out_stride = out_stride;
+
+         scaler_ctx_scale(&driver.scaler, driver.scaler_out, data);
+      }
       data = driver.scaler_out;
-      pitch = driver.scaler.out_stride;
+      pitch = out_stride;
       RARCH_PERFORMANCE_STOP(video_frame_conv);
    }
 
@@ -87,9 +128,10 @@ static void video_frame(const void *data, unsigned width,
 
       RARCH_PERFORMANCE_INIT(softfilter_process);
       RARCH_PERFORMANCE_START(softfilter_process);
-      rarch_softfilter_process(g_extern.filter.filter,
+      rarch_softfilter_process_dirty(g_extern.filter.filter,
             g_extern.filter.buffer, opitch,
-            data, width, height, pitch);
+            data, width, height, pitch,
+            dirty_y, dirty_height, &dirty_y, &dirty_height);
       RARCH_PERFORMANCE_STOP(softfilter_process);
 
       if (driver.recording_data && g_settings.video.post_filter_record)
@@ -102,6 +144,11 @@ static void video_frame(const void *data, unsigned width,
       pitch = opitch;
    }
 
+   if (data && dirty_height < height && driver.video_poke &&
+         driver.video_poke->set_frame_dirty)
+      driver.video_poke->set_frame_dirty(driver.video_data,
+            dirty_y, dirty_height);
+
    if (!driver.video->frame(driver.video_data, data, width, height, pitch, msg))
       driver.video_active = false;
 }
@@ -143,7 +190,12 @@ static bool audio_flush(const int16_t *data, size_t samples)
       ffemu_data.frames                  = samples / 2;
 
       if (driver.recording && driver.recording->push_audio)
+      {
+         RARCH_PERFORMANCE_INIT(record_push_audio);
+         RARCH_PERFORMANCE_START(record_push_audio);
          driver.recording->push_audio(driver.recording_data, &ffemu_data);
+         RARCH_PERFORMANCE_STOP(record_push_audio);
+      }
    }
 
    if (g_extern.is_paused || g_extern.audio_data.mute)
@@ -16,41 +16,70 @@
 #include <stdlib.h>
 #include <string.h>
 #include <stddef.h>
+#include <stdint.h>
 #include "boolean.h"
 #include "message_queue.h"
+#include "hash.h"
 #include "retroarch_logger.h"
 #include "compat/posix_string.h"
+#include "compat/strl.h"
+
+/* Messages are stored inline and truncated to fit.
+ * Anything longer won't fit on screen anyway. */
+#define MSG_QUEUE_MSG_SIZE 512
 
 struct queue_elem
 {
    unsigned duration;
    unsigned prio;
-   char *msg;
+   /* Push order, so equal priorities come out first in, first out. */
+   unsigned seq;
+   uint32_t hash;
+   bool has_msg;
+   char msg[MSG_QUEUE_MSG_SIZE];
 };
 
+/* All elements live in one slab allocated up front, so pushing and
+ * pulling never touch the heap. elems is a binary max-heap of
+ * pointers into the slab, 1-indexed. Unused slab entries are kept
+ * on a free stack. */
 struct msg_queue
 {
+   struct queue_elem *slab;
    struct queue_elem **elems;
+   struct queue_elem **free_elems;
+   size_t num_free;
    size_t ptr;
    size_t size;
-   char *tmp_msg;
+   unsigned seq;
+
+   /* Holds an expired message for the frame it is pulled in. */
+   char tmp_msg[MSG_QUEUE_MSG_SIZE];
 };
 
 msg_queue_t *msg_queue_new(size_t size)
 {
+   size_t i;
    msg_queue_t *queue = (msg_queue_t*)calloc(1, sizeof(*queue));
    if (!queue)
       return NULL;
 
    queue->size = size + 1;
+   queue->slab = (struct queue_elem*)calloc(size, sizeof(*queue->slab));
    queue->elems = (struct queue_elem**)
-      calloc(queue->size,sizeof(struct queue_elem*)); 
+      calloc(queue->size, sizeof(struct queue_elem*));
+   queue->free_elems = (struct queue_elem**)
+      calloc(size, sizeof(struct queue_elem*));
 
-   if (!queue->elems)
+   if (!queue->slab || !queue->elems || !queue->free_elems)
    {
-      free(queue);
+      msg_queue_free(queue);
       return NULL;
    }
+
+   for (i = 0; i < size; i++)
+      queue->free_elems[i] = &queue->slab[size - 1 - i];
+   queue->num_free = size;
    queue->ptr = 1;
    return queue;
 }
@@ -59,121 +88,144 @@ void msg_queue_free(msg_queue_t *queue)
 {
    if (queue)
    {
-      msg_queue_clear(queue);
+      free(queue->slab);
       free(queue->elems);
+      free(queue->free_elems);
    }
    free(queue);
 }
 
-void msg_queue_push(msg_queue_t *queue, const char *msg,
-      unsigned prio, unsigned duration)
+/* Whether a should be pulled before b. */
+static bool msg_queue_before(const struct queue_elem *a,
+      const struct queue_elem *b)
 {
-   if (!queue || queue->ptr >= queue->size)
-      return;
-
-   struct queue_elem *new_elem = (struct queue_elem*)
-      calloc(1, sizeof(struct queue_elem));
-   if (!new_elem)
-   {
-      RARCH_ERR("New element allocation failed.\n");
-      return;
-   }
-
-   new_elem->prio = prio;
-   new_elem->duration = duration;
-   new_elem->msg = msg ? strdup(msg) : NULL;
-
-   queue->elems[queue->ptr] = new_elem;
-   size_t tmp_ptr = queue->ptr++;
+   if (a->prio != b->prio)
+      return a->prio > b->prio;
+   return (int)(a->seq - b->seq) < 0;
+}
 
+static void msg_queue_sift_up(msg_queue_t *queue, size_t tmp_ptr)
+{
    while (tmp_ptr > 1)
    {
       struct queue_elem *parent = queue->elems[tmp_ptr >> 1];
       struct queue_elem *child = queue->elems[tmp_ptr];
 
-      if (child->prio <= parent->prio)
+      if (!msg_queue_before(child, parent))
          break;
-      else
-      {
-         queue->elems[tmp_ptr >> 1] = child;
-         queue->elems[tmp_ptr] = parent;
-      }
+
+      queue->elems[tmp_ptr >> 1] = child;
+      queue->elems[tmp_ptr] = parent;
       tmp_ptr >>= 1;
    }
 }
 
-void msg_queue_clear(msg_queue_t *queue)
+static void msg_queue_sift_down(msg_queue_t *queue, size_t tmp_ptr)
 {
+   for (;;)
+   {
+      size_t left = tmp_ptr * 2;
+      size_t switch_index = tmp_ptr;
+      struct queue_elem *parent;
+
+      if (left < queue->ptr
+            && msg_queue_before(queue->elems[left], queue->elems[switch_index]))
+         switch_index = left;
+      if (left + 1 < queue->ptr
+            && msg_queue_before(queue->elems[left + 1], queue->elems[switch_index]))
+         switch_index = left + 1;
+
+      if (switch_index == tmp_ptr)
+         break;
+
+      parent = queue->elems[tmp_ptr];
+      queue->elems[tmp_ptr] = queue->elems[switch_index];
+      queue->elems[switch_index] = parent;
+      tmp_ptr = switch_index;
+   }
+}
+
+void msg_queue_push(msg_queue_t *queue, const char *msg,
+      unsigned prio, unsigned duration)
+{
+   size_t i;
+   uint32_t hash = 0;
+   struct queue_elem *new_elem;
+
    if (!queue)
       return;
 
-   size_t i;
-   for (i = 1; i < queue->ptr; i++)
+   /* Pushing a message which is already pending (e.g. "Rewinding."
+    * every frame) refreshes it instead of queueing a copy. */
+   if (msg)
    {
-      if (queue->elems[i])
+      hash = djb2_calculate(msg);
+
+      for (i = 1; i < queue->ptr; i++)
       {
-         free(queue->elems[i]->msg);
-         free(queue->elems[i]);
-         queue->elems[i] = NULL;
+         struct queue_elem *elem = queue->elems[i];
+         if (!elem->has_msg || elem->hash != hash
+               || strncmp(elem->msg, msg, sizeof(elem->msg) - 1))
+            continue;
+
+         if (duration > elem->duration)
+            elem->duration = duration;
+         if (prio > elem->prio)
+         {
+            elem->prio = prio;
+            msg_queue_sift_up(queue, i);
+         }
+         return;
       }
    }
-   queue->ptr = 1;
-   free(queue->tmp_msg);
-   queue->tmp_msg = NULL;
+
+   if (!queue->num_free)
+      return;
+
+   new_elem = queue->free_elems[--queue->num_free];
+   new_elem->prio = prio;
+   new_elem->duration = duration;
+   new_elem->seq = queue->seq++;
+   new_elem->hash = hash;
+   new_elem->has_msg = msg != NULL;
+   if (msg)
+      strlcpy(new_elem->msg, msg, sizeof(new_elem->msg));
+
+   queue->elems[queue->ptr] = new_elem;
+   msg_queue_sift_up(queue, queue->ptr++);
+}
+
+void msg_queue_clear(msg_queue_t *queue)
+{
+   if (!queue)
+      return;
+
+   while (queue->ptr > 1)
+      queue->free_elems[queue->num_free++] = queue->elems[--queue->ptr];
 }
 
 const char *msg_queue_pull(msg_queue_t *queue)
 {
+   struct queue_elem *front;
+
    /* Nothing in queue. */
    if (!queue || queue->ptr == 1)
       return NULL;
 
-   struct queue_elem *front = queue->elems[1];
-   front->duration--;
-   if (front->duration > 0)
-      return front->msg;
-   else
+   front = queue->elems[1];
+   if (front->duration > 1)
    {
-      free(queue->tmp_msg);
-      queue->tmp_msg = front->msg;
-      front->msg = NULL;
+      front->duration--;
+      return front->has_msg ? front->msg : NULL;
+   }
 
-      struct queue_elem *front = queue->elems[1];
-      struct queue_elem *last = queue->elems[--queue->ptr];
-      queue->elems[1] = last;
-      free(front);
+   /* Last time this one is shown. */
+   if (front->has_msg)
+      strlcpy(queue->tmp_msg, front->msg, sizeof(queue->tmp_msg));
 
-      size_t tmp_ptr = 1;
-      for (;;)
-      {
-         bool left = (tmp_ptr * 2 <= queue->ptr)
-            && (queue->elems[tmp_ptr] < queue->elems[tmp_ptr * 2]);
-         bool right = (tmp_ptr * 2 + 1 <= queue->ptr)
-            && (queue->elems[tmp_ptr] < queue->elems[tmp_ptr * 2 + 1]);
-
-         if (!left && !right)
-            break;
-
-         size_t switch_index = tmp_ptr;
-         if (left && !right)
-            switch_index <<= 1;
-         else if (right && !left)
-            switch_index += switch_index + 1;
-         else
-         {
-            if (queue->elems[tmp_ptr * 2]
-                  >= queue->elems[tmp_ptr * 2 + 1])
-               switch_index <<= 1;
-            else
-               switch_index += switch_index + 1;
-         }
-         struct queue_elem *parent = queue->elems[tmp_ptr];
-         struct queue_elem *child = queue->elems[switch_index];
-         queue->elems[tmp_ptr] = child;
-         queue->elems[switch_index] = parent;
-         tmp_ptr = switch_index;
-      }
+   queue->free_elems[queue->num_free++] = front;
+   queue->elems[1] = queue->elems[--queue->ptr];
+   msg_queue_sift_down(queue, 1);
 
-      return queue->tmp_msg;
-   }
+   return front->has_msg ? queue->tmp_msg : NULL;
 }
@@ -17,6 +17,8 @@
 #ifndef __RARCH_MSG_QUEUE_H
 #define __RARCH_MSG_QUEUE_H
 
+#include <stddef.h>
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -29,7 +31,9 @@ msg_queue_t *msg_queue_new(size_t size);
 
 /* Duration is how many times a  message can be pulled from queue 
  * before it vanishes. (E.g. show a message for 
- * 3 seconds @ 60fps = 180 duration). */
+ * 3 seconds @ 60fps = 180 duration).
+ * Pushing a message identical to a pending one refreshes the pending
+ * one instead. Does not allocate. */
 void msg_queue_push(msg_queue_t *queue, const char *msg,
       unsigned prio, unsigned duration);
 
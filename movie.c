@@ -20,29 +20,436 @@
 #include <string.h>
 #include "general.h"
 #include "dynamic.h"
+#include "retro.h"
+
+#ifdef HAVE_ZLIB
+#include <zlib.h>
+#endif
+
+#define BSV1_HEADER_SIZE (4 * sizeof(uint32_t))
+#define BSV2_HEADER_SIZE (8 * sizeof(uint32_t))
+
+#define BSV_BLOCK_HEADER_SIZE 24
+#define BSV_INDEX_MAGIC 0x42535649
+#define BSV_INDEX_ENTRY_SIZE 16
+
+/* Frames per input block. */
+#define BSV_BLOCK_FRAMES 256
+
+enum bsv_block_type
+{
+   BSV_BLOCK_INPUT = 1,
+   BSV_BLOCK_KEYFRAME
+};
+
+enum bsv_codec
+{
+   BSV_CODEC_NONE = 0,
+   BSV_CODEC_DEFLATE
+};
+
+struct bsv_block
+{
+   unsigned type;
+   unsigned codec;
+   unsigned frame;
+   unsigned frames;
+   size_t size;
+   size_t stored_size;
+};
+
+struct bsv_index_entry
+{
+   unsigned frame;
+   /* 0 for keyframes. */
+   unsigned frames;
+   long offset;
+};
+
+struct bsv_index
+{
+   struct bsv_index_entry *entries;
+   size_t size;
+   size_t capacity;
+};
 
 struct bsv_movie
 {
    FILE *file;
 
-   /* A ring buffer keeping track of positions
-    * in the file for each frame. */
+   size_t state_size;
+   uint8_t *state;
+   long state_pos;
+   long data_pos;
+   long write_pos;
+
+   unsigned keyframe_interval;
+   struct bsv_index blocks;
+   struct bsv_index keyframes;
+
+   /* Decoded inputs of the current block,
+    * or the whole input stream for BSV1. */
+   uint8_t *inputs;
+   size_t inputs_size;
+   size_t inputs_capacity;
+   size_t block;
+   bool block_loaded;
+   unsigned block_frame;
+   unsigned block_frames;
+
+   /* Where each frame of the block starts in inputs. */
    size_t *frame_pos;
-   size_t frame_mask;
-   size_t frame_ptr;
+   size_t frame_pos_capacity;
 
-   size_t min_file_pos;
+   size_t ptr;
+   size_t frame_end;
+   bool in_frame;
+   unsigned frame;
+   unsigned num_frames;
 
-   size_t state_size;
-   uint8_t *state;
+   uint8_t *packed;
+   size_t packed_capacity;
+   uint8_t *keyframe;
+   size_t keyframe_capacity;
 
    bool playback;
+   bool legacy;
    bool first_rewind;
    bool did_rewind;
 };
 
+static void bsv_write_le32(uint8_t *out, uint32_t val)
+{
+   val = swap_if_big32(val);
+   memcpy(out, &val, sizeof(val));
+}
+
+static uint32_t bsv_read_le32(const uint8_t *in)
+{
+   uint32_t val;
+   memcpy(&val, in, sizeof(val));
+   return swap_if_big32(val);
+}
+
+static void bsv_write_le16(uint8_t *out, uint16_t val)
+{
+   val = swap_if_big16(val);
+   memcpy(out, &val, sizeof(val));
+}
+
+static uint16_t bsv_read_le16(const uint8_t *in)
+{
+   uint16_t val;
+   memcpy(&val, in, sizeof(val));
+   return swap_if_big16(val);
+}
+
+static bool bsv_reserve(uint8_t **buf, size_t *capacity, size_t size)
+{
+   uint8_t *new_buf;
+   size_t new_capacity = *capacity ? *capacity : 4096;
+
+   if (size <= *capacity)
+      return true;
+
+   while (new_capacity < size)
+      new_capacity *= 2;
+
+   if (!(new_buf = (uint8_t*)realloc(*buf, new_capacity)))
+      return false;
+
+   *buf      = new_buf;
+   *capacity = new_capacity;
+   return true;
+}
+
+static bool bsv_reserve_frames(bsv_movie_t *handle, size_t frames)
+{
+   size_t *frame_pos;
+   size_t capacity = handle->frame_pos_capacity ?
+      handle->frame_pos_capacity : BSV_BLOCK_FRAMES + 1;
+
+   if (frames <= handle->frame_pos_capacity)
+      return true;
+
+   while (capacity < frames)
+      capacity *= 2;
+
+   if (!(frame_pos = (size_t*)realloc(handle->frame_pos,
+               capacity * sizeof(*frame_pos))))
+      return false;
+
+   handle->frame_pos          = frame_pos;
+   handle->frame_pos_capacity = capacity;
+   return true;
+}
+
+static bool bsv_index_push(struct bsv_index *index,
+      unsigned frame, unsigned frames, long offset)
+{
+   struct bsv_index_entry *entry;
+
+   if (index->size == index->capacity)
+   {
+      size_t capacity = index->capacity ? index->capacity * 2 : 64;
+      struct bsv_index_entry *entries = (struct bsv_index_entry*)
+         realloc(index->entries, capacity * sizeof(*entries));
+      if (!entries)
+         return false;
+
+      index->entries  = entries;
+      index->capacity = capacity;
+   }
+
+   entry         = &index->entries[index->size++];
+   entry->frame  = frame;
+   entry->frames = frames;
+   entry->offset = offset;
+   return true;
+}
+
+/* The last entry starting at or before frame. */
+static size_t bsv_index_find(const struct bsv_index *index, unsigned frame)
+{
+   size_t lo = 0, hi = index->size;
+
+   while (lo < hi)
+   {
+      size_t mid = lo + (hi - lo) / 2;
+      if (index->entries[mid].frame <= frame)
+         lo = mid + 1;
+      else
+         hi = mid;
+   }
+
+   return lo ? lo - 1 : 0;
+}
+
+static bool bsv_movie_write_block(bsv_movie_t *handle, unsigned type,
+      unsigned frame, unsigned frames, const uint8_t *data, size_t size)
+{
+   uint8_t header[BSV_BLOCK_HEADER_SIZE];
+   const uint8_t *payload = data;
+   size_t stored_size     = size;
+   unsigned codec         = BSV_CODEC_NONE;
+
+#ifdef HAVE_ZLIB_DEFLATE
+   {
+      uLongf packed_size = compressBound(size);
+      if (bsv_reserve(&handle->packed, &handle->packed_capacity, packed_size)
+            && compress2(handle->packed, &packed_size, data, size,
+               Z_BEST_SPEED) == Z_OK
+            && packed_size < size)
+      {
+         payload     = handle->packed;
+         stored_size = packed_size;
+         codec       = BSV_CODEC_DEFLATE;
+      }
+   }
+#endif
+
+   bsv_write_le32(header +  0, type);
+   bsv_write_le32(header +  4, codec);
+   bsv_write_le32(header +  8, frame);
+   bsv_write_le32(header + 12, frames);
+   bsv_write_le32(header + 16, size);
+   bsv_write_le32(header + 20, stored_size);
+
+   if (fseek(handle->file, handle->write_pos, SEEK_SET) != 0
+         || fwrite(header, 1, sizeof(header), handle->file) != sizeof(header)
+         || fwrite(payload, 1, stored_size, handle->file) != stored_size)
+   {
+      RARCH_ERR("Couldn't write to movie file.\n");
+      return false;
+   }
+
+   if (!bsv_index_push(type == BSV_BLOCK_INPUT ?
+            &handle->blocks : &handle->keyframes,
+            frame, frames, handle->write_pos))
+      return false;
+
+   handle->write_pos += sizeof(header) + stored_size;
+   return true;
+}
+
+static bool bsv_movie_read_block_header(bsv_movie_t *handle, long offset,
+      struct bsv_block *block)
+{
+   uint8_t header[BSV_BLOCK_HEADER_SIZE];
+
+   if (fseek(handle->file, offset, SEEK_SET) != 0
+         || fread(header, 1, sizeof(header), handle->file) != sizeof(header))
+      return false;
+
+   block->type        = bsv_read_le32(header +  0);
+   block->codec       = bsv_read_le32(header +  4);
+   block->frame       = bsv_read_le32(header +  8);
+   block->frames      = bsv_read_le32(header + 12);
+   block->size        = bsv_read_le32(header + 16);
+   block->stored_size = bsv_read_le32(header + 20);
+
+   return (block->type == BSV_BLOCK_INPUT || block->type == BSV_BLOCK_KEYFRAME)
+      && (block->codec == BSV_CODEC_NONE || block->codec == BSV_CODEC_DEFLATE);
+}
+
+static bool bsv_movie_read_block(bsv_movie_t *handle, long offset,
+      unsigned type, struct bsv_block *block,
+      uint8_t **out, size_t *capacity)
+{
+   if (!bsv_movie_read_block_header(handle, offset, block)
+         || block->type != type
+         || !bsv_reserve(out, capacity, block->size ? block->size : 1))
+      return false;
+
+   if (block->codec == BSV_CODEC_NONE)
+      return block->stored_size == block->size
+         && fread(*out, 1, block->size, handle->file) == block->size;
+
+#ifdef HAVE_ZLIB
+   {
+      uLongf size = block->size;
+      if (!bsv_reserve(&handle->packed, &handle->packed_capacity,
+               block->stored_size)
+            || fread(handle->packed, 1, block->stored_size, handle->file)
+            != block->stored_size)
+         return false;
+
+      return uncompress(*out, &size, handle->packed,
+            block->stored_size) == Z_OK && size == block->size;
+   }
+#else
+   RARCH_ERR("Compressed movies are not supported in this build.\n");
+   return false;
+#endif
+}
+
+/* Decodes an input block and finds where its frames start. */
+static bool bsv_movie_load_block(bsv_movie_t *handle, size_t block)
+{
+   unsigned i;
+   size_t pos = 0;
+   struct bsv_block info;
+   const struct bsv_index_entry *entry = &handle->blocks.entries[block];
+
+   if (handle->block_loaded && handle->block == block)
+      return true;
+
+   handle->block_loaded = false;
+
+   if (!bsv_movie_read_block(handle, entry->offset, BSV_BLOCK_INPUT, &info,
+            &handle->inputs, &handle->inputs_capacity)
+         || info.frame != entry->frame || info.frames != entry->frames
+         || !bsv_reserve_frames(handle, info.frames + 1))
+      return false;
+
+   for (i = 0; i < info.frames; i++)
+   {
+      handle->frame_pos[i] = pos;
+      if (pos + 2 > info.size)
+         return false;
+      pos += 2 + 2 * bsv_read_le16(handle->inputs + pos);
+   }
+
+   if (pos > info.size)
+      return false;
+
+   handle->frame_pos[info.frames] = pos;
+   handle->inputs_size  = info.size;
+   handle->block        = block;
+   handle->block_frame  = info.frame;
+   handle->block_frames = info.frames;
+   handle->block_loaded = true;
+   return true;
+}
+
+static bool bsv_movie_read_index(bsv_movie_t *handle, long offset, long end)
+{
+   uint8_t entry[BSV_INDEX_ENTRY_SIZE];
+   unsigned i, num_blocks, num_keyframes, frame = 0;
+
+   if (offset < handle->data_pos || offset + BSV_INDEX_ENTRY_SIZE > end
+         || fseek(handle->file, offset, SEEK_SET) != 0
+         || fread(entry, 1, sizeof(entry), handle->file) != sizeof(entry)
+         || bsv_read_le32(entry) != BSV_INDEX_MAGIC)
+      return false;
+
+   num_blocks    = bsv_read_le32(entry + 4);
+   num_keyframes = bsv_read_le32(entry + 8);
+
+   if ((uint64_t)(num_blocks + (uint64_t)num_keyframes)
+         * BSV_INDEX_ENTRY_SIZE > (uint64_t)(end - offset))
+      return false;
+
+   for (i = 0; i < num_blocks + num_keyframes; i++)
+   {
+      uint64_t pos;
+      bool keyframe = i >= num_blocks;
+
+      if (fread(entry, 1, sizeof(entry), handle->file) != sizeof(entry))
+         return false;
+
+      pos = bsv_read_le32(entry + 8)
+         | ((uint64_t)bsv_read_le32(entry + 12) << 32);
+      if (pos < (uint64_t)handle->data_pos || pos >= (uint64_t)offset)
+         return false;
+
+      /* Input blocks have to follow each other without gaps. */
+      if (!keyframe)
+      {
+         if (bsv_read_le32(entry) != frame || !bsv_read_le32(entry + 4))
+            return false;
+         frame += bsv_read_le32(entry + 4);
+      }
+
+      if (!bsv_index_push(keyframe ? &handle->keyframes : &handle->blocks,
+               bsv_read_le32(entry), bsv_read_le32(entry + 4), (long)pos))
+         return false;
+   }
+
+   handle->num_frames = frame;
+   return true;
+}
+
+/* Rebuilds the index of a movie which was not finished. */
+static void bsv_movie_scan(bsv_movie_t *handle, long end)
+{
+   struct bsv_block block;
+   long offset    = handle->data_pos;
+   unsigned frame = 0;
+
+   handle->blocks.size    = 0;
+   handle->keyframes.size = 0;
+
+   while (offset + BSV_BLOCK_HEADER_SIZE <= end
+         && bsv_movie_read_block_header(handle, offset, &block))
+   {
+      long next = offset + BSV_BLOCK_HEADER_SIZE + (long)block.stored_size;
+      if (next > end || block.frame != frame)
+         break;
+
+      if (block.type == BSV_BLOCK_INPUT)
+      {
+         if (!block.frames
+               || !bsv_index_push(&handle->blocks, frame, block.frames, offset))
+            break;
+         frame += block.frames;
+      }
+      else if (!bsv_index_push(&handle->keyframes, frame, 0, offset))
+         break;
+
+      offset = next;
+   }
+
+   handle->num_frames = frame;
+   RARCH_WARN("Movie was not finished, it ends after frame %u.\n", frame);
+}
+
 static bool init_playback(bsv_movie_t *handle, const char *path)
 {
+   uint32_t header[8] = {0};
+   uint32_t state_size;
+   long end;
+
    handle->playback = true;
    handle->file = fopen(path, "rb");
    if (!handle->file)
@@ -51,7 +458,6 @@ static bool init_playback(bsv_movie_t *handle, const char *path)
       return false;
    }
 
-   uint32_t header[4] = {0};
    if (fread(header, sizeof(uint32_t), 4, handle->file) != 4)
    {
       RARCH_ERR("Couldn't read movie header.\n");
@@ -60,17 +466,27 @@ static bool init_playback(bsv_movie_t *handle, const char *path)
 
    /* Compatibility with old implementation that
     * used incorrect documentation. */
-   if (swap_if_little32(header[MAGIC_INDEX]) != BSV_MAGIC
-         && swap_if_big32(header[MAGIC_INDEX]) != BSV_MAGIC)
+   if (swap_if_little32(header[MAGIC_INDEX]) == BSV2_MAGIC)
+   {
+      if (fread(header + 4, sizeof(uint32_t), 4, handle->file) != 4)
+      {
+         RARCH_ERR("Couldn't read movie header.\n");
+         return false;
+      }
+   }
+   else if (swap_if_little32(header[MAGIC_INDEX]) == BSV_MAGIC
+         || swap_if_big32(header[MAGIC_INDEX]) == BSV_MAGIC)
+      handle->legacy = true;
+   else
    {
-      RARCH_ERR("Movie file is not a valid BSV1 file.\n");
+      RARCH_ERR("Movie file is not a valid BSV1 or BSV2 file.\n");
       return false;
    }
 
    if (swap_if_big32(header[CRC_INDEX]) != g_extern.content_crc)
       RARCH_WARN("CRC32 checksum mismatch between content file and saved content checksum in replay file header; replay highly likely to desync on playback.\n");
 
-   uint32_t state_size = swap_if_big32(header[STATE_SIZE_INDEX]);
+   state_size = swap_if_big32(header[STATE_SIZE_INDEX]);
 
    if (state_size)
    {
@@ -91,34 +507,70 @@ static bool init_playback(bsv_movie_t *handle, const char *path)
          RARCH_WARN("Movie format seems to have a different serializer version. Will most likely fail.\n");
    }
 
-   handle->min_file_pos = sizeof(header) + state_size;
+   handle->state_pos = handle->legacy ? BSV1_HEADER_SIZE : BSV2_HEADER_SIZE;
+   handle->data_pos  = handle->state_pos + state_size;
+
+   fseek(handle->file, 0, SEEK_END);
+   end = ftell(handle->file);
+
+   if (handle->legacy)
+   {
+      /* No frames to go by, read all inputs at once. */
+      size_t size = end > handle->data_pos ? end - handle->data_pos : 0;
+
+      if (!bsv_reserve(&handle->inputs, &handle->inputs_capacity,
+               size ? size : 1)
+            || fseek(handle->file, handle->data_pos, SEEK_SET) != 0
+            || fread(handle->inputs, 1, size, handle->file) != size)
+      {
+         RARCH_ERR("Couldn't read inputs from movie.\n");
+         return false;
+      }
+
+      handle->inputs_size = size & ~(size_t)1;
+      return true;
+   }
+
+   handle->keyframe_interval = swap_if_big32(header[KEYFRAME_INTERVAL_INDEX]);
+
+   if (!bsv_movie_read_index(handle, swap_if_big32(header[INDEX_OFFSET_LO_INDEX])
+            | ((uint64_t)swap_if_big32(header[INDEX_OFFSET_HI_INDEX]) << 32),
+            end))
+      bsv_movie_scan(handle, end);
 
    return true;
 }
 
 static bool init_record(bsv_movie_t *handle, const char *path)
 {
-   handle->file = fopen(path, "wb");
+   /* Blocks are read back when rewinding into them. */
+   handle->file = fopen(path, "w+b");
    if (!handle->file)
    {
       RARCH_ERR("Couldn't open BSV \"%s\" for recording.\n", path);
       return false;
    }
 
-   uint32_t header[4] = {0};
+   uint32_t header[8] = {0};
 
    /* This value is supposed to show up as
-    * BSV1 in a HEX editor, big-endian. */
-   header[MAGIC_INDEX] = swap_if_little32(BSV_MAGIC);
+    * BSV2 in a HEX editor, big-endian. */
+   header[MAGIC_INDEX] = swap_if_little32(BSV2_MAGIC);
 
    header[CRC_INDEX] = swap_if_big32(g_extern.content_crc);
 
    uint32_t state_size = pretro_serialize_size();
 
+   handle->keyframe_interval = state_size ?
+      g_settings.movie_keyframe_interval : 0;
+
    header[STATE_SIZE_INDEX] = swap_if_big32(state_size);
-   fwrite(header, 4, sizeof(uint32_t), handle->file);
+   header[KEYFRAME_INTERVAL_INDEX] = swap_if_big32(handle->keyframe_interval);
+   fwrite(header, 8, sizeof(uint32_t), handle->file);
 
-   handle->min_file_pos = sizeof(header) + state_size;
+   handle->state_pos = BSV2_HEADER_SIZE;
+   handle->data_pos  = handle->state_pos + state_size;
+   handle->write_pos = handle->data_pos;
    handle->state_size = state_size;
 
    if (state_size)
@@ -134,31 +586,244 @@ static bool init_record(bsv_movie_t *handle, const char *path)
    return true;
 }
 
+static bool bsv_movie_flush_block(bsv_movie_t *handle)
+{
+   bool ret = true;
+
+   if (handle->block_frames)
+      ret = bsv_movie_write_block(handle, BSV_BLOCK_INPUT,
+            handle->block_frame, handle->block_frames,
+            handle->inputs, handle->inputs_size);
+
+   handle->block_frame  += handle->block_frames;
+   handle->block_frames  = 0;
+   handle->inputs_size   = 0;
+   return ret;
+}
+
+static void bsv_movie_write_keyframe(bsv_movie_t *handle)
+{
+   if (handle->keyframes.size && handle->keyframes.entries[
+         handle->keyframes.size - 1].frame == handle->frame)
+      return;
+
+   if (!bsv_reserve(&handle->keyframe, &handle->keyframe_capacity,
+            handle->state_size)
+         || !pretro_serialize(handle->keyframe, handle->state_size))
+   {
+      RARCH_WARN("Couldn't take keyframe for movie.\n");
+      return;
+   }
+
+   bsv_movie_write_block(handle, BSV_BLOCK_KEYFRAME, handle->frame, 0,
+         handle->keyframe, handle->state_size);
+}
+
+static void bsv_movie_begin_frame(bsv_movie_t *handle)
+{
+   handle->in_frame = true;
+
+   if (!handle->playback)
+   {
+      if (handle->keyframe_interval && handle->frame
+            && handle->frame % handle->keyframe_interval == 0)
+      {
+         bsv_movie_flush_block(handle);
+         bsv_movie_write_keyframe(handle);
+      }
+      else if (handle->block_frames == BSV_BLOCK_FRAMES)
+         bsv_movie_flush_block(handle);
+
+      handle->frame_pos[handle->block_frames] = handle->inputs_size;
+      if (bsv_reserve(&handle->inputs, &handle->inputs_capacity,
+               handle->inputs_size + 2))
+      {
+         bsv_write_le16(handle->inputs + handle->inputs_size, 0);
+         handle->inputs_size += 2;
+      }
+      return;
+   }
+
+   if (handle->legacy)
+   {
+      if (bsv_reserve_frames(handle, handle->frame + 1))
+         handle->frame_pos[handle->frame] = handle->ptr;
+      handle->frame_end = handle->inputs_size;
+      return;
+   }
+
+   handle->ptr = handle->frame_end = 0;
+   if (handle->frame >= handle->num_frames)
+      return;
+
+   if (!bsv_movie_load_block(handle,
+            bsv_index_find(&handle->blocks, handle->frame)))
+   {
+      RARCH_ERR("Couldn't read inputs for frame %u from movie.\n",
+            handle->frame);
+      handle->num_frames = handle->frame;
+      return;
+   }
+
+   handle->ptr = handle->frame_pos[handle->frame - handle->block_frame];
+   handle->frame_end = handle->ptr + 2
+      + 2 * bsv_read_le16(handle->inputs + handle->ptr);
+   handle->ptr += 2;
+}
+
+static void bsv_movie_end_frame(bsv_movie_t *handle)
+{
+   if (!handle->playback)
+   {
+      size_t pos = handle->frame_pos[handle->block_frames];
+      bsv_write_le16(handle->inputs + pos,
+            (handle->inputs_size - pos - 2) / 2);
+      handle->block_frames++;
+   }
+
+   handle->frame++;
+   handle->in_frame = false;
+}
+
+/* Drops everything recorded from frame on. */
+static void bsv_movie_truncate(bsv_movie_t *handle, unsigned frame)
+{
+   if (frame < handle->block_frame)
+   {
+      /* Back into a block already written. Load it again
+       * and write over it from where it was. */
+      size_t block = bsv_index_find(&handle->blocks, frame);
+      struct bsv_index_entry entry = handle->blocks.entries[block];
+
+      handle->block_loaded = false;
+      if (!bsv_movie_load_block(handle, block))
+      {
+         RARCH_ERR("Couldn't read back movie, can't rewind recording.\n");
+         frame = handle->block_frame;
+         handle->inputs_size = 0;
+      }
+      else
+      {
+         handle->write_pos   = entry.offset;
+         handle->blocks.size = block;
+         while (handle->keyframes.size && handle->keyframes.entries[
+               handle->keyframes.size - 1].frame > entry.frame)
+            handle->keyframes.size--;
+      }
+   }
+
+   handle->block_frames = frame - handle->block_frame;
+   handle->inputs_size  = handle->frame_pos[handle->block_frames];
+   handle->frame        = frame;
+}
+
+static void bsv_movie_write_index(bsv_movie_t *handle)
+{
+   size_t i;
+   uint8_t entry[BSV_INDEX_ENTRY_SIZE];
+   uint64_t offset = handle->write_pos;
+   bool ret;
+
+   bsv_write_le32(entry +  0, BSV_INDEX_MAGIC);
+   bsv_write_le32(entry +  4, handle->blocks.size);
+   bsv_write_le32(entry +  8, handle->keyframes.size);
+   bsv_write_le32(entry + 12, handle->block_frame);
+
+   ret = fseek(handle->file, handle->write_pos, SEEK_SET) == 0
+      && fwrite(entry, 1, sizeof(entry), handle->file) == sizeof(entry);
+
+   for (i = 0; ret && i < handle->blocks.size + handle->keyframes.size; i++)
+   {
+      const struct bsv_index_entry *index = i < handle->blocks.size ?
+         &handle->blocks.entries[i] :
+         &handle->keyframes.entries[i - handle->blocks.size];
+      uint64_t pos = index->offset;
+
+      bsv_write_le32(entry +  0, index->frame);
+      bsv_write_le32(entry +  4, index->frames);
+      bsv_write_le32(entry +  8, (uint32_t)pos);
+      bsv_write_le32(entry + 12, (uint32_t)(pos >> 32));
+      ret = fwrite(entry, 1, sizeof(entry), handle->file) == sizeof(entry);
+   }
+
+   bsv_write_le32(entry + 0, (uint32_t)offset);
+   bsv_write_le32(entry + 4, (uint32_t)(offset >> 32));
+
+   /* Only point to the index once it is complete. */
+   ret = ret && fflush(handle->file) == 0
+      && fseek(handle->file, INDEX_OFFSET_LO_INDEX * sizeof(uint32_t),
+            SEEK_SET) == 0
+      && fwrite(entry, 1, 2 * sizeof(uint32_t), handle->file)
+      == 2 * sizeof(uint32_t);
+
+   if (!ret)
+      RARCH_WARN("Couldn't write movie index, the movie will be scanned on playback.\n");
+}
+
 void bsv_movie_free(bsv_movie_t *handle)
 {
    if (handle)
    {
+      if (handle->file && !handle->playback)
+      {
+         if (handle->in_frame)
+            bsv_movie_end_frame(handle);
+         if (bsv_movie_flush_block(handle))
+            bsv_movie_write_index(handle);
+      }
+
       if (handle->file)
          fclose(handle->file);
       free(handle->state);
+      free(handle->inputs);
       free(handle->frame_pos);
+      free(handle->packed);
+      free(handle->keyframe);
+      free(handle->blocks.entries);
+      free(handle->keyframes.entries);
       free(handle);
    }
 }
 
 bool bsv_movie_get_input(bsv_movie_t *handle, int16_t *input)
 {
-   if (fread(input, sizeof(int16_t), 1, handle->file) != 1)
+   if (!handle->in_frame)
+      bsv_movie_begin_frame(handle);
+
+   if (!handle->legacy && handle->frame >= handle->num_frames)
       return false;
 
-   *input = swap_if_big16(*input);
+   if (handle->ptr + 2 > handle->frame_end)
+   {
+      if (handle->legacy)
+         return false;
+
+      /* The core asks for more than it did while recording. */
+      *input = 0;
+      return true;
+   }
+
+   *input = (int16_t)bsv_read_le16(handle->inputs + handle->ptr);
+   handle->ptr += 2;
    return true;
 }
 
 void bsv_movie_set_input(bsv_movie_t *handle, int16_t input)
 {
-   input = swap_if_big16(input);
-   fwrite(&input, sizeof(int16_t), 1, handle->file);
+   if (!handle->in_frame)
+      bsv_movie_begin_frame(handle);
+
+   /* The count is 16 bits. */
+   if (handle->inputs_size - handle->frame_pos[handle->block_frames] - 2
+         >= 2 * 0xffff)
+      return;
+
+   if (!bsv_reserve(&handle->inputs, &handle->inputs_capacity,
+            handle->inputs_size + 2))
+      return;
+
+   bsv_write_le16(handle->inputs + handle->inputs_size, (uint16_t)input);
+   handle->inputs_size += 2;
 }
 
 bsv_movie_t *bsv_movie_init(const char *path, enum rarch_movie_type type)
@@ -175,13 +840,9 @@ bsv_movie_t *bsv_movie_init(const char *path, enum rarch_movie_type type)
    else if (!init_record(handle, path))
       goto error;
 
-   /* Just pick something really large 
-    * ~1 million frames rewind should do the trick. */
-   if (!(handle->frame_pos = (size_t*)calloc((1 << 20), sizeof(size_t))))
-      goto error; 
-
-   handle->frame_pos[0] = handle->min_file_pos;
-   handle->frame_mask = (1 << 20) - 1;
+   if (!bsv_reserve_frames(handle, BSV_BLOCK_FRAMES + 1))
+      goto error;
+   handle->frame_pos[0] = 0;
 
    return handle;
 
@@ -192,12 +853,15 @@ error:
 
 void bsv_movie_set_frame_start(bsv_movie_t *handle)
 {
-   handle->frame_pos[handle->frame_ptr] = ftell(handle->file);
+   if (!handle->in_frame)
+      bsv_movie_begin_frame(handle);
 }
 
 void bsv_movie_set_frame_end(bsv_movie_t *handle)
 {
-   handle->frame_ptr = (handle->frame_ptr + 1) & handle->frame_mask;
+   if (!handle->in_frame)
+      bsv_movie_begin_frame(handle);
+   bsv_movie_end_frame(handle);
 
    handle->first_rewind = !handle->did_rewind;
    handle->did_rewind = false;
@@ -205,41 +869,125 @@ void bsv_movie_set_frame_end(bsv_movie_t *handle)
 
 void bsv_movie_frame_rewind(bsv_movie_t *handle)
 {
+   /* First time rewind is performed, the old frame is simply replayed.
+    * Successively rewinding frames, we need to rewind past the frame
+    * which was replayed, plus another. */
+   unsigned frames = handle->first_rewind ? 1 : 2;
+   unsigned frame  = handle->frame > frames ? handle->frame - frames : 0;
+
    handle->did_rewind = true;
+   handle->in_frame   = false;
 
-   if ((handle->frame_ptr <= 1) && (handle->frame_pos[0] == handle->min_file_pos))
+   if (handle->playback)
    {
-      /* If we're at the beginning... */
-      handle->frame_ptr = 0;
-      fseek(handle->file, handle->min_file_pos, SEEK_SET);
+      if (handle->legacy)
+         handle->ptr = handle->frame_pos[frame];
+      handle->frame = frame;
+      return;
    }
-   else
+
+   bsv_movie_truncate(handle, frame);
+
+   if (frame == 0 && handle->state_size)
    {
-      /* First time rewind is performed, the old frame is simply replayed.
-       * However, playing back that frame caused us to read data, and push
-       * data to the ring buffer.
-       *
-       * Sucessively rewinding frames, we need to rewind past the read data,
-       * plus another. */
-      handle->frame_ptr = (handle->frame_ptr -
-            (handle->first_rewind ? 1 : 2)) & handle->frame_mask;
-      fseek(handle->file, handle->frame_pos[handle->frame_ptr], SEEK_SET);
+      /* We rewound past the beginning. If recording, we simply
+       * reset the starting point. Nice and easy. */
+      pretro_serialize(handle->state, handle->state_size);
+      fseek(handle->file, handle->state_pos, SEEK_SET);
+      fwrite(handle->state, 1, handle->state_size, handle->file);
    }
+}
+
+static void bsv_movie_video_null(const void *data, unsigned width,
+      unsigned height, size_t pitch)
+{
+   (void)data;
+   (void)width;
+   (void)height;
+   (void)pitch;
+}
+
+static void bsv_movie_audio_null(int16_t left, int16_t right)
+{
+   (void)left;
+   (void)right;
+}
 
-   if (ftell(handle->file) <= (long)handle->min_file_pos)
+static size_t bsv_movie_audio_batch_null(const int16_t *data, size_t frames)
+{
+   (void)data;
+   return frames;
+}
+
+bool bsv_movie_seek(bsv_movie_t *handle, unsigned frame)
+{
+   unsigned start       = 0;
+   const uint8_t *state = handle->state;
+
+   if (!handle->playback || handle->legacy || !handle->state_size
+         || frame > handle->num_frames)
+      return false;
+
+   if (handle->keyframes.size
+         && handle->keyframes.entries[0].frame <= frame)
    {
-      /* We rewound past the beginning. */
+      struct bsv_block block;
+      const struct bsv_index_entry *entry = &handle->keyframes.entries[
+         bsv_index_find(&handle->keyframes, frame)];
 
-      if (!handle->playback)
+      start = entry->frame;
+      state = NULL;
+
+      /* Closer than the keyframe already, just run ahead. */
+      if (handle->frame < start || handle->frame > frame)
       {
-         /* If recording, we simply reset
-          * the starting point. Nice and easy. */
-         fseek(handle->file, 4 * sizeof(uint32_t), SEEK_SET);
-         pretro_serialize(handle->state, handle->state_size);
-         fwrite(handle->state, 1, handle->state_size, handle->file);
+         if (!bsv_movie_read_block(handle, entry->offset, BSV_BLOCK_KEYFRAME,
+                  &block, &handle->keyframe, &handle->keyframe_capacity)
+               || block.size != handle->state_size)
+         {
+            RARCH_ERR("Couldn't read movie keyframe at frame %u.\n", start);
+            return false;
+         }
+         state = handle->keyframe;
       }
-      else
-         fseek(handle->file, handle->min_file_pos, SEEK_SET);
    }
+   else if (handle->frame <= frame)
+      state = NULL;
+
+   if (state)
+   {
+      if (!pretro_unserialize(state, handle->state_size))
+         return false;
+      handle->frame = start;
+   }
+
+   handle->in_frame = false;
+
+   pretro_set_video_refresh(bsv_movie_video_null);
+   pretro_set_audio_sample(bsv_movie_audio_null);
+   pretro_set_audio_sample_batch(bsv_movie_audio_batch_null);
+
+   while (handle->frame < frame)
+   {
+      bsv_movie_begin_frame(handle);
+      pretro_run();
+      bsv_movie_end_frame(handle);
+   }
+
+   pretro_set_video_refresh(driver.retro_ctx.frame_cb);
+   retro_set_rewind_callbacks();
+
+   handle->first_rewind = false;
+   handle->did_rewind   = false;
+   return true;
+}
+
+unsigned bsv_movie_get_frame(bsv_movie_t *handle)
+{
+   return handle->frame;
 }
 
+unsigned bsv_movie_get_num_frames(bsv_movie_t *handle)
+{
+   return handle->playback ? handle->num_frames : handle->frame;
+}
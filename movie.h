@@ -21,12 +21,30 @@
 #include "boolean.h"
 
 #define BSV_MAGIC 0x42535631
+#define BSV2_MAGIC 0x42535632
 
 #define MAGIC_INDEX 0
 #define SERIALIZER_INDEX 1
 #define CRC_INDEX 2
 #define STATE_SIZE_INDEX 3
 
+/* BSV2 extends the BSV1 header. */
+#define KEYFRAME_INTERVAL_INDEX 4
+#define INDEX_OFFSET_LO_INDEX 6
+#define INDEX_OFFSET_HI_INDEX 7
+
+/* BSV1 is the header, the start state and then every input the core
+ * asked for, 16 bits each, with nothing marking frames.
+ *
+ * BSV2 follows the start state with blocks. Input blocks hold a run of
+ * frames, each a 16 bit input count and the inputs, compressed as a
+ * whole. Keyframe blocks hold a compressed savestate taken at the start
+ * of a frame, every keyframe interval frames. An index of all blocks
+ * is written at the end and its offset is stored in the header. If the
+ * recording was cut short, the blocks are scanned instead.
+ *
+ * Movies are recorded as BSV2, both are played back. */
+
 typedef struct bsv_movie bsv_movie_t;
 
 enum rarch_movie_type
@@ -50,6 +68,17 @@ void bsv_movie_set_frame_end(bsv_movie_t *handle);
 
 void bsv_movie_frame_rewind(bsv_movie_t *handle);
 
+/* Jumps to the start of frame during playback, by loading the closest
+ * keyframe and running the core up to frame with video and audio off.
+ * Not supported for BSV1 movies. */
+bool bsv_movie_seek(bsv_movie_t *handle, unsigned frame);
+
+/* Current frame, counted from the start of the movie. */
+unsigned bsv_movie_get_frame(bsv_movie_t *handle);
+
+/* Frames in the movie, 0 if unknown. */
+unsigned bsv_movie_get_num_frames(bsv_movie_t *handle);
+
 void bsv_movie_free(bsv_movie_t *handle);
 
 #endif
@@ -31,45 +31,134 @@ enum bps_mode
    TARGET_COPY
 };
 
+/* Checksums are calculated over whole buffers once patching is done,
+ * and runs are copied with memcpy() instead of one byte at a time. */
 struct bps_data
 {
    const uint8_t *modify_data, *source_data; 
    uint8_t *target_data;
    size_t modify_length, source_length, target_length;
    size_t modify_offset, source_offset, target_offset;
-   uint32_t modify_checksum, source_checksum, target_checksum;
 
-   size_t source_relative_offset, target_relative_offset, output_offset;
+   /* Actions end where the checksums start. */
+   size_t modify_end;
+   size_t output_offset;
 };
 
-static uint8_t bps_read(struct bps_data *bps)
+static uint32_t patch_read_le32(const uint8_t *data)
 {
-   uint8_t data = bps->modify_data[bps->modify_offset++];
-   bps->modify_checksum = crc32_adjust(bps->modify_checksum, data);
-   return data;
+   return data[0] | (data[1] << 8) | (data[2] << 16) |
+      ((uint32_t)data[3] << 24);
 }
 
-static uint64_t bps_decode(struct bps_data *bps)
+static bool bps_decode(struct bps_data *bps, uint64_t *out)
 {
    uint64_t data = 0, shift = 1;
 
-   for (;;)
+   while (bps->modify_offset < bps->modify_end)
    {
-      uint8_t x = bps_read(bps);
+      uint8_t x = bps->modify_data[bps->modify_offset++];
       data += (x & 0x7f) * shift;
       if (x & 0x80)
-         break;
+      {
+         *out = data;
+         return true;
+      }
       shift <<= 7;
       data += shift;
    }
 
-   return data;
+   return false;
+}
+
+static bool bps_header(struct bps_data *bps,
+      uint64_t *source_size, uint64_t *target_size)
+{
+   uint64_t markup_size;
+
+   if (bps->modify_length < 19)
+      return false;
+
+   bps->modify_end = bps->modify_length - 12;
+   if (memcmp(bps->modify_data, "BPS1", 4) != 0)
+      return false;
+   bps->modify_offset = 4;
+
+   if (!bps_decode(bps, source_size) || !bps_decode(bps, target_size)
+         || !bps_decode(bps, &markup_size))
+      return false;
+
+   if (markup_size > bps->modify_end - bps->modify_offset)
+      return false;
+   bps->modify_offset += markup_size;
+   return true;
+}
+
+/* A TargetCopy may read bytes it's writing itself, which repeats
+ * them. Copies in runs no longer than the distance between the two. */
+static void bps_target_copy(struct bps_data *bps, size_t length)
+{
+   uint8_t *out = bps->target_data + bps->output_offset;
+   const uint8_t *in = bps->target_data + bps->target_offset;
+   size_t distance = out - in;
+
+   bps->target_offset += length;
+
+   if (distance == 1)
+   {
+      memset(out, *in, length);
+      return;
+   }
+
+   while (length)
+   {
+      size_t run = length < distance ? length : distance;
+      memcpy(out, in, run);
+      out    += run;
+      in     += run;
+      length -= run;
+   }
+}
+
+/* Moves a relative SourceCopy/TargetCopy offset, checking the result
+ * stays within 0..limit. */
+static bool bps_seek(struct bps_data *bps, size_t *offset, size_t limit)
+{
+   uint64_t data;
+   uint64_t distance;
+
+   if (!bps_decode(bps, &data))
+      return false;
+
+   distance = data >> 1;
+   if (data & 1)
+   {
+      if (distance > *offset)
+         return false;
+      *offset -= distance;
+   }
+   else
+   {
+      if (distance > limit - *offset)
+         return false;
+      *offset += distance;
+   }
+
+   return true;
 }
 
-static void bps_write(struct bps_data *bps, uint8_t data)
+size_t bps_get_target_size(
+      const uint8_t *modify_data, size_t modify_length,
+      size_t source_length)
 {
-   bps->target_data[bps->output_offset++] = data;
-   bps->target_checksum = crc32_adjust(bps->target_checksum, data);
+   uint64_t source_size, target_size;
+   struct bps_data bps = {0};
+   bps.modify_data = modify_data;
+   bps.modify_length = modify_length;
+
+   if (!bps_header(&bps, &source_size, &target_size))
+      return 0;
+   return target_size;
 }
 
 patch_error_t bps_apply_patch(
@@ -77,100 +166,93 @@ patch_error_t bps_apply_patch(
       const uint8_t *source_data, size_t source_length,
       uint8_t *target_data, size_t *target_length)
 {
-   size_t i;
+   uint64_t modify_source_size, modify_target_size;
+   uint32_t modify_source_checksum, modify_target_checksum,
+            modify_modify_checksum;
+   struct bps_data bps = {0};
+
    if (modify_length < 19)
       return PATCH_PATCH_TOO_SMALL;
 
-   struct bps_data bps = {0};
    bps.modify_data = modify_data;
    bps.modify_length = modify_length;
    bps.target_data = target_data;
    bps.target_length = *target_length;
    bps.source_data = source_data;
    bps.source_length = source_length;
-   bps.modify_checksum = ~0;
-   bps.target_checksum = ~0;
 
-   if ((bps_read(&bps) != 'B') || (bps_read(&bps) != 'P') ||
-         (bps_read(&bps) != 'S') || (bps_read(&bps) != '1'))
+   if (!bps_header(&bps, &modify_source_size, &modify_target_size))
       return PATCH_PATCH_INVALID_HEADER;
 
-   size_t modify_source_size = bps_decode(&bps);
-   size_t modify_target_size = bps_decode(&bps);
-   size_t modify_markup_size = bps_decode(&bps);
-   for (i = 0; i < modify_markup_size; i++)
-      bps_read(&bps);
-
    if (modify_source_size > bps.source_length)
       return PATCH_SOURCE_TOO_SMALL;
    if (modify_target_size > bps.target_length)
       return PATCH_TARGET_TOO_SMALL;
 
-   while (bps.modify_offset < bps.modify_length - 12)
+   while (bps.modify_offset < bps.modify_end)
    {
-      size_t length = bps_decode(&bps);
-      unsigned mode = length & 3;
+      uint64_t length;
+      unsigned mode;
+
+      if (!bps_decode(&bps, &length))
+         return PATCH_PATCH_INVALID;
+
+      mode = length & 3;
       length = (length >> 2) + 1;
 
+      if (length > modify_target_size - bps.output_offset)
+         return PATCH_PATCH_INVALID;
+
       switch (mode)
       {
          case SOURCE_READ:
-            while (length--)
-               bps_write(&bps, bps.source_data[bps.output_offset]);
+            if (bps.output_offset + length > bps.source_length)
+               return PATCH_PATCH_INVALID;
+            memcpy(bps.target_data + bps.output_offset,
+                  bps.source_data + bps.output_offset, length);
             break;
 
          case TARGET_READ:
-            while (length--)
-               bps_write(&bps, bps_read(&bps));
+            if (length > bps.modify_end - bps.modify_offset)
+               return PATCH_PATCH_INVALID;
+            memcpy(bps.target_data + bps.output_offset,
+                  bps.modify_data + bps.modify_offset, length);
+            bps.modify_offset += length;
             break;
 
          case SOURCE_COPY:
-         case TARGET_COPY:
-         {
-            int offset = bps_decode(&bps);
-            bool negative = offset & 1;
-            offset >>= 1;
-            if (negative)
-               offset = -offset;
+            if (!bps_seek(&bps, &bps.source_offset, bps.source_length)
+                  || length > bps.source_length - bps.source_offset)
+               return PATCH_PATCH_INVALID;
+            memcpy(bps.target_data + bps.output_offset,
+                  bps.source_data + bps.source_offset, length);
+            bps.source_offset += length;
+            break;
 
-            if (mode == SOURCE_COPY)
-            {
-               bps.source_offset += offset;
-               while (length--)
-                  bps_write(&bps, bps.source_data[bps.source_offset++]);
-            }
-            else
-            {
-               bps.target_offset += offset;
-               while (length--)
-                  bps_write(&bps, bps.target_data[bps.target_offset++]);
-               break;
-            }
+         case TARGET_COPY:
+            /* Can only copy what's been written already. */
+            if (!bps_seek(&bps, &bps.target_offset, bps.output_offset)
+                  || bps.target_offset == bps.output_offset)
+               return PATCH_PATCH_INVALID;
+            bps_target_copy(&bps, length);
             break;
-         }
       }
-   }
-
-   uint32_t modify_source_checksum = 0, modify_target_checksum = 0,
-            modify_modify_checksum = 0;
-
-   for (i = 0; i < 32; i += 8)
-      modify_source_checksum |= bps_read(&bps) << i;
-   for (i = 0; i < 32; i += 8)
-      modify_target_checksum |= bps_read(&bps) << i;
 
-   uint32_t checksum = ~bps.modify_checksum;
-   for (i = 0; i < 32; i += 8)
-      modify_modify_checksum |= bps_read(&bps) << i;
+      bps.output_offset += length;
+   }
 
-   bps.source_checksum = crc32_calculate(bps.source_data, bps.source_length);
-   bps.target_checksum = ~bps.target_checksum;
+   modify_source_checksum = patch_read_le32(modify_data + modify_length - 12);
+   modify_target_checksum = patch_read_le32(modify_data + modify_length - 8);
+   modify_modify_checksum = patch_read_le32(modify_data + modify_length - 4);
 
-   if (bps.source_checksum != modify_source_checksum)
+   if (crc32_calculate(bps.source_data, bps.source_length)
+         != modify_source_checksum)
       return PATCH_SOURCE_CHECKSUM_INVALID;
-   if (bps.target_checksum != modify_target_checksum)
+   if (crc32_calculate(bps.target_data, bps.output_offset)
+         != modify_target_checksum)
       return PATCH_TARGET_CHECKSUM_INVALID;
-   if (checksum != modify_modify_checksum)
+   if (crc32_calculate(modify_data, modify_length - 4)
+         != modify_modify_checksum)
       return PATCH_PATCH_CHECKSUM_INVALID;
 
    *target_length = modify_target_size;
@@ -182,40 +264,28 @@ struct ups_data
 {
    const uint8_t *patch_data, *source_data; 
    uint8_t *target_data;
-   unsigned patch_length, source_length, target_length;
-   unsigned patch_offset, source_offset, target_offset;
-   unsigned patch_checksum, source_checksum, target_checksum;
+   size_t patch_length, source_length, target_length;
+   size_t patch_offset, source_offset, target_offset;
 };
 
 static uint8_t ups_patch_read(struct ups_data *data) 
 {
    if (data->patch_offset < data->patch_length) 
-   {
-      uint8_t n = data->patch_data[data->patch_offset++];
-      data->patch_checksum = crc32_adjust(data->patch_checksum, n);
-      return n;
-   }
+      return data->patch_data[data->patch_offset++];
    return 0x00;
 }
 
 static uint8_t ups_source_read(struct ups_data *data) 
 {
    if (data->source_offset < data->source_length) 
-   {
-      uint8_t n = data->source_data[data->source_offset++];
-      data->source_checksum = crc32_adjust(data->source_checksum, n);
-      return n;
-   }
+      return data->source_data[data->source_offset++];
    return 0x00;
 }
 
 static void ups_target_write(struct ups_data *data, uint8_t n) 
 {
    if (data->target_offset < data->target_length) 
-   {
       data->target_data[data->target_offset] = n;
-      data->target_checksum = crc32_adjust(data->target_checksum, n);
-   }
 
    data->target_offset++;
 }
@@ -223,7 +293,7 @@ static void ups_target_write(struct ups_data *data, uint8_t n)
 static uint64_t ups_decode(struct ups_data *data) 
 {
    uint64_t offset = 0, shift = 1;
-   while (true) 
+   while (data->patch_offset < data->patch_length) 
    {
       uint8_t x = ups_patch_read(data);
       offset += (x & 0x7f) * shift;
@@ -235,12 +305,94 @@ static uint64_t ups_decode(struct ups_data *data)
    return offset;
 }
 
+/* Copies source to target unchanged. Like ups_source_read() and
+ * ups_target_write(), source past its end reads as zeroes and
+ * target past its end is dropped. */
+static void ups_copy(struct ups_data *data, uint64_t length)
+{
+   size_t source_left = data->source_length - data->source_offset;
+   size_t source_run = length < source_left ? length : source_left;
+
+   if (data->target_offset < data->target_length)
+   {
+      size_t target_left = data->target_length - data->target_offset;
+      size_t run = length < target_left ? length : target_left;
+      size_t copy = run < source_run ? run : source_run;
+
+      memcpy(data->target_data + data->target_offset,
+            data->source_data + data->source_offset, copy);
+      memset(data->target_data + data->target_offset + copy, 0, run - copy);
+   }
+
+   data->source_offset += source_run;
+   data->target_offset += length;
+}
+
+/* XORs source with patch up to and including a zero byte. */
+static void ups_xor(struct ups_data *data)
+{
+   size_t i;
+   const uint8_t *patch = data->patch_data + data->patch_offset;
+   size_t patch_left = data->patch_length - data->patch_offset;
+   const uint8_t *end = (const uint8_t*)memchr(patch, 0, patch_left);
+   size_t length = end ? (size_t)(end - patch) : patch_left;
+
+   if (length <= data->source_length - data->source_offset
+         && data->target_offset <= data->target_length
+         && length <= data->target_length - data->target_offset)
+   {
+      const uint8_t *source = data->source_data + data->source_offset;
+      uint8_t *target = data->target_data + data->target_offset;
+
+      for (i = 0; i < length; i++)
+         target[i] = patch[i] ^ source[i];
+
+      data->source_offset += length;
+      data->target_offset += length;
+   }
+   else
+   {
+      for (i = 0; i < length; i++)
+         ups_target_write(data, patch[i] ^ ups_source_read(data));
+   }
+
+   data->patch_offset += length + (end ? 1 : 0);
+   ups_target_write(data, ups_source_read(data));
+}
+
+size_t ups_get_target_size(
+      const uint8_t *patchdata, size_t patchlength,
+      size_t sourcelength)
+{
+   uint64_t source_read_length, target_read_length;
+   struct ups_data data = {0};
+   data.patch_data = patchdata;
+   data.patch_length = patchlength;
+
+   if (patchlength < 18 || memcmp(patchdata, "UPS1", 4) != 0)
+      return 0;
+   data.patch_offset = 4;
+
+   source_read_length = ups_decode(&data);
+   target_read_length = ups_decode(&data);
+
+   if (sourcelength == source_read_length)
+      return target_read_length;
+   if (sourcelength == target_read_length)
+      return source_read_length;
+   return 0;
+}
+
 patch_error_t ups_apply_patch(
       const uint8_t *patchdata, size_t patchlength,
       const uint8_t *sourcedata, size_t sourcelength,
       uint8_t *targetdata, size_t *targetlength)
 {
    size_t i;
+   uint64_t source_read_length, target_read_length;
+   uint32_t patch_read_checksum = 0, source_read_checksum = 0,
+            target_read_checksum = 0;
+   uint32_t patch_result_checksum, source_checksum, target_checksum;
    struct ups_data data = {0};
    data.patch_data = patchdata;
    data.source_data = sourcedata;
@@ -248,23 +400,15 @@ patch_error_t ups_apply_patch(
    data.patch_length = patchlength;
    data.source_length = sourcelength;
    data.target_length = *targetlength;
-   data.patch_checksum = ~0;
-   data.source_checksum = ~0;
-   data.target_checksum = ~0;
 
    if (data.patch_length < 18) 
       return PATCH_PATCH_INVALID;
-   if (ups_patch_read(&data) != 'U') 
-      return PATCH_PATCH_INVALID;
-   if (ups_patch_read(&data) != 'P') 
-      return PATCH_PATCH_INVALID;
-   if (ups_patch_read(&data) != 'S') 
-      return PATCH_PATCH_INVALID;
-   if (ups_patch_read(&data) != '1') 
+   if (memcmp(data.patch_data, "UPS1", 4) != 0)
       return PATCH_PATCH_INVALID;
+   data.patch_offset = 4;
 
-   unsigned source_read_length = ups_decode(&data);
-   unsigned target_read_length = ups_decode(&data);
+   source_read_length = ups_decode(&data);
+   target_read_length = ups_decode(&data);
 
    if (data.source_length != source_read_length
          && data.source_length != target_read_length) 
@@ -277,52 +421,45 @@ patch_error_t ups_apply_patch(
 
    while (data.patch_offset < data.patch_length - 12) 
    {
-      unsigned length = ups_decode(&data);
-      while (length--) 
-         ups_target_write(&data, ups_source_read(&data));
-      while (true) 
-      {
-         uint8_t patch_xor = ups_patch_read(&data);
-         ups_target_write(&data, patch_xor ^ ups_source_read(&data));
-         if (patch_xor == 0) break;
-      }
+      ups_copy(&data, ups_decode(&data));
+      ups_xor(&data);
    }
 
-   while (data.source_offset < data.source_length) 
-      ups_target_write(&data, ups_source_read(&data));
-   while (data.target_offset < data.target_length) 
-      ups_target_write(&data, ups_source_read(&data));
-
-   uint32_t patch_read_checksum = 0, source_read_checksum = 0,
-            target_read_checksum = 0;
+   /* Whatever is left is unchanged, or grows the target with zeroes. */
+   ups_copy(&data, data.source_length - data.source_offset);
+   if (data.target_offset < data.target_length)
+      ups_copy(&data, data.target_length - data.target_offset);
 
    for (i = 0; i < 4; i++) 
-      source_read_checksum |= ups_patch_read(&data) << (i * 8);
+      source_read_checksum |= (uint32_t)ups_patch_read(&data) << (i * 8);
    for (i = 0; i < 4; i++) 
-      target_read_checksum |= ups_patch_read(&data) << (i * 8);
+      target_read_checksum |= (uint32_t)ups_patch_read(&data) << (i * 8);
 
-   uint32_t patch_result_checksum = ~data.patch_checksum;
-   data.source_checksum = ~data.source_checksum;
-   data.target_checksum = ~data.target_checksum;
+   /* Covers everything but the patch checksum itself,
+    * as far as it was read. */
+   patch_result_checksum = crc32_calculate(data.patch_data,
+         data.patch_offset);
+   source_checksum = crc32_calculate(data.source_data, data.source_length);
+   target_checksum = crc32_calculate(data.target_data, data.target_length);
 
    for (i = 0; i < 4; i++) 
-      patch_read_checksum |= ups_patch_read(&data) << (i * 8);
+      patch_read_checksum |= (uint32_t)ups_patch_read(&data) << (i * 8);
 
    if (patch_result_checksum != patch_read_checksum) 
       return PATCH_PATCH_INVALID;
 
-   if (data.source_checksum == source_read_checksum
+   if (source_checksum == source_read_checksum
          && data.source_length == source_read_length) 
    {
-      if (data.target_checksum == target_read_checksum
+      if (target_checksum == target_read_checksum
             && data.target_length == target_read_length) 
          return PATCH_SUCCESS;
       return PATCH_TARGET_INVALID;
    } 
-   else if (data.source_checksum == target_read_checksum
+   else if (source_checksum == target_read_checksum
          && data.source_length == target_read_length) 
    {
-      if (data.target_checksum == source_read_checksum
+      if (target_checksum == source_read_checksum
             && data.target_length == source_read_length) 
          return PATCH_SUCCESS;
       return PATCH_TARGET_INVALID;
@@ -331,60 +468,66 @@ patch_error_t ups_apply_patch(
       return PATCH_SOURCE_INVALID;
 }
 
-patch_error_t ips_apply_patch(
-      const uint8_t *patchdata, size_t patchlen,
-      const uint8_t *sourcedata, size_t sourcelength,
-      uint8_t *targetdata, size_t *targetlength)
+/* Walks the records of an IPS patch. With target set, applies them,
+ * otherwise only works out how large the target gets. filled is how
+ * far the records reach. Returns false for a broken patch. */
+static bool ips_walk(const uint8_t *patchdata, size_t patchlen,
+      uint8_t *target, size_t capacity, size_t *filled,
+      size_t *targetlength)
 {
-   if (patchlen < 8 ||
-         patchdata[0] != 'P' ||
-         patchdata[1] != 'A' ||
-         patchdata[2] != 'T' ||
-         patchdata[3] != 'C' ||
-         patchdata[4] != 'H')
-      return PATCH_PATCH_INVALID;
+   size_t offset = 5;
 
-   memcpy(targetdata, sourcedata, sourcelength);
-
-   uint32_t offset = 5;
-   *targetlength = sourcelength;
+   if (patchlen < 8 || memcmp(patchdata, "PATCH", 5) != 0)
+      return false;
 
    for (;;)
    {
+      uint32_t address;
+      unsigned length;
+      const uint8_t *run = NULL;
+
       if (offset > patchlen - 3)
          break;
 
-      uint32_t address = patchdata[offset++] << 16;
+      address  = patchdata[offset++] << 16;
       address |= patchdata[offset++] << 8;
       address |= patchdata[offset++] << 0;
 
       if (address == 0x454f46) /* EOF */
       {
          if (offset == patchlen)
-            return PATCH_SUCCESS;
+            return true;
          else if (offset == patchlen - 3)
          {
             uint32_t size = patchdata[offset++] << 16;
             size |= patchdata[offset++] << 8;
             size |= patchdata[offset++] << 0;
+
+            if (target && size > *filled)
+            {
+               if (size > capacity)
+                  return false;
+               memset(target + *filled, 0, size - *filled);
+               *filled = size;
+            }
             *targetlength = size;
-            return PATCH_SUCCESS;
+            return true;
          }
       }
 
       if (offset > patchlen - 2)
          break;
 
-      unsigned length = patchdata[offset++] << 8;
+      length  = patchdata[offset++] << 8;
       length |= patchdata[offset++] << 0;
 
       if (length) /* Copy */
       {
-         if (offset > patchlen - length)
+         if (length > patchlen - offset)
             break;
 
-         while (length--)
-            targetdata[address++] = patchdata[offset++];
+         run = patchdata + offset;
+         offset += length;
       }
       else /* RLE */
       {
@@ -397,16 +540,66 @@ patch_error_t ips_apply_patch(
          if (length == 0) /* Illegal */
             break;
 
-         while (length--)
-            targetdata[address++] = patchdata[offset];
-
          offset++;
       }
 
-      if (address > *targetlength)
-         *targetlength = address;
+      if (target)
+      {
+         if (address + length > capacity)
+            return false;
+
+         /* Gaps past the end of the source read as zeroes. */
+         if (address > *filled)
+            memset(target + *filled, 0, address - *filled);
+
+         if (run)
+            memcpy(target + address, run, length);
+         else
+            memset(target + address, patchdata[offset - 1], length);
+      }
+
+      if (address + length > *filled)
+         *filled = address + length;
+      if (address + length > *targetlength)
+         *targetlength = address + length;
    }
 
-   return PATCH_PATCH_INVALID;
+   return false;
+}
+
+size_t ips_get_target_size(
+      const uint8_t *patchdata, size_t patchlen,
+      size_t sourcelength)
+{
+   size_t targetlength = sourcelength;
+   size_t filled = sourcelength;
+
+   /* Room for every record, even if the patch truncates at the end. */
+   if (ips_walk(patchdata, patchlen, NULL, 0, &filled, &targetlength))
+      return targetlength > filled ? targetlength : filled;
+   return sourcelength;
 }
 
+patch_error_t ips_apply_patch(
+      const uint8_t *patchdata, size_t patchlen,
+      const uint8_t *sourcedata, size_t sourcelength,
+      uint8_t *targetdata, size_t *targetlength)
+{
+   size_t capacity = *targetlength;
+   size_t filled = sourcelength;
+
+   if (patchlen < 8 || memcmp(patchdata, "PATCH", 5) != 0)
+      return PATCH_PATCH_INVALID;
+
+   if (sourcelength > capacity)
+      return PATCH_TARGET_TOO_SMALL;
+
+   memcpy(targetdata, sourcedata, sourcelength);
+   *targetlength = sourcelength;
+
+   if (!ips_walk(patchdata, patchlen, targetdata, capacity,
+            &filled, targetlength))
+      return PATCH_PATCH_INVALID;
+
+   return PATCH_SUCCESS;
+}
@@ -41,6 +41,22 @@ typedef enum
 typedef patch_error_t (*patch_func_t)(const uint8_t*, size_t,
       const uint8_t*, size_t, uint8_t*, size_t*);
 
+/* Size of the target buffer a patch needs for a source of the
+ * given size, as far as the patch header tells. */
+typedef size_t (*patch_size_func_t)(const uint8_t*, size_t, size_t);
+
+size_t bps_get_target_size(
+      const uint8_t *patch_data, size_t patch_length,
+      size_t source_length);
+
+size_t ups_get_target_size(
+      const uint8_t *patch_data, size_t patch_length,
+      size_t source_length);
+
+size_t ips_get_target_size(
+      const uint8_t *patch_data, size_t patch_length,
+      size_t source_length);
+
 patch_error_t bps_apply_patch(
       const uint8_t *patch_data, size_t patch_length,
       const uint8_t *source_data, size_t source_length,
@@ -76,13 +76,155 @@
 #include <sys/sysctl.h>
 #endif
 
+#include <stdlib.h>
 #include <string.h>
+#include "compat/strl.h"
 
 const struct retro_perf_counter *perf_counters_rarch[MAX_COUNTERS];
 const struct retro_perf_counter *perf_counters_libretro[MAX_COUNTERS];
 unsigned perf_ptr_rarch;
 unsigned perf_ptr_libretro;
 
+/* retro_perf_counter is part of the libretro ABI and can't grow,
+ * so histograms are kept on the side, looked up by counter address.
+ * Slots outlive libretro counters (which go away with the core),
+ * so trace events can still be named after the core is unloaded. */
+#define PERF_HIST_BUCKETS 252
+#define PERF_MAX_STATS (MAX_COUNTERS * 4)
+#define PERF_HASH_SIZE (PERF_MAX_STATS * 2)
+#define PERF_TRACE_EVENTS (1 << 16)
+
+struct perf_stats
+{
+   const struct retro_perf_counter *perf;
+   char ident[64];
+   bool libretro;
+   retro_perf_tick_t max;
+   uint32_t hist[PERF_HIST_BUCKETS];
+};
+
+struct perf_hash_entry
+{
+   const struct retro_perf_counter *perf;
+   unsigned slot;
+};
+
+struct perf_trace_event
+{
+   retro_perf_tick_t start;
+   retro_perf_tick_t duration;
+   unsigned slot;
+};
+
+static struct perf_stats *perf_stats[PERF_MAX_STATS];
+static unsigned perf_stats_count;
+static struct perf_hash_entry perf_hash[PERF_HASH_SIZE];
+
+static struct perf_trace_event *perf_trace;
+static uint64_t perf_trace_ptr;
+static retro_perf_tick_t perf_trace_start_tick;
+static retro_time_t perf_trace_start_usec;
+
+static unsigned perf_hash_index(const struct retro_perf_counter *perf)
+{
+   uint32_t hash = (uint32_t)((uintptr_t)perf >> 3) * 2654435761u;
+   return (hash >> 16) & (PERF_HASH_SIZE - 1);
+}
+
+static void perf_hash_insert(const struct retro_perf_counter *perf,
+      unsigned slot)
+{
+   unsigned i = perf_hash_index(perf);
+   while (perf_hash[i].perf)
+      i = (i + 1) & (PERF_HASH_SIZE - 1);
+
+   perf_hash[i].perf = perf;
+   perf_hash[i].slot = slot;
+}
+
+static int perf_hash_find(const struct retro_perf_counter *perf)
+{
+   unsigned i;
+   for (i = perf_hash_index(perf); perf_hash[i].perf;
+         i = (i + 1) & (PERF_HASH_SIZE - 1))
+   {
+      if (perf_hash[i].perf == perf)
+         return perf_hash[i].slot;
+   }
+
+   return -1;
+}
+
+static void perf_trace_init(void)
+{
+   if (perf_trace || !*g_extern.perfcnt_trace_path)
+      return;
+
+   perf_trace = (struct perf_trace_event*)calloc(PERF_TRACE_EVENTS,
+         sizeof(*perf_trace));
+   if (!perf_trace)
+      return;
+
+   perf_trace_ptr        = 0;
+   perf_trace_start_tick = rarch_get_perf_counter();
+   perf_trace_start_usec = rarch_get_time_usec();
+   RARCH_LOG("[PERF]: Tracing the last %u counter events.\n",
+         PERF_TRACE_EVENTS);
+}
+
+static void perf_stats_add(const struct retro_perf_counter *perf,
+      bool libretro)
+{
+   unsigned i, slot = perf_stats_count;
+   struct perf_stats *stats = NULL;
+   char *ident;
+
+   if (!g_extern.perfcnt_enable)
+      return;
+
+   perf_trace_init();
+
+   /* Without a trace, nothing refers to the slots of
+    * unloaded libretro counters, so they can be reused. */
+   if (!perf_trace)
+   {
+      for (i = 0; i < perf_stats_count; i++)
+      {
+         if (!perf_stats[i]->perf)
+         {
+            slot = i;
+            break;
+         }
+      }
+   }
+
+   if (slot == perf_stats_count)
+   {
+      if (perf_stats_count >= PERF_MAX_STATS)
+         return;
+      perf_stats[slot] = (struct perf_stats*)malloc(sizeof(*stats));
+      if (!perf_stats[slot])
+         return;
+      perf_stats_count++;
+   }
+
+   stats = perf_stats[slot];
+   memset(stats, 0, sizeof(*stats));
+   stats->perf     = perf;
+   stats->libretro = libretro;
+   strlcpy(stats->ident, perf->ident ? perf->ident : "(null)",
+         sizeof(stats->ident));
+
+   /* Keep the ident safe to emit as a JSON string. */
+   for (ident = stats->ident; *ident; ident++)
+   {
+      if (*ident == '"' || *ident == '\\' || (unsigned char)*ident < 0x20)
+         *ident = '_';
+   }
+
+   perf_hash_insert(perf, slot);
+}
+
 void rarch_perf_register(struct retro_perf_counter *perf)
 {
    if (!g_extern.perfcnt_enable || perf->registered 
@@ -91,6 +233,7 @@ void rarch_perf_register(struct retro_perf_counter *perf)
 
    perf_counters_rarch[perf_ptr_rarch++] = perf;
    perf->registered = true;
+   perf_stats_add(perf, false);
 }
 
 void retro_perf_register(struct retro_perf_counter *perf)
@@ -100,12 +243,207 @@ void retro_perf_register(struct retro_perf_counter *perf)
 
    perf_counters_libretro[perf_ptr_libretro++] = perf;
    perf->registered = true;
+   perf_stats_add(perf, true);
 }
 
 void retro_perf_clear(void)
 {
+   unsigned i;
+
    perf_ptr_libretro = 0;
    memset(perf_counters_libretro, 0, sizeof(perf_counters_libretro));
+
+   /* The counters live in the core, which is going away. */
+   memset(perf_hash, 0, sizeof(perf_hash));
+   for (i = 0; i < perf_stats_count; i++)
+   {
+      if (perf_stats[i]->libretro)
+         perf_stats[i]->perf = NULL;
+      else
+         perf_hash_insert(perf_stats[i]->perf, i);
+   }
+}
+
+/* Log scale buckets, four per power of two,
+ * so any reported value is within 25% of the real one. */
+static unsigned perf_hist_bucket(retro_perf_tick_t val)
+{
+   unsigned octave = 0;
+
+   if (val < 4)
+      return val;
+
+#ifdef __GNUC__
+   octave = 63 - __builtin_clzll(val);
+#else
+   while (val >> (octave + 1))
+      octave++;
+#endif
+
+   return (octave - 1) * 4 + ((val >> (octave - 2)) & 3);
+}
+
+static retro_perf_tick_t perf_hist_bucket_max(unsigned bucket)
+{
+   unsigned octave;
+
+   if (bucket < 4)
+      return bucket;
+
+   octave = bucket / 4 + 1;
+   return ((retro_perf_tick_t)(5 + (bucket & 3)) << (octave - 2)) - 1;
+}
+
+static retro_perf_tick_t perf_hist_percentile(const struct perf_stats *stats,
+      unsigned percent)
+{
+   unsigned i;
+   uint64_t total = 0, target, sum = 0;
+
+   for (i = 0; i < PERF_HIST_BUCKETS; i++)
+      total += stats->hist[i];
+
+   target = (total * percent + 99) / 100;
+
+   for (i = 0; i < PERF_HIST_BUCKETS; i++)
+   {
+      sum += stats->hist[i];
+      if (sum && sum >= target)
+      {
+         retro_perf_tick_t val = perf_hist_bucket_max(i);
+         return val < stats->max ? val : stats->max;
+      }
+   }
+
+   return stats->max;
+}
+
+void rarch_perf_record(const struct retro_perf_counter *perf,
+      retro_perf_tick_t delta)
+{
+   struct perf_stats *stats;
+   int slot = perf_hash_find(perf);
+
+   if (slot < 0)
+      return;
+
+   stats = perf_stats[slot];
+   stats->hist[perf_hist_bucket(delta)]++;
+   if (delta > stats->max)
+      stats->max = delta;
+
+   if (perf_trace)
+   {
+      struct perf_trace_event *event =
+         &perf_trace[perf_trace_ptr++ & (PERF_TRACE_EVENTS - 1)];
+      event->start    = perf->start;
+      event->duration = delta;
+      event->slot     = slot;
+   }
+}
+
+bool rarch_perf_trace_dump(const char *path)
+{
+   uint64_t i, count;
+   double usec_per_tick = 1.0;
+   retro_perf_tick_t ticks;
+   FILE *file;
+
+   if (!perf_trace)
+   {
+      RARCH_WARN("[PERF]: Tracing is not enabled, set perfcnt_trace_path.\n");
+      return false;
+   }
+
+   file = fopen(path, "w");
+   if (!file)
+   {
+      RARCH_ERR("[PERF]: Failed to open %s.\n", path);
+      return false;
+   }
+
+   /* Ticks are not necessarily nanoseconds (e.g. RDTSC),
+    * so calibrate against the wall clock since tracing began. */
+   ticks = rarch_get_perf_counter() - perf_trace_start_tick;
+   if (ticks)
+      usec_per_tick = (double)(rarch_get_time_usec() -
+            perf_trace_start_usec) / ticks;
+
+   count = perf_trace_ptr < PERF_TRACE_EVENTS ?
+      perf_trace_ptr : PERF_TRACE_EVENTS;
+
+   fputs("{\"traceEvents\":[\n", file);
+   for (i = perf_trace_ptr - count; i < perf_trace_ptr; i++)
+   {
+      const struct perf_trace_event *event =
+         &perf_trace[i & (PERF_TRACE_EVENTS - 1)];
+      const struct perf_stats *stats = perf_stats[event->slot];
+
+      fprintf(file, "%s{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"X\","
+            "\"pid\":1,\"tid\":1,\"ts\":%.3f,\"dur\":%.3f}\n",
+            i == perf_trace_ptr - count ? "" : ",",
+            stats->ident, stats->libretro ? "libretro" : "retroarch",
+            (double)(int64_t)(event->start - perf_trace_start_tick) *
+            usec_per_tick,
+            event->duration * usec_per_tick);
+   }
+   fputs("],\"displayTimeUnit\":\"ms\"}\n", file);
+
+   if (fclose(file) != 0)
+   {
+      RARCH_ERR("[PERF]: Failed to write %s.\n", path);
+      return false;
+   }
+
+   RARCH_LOG("[PERF]: Wrote %u trace events to %s.\n",
+         (unsigned)count, path);
+   return true;
+}
+
+static void write_counters_json(FILE *file,
+      const struct retro_perf_counter **counters, unsigned num,
+      const char *category, double usec_per_tick, bool *first)
+{
+   unsigned i;
+   for (i = 0; i < num; i++)
+   {
+      int slot;
+      const struct perf_stats *stats = NULL;
+
+      if (!counters[i]->call_cnt)
+         continue;
+
+      slot = perf_hash_find(counters[i]);
+      if (slot < 0)
+         continue;
+      stats = perf_stats[slot];
+
+      fprintf(file, "%s    {\"name\": \"%s\", \"category\": \"%s\", "
+            "\"calls\": %llu, \"total_usec\": %.3f, \"avg_usec\": %.3f, "
+            "\"p50_usec\": %.3f, \"p95_usec\": %.3f, \"p99_usec\": %.3f, "
+            "\"max_usec\": %.3f}",
+            *first ? "" : ",\n", stats->ident, category,
+            (unsigned long long)counters[i]->call_cnt,
+            counters[i]->total * usec_per_tick,
+            counters[i]->total * usec_per_tick / counters[i]->call_cnt,
+            perf_hist_percentile(stats, 50) * usec_per_tick,
+            perf_hist_percentile(stats, 95) * usec_per_tick,
+            perf_hist_percentile(stats, 99) * usec_per_tick,
+            stats->max * usec_per_tick);
+      *first = false;
+   }
+}
+
+void rarch_perf_write_json(FILE *file, double usec_per_tick)
+{
+   bool first = true;
+
+   fputs("[\n", file);
+   write_counters_json(file, perf_counters_rarch, perf_ptr_rarch,
+         "retroarch", usec_per_tick, &first);
+   write_counters_json(file, perf_counters_libretro, perf_ptr_libretro,
+         "libretro", usec_per_tick, &first);
+   fputs("\n  ]", file);
 }
 
 static void log_counters(
@@ -114,13 +452,26 @@ static void log_counters(
    unsigned i;
    for (i = 0; i < num; i++)
    {
-      if (counters[i]->call_cnt)
+      int slot;
+
+      if (!counters[i]->call_cnt)
+         continue;
+
+      RARCH_LOG(PERF_LOG_FMT,
+            counters[i]->ident,
+            (unsigned long long)counters[i]->total / 
+            (unsigned long long)counters[i]->call_cnt,
+            (unsigned long long)counters[i]->call_cnt);
+
+      slot = perf_hash_find(counters[i]);
+      if (slot >= 0)
       {
-         RARCH_LOG(PERF_LOG_FMT,
-               counters[i]->ident,
-               (unsigned long long)counters[i]->total / 
-               (unsigned long long)counters[i]->call_cnt,
-               (unsigned long long)counters[i]->call_cnt);
+         const struct perf_stats *stats = perf_stats[slot];
+         RARCH_LOG(PERF_HIST_LOG_FMT,
+               (unsigned long long)perf_hist_percentile(stats, 50),
+               (unsigned long long)perf_hist_percentile(stats, 95),
+               (unsigned long long)perf_hist_percentile(stats, 99),
+               (unsigned long long)stats->max);
       }
    }
 }
@@ -413,7 +764,8 @@ uint64_t rarch_get_cpu_features(void)
    if (max_flag >= 7)
    {
       x86_cpuid(7, flags);
-      if (flags[1] & (1 << 5))
+      /* AVX2 needs the OS support checked for AVX above. */
+      if ((flags[1] & (1 << 5)) && (cpu & RETRO_SIMD_AVX))
          cpu |= RETRO_SIMD_AVX2;
    }
 
@@ -19,8 +19,10 @@
 
 #ifdef _WIN32
 #define PERF_LOG_FMT "[PERF]: Avg (%s): %I64u ticks, %I64u runs.\n"
+#define PERF_HIST_LOG_FMT "[PERF]:     p50: %I64u, p95: %I64u, p99: %I64u, max: %I64u ticks.\n"
 #else
 #define PERF_LOG_FMT "[PERF]: Avg (%s): %llu ticks, %llu runs.\n"
+#define PERF_HIST_LOG_FMT "[PERF]:     p50: %llu, p95: %llu, p99: %llu, max: %llu ticks.\n"
 #endif
 
 #ifdef __cplusplus
@@ -51,6 +53,18 @@ void rarch_perf_log(void);
 
 void retro_perf_log(void);
 
+/* Adds a sample to the histogram of a registered counter,
+ * and to the event trace if tracing is enabled. */
+void rarch_perf_record(const struct retro_perf_counter *perf,
+      retro_perf_tick_t delta);
+
+/* Writes all counters with their percentiles as a JSON array. */
+void rarch_perf_write_json(FILE *file, double usec_per_tick);
+
+/* Writes the traced events as Chrome trace JSON
+ * (chrome://tracing, Perfetto). */
+bool rarch_perf_trace_dump(const char *path);
+
 static inline void rarch_perf_start(struct retro_perf_counter *perf)
 {
    if (g_extern.perfcnt_enable)
@@ -63,7 +77,11 @@ static inline void rarch_perf_start(struct retro_perf_counter *perf)
 static inline void rarch_perf_stop(struct retro_perf_counter *perf)
 {
    if (g_extern.perfcnt_enable)
-      perf->total += rarch_get_perf_counter() - perf->start;
+   {
+      retro_perf_tick_t delta = rarch_get_perf_counter() - perf->start;
+      perf->total += delta;
+      rarch_perf_record(perf, delta);
+   }
 }
 
 uint64_t rarch_get_cpu_features(void);
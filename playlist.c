@@ -2,7 +2,7 @@
  *  Copyright (C) 2010-2014 - Hans-Kristian Arntzen
  *  Copyright (C) 2011-2014 - Daniel De Matteis
  *  Copyright (C) 2013-2014 - Jason Fetters
- * 
+ *
  *  RetroArch is free software: you can redistribute it and/or modify it under the terms
  *  of the GNU General Public License as published by the Free Software Found-
  *  ation, either version 3 of the License, or (at your option) any later version.
@@ -21,162 +21,747 @@
 #include "boolean.h"
 #include "general.h"
 #include "file.h"
+#include "file_path.h"
+#include "endianness.h"
+#include "hash.h"
 
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <ctype.h>
+
+/* On-disk format, all integers little endian:
+ *
+ * header:  "RPLAYLST", version, entry count, string table size, reserved
+ * entries: path, core path and core name offsets into the string table,
+ *          content CRC32 and path hash, most recently used first
+ * sorted:  entry indices sorted by content file name
+ * strings: NUL terminated, deduplicated
+ * journal: records appended by every change since the snapshot
+ *
+ * Strings are used in place from the loaded file, so opening a large
+ * playlist is one read plus building the hash indexes from stored hashes.
+ *
+ * Files without the magic are read as the old text format, three lines
+ * per entry. They are converted on the first change. */
+
+#define PLAYLIST_MAGIC "RPLAYLST"
+#define PLAYLIST_VERSION 1
+#define PLAYLIST_HEADER_SIZE 24
+#define PLAYLIST_ENTRY_SIZE 20
+#define PLAYLIST_NO_STRING 0xffffffffu
+#define PLAYLIST_NONE 0xffffffffu
+
+#define PLAYLIST_JOURNAL_PUSH  1
+#define PLAYLIST_JOURNAL_CLEAR 2
+#define PLAYLIST_JOURNAL_HEADER_SIZE 12
+
+#define PLAYLIST_BLOCK_SIZE 4096
 
 struct content_playlist_entry
 {
-   char *path;
-   char *core_path;
-   char *core_name;
+   const char *path;
+   const char *core_path;
+   const char *core_name;
+   uint32_t crc32;
+   uint32_t path_hash;
+
+   /* MRU list links. */
+   uint32_t prev;
+   uint32_t next;
+   /* Position in the MRU order, valid with order_valid. */
+   uint32_t pos;
+};
+
+/* Backing store for strings pushed at runtime. Strings of evicted
+ * entries are only reclaimed when the playlist is reopened. */
+struct content_playlist_block
+{
+   struct content_playlist_block *next;
+   size_t used;
+   size_t size;
+   char data[1];
 };
 
 struct content_playlist
 {
+   /* Slots 0 to size - 1 are in use. */
    struct content_playlist_entry *entries;
    size_t size;
    size_t cap;
 
+   /* Most and least recently used slots. */
+   uint32_t head;
+   uint32_t tail;
+
+   /* Slot of each entry, most recently used first. Rebuilt lazily,
+    * so pushes don't pay for shifting every entry. */
+   uint32_t *order;
+   bool order_valid;
+
+   /* Slots by path, see hash_bucket(). */
+   uint32_t *path_index;
+   size_t index_mask;
+
+   /* Slots sorted by file name, rebuilt lazily. */
+   uint32_t *sorted;
+   bool sorted_valid;
+
+   uint8_t *file_data;
+   struct content_playlist_block *blocks;
+
+   /* conf_path holds a snapshot in the binary format. */
+   bool binary;
+   size_t snapshot_size;
+   size_t journal_size;
+
    char *conf_path;
 };
 
+static void content_playlist_index_add(content_playlist_t *playlist,
+      uint32_t slot)
+{
+   uint32_t *index = playlist->path_index;
+   size_t i = hash_bucket(playlist->entries[slot].path_hash,
+         playlist->index_mask);
+
+   while (index[i])
+      i = (i + 1) & playlist->index_mask;
+   index[i] = slot + 1;
+}
+
+static void content_playlist_index_remove(content_playlist_t *playlist,
+      uint32_t slot)
+{
+   uint32_t *index = playlist->path_index;
+   size_t i = hash_bucket(playlist->entries[slot].path_hash,
+         playlist->index_mask);
+   size_t j;
+
+   while (index[i] && index[i] != slot + 1)
+      i = (i + 1) & playlist->index_mask;
+   if (!index[i])
+      return;
+
+   /* Backward shift deletion, keeps probe sequences intact
+    * without tombstones. */
+   for (j = (i + 1) & playlist->index_mask; index[j];
+         j = (j + 1) & playlist->index_mask)
+   {
+      size_t home = hash_bucket(playlist->entries[index[j] - 1].path_hash,
+            playlist->index_mask);
+
+      if (((j - home) & playlist->index_mask) >=
+            ((j - i) & playlist->index_mask))
+      {
+         index[i] = index[j];
+         i = j;
+      }
+   }
+
+   index[i] = 0;
+}
+
+static bool content_playlist_string_equal(const char *a, const char *b)
+{
+   if (!a || !b)
+      return a == b;
+   return !strcmp(a, b);
+}
+
+/* With a NULL core_path, returns the most recent entry for path. */
+static const struct content_playlist_entry *content_playlist_lookup(
+      const content_playlist_t *playlist,
+      const char *path, const char *core_path)
+{
+   const struct content_playlist_entry *best = NULL;
+   uint32_t hash = djb2_calculate(path);
+   size_t i      = hash_bucket(hash, playlist->index_mask);
+
+   for (; playlist->path_index[i]; i = (i + 1) & playlist->index_mask)
+   {
+      const struct content_playlist_entry *entry =
+         &playlist->entries[playlist->path_index[i] - 1];
+
+      if (entry->path_hash != hash
+            || !content_playlist_string_equal(entry->path, path))
+         continue;
+
+      /* Core name can have changed while still being the same core.
+       * Differentiate based on the core path only. */
+      if (core_path)
+      {
+         if (!strcmp(entry->core_path, core_path))
+            return entry;
+      }
+      else if (!best || entry->pos < best->pos)
+         best = entry;
+   }
+
+   return best;
+}
+
+static const char *content_playlist_strdup(content_playlist_t *playlist,
+      const char *str)
+{
+   char *ret;
+   size_t len = strlen(str) + 1;
+   struct content_playlist_block *block = playlist->blocks;
+
+   if (!block || block->size - block->used < len)
+   {
+      size_t size = len > PLAYLIST_BLOCK_SIZE ? len : PLAYLIST_BLOCK_SIZE;
+
+      block = (struct content_playlist_block*)malloc(sizeof(*block) + size);
+      if (!block)
+         return NULL;
+
+      block->next = playlist->blocks;
+      block->used = 0;
+      block->size = size;
+      playlist->blocks = block;
+   }
+
+   ret = block->data + block->used;
+   memcpy(ret, str, len);
+   block->used += len;
+   return ret;
+}
+
+static void content_playlist_unlink(content_playlist_t *playlist,
+      uint32_t slot)
+{
+   const struct content_playlist_entry *entry = &playlist->entries[slot];
+
+   if (entry->prev != PLAYLIST_NONE)
+      playlist->entries[entry->prev].next = entry->next;
+   else
+      playlist->head = entry->next;
+
+   if (entry->next != PLAYLIST_NONE)
+      playlist->entries[entry->next].prev = entry->prev;
+   else
+      playlist->tail = entry->prev;
+
+   playlist->order_valid = false;
+}
+
+static void content_playlist_link_front(content_playlist_t *playlist,
+      uint32_t slot)
+{
+   struct content_playlist_entry *entry = &playlist->entries[slot];
+
+   entry->prev = PLAYLIST_NONE;
+   entry->next = playlist->head;
+
+   if (playlist->head != PLAYLIST_NONE)
+      playlist->entries[playlist->head].prev = slot;
+   else
+      playlist->tail = slot;
+
+   playlist->head        = slot;
+   playlist->order_valid = false;
+}
+
+static void content_playlist_link_back(content_playlist_t *playlist,
+      uint32_t slot)
+{
+   struct content_playlist_entry *entry = &playlist->entries[slot];
+
+   entry->prev = playlist->tail;
+   entry->next = PLAYLIST_NONE;
+
+   if (playlist->tail != PLAYLIST_NONE)
+      playlist->entries[playlist->tail].next = slot;
+   else
+      playlist->head = slot;
+
+   playlist->tail        = slot;
+   playlist->order_valid = false;
+}
+
+static void content_playlist_update_order(content_playlist_t *playlist)
+{
+   uint32_t slot, pos = 0;
+
+   if (playlist->order_valid)
+      return;
+
+   for (slot = playlist->head; slot != PLAYLIST_NONE;
+         slot = playlist->entries[slot].next)
+   {
+      playlist->order[pos] = slot;
+      playlist->entries[slot].pos = pos++;
+   }
+
+   playlist->order_valid = true;
+}
+
+/* Strings must stay valid for the lifetime of the playlist. */
+static bool content_playlist_add(content_playlist_t *playlist,
+      const char *path, const char *core_path,
+      const char *core_name, uint32_t crc32)
+{
+   uint32_t slot;
+   struct content_playlist_entry *entry = (struct content_playlist_entry*)
+      content_playlist_lookup(playlist, path, core_path);
+
+   if (entry)
+   {
+      uint32_t slot = entry - playlist->entries;
+      bool changed  = playlist->head != slot;
+
+      if (crc32 && entry->crc32 != crc32)
+      {
+         entry->crc32 = crc32;
+         changed      = true;
+      }
+
+      /* Seen it before, bump to top. */
+      if (playlist->head != slot)
+      {
+         content_playlist_unlink(playlist, slot);
+         content_playlist_link_front(playlist, slot);
+         playlist->sorted_valid = false;
+      }
+      return changed;
+   }
+
+   if (playlist->size == playlist->cap)
+   {
+      slot  = playlist->tail;
+      entry = &playlist->entries[slot];
+
+      content_playlist_index_remove(playlist, slot);
+      content_playlist_unlink(playlist, slot);
+   }
+   else
+      slot = playlist->size++;
+
+   entry            = &playlist->entries[slot];
+   entry->path      = path;
+   entry->core_path = core_path;
+   entry->core_name = core_name;
+   entry->crc32     = crc32;
+   entry->path_hash = djb2_calculate(path);
+
+   content_playlist_index_add(playlist, slot);
+
+   content_playlist_link_front(playlist, slot);
+   playlist->sorted_valid = false;
+   return true;
+}
+
+static void content_playlist_reset(content_playlist_t *playlist)
+{
+   size_t index_size = playlist->index_mask + 1;
+
+   memset(playlist->path_index, 0, index_size * sizeof(uint32_t));
+   playlist->size         = 0;
+   playlist->head         = PLAYLIST_NONE;
+   playlist->tail         = PLAYLIST_NONE;
+   playlist->order_valid  = false;
+   playlist->sorted_valid = false;
+}
+
 void content_playlist_get_index(content_playlist_t *playlist,
       size_t index,
       const char **path, const char **core_path,
       const char **core_name)
 {
+   const struct content_playlist_entry *entry;
+
    if (!playlist)
       return;
 
+   content_playlist_update_order(playlist);
+   entry = &playlist->entries[playlist->order[index]];
+
    if (path)
-      *path      = playlist->entries[index].path;
+      *path      = entry->path;
    if (core_path)
-      *core_path = playlist->entries[index].core_path;
+      *core_path = entry->core_path;
    if (core_name)
-      *core_name = playlist->entries[index].core_name;
+      *core_name = entry->core_name;
 }
 
-static void content_playlist_free_entry(
-      struct content_playlist_entry *entry)
+static void write_le32(uint8_t *out, uint32_t val)
 {
-   if (!entry)
-      return;
+   val = swap_if_big32(val);
+   memcpy(out, &val, sizeof(val));
+}
 
-   if (entry->path)
-      free(entry->path);
-   entry->path = NULL;
-   if (entry->core_path)
-      free(entry->core_path);
-   entry->core_path = NULL;
-   if (entry->core_name)
-      free(entry->core_name);
-   entry->core_name = NULL;
-
-   memset(entry, 0, sizeof(*entry));
+static uint32_t read_le32(const uint8_t *in)
+{
+   uint32_t val;
+   memcpy(&val, in, sizeof(val));
+   return swap_if_big32(val);
 }
 
-void content_playlist_push(content_playlist_t *playlist,
-      const char *path, const char *core_path,
-      const char *core_name)
+static const char *content_playlist_basename(
+      const struct content_playlist_entry *entry)
+{
+   return entry->path ? path_basename(entry->path) : "";
+}
+
+static int content_playlist_strcasecmp(const char *a, const char *b)
+{
+   for (; *a && tolower((uint8_t)*a) == tolower((uint8_t)*b); a++, b++);
+   return tolower((uint8_t)*a) - tolower((uint8_t)*b);
+}
+
+static int content_playlist_sort_cmp(const void *a_, const void *b_)
+{
+   const struct content_playlist_entry *a =
+      *(const struct content_playlist_entry**)a_;
+   const struct content_playlist_entry *b =
+      *(const struct content_playlist_entry**)b_;
+   int ret = content_playlist_strcasecmp(content_playlist_basename(a),
+         content_playlist_basename(b));
+
+   if (ret)
+      return ret;
+   return a->pos < b->pos ? -1 : a->pos > b->pos;
+}
+
+static bool content_playlist_sort(content_playlist_t *playlist)
 {
    size_t i;
+   const struct content_playlist_entry **tmp;
 
-   if (!playlist)
-      return;
+   if (playlist->sorted_valid)
+      return true;
+
+   /* Ties are broken by MRU position. */
+   content_playlist_update_order(playlist);
+
+   tmp = (const struct content_playlist_entry**)
+      malloc(playlist->size * sizeof(*tmp) + 1);
+   if (!tmp)
+      return false;
 
    for (i = 0; i < playlist->size; i++)
+      tmp[i] = &playlist->entries[i];
+
+   qsort(tmp, playlist->size, sizeof(*tmp), content_playlist_sort_cmp);
+
+   for (i = 0; i < playlist->size; i++)
+      playlist->sorted[i] = tmp[i] - playlist->entries;
+
+   free(tmp);
+   playlist->sorted_valid = true;
+   return true;
+}
+
+struct content_playlist_string_table
+{
+   uint8_t *data;
+   size_t size;
+   size_t cap;
+
+   /* Offset + 1 of each stored string, see hash_bucket(). */
+   uint32_t *index;
+   size_t mask;
+};
+
+static uint32_t content_playlist_intern(
+      struct content_playlist_string_table *table, const char *str)
+{
+   size_t len, i;
+
+   if (!str)
+      return PLAYLIST_NO_STRING;
+
+   i = hash_bucket(djb2_calculate(str), table->mask);
+   for (; table->index[i]; i = (i + 1) & table->mask)
    {
-      bool equal_path = (!path && !playlist->entries[i].path) ||
-         (path && playlist->entries[i].path &&
-          !strcmp(path,playlist->entries[i].path));
+      uint32_t offset = table->index[i] - 1;
+      if (!strcmp((const char*)table->data + offset, str))
+         return offset;
+   }
 
-      /* Core name can have changed while still being the same core.
-       * Differentiate based on the core path only. */
-      if (equal_path && !strcmp(playlist->entries[i].core_path, core_path))
-      {
-         if (i == 0)
-            return;
+   len = strlen(str) + 1;
+   if (table->size + len > table->cap)
+   {
+      size_t cap    = table->cap * 2 + len;
+      uint8_t *data = (uint8_t*)realloc(table->data, cap);
+      if (!data)
+         return PLAYLIST_NO_STRING;
 
-         /* Seen it before, bump to top. */
-         struct content_playlist_entry tmp = playlist->entries[i];
-         memmove(playlist->entries + 1, playlist->entries,
-               i * sizeof(struct content_playlist_entry));
-         playlist->entries[0] = tmp;
-         return;
-      }
+      table->data = data;
+      table->cap  = cap;
    }
 
-   if (playlist->size == playlist->cap)
+   memcpy(table->data + table->size, str, len);
+   table->index[i] = table->size + 1;
+   table->size    += len;
+   return table->index[i] - 1;
+}
+
+/* Writes a fresh snapshot to a temporary file and renames it over
+ * conf_path, so a crash never leaves a truncated playlist behind. */
+static bool content_playlist_write_file(content_playlist_t *playlist)
+{
+   size_t i, tables_size, total;
+   char tmp_path[PATH_MAX];
+   uint8_t *buf = NULL, *ptr;
+   bool ret     = false;
+   struct content_playlist_string_table table = {0};
+
+   if (!playlist || !playlist->conf_path)
+      return false;
+
+   if (!content_playlist_sort(playlist))
+      return false;
+
+   for (table.mask = 1; table.mask < playlist->size * 6 + 16;
+         table.mask <<= 1);
+   table.mask--;
+   if (!(table.index = (uint32_t*)calloc(table.mask + 1, sizeof(uint32_t))))
+      return false;
+
+   tables_size = playlist->size * (PLAYLIST_ENTRY_SIZE + sizeof(uint32_t));
+   if (!(buf = (uint8_t*)malloc(PLAYLIST_HEADER_SIZE + tables_size)))
+      goto end;
+
+   ptr = buf + PLAYLIST_HEADER_SIZE;
+   for (i = 0; i < playlist->size; i++, ptr += PLAYLIST_ENTRY_SIZE)
+   {
+      const struct content_playlist_entry *entry =
+         &playlist->entries[playlist->order[i]];
+      uint32_t path      = content_playlist_intern(&table, entry->path);
+      uint32_t core_path = content_playlist_intern(&table, entry->core_path);
+      uint32_t core_name = content_playlist_intern(&table, entry->core_name);
+
+      if ((entry->path && path == PLAYLIST_NO_STRING)
+            || core_path == PLAYLIST_NO_STRING
+            || core_name == PLAYLIST_NO_STRING)
+         goto end;
+
+      write_le32(ptr +  0, path);
+      write_le32(ptr +  4, core_path);
+      write_le32(ptr +  8, core_name);
+      write_le32(ptr + 12, entry->crc32);
+      write_le32(ptr + 16, entry->path_hash);
+   }
+
+   /* Stored by MRU position, which is what the slots are on load. */
+   for (i = 0; i < playlist->size; i++, ptr += sizeof(uint32_t))
+      write_le32(ptr, playlist->entries[playlist->sorted[i]].pos);
+
+   memcpy(buf, PLAYLIST_MAGIC, 8);
+   write_le32(buf +  8, PLAYLIST_VERSION);
+   write_le32(buf + 12, playlist->size);
+   write_le32(buf + 16, table.size);
+   write_le32(buf + 20, 0);
+
+   total = PLAYLIST_HEADER_SIZE + tables_size + table.size;
+   snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", playlist->conf_path);
+
    {
-      content_playlist_free_entry(&playlist->entries[playlist->cap - 1]);
-      playlist->size--;
+      FILE *file = fopen(tmp_path, "wb");
+      if (!file)
+         goto end;
+
+      ret = fwrite(buf, 1, PLAYLIST_HEADER_SIZE + tables_size, file)
+         == PLAYLIST_HEADER_SIZE + tables_size;
+      if (table.size)
+         ret = ret && fwrite(table.data, 1, table.size, file) == table.size;
+      ret = fclose(file) == 0 && ret;
    }
 
-   memmove(playlist->entries + 1, playlist->entries,
-         (playlist->cap - 1) * sizeof(struct content_playlist_entry));
+#ifdef _WIN32
+   if (ret)
+      remove(playlist->conf_path);
+#endif
+   ret = ret && rename(tmp_path, playlist->conf_path) == 0;
 
-   playlist->entries[0].path      = path ? strdup(path) : NULL;
-   playlist->entries[0].core_path = strdup(core_path);
-   playlist->entries[0].core_name = strdup(core_name);
-   playlist->size++;
+   if (ret)
+   {
+      playlist->binary        = true;
+      playlist->snapshot_size = total;
+      playlist->journal_size  = 0;
+   }
+   else
+      remove(tmp_path);
+
+end:
+   if (!ret)
+      RARCH_ERR("Couldn't write to content playlist file: %s.\n",
+            playlist->conf_path);
+   free(table.index);
+   free(table.data);
+   free(buf);
+   return ret;
 }
 
-static void content_playlist_write_file(content_playlist_t *playlist)
+/* Appends one change to the file. Compacts once the journal
+ * outgrows the snapshot, which keeps writes amortized O(1). */
+static void content_playlist_journal(content_playlist_t *playlist,
+      unsigned type, const struct content_playlist_entry *entry)
 {
-   size_t i;
-   FILE *file = NULL;
+   uint8_t buf[PLAYLIST_JOURNAL_HEADER_SIZE + 4 + 3 * PATH_MAX];
+   size_t size = 0;
+   FILE *file;
 
-   if (!playlist)
+   if (!playlist->conf_path)
+      return;
+
+   if (!playlist->binary
+         || playlist->journal_size >= playlist->snapshot_size)
+   {
+      content_playlist_write_file(playlist);
       return;
+   }
+
+   if (entry)
+   {
+      const char *strs[3];
+      unsigned i;
+
+      strs[0] = entry->path ? entry->path : "";
+      strs[1] = entry->core_path;
+      strs[2] = entry->core_name;
+
+      write_le32(buf + PLAYLIST_JOURNAL_HEADER_SIZE, entry->crc32);
+      size = 4;
+
+      for (i = 0; i < 3; i++)
+      {
+         size_t len = strlen(strs[i]) + 1;
+         if (len > PATH_MAX)
+         {
+            content_playlist_write_file(playlist);
+            return;
+         }
+         memcpy(buf + PLAYLIST_JOURNAL_HEADER_SIZE + size, strs[i], len);
+         size += len;
+      }
+   }
 
-   file = fopen(playlist->conf_path, "w");
+   write_le32(buf + 0, type);
+   write_le32(buf + 4, size);
+   write_le32(buf + 8, crc32_calculate(
+            buf + PLAYLIST_JOURNAL_HEADER_SIZE, size));
+   size += PLAYLIST_JOURNAL_HEADER_SIZE;
 
-   if (!file)
+   if (!(file = fopen(playlist->conf_path, "ab")))
    {
       RARCH_ERR("Couldn't write to content playlist file: %s.\n",
             playlist->conf_path);
       return;
    }
 
-   for (i = 0; i < playlist->size; i++)
+   if (fwrite(buf, 1, size, file) == size)
+      playlist->journal_size += size;
+   fclose(file);
+}
+
+void content_playlist_push(content_playlist_t *playlist,
+      const char *path, const char *core_path,
+      const char *core_name, uint32_t crc32)
+{
+   const struct content_playlist_entry *entry;
+
+   if (!playlist)
+      return;
+
+   entry = content_playlist_lookup(playlist, path, core_path);
+
+   if (entry)
    {
-      fprintf(file, "%s\n%s\n%s\n",
-            playlist->entries[i].path ? playlist->entries[i].path : "",
-            playlist->entries[i].core_path,
-            playlist->entries[i].core_name);
+      if (!content_playlist_add(playlist, entry->path,
+               entry->core_path, entry->core_name, crc32))
+         return;
    }
+   else
+   {
+      const char *path_copy = path ? content_playlist_strdup(playlist, path) : NULL;
+      const char *core_path_copy = content_playlist_strdup(playlist, core_path);
+      const char *core_name_copy = content_playlist_strdup(playlist, core_name);
 
-   fclose(file);
+      if ((path && !path_copy) || !core_path_copy || !core_name_copy)
+         return;
+
+      content_playlist_add(playlist, path_copy,
+            core_path_copy, core_name_copy, crc32);
+   }
+
+   content_playlist_journal(playlist, PLAYLIST_JOURNAL_PUSH,
+         &playlist->entries[playlist->head]);
+}
+
+size_t content_playlist_find_prefix(content_playlist_t *playlist,
+      const char *prefix, size_t *indices, size_t max)
+{
+   size_t lo = 0, hi, count = 0, len;
+
+   if (!playlist || !prefix || !content_playlist_sort(playlist))
+      return 0;
+
+   len = strlen(prefix);
+   hi  = playlist->size;
+
+   /* Lower bound of the first name not sorting before prefix. */
+   while (lo < hi)
+   {
+      size_t mid = lo + (hi - lo) / 2;
+      const char *name = content_playlist_basename(
+            &playlist->entries[playlist->sorted[mid]]);
+
+      if (content_playlist_strcasecmp(name, prefix) < 0)
+         lo = mid + 1;
+      else
+         hi = mid;
+   }
+
+   for (; lo < playlist->size && count < max; lo++)
+   {
+      size_t i;
+      const struct content_playlist_entry *entry =
+         &playlist->entries[playlist->sorted[lo]];
+      const char *name = content_playlist_basename(entry);
+
+      for (i = 0; i < len && tolower((uint8_t)name[i])
+            == tolower((uint8_t)prefix[i]); i++);
+      if (i < len)
+         break;
+
+      indices[count++] = entry->pos;
+   }
+
+   return count;
 }
 
 void content_playlist_free(content_playlist_t *playlist)
 {
-   size_t i;
    if (!playlist)
       return;
 
-   if (playlist->conf_path)
-      content_playlist_write_file(playlist);
    free(playlist->conf_path);
 
-   for (i = 0; i < playlist->cap; i++)
-      content_playlist_free_entry(&playlist->entries[i]);
-   free(playlist->entries);
+   while (playlist->blocks)
+   {
+      struct content_playlist_block *next = playlist->blocks->next;
+      free(playlist->blocks);
+      playlist->blocks = next;
+   }
 
+   free(playlist->file_data);
+   free(playlist->entries);
+   free(playlist->order);
+   free(playlist->path_index);
+   free(playlist->sorted);
    free(playlist);
 }
 
 void content_playlist_clear(content_playlist_t *playlist)
 {
-   size_t i;
    if (!playlist)
       return;
 
-   for (i = 0; i < playlist->cap; i++)
-      content_playlist_free_entry(&playlist->entries[i]);
-   playlist->size = 0;
+   content_playlist_reset(playlist);
+   content_playlist_journal(playlist, PLAYLIST_JOURNAL_CLEAR, NULL);
 }
 
 size_t content_playlist_size(content_playlist_t *playlist)
@@ -186,72 +771,249 @@ size_t content_playlist_size(content_playlist_t *playlist)
    return 0;
 }
 
-static bool content_playlist_read_file(
-      content_playlist_t *playlist, const char *path)
+static char *content_playlist_next_line(char **ptr, char *end)
+{
+   char *line = *ptr, *eol;
+
+   if (line >= end)
+      return NULL;
+
+   eol = (char*)memchr(line, '\n', end - line);
+   if (!eol)
+      eol = end;
+
+   *ptr = eol + (eol < end);
+   *eol = '\0';
+   if (eol > line && eol[-1] == '\r')
+      eol[-1] = '\0';
+
+   return line;
+}
+
+static void content_playlist_read_text(content_playlist_t *playlist,
+      char *data, size_t size)
 {
-   char buf[3][PATH_MAX];
-   unsigned i;
-   struct content_playlist_entry *entry = NULL;
-   char *last = NULL;
-   FILE *file = fopen(path, "r");
+   char *ptr = data, *end = data + size;
+
+   /* Oldest last, so push in reverse. */
+   size_t i, num = 0;
+   char **lines = NULL;
 
-   if (!file || !playlist)
+   for (;;)
    {
-      RARCH_ERR("Couldn't read content playlist file: %s.\n", path);
+      char *path      = content_playlist_next_line(&ptr, end);
+      char *core_path = content_playlist_next_line(&ptr, end);
+      char *core_name = content_playlist_next_line(&ptr, end);
+
+      if (!core_name)
+         break;
+      if (!*core_path || !*core_name)
+         continue;
+
+      if (!(num % 96))
+      {
+         char **tmp = (char**)realloc(lines, (num + 96) * sizeof(*lines));
+         if (!tmp)
+            break;
+         lines = tmp;
+      }
+
+      lines[num++] = *path ? path : NULL;
+      lines[num++] = core_path;
+      lines[num++] = core_name;
+   }
+
+   for (i = num; i > 0; i -= 3)
+      content_playlist_add(playlist, lines[i - 3],
+            lines[i - 2], lines[i - 1], 0);
+
+   free(lines);
+}
+
+static bool content_playlist_read_binary(content_playlist_t *playlist,
+      uint8_t *data, size_t size)
+{
+   size_t i, num, strings_size, tables_size, offset;
+   const uint8_t *entries, *sorted;
+   const char *strings;
+
+   if (size < PLAYLIST_HEADER_SIZE
+         || read_le32(data + 8) != PLAYLIST_VERSION)
+      return false;
 
-      if (file)
-         fclose(file);
+   num          = read_le32(data + 12);
+   strings_size = read_le32(data + 16);
+   tables_size  = num * (PLAYLIST_ENTRY_SIZE + sizeof(uint32_t));
 
+   if (num > (size - PLAYLIST_HEADER_SIZE) / (PLAYLIST_ENTRY_SIZE + 4)
+         || strings_size > size - PLAYLIST_HEADER_SIZE - tables_size
+         || (strings_size && data[PLAYLIST_HEADER_SIZE
+            + tables_size + strings_size - 1]))
       return false;
+
+   entries = data + PLAYLIST_HEADER_SIZE;
+   sorted  = entries + num * PLAYLIST_ENTRY_SIZE;
+   strings = (const char*)sorted + num * sizeof(uint32_t);
+
+   for (i = 0; i < num && playlist->size < playlist->cap;
+         i++, entries += PLAYLIST_ENTRY_SIZE)
+   {
+      struct content_playlist_entry *entry;
+      uint32_t offsets[3];
+      unsigned j;
+
+      for (j = 0; j < 3; j++)
+      {
+         offsets[j] = read_le32(entries + 4 * j);
+         if (offsets[j] != PLAYLIST_NO_STRING && offsets[j] >= strings_size)
+            return false;
+      }
+
+      if (offsets[1] == PLAYLIST_NO_STRING || offsets[2] == PLAYLIST_NO_STRING)
+         return false;
+
+      entry            = &playlist->entries[playlist->size];
+      entry->path      = offsets[0] == PLAYLIST_NO_STRING ?
+         NULL : strings + offsets[0];
+      entry->core_path = strings + offsets[1];
+      entry->core_name = strings + offsets[2];
+      entry->crc32     = read_le32(entries + 12);
+      entry->path_hash = read_le32(entries + 16);
+
+      content_playlist_link_back(playlist, playlist->size);
+      content_playlist_index_add(playlist, playlist->size);
+      playlist->size++;
    }
 
-   for (playlist->size = 0; playlist->size < playlist->cap; )
+   /* The stored order is only usable if nothing was dropped. */
+   if (playlist->size == num)
    {
-      for (i = 0; i < 3; i++)
+      for (i = 0; i < num; i++)
+      {
+         playlist->sorted[i] = read_le32(sorted + 4 * i);
+         if (playlist->sorted[i] >= num)
+            break;
+      }
+      playlist->sorted_valid = i == num;
+   }
+
+   playlist->binary        = true;
+   playlist->snapshot_size = PLAYLIST_HEADER_SIZE + tables_size + strings_size;
+
+   /* Replay the journal. Stop at the first damaged record,
+    * i.e. a write that was cut short. */
+   for (offset = playlist->snapshot_size;
+         size - offset >= PLAYLIST_JOURNAL_HEADER_SIZE; )
+   {
+      uint32_t type         = read_le32(data + offset);
+      uint32_t payload_size = read_le32(data + offset + 4);
+      uint8_t *payload      = data + offset + PLAYLIST_JOURNAL_HEADER_SIZE;
+
+      if (payload_size > size - offset - PLAYLIST_JOURNAL_HEADER_SIZE
+            || crc32_calculate(payload, payload_size)
+            != read_le32(data + offset + 8))
+         break;
+
+      if (type == PLAYLIST_JOURNAL_CLEAR)
+         content_playlist_reset(playlist);
+      else if (type == PLAYLIST_JOURNAL_PUSH)
       {
-         *buf[i] = '\0';
-         if (!fgets(buf[i], sizeof(buf[i]), file))
-            goto end;
+         const char *strs[3];
+         size_t pos = 4;
+
+         for (i = 0; i < 3 && pos < payload_size; i++)
+         {
+            const uint8_t *nul = (const uint8_t*)memchr(payload + pos, '\0',
+                  payload_size - pos);
+            if (!nul)
+               break;
+            strs[i] = (const char*)payload + pos;
+            pos     = nul - payload + 1;
+         }
 
-         last = strrchr(buf[i], '\n');
-         if (last)
-            *last = '\0';
+         if (payload_size < 4 || i < 3 || !*strs[1] || !*strs[2])
+            break;
+
+         content_playlist_add(playlist, *strs[0] ? strs[0] : NULL,
+               strs[1], strs[2], read_le32(payload));
       }
+      else
+         break;
 
-      entry = &playlist->entries[playlist->size];
+      offset += PLAYLIST_JOURNAL_HEADER_SIZE + payload_size;
+   }
 
-      if (!*buf[1] || !*buf[2])
-         continue;
+   playlist->journal_size = offset - playlist->snapshot_size;
 
-      if (*buf[0])
-         entry->path = strdup(buf[0]);
-      entry->core_path = strdup(buf[1]);
-      entry->core_name = strdup(buf[2]);
-      playlist->size++;
+   /* Don't append after garbage. */
+   if (offset != size)
+      playlist->binary = false;
+
+   return true;
+}
+
+static bool content_playlist_read_file(
+      content_playlist_t *playlist, const char *path)
+{
+   void *buf  = NULL;
+   long size = read_file(path, &buf);
+
+   if (size < 0)
+   {
+      RARCH_ERR("Couldn't read content playlist file: %s.\n", path);
+      return false;
    }
 
-end:
-   fclose(file);
+   /* read_file() NUL terminates, which the text parser relies on. */
+   playlist->file_data = (uint8_t*)buf;
+
+   if (size >= 8 && !memcmp(buf, PLAYLIST_MAGIC, 8))
+   {
+      if (!content_playlist_read_binary(playlist, (uint8_t*)buf, size))
+      {
+         RARCH_WARN("Content playlist file is damaged: %s.\n", path);
+         content_playlist_reset(playlist);
+         playlist->binary = false;
+      }
+   }
+   else
+      content_playlist_read_text(playlist, (char*)buf, size);
+
    return true;
 }
 
 content_playlist_t *content_playlist_init(const char *path, size_t size)
 {
+   size_t index_size;
+   content_playlist_t *playlist;
+
    RARCH_LOG("Opening playlist: %s.\n", path);
-   content_playlist_t *playlist = (content_playlist_t*)
-      calloc(1, sizeof(*playlist));
+
+   if (!size)
+      return NULL;
+
+   playlist = (content_playlist_t*)calloc(1, sizeof(*playlist));
    if (!playlist)
    {
-       RARCH_ERR("Cannot initialize content playlist.\n");
+      RARCH_ERR("Cannot initialize content playlist.\n");
       return NULL;
    }
 
-   playlist->entries = (struct content_playlist_entry*)calloc(size,
+   for (index_size = 16; index_size < size * 2; index_size <<= 1);
+
+   playlist->cap        = size;
+   playlist->head       = PLAYLIST_NONE;
+   playlist->tail       = PLAYLIST_NONE;
+   playlist->index_mask = index_size - 1;
+   playlist->entries    = (struct content_playlist_entry*)calloc(size,
          sizeof(*playlist->entries));
-   if (!playlist->entries)
-      goto error;
+   playlist->order      = (uint32_t*)calloc(size, sizeof(uint32_t));
+   playlist->sorted     = (uint32_t*)calloc(size, sizeof(uint32_t));
+   playlist->path_index = (uint32_t*)calloc(index_size, sizeof(uint32_t));
 
-   playlist->cap = size;
+   if (!playlist->entries || !playlist->order || !playlist->sorted
+         || !playlist->path_index)
+      goto error;
 
    if (!content_playlist_read_file(playlist, path))
       goto error;
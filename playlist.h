@@ -17,6 +17,8 @@
 #define CONTENT_HISTORY_H__
 
 #include <stddef.h>
+#include <stdint.h>
+#include "boolean.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -37,9 +39,16 @@ void content_playlist_get_index(content_playlist_t *playlist,
       const char **path, const char **core_path,
       const char **core_name);
 
+/* crc32 is the CRC of the content, 0 if unknown.
+ * Pushing a known path/core pair moves it to the top. */
 void content_playlist_push(content_playlist_t *playlist,
       const char *path, const char *core_path,
-      const char *core_name);
+      const char *core_name, uint32_t crc32);
+
+/* Case-insensitive search on content file names. Writes up to max
+ * indices in name order and returns how many were written. */
+size_t content_playlist_find_prefix(content_playlist_t *playlist,
+      const char *prefix, size_t *indices, size_t max);
 
 #ifdef __cplusplus
 }
@@ -21,6 +21,9 @@
 #endif
 
 static const ffemu_backend_t *ffemu_backends[] = {
+#ifdef HAVE_RLV
+   &ffemu_rlv,
+#endif
 #ifdef HAVE_FFMPEG
    &ffemu_ffmpeg,
 #endif
@@ -57,3 +60,11 @@ bool ffemu_init_first(const ffemu_backend_t **backend, void **data,
    return false;
 }
 
+enum ffemu_backpressure ffemu_backpressure_from_string(const char *str)
+{
+   if (str && !strcmp(str, "drop"))
+      return FFEMU_BACKPRESSURE_DROP;
+   if (str && !strcmp(str, "dupe"))
+      return FFEMU_BACKPRESSURE_DUPE;
+   return FFEMU_BACKPRESSURE_BLOCK;
+}
@@ -31,6 +31,18 @@ enum ffemu_pix_format
    FFEMU_PIX_ARGB8888
 };
 
+/* What to do with a frame when the recording thread
+ * has fallen behind and there is no free frame buffer. */
+enum ffemu_backpressure
+{
+   /* Wait for the encoder. Every frame is recorded. */
+   FFEMU_BACKPRESSURE_BLOCK = 0,
+   /* Throw away the frame. */
+   FFEMU_BACKPRESSURE_DROP,
+   /* Record the previous frame again, keeping A/V sync. */
+   FFEMU_BACKPRESSURE_DUPE
+};
+
 /* Parameters passed to ffemu_new() */
 struct ffemu_params
 {
@@ -63,6 +75,9 @@ struct ffemu_params
 
    /* Path to config. Optional. */
    const char *config;
+
+   /* Policy when the encoder can't keep up. */
+   enum ffemu_backpressure backpressure;
 };
 
 struct ffemu_video_data
@@ -91,8 +106,10 @@ typedef struct ffemu_backend
 } ffemu_backend_t;
 
 extern const ffemu_backend_t ffemu_ffmpeg;
+extern const ffemu_backend_t ffemu_rlv;
 
 const ffemu_backend_t *ffemu_find_backend(const char *ident);
+enum ffemu_backpressure ffemu_backpressure_from_string(const char *str);
 bool ffemu_init_first(const ffemu_backend_t **backend, void **data,
       const struct ffemu_params *params);
 
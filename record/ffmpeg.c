@@ -46,10 +46,12 @@ extern "C" {
 #include "../fifo_buffer.h"
 #include "../thread.h"
 #include "../general.h"
+#include "../performance.h"
 #include "../gfx/scaler/scaler.h"
 #include "../conf/config_file.h"
 #include "../audio/utils.h"
 #include "ffemu.h"
+#include "frame_pool.h"
 #include <assert.h>
 
 #ifdef FFEMU_PERF
@@ -175,8 +177,7 @@ typedef struct ffmpeg
    slock_t *cond_lock;
    slock_t *lock;
    fifo_buffer_t *audio_fifo;
-   fifo_buffer_t *video_fifo;
-   fifo_buffer_t *attr_fifo;
+   ffemu_frame_pool_t *frame_pool;
    sthread_t *thread;
 
    volatile bool alive;
@@ -436,6 +437,10 @@ static bool ffmpeg_init_video(ffmpeg_t *handle)
          return false;
    }
 
+   /* Encoding runs on its own thread, and large GPU readbacks are
+    * expensive to scale down, so spread the scaling over all cores. */
+   video->scaler.threads = rarch_get_cpu_cores();
+
    video->codec = avcodec_alloc_context3(codec);
 
    /* Useful to set scale_factor to 2 for chroma subsampled formats to
@@ -620,9 +625,11 @@ static bool init_thread(ffmpeg_t *handle)
    handle->cond = scond_new();
    handle->audio_fifo = fifo_new(32000 * sizeof(int16_t) *
          handle->params.channels * MAX_FRAMES / 60); /* Some arbitrary max size. */
-   handle->attr_fifo = fifo_new(sizeof(struct ffemu_video_data) * MAX_FRAMES);
-   handle->video_fifo = fifo_new(handle->params.fb_width * handle->params.fb_height *
-            handle->video.pix_size * MAX_FRAMES);
+   /* Frames are scaled straight out of the pool. sws_scale()
+    * tends to read a bit past the end of its input, so overallocate. */
+   handle->frame_pool = ffemu_frame_pool_new(
+         (handle->params.fb_width * (handle->params.fb_height + 1) + 64) *
+         handle->video.pix_size, MAX_FRAMES, handle->params.backpressure);
 
    handle->alive = true;
    handle->can_sleep = true;
@@ -630,7 +637,7 @@ static bool init_thread(ffmpeg_t *handle)
 
    assert(handle->lock && handle->cond_lock &&
       handle->cond && handle->audio_fifo &&
-      handle->attr_fifo && handle->video_fifo && handle->thread);
+      handle->frame_pool && handle->thread);
 
    return true;
 }
@@ -663,16 +670,10 @@ static void deinit_thread_buf(ffmpeg_t *handle)
       handle->audio_fifo = NULL;
    }
    
-   if (handle->attr_fifo)
-   {
-      fifo_free(handle->attr_fifo);
-      handle->attr_fifo = NULL;
-   }
-
-   if (handle->video_fifo)
+   if (handle->frame_pool)
    {
-      fifo_free(handle->video_fifo);
-      handle->video_fifo = NULL;
+      ffemu_frame_pool_free(handle->frame_pool);
+      handle->frame_pool = NULL;
    }
 }
 
@@ -764,7 +765,6 @@ error:
 static bool ffmpeg_push_video(void *data,
       const struct ffemu_video_data *video_data)
 {
-   unsigned y;
    bool drop_frame;
    ffmpeg_t *handle = (ffmpeg_t*)data;
 
@@ -779,53 +779,16 @@ static bool ffmpeg_push_video(void *data,
    if (drop_frame)
       return true;
 
-   for (;;)
-   {
-      slock_lock(handle->lock);
-      unsigned avail = fifo_write_avail(handle->attr_fifo);
-      slock_unlock(handle->lock);
-
-      if (!handle->alive)
-         return false;
-
-      if (avail >= sizeof(*video_data))
-         break;
-
-      slock_lock(handle->cond_lock);
-      if (handle->can_sleep)
-      {
-         handle->can_sleep = false;
-         scond_wait(handle->cond, handle->cond_lock);
-         handle->can_sleep = true;
-      }
-      else
-         scond_signal(handle->cond);
-
-      slock_unlock(handle->cond_lock);
-   }
-
-   slock_lock(handle->lock);
-
-   /* Tightly pack our frame to conserve memory.
-    * libretro tends to use a very large pitch.
-    */
-   struct ffemu_video_data attr_data = *video_data;
-
-   if (attr_data.is_dupe)
-      attr_data.width = attr_data.height = attr_data.pitch = 0;
-   else
-      attr_data.pitch = attr_data.width * handle->video.pix_size;
-
-   fifo_write(handle->attr_fifo, &attr_data, sizeof(attr_data));
+   if (!handle->alive)
+      return false;
 
-   int offset = 0;
-   for (y = 0; y < attr_data.height; y++, offset += video_data->pitch)
-      fifo_write(handle->video_fifo,
-            (const uint8_t*)video_data->data + offset, attr_data.pitch);
+   /* Blocks, drops or dupes according to the backpressure policy
+    * when the encoder has fallen behind. */
+   if (!ffemu_frame_pool_push(handle->frame_pool, video_data,
+            handle->video.pix_size))
+      return false;
 
-   slock_unlock(handle->lock);
    scond_signal(handle->cond);
-
    return true;
 }
 
@@ -1235,8 +1198,6 @@ static void ffmpeg_flush_video(ffmpeg_t *handle)
 
 static void ffmpeg_flush_buffers(ffmpeg_t *handle)
 {
-   void *video_buf = av_malloc(2 * handle->params.fb_width * 
-         handle->params.fb_height * handle->video.pix_size);
    size_t audio_buf_size = handle->config.audio_enable ? 
       (handle->audio.codec->frame_size * 
        handle->params.channels * sizeof(int16_t)) : 0;
@@ -1265,14 +1226,12 @@ static void ffmpeg_flush_buffers(ffmpeg_t *handle)
          }
       }
 
-      struct ffemu_video_data attr_buf;
-      if (fifo_read_avail(handle->attr_fifo) >= sizeof(attr_buf))
+      struct ffemu_video_data video;
+      ffemu_frame_t *frame = NULL;
+      if (ffemu_frame_pool_pop(handle->frame_pool, &video, &frame))
       {
-         fifo_read(handle->attr_fifo, &attr_buf, sizeof(attr_buf));
-         fifo_read(handle->video_fifo, video_buf, 
-               attr_buf.height * attr_buf.pitch);
-         attr_buf.data = video_buf;
-         ffmpeg_push_video_thread(handle, &attr_buf);
+         ffmpeg_push_video_thread(handle, &video);
+         ffemu_frame_pool_release(handle->frame_pool, frame);
 
          did_work = true;
       }
@@ -1285,12 +1244,12 @@ static void ffmpeg_flush_buffers(ffmpeg_t *handle)
    /* Flush out last video. */
    ffmpeg_flush_video(handle);
 
-   av_free(video_buf);
    av_free(audio_buf);
 }
 
 static bool ffmpeg_finalize(void *data)
 {
+   struct ffemu_frame_pool_stats stats;
    ffmpeg_t *handle = (ffmpeg_t*)data;
 
    if (!handle)
@@ -1298,6 +1257,10 @@ static bool ffmpeg_finalize(void *data)
 
    deinit_thread(handle);
 
+   ffemu_frame_pool_get_stats(handle->frame_pool, &stats);
+   RARCH_LOG("[FFmpeg]: %u frames pushed, %u dropped, %u duplicated, main thread waited %u times.\n",
+         stats.pushed, stats.dropped, stats.duplicated, stats.blocked);
+
    /* Flush out data still in buffers (internal, and FFmpeg internal). */
    ffmpeg_flush_buffers(handle);
 
@@ -1313,27 +1276,20 @@ static void ffmpeg_thread(void *data)
 {
    ffmpeg_t *ff = (ffmpeg_t*)data;
 
-   /* For some reason, FFmpeg has a tendency to crash 
-    * if we don't overallocate a bit. */
-   void *video_buf = av_malloc(2 * ff->params.fb_width *
-         ff->params.fb_height * ff->video.pix_size);
-   assert(video_buf);
-
    size_t audio_buf_size = ff->config.audio_enable ? 
       (ff->audio.codec->frame_size * ff->params.channels * sizeof(int16_t)) : 0;
    void *audio_buf = audio_buf_size ? av_malloc(audio_buf_size) : NULL;
 
    while (ff->alive)
    {
-      struct ffemu_video_data attr_buf;
+      struct ffemu_video_data video;
+      ffemu_frame_t *frame = NULL;
 
-      bool avail_video = false;
+      bool avail_video = ffemu_frame_pool_pop(ff->frame_pool,
+            &video, &frame);
       bool avail_audio = false;
 
       slock_lock(ff->lock);
-      if (fifo_read_avail(ff->attr_fifo) >= sizeof(attr_buf))
-         avail_video = true;
-
       if (ff->config.audio_enable)
          if (fifo_read_avail(ff->audio_fifo) >= audio_buf_size)
             avail_audio = true;
@@ -1356,15 +1312,9 @@ static void ffmpeg_thread(void *data)
 
       if (avail_video)
       {
-         slock_lock(ff->lock);
-         fifo_read(ff->attr_fifo, &attr_buf, sizeof(attr_buf));
-         fifo_read(ff->video_fifo, video_buf,
-               attr_buf.height * attr_buf.pitch);
-         slock_unlock(ff->lock);
-         scond_signal(ff->cond);
-
-         attr_buf.data = video_buf;
-         ffmpeg_push_video_thread(ff, &attr_buf);
+         /* Encoded in place, no copy out of the pool. */
+         ffmpeg_push_video_thread(ff, &video);
+         ffemu_frame_pool_release(ff->frame_pool, frame);
       }
 
       if (avail_audio)
@@ -1382,7 +1332,6 @@ static void ffmpeg_thread(void *data)
       }
    }
 
-   av_free(video_buf);
    av_free(audio_buf);
 }
 
@@ -0,0 +1,337 @@
+/*  RetroArch - A frontend for libretro.
+ *  Copyright (C) 2010-2014 - Hans-Kristian Arntzen
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "frame_pool.h"
+#include "../thread.h"
+#include <stdlib.h>
+#include <string.h>
+
+struct ffemu_frame
+{
+   uint8_t *data;
+   unsigned width;
+   unsigned height;
+   int pitch;
+   unsigned refcount;
+};
+
+struct ffemu_frame_entry
+{
+   ffemu_frame_t *frame;
+   bool is_dupe;
+};
+
+/* The lock only guards refcounts and pointer moves,
+ * frame data is copied and encoded outside of it. */
+struct ffemu_frame_pool
+{
+   slock_t *lock;
+   scond_t *cond;
+
+   ffemu_frame_t *frames;
+   unsigned num_frames;
+   size_t frame_size;
+
+   ffemu_frame_t **free_list;
+   unsigned num_free;
+
+   /* Dupes don't take a buffer, so the queue can hold more entries
+    * than there are frames. */
+   struct ffemu_frame_entry *queue;
+   unsigned queue_size;
+   unsigned queue_head;
+   unsigned queue_count;
+
+   /* The pool keeps a reference to the last pushed frame for dupes. */
+   ffemu_frame_t *last;
+
+   enum ffemu_backpressure policy;
+   bool shutdown;
+
+   struct ffemu_frame_pool_stats stats;
+};
+
+ffemu_frame_pool_t *ffemu_frame_pool_new(size_t frame_size,
+      unsigned num_frames, enum ffemu_backpressure policy)
+{
+   unsigned i;
+   ffemu_frame_pool_t *pool = NULL;
+
+   /* One frame is always held as the last frame,
+    * so we need at least two to make progress. */
+   if (num_frames < 2)
+      return NULL;
+
+   pool = (ffemu_frame_pool_t*)calloc(1, sizeof(*pool));
+   if (!pool)
+      return NULL;
+
+   pool->num_frames = num_frames;
+   pool->frame_size = frame_size;
+   pool->queue_size = num_frames * 2;
+   pool->policy     = policy;
+
+   pool->lock      = slock_new();
+   pool->cond      = scond_new();
+   pool->frames    = (ffemu_frame_t*)calloc(num_frames, sizeof(*pool->frames));
+   pool->free_list = (ffemu_frame_t**)calloc(num_frames,
+         sizeof(*pool->free_list));
+   pool->queue     = (struct ffemu_frame_entry*)calloc(pool->queue_size,
+         sizeof(*pool->queue));
+
+   if (!pool->lock || !pool->cond || !pool->frames ||
+         !pool->free_list || !pool->queue)
+      goto error;
+
+   for (i = 0; i < num_frames; i++)
+   {
+      pool->frames[i].data = (uint8_t*)malloc(frame_size);
+      if (!pool->frames[i].data)
+         goto error;
+      pool->free_list[pool->num_free++] = &pool->frames[i];
+   }
+
+   return pool;
+
+error:
+   ffemu_frame_pool_free(pool);
+   return NULL;
+}
+
+void ffemu_frame_pool_free(ffemu_frame_pool_t *pool)
+{
+   unsigned i;
+   if (!pool)
+      return;
+
+   if (pool->frames)
+   {
+      for (i = 0; i < pool->num_frames; i++)
+         free(pool->frames[i].data);
+   }
+
+   if (pool->lock)
+      slock_free(pool->lock);
+   if (pool->cond)
+      scond_free(pool->cond);
+
+   free(pool->frames);
+   free(pool->free_list);
+   free(pool->queue);
+   free(pool);
+}
+
+/* Lock must be held. */
+static void frame_unref(ffemu_frame_pool_t *pool, ffemu_frame_t *frame)
+{
+   if (!frame || --frame->refcount)
+      return;
+
+   pool->free_list[pool->num_free++] = frame;
+   scond_signal(pool->cond);
+}
+
+/* Lock must be held, and the queue must not be full. */
+static void queue_push(ffemu_frame_pool_t *pool,
+      ffemu_frame_t *frame, bool is_dupe)
+{
+   struct ffemu_frame_entry *entry = &pool->queue[
+      (pool->queue_head + pool->queue_count) % pool->queue_size];
+
+   entry->frame   = frame;
+   entry->is_dupe = is_dupe;
+   pool->queue_count++;
+
+   if (frame)
+      frame->refcount++;
+}
+
+static bool push_dupe(ffemu_frame_pool_t *pool)
+{
+   bool ret;
+
+   slock_lock(pool->lock);
+   if (pool->queue_count == pool->queue_size && !pool->shutdown &&
+         pool->policy == FFEMU_BACKPRESSURE_BLOCK)
+   {
+      pool->stats.blocked++;
+      while (pool->queue_count == pool->queue_size && !pool->shutdown)
+         scond_wait(pool->cond, pool->lock);
+   }
+
+   ret = !pool->shutdown;
+   if (ret)
+   {
+      if (pool->queue_count < pool->queue_size)
+         queue_push(pool, pool->last, true);
+      else
+         pool->stats.dropped++;
+   }
+   slock_unlock(pool->lock);
+
+   return ret;
+}
+
+bool ffemu_frame_pool_push(ffemu_frame_pool_t *pool,
+      const struct ffemu_video_data *data, size_t pix_size)
+{
+   unsigned y;
+   size_t pitch;
+   bool waited          = false;
+   ffemu_frame_t *frame = NULL;
+   const uint8_t *src   = NULL;
+   uint8_t *dst         = NULL;
+
+   if (!pool || !data)
+      return false;
+
+   slock_lock(pool->lock);
+   pool->stats.pushed++;
+   slock_unlock(pool->lock);
+
+   if (data->is_dupe)
+      return push_dupe(pool);
+
+   pitch = data->width * pix_size;
+   if (pitch * data->height > pool->frame_size)
+      return false;
+
+   slock_lock(pool->lock);
+   while (!pool->shutdown &&
+         (!pool->num_free || pool->queue_count == pool->queue_size))
+   {
+      if (pool->policy == FFEMU_BACKPRESSURE_BLOCK)
+      {
+         if (!waited)
+            pool->stats.blocked++;
+         waited = true;
+         scond_wait(pool->cond, pool->lock);
+         continue;
+      }
+
+      /* Keep the timeline intact by repeating the last frame,
+       * if there is room for it. */
+      if (pool->policy == FFEMU_BACKPRESSURE_DUPE && pool->last &&
+            pool->queue_count < pool->queue_size)
+      {
+         queue_push(pool, pool->last, true);
+         pool->stats.duplicated++;
+      }
+      else
+         pool->stats.dropped++;
+
+      slock_unlock(pool->lock);
+      return true;
+   }
+
+   if (pool->shutdown)
+   {
+      slock_unlock(pool->lock);
+      return false;
+   }
+
+   frame = pool->free_list[--pool->num_free];
+   frame->refcount = 1;
+   slock_unlock(pool->lock);
+
+   /* Tightly pack our frame to conserve memory.
+    * libretro tends to use a very large pitch.
+    */
+   src = (const uint8_t*)data->data;
+   dst = frame->data;
+   for (y = 0; y < data->height; y++, src += data->pitch, dst += pitch)
+      memcpy(dst, src, pitch);
+
+   frame->width  = data->width;
+   frame->height = data->height;
+   frame->pitch  = pitch;
+
+   slock_lock(pool->lock);
+   /* Our reference from the free list becomes the last frame reference. */
+   frame_unref(pool, pool->last);
+   pool->last = frame;
+   queue_push(pool, frame, false);
+   slock_unlock(pool->lock);
+
+   return true;
+}
+
+bool ffemu_frame_pool_pop(ffemu_frame_pool_t *pool,
+      struct ffemu_video_data *data, ffemu_frame_t **frame)
+{
+   struct ffemu_frame_entry entry;
+
+   if (!pool)
+      return false;
+
+   slock_lock(pool->lock);
+   if (!pool->queue_count)
+   {
+      slock_unlock(pool->lock);
+      return false;
+   }
+
+   entry = pool->queue[pool->queue_head];
+   pool->queue_head = (pool->queue_head + 1) % pool->queue_size;
+   pool->queue_count--;
+   scond_signal(pool->cond);
+   slock_unlock(pool->lock);
+
+   memset(data, 0, sizeof(*data));
+   data->is_dupe = entry.is_dupe;
+
+   if (entry.frame)
+   {
+      data->data   = entry.frame->data;
+      data->width  = entry.frame->width;
+      data->height = entry.frame->height;
+      data->pitch  = entry.frame->pitch;
+   }
+
+   *frame = entry.frame;
+   return true;
+}
+
+void ffemu_frame_pool_release(ffemu_frame_pool_t *pool, ffemu_frame_t *frame)
+{
+   if (!pool || !frame)
+      return;
+
+   slock_lock(pool->lock);
+   frame_unref(pool, frame);
+   slock_unlock(pool->lock);
+}
+
+void ffemu_frame_pool_shutdown(ffemu_frame_pool_t *pool)
+{
+   if (!pool)
+      return;
+
+   slock_lock(pool->lock);
+   pool->shutdown = true;
+   scond_broadcast(pool->cond);
+   slock_unlock(pool->lock);
+}
+
+void ffemu_frame_pool_get_stats(ffemu_frame_pool_t *pool,
+      struct ffemu_frame_pool_stats *stats)
+{
+   if (!pool)
+      return;
+
+   slock_lock(pool->lock);
+   *stats = pool->stats;
+   slock_unlock(pool->lock);
+}
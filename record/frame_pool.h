@@ -0,0 +1,87 @@
+/*  RetroArch - A frontend for libretro.
+ *  Copyright (C) 2010-2014 - Hans-Kristian Arntzen
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __FFEMU_FRAME_POOL_H
+#define __FFEMU_FRAME_POOL_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "../boolean.h"
+#include "ffemu.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Hands video frames from the main thread to a recording thread.
+ *
+ * Frames live in a fixed set of preallocated, refcounted buffers.
+ * The producer packs each frame into a free buffer (the only copy made),
+ * and the consumer gets a pointer to it. Consumers may hold on to a
+ * popped frame (e.g. as a delta reference) until they release it.
+ *
+ * Dupes never take a buffer, they reference the last pushed frame.
+ * When no buffer is free, the backpressure policy decides what happens.
+ */
+
+typedef struct ffemu_frame ffemu_frame_t;
+typedef struct ffemu_frame_pool ffemu_frame_pool_t;
+
+struct ffemu_frame_pool_stats
+{
+   /* Frames handed to ffemu_frame_pool_push(). */
+   unsigned pushed;
+   /* Frames thrown away because no buffer was free. */
+   unsigned dropped;
+   /* Frames replaced by a dupe of the previous frame,
+    * because no buffer was free. */
+   unsigned duplicated;
+   /* Times the producer had to wait for a free buffer. */
+   unsigned blocked;
+};
+
+/* frame_size is the maximum size of a tightly packed frame.
+ * Returns NULL on allocation failure. */
+ffemu_frame_pool_t *ffemu_frame_pool_new(size_t frame_size,
+      unsigned num_frames, enum ffemu_backpressure policy);
+
+void ffemu_frame_pool_free(ffemu_frame_pool_t *pool);
+
+/* Producer side. Copies the frame, or queues a dupe.
+ * Returns false once the pool has been shut down. */
+bool ffemu_frame_pool_push(ffemu_frame_pool_t *pool,
+      const struct ffemu_video_data *data, size_t pix_size);
+
+/* Consumer side. Pops the oldest queued frame and fills in data,
+ * returns false if the queue is empty. The frame must be released
+ * after use. For a dupe pushed before any real frame,
+ * *frame and data->data are NULL. */
+bool ffemu_frame_pool_pop(ffemu_frame_pool_t *pool,
+      struct ffemu_video_data *data, ffemu_frame_t **frame);
+
+/* Accepts NULL. */
+void ffemu_frame_pool_release(ffemu_frame_pool_t *pool, ffemu_frame_t *frame);
+
+/* Wakes up and fails a blocked producer, e.g. when the consumer dies. */
+void ffemu_frame_pool_shutdown(ffemu_frame_pool_t *pool);
+
+void ffemu_frame_pool_get_stats(ffemu_frame_pool_t *pool,
+      struct ffemu_frame_pool_stats *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,579 @@
+/*  RetroArch - A frontend for libretro.
+ *  Copyright (C) 2010-2014 - Hans-Kristian Arntzen
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Built-in lossless recording backend.
+ * Frames are XORed against the previous frame and deflated,
+ * audio is stored as raw PCM. See rlv.h for the file format.
+ * Encoding happens on a worker thread, fed through a frame pool
+ * and an audio fifo the same way as the FFmpeg backend. */
+
+#ifdef HAVE_CONFIG_H
+#include "../config.h"
+#endif
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <zlib.h>
+
+#include "../boolean.h"
+#include "../fifo_buffer.h"
+#include "../thread.h"
+#include "../general.h"
+#include "../file_path.h"
+#include "ffemu.h"
+#include "frame_pool.h"
+#include "rlv.h"
+
+#define MAX_FRAMES 32
+
+/* Audio is written in chunks of at most this many frames. */
+#define RLV_AUDIO_CHUNK_FRAMES 4096
+
+typedef struct rlv
+{
+   struct ffemu_params params;
+   FILE *file;
+   size_t pix_size;
+   bool write_error;
+
+   /* Encoder state. Only touched by the thread,
+    * or by the main thread once the thread is gone. */
+   z_stream stream;
+   bool stream_init;
+   /* Reference frame for deltas, still owned by the pool. */
+   ffemu_frame_t *prev_frame;
+   const uint8_t *prev_data;
+   uint8_t *delta;
+   uint8_t *deflate_buf;
+   size_t deflate_buf_size;
+   unsigned prev_width;
+   unsigned prev_height;
+   uint32_t prev_crc;
+   bool has_prev;
+   unsigned frames_since_key;
+   uint32_t frame_cnt;
+   int16_t *audio_buf;
+   size_t audio_buf_size;
+
+   scond_t *cond;
+   slock_t *cond_lock;
+   slock_t *lock;
+   fifo_buffer_t *audio_fifo;
+   ffemu_frame_pool_t *frame_pool;
+   sthread_t *thread;
+
+   volatile bool alive;
+   volatile bool can_sleep;
+} rlv_t;
+
+static void write_le32(uint8_t *buf, uint32_t val)
+{
+   buf[0] = (uint8_t)(val >>  0);
+   buf[1] = (uint8_t)(val >>  8);
+   buf[2] = (uint8_t)(val >> 16);
+   buf[3] = (uint8_t)(val >> 24);
+}
+
+static void write_le64_double(uint8_t *buf, double val)
+{
+   uint64_t bits;
+   memcpy(&bits, &val, sizeof(bits));
+   write_le32(buf + 0, (uint32_t)bits);
+   write_le32(buf + 4, (uint32_t)(bits >> 32));
+}
+
+static bool rlv_write(rlv_t *handle, const void *data, size_t size)
+{
+   if (handle->write_error)
+      return false;
+
+   if (size && fwrite(data, 1, size, handle->file) != size)
+   {
+      RARCH_ERR("[RLV]: Failed to write to %s.\n", handle->params.filename);
+      handle->write_error = true;
+      return false;
+   }
+
+   return true;
+}
+
+static bool rlv_write_packet(rlv_t *handle, enum rlv_packet_type type,
+      uint32_t crc, const void *data, size_t size)
+{
+   uint8_t header[RLV_PACKET_SIZE];
+   write_le32(header + 0, type);
+   write_le32(header + 4, size);
+   write_le32(header + 8, crc);
+
+   return rlv_write(handle, header, sizeof(header)) &&
+      rlv_write(handle, data, size);
+}
+
+static bool rlv_write_header(rlv_t *handle)
+{
+   uint8_t header[RLV_HEADER_SIZE];
+   memcpy(header, RLV_MAGIC, 4);
+   write_le32(header +  4, handle->params.pix_fmt);
+   write_le32(header +  8, handle->params.channels);
+   write_le32(header + 12, (uint32_t)(handle->params.aspect_ratio * 1000000.0f));
+   write_le64_double(header + 16, handle->params.fps);
+   write_le64_double(header + 24, handle->params.samplerate);
+   return rlv_write(handle, header, sizeof(header));
+}
+
+/* Encodes a tightly packed frame from the pool.
+ * Takes over the reference to the frame. */
+static bool rlv_encode_video(rlv_t *handle, ffemu_frame_t *frame,
+      const struct ffemu_video_data *data)
+{
+   size_t i;
+   unsigned width     = data->width;
+   unsigned height    = data->height;
+   const uint8_t *cur = (const uint8_t*)data->data;
+   const uint8_t *src = cur;
+   size_t size = width * height * handle->pix_size;
+   uint32_t crc = crc32(0, cur, size);
+   bool keyframe = !handle->has_prev ||
+      width != handle->prev_width || height != handle->prev_height ||
+      handle->frames_since_key >= RLV_KEYFRAME_INTERVAL;
+
+   if (!keyframe)
+   {
+      const uint8_t *prev = handle->prev_data;
+      for (i = 0; i < size; i++)
+         handle->delta[i] = cur[i] ^ prev[i];
+      src = handle->delta;
+   }
+
+   if (deflateReset(&handle->stream) != Z_OK)
+   {
+      ffemu_frame_pool_release(handle->frame_pool, frame);
+      return false;
+   }
+
+   handle->stream.next_in   = (Bytef*)src;
+   handle->stream.avail_in  = size;
+   handle->stream.next_out  = handle->deflate_buf + RLV_VIDEO_HEADER_SIZE;
+   handle->stream.avail_out = handle->deflate_buf_size - RLV_VIDEO_HEADER_SIZE;
+
+   if (deflate(&handle->stream, Z_FINISH) != Z_STREAM_END)
+   {
+      RARCH_ERR("[RLV]: Failed to compress frame.\n");
+      ffemu_frame_pool_release(handle->frame_pool, frame);
+      return false;
+   }
+
+   write_le32(handle->deflate_buf + 0, width);
+   write_le32(handle->deflate_buf + 4, height);
+
+   if (!rlv_write_packet(handle,
+            keyframe ? RLV_PACKET_KEYFRAME : RLV_PACKET_DELTA, crc,
+            handle->deflate_buf,
+            RLV_VIDEO_HEADER_SIZE + handle->stream.total_out))
+   {
+      ffemu_frame_pool_release(handle->frame_pool, frame);
+      return false;
+   }
+
+   /* The current frame is the reference for the next one. */
+   ffemu_frame_pool_release(handle->frame_pool, handle->prev_frame);
+   handle->prev_frame  = frame;
+   handle->prev_data   = cur;
+   handle->prev_width  = width;
+   handle->prev_height = height;
+   handle->prev_crc    = crc;
+   handle->has_prev    = true;
+   handle->frames_since_key = keyframe ? 1 : handle->frames_since_key + 1;
+   handle->frame_cnt++;
+   return true;
+}
+
+static bool rlv_encode_dupe(rlv_t *handle)
+{
+   /* Nothing to repeat yet. */
+   if (!handle->has_prev)
+      return true;
+
+   handle->frame_cnt++;
+   return rlv_write_packet(handle, RLV_PACKET_DUPE,
+         handle->prev_crc, NULL, 0);
+}
+
+static bool rlv_encode_audio(rlv_t *handle, size_t size)
+{
+   return rlv_write_packet(handle, RLV_PACKET_AUDIO,
+         crc32(0, (const uint8_t*)handle->audio_buf, size),
+         handle->audio_buf, size);
+}
+
+static void rlv_thread(void *data);
+
+static bool init_thread(rlv_t *handle)
+{
+   handle->lock       = slock_new();
+   handle->cond_lock  = slock_new();
+   handle->cond       = scond_new();
+   handle->audio_fifo = fifo_new(32000 * sizeof(int16_t) *
+         handle->params.channels * MAX_FRAMES / 60); /* Some arbitrary max size. */
+   handle->frame_pool = ffemu_frame_pool_new(handle->params.fb_width *
+         handle->params.fb_height * handle->pix_size, MAX_FRAMES,
+         handle->params.backpressure);
+
+   if (!handle->lock || !handle->cond_lock || !handle->cond ||
+         !handle->audio_fifo || !handle->frame_pool)
+      return false;
+
+   handle->alive     = true;
+   handle->can_sleep = true;
+   handle->thread    = sthread_create(rlv_thread, handle);
+
+   return handle->thread;
+}
+
+static void deinit_thread(rlv_t *handle)
+{
+   if (!handle->thread)
+      return;
+
+   slock_lock(handle->cond_lock);
+   handle->alive = false;
+   handle->can_sleep = false;
+   slock_unlock(handle->cond_lock);
+
+   scond_signal(handle->cond);
+   sthread_join(handle->thread);
+
+   handle->thread = NULL;
+}
+
+static void deinit_thread_buf(rlv_t *handle)
+{
+   if (handle->lock)
+      slock_free(handle->lock);
+   if (handle->cond_lock)
+      slock_free(handle->cond_lock);
+   if (handle->cond)
+      scond_free(handle->cond);
+   handle->lock      = NULL;
+   handle->cond_lock = NULL;
+   handle->cond      = NULL;
+
+   if (handle->audio_fifo)
+      fifo_free(handle->audio_fifo);
+   handle->audio_fifo = NULL;
+
+   ffemu_frame_pool_release(handle->frame_pool, handle->prev_frame);
+   handle->prev_frame = NULL;
+   handle->prev_data  = NULL;
+   handle->has_prev   = false;
+
+   ffemu_frame_pool_free(handle->frame_pool);
+   handle->frame_pool = NULL;
+}
+
+static void rlv_free(void *data)
+{
+   rlv_t *handle = (rlv_t*)data;
+   if (!handle)
+      return;
+
+   deinit_thread(handle);
+   deinit_thread_buf(handle);
+
+   if (handle->stream_init)
+      deflateEnd(&handle->stream);
+
+   if (handle->file)
+      fclose(handle->file);
+
+   free(handle->delta);
+   free(handle->deflate_buf);
+   free(handle->audio_buf);
+   free(handle);
+}
+
+static void *rlv_new(const struct ffemu_params *params)
+{
+   size_t frame_size;
+   rlv_t *handle = NULL;
+
+#ifdef HAVE_FFMPEG
+   /* Leave every other container to FFmpeg. */
+   if (strcasecmp(path_get_extension(params->filename), "rlv") != 0)
+      return NULL;
+#endif
+
+   handle = (rlv_t*)calloc(1, sizeof(*handle));
+   if (!handle)
+      return NULL;
+
+   handle->params = *params;
+   if (params->config)
+      RARCH_WARN("[RLV]: Recording config is not used by this backend.\n");
+   handle->params.config = NULL;
+
+   switch (params->pix_fmt)
+   {
+      case FFEMU_PIX_RGB565:
+         handle->pix_size = sizeof(uint16_t);
+         break;
+      case FFEMU_PIX_BGR24:
+         handle->pix_size = 3;
+         break;
+      case FFEMU_PIX_ARGB8888:
+         handle->pix_size = sizeof(uint32_t);
+         break;
+      default:
+         goto error;
+   }
+
+   /* Lowest level with RLE matching. XORed frames are mostly
+    * zero runs, so this is both fast and compresses well. */
+   if (deflateInit2(&handle->stream, 1, Z_DEFLATED,
+            -MAX_WBITS, 8, Z_RLE) != Z_OK)
+      goto error;
+   handle->stream_init = true;
+
+   frame_size               = params->fb_width * params->fb_height * handle->pix_size;
+   handle->deflate_buf_size = RLV_VIDEO_HEADER_SIZE +
+      deflateBound(&handle->stream, frame_size);
+   handle->delta            = (uint8_t*)malloc(frame_size);
+   handle->deflate_buf      = (uint8_t*)malloc(handle->deflate_buf_size);
+   handle->audio_buf_size   = RLV_AUDIO_CHUNK_FRAMES *
+      params->channels * sizeof(int16_t);
+   handle->audio_buf        = (int16_t*)malloc(handle->audio_buf_size);
+
+   if (!handle->delta || !handle->deflate_buf || !handle->audio_buf)
+      goto error;
+
+   handle->file = fopen(params->filename, "wb");
+   if (!handle->file)
+   {
+      RARCH_ERR("[RLV]: Failed to open %s.\n", params->filename);
+      goto error;
+   }
+
+   if (!rlv_write_header(handle))
+      goto error;
+
+   if (!init_thread(handle))
+      goto error;
+
+   RARCH_LOG("[RLV]: Recording lossless video to %s.\n", params->filename);
+   return handle;
+
+error:
+   rlv_free(handle);
+   return NULL;
+}
+
+static bool rlv_push_video(void *data,
+      const struct ffemu_video_data *video_data)
+{
+   rlv_t *handle = (rlv_t*)data;
+
+   if (!handle || !video_data || !handle->alive)
+      return false;
+
+   /* Blocks, drops or dupes according to the backpressure policy
+    * when the encoder has fallen behind. */
+   if (!ffemu_frame_pool_push(handle->frame_pool, video_data,
+            handle->pix_size))
+      return false;
+
+   scond_signal(handle->cond);
+   return true;
+}
+
+static bool rlv_push_audio(void *data,
+      const struct ffemu_audio_data *audio_data)
+{
+   size_t size;
+   rlv_t *handle = (rlv_t*)data;
+
+   if (!handle || !audio_data)
+      return false;
+
+   size = audio_data->frames * handle->params.channels * sizeof(int16_t);
+
+   for (;;)
+   {
+      slock_lock(handle->lock);
+      unsigned avail = fifo_write_avail(handle->audio_fifo);
+      slock_unlock(handle->lock);
+
+      if (!handle->alive)
+         return false;
+
+      if (avail >= size)
+         break;
+
+      slock_lock(handle->cond_lock);
+      if (handle->can_sleep)
+      {
+         handle->can_sleep = false;
+         scond_wait(handle->cond, handle->cond_lock);
+         handle->can_sleep = true;
+      }
+      else
+         scond_signal(handle->cond);
+
+      slock_unlock(handle->cond_lock);
+   }
+
+   slock_lock(handle->lock);
+   fifo_write(handle->audio_fifo, audio_data->data, size);
+   slock_unlock(handle->lock);
+   scond_signal(handle->cond);
+
+   return true;
+}
+
+static size_t rlv_audio_chunk_size(rlv_t *handle, size_t avail)
+{
+   size_t frame_size = handle->params.channels * sizeof(int16_t);
+   if (avail > handle->audio_buf_size)
+      avail = handle->audio_buf_size;
+   return avail - avail % frame_size;
+}
+
+/* Encodes one frame and one chunk of audio if available.
+ * Frames are encoded straight out of the pool,
+ * the lock is only held while copying audio out of the fifo. */
+static bool rlv_process(rlv_t *handle, bool *did_work)
+{
+   struct ffemu_video_data video;
+   ffemu_frame_t *frame = NULL;
+   size_t audio_size    = 0;
+   bool avail_video     = ffemu_frame_pool_pop(handle->frame_pool,
+         &video, &frame);
+
+   *did_work = false;
+
+   slock_lock(handle->lock);
+   audio_size = rlv_audio_chunk_size(handle,
+         fifo_read_avail(handle->audio_fifo));
+   if (audio_size)
+      fifo_read(handle->audio_fifo, handle->audio_buf, audio_size);
+   slock_unlock(handle->lock);
+
+   if (!avail_video && !audio_size)
+      return true;
+
+   *did_work = true;
+   scond_signal(handle->cond);
+
+   if (avail_video)
+   {
+      bool ret;
+      if (video.is_dupe)
+      {
+         ffemu_frame_pool_release(handle->frame_pool, frame);
+         ret = rlv_encode_dupe(handle);
+      }
+      else
+         ret = rlv_encode_video(handle, frame, &video);
+
+      if (!ret)
+         return false;
+   }
+
+   if (audio_size && !rlv_encode_audio(handle, audio_size))
+      return false;
+
+   return true;
+}
+
+static bool rlv_finalize(void *data)
+{
+   bool did_work;
+   uint8_t frames[4];
+   struct ffemu_frame_pool_stats stats;
+   rlv_t *handle = (rlv_t*)data;
+
+   if (!handle)
+      return false;
+
+   deinit_thread(handle);
+
+   ffemu_frame_pool_get_stats(handle->frame_pool, &stats);
+   RARCH_LOG("[RLV]: %u frames pushed, %u dropped, %u duplicated, main thread waited %u times.\n",
+         stats.pushed, stats.dropped, stats.duplicated, stats.blocked);
+
+   /* Flush out data still in buffers. */
+   do
+   {
+      if (!rlv_process(handle, &did_work))
+         break;
+   } while (did_work);
+
+   write_le32(frames, handle->frame_cnt);
+   rlv_write_packet(handle, RLV_PACKET_END, 0, frames, sizeof(frames));
+
+   deinit_thread_buf(handle);
+
+   if (fclose(handle->file) != 0)
+      handle->write_error = true;
+   handle->file = NULL;
+
+   return !handle->write_error;
+}
+
+static void rlv_thread(void *data)
+{
+   rlv_t *handle = (rlv_t*)data;
+
+   while (handle->alive)
+   {
+      bool did_work = false;
+
+      if (!rlv_process(handle, &did_work))
+      {
+         /* Unblock the pushers, which check alive. */
+         slock_lock(handle->cond_lock);
+         handle->alive = false;
+         slock_unlock(handle->cond_lock);
+         scond_signal(handle->cond);
+         ffemu_frame_pool_shutdown(handle->frame_pool);
+         break;
+      }
+
+      if (!did_work)
+      {
+         slock_lock(handle->cond_lock);
+         if (handle->can_sleep)
+         {
+            handle->can_sleep = false;
+            scond_wait(handle->cond, handle->cond_lock);
+            handle->can_sleep = true;
+         }
+         else
+            scond_signal(handle->cond);
+
+         slock_unlock(handle->cond_lock);
+      }
+   }
+}
+
+const ffemu_backend_t ffemu_rlv = {
+   rlv_new,
+   rlv_free,
+   rlv_push_video,
+   rlv_push_audio,
+   rlv_finalize,
+   "rlv",
+};
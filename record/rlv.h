@@ -0,0 +1,62 @@
+/*  RetroArch - A frontend for libretro.
+ *  Copyright (C) 2010-2014 - Hans-Kristian Arntzen
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __RARCH_RLV_H
+#define __RARCH_RLV_H
+
+/* RLV - RetroArch lossless video.
+ *
+ * A trivial container used by the built-in recording backend.
+ * All integers are little endian.
+ *
+ * File header (RLV_HEADER_SIZE bytes):
+ *    char     magic[4]     "RLV1"
+ *    uint32_t pix_fmt      enum ffemu_pix_format
+ *    uint32_t channels     Interleaved S16 audio channels.
+ *    uint32_t aspect       Aspect ratio * 1000000.
+ *    uint64_t fps          IEEE754 double bit pattern.
+ *    uint64_t samplerate   IEEE754 double bit pattern.
+ *
+ * Followed by packets, each with a header of RLV_PACKET_SIZE bytes:
+ *    uint32_t type         enum rlv_packet_type
+ *    uint32_t size         Payload size in bytes.
+ *    uint32_t crc          CRC32 of the decoded frame or audio.
+ *
+ * Video payloads start with uint32_t width, uint32_t height, followed by
+ * a raw deflate stream of the tightly packed frame (keyframes) or of the
+ * frame XOR the previous frame (deltas). A dupe packet has no payload
+ * and repeats the previous frame. Audio payloads are raw S16 PCM.
+ * The final packet is RLV_PACKET_END, with a uint32_t video frame count.
+ */
+
+#define RLV_MAGIC "RLV1"
+#define RLV_HEADER_SIZE 32
+#define RLV_PACKET_SIZE 12
+#define RLV_VIDEO_HEADER_SIZE 8
+
+/* A keyframe is forced at least this often,
+ * so a damaged file can be resynced. */
+#define RLV_KEYFRAME_INTERVAL 600
+
+enum rlv_packet_type
+{
+   RLV_PACKET_KEYFRAME = 0,
+   RLV_PACKET_DELTA,
+   RLV_PACKET_DUPE,
+   RLV_PACKET_AUDIO,
+   RLV_PACKET_END
+};
+
+#endif
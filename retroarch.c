@@ -26,6 +26,8 @@
 #include "driver.h"
 #include "file.h"
 #include "general.h"
+#include "performance.h"
+#include "hash.h"
 #include "dynamic.h"
 #include "compat/strl.h"
 #include "screenshot.h"
@@ -236,7 +238,12 @@ void rarch_recording_dump_frame(const void *data, unsigned width,
       ffemu_data.is_dupe = !data;
 
    if (driver.recording && driver.recording->push_video)
+   {
+      RARCH_PERFORMANCE_INIT(record_push_video);
+      RARCH_PERFORMANCE_START(record_push_video);
       driver.recording->push_video(driver.recording_data, &ffemu_data);
+      RARCH_PERFORMANCE_STOP(record_push_video);
+   }
 }
 
 static void init_recording(void)
@@ -276,6 +283,8 @@ static void init_recording(void)
    params.pix_fmt    = (g_extern.system.pix_fmt == RETRO_PIXEL_FORMAT_XRGB8888) ?
       FFEMU_PIX_ARGB8888 : FFEMU_PIX_RGB565;
    params.config     = NULL;
+   params.backpressure = ffemu_backpressure_from_string(
+         g_settings.video.record_backpressure);
    
    if (*g_extern.record_config)
       params.config = g_extern.record_config;
@@ -420,6 +429,7 @@ static void print_features(void)
    _PSUPP(fbo, "FBO", "OpenGL render-to-texture (multi-pass shaders)");
    _PSUPP(dynamic, "Dynamic", "Dynamic run-time loading of libretro library");
    _PSUPP(ffmpeg, "FFmpeg", "On-the-fly recording of gameplay with libavcodec");
+   _PSUPP(rlv, "RLV", "Built-in lossless recording of gameplay (.rlv)");
    _PSUPP(freetype, "FreeType", "TTF font rendering with FreeType");
    _PSUPP(netplay, "Netplay", "Peer-to-peer netplay");
    _PSUPP(python, "Python", "Script support in shaders");
@@ -518,7 +528,13 @@ static void print_help(void)
    puts("\t--ips: Specifies path for IPS patch that will be applied to content.");
    puts("\t--no-patch: Disables all forms of content patching.");
    puts("\t-D/--detach: Detach " RETRO_FRONTEND " from the running console. Not relevant for all platforms.");
-   puts("\t--max-frames: Runs for the specified number of frames, then exits.\n");
+   puts("\t--max-frames: Runs for the specified number of frames, then exits.");
+   puts("\t--benchmark: Runs without frame limiting for --max-frames frames (default 3600),");
+   puts("\t\tthen writes frame rate and performance counter timings as JSON to path.");
+   puts("\t\tCombine with null drivers for headless runs.");
+   puts("\t--checkpoints: Writes a CRC32 of the core's serialized state to path every");
+   puts("\t\t--checkpoint-interval frames (default 60), to compare replays of a movie.");
+   puts("\t\tSee tools/retroarch-replay.sh.\n");
 }
 
 static void set_basename(const char *path)
@@ -649,6 +665,9 @@ static void parse_input(int argc, char *argv[])
    *g_extern.ips_name = '\0';
 
    *g_extern.subsystem = '\0';
+   *g_extern.benchmark.path = '\0';
+   *g_extern.checkpoint.path = '\0';
+   g_extern.checkpoint.interval = 60;
 
    if (argc < 2)
    {
@@ -701,6 +720,9 @@ static void parse_input(int argc, char *argv[])
       { "features", 0, &val, 'f' },
       { "subsystem", 1, NULL, 'Z' },
       { "max-frames", 1, NULL, 'm' },
+      { "benchmark", 1, &val, 'b' },
+      { "checkpoints", 1, &val, 'k' },
+      { "checkpoint-interval", 1, &val, 'K' },
       { "eof-exit", 0, &val, 'e' },
       { NULL, 0, NULL, 0 }
    };
@@ -982,6 +1004,26 @@ static void parse_input(int argc, char *argv[])
                   g_extern.bsv.eof_exit = true;
                   break;
 
+               case 'b':
+                  strlcpy(g_extern.benchmark.path, optarg,
+                        sizeof(g_extern.benchmark.path));
+                  break;
+
+               case 'k':
+                  strlcpy(g_extern.checkpoint.path, optarg,
+                        sizeof(g_extern.checkpoint.path));
+                  break;
+
+               case 'K':
+                  g_extern.checkpoint.interval = strtoul(optarg, NULL, 0);
+                  if (!g_extern.checkpoint.interval)
+                  {
+                     RARCH_ERR("--checkpoint-interval must be at least 1.\n");
+                     print_help();
+                     rarch_fail(1, "parse_input()");
+                  }
+                  break;
+
                default:
                   break;
             }
@@ -1059,6 +1101,7 @@ static void init_controllers(void)
       {
          RARCH_LOG("Disconnecting device from port %u.\n", i + 1);
          pretro_set_controller_port_device(i, device);
+         runahead_set_controller_port_device(g_extern.runahead, i, device);
       }
       else if (device != RETRO_DEVICE_JOYPAD)
       {
@@ -1068,6 +1111,7 @@ static void init_controllers(void)
          RARCH_LOG("Connecting %s (ID: %u) to port %u.\n", ident,
                device, i + 1);
          pretro_set_controller_port_device(i, device);
+         runahead_set_controller_port_device(g_extern.runahead, i, device);
       }
    }
 }
@@ -1080,8 +1124,13 @@ static bool load_save_files(void)
       return false;
 
    for (i = 0; i < g_extern.savefiles->size; i++)
+   {
+#ifdef HAVE_THREADS
+      autosave_recover(g_extern.savefiles->elems[i].data);
+#endif
       load_ram_file(g_extern.savefiles->elems[i].data,
             g_extern.savefiles->elems[i].attr.i);
+   }
     
     return true;
 }
@@ -1155,6 +1204,32 @@ static void init_rewind(void)
    state_manager_push_do(g_extern.state_manager);
 }
 
+static void init_runahead(void)
+{
+#ifdef HAVE_NETPLAY
+   if (driver.netplay_data)
+      return;
+#endif
+
+   if (!g_settings.run_ahead_enable || !g_settings.run_ahead_frames
+         || g_extern.runahead)
+      return;
+
+   if (g_extern.system.audio_callback.callback)
+   {
+      RARCH_ERR("Run-ahead: cores with an audio callback are not supported.\n");
+      return;
+   }
+
+   g_extern.runahead = runahead_new(g_settings.run_ahead_frames,
+         g_settings.run_ahead_secondary_instance);
+
+   if (!g_extern.runahead)
+      RARCH_ERR("Run-ahead: core does not support save states.\n");
+   else
+      RARCH_LOG("Running %u frame(s) ahead.\n", g_settings.run_ahead_frames);
+}
+
 static void init_movie(void)
 {
    if (g_extern.bsv.movie_start_playback)
@@ -1259,6 +1334,18 @@ static void init_command(void)
 }
 #endif
 
+#ifdef HAVE_CONTROL
+static void init_control(void)
+{
+   if (!g_settings.control_socket_enable)
+      return;
+
+   if (!(driver.control = rarch_control_new(g_settings.control_socket_path,
+               g_settings.control_socket_port)))
+      RARCH_ERR("Failed to initialize control socket.\n");
+}
+#endif
+
 #if defined(HAVE_THREADS)
 static void init_autosave(void)
 {
@@ -1497,6 +1584,14 @@ static bool save_auto_state(void)
          ".auto", sizeof(savestate_name_auto));
 
    bool ret = save_state(savestate_name_auto);
+
+   /* Wait for the write, we are about to quit. */
+   if (ret)
+   {
+      savestate_writer_flush(g_extern.state_writer);
+      ret = !savestate_writer_failed(g_extern.state_writer, NULL, 0);
+   }
+
    RARCH_LOG("Auto save state to \"%s\" %s.\n", savestate_name_auto, ret ?
          "succeeded" : "failed");
     
@@ -1542,6 +1637,9 @@ static void rarch_save_state(const char *path,
 static void main_state(unsigned cmd)
 {
    char path[PATH_MAX], msg[PATH_MAX];
+   /* How long emulation is held up, from the hotkey until
+    * the next frame can run. */
+   retro_time_t start = rarch_get_time_usec();
 
    if (g_settings.state_slot > 0)
       snprintf(path, sizeof(path), "%s%d",
@@ -1564,7 +1662,8 @@ static void main_state(unsigned cmd)
 
    msg_queue_clear(g_extern.msg_queue);
    msg_queue_push(g_extern.msg_queue, msg, 2, 180);
-   RARCH_LOG("%s\n", msg);
+   RARCH_LOG("%s (Emulation resumed after %.2f ms.)\n", msg,
+         (rarch_get_time_usec() - start) / 1000.0);
 }
 
 bool rarch_check_fullscreen(bool pressed)
@@ -1892,6 +1991,13 @@ static void init_system_av_info(void)
 
 static void deinit_core(void)
 {
+   /* Finishes any pending state write. */
+   savestate_writer_free(g_extern.state_writer);
+   g_extern.state_writer = NULL;
+
+   rarch_main_command(RARCH_CMD_RUNAHEAD_DEINIT);
+   runahead_free_content();
+
    pretro_unload_game();
    pretro_deinit();
 
@@ -1942,6 +2048,189 @@ static bool init_core(void)
    return true;
 }
 
+/* Benchmarks measure the frontend, not the host's display or
+ * sound card, so take every form of frame pacing out of the loop. */
+static void init_benchmark(void)
+{
+   if (!*g_extern.benchmark.path)
+      return;
+
+   g_extern.perfcnt_enable = true;
+   g_settings.video.vsync  = false;
+   g_settings.audio.sync   = false;
+   g_settings.fastforward_ratio_throttle_enable = false;
+
+   /* A replayed movie ends the run by itself. */
+   if (!g_extern.max_frames && !(g_extern.bsv.movie_start_playback
+            && g_extern.bsv.eof_exit))
+      g_extern.max_frames = 3600;
+
+   RARCH_LOG("Benchmarking %u frames, report goes to \"%s\".\n",
+         g_extern.max_frames, g_extern.benchmark.path);
+}
+
+static void init_checkpoints(void)
+{
+   if (!*g_extern.checkpoint.path)
+      return;
+
+   if (!pretro_serialize_size())
+   {
+      RARCH_ERR("Core does not support savestates, no checkpoints can be taken.\n");
+      return;
+   }
+
+   g_extern.checkpoint.file = fopen(g_extern.checkpoint.path, "w");
+   if (!g_extern.checkpoint.file)
+   {
+      RARCH_ERR("Failed to open checkpoint file \"%s\".\n",
+            g_extern.checkpoint.path);
+      return;
+   }
+
+   g_extern.checkpoint.frame = 0;
+   RARCH_LOG("Writing state checkpoints every %u frames to \"%s\".\n",
+         g_extern.checkpoint.interval, g_extern.checkpoint.path);
+}
+
+static void deinit_checkpoints(void)
+{
+   if (g_extern.checkpoint.file && fclose(g_extern.checkpoint.file) != 0)
+      RARCH_ERR("Failed to write checkpoint file.\n");
+
+   free(g_extern.checkpoint.buf);
+   g_extern.checkpoint.file = NULL;
+   g_extern.checkpoint.buf  = NULL;
+   g_extern.checkpoint.size = 0;
+}
+
+/* Called after every frame the core ran. One line per checkpoint,
+ * "<frame> <crc32>", frame counting from the start of the movie. */
+void rarch_main_checkpoint(void)
+{
+   size_t size;
+   unsigned frame = ++g_extern.checkpoint.frame;
+
+   /* The frame after the last one of a movie
+    * ran without recorded input. */
+   if (g_extern.bsv.movie && g_extern.bsv.movie_playback)
+   {
+      if (g_extern.bsv.movie_end)
+         return;
+      frame = bsv_movie_get_frame(g_extern.bsv.movie);
+   }
+
+   if (frame % g_extern.checkpoint.interval)
+      return;
+
+   size = pretro_serialize_size();
+   if (size > g_extern.checkpoint.size)
+   {
+      void *buf = realloc(g_extern.checkpoint.buf, size);
+      if (!buf)
+         return;
+      g_extern.checkpoint.buf  = buf;
+      g_extern.checkpoint.size = size;
+   }
+
+   if (!pretro_serialize(g_extern.checkpoint.buf, size))
+   {
+      RARCH_WARN("Failed to serialize checkpoint at frame %u.\n", frame);
+      return;
+   }
+
+   fprintf(g_extern.checkpoint.file, "%u %08x\n", frame,
+         (unsigned)crc32_calculate((const uint8_t*)g_extern.checkpoint.buf,
+            size));
+}
+
+/* Writes str as a quoted JSON string. */
+static void write_json_string(FILE *file, const char *str)
+{
+   fputc('"', file);
+   for (; *str; str++)
+   {
+      unsigned char c = *str;
+
+      if (c == '"' || c == '\\')
+         fprintf(file, "\\%c", c);
+      else if (c < 0x20)
+         fprintf(file, "\\u%04x", c);
+      else
+         fputc(c, file);
+   }
+   fputc('"', file);
+}
+
+static void write_benchmark_report(void)
+{
+   FILE *file;
+   unsigned frames;
+   char core[PATH_MAX];
+   double seconds, usec_per_tick = 1.0;
+   retro_time_t usec = rarch_get_time_usec() - g_extern.benchmark.start_usec;
+   retro_perf_tick_t ticks = rarch_get_perf_counter() -
+      g_extern.benchmark.start_tick;
+
+   file = fopen(g_extern.benchmark.path, "w");
+   if (!file)
+   {
+      RARCH_ERR("Failed to open benchmark report \"%s\".\n",
+            g_extern.benchmark.path);
+      return;
+   }
+
+   /* Perf ticks are not necessarily nanoseconds. */
+   if (ticks)
+      usec_per_tick = (double)usec / ticks;
+
+   frames  = g_extern.frame_count - g_extern.benchmark.start_frame;
+   seconds = usec / 1000000.0;
+
+   snprintf(core, sizeof(core), "%s %s",
+         g_extern.system.info.library_name ?
+         g_extern.system.info.library_name : "",
+         g_extern.system.info.library_version ?
+         g_extern.system.info.library_version : "");
+
+   fputs("{\n", file);
+   fputs("  \"core\": ", file);
+   write_json_string(file, core);
+   fputs(",\n", file);
+   fprintf(file, "  \"frames\": %u,\n", frames);
+   fprintf(file, "  \"seconds\": %.6f,\n", seconds);
+   fprintf(file, "  \"fps\": %.3f,\n", seconds > 0.0 ? frames / seconds : 0.0);
+   fprintf(file, "  \"usec_per_frame\": %.3f,\n",
+         frames ? (double)usec / frames : 0.0);
+   fprintf(file, "  \"dupe_frames\": %u,\n", driver.frame_dupe.dupes);
+   fputs("  \"features\": {\n", file);
+   fprintf(file, "    \"rewind\": %s,\n",
+         g_extern.state_manager ? "true" : "false");
+   fprintf(file, "    \"softfilter\": %s,\n",
+         g_extern.filter.filter ? "true" : "false");
+   fprintf(file, "    \"dsp\": %s,\n",
+         g_extern.audio_data.dsp ? "true" : "false");
+   fputs("    \"resampler\": ", file);
+   write_json_string(file, g_settings.audio.resampler);
+   fputs(",\n", file);
+   fprintf(file, "    \"recording\": %s,\n",
+         driver.recording_data ? "true" : "false");
+   fprintf(file, "    \"netplay\": %s,\n",
+         driver.netplay_data ? "true" : "false");
+   fprintf(file, "    \"threaded_video\": %s\n",
+         g_settings.video.threaded ? "true" : "false");
+   fputs("  },\n", file);
+   fputs("  \"counters\": ", file);
+   rarch_perf_write_json(file, usec_per_tick);
+   fputs("\n}\n", file);
+
+   if (fclose(file) != 0)
+      RARCH_ERR("Failed to write benchmark report.\n");
+   else
+      RARCH_LOG("Benchmark: %u frames in %.3f s (%.1f FPS).\n",
+            frames, seconds, seconds > 0.0 ? frames / seconds : 0.0);
+}
+
 int rarch_main_init(int argc, char *argv[])
 {
    int sjlj_ret;
@@ -1969,6 +2258,7 @@ int rarch_main_init(int argc, char *argv[])
 
    validate_cpu_features();
    config_load();
+   init_benchmark();
 
    init_libretro_sym(g_extern.libretro_dummy);
    init_system_info();
@@ -1980,11 +2270,19 @@ int rarch_main_init(int argc, char *argv[])
 
    rarch_main_command(RARCH_CMD_DRIVERS_INIT);
    rarch_main_command(RARCH_CMD_COMMAND_INIT);
+   rarch_main_command(RARCH_CMD_CONTROL_INIT);
    rarch_main_command(RARCH_CMD_REWIND_INIT);
+   rarch_main_command(RARCH_CMD_RUNAHEAD_INIT);
    rarch_main_command(RARCH_CMD_CONTROLLERS_INIT);
    rarch_main_command(RARCH_CMD_RECORD_INIT);
    rarch_main_command(RARCH_CMD_CHEATS_INIT);
 
+   init_checkpoints();
+
+   g_extern.benchmark.start_frame = g_extern.frame_count;
+   g_extern.benchmark.start_usec  = rarch_get_time_usec();
+   g_extern.benchmark.start_tick  = rarch_get_perf_counter();
+
    g_extern.error_in_init = false;
    g_extern.main_is_init  = true;
    return 0;
@@ -2209,6 +2507,7 @@ bool rarch_main_command(unsigned cmd)
          msg_queue_clear(g_extern.msg_queue);
          msg_queue_push(g_extern.msg_queue, "Reset.", 1, 120);
          pretro_reset();
+         runahead_invalidate(g_extern.runahead);
 
          /* bSNES since v073r01 resets controllers to JOYPAD
           * after a reset, so just enforce it here. */
@@ -2274,6 +2573,22 @@ bool rarch_main_command(unsigned cmd)
          else
             rarch_main_command(RARCH_CMD_REWIND_DEINIT);
          break;
+      case RARCH_CMD_RUNAHEAD_DEINIT:
+         runahead_free(g_extern.runahead);
+         g_extern.runahead = NULL;
+         break;
+      case RARCH_CMD_RUNAHEAD_INIT:
+         init_runahead();
+         break;
+      case RARCH_CMD_RUNAHEAD_TOGGLE:
+         rarch_main_command(RARCH_CMD_RUNAHEAD_DEINIT);
+         if (g_settings.run_ahead_enable)
+         {
+            rarch_main_command(RARCH_CMD_RUNAHEAD_INIT);
+            /* A new secondary core needs the port devices too. */
+            rarch_main_command(RARCH_CMD_CONTROLLERS_INIT);
+         }
+         break;
       case RARCH_CMD_AUTOSAVE_DEINIT:
 #ifdef HAVE_THREADS
          deinit_autosave();
@@ -2365,6 +2680,8 @@ bool rarch_main_command(unsigned cmd)
       case RARCH_CMD_RECORD_INIT:
          rarch_main_command(RARCH_CMD_HISTORY_DEINIT);
          init_recording();
+         /* The first recorded frame can't be a dupe. */
+         frame_dupe_invalidate(&driver.frame_dupe);
          break;
       case RARCH_CMD_HISTORY_DEINIT:
          if (g_defaults.history)
@@ -2581,6 +2898,20 @@ bool rarch_main_command(unsigned cmd)
 
 #ifdef HAVE_COMMAND
          init_command();
+#endif
+         break;
+      case RARCH_CMD_CONTROL_DEINIT:
+#ifdef HAVE_CONTROL
+         if (driver.control)
+            rarch_control_free(driver.control);
+         driver.control = NULL;
+#endif
+         break;
+      case RARCH_CMD_CONTROL_INIT:
+         rarch_main_command(RARCH_CMD_CONTROL_DEINIT);
+
+#ifdef HAVE_CONTROL
+         init_control();
 #endif
          break;
       case RARCH_CMD_TEMPORARY_CONTENT_DEINIT:
@@ -2648,8 +2979,14 @@ bool rarch_main_command(unsigned cmd)
 
 void rarch_main_deinit(void)
 {
+   /* Before the core goes away, along with its perf counters. */
+   if (*g_extern.benchmark.path)
+      write_benchmark_report();
+   deinit_checkpoints();
+
    rarch_main_command(RARCH_CMD_NETPLAY_DEINIT);
    rarch_main_command(RARCH_CMD_COMMAND_DEINIT);
+   rarch_main_command(RARCH_CMD_CONTROL_DEINIT);
 
    if (g_extern.use_sram)
       rarch_main_command(RARCH_CMD_AUTOSAVE_DEINIT);
@@ -2658,6 +2995,7 @@ void rarch_main_deinit(void)
    rarch_main_command(RARCH_CMD_SAVEFILES);
 
    rarch_main_command(RARCH_CMD_REWIND_DEINIT);
+   rarch_main_command(RARCH_CMD_RUNAHEAD_DEINIT);
    rarch_main_command(RARCH_CMD_CHEATS_DEINIT);
    rarch_main_command(RARCH_CMD_BSV_MOVIE_DEINIT);
 
@@ -0,0 +1,641 @@
+/*  RetroArch - A frontend for libretro.
+ *  Copyright (C) 2010-2014 - Hans-Kristian Arntzen
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "runahead.h"
+#include "general.h"
+#include "dynamic.h"
+#include "retro.h"
+#include "performance.h"
+#include "file_path.h"
+#include "compat/posix_string.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef HAVE_DYNAMIC
+/* A second, independently loaded copy of the core.
+ * The library is copied to a temporary file first, as loading
+ * the same path again would just hand back the main core. */
+struct runahead_core
+{
+   dylib_t lib;
+   char path[PATH_MAX];
+   bool initialized;
+   bool game_loaded;
+
+   void (*retro_init)(void);
+   void (*retro_deinit)(void);
+   void (*retro_set_environment)(retro_environment_t);
+   void (*retro_set_video_refresh)(retro_video_refresh_t);
+   void (*retro_set_audio_sample)(retro_audio_sample_t);
+   void (*retro_set_audio_sample_batch)(retro_audio_sample_batch_t);
+   void (*retro_set_input_poll)(retro_input_poll_t);
+   void (*retro_set_input_state)(retro_input_state_t);
+   void (*retro_set_controller_port_device)(unsigned, unsigned);
+   void (*retro_run)(void);
+   bool (*retro_unserialize)(const void*, size_t);
+   bool (*retro_load_game)(const struct retro_game_info*);
+   bool (*retro_load_game_special)(unsigned,
+         const struct retro_game_info*, size_t);
+   void (*retro_unload_game)(void);
+};
+#endif
+
+struct runahead
+{
+   unsigned frames;
+
+   /* Main core state after the real frame.
+    * Sized once, only grows if the core's state does. */
+   void *state;
+   size_t state_size;
+
+   /* FNV-1a over every input the main core read this frame. */
+   uint32_t input_hash;
+   uint32_t last_input_hash;
+
+   /* Secondary core must be resynced from the main core. */
+   bool dirty;
+   /* Core options as of the last resync. */
+   unsigned options_generation;
+
+#ifdef HAVE_DYNAMIC
+   struct runahead_core *secondary;
+#endif
+};
+
+/* Content as the main core got it, for loading the secondary core. */
+static struct retro_game_info *content_info;
+static size_t content_num_info;
+static bool content_special;
+static unsigned content_special_id;
+static bool content_valid;
+
+/* Core options as of the secondary core's last GET_VARIABLE. */
+static unsigned secondary_options_seen;
+
+static void runahead_video_null(const void *data, unsigned width,
+      unsigned height, size_t pitch)
+{
+   (void)data;
+   (void)width;
+   (void)height;
+   (void)pitch;
+}
+
+static void runahead_audio_null(int16_t left, int16_t right)
+{
+   (void)left;
+   (void)right;
+}
+
+static size_t runahead_audio_batch_null(const int16_t *data, size_t frames)
+{
+   (void)data;
+   return frames;
+}
+
+static void runahead_poll_null(void)
+{
+}
+
+static inline uint32_t runahead_hash(uint32_t hash, uint32_t val)
+{
+   return (hash ^ val) * 16777619u;
+}
+
+static int16_t runahead_input_state(unsigned port, unsigned device,
+      unsigned index, unsigned id)
+{
+   runahead_t *handle = g_extern.runahead;
+   int16_t ret = driver.retro_ctx.state_cb(port, device, index, id);
+
+   if (handle)
+   {
+      handle->input_hash = runahead_hash(handle->input_hash,
+            (port << 24) ^ (device << 16) ^ (index << 8) ^ id);
+      handle->input_hash = runahead_hash(handle->input_hash,
+            (uint16_t)ret);
+   }
+
+   return ret;
+}
+
+static bool runahead_save_state(runahead_t *handle)
+{
+   size_t size;
+   void *state = NULL;
+
+   if (pretro_serialize(handle->state, handle->state_size))
+      return true;
+
+   /* Some cores' state grows, e.g. when a disk is inserted. */
+   size = pretro_serialize_size();
+   if (size <= handle->state_size)
+      return false;
+
+   state = realloc(handle->state, size);
+   if (!state)
+      return false;
+
+   handle->state      = state;
+   handle->state_size = size;
+   return pretro_serialize(handle->state, handle->state_size);
+}
+
+/* The real frame has been run with its video hidden. Show the
+ * previous frame again and stop running ahead. */
+static void runahead_fail(runahead_t *handle)
+{
+   RARCH_ERR("Run-ahead: failed to save core state, disabling run-ahead.\n");
+   handle->frames = 0;
+
+   pretro_set_video_refresh(driver.retro_ctx.frame_cb);
+   driver.retro_ctx.frame_cb(NULL, g_extern.frame_cache.width,
+         g_extern.frame_cache.height, g_extern.frame_cache.pitch);
+}
+
+static void runahead_run_single(runahead_t *handle)
+{
+   unsigned i;
+   bool ret;
+
+   pretro_set_video_refresh(runahead_video_null);
+   pretro_run();
+
+   {
+      RARCH_PERFORMANCE_INIT(runahead_serialize);
+      RARCH_PERFORMANCE_START(runahead_serialize);
+      ret = runahead_save_state(handle);
+      RARCH_PERFORMANCE_STOP(runahead_serialize);
+   }
+
+   if (!ret)
+   {
+      runahead_fail(handle);
+      return;
+   }
+
+   /* Frames ahead only exist to be looked at. */
+   pretro_set_audio_sample(runahead_audio_null);
+   pretro_set_audio_sample_batch(runahead_audio_batch_null);
+   pretro_set_input_poll(runahead_poll_null);
+
+   {
+      RARCH_PERFORMANCE_INIT(runahead_frames);
+      RARCH_PERFORMANCE_START(runahead_frames);
+      for (i = 1; i < handle->frames; i++)
+         pretro_run();
+
+      pretro_set_video_refresh(driver.retro_ctx.frame_cb);
+      pretro_run();
+      RARCH_PERFORMANCE_STOP(runahead_frames);
+   }
+
+   {
+      RARCH_PERFORMANCE_INIT(runahead_unserialize);
+      RARCH_PERFORMANCE_START(runahead_unserialize);
+      pretro_unserialize(handle->state, handle->state_size);
+      RARCH_PERFORMANCE_STOP(runahead_unserialize);
+   }
+
+   pretro_set_input_poll(driver.retro_ctx.poll_cb);
+   retro_set_rewind_callbacks();
+}
+
+#ifdef HAVE_DYNAMIC
+static void runahead_run_secondary(runahead_t *handle)
+{
+   unsigned i;
+   unsigned frames = 1;
+   struct runahead_core *core = handle->secondary;
+
+   handle->input_hash = 2166136261u;
+
+   /* The main core applies changed options on its own, the
+    * secondary core needs to be told and start over from it. */
+   if (g_extern.system.core_options)
+   {
+      unsigned generation = core_option_generation(
+            g_extern.system.core_options);
+      if (generation != handle->options_generation)
+      {
+         handle->options_generation = generation;
+         handle->dirty = true;
+      }
+   }
+
+   pretro_set_video_refresh(runahead_video_null);
+   pretro_run();
+
+   /* With the same input as last frame, the secondary core
+    * is already one frame ahead of where it needs to be. */
+   if (handle->dirty || g_extern.frame_is_reverse ||
+         handle->input_hash != handle->last_input_hash)
+   {
+      bool ret;
+
+      {
+         RARCH_PERFORMANCE_INIT(runahead_serialize);
+         RARCH_PERFORMANCE_START(runahead_serialize);
+         ret = runahead_save_state(handle);
+         RARCH_PERFORMANCE_STOP(runahead_serialize);
+      }
+
+      if (!ret)
+      {
+         runahead_fail(handle);
+         return;
+      }
+
+      {
+         RARCH_PERFORMANCE_INIT(runahead_unserialize);
+         RARCH_PERFORMANCE_START(runahead_unserialize);
+         core->retro_unserialize(handle->state, handle->state_size);
+         RARCH_PERFORMANCE_STOP(runahead_unserialize);
+      }
+
+      frames        = handle->frames;
+      handle->dirty = false;
+   }
+
+   handle->last_input_hash = handle->input_hash;
+   pretro_set_video_refresh(driver.retro_ctx.frame_cb);
+
+   {
+      RARCH_PERFORMANCE_INIT(runahead_frames);
+      RARCH_PERFORMANCE_START(runahead_frames);
+      core->retro_set_video_refresh(runahead_video_null);
+      for (i = 1; i < frames; i++)
+         core->retro_run();
+
+      core->retro_set_video_refresh(driver.retro_ctx.frame_cb);
+      core->retro_run();
+      RARCH_PERFORMANCE_STOP(runahead_frames);
+   }
+}
+
+static bool runahead_environment_cb(unsigned cmd, void *data)
+{
+   core_option_manager_t *opt = g_extern.system.core_options;
+
+   switch (cmd)
+   {
+      /* Queries without side effects are answered
+       * just like for the main core. */
+      case RETRO_ENVIRONMENT_GET_OVERSCAN:
+      case RETRO_ENVIRONMENT_GET_CAN_DUPE:
+      case RETRO_ENVIRONMENT_GET_SYSTEM_DIRECTORY:
+      case RETRO_ENVIRONMENT_GET_LIBRETRO_PATH:
+      case RETRO_ENVIRONMENT_GET_INPUT_DEVICE_CAPABILITIES:
+      case RETRO_ENVIRONMENT_GET_LOG_INTERFACE:
+      case RETRO_ENVIRONMENT_GET_PERF_INTERFACE:
+      case RETRO_ENVIRONMENT_GET_CONTENT_DIRECTORY:
+      case RETRO_ENVIRONMENT_GET_SAVE_DIRECTORY:
+      case RETRO_ENVIRONMENT_GET_USERNAME:
+      case RETRO_ENVIRONMENT_GET_LANGUAGE:
+         return rarch_environment_cb(cmd, data);
+
+      /* Options are shared, but whether they changed is tracked
+       * separately, so neither core hides an update from the other. */
+      case RETRO_ENVIRONMENT_GET_VARIABLE:
+      {
+         struct retro_variable *var = (struct retro_variable*)data;
+         var->value = opt ? core_option_lookup(opt, var->key) : NULL;
+         if (opt)
+            secondary_options_seen = core_option_generation(opt);
+         return true;
+      }
+
+      case RETRO_ENVIRONMENT_GET_VARIABLE_UPDATE:
+         *(bool*)data = opt &&
+            core_option_generation(opt) != secondary_options_seen;
+         return true;
+
+      case RETRO_ENVIRONMENT_SET_PIXEL_FORMAT:
+         return *(const enum retro_pixel_format*)data ==
+            g_extern.system.pix_fmt;
+
+      /* The main core already set these up for both. */
+      case RETRO_ENVIRONMENT_SET_ROTATION:
+      case RETRO_ENVIRONMENT_SET_MESSAGE:
+      case RETRO_ENVIRONMENT_SHUTDOWN:
+      case RETRO_ENVIRONMENT_SET_PERFORMANCE_LEVEL:
+      case RETRO_ENVIRONMENT_SET_INPUT_DESCRIPTORS:
+      case RETRO_ENVIRONMENT_SET_KEYBOARD_CALLBACK:
+      case RETRO_ENVIRONMENT_SET_DISK_CONTROL_INTERFACE:
+      case RETRO_ENVIRONMENT_SET_VARIABLES:
+      case RETRO_ENVIRONMENT_SET_SUPPORT_NO_GAME:
+      case RETRO_ENVIRONMENT_SET_FRAME_TIME_CALLBACK:
+      case RETRO_ENVIRONMENT_SET_SYSTEM_AV_INFO:
+      case RETRO_ENVIRONMENT_SET_SUBSYSTEM_INFO:
+      case RETRO_ENVIRONMENT_SET_CONTROLLER_INFO:
+      case RETRO_ENVIRONMENT_SET_MEMORY_MAPS:
+      case RETRO_ENVIRONMENT_SET_GEOMETRY:
+         return true;
+
+      /* Hardware contexts, audio threads, rumble
+       * and cameras all belong to the main core. */
+      default:
+         return false;
+   }
+}
+
+static void runahead_core_free(struct runahead_core *core)
+{
+   if (!core)
+      return;
+
+   if (core->game_loaded)
+      core->retro_unload_game();
+   if (core->initialized)
+      core->retro_deinit();
+   if (core->lib)
+      dylib_close(core->lib);
+   if (*core->path)
+      remove(core->path);
+
+   free(core);
+}
+
+#define RUNAHEAD_SYM(x) do { \
+   function_t func = dylib_proc(core->lib, #x); \
+   memcpy(&core->x, &func, sizeof(func)); \
+   if (!core->x) \
+   { \
+      RARCH_ERR("Run-ahead: failed to load symbol \"%s\".\n", #x); \
+      goto error; \
+   } \
+} while (0)
+
+static struct runahead_core *runahead_core_new(void)
+{
+   char name[PATH_MAX];
+   const char *dir = NULL;
+   void *buf       = NULL;
+   long size       = 0;
+   struct runahead_core *core = NULL;
+
+   if (!content_valid)
+   {
+      RARCH_ERR("Run-ahead: content was not kept for a secondary core.\n");
+      return NULL;
+   }
+
+   secondary_options_seen = g_extern.system.core_options ?
+      core_option_generation(g_extern.system.core_options) : 0;
+
+   core = (struct runahead_core*)calloc(1, sizeof(*core));
+   if (!core)
+      return NULL;
+
+   if (!(dir = getenv("TMPDIR")) && !(dir = getenv("TEMP")))
+      dir = "/tmp";
+
+   snprintf(name, sizeof(name), "retroarch_runahead_%llx_%s",
+         (unsigned long long)rarch_get_time_usec(),
+         path_basename(g_settings.libretro));
+   fill_pathname_join(core->path, dir, name, sizeof(core->path));
+
+   size = read_file(g_settings.libretro, &buf);
+   if (size < 0 || !write_file(core->path, buf, size))
+   {
+      RARCH_ERR("Run-ahead: could not copy core to \"%s\".\n", core->path);
+      free(buf);
+      *core->path = '\0';
+      goto error;
+   }
+   free(buf);
+
+   core->lib = dylib_load(core->path);
+   if (!core->lib)
+   {
+      RARCH_ERR("Run-ahead: failed to open \"%s\".\n", core->path);
+      goto error;
+   }
+
+   RUNAHEAD_SYM(retro_init);
+   RUNAHEAD_SYM(retro_deinit);
+   RUNAHEAD_SYM(retro_set_environment);
+   RUNAHEAD_SYM(retro_set_video_refresh);
+   RUNAHEAD_SYM(retro_set_audio_sample);
+   RUNAHEAD_SYM(retro_set_audio_sample_batch);
+   RUNAHEAD_SYM(retro_set_input_poll);
+   RUNAHEAD_SYM(retro_set_input_state);
+   RUNAHEAD_SYM(retro_set_controller_port_device);
+   RUNAHEAD_SYM(retro_run);
+   RUNAHEAD_SYM(retro_unserialize);
+   RUNAHEAD_SYM(retro_load_game);
+   RUNAHEAD_SYM(retro_load_game_special);
+   RUNAHEAD_SYM(retro_unload_game);
+
+   core->retro_set_environment(runahead_environment_cb);
+   core->retro_init();
+   core->initialized = true;
+
+   core->retro_set_video_refresh(runahead_video_null);
+   core->retro_set_audio_sample(runahead_audio_null);
+   core->retro_set_audio_sample_batch(runahead_audio_batch_null);
+   core->retro_set_input_poll(runahead_poll_null);
+   core->retro_set_input_state(driver.retro_ctx.state_cb);
+
+   if (content_special)
+      core->game_loaded = core->retro_load_game_special(content_special_id,
+            content_info, content_num_info);
+   else
+      core->game_loaded = core->retro_load_game(content_info);
+
+   if (!core->game_loaded)
+   {
+      RARCH_ERR("Run-ahead: secondary core failed to load content.\n");
+      goto error;
+   }
+
+   RARCH_LOG("Run-ahead: loaded secondary core from \"%s\".\n", core->path);
+   return core;
+
+error:
+   runahead_core_free(core);
+   return NULL;
+}
+#endif
+
+runahead_t *runahead_new(unsigned frames, bool secondary_instance)
+{
+   runahead_t *handle = (runahead_t*)calloc(1, sizeof(*handle));
+   if (!handle)
+      return NULL;
+
+   handle->frames     = frames;
+   handle->dirty      = true;
+   handle->state_size = pretro_serialize_size();
+
+   if (!handle->state_size)
+      goto error;
+
+   handle->state = malloc(handle->state_size);
+   if (!handle->state)
+      goto error;
+
+   if (secondary_instance)
+   {
+#ifdef HAVE_DYNAMIC
+      if (g_extern.system.hw_render_callback.context_type
+            != RETRO_HW_CONTEXT_NONE)
+         RARCH_WARN("Run-ahead: no secondary instance for hardware rendered cores.\n");
+      /* Disk swaps only reach the main core. */
+      else if (g_extern.system.disk_control.get_num_images)
+         RARCH_WARN("Run-ahead: no secondary instance for cores with disk control.\n");
+      else if ((handle->secondary = runahead_core_new()))
+         pretro_set_input_state(runahead_input_state);
+#else
+      RARCH_WARN("Run-ahead: secondary instance needs a dynamically loaded core.\n");
+#endif
+   }
+
+   return handle;
+
+error:
+   runahead_free(handle);
+   return NULL;
+}
+
+void runahead_free(runahead_t *handle)
+{
+   if (!handle)
+      return;
+
+#ifdef HAVE_DYNAMIC
+   if (handle->secondary)
+   {
+      pretro_set_input_state(driver.retro_ctx.state_cb);
+      runahead_core_free(handle->secondary);
+   }
+#endif
+
+   free(handle->state);
+   free(handle);
+}
+
+void runahead_run(runahead_t *handle)
+{
+   /* Movies record and replay every input read,
+    * so each frame has to run exactly once. */
+   if (!handle->frames || g_extern.bsv.movie)
+   {
+      handle->dirty = true;
+      pretro_run();
+      return;
+   }
+
+#ifdef HAVE_DYNAMIC
+   if (handle->secondary)
+   {
+      runahead_run_secondary(handle);
+      return;
+   }
+#endif
+
+   runahead_run_single(handle);
+}
+
+void runahead_invalidate(runahead_t *handle)
+{
+   if (handle)
+      handle->dirty = true;
+}
+
+void runahead_set_controller_port_device(runahead_t *handle,
+      unsigned port, unsigned device)
+{
+#ifdef HAVE_DYNAMIC
+   if (handle && handle->secondary)
+   {
+      handle->secondary->retro_set_controller_port_device(port, device);
+      handle->dirty = true;
+   }
+#else
+   (void)handle;
+   (void)port;
+   (void)device;
+#endif
+}
+
+void runahead_free_content(void)
+{
+   size_t i;
+
+   for (i = 0; i < content_num_info; i++)
+   {
+      free((void*)content_info[i].path);
+      free((void*)content_info[i].data);
+      free((void*)content_info[i].meta);
+   }
+   free(content_info);
+
+   content_info       = NULL;
+   content_num_info   = 0;
+   content_special    = false;
+   content_special_id = 0;
+   content_valid      = false;
+}
+
+void runahead_set_content(const struct retro_game_info *info,
+      size_t num_info, bool special, unsigned special_id)
+{
+   size_t i;
+
+   runahead_free_content();
+
+   content_special    = special;
+   content_special_id = special_id;
+
+   if (!info)
+   {
+      content_valid = true;
+      return;
+   }
+
+   content_info = (struct retro_game_info*)
+      calloc(num_info, sizeof(*content_info));
+   if (!content_info)
+      return;
+   content_num_info = num_info;
+
+   for (i = 0; i < num_info; i++)
+   {
+      void *data = NULL;
+
+      if (info[i].path && !(content_info[i].path = strdup(info[i].path)))
+         goto error;
+      if (info[i].meta && !(content_info[i].meta = strdup(info[i].meta)))
+         goto error;
+
+      if (info[i].data)
+      {
+         if (!(data = malloc(info[i].size)))
+            goto error;
+         memcpy(data, info[i].data, info[i].size);
+      }
+      content_info[i].data = data;
+      content_info[i].size = info[i].size;
+   }
+
+   content_valid = true;
+   return;
+
+error:
+   runahead_free_content();
+}
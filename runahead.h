@@ -0,0 +1,66 @@
+/*  RetroArch - A frontend for libretro.
+ *  Copyright (C) 2010-2014 - Hans-Kristian Arntzen
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __RARCH_RUNAHEAD_H
+#define __RARCH_RUNAHEAD_H
+
+#include <stddef.h>
+#include "boolean.h"
+#include "libretro.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Run-ahead hides the core's internal input lag.
+ *
+ * Every displayed frame, the real frame is run with video hidden,
+ * then the core is run a number of frames further with the same
+ * input, and only the last of those is shown.
+ *
+ * With a single instance the core is saved after the real frame and
+ * restored after the frames ahead. With a secondary instance, a second
+ * copy of the core runs ahead instead. It is only resynced from the
+ * main core when input changes, so usually no state is copied. */
+typedef struct runahead runahead_t;
+
+runahead_t *runahead_new(unsigned frames, bool secondary_instance);
+
+void runahead_free(runahead_t *handle);
+
+/* Runs the core for one displayed frame. */
+void runahead_run(runahead_t *handle);
+
+/* Call when the main core's state changed outside of
+ * runahead_run(), e.g. on state load or reset. */
+void runahead_invalidate(runahead_t *handle);
+
+/* Mirrors retro_set_controller_port_device() to the secondary core. */
+void runahead_set_controller_port_device(runahead_t *handle,
+      unsigned port, unsigned device);
+
+/* Keeps a copy of the content the core was loaded with, for the
+ * secondary core. NULL info means the core runs without content. */
+void runahead_set_content(const struct retro_game_info *info,
+      size_t num_info, bool special, unsigned special_id);
+
+void runahead_free_content(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
+
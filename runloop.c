@@ -181,6 +181,24 @@ static void check_stateslots(bool pressed_increase, bool pressed_decrease)
    RARCH_LOG("%s\n", msg);
 }
 
+/* Save states are written in the background,
+ * so failures only show up later. */
+static void check_state_writer(void)
+{
+   char path[PATH_MAX], msg[PATH_MAX + 32];
+
+   if (!savestate_writer_failed(g_extern.state_writer, path, sizeof(path)))
+      return;
+
+   snprintf(msg, sizeof(msg), "Failed to save state to \"%s\".", path);
+
+   if (g_extern.msg_queue)
+   {
+      msg_queue_clear(g_extern.msg_queue);
+      msg_queue_push(g_extern.msg_queue, msg, 2, 180);
+   }
+}
+
 static inline void setup_rewind_audio(void)
 {
    unsigned i;
@@ -706,6 +724,16 @@ int rarch_main_iterate(void)
    if (driver.flushing_input)
       driver.flushing_input = (input) ? input_flush(&input) : false;
 
+   g_extern.frame_input = input;
+
+#ifdef HAVE_CONTROL
+   if (driver.control)
+      rarch_control_frame(driver.control);
+#endif
+
+   if (g_extern.state_writer)
+      check_state_writer();
+
    trigger_input = input & ~old_input;
 
    if (time_to_exit(input))
@@ -750,7 +778,12 @@ int rarch_main_iterate(void)
 
 #ifdef HAVE_NETPLAY
    if (driver.netplay_data)
+   {
+      RARCH_PERFORMANCE_INIT(netplay_pre);
+      RARCH_PERFORMANCE_START(netplay_pre);
       netplay_pre_frame((netplay_t*)driver.netplay_data);
+      RARCH_PERFORMANCE_STOP(netplay_pre);
+   }
 #endif
 
    if (g_extern.bsv.movie)
@@ -776,7 +809,15 @@ int rarch_main_iterate(void)
 
 
    /* Run libretro for one frame. */
-   pretro_run();
+   {
+      RARCH_PERFORMANCE_INIT(core_run);
+      RARCH_PERFORMANCE_START(core_run);
+      if (g_extern.runahead)
+         runahead_run(g_extern.runahead);
+      else
+         pretro_run();
+      RARCH_PERFORMANCE_STOP(core_run);
+   }
 
    for (i = 0; i < MAX_PLAYERS; i++)
    {
@@ -790,9 +831,17 @@ int rarch_main_iterate(void)
    if (g_extern.bsv.movie)
       bsv_movie_set_frame_end(g_extern.bsv.movie);
 
+   if (g_extern.checkpoint.file)
+      rarch_main_checkpoint();
+
 #ifdef HAVE_NETPLAY
    if (driver.netplay_data)
+   {
+      RARCH_PERFORMANCE_INIT(netplay_post);
+      RARCH_PERFORMANCE_START(netplay_post);
       netplay_post_frame((netplay_t*)driver.netplay_data);
+      RARCH_PERFORMANCE_STOP(netplay_post);
+   }
 #endif
 
 #if defined(HAVE_THREADS)
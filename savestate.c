@@ -0,0 +1,481 @@
+/*  RetroArch - A frontend for libretro.
+ *  Copyright (C) 2010-2014 - Hans-Kristian Arntzen
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "savestate.h"
+#include "general.h"
+#include "dynamic.h"
+#include "file_path.h"
+#include "endianness.h"
+#include "performance.h"
+#include "compat/strl.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef HAVE_THREADS
+#include "thread.h"
+#endif
+
+#ifdef HAVE_ZLIB
+#include <zlib.h>
+#endif
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+#define SAVESTATE_CHUNK_SIZE (128 * 1024)
+
+struct savestate_writer
+{
+   void *buffer[2];
+   size_t capacity[2];
+   /* Buffer the main thread serializes into next. */
+   unsigned current;
+
+   /* The queued write. Owned by the thread while busy is set. */
+   char path[PATH_MAX];
+   const void *data;
+   size_t size;
+   bool compress;
+   bool busy;
+
+   uint8_t *chunk;
+
+   char failed_path[PATH_MAX];
+   volatile bool failed;
+
+#ifdef HAVE_THREADS
+   bool quit;
+   slock_t *lock;
+   scond_t *cond;
+   sthread_t *thread;
+#endif
+};
+
+static void savestate_write_le32(uint8_t *out, uint32_t val)
+{
+   val = swap_if_big32(val);
+   memcpy(out, &val, sizeof(val));
+}
+
+static uint32_t savestate_read_le32(const uint8_t *in)
+{
+   uint32_t val;
+   memcpy(&val, in, sizeof(val));
+   return swap_if_big32(val);
+}
+
+#ifdef HAVE_ZLIB_DEFLATE
+/* Compresses in chunks, so the compressed state is never
+ * held in memory as a whole. */
+static bool savestate_deflate(savestate_writer_t *handle, FILE *file)
+{
+   int ret;
+   z_stream stream = {0};
+
+   if (deflateInit(&stream, Z_BEST_SPEED) != Z_OK)
+      return false;
+
+   stream.next_in  = (Bytef*)handle->data;
+   stream.avail_in = handle->size;
+
+   do
+   {
+      size_t have;
+
+      stream.next_out  = handle->chunk;
+      stream.avail_out = SAVESTATE_CHUNK_SIZE;
+
+      ret  = deflate(&stream, Z_FINISH);
+      have = SAVESTATE_CHUNK_SIZE - stream.avail_out;
+
+      if (ret == Z_STREAM_ERROR
+            || fwrite(handle->chunk, 1, have, file) != have)
+      {
+         ret = Z_STREAM_ERROR;
+         break;
+      }
+   } while (ret != Z_STREAM_END);
+
+   deflateEnd(&stream);
+   return ret == Z_STREAM_END;
+}
+#endif
+
+static bool savestate_write(savestate_writer_t *handle)
+{
+   char tmp_path[PATH_MAX];
+   long written = 0;
+   bool ret = false;
+   retro_time_t start = rarch_get_time_usec();
+   FILE *file;
+
+   if (snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", handle->path)
+         >= (int)sizeof(tmp_path))
+   {
+      RARCH_ERR("Savestate path \"%s\" is too long.\n", handle->path);
+      return false;
+   }
+
+   if (!(file = fopen(tmp_path, "wb")))
+   {
+      RARCH_ERR("Failed to open \"%s\" for writing.\n", tmp_path);
+      return false;
+   }
+
+#ifdef HAVE_ZLIB_DEFLATE
+   if (handle->compress)
+   {
+      uint8_t header[SAVESTATE_HEADER_SIZE];
+
+      memcpy(header, SAVESTATE_MAGIC, 8);
+      savestate_write_le32(header +  8, SAVESTATE_VERSION);
+      savestate_write_le32(header + 12, SAVESTATE_CODEC_DEFLATE);
+      savestate_write_le32(header + 16, handle->size);
+      savestate_write_le32(header + 20, 0);
+
+      ret = fwrite(header, 1, sizeof(header), file) == sizeof(header)
+         && savestate_deflate(handle, file);
+   }
+   else
+#endif
+      ret = fwrite(handle->data, 1, handle->size, file) == handle->size;
+
+   written = ftell(file);
+   ret = fflush(file) == 0 && ret;
+   /* Make sure the new state is on disk before it replaces the old one. */
+#ifdef _WIN32
+   ret = ret && _commit(_fileno(file)) == 0;
+#else
+   ret = ret && fsync(fileno(file)) == 0;
+#endif
+   ret = fclose(file) == 0 && ret;
+
+#ifdef _WIN32
+   if (ret)
+      remove(handle->path);
+#endif
+   ret = ret && rename(tmp_path, handle->path) == 0;
+
+   if (!ret)
+   {
+      remove(tmp_path);
+      RARCH_ERR("Failed to write state to \"%s\".\n", handle->path);
+      return false;
+   }
+
+   RARCH_LOG("Wrote state to \"%s\" in %.1f ms (%u -> %ld bytes).\n",
+         handle->path, (rarch_get_time_usec() - start) / 1000.0,
+         (unsigned)handle->size, written);
+   return true;
+}
+
+static void savestate_writer_done(savestate_writer_t *handle, bool ret)
+{
+   if (!ret)
+   {
+      strlcpy(handle->failed_path, handle->path,
+            sizeof(handle->failed_path));
+      handle->failed = true;
+   }
+   handle->busy = false;
+}
+
+#ifdef HAVE_THREADS
+static void savestate_thread(void *data)
+{
+   savestate_writer_t *handle = (savestate_writer_t*)data;
+
+   slock_lock(handle->lock);
+
+   for (;;)
+   {
+      bool ret;
+
+      while (!handle->busy && !handle->quit)
+         scond_wait(handle->cond, handle->lock);
+
+      /* A queued write is finished before quitting. */
+      if (!handle->busy)
+         break;
+
+      slock_unlock(handle->lock);
+      ret = savestate_write(handle);
+      slock_lock(handle->lock);
+
+      savestate_writer_done(handle, ret);
+      scond_signal(handle->cond);
+   }
+
+   slock_unlock(handle->lock);
+}
+#endif
+
+savestate_writer_t *savestate_writer_new(void)
+{
+   savestate_writer_t *handle = (savestate_writer_t*)
+      calloc(1, sizeof(*handle));
+   if (!handle)
+      return NULL;
+
+   handle->chunk = (uint8_t*)malloc(SAVESTATE_CHUNK_SIZE);
+   if (!handle->chunk)
+      goto error;
+
+#ifdef HAVE_THREADS
+   handle->lock = slock_new();
+   handle->cond = scond_new();
+   if (!handle->lock || !handle->cond)
+      goto error;
+
+   handle->thread = sthread_create(savestate_thread, handle);
+   if (!handle->thread)
+      goto error;
+#endif
+
+   return handle;
+
+error:
+#ifdef HAVE_THREADS
+   if (handle->lock)
+      slock_free(handle->lock);
+   if (handle->cond)
+      scond_free(handle->cond);
+#endif
+   free(handle->chunk);
+   free(handle);
+   return NULL;
+}
+
+void savestate_writer_free(savestate_writer_t *handle)
+{
+   if (!handle)
+      return;
+
+#ifdef HAVE_THREADS
+   slock_lock(handle->lock);
+   handle->quit = true;
+   scond_signal(handle->cond);
+   slock_unlock(handle->lock);
+   sthread_join(handle->thread);
+
+   slock_free(handle->lock);
+   scond_free(handle->cond);
+#endif
+
+   free(handle->buffer[0]);
+   free(handle->buffer[1]);
+   free(handle->chunk);
+   free(handle);
+}
+
+void *savestate_writer_buffer(savestate_writer_t *handle, size_t size)
+{
+   unsigned i = handle->current;
+
+   /* The thread only ever uses the other buffer. */
+   if (size > handle->capacity[i])
+   {
+      void *buffer = realloc(handle->buffer[i], size);
+      if (!buffer)
+         return NULL;
+
+      handle->buffer[i]   = buffer;
+      handle->capacity[i] = size;
+   }
+
+   return handle->buffer[i];
+}
+
+bool savestate_writer_submit(savestate_writer_t *handle,
+      const char *path, size_t size, bool compress)
+{
+   unsigned i = handle->current;
+
+   if (size > handle->capacity[i])
+      return false;
+
+#ifndef HAVE_ZLIB_DEFLATE
+   compress = false;
+#endif
+
+#ifdef HAVE_THREADS
+   slock_lock(handle->lock);
+   while (handle->busy)
+      scond_wait(handle->cond, handle->lock);
+#endif
+
+   strlcpy(handle->path, path, sizeof(handle->path));
+   handle->data     = handle->buffer[i];
+   handle->size     = size;
+   handle->compress = compress;
+   handle->busy     = true;
+   handle->current  = !i;
+
+#ifdef HAVE_THREADS
+   scond_signal(handle->cond);
+   slock_unlock(handle->lock);
+   return true;
+#else
+   {
+      bool ret = savestate_write(handle);
+      savestate_writer_done(handle, ret);
+      return ret;
+   }
+#endif
+}
+
+void savestate_writer_flush(savestate_writer_t *handle)
+{
+#ifdef HAVE_THREADS
+   slock_lock(handle->lock);
+   while (handle->busy)
+      scond_wait(handle->cond, handle->lock);
+   slock_unlock(handle->lock);
+#else
+   (void)handle;
+#endif
+}
+
+bool savestate_writer_failed(savestate_writer_t *handle,
+      char *path, size_t size)
+{
+   if (!handle->failed)
+      return false;
+
+#ifdef HAVE_THREADS
+   slock_lock(handle->lock);
+#endif
+   if (path)
+      strlcpy(path, handle->failed_path, size);
+   handle->failed = false;
+#ifdef HAVE_THREADS
+   slock_unlock(handle->lock);
+#endif
+
+   return true;
+}
+
+#ifdef HAVE_ZLIB
+/* Inflates straight from the mapped file into the state buffer. */
+static bool savestate_inflate(struct savestate_data *state, size_t size)
+{
+   bool ret;
+   z_stream stream = {0};
+   void *out;
+
+   /* The header is untrusted, don't let it pick the allocation. */
+   if (size != pretro_serialize_size())
+   {
+      RARCH_ERR("Compressed state is %u bytes, core expects %u.\n",
+            (unsigned)size, (unsigned)pretro_serialize_size());
+      return false;
+   }
+
+   if (!(out = malloc(size ? size : 1)))
+      return false;
+
+   stream.next_in   = (Bytef*)state->data + SAVESTATE_HEADER_SIZE;
+   stream.avail_in  = state->size - SAVESTATE_HEADER_SIZE;
+   stream.next_out  = (Bytef*)out;
+   stream.avail_out = size;
+
+   if (inflateInit(&stream) != Z_OK)
+   {
+      free(out);
+      return false;
+   }
+
+   ret = inflate(&stream, Z_FINISH) == Z_STREAM_END
+      && stream.total_out == size;
+   inflateEnd(&stream);
+
+   if (!ret)
+   {
+      free(out);
+      return false;
+   }
+
+   file_map_close(&state->file);
+
+   state->buf  = out;
+   state->data = out;
+   state->size = size;
+   return true;
+}
+#endif
+
+bool savestate_open(struct savestate_data *state, const char *path)
+{
+   const uint8_t *header;
+
+   memset(state, 0, sizeof(*state));
+
+   if (!file_map_open(&state->file, path, true))
+      return false;
+
+   state->data = state->file.data;
+   state->size = state->file.size;
+
+   header = (const uint8_t*)state->data;
+
+   /* No header, a raw state. */
+   if (state->size < SAVESTATE_HEADER_SIZE
+         || memcmp(header, SAVESTATE_MAGIC, 8))
+      return true;
+
+   if (savestate_read_le32(header + 8) != SAVESTATE_VERSION)
+   {
+      RARCH_ERR("Unsupported state version %u.\n",
+            (unsigned)savestate_read_le32(header + 8));
+      goto error;
+   }
+
+   switch (savestate_read_le32(header + 12))
+   {
+      case SAVESTATE_CODEC_NONE:
+         state->data = header + SAVESTATE_HEADER_SIZE;
+         state->size = state->size - SAVESTATE_HEADER_SIZE;
+         return true;
+
+      case SAVESTATE_CODEC_DEFLATE:
+#ifdef HAVE_ZLIB
+         if (savestate_inflate(state, savestate_read_le32(header + 16)))
+            return true;
+         RARCH_ERR("Compressed state is corrupt.\n");
+#else
+         RARCH_ERR("Compressed states are not supported in this build.\n");
+#endif
+         break;
+
+      default:
+         RARCH_ERR("Unknown state compression.\n");
+         break;
+   }
+
+error:
+   savestate_close(state);
+   return false;
+}
+
+void savestate_close(struct savestate_data *state)
+{
+   file_map_close(&state->file);
+   free(state->buf);
+   memset(state, 0, sizeof(*state));
+}
@@ -0,0 +1,94 @@
+/*  RetroArch - A frontend for libretro.
+ *  Copyright (C) 2010-2014 - Hans-Kristian Arntzen
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __RARCH_SAVESTATE_H
+#define __RARCH_SAVESTATE_H
+
+#include <stddef.h>
+#include "boolean.h"
+#include "file_map.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Compressed states start with a 24 byte header:
+ * magic, version, codec, uncompressed size and a reserved word,
+ * all little endian. Uncompressed states are written without a header
+ * so older versions and other tools can still read them, and files
+ * without the magic are always loaded as raw states. */
+#define SAVESTATE_MAGIC "RASTATE\0"
+#define SAVESTATE_VERSION 1
+#define SAVESTATE_HEADER_SIZE 24
+
+enum savestate_codec
+{
+   SAVESTATE_CODEC_NONE = 0,
+   SAVESTATE_CODEC_DEFLATE
+};
+
+/* Writes states on a background thread.
+ *
+ * The state is serialized on the main thread into a buffer owned by
+ * the writer, then compressed and written to "<path>.tmp" by the thread,
+ * which renames it over the old file once it is complete. A crash
+ * half way through a write leaves the old state intact.
+ *
+ * Two buffers are kept, so the next state can be serialized while the
+ * previous one is still being written. */
+typedef struct savestate_writer savestate_writer_t;
+
+savestate_writer_t *savestate_writer_new(void);
+
+/* Waits for the pending write before freeing. */
+void savestate_writer_free(savestate_writer_t *handle);
+
+/* Returns a buffer of at least size bytes to serialize into. */
+void *savestate_writer_buffer(savestate_writer_t *handle, size_t size);
+
+/* Queues the buffer for writing to path. Only waits if the previous
+ * write has not finished yet. */
+bool savestate_writer_submit(savestate_writer_t *handle,
+      const char *path, size_t size, bool compress);
+
+/* Waits until all queued writes are on disk. */
+void savestate_writer_flush(savestate_writer_t *handle);
+
+/* Returns true once for every failed write, with its path in path.
+ * Does not wait. */
+bool savestate_writer_failed(savestate_writer_t *handle,
+      char *path, size_t size);
+
+/* A state read for unserializing. Uncompressed states are mapped and
+ * used in place, compressed states are inflated straight from the
+ * mapping into a single buffer. */
+struct savestate_data
+{
+   const void *data;
+   size_t size;
+
+   file_map_t file;
+   void *buf;
+};
+
+bool savestate_open(struct savestate_data *state, const char *path);
+
+void savestate_close(struct savestate_data *state);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -346,6 +346,7 @@ static void config_set_defaults(void)
    g_settings.video.black_frame_insertion = black_frame_insertion;
    g_settings.video.swap_interval = swap_interval;
    g_settings.video.threaded = video_threaded;
+   g_settings.video.frame_dupe_detect = frame_dupe_detect;
 
    if (g_defaults.settings.video_threaded_enable != video_threaded)
       g_settings.video.threaded = g_defaults.settings.video_threaded_enable;
@@ -383,6 +384,8 @@ static void config_set_defaults(void)
 
    g_settings.video.post_filter_record = post_filter_record;
    g_settings.video.gpu_record = gpu_record;
+   strlcpy(g_settings.video.record_backpressure, record_backpressure,
+         sizeof(g_settings.video.record_backpressure));
    g_settings.video.gpu_screenshot = gpu_screenshot;
    g_settings.video.rotation = ORIENTATION_NORMAL;
 
@@ -407,6 +410,9 @@ static void config_set_defaults(void)
    g_settings.rewind_enable = rewind_enable;
    g_settings.rewind_buffer_size = rewind_buffer_size;
    g_settings.rewind_granularity = rewind_granularity;
+   g_settings.run_ahead_enable = run_ahead_enable;
+   g_settings.run_ahead_frames = run_ahead_frames;
+   g_settings.run_ahead_secondary_instance = run_ahead_secondary_instance;
    g_settings.slowmotion_ratio = slowmotion_ratio;
    g_settings.fastforward_ratio = fastforward_ratio;
    g_settings.fastforward_ratio_throttle_enable = fastforward_ratio_throttle_enable;
@@ -417,9 +423,14 @@ static void config_set_defaults(void)
    g_settings.savestate_auto_index = savestate_auto_index;
    g_settings.savestate_auto_save  = savestate_auto_save;
    g_settings.savestate_auto_load  = savestate_auto_load;
+   g_settings.savestate_compression = savestate_compression;
+   g_settings.movie_keyframe_interval = movie_keyframe_interval;
    g_settings.network_cmd_enable   = network_cmd_enable;
    g_settings.network_cmd_port     = network_cmd_port;
    g_settings.stdin_cmd_enable     = stdin_cmd_enable;
+   g_settings.control_socket_enable = control_socket_enable;
+   g_settings.control_socket_port  = control_socket_port;
+   *g_settings.control_socket_path = '\0';
    g_settings.content_history_size    = default_content_history_size;
    g_settings.libretro_log_level   = libretro_log_level;
 
@@ -498,6 +509,7 @@ static void config_set_defaults(void)
    *g_settings.screenshot_directory = '\0';
    *g_settings.system_directory = '\0';
    *g_settings.extraction_directory = '\0';
+   *g_settings.patch_cache_directory = '\0';
    *g_settings.input.autoconfig_dir = '\0';
    *g_settings.input.overlay = '\0';
    *g_settings.content_directory = '\0';
@@ -876,6 +888,7 @@ static bool config_load_file(const char *path, bool set_defaults)
    g_settings.video.swap_interval = max(g_settings.video.swap_interval, 1);
    g_settings.video.swap_interval = min(g_settings.video.swap_interval, 4);
    CONFIG_GET_BOOL(video.threaded, "video_threaded");
+   CONFIG_GET_BOOL(video.frame_dupe_detect, "video_frame_dupe_detect");
    CONFIG_GET_BOOL(video.shared_context, "video_shared_context");
 #ifdef GEKKO
    CONFIG_GET_INT(video.viwidth, "video_viwidth");
@@ -945,6 +958,7 @@ static bool config_load_file(const char *path, bool set_defaults)
 
    CONFIG_GET_BOOL(video.post_filter_record, "video_post_filter_record");
    CONFIG_GET_BOOL(video.gpu_record, "video_gpu_record");
+   CONFIG_GET_STRING(video.record_backpressure, "video_record_backpressure");
    CONFIG_GET_BOOL(video.gpu_screenshot, "video_gpu_screenshot");
 
    CONFIG_GET_PATH(video.shader_dir, "video_shader_dir");
@@ -1042,6 +1056,7 @@ static bool config_load_file(const char *path, bool set_defaults)
 
    CONFIG_GET_PATH(resampler_directory, "resampler_directory");
    CONFIG_GET_PATH(extraction_directory, "extraction_directory");
+   CONFIG_GET_PATH(patch_cache_directory, "patch_cache_directory");
    CONFIG_GET_PATH(content_directory, "content_directory");
    CONFIG_GET_PATH(assets_directory, "assets_directory");
    CONFIG_GET_PATH(playlist_directory, "playlist_directory");
@@ -1066,6 +1081,7 @@ static bool config_load_file(const char *path, bool set_defaults)
       CONFIG_GET_BOOL_EXTERN(verbosity, "log_verbosity");
 
    CONFIG_GET_BOOL_EXTERN(perfcnt_enable, "perfcnt_enable");
+   CONFIG_GET_PATH_EXTERN(perfcnt_trace_path, "perfcnt_trace_path");
 
 #ifdef HAVE_OVERLAY
    CONFIG_GET_PATH_EXTERN(overlay_dir, "overlay_directory");
@@ -1084,6 +1100,11 @@ static bool config_load_file(const char *path, bool set_defaults)
       g_settings.rewind_buffer_size = buffer_size * UINT64_C(1000000);
 
    CONFIG_GET_INT(rewind_granularity, "rewind_granularity");
+
+   CONFIG_GET_BOOL(run_ahead_enable, "run_ahead_enable");
+   CONFIG_GET_INT(run_ahead_frames, "run_ahead_frames");
+   CONFIG_GET_BOOL(run_ahead_secondary_instance,
+         "run_ahead_secondary_instance");
    CONFIG_GET_FLOAT(slowmotion_ratio, "slowmotion_ratio");
    if (g_settings.slowmotion_ratio < 1.0f)
       g_settings.slowmotion_ratio = 1.0f;
@@ -1107,10 +1128,15 @@ static bool config_load_file(const char *path, bool set_defaults)
    CONFIG_GET_BOOL(savestate_auto_index, "savestate_auto_index");
    CONFIG_GET_BOOL(savestate_auto_save, "savestate_auto_save");
    CONFIG_GET_BOOL(savestate_auto_load, "savestate_auto_load");
+   CONFIG_GET_BOOL(savestate_compression, "savestate_compression");
+   CONFIG_GET_INT(movie_keyframe_interval, "movie_keyframe_interval");
 
    CONFIG_GET_BOOL(network_cmd_enable, "network_cmd_enable");
    CONFIG_GET_INT(network_cmd_port, "network_cmd_port");
    CONFIG_GET_BOOL(stdin_cmd_enable, "stdin_cmd_enable");
+   CONFIG_GET_BOOL(control_socket_enable, "control_socket_enable");
+   CONFIG_GET_INT(control_socket_port, "control_socket_port");
+   CONFIG_GET_PATH(control_socket_path, "control_socket_path");
 
    if (g_settings.playlist_directory[0] != '\0')
       fill_pathname_join(g_settings.content_history_path,
@@ -1517,6 +1543,10 @@ bool config_save_file(const char *path)
    config_set_bool(conf,  "audio_sync",    g_settings.audio.sync);
    config_set_int(conf,   "audio_block_frames", g_settings.audio.block_frames);
    config_set_int(conf,   "rewind_granularity", g_settings.rewind_granularity);
+   config_set_bool(conf,  "run_ahead_enable", g_settings.run_ahead_enable);
+   config_set_int(conf,   "run_ahead_frames", g_settings.run_ahead_frames);
+   config_set_bool(conf,  "run_ahead_secondary_instance",
+         g_settings.run_ahead_secondary_instance);
    config_set_path(conf,  "video_shader", g_settings.video.shader_path);
    config_set_bool(conf,  "video_shader_enable",
          g_settings.video.shader_enable);
@@ -1533,6 +1563,8 @@ bool config_save_file(const char *path)
 #endif
    config_set_bool(conf,  "video_smooth", g_settings.video.smooth);
    config_set_bool(conf,  "video_threaded", g_settings.video.threaded);
+   config_set_bool(conf,  "video_frame_dupe_detect",
+         g_settings.video.frame_dupe_detect);
    config_set_bool(conf,  "video_shared_context",
          g_settings.video.shared_context);
    config_set_bool(conf,  "video_force_srgb_disable",
@@ -1588,6 +1620,8 @@ bool config_save_file(const char *path)
          g_settings.system_directory : "default");
    config_set_path(conf, "extraction_directory",
          g_settings.extraction_directory);
+   config_set_path(conf, "patch_cache_directory",
+         g_settings.patch_cache_directory);
    config_set_path(conf, "resampler_directory",
          g_settings.resampler_directory);
    config_set_string(conf, "audio_resampler", g_settings.audio.resampler);
@@ -1677,6 +1711,10 @@ bool config_save_file(const char *path)
          g_settings.savestate_auto_save);
    config_set_bool(conf, "savestate_auto_load",
          g_settings.savestate_auto_load);
+   config_set_bool(conf, "savestate_compression",
+         g_settings.savestate_compression);
+   config_set_int(conf, "movie_keyframe_interval",
+         g_settings.movie_keyframe_interval);
 
    config_set_float(conf, "fastforward_ratio", g_settings.fastforward_ratio);
    config_set_bool(conf, "fastforward_ratio_throttle_enable", g_settings.fastforward_ratio_throttle_enable);
@@ -1727,6 +1765,7 @@ bool config_save_file(const char *path)
    config_set_int(conf, "libretro_log_level", g_settings.libretro_log_level);
    config_set_bool(conf, "log_verbosity", g_extern.verbosity);
    config_set_bool(conf, "perfcnt_enable", g_extern.perfcnt_enable);
+   config_set_path(conf, "perfcnt_trace_path", g_extern.perfcnt_trace_path);
 
    ret = config_file_write(conf, path);
    config_file_free(conf);
@@ -19,6 +19,7 @@
 #include "input/input_common.h"
 #include "config.def.h"
 #include "retroarch_logger.h"
+#include "hash.h"
 
 #ifdef APPLE
 #include "input/apple_keycode.h"
@@ -380,24 +381,102 @@ bool setting_data_save_config(rarch_setting_t* settings,
    return true;
 }
 
+struct setting_index
+{
+   const rarch_setting_t *list;
+   /* See hash_bucket(). */
+   uint32_t *slots;
+   uint32_t mask;
+};
+
+/* Name lookup for the lists handed out by setting_data_get_list()
+ * and setting_data_get_mainmenu(). */
+static struct setting_index setting_list_index;
+static struct setting_index setting_mainmenu_index;
+
+static void setting_index_free(struct setting_index *index)
+{
+   free(index->slots);
+   index->list  = NULL;
+   index->slots = NULL;
+   index->mask  = 0;
+}
+
+/* Only settings and groups can be found by name. Names already in
+ * the index keep their entry, so the first one in the list wins. */
+static void setting_index_build(struct setting_index *index,
+      const rarch_setting_t *list)
+{
+   size_t i, count = 0, size = 16;
+
+   setting_index_free(index);
+
+   for (i = 0; list[i].type != ST_NONE; i++)
+      count++;
+   while (size < count * 2)
+      size <<= 1;
+
+   index->slots = (uint32_t*)calloc(size, sizeof(*index->slots));
+   if (!index->slots)
+      return;
+
+   index->list = list;
+   index->mask = size - 1;
+
+   for (i = 0; i < count; i++)
+   {
+      uint32_t slot;
+
+      if (list[i].type > ST_GROUP || !list[i].name)
+         continue;
+
+      for (slot = hash_bucket(djb2_calculate(list[i].name), index->mask);
+            index->slots[slot]; slot = (slot + 1) & index->mask)
+         if (!strcmp(list[index->slots[slot] - 1].name, list[i].name))
+            break;
+
+      if (!index->slots[slot])
+         index->slots[slot] = i + 1;
+   }
+}
+
+static rarch_setting_t *setting_index_find(
+      const struct setting_index *index, const char *name)
+{
+   uint32_t slot;
+
+   for (slot = hash_bucket(djb2_calculate(name), index->mask);
+         index->slots[slot]; slot = (slot + 1) & index->mask)
+   {
+      const rarch_setting_t *setting = &index->list[index->slots[slot] - 1];
+      if (!strcmp(setting->name, name))
+         return (rarch_setting_t*)setting;
+   }
+
+   return NULL;
+}
+
 rarch_setting_t* setting_data_find_setting(rarch_setting_t* setting,
       const char* name)
 {
-   bool found = false;
-
    if (!setting || !name)
       return NULL;
 
-   for (; setting->type != ST_NONE; setting++)
+   if (setting == setting_list_index.list)
+      setting = setting_index_find(&setting_list_index, name);
+   else if (setting == setting_mainmenu_index.list)
+      setting = setting_index_find(&setting_mainmenu_index, name);
+   else
    {
-      if (setting->type <= ST_GROUP && !strcmp(setting->name, name))
-      {
-         found = true;
-         break;
-      }
+      for (; setting->type != ST_NONE; setting++)
+         if (setting->type <= ST_GROUP && !strcmp(setting->name, name))
+            break;
+
+      if (setting->type == ST_NONE)
+         setting = NULL;
    }
 
-   if (!found)
+   if (!setting)
       return NULL;
 
    if (setting->short_description && setting->short_description[0] == '\0')
@@ -788,10 +867,719 @@ rarch_setting_t setting_data_bind_setting(const char* name,
    return result;
 }
 
+struct setting_description
+{
+   const char *label;
+   const char *text;
+};
+
+/* Help texts that don't depend on the current settings. */
+static const struct setting_description setting_descriptions[] = {
+   { "load_content",
+      " -- Load Content. \n"
+      "Browse for content. \n"
+      " \n"
+      "To load content, you need a \n"
+      "libretro core to use, and a \n"
+      "content file. \n"
+      " \n"
+      "To control where the menu starts \n"
+      " to browse for content, set  \n"
+      "Browser Directory. If not set,  \n"
+      "it will start in root. \n"
+      " \n"
+      "The browser will filter out \n"
+      "extensions for the last core set \n"
+      "in 'Core', and use that core when \n"
+      "content is loaded." },
+   { "core_list",
+      " -- Core Selection. \n"
+      " \n"
+      "Browse for a libretro core \n"
+      "implementation. Where the browser \n"
+      "starts depends on your Core Directory \n"
+      "path. If blank, it will start in root. \n"
+      " \n"
+      "If Core Directory is a directory, the menu \n"
+      "will use that as top folder. If Core \n"
+      "Directory is a full path, it will start \n"
+      "in the folder where the file is." },
+   { "history_list",
+      " -- Loading content from history. \n"
+      " \n"
+      "As content is loaded, content and libretro \n"
+      "core combinations are saved to history. \n"
+      " \n"
+      "The history is saved to a file in the same \n"
+      "directory as the RetroArch config file. If \n"
+      "no config file was loaded in startup, history \n"
+      "will not be saved or loaded, and will not exist \n"
+      "in the main menu." },
+   { "audio_dsp_plugin",
+      " -- Audio DSP plugin.\n"
+      " Processes audio before it's sent to \n"
+      "the driver." },
+   { "libretro_dir_path",
+      " -- Core Directory. \n"
+      " \n"
+      "A directory for where to search for \n"
+      "libretro core implementations." },
+   { "video_disable_composition",
+      "-- Forcibly disable composition.\n"
+      "Only valid on Windows Vista/7 for now." },
+   { "libretro_log_level",
+      "-- Sets log level for libretro cores \n"
+      "(GET_LOG_INTERFACE). \n"
+      " \n"
+      " If a log level issued by a libretro \n"
+      " core is below libretro_log level, it \n"
+      " is ignored.\n"
+      " \n"
+      " DEBUG logs are always ignored unless \n"
+      " verbose mode is activated (--verbose).\n"
+      " \n"
+      " DEBUG = 0\n"
+      " INFO  = 1\n"
+      " WARN  = 2\n"
+      " ERROR = 3" },
+   { "log_verbosity",
+      "-- Enable or disable verbosity level \n"
+      "of frontend." },
+   { "perfcnt_enable",
+      "-- Enable or disable frontend \n"
+      "performance counters." },
+   { "system_directory",
+      "-- System Directory. \n"
+      " \n"
+      "Sets the 'system' directory.\n"
+      "Implementations can query for this\n"
+      "directory to load BIOSes, \n"
+      "system-specific configs, etc." },
+   { "rgui_show_start_screen",
+      " -- Show startup screen in menu.\n"
+      "Is automatically set to false when seen\n"
+      "for the first time.\n"
+      " \n"
+      "This is only updated in config if\n"
+      "'Config Save On Exit' is set to true.\n" },
+   { "config_save_on_exit",
+      " -- Flushes config to disk on exit.\n"
+      "Useful for menu as settings can be\n"
+      "modified. Overwrites the config.\n"
+      " \n"
+      "#include's and comments are not \n"
+      "preserved. \n"
+      " \n"
+      "By design, the config file is \n"
+      "considered immutable as it is \n"
+      "likely maintained by the user, \n"
+      "and should not be overwritten \n"
+      "behind the user's back."
+#if defined(RARCH_CONSOLE) || defined(RARCH_MOBILE)
+      "\nThis is not not the case on \n"
+      "consoles however, where \n"
+      "looking at the config file \n"
+      "manually isn't really an option."
+#endif
+   },
+   { "core_specific_config",
+      " -- Load up a specific config file \n"
+      "based on the core being used.\n" },
+   { "video_scale",
+      " -- Fullscreen resolution.\n"
+      " \n"
+      "Resolution of 0 uses the \n"
+      "resolution of the environment.\n" },
+   { "video_vsync",
+      " -- Video V-Sync.\n" },
+   { "video_hard_sync",
+      " -- Attempts to hard-synchronize \n"
+      "CPU and GPU.\n"
+      " \n"
+      "Can reduce latency at cost of \n"
+      "performance." },
+   { "video_hard_sync_frames",
+      " -- Sets how many frames CPU can \n"
+      "run ahead of GPU when using 'GPU \n"
+      "Hard Sync'.\n"
+      " \n"
+      "Maximum is 3.\n"
+      " \n"
+      " 0: Syncs to GPU immediately.\n"
+      " 1: Syncs to previous frame.\n"
+      " 2: Etc ..." },
+   { "video_frame_delay",
+      " -- Sets how many milliseconds to delay\n"
+      "after VSync before running the core.\n"
+      "\n"
+      "Can reduce latency at cost of\n"
+      "higher risk of stuttering.\n"
+      " \n"
+      "Maximum is 15." },
+   { "audio_rate_control_delta",
+      " -- Audio rate control.\n"
+      " \n"
+      "Setting this to 0 disables rate control.\n"
+      "Any other value controls audio rate control \n"
+      "delta.\n"
+      " \n"
+      "Defines how much input rate can be adjusted \n"
+      "dynamically.\n"
+      " \n"
+      " Input rate is defined as: \n"
+      " input rate * (1.0 +/- (rate control delta))" },
+   { "video_filter",
+#ifdef HAVE_FILTERS_BUILTIN
+      " -- CPU-based video filter."
+#else
+      " -- CPU-based video filter.\n"
+      " \n"
+      "Path to a dynamic library."
+#endif
+   },
+   { "video_fullscreen",
+      " -- Toggles fullscreen." },
+   { "audio_device",
+      " -- Override the default audio device \n"
+      "the audio driver uses.\n"
+      "This is driver dependent. E.g.\n"
+#ifdef HAVE_ALSA
+      " \n"
+      "ALSA wants a PCM device."
+#endif
+#ifdef HAVE_OSS
+      " \n"
+      "OSS wants a path (e.g. /dev/dsp)."
+#endif
+#ifdef HAVE_JACK
+      " \n"
+      "JACK wants portnames (e.g. system:playback1\n"
+      ",system:playback_2)."
+#endif
+#ifdef HAVE_RSOUND
+      " \n"
+      "RSound wants an IP address to an RSound \n"
+      "server."
+#endif
+   },
+   { "video_black_frame_insertion",
+      " -- Inserts a black frame inbetween \n"
+      "frames.\n"
+      " \n"
+      "Useful for 120 Hz monitors who want to \n"
+      "play 60 Hz material with eliminated \n"
+      "ghosting.\n"
+      " \n"
+      "Video refresh rate should still be \n"
+      "configured as if it is a 60 Hz monitor \n"
+      "(divide refresh rate by 2)." },
+   { "video_threaded",
+      " -- Use threaded video driver.\n"
+      " \n"
+      "Using this might improve performance at \n"
+      "possible cost of latency and more video \n"
+      "stuttering." },
+   { "video_frame_dupe_detect",
+      " -- Detect frames the core submits \n"
+      "unchanged, and skip converting, \n"
+      "filtering and uploading them.\n"
+      " \n"
+      "Helps with static screens and games \n"
+      "running at 30 FPS. Otherwise only \n"
+      "the rows which changed are processed." },
+   { "video_scale_integer",
+      " -- Only scales video in integer \n"
+      "steps.\n"
+      " \n"
+      "The base size depends on system-reported \n"
+      "geometry and aspect ratio.\n"
+      " \n"
+      "If Force Aspect is not set, X/Y will be \n"
+      "integer scaled independently." },
+   { "video_crop_overscan",
+      " -- Forces cropping of overscanned \n"
+      "frames.\n"
+      " \n"
+      "Exact behavior of this option is \n"
+      "core-implementation specific." },
+   { "video_monitor_index",
+      " -- Which monitor to prefer.\n"
+      " \n"
+      "0 (default) means no particular monitor \n"
+      "is preferred, 1 and up (1 being first \n"
+      "monitor), suggests RetroArch to use that \n"
+      "particular monitor." },
+   { "video_rotation",
+      " -- Forces a certain rotation \n"
+      "of the screen.\n"
+      " \n"
+      "The rotation is added to rotations which\n"
+      "the libretro core sets (see Video Allow\n"
+      "Rotate)." },
+   { "audio_volume",
+      " -- Audio volume, expressed in dB.\n"
+      " \n"
+      " 0 dB is normal volume. No gain will be applied.\n"
+      "Gain can be controlled in runtime with Input\n"
+      "Volume Up / Input Volume Down." },
+   { "block_sram_overwrite",
+      " -- Block SRAM from being overwritten \n"
+      "when loading save states.\n"
+      " \n"
+      "Might potentially lead to buggy games." },
+   { "fastforward_ratio",
+      " -- Fastforward ratio."
+      " \n"
+      "The maximum rate at which content will\n"
+      "be run when using fast forward.\n"
+      " \n"
+      " (E.g. 5.0 for 60 fps content => 300 fps \n"
+      "cap).\n"
+      " \n"
+      "RetroArch will go to sleep to ensure that \n"
+      "the maximum rate will not be exceeded.\n"
+      "Do not rely on this cap to be perfectly \n"
+      "accurate." },
+   { "pause_nonactive",
+      " -- Pause gameplay when window focus \n"
+      "is lost." },
+   { "video_gpu_screenshot",
+      " -- Screenshots output of GPU shaded \n"
+      "material if available." },
+   { "autosave_interval",
+      " -- Autosaves the non-volatile SRAM \n"
+      "at a regular interval.\n"
+      " \n"
+      "This is disabled by default unless set \n"
+      "otherwise. The interval is measured in \n"
+      "seconds. \n"
+      " \n"
+      "A value of 0 disables autosave." },
+   { "screenshot_directory",
+      " -- Screenshot Directory. \n"
+      " \n"
+      "Directory to dump screenshots to." },
+   { "video_swap_interval",
+      " -- VSync Swap Interval.\n"
+      " \n"
+      "Uses a custom swap interval for VSync. Set this \n"
+      "to effectively halve monitor refresh rate." },
+   { "video_refresh_rate_auto",
+      " -- Refresh Rate Auto.\n"
+      " \n"
+      "The accurate refresh rate of our monitor (Hz).\n"
+      "This is used to calculate audio input rate with \n"
+      "the formula: \n"
+      " \n"
+      "audio_input_rate = game input rate * display \n"
+      "refresh rate / game refresh rate\n"
+      " \n"
+      "If the implementation does not report any \n"
+      "values, NTSC defaults will be assumed for \n"
+      "compatibility.\n"
+      " \n"
+      "This value should stay close to 60Hz to avoid \n"
+      "large pitch changes. If your monitor does \n"
+      "not run at 60Hz, or something close to it, \n"
+      "disable VSync, and leave this at its default." },
+   { "savefile_directory",
+      " -- Savefile Directory. \n"
+      " \n"
+      "Save all save files (*.srm) to this \n"
+      "directory. This includes related files like \n"
+      ".bsv, .rt, .psrm, etc...\n"
+      " \n"
+      "This will be overridden by explicit command line\n"
+      "options." },
+   { "savestate_directory",
+      " -- Savestate Directory. \n"
+      " \n"
+      "Save all save states (*.state) to this \n"
+      "directory.\n"
+      " \n"
+      "This will be overridden by explicit command line\n"
+      "options." },
+   { "assets_directory",
+      " -- Assets Directory. \n"
+      " \n"
+      " This location is queried by default when \n"
+      "menu interfaces try to look for loadable \n"
+      "assets, etc." },
+   { "slowmotion_ratio",
+      " -- Slowmotion ratio."
+      " \n"
+      "When slowmotion, content will slow\n"
+      "down by factor." },
+   { "input_axis_threshold",
+      " -- Defines axis threshold.\n"
+      " \n"
+      "How far an axis must be tilted to result\n"
+      "in a button press.\n"
+      " Possible values are [0.0, 1.0]." },
+   { "input_turbo_period",
+      " -- Turbo period.\n"
+      " \n"
+      "Describes speed of which turbo-enabled\n"
+      "buttons toggle." },
+   { "rewind_granularity",
+      " -- Rewind granularity.\n"
+      " \n"
+      " When rewinding defined number of \n"
+      "frames, you can rewind several frames \n"
+      "at a time, increasing the rewinding \n"
+      "speed." },
+   { "rewind_enable",
+      " -- Enable rewinding.\n"
+      " \n"
+      "This will take a performance hit, \n"
+      "so it is disabled by default." },
+   { "run_ahead_enable",
+      " -- Enable run-ahead.\n"
+      " \n"
+      "Hides the core's own input lag by \n"
+      "running it ahead every frame. Needs \n"
+      "save states and costs CPU time." },
+   { "run_ahead_frames",
+      " -- Frames to run ahead.\n"
+      " \n"
+      "Set to the core's own input lag. \n"
+      "Too many frames cause jitter." },
+   { "run_ahead_secondary_instance",
+      " -- Run ahead in a second core.\n"
+      " \n"
+      "Avoids restoring the main core every \n"
+      "frame. Applies when content is loaded. \n"
+      " \n"
+      "Not used for hardware rendered cores \n"
+      "or cores with disk control." },
+   { "input_autodetect_enable",
+      " -- Enable input auto-detection.\n"
+      " \n"
+      "Will attempt to auto-configure \n"
+      "joypads, Plug-and-Play style." },
+   { "camera_allow",
+      " -- Allow or disallow camera access by \n"
+      "cores." },
+   { "location_allow",
+      " -- Allow or disallow location services \n"
+      "access by cores." },
+   { "savestate_auto_save",
+      " -- Automatically saves a savestate at the \n"
+      "end of RetroArch's lifetime.\n"
+      " \n"
+      "RetroArch will automatically load any savestate\n"
+      "with this path on startup if 'Savestate Auto\n"
+      "Load' is set." },
+   { "savestate_compression",
+      " -- Compresses savestates when saving.\n"
+      " \n"
+      "Compressed states are smaller and faster\n"
+      "to write to slow storage. Uncompressed\n"
+      "states can still be loaded." },
+   { "movie_keyframe_interval",
+      " -- Movie Keyframe Interval.\n"
+      " \n"
+      "Recorded movies store a savestate every\n"
+      "this many frames, so playback can seek\n"
+      "to any frame quickly. \n"
+      " \n"
+      "0 only stores the state the movie\n"
+      "starts from." },
+   { "shader_apply_changes",
+      " -- Apply Shader Changes. \n"
+      " \n"
+      "After changing shader settings, use this to \n"
+      "apply changes. \n"
+      " \n"
+      "Changing shader settings is a somewhat \n"
+      "expensive operation so it has to be \n"
+      "done explicitly. \n"
+      " \n"
+      "When you apply shaders, the menu shader \n"
+      "settings are saved to a temporary file (either \n"
+      "menu.cgp or menu.glslp) and loaded. The file \n"
+      "persists after RetroArch exits. The file is \n"
+      "saved to Shader Directory." },
+   { "video_shader_preset",
+      " -- Load Shader Preset. \n"
+      " \n"
+      " Load a "
+#ifdef HAVE_CG
+      "Cg"
+#endif
+#ifdef HAVE_GLSL
+#ifdef HAVE_CG
+      "/"
+#endif
+      "GLSL"
+#endif
+#ifdef HAVE_HLSL
+#if defined(HAVE_CG) || defined(HAVE_HLSL)
+      "/"
+#endif
+      "HLSL"
+#endif
+      " preset directly. \n"
+      "The menu shader menu is updated accordingly. \n"
+      " \n"
+      "If the CGP uses scaling methods which are not \n"
+      "simple, (i.e. source scaling, same scaling \n"
+      "factor for X/Y), the scaling factor displayed \n"
+      "in the menu might not be correct." },
+   { "video_shader_num_passes",
+      " -- Shader Passes. \n"
+      " \n"
+      "RetroArch allows you to mix and match various \n"
+      "shaders with arbitrary shader passes, with \n"
+      "custom hardware filters and scale factors. \n"
+      " \n"
+      "This option specifies the number of shader \n"
+      "passes to use. If you set this to 0, and use \n"
+      "Apply Shader Changes, you use a 'blank' shader. \n"
+      " \n"
+      "The Default Filter option will affect the \n"
+      "stretching filter." },
+   { "video_shader_parameters",
+      "-- Shader Parameters. \n"
+      " \n"
+      "Modifies current shader directly. Will not be \n"
+      "saved to CGP/GLSLP preset file." },
+   { "video_shader_preset_parameters",
+      "-- Shader Preset Parameters. \n"
+      " \n"
+      "Modifies shader preset currently in menu." },
+   { "video_shader_pass",
+      " -- Path to shader. \n"
+      " \n"
+      "All shaders must be of the same \n"
+      "type (i.e. CG, GLSL or HLSL). \n"
+      " \n"
+      "Set Shader Directory to set where \n"
+      "the browser starts to look for \n"
+      "shaders." },
+   { "video_shader_filter_pass",
+      " -- Hardware filter for this pass. \n"
+      " \n"
+      "If 'Don't Care' is set, 'Default \n"
+      "Filter' will be used." },
+   { "video_shader_scale_pass",
+      " -- Scale for this pass. \n"
+      " \n"
+      "The scale factor accumulates, i.e. 2x \n"
+      "for first pass and 2x for second pass \n"
+      "will give you a 4x total scale. \n"
+      " \n"
+      "If there is a scale factor for last \n"
+      "pass, the result is stretched to \n"
+      "screen with the filter specified in \n"
+      "'Default Filter'. \n"
+      " \n"
+      "If 'Don't Care' is set, either 1x \n"
+      "scale or stretch to fullscreen will \n"
+      "be used depending if it's not the last \n"
+      "pass or not." },
+   { "l_x_plus",
+      " -- Axis for analog stick (DualShock-esque).\n"
+      " \n"
+      "Bound as usual, however, if a real analog \n"
+      "axis is bound, it can be read as a true analog.\n"
+      " \n"
+      "Positive X axis is right. \n"
+      "Positive Y axis is down." },
+   { "l_x_minus",
+      " -- Axis for analog stick (DualShock-esque).\n"
+      " \n"
+      "Bound as usual, however, if a real analog \n"
+      "axis is bound, it can be read as a true analog.\n"
+      " \n"
+      "Positive X axis is right. \n"
+      "Positive Y axis is down." },
+   { "l_y_plus",
+      " -- Axis for analog stick (DualShock-esque).\n"
+      " \n"
+      "Bound as usual, however, if a real analog \n"
+      "axis is bound, it can be read as a true analog.\n"
+      " \n"
+      "Positive X axis is right. \n"
+      "Positive Y axis is down." },
+   { "l_y_minus",
+      " -- Axis for analog stick (DualShock-esque).\n"
+      " \n"
+      "Bound as usual, however, if a real analog \n"
+      "axis is bound, it can be read as a true analog.\n"
+      " \n"
+      "Positive X axis is right. \n"
+      "Positive Y axis is down." },
+   { "turbo",
+      " -- Turbo enable.\n"
+      " \n"
+      "Holding the turbo while pressing another \n"
+      "button will let the button enter a turbo \n"
+      "mode where the button state is modulated \n"
+      "with a periodic signal. \n"
+      " \n"
+      "The modulation stops when the button \n"
+      "itself (not turbo button) is released." },
+   { "exit_emulator",
+      " -- Key to exit RetroArch cleanly."
+#if !defined(RARCH_MOBILE) && !defined(RARCH_CONSOLE)
+      "\nKilling it in any hard way (SIGKILL, \n"
+      "etc) will terminate without saving\n"
+      "RAM, etc. On Unix-likes,\n"
+      "SIGINT/SIGTERM allows\n"
+      "a clean deinitialization."
+#endif
+   },
+   { "rewind",
+      " -- Hold button down to rewind.\n"
+      " \n"
+      "Rewind must be enabled." },
+   { "load_state",
+      " -- Loads state." },
+   { "save_state",
+      " -- Saves state." },
+   { "state_slot_increase",
+      " -- State slots.\n"
+      " \n"
+      " With slot set to 0, save state name is *.state \n"
+      " (or whatever defined on commandline).\n"
+      "When slot is != 0, path will be (path)(d), \n"
+      "where (d) is slot number." },
+   { "state_slot_decrease",
+      " -- State slots.\n"
+      " \n"
+      " With slot set to 0, save state name is *.state \n"
+      " (or whatever defined on commandline).\n"
+      "When slot is != 0, path will be (path)(d), \n"
+      "where (d) is slot number." },
+   { "netplay_flip_players",
+      " -- Netplay flip players." },
+   { "frame_advance",
+      " -- Frame advance when content is paused." },
+   { "enable_hotkey",
+      " -- Enable other hotkeys.\n"
+      " \n"
+      " If this hotkey is bound to either keyboard, \n"
+      "joybutton or joyaxis, all other hotkeys will \n"
+      "be disabled unless this hotkey is also held \n"
+      "at the same time. \n"
+      " \n"
+      "This is useful for RETRO_KEYBOARD centric \n"
+      "implementations which query a large area of \n"
+      "the keyboard, where it is not desirable that \n"
+      "hotkeys get in the way." },
+   { "slowmotion",
+      " -- Hold for slowmotion." },
+   { "movie_record_toggle",
+      " -- Toggle between recording and not." },
+   { "pause_toggle",
+      " -- Toggle between paused and non-paused state." },
+   { "hold_fast_forward",
+      " -- Hold for fast-forward. Releasing button \n"
+      "disables fast-forward." },
+   { "shader_next",
+      " -- Applies next shader in directory." },
+   { "reset",
+      " -- Reset the content.\n" },
+   { "cheat_index_plus",
+      " -- Increment cheat index.\n" },
+   { "cheat_index_minus",
+      " -- Decrement cheat index.\n" },
+   { "cheat_toggle",
+      " -- Toggle cheat index.\n" },
+   { "shader_prev",
+      " -- Applies previous shader in directory." },
+   { "audio_mute",
+      " -- Mute/unmute audio." },
+   { "screenshot",
+      " -- Take screenshot." },
+   { "volume_up",
+      " -- Increases audio volume." },
+   { "volume_down",
+      " -- Decreases audio volume." },
+   { "overlay_next",
+      " -- Toggles to next overlay.\n"
+      " \n"
+      "Wraps around." },
+   { "disk_eject_toggle",
+      " -- Toggles eject for disks.\n"
+      " \n"
+      "Used for multiple-disk content." },
+   { "disk_next",
+      " -- Cycles through disk images. Use after \n"
+      "ejecting. \n"
+      " \n"
+      " Complete by toggling eject again." },
+   { "grab_mouse_toggle",
+      " -- Toggles mouse grab.\n"
+      " \n"
+      "When mouse is grabbed, RetroArch hides the \n"
+      "mouse, and keeps the mouse pointer inside \n"
+      "the window to allow relative mouse input to \n"
+      "work better." },
+   { "menu_toggle",
+      " -- Toggles menu." },
+   { "input_bind_device_id",
+      " -- Input Device. \n"
+      " \n"
+      "Picks which gamepad to use for player N. \n"
+      "The name of the pad is available." },
+   { "input_bind_device_type",
+      " -- Input Device Type. \n"
+      " \n"
+      "Picks which device type to use. This is \n"
+      "relevant for the libretro core itself." },
+};
+
+#define SETTING_DESCRIPTION_SLOTS 256
+
+/* Fails to compile once the table is more than half full. */
+typedef char setting_description_slots_fit[
+   ARRAY_SIZE(setting_descriptions) * 2 <= SETTING_DESCRIPTION_SLOTS
+   ? 1 : -1];
+
+/* Index into setting_descriptions[], see hash_bucket(). */
+static uint16_t setting_description_slots[SETTING_DESCRIPTION_SLOTS];
+
+static const char *setting_data_find_description(const char *label)
+{
+   static bool indexed = false;
+   const uint32_t mask = SETTING_DESCRIPTION_SLOTS - 1;
+   uint32_t slot;
+   unsigned i;
+
+   if (!indexed)
+   {
+      for (i = 0; i < ARRAY_SIZE(setting_descriptions); i++)
+      {
+         slot = hash_bucket(djb2_calculate(setting_descriptions[i].label), mask);
+         while (setting_description_slots[slot])
+            slot = (slot + 1) & mask;
+         setting_description_slots[slot] = i + 1;
+      }
+      indexed = true;
+   }
+
+   for (slot = hash_bucket(djb2_calculate(label), mask);
+         setting_description_slots[slot]; slot = (slot + 1) & mask)
+   {
+      const struct setting_description *desc =
+         &setting_descriptions[setting_description_slots[slot] - 1];
+      if (!strcmp(desc->label, label))
+         return desc->text;
+   }
+
+   return NULL;
+}
+
 int setting_data_get_description(const char *label, char *msg,
       size_t sizeof_msg)
 {
-   if (!strcmp(label, "input_driver"))
+   const char *text = setting_data_find_description(label);
+
+   if (text)
+      strlcpy(msg, text, sizeof_msg);
+   else if (!strcmp(label, "input_driver"))
    {
       if (!strcmp(g_settings.input.driver, "udev"))
          snprintf(msg, sizeof_msg,
@@ -831,57 +1619,6 @@ int setting_data_get_description(const char *label, char *msg,
                "force a different input driver.");
 
    }
-   else if (!strcmp(label, "load_content"))
-   {
-      snprintf(msg, sizeof_msg,
-            " -- Load Content. \n"
-            "Browse for content. \n"
-            " \n"
-            "To load content, you need a \n"
-            "libretro core to use, and a \n"
-            "content file. \n"
-            " \n"
-            "To control where the menu starts \n"
-            " to browse for content, set  \n"
-            "Browser Directory. If not set,  \n"
-            "it will start in root. \n"
-            " \n"
-            "The browser will filter out \n"
-            "extensions for the last core set \n"
-            "in 'Core', and use that core when \n"
-            "content is loaded."
-            );
-   }
-   else if (!strcmp(label, "core_list"))
-   {
-      snprintf(msg, sizeof_msg,
-            " -- Core Selection. \n"
-            " \n"
-            "Browse for a libretro core \n"
-            "implementation. Where the browser \n"
-            "starts depends on your Core Directory \n"
-            "path. If blank, it will start in root. \n"
-            " \n"
-            "If Core Directory is a directory, the menu \n"
-            "will use that as top folder. If Core \n"
-            "Directory is a full path, it will start \n"
-            "in the folder where the file is.");
-   }
-   else if (!strcmp(label, "history_list"))
-   {
-      snprintf(msg, sizeof_msg,
-            " -- Loading content from history. \n"
-            " \n"
-            "As content is loaded, content and libretro \n"
-            "core combinations are saved to history. \n"
-            " \n"
-            "The history is saved to a file in the same \n"
-            "directory as the RetroArch config file. If \n"
-            "no config file was loaded in startup, history \n"
-            "will not be saved or loaded, and will not exist \n"
-            "in the main menu."
-            );
-   }
    else if (!strcmp(label, "audio_resampler_driver"))
    {
       if (!strcmp(g_settings.audio.resampler, "sinc"))
@@ -945,758 +1682,6 @@ int setting_data_get_description(const char *label, char *msg,
          snprintf(msg, sizeof_msg,
                " -- Current Video driver.");
    }
-   else if (!strcmp(label, "audio_dsp_plugin"))
-   {
-      snprintf(msg, sizeof_msg,
-            " -- Audio DSP plugin.\n"
-            " Processes audio before it's sent to \n"
-            "the driver."
-            );
-   }
-   else if (!strcmp(label, "libretro_dir_path"))
-   {
-      snprintf(msg, sizeof_msg,
-            " -- Core Directory. \n"
-            " \n"
-            "A directory for where to search for \n"
-            "libretro core implementations.");
-   }
-   else if (!strcmp(label, "video_disable_composition"))
-   {
-      snprintf(msg, sizeof_msg,
-            "-- Forcibly disable composition.\n"
-            "Only valid on Windows Vista/7 for now.");
-   }
-   else if (!strcmp(label, "libretro_log_level"))
-   {
-      snprintf(msg, sizeof_msg,
-            "-- Sets log level for libretro cores \n"
-            "(GET_LOG_INTERFACE). \n"
-            " \n"
-            " If a log level issued by a libretro \n"
-            " core is below libretro_log level, it \n"
-            " is ignored.\n"
-            " \n"
-            " DEBUG logs are always ignored unless \n"
-            " verbose mode is activated (--verbose).\n"
-            " \n"
-            " DEBUG = 0\n"
-            " INFO  = 1\n"
-            " WARN  = 2\n"
-            " ERROR = 3"
-            );
-   }
-   else if (!strcmp(label, "log_verbosity"))
-   {
-      snprintf(msg, sizeof_msg,
-            "-- Enable or disable verbosity level \n"
-            "of frontend.");
-   }
-   else if (!strcmp(label, "perfcnt_enable"))
-   {
-      snprintf(msg, sizeof_msg,
-            "-- Enable or disable frontend \n"
-            "performance counters.");
-   }
-   else if (!strcmp(label, "system_directory"))
-   {
-      snprintf(msg, sizeof_msg,
-            "-- System Directory. \n"
-            " \n"
-            "Sets the 'system' directory.\n"
-            "Implementations can query for this\n"
-            "directory to load BIOSes, \n"
-            "system-specific configs, etc.");
-   }
-   else if (!strcmp(label, "rgui_show_start_screen"))
-   {
-      snprintf(msg, sizeof_msg,
-            " -- Show startup screen in menu.\n"
-            "Is automatically set to false when seen\n"
-            "for the first time.\n"
-            " \n"
-            "This is only updated in config if\n"
-            "'Config Save On Exit' is set to true.\n");
-   }
-   else if (!strcmp(label, "config_save_on_exit"))
-   {
-      snprintf(msg, sizeof_msg,
-            " -- Flushes config to disk on exit.\n"
-            "Useful for menu as settings can be\n"
-            "modified. Overwrites the config.\n"
-            " \n"
-            "#include's and comments are not \n"
-            "preserved. \n"
-            " \n"
-            "By design, the config file is \n"
-            "considered immutable as it is \n"
-            "likely maintained by the user, \n"
-            "and should not be overwritten \n"
-            "behind the user's back."
-#if defined(RARCH_CONSOLE) || defined(RARCH_MOBILE)
-            "\nThis is not not the case on \n"
-            "consoles however, where \n"
-            "looking at the config file \n"
-            "manually isn't really an option."
-#endif
-            );
-   }
-   else if (!strcmp(label, "core_specific_config"))
-   {
-      snprintf(msg, sizeof_msg,
-            " -- Load up a specific config file \n"
-            "based on the core being used.\n");
-   }
-   else if (!strcmp(label, "video_scale"))
-   {
-      snprintf(msg, sizeof_msg,
-            " -- Fullscreen resolution.\n"
-            " \n"
-            "Resolution of 0 uses the \n"
-            "resolution of the environment.\n");
-   }
-   else if (!strcmp(label, "video_vsync"))
-   {
-      snprintf(msg, sizeof_msg,
-            " -- Video V-Sync.\n");
-   }
-   else if (!strcmp(label, "video_hard_sync"))
-   {
-      snprintf(msg, sizeof_msg,
-            " -- Attempts to hard-synchronize \n"
-            "CPU and GPU.\n"
-            " \n"
-            "Can reduce latency at cost of \n"
-            "performance.");
-   }
-   else if (!strcmp(label, "video_hard_sync_frames"))
-   {
-      snprintf(msg, sizeof_msg,
-            " -- Sets how many frames CPU can \n"
-            "run ahead of GPU when using 'GPU \n"
-            "Hard Sync'.\n"
-            " \n"
-            "Maximum is 3.\n"
-            " \n"
-            " 0: Syncs to GPU immediately.\n"
-            " 1: Syncs to previous frame.\n"
-            " 2: Etc ...");
-   }
-   else if (!strcmp(label, "video_frame_delay"))
-   {
-      snprintf(msg, sizeof_msg,
-            " -- Sets how many milliseconds to delay\n"
-            "after VSync before running the core.\n"
-            "\n"
-            "Can reduce latency at cost of\n"
-            "higher risk of stuttering.\n"
-            " \n"
-            "Maximum is 15.");
-   }
-   else if (!strcmp(label, "audio_rate_control_delta"))
-   {
-      snprintf(msg, sizeof_msg,
-            " -- Audio rate control.\n"
-            " \n"
-            "Setting this to 0 disables rate control.\n"
-            "Any other value controls audio rate control \n"
-            "delta.\n"
-            " \n"
-            "Defines how much input rate can be adjusted \n"
-            "dynamically.\n"
-            " \n"
-            " Input rate is defined as: \n"
-            " input rate * (1.0 +/- (rate control delta))");
-   }
-   else if (!strcmp(label, "video_filter"))
-   {
-#ifdef HAVE_FILTERS_BUILTIN
-      snprintf(msg, sizeof_msg,
-            " -- CPU-based video filter.");
-#else
-      snprintf(msg, sizeof_msg,
-            " -- CPU-based video filter.\n"
-            " \n"
-            "Path to a dynamic library.");
-#endif
-   }
-   else if (!strcmp(label, "video_fullscreen"))
-   {
-      snprintf(msg, sizeof_msg, " -- Toggles fullscreen.");
-   }
-   else if (!strcmp(label, "audio_device"))
-   {
-      snprintf(msg, sizeof_msg,
-            " -- Override the default audio device \n"
-            "the audio driver uses.\n"
-            "This is driver dependent. E.g.\n"
-#ifdef HAVE_ALSA
-            " \n"
-            "ALSA wants a PCM device."
-#endif
-#ifdef HAVE_OSS
-            " \n"
-            "OSS wants a path (e.g. /dev/dsp)."
-#endif
-#ifdef HAVE_JACK
-            " \n"
-            "JACK wants portnames (e.g. system:playback1\n"
-            ",system:playback_2)."
-#endif
-#ifdef HAVE_RSOUND
-            " \n"
-            "RSound wants an IP address to an RSound \n"
-            "server."
-#endif
-            );
-   }
-   else if (!strcmp(label, "video_black_frame_insertion"))
-   {
-      snprintf(msg, sizeof_msg,
-            " -- Inserts a black frame inbetween \n"
-            "frames.\n"
-            " \n"
-            "Useful for 120 Hz monitors who want to \n"
-            "play 60 Hz material with eliminated \n"
-            "ghosting.\n"
-            " \n"
-            "Video refresh rate should still be \n"
-            "configured as if it is a 60 Hz monitor \n"
-            "(divide refresh rate by 2).");
-   }
-   else if (!strcmp(label, "video_threaded"))
-   {
-      snprintf(msg, sizeof_msg,
-            " -- Use threaded video driver.\n"
-            " \n"
-            "Using this might improve performance at \n"
-            "possible cost of latency and more video \n"
-            "stuttering.");
-   }
-   else if (!strcmp(label, "video_scale_integer"))
-   {
-      snprintf(msg, sizeof_msg,
-            " -- Only scales video in integer \n"
-            "steps.\n"
-            " \n"
-            "The base size depends on system-reported \n"
-            "geometry and aspect ratio.\n"
-            " \n"
-            "If Force Aspect is not set, X/Y will be \n"
-            "integer scaled independently.");
-   }
-   else if (!strcmp(label, "video_crop_overscan"))
-   {
-      snprintf(msg, sizeof_msg,
-            " -- Forces cropping of overscanned \n"
-            "frames.\n"
-            " \n"
-            "Exact behavior of this option is \n"
-            "core-implementation specific.");
-   }
-   else if (!strcmp(label, "video_monitor_index"))
-   {
-      snprintf(msg, sizeof_msg,
-            " -- Which monitor to prefer.\n"
-            " \n"
-            "0 (default) means no particular monitor \n"
-            "is preferred, 1 and up (1 being first \n"
-            "monitor), suggests RetroArch to use that \n"
-            "particular monitor.");
-   }
-   else if (!strcmp(label, "video_rotation"))
-   {
-      snprintf(msg, sizeof_msg,
-            " -- Forces a certain rotation \n"
-            "of the screen.\n"
-            " \n"
-            "The rotation is added to rotations which\n"
-            "the libretro core sets (see Video Allow\n"
-            "Rotate).");
-   }
-   else if (!strcmp(label, "audio_volume"))
-   {
-      snprintf(msg, sizeof_msg,
-            " -- Audio volume, expressed in dB.\n"
-            " \n"
-            " 0 dB is normal volume. No gain will be applied.\n"
-            "Gain can be controlled in runtime with Input\n"
-            "Volume Up / Input Volume Down.");
-   }
-   else if (!strcmp(label, "block_sram_overwrite"))
-   {
-      snprintf(msg, sizeof_msg,
-            " -- Block SRAM from being overwritten \n"
-            "when loading save states.\n"
-            " \n"
-            "Might potentially lead to buggy games.");
-   }
-   else if (!strcmp(label, "fastforward_ratio"))
-   {
-      snprintf(msg, sizeof_msg,
-            " -- Fastforward ratio."
-            " \n"
-            "The maximum rate at which content will\n"
-            "be run when using fast forward.\n"
-            " \n"
-            " (E.g. 5.0 for 60 fps content => 300 fps \n"
-            "cap).\n"
-            " \n"
-            "RetroArch will go to sleep to ensure that \n"
-            "the maximum rate will not be exceeded.\n"
-            "Do not rely on this cap to be perfectly \n"
-            "accurate.");
-   }
-   else if (!strcmp(label, "pause_nonactive"))
-   {
-      snprintf(msg, sizeof_msg,
-            " -- Pause gameplay when window focus \n"
-            "is lost.");
-   }
-   else if (!strcmp(label, "video_gpu_screenshot"))
-   {
-      snprintf(msg, sizeof_msg,
-            " -- Screenshots output of GPU shaded \n"
-            "material if available.");
-   }
-   else if (!strcmp(label, "autosave_interval"))
-   {
-      snprintf(msg, sizeof_msg,
-            " -- Autosaves the non-volatile SRAM \n"
-            "at a regular interval.\n"
-            " \n"
-            "This is disabled by default unless set \n"
-            "otherwise. The interval is measured in \n"
-            "seconds. \n"
-            " \n"
-            "A value of 0 disables autosave.");
-   }
-   else if (!strcmp(label, "screenshot_directory"))
-   {
-      snprintf(msg, sizeof_msg,
-            " -- Screenshot Directory. \n"
-            " \n"
-            "Directory to dump screenshots to."
-            );
-   }
-   else if (!strcmp(label, "video_swap_interval"))
-   {
-      snprintf(msg, sizeof_msg,
-            " -- VSync Swap Interval.\n"
-            " \n"
-            "Uses a custom swap interval for VSync. Set this \n"
-            "to effectively halve monitor refresh rate.");
-   }
-   else if (!strcmp(label, "video_refresh_rate_auto"))
-   {
-      snprintf(msg, sizeof_msg,
-            " -- Refresh Rate Auto.\n"
-            " \n"
-            "The accurate refresh rate of our monitor (Hz).\n"
-            "This is used to calculate audio input rate with \n"
-            "the formula: \n"
-            " \n"
-            "audio_input_rate = game input rate * display \n"
-            "refresh rate / game refresh rate\n"
-            " \n"
-            "If the implementation does not report any \n"
-            "values, NTSC defaults will be assumed for \n"
-            "compatibility.\n"
-            " \n"
-            "This value should stay close to 60Hz to avoid \n"
-            "large pitch changes. If your monitor does \n"
-            "not run at 60Hz, or something close to it, \n"
-            "disable VSync, and leave this at its default.");
-   }
-   else if (!strcmp(label, "savefile_directory"))
-   {
-      snprintf(msg, sizeof_msg,
-            " -- Savefile Directory. \n"
-            " \n"
-            "Save all save files (*.srm) to this \n"
-            "directory. This includes related files like \n"
-            ".bsv, .rt, .psrm, etc...\n"
-            " \n"
-            "This will be overridden by explicit command line\n"
-            "options.");
-   }
-   else if (!strcmp(label, "savestate_directory"))
-   {
-      snprintf(msg, sizeof_msg,
-            " -- Savestate Directory. \n"
-            " \n"
-            "Save all save states (*.state) to this \n"
-            "directory.\n"
-            " \n"
-            "This will be overridden by explicit command line\n"
-            "options.");
-   }
-   else if (!strcmp(label, "assets_directory"))
-   {
-      snprintf(msg, sizeof_msg,
-            " -- Assets Directory. \n"
-            " \n"
-            " This location is queried by default when \n"
-            "menu interfaces try to look for loadable \n"
-            "assets, etc.");
-   }
-   else if (!strcmp(label, "slowmotion_ratio"))
-   {
-      snprintf(msg, sizeof_msg,
-            " -- Slowmotion ratio."
-            " \n"
-            "When slowmotion, content will slow\n"
-            "down by factor.");
-   }
-   else if (!strcmp(label, "input_axis_threshold"))
-   {
-      snprintf(msg, sizeof_msg,
-            " -- Defines axis threshold.\n"
-            " \n"
-            "How far an axis must be tilted to result\n"
-            "in a button press.\n"
-            " Possible values are [0.0, 1.0].");
-   }
-   else if (!strcmp(label, "input_turbo_period"))
-   {
-      snprintf(msg, sizeof_msg, 
-            " -- Turbo period.\n"
-            " \n"
-            "Describes speed of which turbo-enabled\n"
-            "buttons toggle."
-            );
-   }
-   else if (!strcmp(label, "rewind_granularity"))
-   {
-      snprintf(msg, sizeof_msg,
-            " -- Rewind granularity.\n"
-            " \n"
-            " When rewinding defined number of \n"
-            "frames, you can rewind several frames \n"
-            "at a time, increasing the rewinding \n"
-            "speed.");
-   }
-   else if (!strcmp(label, "rewind_enable"))
-   {
-      snprintf(msg, sizeof_msg,
-            " -- Enable rewinding.\n"
-            " \n"
-            "This will take a performance hit, \n"
-            "so it is disabled by default.");
-   }
-   else if (!strcmp(label, "input_autodetect_enable"))
-   {
-      snprintf(msg, sizeof_msg,
-            " -- Enable input auto-detection.\n"
-            " \n"
-            "Will attempt to auto-configure \n"
-            "joypads, Plug-and-Play style.");
-   }
-   else if (!strcmp(label, "camera_allow"))
-   {
-      snprintf(msg, sizeof_msg,
-            " -- Allow or disallow camera access by \n"
-            "cores.");
-   }
-   else if (!strcmp(label, "location_allow"))
-   {
-      snprintf(msg, sizeof_msg,
-            " -- Allow or disallow location services \n"
-            "access by cores.");
-   }
-   else if (!strcmp(label, "savestate_auto_save"))
-   {
-      snprintf(msg, sizeof_msg,
-            " -- Automatically saves a savestate at the \n"
-            "end of RetroArch's lifetime.\n"
-            " \n"
-            "RetroArch will automatically load any savestate\n"
-            "with this path on startup if 'Savestate Auto\n"
-            "Load' is set.");
-   }
-   else if (!strcmp(label, "shader_apply_changes"))
-   {
-      snprintf(msg, sizeof_msg,
-            " -- Apply Shader Changes. \n"
-            " \n"
-            "After changing shader settings, use this to \n"
-            "apply changes. \n"
-            " \n"
-            "Changing shader settings is a somewhat \n"
-            "expensive operation so it has to be \n"
-            "done explicitly. \n"
-            " \n"
-            "When you apply shaders, the menu shader \n"
-            "settings are saved to a temporary file (either \n"
-            "menu.cgp or menu.glslp) and loaded. The file \n"
-            "persists after RetroArch exits. The file is \n"
-            "saved to Shader Directory."
-            );
-
-   }
-   else if (!strcmp(label, "video_shader_preset")) 
-   {
-      snprintf(msg, sizeof_msg,
-            " -- Load Shader Preset. \n"
-            " \n"
-            " Load a "
-#ifdef HAVE_CG
-            "Cg"
-#endif
-#ifdef HAVE_GLSL
-#ifdef HAVE_CG
-            "/"
-#endif
-            "GLSL"
-#endif
-#ifdef HAVE_HLSL
-#if defined(HAVE_CG) || defined(HAVE_HLSL)
-            "/"
-#endif
-            "HLSL"
-#endif
-            " preset directly. \n"
-            "The menu shader menu is updated accordingly. \n"
-            " \n"
-            "If the CGP uses scaling methods which are not \n"
-            "simple, (i.e. source scaling, same scaling \n"
-            "factor for X/Y), the scaling factor displayed \n"
-            "in the menu might not be correct."
-            );
-   }
-   else if (!strcmp(label, "video_shader_num_passes")) 
-   {
-      snprintf(msg, sizeof_msg,
-            " -- Shader Passes. \n"
-            " \n"
-            "RetroArch allows you to mix and match various \n"
-            "shaders with arbitrary shader passes, with \n"
-            "custom hardware filters and scale factors. \n"
-            " \n"
-            "This option specifies the number of shader \n"
-            "passes to use. If you set this to 0, and use \n"
-            "Apply Shader Changes, you use a 'blank' shader. \n"
-            " \n"
-            "The Default Filter option will affect the \n"
-            "stretching filter.");
-   }
-   else if (!strcmp(label, "video_shader_parameters"))
-   {
-      snprintf(msg, sizeof_msg,
-            "-- Shader Parameters. \n"
-            " \n"
-            "Modifies current shader directly. Will not be \n"
-            "saved to CGP/GLSLP preset file.");
-   }
-   else if (!strcmp(label, "video_shader_preset_parameters"))
-   {
-      snprintf(msg, sizeof_msg,
-            "-- Shader Preset Parameters. \n"
-            " \n"
-            "Modifies shader preset currently in menu."
-            );
-   }
-   else if (!strcmp(label, "video_shader_pass"))
-   {
-      snprintf(msg, sizeof_msg,
-            " -- Path to shader. \n"
-            " \n"
-            "All shaders must be of the same \n"
-            "type (i.e. CG, GLSL or HLSL). \n"
-            " \n"
-            "Set Shader Directory to set where \n"
-            "the browser starts to look for \n"
-            "shaders."
-            );
-   }
-   else if (!strcmp(label, "video_shader_filter_pass"))
-   {
-      snprintf(msg, sizeof_msg,
-            " -- Hardware filter for this pass. \n"
-            " \n"
-            "If 'Don't Care' is set, 'Default \n"
-            "Filter' will be used."
-            );
-   }
-   else if (!strcmp(label, "video_shader_scale_pass"))
-   {
-      snprintf(msg, sizeof_msg,
-            " -- Scale for this pass. \n"
-            " \n"
-            "The scale factor accumulates, i.e. 2x \n"
-            "for first pass and 2x for second pass \n"
-            "will give you a 4x total scale. \n"
-            " \n"
-            "If there is a scale factor for last \n"
-            "pass, the result is stretched to \n"
-            "screen with the filter specified in \n"
-            "'Default Filter'. \n"
-            " \n"
-            "If 'Don't Care' is set, either 1x \n"
-            "scale or stretch to fullscreen will \n"
-            "be used depending if it's not the last \n"
-            "pass or not."
-            );
-   }
-   else if (
-         !strcmp(label, "l_x_plus")  ||
-         !strcmp(label, "l_x_minus") ||
-         !strcmp(label, "l_y_plus")  ||
-         !strcmp(label, "l_y_minus")
-         )
-      snprintf(msg, sizeof_msg,
-            " -- Axis for analog stick (DualShock-esque).\n"
-            " \n"
-            "Bound as usual, however, if a real analog \n"
-            "axis is bound, it can be read as a true analog.\n"
-            " \n"
-            "Positive X axis is right. \n"
-            "Positive Y axis is down.");
-   else if (!strcmp(label, "turbo"))
-      snprintf(msg, sizeof_msg,
-            " -- Turbo enable.\n"
-            " \n"
-            "Holding the turbo while pressing another \n"
-            "button will let the button enter a turbo \n"
-            "mode where the button state is modulated \n"
-            "with a periodic signal. \n"
-            " \n"
-            "The modulation stops when the button \n"
-            "itself (not turbo button) is released.");
-   else if (!strcmp(label, "exit_emulator"))
-      snprintf(msg, sizeof_msg,
-            " -- Key to exit RetroArch cleanly."
-#if !defined(RARCH_MOBILE) && !defined(RARCH_CONSOLE)
-            "\nKilling it in any hard way (SIGKILL, \n"
-            "etc) will terminate without saving\n"
-            "RAM, etc. On Unix-likes,\n"
-            "SIGINT/SIGTERM allows\n"
-            "a clean deinitialization."
-#endif
-            );
-   else if (!strcmp(label, "rewind"))
-      snprintf(msg, sizeof_msg,
-            " -- Hold button down to rewind.\n"
-            " \n"
-            "Rewind must be enabled.");
-   else if (!strcmp(label, "load_state"))
-      snprintf(msg, sizeof_msg,
-            " -- Loads state.");
-   else if (!strcmp(label, "save_state"))
-      snprintf(msg, sizeof_msg,
-            " -- Saves state.");
-   else if (!strcmp(label, "state_slot_increase") ||
-         !strcmp(label, "state_slot_decrease"))
-      snprintf(msg, sizeof_msg,
-            " -- State slots.\n"
-            " \n"
-            " With slot set to 0, save state name is *.state \n"
-            " (or whatever defined on commandline).\n"
-            "When slot is != 0, path will be (path)(d), \n"
-            "where (d) is slot number.");
-   else if (!strcmp(label, "netplay_flip_players"))
-      snprintf(msg, sizeof_msg,
-            " -- Netplay flip players.");
-   else if (!strcmp(label, "frame_advance"))
-      snprintf(msg, sizeof_msg,
-            " -- Frame advance when content is paused.");
-   else if (!strcmp(label, "enable_hotkey"))
-      snprintf(msg, sizeof_msg,
-            " -- Enable other hotkeys.\n"
-            " \n"
-            " If this hotkey is bound to either keyboard, \n"
-            "joybutton or joyaxis, all other hotkeys will \n"
-            "be disabled unless this hotkey is also held \n"
-            "at the same time. \n"
-            " \n"
-            "This is useful for RETRO_KEYBOARD centric \n"
-            "implementations which query a large area of \n"
-            "the keyboard, where it is not desirable that \n"
-            "hotkeys get in the way.");
-   else if (!strcmp(label, "slowmotion"))
-      snprintf(msg, sizeof_msg,
-            " -- Hold for slowmotion.");
-   else if (!strcmp(label, "movie_record_toggle"))
-      snprintf(msg, sizeof_msg,
-            " -- Toggle between recording and not.");
-   else if (!strcmp(label, "pause_toggle"))
-      snprintf(msg, sizeof_msg,
-            " -- Toggle between paused and non-paused state.");
-   else if (!strcmp(label, "hold_fast_forward"))
-      snprintf(msg, sizeof_msg,
-            " -- Hold for fast-forward. Releasing button \n"
-            "disables fast-forward.");
-   else if (!strcmp(label, "shader_next"))
-      snprintf(msg, sizeof_msg,
-            " -- Applies next shader in directory.");
-   else if (!strcmp(label, "reset"))
-      snprintf(msg, sizeof_msg,
-            " -- Reset the content.\n");
-   else if (!strcmp(label, "cheat_index_plus"))
-      snprintf(msg, sizeof_msg,
-            " -- Increment cheat index.\n");
-   else if (!strcmp(label, "cheat_index_minus"))
-      snprintf(msg, sizeof_msg,
-            " -- Decrement cheat index.\n");
-   else if (!strcmp(label, "cheat_toggle"))
-      snprintf(msg, sizeof_msg,
-            " -- Toggle cheat index.\n");
-   else if (!strcmp(label, "shader_prev"))
-      snprintf(msg, sizeof_msg,
-            " -- Applies previous shader in directory.");
-   else if (!strcmp(label, "audio_mute"))
-      snprintf(msg, sizeof_msg,
-            " -- Mute/unmute audio.");
-   else if (!strcmp(label, "screenshot"))
-      snprintf(msg, sizeof_msg,
-            " -- Take screenshot.");
-   else if (!strcmp(label, "volume_up"))
-      snprintf(msg, sizeof_msg,
-            " -- Increases audio volume.");
-   else if (!strcmp(label, "volume_down"))
-      snprintf(msg, sizeof_msg,
-            " -- Decreases audio volume.");
-   else if (!strcmp(label, "overlay_next"))
-      snprintf(msg, sizeof_msg,
-            " -- Toggles to next overlay.\n"
-            " \n"
-            "Wraps around.");
-   else if (!strcmp(label, "disk_eject_toggle"))
-      snprintf(msg, sizeof_msg,
-            " -- Toggles eject for disks.\n"
-            " \n"
-            "Used for multiple-disk content.");
-   else if (!strcmp(label, "disk_next"))
-      snprintf(msg, sizeof_msg,
-            " -- Cycles through disk images. Use after \n"
-            "ejecting. \n"
-            " \n"
-            " Complete by toggling eject again.");
-   else if (!strcmp(label, "grab_mouse_toggle"))
-      snprintf(msg, sizeof_msg,
-            " -- Toggles mouse grab.\n"
-            " \n"
-            "When mouse is grabbed, RetroArch hides the \n"
-            "mouse, and keeps the mouse pointer inside \n"
-            "the window to allow relative mouse input to \n"
-            "work better.");
-   else if (!strcmp(label, "menu_toggle"))
-      snprintf(msg, sizeof_msg,
-            " -- Toggles menu.");
-   else if (!strcmp(label, "input_bind_device_id"))
-      snprintf(msg, sizeof_msg,
-            " -- Input Device. \n"
-            " \n"
-            "Picks which gamepad to use for player N. \n"
-            "The name of the pad is available."
-            );
-   else if (!strcmp(label, "input_bind_device_type"))
-      snprintf(msg, sizeof_msg,
-            " -- Input Device Type. \n"
-            " \n"
-            "Picks which device type to use. This is \n"
-            "relevant for the libretro core itself."
-            );
    else
       snprintf(msg, sizeof_msg,
             "-- No info on this item is available. --\n");
@@ -2684,6 +2669,45 @@ bool setting_data_append_list_general_options(
             general_read_handler);
    settings_list_current_add_range(list, list_info, 1, 32768, 1, true, false);
 
+   CONFIG_BOOL(
+         g_settings.run_ahead_enable,
+         "run_ahead_enable",
+         "Run-Ahead",
+         run_ahead_enable,
+         "OFF",
+         "ON",
+         group_info.name,
+         subgroup_info.name,
+         general_write_handler,
+         general_read_handler);
+   settings_list_current_add_cmd(list, list_info, RARCH_CMD_RUNAHEAD_TOGGLE);
+   settings_list_current_add_flags(list, list_info, SD_FLAG_CMD_APPLY_AUTO);
+
+   CONFIG_UINT(
+         g_settings.run_ahead_frames,
+         "run_ahead_frames",
+         "Run-Ahead Frames",
+         run_ahead_frames,
+         group_info.name,
+         subgroup_info.name,
+         general_write_handler,
+         general_read_handler);
+   settings_list_current_add_range(list, list_info, 1, 6, 1, true, true);
+   settings_list_current_add_cmd(list, list_info, RARCH_CMD_RUNAHEAD_TOGGLE);
+   settings_list_current_add_flags(list, list_info, SD_FLAG_CMD_APPLY_AUTO);
+
+   CONFIG_BOOL(
+         g_settings.run_ahead_secondary_instance,
+         "run_ahead_secondary_instance",
+         "Run-Ahead Secondary Instance",
+         run_ahead_secondary_instance,
+         "OFF",
+         "ON",
+         group_info.name,
+         subgroup_info.name,
+         general_write_handler,
+         general_read_handler);
+
    CONFIG_BOOL(
          g_settings.block_sram_overwrite,
          "block_sram_overwrite",
@@ -2809,6 +2833,18 @@ bool setting_data_append_list_general_options(
          general_write_handler,
          general_read_handler);
 
+   CONFIG_BOOL(
+         g_settings.savestate_compression,
+         "savestate_compression",
+         "Compress State",
+         savestate_compression,
+         "OFF",
+         "ON",
+         group_info.name,
+         subgroup_info.name,
+         general_write_handler,
+         general_read_handler);
+
    CONFIG_INT(
          g_settings.state_slot,
          "state_slot",
@@ -2819,6 +2855,17 @@ bool setting_data_append_list_general_options(
          general_write_handler,
          general_read_handler);
 
+   CONFIG_UINT(
+         g_settings.movie_keyframe_interval,
+         "movie_keyframe_interval",
+         "Movie Keyframe Interval",
+         movie_keyframe_interval,
+         group_info.name,
+         subgroup_info.name,
+         general_write_handler,
+         general_read_handler);
+   settings_list_current_add_range(list, list_info, 0, 36000, 60, true, true);
+
    END_SUB_GROUP(list, list_info);
    START_SUB_GROUP(
          list,
@@ -2859,6 +2906,21 @@ bool setting_data_append_list_general_options(
          subgroup_info.name,
          general_write_handler,
          general_read_handler);
+#endif
+#ifdef HAVE_CONTROL
+   CONFIG_BOOL(
+         g_settings.control_socket_enable,
+         "control_socket_enable",
+         "Control Socket",
+         control_socket_enable,
+         "OFF",
+         "ON",
+         group_info.name,
+         subgroup_info.name,
+         general_write_handler,
+         general_read_handler);
+   settings_list_current_add_cmd(list, list_info, RARCH_CMD_CONTROL_INIT);
+   settings_list_current_add_flags(list, list_info, SD_FLAG_CMD_APPLY_AUTO);
 #endif
    END_SUB_GROUP(list, list_info);
    END_GROUP(list, list_info);
@@ -3230,6 +3292,18 @@ bool setting_data_append_list_video_options(
    settings_list_current_add_flags(list, list_info, SD_FLAG_CMD_APPLY_AUTO);
 #endif
 
+   CONFIG_BOOL(
+         g_settings.video.frame_dupe_detect,
+         "video_frame_dupe_detect",
+         "Duplicate Frame Detection",
+         frame_dupe_detect,
+         "OFF",
+         "ON",
+         group_info.name,
+         subgroup_info.name,
+         general_write_handler,
+         general_read_handler);
+
    CONFIG_BOOL(
          g_settings.video.vsync,
          "video_vsync",
@@ -4483,6 +4557,17 @@ bool setting_data_append_list_path_options(
          subgroup_info.name,
          general_write_handler,
          general_read_handler);
+
+   CONFIG_DIR(
+         g_settings.patch_cache_directory,
+         "patch_cache_directory",
+         "Patch Cache Directory",
+         "",
+         "<None>",
+         group_info.name,
+         subgroup_info.name,
+         general_write_handler,
+         general_read_handler);
    END_SUB_GROUP(list, list_info);
    END_GROUP(list, list_info);
 
@@ -4542,6 +4627,7 @@ rarch_setting_t *setting_data_get_mainmenu(bool need_refresh)
       if (!need_refresh)
          return list;
 
+      setting_index_free(&setting_mainmenu_index);
       settings_list_free(list);
    }
 
@@ -4565,6 +4651,7 @@ rarch_setting_t *setting_data_get_mainmenu(bool need_refresh)
             realloc(list, list_info->index * sizeof(rarch_setting_t))))
       goto error;
 
+   setting_index_build(&setting_mainmenu_index, list);
    settings_info_list_free(list_info);
 
    /* do not optimize into return realloc(),
@@ -4574,6 +4661,7 @@ rarch_setting_t *setting_data_get_mainmenu(bool need_refresh)
 error:
    RARCH_ERR("Allocation failed.\n");
    settings_info_list_free(list_info);
+   setting_index_free(&setting_mainmenu_index);
    settings_list_free(list);
 
    return NULL;
@@ -4592,6 +4680,7 @@ rarch_setting_t *setting_data_get_list(unsigned mask, bool need_refresh)
          if (!need_refresh)
             return list;
 
+      setting_index_free(&setting_list_index);
       settings_list_free(list);
    }
 
@@ -4696,6 +4785,7 @@ rarch_setting_t *setting_data_get_list(unsigned mask, bool need_refresh)
             realloc(list, list_info->index * sizeof(rarch_setting_t))))
       goto error;
 
+   setting_index_build(&setting_list_index, list);
    settings_info_list_free(list_info);
 
    last_mask = mask;
@@ -4707,6 +4797,7 @@ rarch_setting_t *setting_data_get_list(unsigned mask, bool need_refresh)
 error:
    RARCH_ERR("Allocation failed.\n");
    settings_info_list_free(list_info);
+   setting_index_free(&setting_list_index);
    settings_list_free(list);
 
    return NULL;
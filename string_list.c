@@ -23,14 +23,172 @@
 #include "string_list.h"
 #include "compat/posix_string.h"
 
+#define STRING_ARENA_BLOCK_MIN 1024
+#define STRING_ARENA_BLOCK_MAX (64 * 1024)
+
+struct string_arena_block
+{
+   struct string_arena_block *next;
+   size_t size;
+   /* Followed by size bytes of string data. */
+};
+
+#define STRING_ARENA_BLOCK_DATA(block) ((char*)((block) + 1))
+
+static void string_arena_free_blocks(struct string_arena_block *block)
+{
+   while (block)
+   {
+      struct string_arena_block *next = block->next;
+      free(block);
+      block = next;
+   }
+}
+
+static bool string_arena_grow(struct string_arena *arena, size_t size)
+{
+   size_t block_size;
+   struct string_arena_block *block = NULL;
+
+   /* The inline buffer is only handed out while nothing else is. */
+   if (!arena->blocks && !arena->ptr && size <= sizeof(arena->inline_buf))
+   {
+      arena->ptr  = arena->inline_buf;
+      arena->left = sizeof(arena->inline_buf);
+      return true;
+   }
+
+   block_size = arena->blocks ?
+      arena->blocks->size * 2 : STRING_ARENA_BLOCK_MIN;
+   if (block_size < STRING_ARENA_BLOCK_MIN)
+      block_size = STRING_ARENA_BLOCK_MIN;
+   if (block_size > STRING_ARENA_BLOCK_MAX)
+      block_size = STRING_ARENA_BLOCK_MAX;
+   if (block_size < size)
+      block_size = size;
+
+   block = (struct string_arena_block*)malloc(sizeof(*block) + block_size);
+   if (!block)
+      return false;
+
+   block->next   = arena->blocks;
+   block->size   = block_size;
+   arena->blocks = block;
+   arena->ptr    = STRING_ARENA_BLOCK_DATA(block);
+   arena->left   = block_size;
+   return true;
+}
+
+char *string_arena_strndup(struct string_arena *arena,
+      const char *str, size_t len)
+{
+   char *ret = NULL;
+
+   if (!str)
+      return NULL;
+
+   if (len + 1 > arena->left && !string_arena_grow(arena, len + 1))
+      return NULL;
+
+   ret = arena->ptr;
+   memcpy(ret, str, len);
+   ret[len] = '\0';
+
+   arena->ptr  += len + 1;
+   arena->left -= len + 1;
+   arena->used += len + 1;
+   return ret;
+}
+
+char *string_arena_strdup(struct string_arena *arena, const char *str)
+{
+   if (!str)
+      return NULL;
+   return string_arena_strndup(arena, str, strlen(str));
+}
+
+void string_arena_release(struct string_arena *arena, const char *str)
+{
+   if (str)
+      arena->garbage += strlen(str) + 1;
+}
+
+bool string_arena_should_compact(const struct string_arena *arena)
+{
+   return arena->garbage > STRING_ARENA_BLOCK_MIN &&
+      arena->garbage * 2 > arena->used;
+}
+
+bool string_arena_compact_begin(struct string_arena *arena)
+{
+   size_t live = arena->used - arena->garbage;
+   struct string_arena_block *block = NULL;
+
+   rarch_assert(!arena->retired);
+
+   /* Sized for exactly the live strings, so nothing lands in
+    * the inline buffer while old strings may still be read from it. */
+   if (live)
+   {
+      block = (struct string_arena_block*)malloc(sizeof(*block) + live);
+      if (!block)
+         return false;
+      block->next = NULL;
+      block->size = live;
+   }
+
+   arena->retired = arena->blocks;
+   arena->blocks  = block;
+   arena->ptr     = block ? STRING_ARENA_BLOCK_DATA(block) : NULL;
+   arena->left    = live;
+   arena->used    = 0;
+   arena->garbage = 0;
+   return true;
+}
+
+void string_arena_compact_end(struct string_arena *arena)
+{
+   string_arena_free_blocks(arena->retired);
+   arena->retired = NULL;
+}
+
+void string_arena_clear(struct string_arena *arena)
+{
+   if (arena->blocks)
+   {
+      string_arena_free_blocks(arena->blocks->next);
+      arena->blocks->next = NULL;
+      arena->ptr  = STRING_ARENA_BLOCK_DATA(arena->blocks);
+      arena->left = arena->blocks->size;
+   }
+   else
+   {
+      arena->ptr  = NULL;
+      arena->left = 0;
+   }
+
+   arena->used    = 0;
+   arena->garbage = 0;
+}
+
+void string_arena_free(struct string_arena *arena)
+{
+   string_arena_free_blocks(arena->blocks);
+   string_arena_free_blocks(arena->retired);
+   arena->blocks  = NULL;
+   arena->retired = NULL;
+   arena->ptr     = NULL;
+   arena->left    = 0;
+   arena->used    = 0;
+   arena->garbage = 0;
+}
+
 void string_list_free(struct string_list *list)
 {
-   size_t i;
    if (!list)
       return;
 
-   for (i = 0; i < list->size; i++)
-      free(list->elems[i].data);
+   string_arena_free(&list->arena);
    free(list->elems);
    free(list);
 }
@@ -68,30 +226,54 @@ struct string_list *string_list_new(void)
    return list;
 }
 
-bool string_list_append(struct string_list *list, const char *elem,
-      union string_list_elem_attr attr)
+static bool string_list_append_n(struct string_list *list, const char *elem,
+      size_t len, union string_list_elem_attr attr)
 {
-   char *dup;
+   char *data;
    if (list->size >= list->cap &&
          !string_list_capacity(list, list->cap * 2))
       return false;
 
-   dup = strdup(elem);
-   if (!dup)
+   data = string_arena_strndup(&list->arena, elem, len);
+   if (!data)
       return false;
 
-   list->elems[list->size].data = dup;
+   list->elems[list->size].data = data;
    list->elems[list->size].attr = attr;
 
    list->size++;
    return true;
 }
 
+bool string_list_append(struct string_list *list, const char *elem,
+      union string_list_elem_attr attr)
+{
+   return string_list_append_n(list, elem, strlen(elem), attr);
+}
+
+static void string_list_compact(struct string_list *list)
+{
+   size_t i;
+
+   if (!string_arena_compact_begin(&list->arena))
+      return;
+
+   for (i = 0; i < list->size; i++)
+      list->elems[i].data = string_arena_strdup(&list->arena,
+            list->elems[i].data);
+
+   string_arena_compact_end(&list->arena);
+}
+
 void string_list_set(struct string_list *list,
       unsigned index, const char *str)
 {
-   free(list->elems[index].data);
-   rarch_assert(list->elems[index].data = strdup(str));
+   string_arena_release(&list->arena, list->elems[index].data);
+   rarch_assert(list->elems[index].data =
+         string_arena_strdup(&list->arena, str));
+
+   if (string_arena_should_compact(&list->arena))
+      string_list_compact(list);
 }
 
 void string_list_join_concat(char *buffer, size_t size,
@@ -110,39 +292,35 @@ void string_list_join_concat(char *buffer, size_t size,
    }
 }
 
+/* Same tokens as strtok_r(), but copied straight into the arena. */
 struct string_list *string_split(const char *str, const char *delim)
 {
-   char *save      = NULL;
-   char *copy      = NULL;
-   const char *tmp = NULL;
+   union string_list_elem_attr attr;
    struct string_list *list = string_list_new();
 
    if (!list)
-      goto error;
+      return NULL;
 
-   copy = strdup(str);
-   if (!copy)
-      goto error;
+   memset(&attr, 0, sizeof(attr));
 
-   tmp = strtok_r(copy, delim, &save);
-   while (tmp)
+   for (;;)
    {
-      union string_list_elem_attr attr;
-      memset(&attr, 0, sizeof(attr));
-
-      if (!string_list_append(list, tmp, attr))
-         goto error;
-
-      tmp = strtok_r(NULL, delim, &save);
+      size_t len;
+
+      str += strspn(str, delim);
+      if (!*str)
+         break;
+
+      len = strcspn(str, delim);
+      if (!string_list_append_n(list, str, len, attr))
+      {
+         string_list_free(list);
+         return NULL;
+      }
+      str += len;
    }
 
-   free(copy);
    return list;
-
-error:
-   string_list_free(list);
-   free(copy);
-   return NULL;
 }
 
 bool string_list_find_elem(const struct string_list *list, const char *elem)
@@ -38,11 +38,57 @@ struct string_list_elem
    union string_list_elem_attr attr;
 };
 
+/* Bump allocator for strings which are freed all at once.
+ *
+ * A zeroed arena is empty and valid. The first strings go to the
+ * inline buffer, later ones to heap blocks of growing size, so a
+ * list of N strings costs a handful of allocations instead of N.
+ * Individual strings cannot be freed, only released for accounting;
+ * owners compact when enough has been released. */
+#define STRING_ARENA_INLINE_SIZE 256
+
+struct string_arena_block;
+
+struct string_arena
+{
+   struct string_arena_block *blocks;
+   struct string_arena_block *retired;
+   char *ptr;
+   size_t left;
+   size_t used;
+   size_t garbage;
+   char inline_buf[STRING_ARENA_INLINE_SIZE];
+};
+
+char *string_arena_strndup(struct string_arena *arena,
+      const char *str, size_t len);
+
+char *string_arena_strdup(struct string_arena *arena, const char *str);
+
+/* Marks str as unused. Its memory is reclaimed by compaction
+ * or string_arena_clear(). */
+void string_arena_release(struct string_arena *arena, const char *str);
+
+bool string_arena_should_compact(const struct string_arena *arena);
+
+/* Compaction: after string_arena_compact_begin() succeeds, every live
+ * string must be copied again with string_arena_strdup(). Old strings
+ * stay readable until string_arena_compact_end(). */
+bool string_arena_compact_begin(struct string_arena *arena);
+
+void string_arena_compact_end(struct string_arena *arena);
+
+/* Drops all strings but keeps the newest block around for reuse. */
+void string_arena_clear(struct string_arena *arena);
+
+void string_arena_free(struct string_arena *arena);
+
 struct string_list
 {
    struct string_list_elem *elems;
    size_t size;
    size_t cap;
+   struct string_arena arena;
 };
 
 bool string_list_find_elem(const struct string_list *list, const char *elem);
@@ -0,0 +1,184 @@
+/*  RetroArch - A frontend for libretro.
+ *  Copyright (C) 2010-2014 - Hans-Kristian Arntzen
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Autoconfigures joypads against a directory of profiles, matching
+ * by vendor/product ID, by name and driver, and by "<name>_p<port>",
+ * then adds and edits profiles and checks that the index notices.
+ * Times a hotplug against the first one, which indexes the directory. */
+
+#include "../input/input_common.h"
+#include "../input/input_autodetect.h"
+#include "../general.h"
+#include "../conf/config_file.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#define TEST_DIR "autodetect_test.d"
+#define NUM_PROFILES 500
+
+struct settings g_settings;
+struct global g_extern;
+
+const struct input_bind_map input_config_bind_map[RARCH_BIND_LIST_END];
+
+static int profile;
+
+/* Stands in for parsing the binds, notes which profile was applied. */
+void input_config_parse_joy_button(config_file_t *conf, const char *prefix,
+      const char *btn, struct retro_keybind *bind)
+{
+   (void)prefix;
+   (void)btn;
+   (void)bind;
+   config_get_int(conf, "profile", &profile);
+}
+
+void input_config_parse_joy_axis(config_file_t *conf, const char *prefix,
+      const char *axis, struct retro_keybind *bind)
+{
+   (void)conf;
+   (void)prefix;
+   (void)axis;
+   (void)bind;
+}
+
+void msg_queue_push(msg_queue_t *queue, const char *msg,
+      unsigned prio, unsigned duration)
+{
+   (void)queue;
+   (void)msg;
+   (void)prio;
+   (void)duration;
+}
+
+static void fail(const char *msg)
+{
+   fprintf(stderr, "FAIL: %s.\n", msg);
+   exit(1);
+}
+
+static double get_time(void)
+{
+   struct timespec tv;
+   clock_gettime(CLOCK_MONOTONIC, &tv);
+   return tv.tv_sec + tv.tv_nsec / 1000000000.0;
+}
+
+static void write_profile(unsigned id, const char *ident, const char *driver,
+      int vid, int pid)
+{
+   char path[PATH_MAX];
+   FILE *file;
+
+   snprintf(path, sizeof(path), TEST_DIR "/pad%04u.cfg", id);
+   file = fopen(path, "w");
+   fprintf(file, "input_device = \"%s\"\ninput_driver = \"%s\"\n",
+         ident, driver);
+   if (vid || pid)
+      fprintf(file, "input_vendor_id = %d\ninput_product_id = %d\n",
+            vid, pid);
+   fprintf(file, "profile = %u\ninput_a_btn = \"0\"\n", id);
+   fclose(file);
+}
+
+/* Returns the profile applied, or -1. */
+static int plug(unsigned port, const char *name, int vid, int pid,
+      const char *driver)
+{
+   profile = -1;
+   input_config_autoconfigure_joypad(port, name, vid, pid, driver);
+   if (g_settings.input.autoconfigured[port] != (profile >= 0))
+      fail("autoconfigured flag");
+   return profile;
+}
+
+int main(void)
+{
+   unsigned i;
+   char name[64];
+   double start, first, hotplug;
+
+   mkdir(TEST_DIR, 0755);
+   for (i = 0; i < NUM_PROFILES; i++)
+   {
+      snprintf(name, sizeof(name), "Pad %u", i);
+      write_profile(i, name, i & 1 ? "udev" : "linuxraw",
+            i % 3 ? 0x1000 + i : 0, i % 3 ? 0x2000 + i : 0);
+   }
+   /* Same device under another name, the first one in order wins. */
+   write_profile(NUM_PROFILES, "Pad 0 again", "udev", 0x1001, 0x2001);
+
+   g_settings.input.autodetect_enable = true;
+   strlcpy(g_settings.input.autoconfig_dir, TEST_DIR,
+         sizeof(g_settings.input.autoconfig_dir));
+
+   /* The index isn't trusted in the second the directory changed. */
+   sleep(1);
+
+   start = get_time();
+   if (plug(0, "Pad 1", 0x1001, 0x2001, "udev") != 1)
+      fail("vid/pid");
+   first = get_time() - start;
+
+   start = get_time();
+   for (i = 0; i < 100; i++)
+      if (plug(0, "Pad 1", 0x1001, 0x2001, "udev") != 1)
+         fail("vid/pid");
+   hotplug = (get_time() - start) / 100;
+
+   if (plug(1, "Pad 2", 0, 0, "linuxraw") != 2)
+      fail("name of a profile with IDs");
+   if (plug(1, "Pad 3", 0, 0, "linuxraw") != -1)
+      fail("name with wrong driver");
+   if (plug(1, "Pad 3", 0, 0, "udev") != 3)
+      fail("name and driver");
+   if (plug(2, "Pad 6_p2", 0, 0, "anything") != 6)
+      fail("name with port");
+   if (plug(2, "Pad 6_p1", 0, 0, "anything") != -1)
+      fail("name with wrong port");
+   if (plug(0, "Nothing", 0x1234, 0x5678, "udev") != -1)
+      fail("unknown pad");
+   if (plug(0, NULL, 0, 0, NULL) != -1)
+      fail("unplugged");
+
+   /* New profile, the directory's mtime changes. */
+   write_profile(NUM_PROFILES + 1, "New pad", "udev", 0x4242, 0x4343);
+   if (plug(0, "New pad", 0x4242, 0x4343, "udev") != NUM_PROFILES + 1)
+      fail("added profile");
+
+   /* Edited in place, the directory's mtime doesn't change. */
+   sleep(1);
+   plug(0, "Pad 4", 0, 0, "linuxraw");
+   write_profile(4, "Pad 4 renamed", "linuxraw", 0, 0);
+   if (plug(0, "Pad 4", 0, 0, "linuxraw") != -1)
+      fail("edited profile");
+
+   printf("%u profiles: first lookup %.2f ms, hotplug %.3f ms.\n",
+         NUM_PROFILES + 2, first * 1000.0, hotplug * 1000.0);
+
+   for (i = 0; i < NUM_PROFILES + 2; i++)
+   {
+      char path[PATH_MAX];
+      snprintf(path, sizeof(path), TEST_DIR "/pad%04u.cfg", i);
+      remove(path);
+   }
+   rmdir(TEST_DIR);
+   printf("Autoconfig matches.\n");
+   return 0;
+}
@@ -0,0 +1,174 @@
+/*  RetroArch - A frontend for libretro.
+ *  Copyright (C) 2010-2014 - Hans-Kristian Arntzen
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Autosaves SRAM while it is changed in a few places, then as a
+ * whole, and checks the file after each. Replays a journal left by
+ * an interrupted autosave and drops a torn one. Measures how long
+ * taking the lock is held up while large SRAM is being checked. */
+
+#include "../autosave.h"
+#include "../general.h"
+#include "../file_path.h"
+#include "../hash.h"
+#include "../endianness.h"
+#include "../thread.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define TEST_PATH "autosave_test.srm"
+#define TEST_JOURNAL TEST_PATH ".journal"
+
+struct settings g_settings;
+struct global g_extern;
+
+static double get_time(void)
+{
+   struct timespec tv;
+   clock_gettime(CLOCK_MONOTONIC, &tv);
+   return tv.tv_sec + tv.tv_nsec / 1000000000.0;
+}
+
+static void fail(const char *msg)
+{
+   fprintf(stderr, "FAIL: %s.\n", msg);
+   exit(1);
+}
+
+static void check_file(const uint8_t *sram, size_t size)
+{
+   void *file = NULL;
+   long len = read_file(TEST_PATH, &file);
+   if (len != (long)size || memcmp(file, sram, size))
+      fail("save file");
+   free(file);
+   if (path_file_exists(TEST_JOURNAL))
+      fail("journal left behind");
+}
+
+static void put_le32(uint8_t *out, uint32_t val)
+{
+   val = swap_if_big32(val);
+   memcpy(out, &val, sizeof(val));
+}
+
+/* One range of 8 bytes at offset 100. */
+static size_t make_journal(uint8_t *out, uint32_t file_size)
+{
+   memcpy(out, "RASRAMJ\0", 8);
+   put_le32(out +  8, file_size);
+   put_le32(out + 12, 1);
+   put_le32(out + 16, 100);
+   put_le32(out + 20, 8);
+   memcpy(out + 24, "JOURNAL!", 8);
+   put_le32(out + 32, crc32_calculate(out, 32));
+   return 36;
+}
+
+int main(void)
+{
+   unsigned i;
+   size_t size = 256 * 1024;
+   uint8_t journal[64];
+   double start, worst = 0.0;
+   autosave_t *save;
+   uint8_t *sram = (uint8_t*)calloc(1, size);
+   uint8_t *expected = (uint8_t*)calloc(1, size);
+
+   remove(TEST_PATH);
+   remove(TEST_JOURNAL);
+
+   /* No save file yet, nothing is written until SRAM changes. */
+   save = autosave_new(TEST_PATH, sram, size, 1);
+   retro_sleep(2500);
+   if (path_file_exists(TEST_PATH))
+      fail("written without changes");
+
+   autosave_lock(save);
+   sram[5] = 1;
+   autosave_unlock(save);
+   retro_sleep(2500);
+   check_file(sram, size);
+
+   /* A few scattered bytes go through the journal. */
+   autosave_lock(save);
+   sram[4096 * 3 + 7] = 2;
+   sram[4096 * 40]    = 3;
+   sram[size - 1]     = 4;
+   autosave_unlock(save);
+   retro_sleep(2500);
+   check_file(sram, size);
+
+   /* Most of it changed, rewritten as a whole. */
+   autosave_lock(save);
+   for (i = 0; i < size; i += 512)
+      sram[i] = i >> 9;
+   autosave_unlock(save);
+   retro_sleep(2500);
+   check_file(sram, size);
+   autosave_free(save);
+
+   /* Changed while no autosave was running. */
+   sram[1000] = 5;
+   save = autosave_new(TEST_PATH, sram, size, 1);
+   retro_sleep(2500);
+   autosave_free(save);
+   check_file(sram, size);
+
+   /* An autosave interrupted after its journal was written. */
+   memcpy(expected, sram, size);
+   memcpy(expected + 100, "JOURNAL!", 8);
+   write_file(TEST_JOURNAL, journal, make_journal(journal, size));
+   if (!autosave_recover(TEST_PATH))
+      fail("journal not replayed");
+   check_file(expected, size);
+
+   /* One interrupted while writing the journal. */
+   make_journal(journal, size);
+   write_file(TEST_JOURNAL, journal, 30);
+   if (autosave_recover(TEST_PATH))
+      fail("torn journal replayed");
+   check_file(expected, size);
+
+   /* How long the frame would wait for the lock
+    * while 16 MB of SRAM are checked. */
+   free(sram);
+   size = 16 * 1024 * 1024;
+   sram = (uint8_t*)calloc(1, size);
+   write_file(TEST_PATH, sram, size);
+   save = autosave_new(TEST_PATH, sram, size, 1);
+   start = get_time();
+   while (get_time() - start < 3.0)
+   {
+      double lock_start = get_time();
+      autosave_lock(save);
+      if (get_time() - lock_start > worst)
+         worst = get_time() - lock_start;
+      sram[rand() % size]++;
+      autosave_unlock(save);
+      retro_sleep(1);
+   }
+   retro_sleep(2500);
+   autosave_free(save);
+   check_file(sram, size);
+   printf("Longest wait for the lock: %.3f ms.\n", worst * 1000.0);
+
+   remove(TEST_PATH);
+   free(sram);
+   free(expected);
+   printf("Autosaves match.\n");
+   return 0;
+}
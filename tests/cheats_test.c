@@ -0,0 +1,231 @@
+/*  RetroArch - A frontend for libretro.
+ *  Copyright (C) 2010-2014 - Hans-Kristian Arntzen
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Loads cheats out of a large XML database, which gets converted to
+ * an index on first use. Checks that the index is used afterwards,
+ * picked up when pointed to directly, and converted again when the
+ * XML changes or the index is damaged. */
+
+#include "../cheats.h"
+#include "../general.h"
+#include "../dynamic.h"
+#include "../message_queue.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define TEST_XML "cheats_test.xml"
+#define TEST_INDEX "cheats_test.idx"
+#define TEST_SETTINGS "cheats_test.cfg"
+#define TEST_CARTRIDGES 20000
+
+struct settings g_settings;
+struct global g_extern;
+
+static char cheat_codes[8][64];
+static unsigned num_cheat_codes;
+static char last_msg[256];
+
+static void cheat_reset(void)
+{
+   num_cheat_codes = 0;
+}
+
+static void cheat_set(unsigned index, bool enabled, const char *code)
+{
+   if (index < 8)
+      strncpy(cheat_codes[index], code, sizeof(cheat_codes[index]) - 1);
+   if (index + 1 > num_cheat_codes)
+      num_cheat_codes = index + 1;
+}
+
+void (*pretro_cheat_reset)(void) = cheat_reset;
+void (*pretro_cheat_set)(unsigned, bool, const char*) = cheat_set;
+
+void msg_queue_clear(msg_queue_t *queue)
+{
+}
+
+void msg_queue_push(msg_queue_t *queue, const char *msg,
+      unsigned prio, unsigned duration)
+{
+   strncpy(last_msg, msg, sizeof(last_msg) - 1);
+}
+
+static void fail(const char *msg)
+{
+   fprintf(stderr, "FAIL: %s.\n", msg);
+   exit(1);
+}
+
+static void cartridge_sha256(char *out, unsigned i)
+{
+   snprintf(out, 65, "%08x%056x", i * 2654435761u, i);
+}
+
+static void write_cartridge(FILE *file, unsigned i, const char *tag)
+{
+   unsigned j;
+   char sha256[65];
+
+   cartridge_sha256(sha256, i);
+   /* Some databases have upper case hashes. */
+   if (i % 7 == 0)
+   {
+      char *ptr;
+      for (ptr = sha256; *ptr; ptr++)
+         if (*ptr >= 'a' && *ptr <= 'f')
+            *ptr -= 'a' - 'A';
+   }
+
+   fprintf(file, "  <cartridge sha256=\"%s\">\n", sha256);
+   fprintf(file, "    <name>Game %u</name>\n", i);
+   for (j = 0; j < 3; j++)
+   {
+      fprintf(file, "    <cheat>\n");
+      fprintf(file, "      <description>%s %u-%u</description>\n", tag, i, j);
+      fprintf(file, "      <code>%04X-%04X</code>\n", i & 0xffff, j);
+      if (j == 1)
+         fprintf(file, "      <code>%04X-BEEF</code>\n", i & 0xffff);
+      fprintf(file, "    </cheat>\n");
+   }
+   fprintf(file, "  </cartridge>\n");
+}
+
+static void write_database(unsigned extra)
+{
+   unsigned i;
+   FILE *file = fopen(TEST_XML, "w");
+   if (!file)
+      fail("couldn't write the database");
+
+   fprintf(file, "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n");
+   fprintf(file, "<database>\n");
+   for (i = 0; i < TEST_CARTRIDGES; i++)
+      write_cartridge(file, i, "Cheat");
+   /* A duplicate, which mustn't win over the first one. */
+   write_cartridge(file, 42, "Duplicate");
+   for (i = 0; i < extra; i++)
+      write_cartridge(file, TEST_CARTRIDGES + i, "Cheat");
+   fprintf(file, "</database>\n");
+   fclose(file);
+}
+
+static double now(void)
+{
+   struct timespec ts;
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/* Loads the cheats for a cartridge, checks them and
+ * returns the time it took. */
+static double load(const char *path, unsigned i, bool expect)
+{
+   char expected[64];
+   cheat_manager_t *handle;
+   FILE *file;
+   double start;
+
+   cartridge_sha256(g_extern.sha256, i);
+
+   /* Cheats 1 and 2 enabled. */
+   file = fopen(TEST_SETTINGS, "w");
+   if (!file)
+      fail("couldn't write the cheat settings");
+   fprintf(file, "%s = \"1;2\"\n", g_extern.sha256);
+   fclose(file);
+
+   num_cheat_codes = 0;
+   start = now();
+   handle = cheat_manager_new(path);
+   start = now() - start;
+
+   if (!expect)
+   {
+      if (handle)
+         fail("found cheats for a missing cartridge");
+      return start;
+   }
+
+   if (!handle)
+      fail("didn't find cheats for a cartridge");
+
+   if (num_cheat_codes != 2)
+      fail("enabled cheats weren't applied");
+   snprintf(expected, sizeof(expected), "%04X-0001+%04X-BEEF",
+         i & 0xffff, i & 0xffff);
+   if (strcmp(cheat_codes[0], expected))
+      fail("codes of a cheat weren't joined");
+   snprintf(expected, sizeof(expected), "%04X-0002", i & 0xffff);
+   if (strcmp(cheat_codes[1], expected))
+      fail("wrong code for a cheat");
+
+   cheat_manager_index_next(handle);
+   snprintf(expected, sizeof(expected), "Cheat: #1 [ON]: Cheat %u-1", i);
+   if (strcmp(last_msg, expected))
+      fail("wrong cheat description");
+
+   cheat_manager_free(handle);
+   return start;
+}
+
+int main(void)
+{
+   double convert, indexed, direct;
+   FILE *file;
+
+   strcpy(g_settings.cheat_settings_path, TEST_SETTINGS);
+   remove(TEST_INDEX);
+   write_database(0);
+
+   convert = load(TEST_XML, TEST_CARTRIDGES / 2, true);
+   if (!(file = fopen(TEST_INDEX, "rb")))
+      fail("index wasn't written");
+   fclose(file);
+
+   indexed = load(TEST_XML, TEST_CARTRIDGES / 2 + 1, true);
+   load(TEST_XML, 0, true);
+   load(TEST_XML, 7, true);
+   load(TEST_XML, 42, true);
+   load(TEST_XML, TEST_CARTRIDGES - 1, true);
+   load(TEST_XML, TEST_CARTRIDGES, false);
+   direct = load(TEST_INDEX, 1234, true);
+
+   /* Changing the database converts it again. */
+   write_database(1);
+   load(TEST_XML, TEST_CARTRIDGES, true);
+
+   /* So does a damaged index. */
+   if (!(file = fopen(TEST_INDEX, "wb")))
+      fail("couldn't damage the index");
+   fputs("CIDX", file);
+   fclose(file);
+   load(TEST_XML, 99, true);
+
+   /* Without the XML, the index is enough. */
+   remove(TEST_XML);
+   load(TEST_XML, 4321, true);
+
+   remove(TEST_INDEX);
+   remove(TEST_SETTINGS);
+
+   printf("%u cartridges: converting %.2f ms, indexed %.3f ms, "
+         "index directly %.3f ms.\n", TEST_CARTRIDGES,
+         convert * 1000.0, indexed * 1000.0, direct * 1000.0);
+   printf("Cheat index matches.\n");
+   return 0;
+}
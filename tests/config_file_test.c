@@ -0,0 +1,179 @@
+/*  RetroArch - A frontend for libretro.
+ *  Copyright (C) 2010-2014 - Hans-Kristian Arntzen
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Reads and writes a config file the size of a full retroarch.cfg,
+ * with includes, duplicate keys and appended files, and checks that
+ * keyed lookups find the same entry a scan of the file would. Times
+ * a pass over every key, like loading or saving all settings. */
+
+#include "../conf/config_file.h"
+#include "../general.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define TEST_CONF "config_file_test.cfg"
+#define TEST_INCLUDE "config_file_test_include.cfg"
+#define TEST_APPEND "config_file_test_append.cfg"
+#define NUM_KEYS 2000
+
+struct settings g_settings;
+struct global g_extern;
+
+static void fail(const char *msg)
+{
+   fprintf(stderr, "FAIL: %s.\n", msg);
+   exit(1);
+}
+
+static double get_time(void)
+{
+   struct timespec tv;
+   clock_gettime(CLOCK_MONOTONIC, &tv);
+   return tv.tv_sec + tv.tv_nsec / 1000000000.0;
+}
+
+static void write_text(const char *path, const char *text)
+{
+   FILE *file = fopen(path, "w");
+   if (!file)
+      fail("couldn't write a config file");
+   fputs(text, file);
+   fclose(file);
+}
+
+static void check_string(config_file_t *conf, const char *key,
+      const char *expected, const char *msg)
+{
+   char buf[64];
+   if (!config_get_array(conf, key, buf, sizeof(buf)))
+   {
+      if (expected)
+         fail(msg);
+      return;
+   }
+   if (!expected || strcmp(buf, expected))
+      fail(msg);
+}
+
+static void check_int(config_file_t *conf, unsigned i, int expected)
+{
+   char key[32];
+   int val = -1;
+
+   snprintf(key, sizeof(key), "key_%u", i);
+   if (!config_get_int(conf, key, &val) || val != expected)
+      fail("wrong value for a key");
+}
+
+int main(void)
+{
+   unsigned i;
+   double start, get, set;
+   char key[32];
+   config_file_t *conf;
+   FILE *file;
+
+   write_text(TEST_INCLUDE,
+         "included = \"yes\"\n"
+         "shared = \"from include\"\n");
+
+   if (!(file = fopen(TEST_CONF, "w")))
+      fail("couldn't write the config");
+   fprintf(file, "#include \"%s\"\n", TEST_INCLUDE);
+   fprintf(file, "shared = \"from config\"\n");
+   for (i = 0; i < NUM_KEYS; i++)
+      fprintf(file, "key_%u = \"%u\"\n", i, i);
+   /* The first of two entries wins. */
+   fprintf(file, "key_7 = \"-7\"\n");
+   fclose(file);
+
+   if (!(conf = config_file_new(TEST_CONF)))
+      fail("couldn't load the config");
+
+   check_string(conf, "included", "yes", "included key not found");
+   check_string(conf, "shared", "from include",
+         "included entry didn't come first");
+   check_string(conf, "missing", NULL, "found a missing key");
+   if (config_entry_exists(conf, "missing") ||
+         !config_entry_exists(conf, "key_0"))
+      fail("wrong answer for a key's existence");
+
+   start = get_time();
+   for (i = 0; i < NUM_KEYS; i++)
+      check_int(conf, i, i);
+   get = get_time() - start;
+
+   /* Included entries are read-only, so the config's own
+    * entry is changed instead. */
+   config_set_string(conf, "shared", "changed");
+   check_string(conf, "shared", "from include",
+         "included entry was overwritten");
+
+   /* Changes values and adds keys, which grows the index. */
+   start = get_time();
+   for (i = 0; i < NUM_KEYS * 2; i++)
+   {
+      snprintf(key, sizeof(key), "key_%u", i);
+      config_set_int(conf, key, -(int)i);
+   }
+   set = get_time() - start;
+
+   for (i = 0; i < NUM_KEYS * 2; i++)
+      check_int(conf, i, -(int)i);
+
+   config_set_string(conf, "last", "tail");
+   check_string(conf, "last", "tail", "added key not found");
+
+   /* Appended files come before everything else. */
+   write_text(TEST_APPEND,
+         "key_3 = \"33\"\n"
+         "appended = \"yes\"\n");
+   if (!config_append_file(conf, TEST_APPEND))
+      fail("couldn't append a config");
+   check_int(conf, 3, 33);
+   check_int(conf, 4, -4);
+   check_string(conf, "appended", "yes", "appended key not found");
+
+   if (!config_file_write(conf, TEST_CONF))
+      fail("couldn't write the config");
+   config_file_free(conf);
+
+   if (!(conf = config_file_new(TEST_CONF)))
+      fail("couldn't load the written config");
+   check_string(conf, "shared", "from include",
+         "included entry didn't come first after writing");
+   check_string(conf, "last", "tail", "added key wasn't written");
+   check_int(conf, 3, 33);
+   check_int(conf, NUM_KEYS * 2 - 1, -(NUM_KEYS * 2 - 1));
+   config_file_free(conf);
+
+   /* Lookups also work without a file. */
+   if (!(conf = config_file_new_from_string("a = \"1\"\nb = \"2\"\na = \"3\"")))
+      fail("couldn't parse a config string");
+   check_string(conf, "a", "1", "wrong value in a config string");
+   check_string(conf, "b", "2", "wrong value in a config string");
+   config_file_free(conf);
+
+   remove(TEST_CONF);
+   remove(TEST_INCLUDE);
+   remove(TEST_APPEND);
+
+   printf("%u keys: reading all %.3f ms, writing twice as many %.3f ms.\n",
+         NUM_KEYS, get * 1000.0, set * 1000.0);
+   printf("Config file lookups match.\n");
+   return 0;
+}
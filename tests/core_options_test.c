@@ -0,0 +1,154 @@
+/*  RetroArch - A frontend for libretro.
+ *  Copyright (C) 2010-2014 - Hans-Kristian Arntzen
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Looks up core options by key, with values from a config file,
+ * duplicate and unknown keys, and checks which lookups report a
+ * changed value. Times lookups against a scan over all keys, which
+ * is what every GET_VARIABLE used to cost. */
+
+#include "../core_options.h"
+#include "../general.h"
+#include "../conf/config_file.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define TEST_CONF "core_options_test.cfg"
+#define NUM_OPTIONS 200
+#define NUM_LOOKUPS 1000000
+
+struct settings g_settings;
+struct global g_extern;
+
+static void fail(const char *msg)
+{
+   fprintf(stderr, "FAIL: %s.\n", msg);
+   exit(1);
+}
+
+static double get_time(void)
+{
+   struct timespec tv;
+   clock_gettime(CLOCK_MONOTONIC, &tv);
+   return tv.tv_sec + tv.tv_nsec / 1000000000.0;
+}
+
+static char keys[NUM_OPTIONS + 1][32];
+static char values[NUM_OPTIONS + 1][64];
+static struct retro_variable vars[NUM_OPTIONS + 2];
+
+static const char *get(core_option_manager_t *opt, const char *key,
+      bool *changed)
+{
+   struct retro_variable var = { key, NULL };
+   bool ret = core_option_get(opt, &var);
+   if (changed)
+      *changed = ret;
+   return var.value;
+}
+
+int main(void)
+{
+   unsigned i;
+   bool changed;
+   unsigned generation;
+   double start, hashed, linear;
+   volatile size_t found = 0;
+   core_option_manager_t *opt;
+   FILE *file;
+
+   /* Named like real cores do, sharing a long prefix. */
+   for (i = 0; i < NUM_OPTIONS; i++)
+   {
+      snprintf(keys[i], sizeof(keys[i]), "mycore_option_%u", i);
+      snprintf(values[i], sizeof(values[i]), "Option %u; a|b|c", i);
+      vars[i].key   = keys[i];
+      vars[i].value = values[i];
+   }
+   /* Repeated key, the first one wins. */
+   vars[NUM_OPTIONS].key   = keys[5];
+   vars[NUM_OPTIONS].value = "Again; x|y";
+
+   file = fopen(TEST_CONF, "w");
+   fprintf(file, "mycore_option_7 = \"c\"\nmycore_option_8 = \"bogus\"\n");
+   fclose(file);
+
+   opt = core_option_new(TEST_CONF, vars);
+   if (!opt || core_option_size(opt) != NUM_OPTIONS + 1)
+      fail("core_option_new");
+
+   if (strcmp(get(opt, "mycore_option_0", &changed), "a") || !changed)
+      fail("first lookup");
+   if (strcmp(get(opt, "mycore_option_0", &changed), "a") || changed)
+      fail("repeated lookup reported as changed");
+   if (strcmp(get(opt, "mycore_option_7", NULL), "c"))
+      fail("value from config");
+   if (strcmp(get(opt, "mycore_option_8", NULL), "a"))
+      fail("unknown value in config");
+   if (strcmp(get(opt, "mycore_option_5", NULL), "a"))
+      fail("duplicate key");
+   if (get(opt, "mycore_option_200", &changed) || changed)
+      fail("unknown key");
+   if (get(opt, "", NULL))
+      fail("empty key");
+
+   for (i = 0; i < NUM_OPTIONS; i++)
+      if (!get(opt, keys[i], NULL))
+         fail("lookup");
+
+   generation = core_option_generation(opt);
+   core_option_next(opt, 0);
+   if (!core_option_updated(opt))
+      fail("not updated");
+   /* A lookup for someone other than the core leaves it updated. */
+   if (strcmp(core_option_lookup(opt, "mycore_option_0"), "b") ||
+         !core_option_updated(opt))
+      fail("lookup reset the updated flag");
+   if (strcmp(get(opt, "mycore_option_0", &changed), "b") || !changed)
+      fail("changed value");
+   if (core_option_updated(opt))
+      fail("still updated");
+   if (core_option_generation(opt) == generation)
+      fail("generation not bumped");
+   if (core_option_lookup(opt, "mycore_option_200"))
+      fail("lookup of an unknown key");
+
+   /* The last key is the worst case for a scan. */
+   start = get_time();
+   for (i = 0; i < NUM_LOOKUPS; i++)
+      found += get(opt, keys[NUM_OPTIONS - 1 - (i & 7)], NULL) != NULL;
+   hashed = get_time() - start;
+
+   start = get_time();
+   for (i = 0; i < NUM_LOOKUPS; i++)
+   {
+      unsigned j;
+      const char *key = keys[NUM_OPTIONS - 1 - (i & 7)];
+      for (j = 0; j < NUM_OPTIONS; j++)
+         if (!strcmp(vars[j].key, key))
+            break;
+      found += j;
+   }
+   linear = get_time() - start;
+
+   printf("Lookup among %u options: %.1f ns, %.1f ns scanning.\n",
+         NUM_OPTIONS, hashed * 1e9 / NUM_LOOKUPS, linear * 1e9 / NUM_LOOKUPS);
+
+   core_option_free(opt);
+   remove(TEST_CONF);
+   printf("Core options match.\n");
+   return 0;
+}
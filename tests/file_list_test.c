@@ -0,0 +1,481 @@
+/*  RetroArch - A frontend for libretro.
+ *  Copyright (C) 2010-2014 - Hans-Kristian Arntzen
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Checks the arena backed string_list and file_list against a
+ * strdup-per-string reference, then benchmarks navigating into a
+ * large directory with both. string_list.c and file_list.c are
+ * built with their allocator calls redirected here. */
+
+#include "../string_list.h"
+#include "../file_list.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <time.h>
+
+static unsigned allocations;
+
+void *test_malloc(size_t size)
+{
+   allocations++;
+   return malloc(size);
+}
+
+void *test_calloc(size_t num, size_t size)
+{
+   allocations++;
+   return calloc(num, size);
+}
+
+void *test_realloc(void *ptr, size_t size)
+{
+   allocations++;
+   return realloc(ptr, size);
+}
+
+char *test_strdup(const char *str)
+{
+   allocations++;
+   return strdup(str);
+}
+
+static void fail(const char *msg, unsigned line)
+{
+   fprintf(stderr, "Line %u: %s.\n", line, msg);
+   exit(1);
+}
+
+#define CHECK(cond) do { if (!(cond)) fail(#cond, __LINE__); } while (0)
+
+static bool str_equal(const char *a, const char *b)
+{
+   return (!a || !b) ? a == b : !strcmp(a, b);
+}
+
+/* The lists as they were: every string on its own. */
+struct ref_item
+{
+   char *path;
+   char *label;
+   char *alt;
+   unsigned type;
+};
+
+struct ref_list
+{
+   struct ref_item *list;
+   size_t size;
+   size_t capacity;
+};
+
+static char *ref_strdup(const char *str)
+{
+   return str ? test_strdup(str) : NULL;
+}
+
+static void ref_push(struct ref_list *list, const char *path,
+      const char *label, unsigned type)
+{
+   if (list->size >= list->capacity)
+   {
+      list->capacity = (list->capacity + 1) * 2;
+      list->list = (struct ref_item*)test_realloc(list->list,
+            list->capacity * sizeof(*list->list));
+   }
+
+   list->list[list->size].path  = ref_strdup(path);
+   list->list[list->size].label = ref_strdup(label);
+   list->list[list->size].alt   = NULL;
+   list->list[list->size].type  = type;
+   list->size++;
+}
+
+static void ref_free_item(struct ref_item *item)
+{
+   free(item->path);
+   free(item->label);
+   free(item->alt);
+}
+
+static void ref_clear(struct ref_list *list)
+{
+   size_t i;
+   for (i = 0; i < list->size; i++)
+      ref_free_item(&list->list[i]);
+   list->size = 0;
+}
+
+static void ref_set_alt(struct ref_list *list, size_t index, const char *alt)
+{
+   free(list->list[index].alt);
+   list->list[index].alt = ref_strdup(alt);
+}
+
+static int ref_alt_cmp(const void *a_, const void *b_)
+{
+   const struct ref_item *a = (const struct ref_item*)a_;
+   const struct ref_item *b = (const struct ref_item*)b_;
+   return strcasecmp(a->alt ? a->alt : a->path, b->alt ? b->alt : b->path);
+}
+
+static struct string_list *ref_split(const char *str, const char *delim)
+{
+   char *save = NULL;
+   char *copy = test_strdup(str);
+   struct string_list *list = string_list_new();
+   const char *tmp = strtok_r(copy, delim, &save);
+
+   while (tmp)
+   {
+      union string_list_elem_attr attr;
+      attr.i = 0;
+      string_list_append(list, tmp, attr);
+      tmp = strtok_r(NULL, delim, &save);
+   }
+
+   free(copy);
+   return list;
+}
+
+static void check_list(const file_list_t *list, const struct ref_list *ref)
+{
+   size_t i;
+
+   CHECK(file_list_get_size(list) == ref->size);
+   for (i = 0; i < ref->size; i++)
+   {
+      const char *path, *label, *alt;
+      unsigned type;
+
+      file_list_get_at_offset(list, i, &path, &label, &type);
+      file_list_get_alt_at_offset(list, i, &alt);
+      CHECK(str_equal(path, ref->list[i].path));
+      CHECK(str_equal(label, ref->list[i].label));
+      CHECK(str_equal(alt, ref->list[i].alt ?
+               ref->list[i].alt : ref->list[i].path));
+      CHECK(type == ref->list[i].type);
+   }
+}
+
+static void random_string(char *buf, size_t size, unsigned serial)
+{
+   static const char chars[] = "abcXYZ019 ._-";
+   size_t i, len = rand() % (rand() % 8 ? 24 : size - 16);
+
+   for (i = 0; i < len; i++)
+      buf[i] = chars[rand() % (sizeof(chars) - 1)];
+   /* Unique, so sorting has one right answer. */
+   snprintf(buf + len, size - len, "#%u", serial);
+}
+
+static void test_split(void)
+{
+   unsigned i;
+   static const char *cases[] = {
+      "", "|", "||", "a", "a|b", "|a||b|", "cg|glsl",
+      "zip|ZIP|7z", "one two\tthree", " lead", "trail ",
+   };
+
+   for (i = 0; i < 2000; i++)
+   {
+      size_t j;
+      char str[512];
+      const char *in = str;
+      struct string_list *list, *ref;
+
+      if (i < sizeof(cases) / sizeof(cases[0]))
+         in = cases[i];
+      else
+      {
+         size_t len = rand() % sizeof(str);
+         for (j = 0; j < len; j++)
+            str[j] = "ab| \t"[rand() % 5];
+         str[len] = '\0';
+      }
+
+      list = string_split(in, "| \t");
+      ref  = ref_split(in, "| \t");
+      CHECK(list->size == ref->size);
+      for (j = 0; j < ref->size; j++)
+         CHECK(!strcmp(list->elems[j].data, ref->elems[j].data));
+      string_list_free(list);
+      string_list_free(ref);
+   }
+}
+
+static void test_string_list_set(void)
+{
+   unsigned i;
+   char buf[600];
+   char *ref[64] = {NULL};
+   struct string_list *list = string_list_new();
+   union string_list_elem_attr attr;
+
+   attr.i = 0;
+   for (i = 0; i < 64; i++)
+   {
+      random_string(buf, sizeof(buf), i);
+      string_list_append(list, buf, attr);
+      ref[i] = strdup(buf);
+   }
+
+   for (i = 0; i < 20000; i++)
+   {
+      unsigned index = rand() % 64;
+      random_string(buf, sizeof(buf), i);
+      string_list_set(list, index, buf);
+      free(ref[index]);
+      ref[index] = strdup(buf);
+      CHECK(!strcmp(list->elems[index].data, buf));
+   }
+
+   for (i = 0; i < 64; i++)
+   {
+      CHECK(!strcmp(list->elems[i].data, ref[i]));
+      free(ref[i]);
+   }
+
+   /* Released strings must not pile up. */
+   CHECK(list->arena.used < 2 * 64 * sizeof(buf));
+   string_list_free(list);
+}
+
+static void test_file_list(void)
+{
+   unsigned round, serial = 0;
+   struct ref_list ref = {0};
+   file_list_t *list = (file_list_t*)calloc(1, sizeof(*list));
+
+   for (round = 0; round < 3000; round++)
+   {
+      char path[600], label[600];
+      unsigned op = rand() % 100;
+      size_t ptr;
+
+      if (op < 50)
+      {
+         random_string(path, sizeof(path), serial++);
+         random_string(label, sizeof(label), serial++);
+         if (!(rand() % 4))
+            *label = '\0';
+         file_list_push(list, path, label, op, 0);
+         ref_push(&ref, path, label, op);
+      }
+      else if (op < 75 && ref.size)
+      {
+         file_list_pop(list, &ptr);
+         ref_free_item(&ref.list[--ref.size]);
+      }
+      else if (op < 85 && ref.size)
+      {
+         size_t index = rand() % ref.size;
+         random_string(label, sizeof(label), serial++);
+         file_list_set_label_at_offset(list, index, label);
+         free(ref.list[index].label);
+         ref.list[index].label = strdup(label);
+      }
+      else if (op < 95 && ref.size)
+      {
+         size_t index = rand() % ref.size;
+         random_string(label, sizeof(label), serial++);
+         file_list_set_alt_at_offset(list, index, label);
+         ref_set_alt(&ref, index, label);
+      }
+      else if (op < 98)
+      {
+         file_list_sort_on_alt(list);
+         qsort(ref.list, ref.size, sizeof(*ref.list), ref_alt_cmp);
+      }
+      else
+      {
+         file_list_clear(list);
+         ref_clear(&ref);
+      }
+
+      check_list(list, &ref);
+   }
+
+   /* Heavy push and pop on a stack doesn't grow without bound. */
+   for (round = 0; round < 100000; round++)
+   {
+      char path[64];
+      size_t ptr;
+      snprintf(path, sizeof(path), "/some/menu/level/%u", round);
+      file_list_push(list, path, "label", 0, 0);
+      file_list_pop(list, &ptr);
+   }
+   check_list(list, &ref);
+   CHECK(list->arena.used < 1024 * 1024);
+
+   ref_clear(&ref);
+   free(ref.list);
+   file_list_free(list);
+}
+
+static double get_time(void)
+{
+   struct timespec tv;
+   clock_gettime(CLOCK_MONOTONIC, &tv);
+   return tv.tv_sec + tv.tv_nsec / 1000000000.0;
+}
+
+static int dir_cmp(const void *a_, const void *b_)
+{
+   const struct string_list_elem *a = (const struct string_list_elem*)a_;
+   const struct string_list_elem *b = (const struct string_list_elem*)b_;
+   if (a->attr.i != b->attr.i)
+      return b->attr.i - a->attr.i;
+   return strcasecmp(a->data, b->data);
+}
+
+static const char *basename_of(const char *path)
+{
+   const char *slash = strrchr(path, '/');
+   return slash ? slash + 1 : path;
+}
+
+/* What the menu does on entering a directory: list it, sort it,
+ * rebuild the selection buffer, then tag and sort on display names. */
+static void navigate(file_list_t *list, const char **names, unsigned count)
+{
+   unsigned i;
+   char display[64];
+   struct string_list *dir = string_list_new();
+
+   for (i = 0; i < count; i++)
+   {
+      union string_list_elem_attr attr;
+      attr.i = (i % 50) == 0;
+      string_list_append(dir, names[i], attr);
+   }
+   qsort(dir->elems, dir->size, sizeof(*dir->elems), dir_cmp);
+
+   file_list_clear(list);
+   for (i = 0; i < dir->size; i++)
+      file_list_push(list, basename_of(dir->elems[i].data), "", 0, 0);
+   for (i = 0; i < dir->size; i++)
+   {
+      snprintf(display, sizeof(display), "Title %u", (i * 7919) % count);
+      file_list_set_alt_at_offset(list, i, display);
+   }
+   file_list_sort_on_alt(list);
+
+   string_list_free(dir);
+}
+
+static int ref_dir_cmp(const void *a_, const void *b_)
+{
+   const struct ref_item *a = (const struct ref_item*)a_;
+   const struct ref_item *b = (const struct ref_item*)b_;
+   if (a->type != b->type)
+      return (int)b->type - (int)a->type;
+   return strcasecmp(a->path, b->path);
+}
+
+static void ref_navigate(struct ref_list *list, const char **names,
+      unsigned count)
+{
+   unsigned i;
+   char display[64];
+   struct ref_list dir = {0};
+
+   for (i = 0; i < count; i++)
+      ref_push(&dir, names[i], NULL, (i % 50) == 0);
+   qsort(dir.list, dir.size, sizeof(*dir.list), ref_dir_cmp);
+
+   ref_clear(list);
+   for (i = 0; i < dir.size; i++)
+      ref_push(list, basename_of(dir.list[i].path), "", 0);
+   for (i = 0; i < dir.size; i++)
+   {
+      snprintf(display, sizeof(display), "Title %u", (i * 7919) % count);
+      ref_set_alt(list, i, display);
+   }
+   qsort(list->list, list->size, sizeof(*list->list), ref_alt_cmp);
+
+   ref_clear(&dir);
+   free(dir.list);
+}
+
+int main(int argc, char *argv[])
+{
+   unsigned i, round;
+   unsigned count  = argc > 1 ? strtoul(argv[1], NULL, 0) : 20000;
+   unsigned rounds = 20;
+   unsigned arena_allocs, ref_allocs;
+   double start, arena_time, ref_time;
+   const char **names = (const char**)malloc(count * sizeof(*names));
+   struct ref_list ref = {0};
+   file_list_t *list = (file_list_t*)calloc(1, sizeof(*list));
+
+   srand(0);
+   test_split();
+   test_string_list_set();
+   test_file_list();
+
+   for (i = 0; i < count; i++)
+   {
+      char name[128];
+      snprintf(name, sizeof(name),
+            "/home/user/roms/Some System/Game Title %05u (Rev %u).zip",
+            (i * 40503u) % count, i % 3);
+      names[i] = strdup(name);
+   }
+
+   /* Warm up, so both sides have grown their arrays. */
+   navigate(list, names, count);
+   ref_navigate(&ref, names, count);
+
+   allocations = 0;
+   start = get_time();
+   for (round = 0; round < rounds; round++)
+      navigate(list, names, count);
+   arena_time   = get_time() - start;
+   arena_allocs = allocations;
+
+   allocations = 0;
+   start = get_time();
+   for (round = 0; round < rounds; round++)
+      ref_navigate(&ref, names, count);
+   ref_time   = get_time() - start;
+   ref_allocs = allocations;
+
+   for (i = 0; i < count; i++)
+   {
+      const char *path, *alt;
+      file_list_get_at_offset(list, i, &path, NULL, NULL);
+      file_list_get_alt_at_offset(list, i, &alt);
+      CHECK(!strcmp(alt, ref.list[i].alt));
+      if (i)
+         CHECK(strcasecmp(ref.list[i - 1].alt, alt) <= 0);
+   }
+
+   printf("Navigating into %u entries:\n", count);
+   printf("Arena:     %8.2f ms, %8u allocations.\n",
+         1000.0 * arena_time / rounds, arena_allocs / rounds);
+   printf("Reference: %8.2f ms, %8u allocations (%.2fx).\n",
+         1000.0 * ref_time / rounds, ref_allocs / rounds,
+         ref_time / arena_time);
+   printf("Arena lists match reference.\n");
+
+   ref_clear(&ref);
+   free(ref.list);
+   file_list_free(list);
+   for (i = 0; i < count; i++)
+      free((void*)names[i]);
+   free(names);
+   return 0;
+}
@@ -0,0 +1,90 @@
+/*  RetroArch - A frontend for libretro.
+ *  Copyright (C) 2010-2014 - Hans-Kristian Arntzen
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Feeds frames with padded rows to the duplicate frame detection and
+ * checks dupes and dirty bands, including frames shown while the
+ * detection is turned off, which must not be compared against. */
+
+#include "../gfx/frame_dupe.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define WIDTH 64
+#define HEIGHT 48
+#define PITCH (WIDTH * 2 + 32)
+#define LINE_SIZE (WIDTH * 2)
+
+static uint8_t frame_a[HEIGHT * PITCH];
+static uint8_t frame_b[HEIGHT * PITCH];
+
+static void fail(const char *msg)
+{
+   fprintf(stderr, "FAIL: %s.\n", msg);
+   exit(1);
+}
+
+static void check(struct frame_dupe *dupe, bool enabled,
+      const uint8_t *frame, bool expect_dupe,
+      unsigned dirty_y, unsigned dirty_height, const char *msg)
+{
+   if (frame_dupe_update(dupe, enabled, frame, WIDTH, HEIGHT,
+            PITCH, LINE_SIZE) != expect_dupe)
+      fail(msg);
+   if (dupe->dirty_y != dirty_y || dupe->dirty_height != dirty_height)
+      fail(msg);
+}
+
+int main(void)
+{
+   unsigned i;
+   struct frame_dupe dupe;
+
+   memset(&dupe, 0, sizeof(dupe));
+
+   for (i = 0; i < sizeof(frame_a); i++)
+      frame_a[i] = i * 7;
+   memcpy(frame_b, frame_a, sizeof(frame_b));
+   /* Padding isn't compared. */
+   frame_b[PITCH - 1] ^= 0xff;
+   /* Rows 10 to 19 differ. */
+   for (i = 10; i < 20; i++)
+      frame_b[i * PITCH + 3] ^= 0xff;
+
+   check(&dupe, true, frame_a, false, 0, HEIGHT, "first frame");
+   check(&dupe, true, frame_a, true, 0, 0, "unchanged frame");
+   check(&dupe, true, frame_b, false, 10, 10, "wrong dirty band");
+   check(&dupe, true, frame_b, true, 0, 0, "unchanged frame");
+
+   /* With detection off, frame A is shown again. Turned back on,
+    * frame B must not count as a dupe of the stale copy. */
+   check(&dupe, false, frame_a, false, 0, HEIGHT, "unchecked frame");
+   check(&dupe, true, frame_b, false, 0, HEIGHT,
+         "frame after toggling compared against a stale frame");
+   check(&dupe, true, frame_a, false, 10, 10, "wrong dirty band");
+
+   /* Same for NULL and hardware frames, which aren't checked. */
+   check(&dupe, false, NULL, false, 0, HEIGHT, "unchecked frame");
+   check(&dupe, true, frame_a, false, 0, HEIGHT,
+         "frame after a NULL frame compared against a stale frame");
+
+   if (dupe.dupes != 2)
+      fail("wrong number of dupes");
+
+   frame_dupe_free(&dupe);
+
+   printf("Frame dupes match.\n");
+   return 0;
+}
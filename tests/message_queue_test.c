@@ -0,0 +1,158 @@
+/*  RetroArch - A frontend for libretro.
+ *  Copyright (C) 2010-2014 - Hans-Kristian Arntzen
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Checks message queue ordering and deduplication, and that the
+ * per-frame push/pull pattern of rewind and friends doesn't allocate.
+ * message_queue.c is built with its allocator calls redirected here. */
+
+#include "../message_queue.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+static unsigned allocations;
+
+void *test_malloc(size_t size)
+{
+   allocations++;
+   return malloc(size);
+}
+
+void *test_calloc(size_t num, size_t size)
+{
+   allocations++;
+   return calloc(num, size);
+}
+
+void *test_realloc(void *ptr, size_t size)
+{
+   allocations++;
+   return realloc(ptr, size);
+}
+
+char *test_strdup(const char *str)
+{
+   allocations++;
+   return strdup(str);
+}
+
+static void expect(const char *got, const char *expected, unsigned line)
+{
+   if ((!got || !expected) ? got != expected : strcmp(got, expected))
+   {
+      fprintf(stderr, "Line %u: got \"%s\", expected \"%s\".\n",
+            line, got ? got : "(null)", expected ? expected : "(null)");
+      exit(1);
+   }
+}
+
+#define EXPECT(got, expected) expect(got, expected, __LINE__)
+
+static double get_time(void)
+{
+   struct timespec tv;
+   clock_gettime(CLOCK_MONOTONIC, &tv);
+   return tv.tv_sec + tv.tv_nsec / 1000000000.0;
+}
+
+int main(void)
+{
+   unsigned i;
+   unsigned frames = 1000000;
+   char long_msg[2048];
+   double start;
+   msg_queue_t *queue = msg_queue_new(8);
+
+   /* Priority first, then push order. */
+   msg_queue_push(queue, "low", 0, 1);
+   msg_queue_push(queue, "high", 2, 2);
+   msg_queue_push(queue, "mid a", 1, 1);
+   msg_queue_push(queue, "mid b", 1, 1);
+   EXPECT(msg_queue_pull(queue), "high");
+   EXPECT(msg_queue_pull(queue), "high");
+   EXPECT(msg_queue_pull(queue), "mid a");
+   EXPECT(msg_queue_pull(queue), "mid b");
+   EXPECT(msg_queue_pull(queue), "low");
+   EXPECT(msg_queue_pull(queue), NULL);
+
+   /* Pending duplicates are refreshed, not queued again. */
+   msg_queue_push(queue, "dupe", 0, 2);
+   msg_queue_push(queue, "other", 1, 1);
+   msg_queue_push(queue, "dupe", 3, 3);
+   msg_queue_push(queue, "dupe", 0, 1);
+   EXPECT(msg_queue_pull(queue), "dupe");
+   EXPECT(msg_queue_pull(queue), "dupe");
+   EXPECT(msg_queue_pull(queue), "dupe");
+   EXPECT(msg_queue_pull(queue), "other");
+   EXPECT(msg_queue_pull(queue), NULL);
+
+   /* Full queue drops new messages. */
+   for (i = 0; i < 10; i++)
+   {
+      char msg[16];
+      snprintf(msg, sizeof(msg), "msg %u", i);
+      msg_queue_push(queue, msg, 0, 1);
+   }
+   for (i = 0; i < 8; i++)
+   {
+      char msg[16];
+      snprintf(msg, sizeof(msg), "msg %u", i);
+      EXPECT(msg_queue_pull(queue), msg);
+   }
+   EXPECT(msg_queue_pull(queue), NULL);
+
+   /* Long messages are truncated, not dropped. */
+   memset(long_msg, 'x', sizeof(long_msg) - 1);
+   long_msg[sizeof(long_msg) - 1] = '\0';
+   msg_queue_push(queue, long_msg, 0, 1);
+   if (strncmp(msg_queue_pull(queue), long_msg, 256))
+   {
+      fprintf(stderr, "Long message mangled.\n");
+      return 1;
+   }
+
+   msg_queue_push(queue, "cleared", 0, 10);
+   msg_queue_clear(queue);
+   EXPECT(msg_queue_pull(queue), NULL);
+
+   /* Rewinding: clear and push every frame, plus the odd
+    * notification, pulled once per frame. */
+   allocations = 0;
+   start = get_time();
+   for (i = 0; i < frames; i++)
+   {
+      msg_queue_clear(queue);
+      msg_queue_push(queue, "Rewinding.", 0, 30);
+      if (i % 97 == 0)
+         msg_queue_push(queue, "Fast forward.", 1, 2);
+      if (i % 500 == 0)
+         msg_queue_push(queue, "Saved state to slot #0.", 2, 180);
+      if (!msg_queue_pull(queue))
+      {
+         fprintf(stderr, "Frame %u: empty queue.\n", i);
+         return 1;
+      }
+   }
+   printf("%u frames: %.1f ns/frame, %u allocations.\n", frames,
+         (get_time() - start) * 1e9 / frames, allocations);
+
+   if (allocations)
+      return 1;
+
+   msg_queue_free(queue);
+   printf("Message queue OK.\n");
+   return 0;
+}
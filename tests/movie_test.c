@@ -0,0 +1,327 @@
+/*  RetroArch - A frontend for libretro.
+ *  Copyright (C) 2010-2014 - Hans-Kristian Arntzen
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Records a movie against a small fake core, rewinding part of it
+ * back over block and keyframe boundaries, then plays it back and
+ * checks that the core ends up in the same state. Seeks around in
+ * it, plays a BSV1 movie and a BSV2 movie which was cut off before
+ * its index was written. */
+
+#include "../movie.h"
+#include "../general.h"
+#include "../dynamic.h"
+#include "../retro.h"
+#include "../endianness.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define TEST_PATH "movie_test.bsv"
+#define TEST_FRAMES 2000
+#define TEST_INPUTS 3
+#define TEST_INTERVAL 100
+
+struct settings g_settings;
+struct global g_extern;
+driver_t driver;
+
+struct core_state
+{
+   uint32_t frame;
+   uint32_t sum;
+};
+
+static struct core_state core;
+static bsv_movie_t *movie;
+static bool playback;
+static unsigned variant;
+static unsigned runs;
+
+static void fail(const char *msg)
+{
+   fprintf(stderr, "FAIL: %s.\n", msg);
+   exit(1);
+}
+
+static int16_t gen_input(unsigned frame, unsigned index)
+{
+   /* Mostly idle, like a real player. */
+   if ((frame / 30) % 3)
+      return 0;
+   return (int16_t)((frame * 7 + index * 13 + variant * 101) & 0xfff);
+}
+
+static int16_t input_state(unsigned index)
+{
+   int16_t val = 0;
+
+   if (playback)
+   {
+      if (!bsv_movie_get_input(movie, &val))
+         fail("movie ended early");
+      return val;
+   }
+
+   val = gen_input(core.frame, index);
+   bsv_movie_set_input(movie, val);
+   return val;
+}
+
+static void core_run(void)
+{
+   unsigned i;
+
+   runs++;
+   for (i = 0; i < TEST_INPUTS; i++)
+      core.sum = core.sum * 31 + (uint16_t)input_state(i);
+   core.frame++;
+}
+
+static size_t core_serialize_size(void)
+{
+   return sizeof(core);
+}
+
+static bool core_serialize(void *data, size_t size)
+{
+   if (size < sizeof(core))
+      return false;
+   memcpy(data, &core, sizeof(core));
+   return true;
+}
+
+static bool core_unserialize(const void *data, size_t size)
+{
+   if (size < sizeof(core))
+      return false;
+   memcpy(&core, data, sizeof(core));
+   return true;
+}
+
+static void set_video_refresh(retro_video_refresh_t cb) { (void)cb; }
+static void set_audio_sample(retro_audio_sample_t cb) { (void)cb; }
+static void set_audio_sample_batch(retro_audio_sample_batch_t cb) { (void)cb; }
+
+void (*pretro_run)(void) = core_run;
+size_t (*pretro_serialize_size)(void) = core_serialize_size;
+bool (*pretro_serialize)(void*, size_t) = core_serialize;
+bool (*pretro_unserialize)(const void*, size_t) = core_unserialize;
+void (*pretro_set_video_refresh)(retro_video_refresh_t) = set_video_refresh;
+void (*pretro_set_audio_sample)(retro_audio_sample_t) = set_audio_sample;
+void (*pretro_set_audio_sample_batch)(retro_audio_sample_batch_t) =
+   set_audio_sample_batch;
+
+void retro_set_rewind_callbacks(void)
+{
+}
+
+static void run_frame(void)
+{
+   bsv_movie_set_frame_start(movie);
+   core_run();
+   bsv_movie_set_frame_end(movie);
+}
+
+static struct core_state states[TEST_FRAMES + 1];
+
+static struct core_state record(void)
+{
+   unsigned i;
+
+   memset(&core, 0, sizeof(core));
+   playback = false;
+   variant  = 0;
+
+   if (!(movie = bsv_movie_init(TEST_PATH, RARCH_MOVIE_RECORD)))
+      fail("record");
+
+   for (i = 0; i < 1000; i++)
+   {
+      states[core.frame] = core;
+      run_frame();
+   }
+
+   /* Rewind one frame at a time, like the rewind hotkey does,
+    * back past a keyframe and into blocks already written. */
+   for (i = 0; i < 300; i++)
+   {
+      bsv_movie_frame_rewind(movie);
+      core = states[bsv_movie_get_frame(movie)];
+      run_frame();
+   }
+   if (core.frame != bsv_movie_get_frame(movie) || core.frame > 720)
+      fail("rewind while recording");
+
+   variant = 1;
+   while (core.frame < TEST_FRAMES)
+   {
+      states[core.frame] = core;
+      run_frame();
+   }
+
+   bsv_movie_free(movie);
+   return core;
+}
+
+static void play(const struct core_state *expected, unsigned frames)
+{
+   unsigned i;
+
+   memset(&core, 0xff, sizeof(core));
+   playback = true;
+
+   if (!(movie = bsv_movie_init(TEST_PATH, RARCH_MOVIE_PLAYBACK)))
+      fail("playback");
+   if (core.frame != 0 || core.sum != 0)
+      fail("start state");
+   if (bsv_movie_get_num_frames(movie) != frames)
+      fail("frame count");
+
+   for (i = 0; i < frames; i++)
+      run_frame();
+
+   if (core.frame != expected->frame || core.sum != expected->sum)
+      fail("desync on playback");
+
+   {
+      int16_t val;
+      bsv_movie_set_frame_start(movie);
+      if (bsv_movie_get_input(movie, &val))
+         fail("movie did not end");
+   }
+}
+
+static void seek(unsigned frame)
+{
+   runs = 0;
+   if (!bsv_movie_seek(movie, frame))
+      fail("seek");
+   if (core.frame != frame || core.sum != states[frame].sum
+         || bsv_movie_get_frame(movie) != frame)
+      fail("wrong state after seek");
+   if (runs > TEST_INTERVAL)
+      fail("seek ran from too far back");
+}
+
+static void write_legacy(void)
+{
+   unsigned i;
+   uint32_t header[4];
+   FILE *file = fopen(TEST_PATH, "wb");
+   struct core_state start = {0};
+
+   header[MAGIC_INDEX]      = swap_if_little32(BSV_MAGIC);
+   header[SERIALIZER_INDEX] = 0;
+   header[CRC_INDEX]        = 0;
+   header[STATE_SIZE_INDEX] = swap_if_big32(sizeof(start));
+   fwrite(header, sizeof(header), 1, file);
+   fwrite(&start, sizeof(start), 1, file);
+
+   for (i = 0; i < 10 * TEST_INPUTS; i++)
+   {
+      uint16_t val = swap_if_big16(i + 1);
+      fwrite(&val, sizeof(val), 1, file);
+   }
+   fclose(file);
+}
+
+int main(void)
+{
+   unsigned i;
+   long size;
+   FILE *file;
+   uint8_t *data;
+   struct core_state final;
+
+   g_settings.movie_keyframe_interval = TEST_INTERVAL;
+   remove(TEST_PATH);
+
+   final = record();
+   states[TEST_FRAMES] = final;
+   play(&final, TEST_FRAMES);
+
+   file = fopen(TEST_PATH, "rb");
+   fseek(file, 0, SEEK_END);
+   size = ftell(file);
+   printf("%u frames with %u inputs each: %ld bytes, %u bytes as BSV1.\n",
+         TEST_FRAMES, TEST_INPUTS, size,
+         (unsigned)(16 + sizeof(core) + TEST_FRAMES * TEST_INPUTS * 2));
+
+   /* Forwards, backwards, and to either end. */
+   seek(1234);
+   seek(1250);
+   seek(350);
+   seek(0);
+   seek(TEST_FRAMES);
+   if (bsv_movie_seek(movie, TEST_FRAMES + 1))
+      fail("seek past the end");
+
+   /* Rewinding during playback. */
+   seek(500);
+   run_frame();
+   bsv_movie_frame_rewind(movie);
+   core = states[bsv_movie_get_frame(movie)];
+   for (i = bsv_movie_get_frame(movie); i < TEST_FRAMES; i++)
+      run_frame();
+   if (core.sum != final.sum)
+      fail("desync after rewind");
+   bsv_movie_free(movie);
+
+   /* Cut off in the middle, as if RetroArch crashed while recording. */
+   data = (uint8_t*)malloc(size);
+   rewind(file);
+   if (fread(data, 1, size, file) != (size_t)size)
+      fail("read");
+   fclose(file);
+   memset(data + 6 * sizeof(uint32_t), 0, 2 * sizeof(uint32_t));
+   file = fopen(TEST_PATH, "wb");
+   fwrite(data, 1, size / 2, file);
+   fclose(file);
+   free(data);
+
+   if (!(movie = bsv_movie_init(TEST_PATH, RARCH_MOVIE_PLAYBACK)))
+      fail("playback of cut off movie");
+   i = bsv_movie_get_num_frames(movie);
+   if (i == 0 || i >= TEST_FRAMES)
+      fail("cut off movie length");
+   bsv_movie_free(movie);
+   play(&states[i], i);
+   bsv_movie_free(movie);
+   printf("Cut off movie plays %u frames.\n", i);
+
+   /* BSV1 is read as one stream of inputs. */
+   write_legacy();
+   playback = true;
+   if (!(movie = bsv_movie_init(TEST_PATH, RARCH_MOVIE_PLAYBACK)))
+      fail("legacy playback");
+   for (i = 0; i < 10 * TEST_INPUTS; i++)
+   {
+      int16_t val;
+      if (!bsv_movie_get_input(movie, &val) || val != (int16_t)(i + 1))
+         fail("legacy inputs");
+      if (i % TEST_INPUTS == TEST_INPUTS - 1)
+         bsv_movie_set_frame_end(movie);
+   }
+   {
+      int16_t val;
+      if (bsv_movie_get_input(movie, &val))
+         fail("legacy movie did not end");
+   }
+   bsv_movie_free(movie);
+
+   remove(TEST_PATH);
+   printf("Movies match.\n");
+   return 0;
+}
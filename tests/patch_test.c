@@ -0,0 +1,483 @@
+/*  RetroArch - A frontend for libretro.
+ *  Copyright (C) 2010-2014 - Hans-Kristian Arntzen
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Builds BPS, UPS and IPS patches for a large source, with every kind
+ * of BPS action including overlapping TargetCopy runs, and checks the
+ * patched result and the target sizes. Damaged and cut off patches
+ * must fail cleanly, without reading past the patch. Also checks the
+ * CRC32 against zlib's. */
+
+#include "../patch.h"
+#include "../hash.h"
+#include "../boolean.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <zlib.h>
+
+#define TEST_SIZE (32 * 1024 * 1024)
+
+struct buffer
+{
+   uint8_t *data;
+   size_t size;
+   size_t cap;
+};
+
+static uint32_t seed = 1;
+
+static void fail(const char *msg)
+{
+   fprintf(stderr, "FAIL: %s.\n", msg);
+   exit(1);
+}
+
+static uint32_t rnd(void)
+{
+   seed = seed * 1103515245 + 12345;
+   return seed >> 8;
+}
+
+static void put(struct buffer *buf, const void *data, size_t size)
+{
+   if (buf->size + size > buf->cap)
+   {
+      buf->cap = (buf->size + size) * 2;
+      buf->data = (uint8_t*)realloc(buf->data, buf->cap);
+      if (!buf->data)
+         fail("out of memory");
+   }
+   memcpy(buf->data + buf->size, data, size);
+   buf->size += size;
+}
+
+static void put8(struct buffer *buf, uint8_t val)
+{
+   put(buf, &val, 1);
+}
+
+static void put_le32(struct buffer *buf, uint32_t val)
+{
+   unsigned i;
+   for (i = 0; i < 4; i++)
+      put8(buf, val >> (i * 8));
+}
+
+static void put_number(struct buffer *buf, uint64_t val)
+{
+   for (;;)
+   {
+      uint8_t x = val & 0x7f;
+      val >>= 7;
+      if (val == 0)
+      {
+         put8(buf, 0x80 | x);
+         break;
+      }
+      put8(buf, x);
+      val--;
+   }
+}
+
+static uint32_t zlib_crc(const uint8_t *data, size_t size)
+{
+   return crc32(0, data, size);
+}
+
+static double now(void)
+{
+   struct timespec ts;
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/* Patches and compares. Returns the time it took. */
+static double check(const char *what, patch_func_t func,
+      patch_size_func_t size_func, const struct buffer *patch,
+      const uint8_t *source, size_t source_size,
+      const struct buffer *target)
+{
+   size_t size = size_func(patch->data, patch->size, source_size);
+   uint8_t *out = (uint8_t*)malloc(size ? size : 1);
+   patch_error_t err;
+   double start;
+
+   if (size != target->size)
+   {
+      fprintf(stderr, "%s: target size %u, expected %u.\n", what,
+            (unsigned)size, (unsigned)target->size);
+      fail("wrong target size");
+   }
+
+   start = now();
+   err = func(patch->data, patch->size, source, source_size, out, &size);
+   start = now() - start;
+
+   if (err != PATCH_SUCCESS)
+   {
+      fprintf(stderr, "%s: error %u.\n", what, (unsigned)err);
+      fail("patching failed");
+   }
+   if (size != target->size || memcmp(out, target->data, size))
+   {
+      fprintf(stderr, "%s\n", what);
+      fail("patched content differs");
+   }
+
+   free(out);
+   return start;
+}
+
+/* Damaged or cut off patches must fail without touching memory
+ * they shouldn't. */
+static void check_broken(const char *what, patch_func_t func,
+      const struct buffer *patch, const uint8_t *source,
+      size_t source_size, size_t target_size)
+{
+   unsigned i;
+   struct buffer copy = {0};
+   put(&copy, patch->data, patch->size);
+
+   for (i = 0; i < 16; i++)
+   {
+      size_t size = target_size;
+      size_t pos = rnd() % copy.size;
+      uint8_t *out = (uint8_t*)malloc(size);
+
+      copy.data[pos] ^= 1 + rnd() % 255;
+      if (func(copy.data, copy.size, source, source_size, out, &size)
+            == PATCH_SUCCESS)
+      {
+         fprintf(stderr, "%s\n", what);
+         fail("damaged patch applied");
+      }
+      copy.data[pos] = patch->data[pos];
+
+      size = target_size;
+      func(copy.data, rnd() % copy.size, source, source_size, out, &size);
+      free(out);
+   }
+
+   free(copy.data);
+}
+
+static void test_crc(void)
+{
+   size_t i;
+   uint8_t *data = (uint8_t*)malloc(4096);
+
+   for (i = 0; i < 4096; i++)
+      data[i] = rnd();
+
+   for (i = 0; i < 100; i++)
+   {
+      if (crc32_calculate(data + i % 7, i) != zlib_crc(data + i % 7, i))
+         fail("CRC32 differs from zlib");
+   }
+
+   if (crc32_calculate(data, 4096) != zlib_crc(data, 4096))
+      fail("CRC32 differs from zlib");
+
+   free(data);
+}
+
+/* A target made of every BPS action, and its patch. */
+static void build_bps(const uint8_t *source, size_t source_size,
+      struct buffer *target, struct buffer *patch)
+{
+   size_t source_rel = 0, target_rel = 0;
+   struct buffer actions = {0};
+
+   while (target->size < source_size - 65536)
+   {
+      unsigned mode = rnd() % 8;
+      size_t length = 1 + rnd() % 4096;
+      size_t i, from;
+      long delta;
+
+      switch (mode)
+      {
+         case 0: /* TargetRead */
+            put_number(&actions, ((length - 1) << 2) | 1);
+            for (i = 0; i < length; i++)
+            {
+               uint8_t byte = rnd();
+               put8(&actions, byte);
+               put8(target, byte);
+            }
+            break;
+
+         case 1: /* SourceCopy */
+            from = rnd() % (source_size - length);
+            delta = (long)from - (long)source_rel;
+            put_number(&actions, ((length - 1) << 2) | 2);
+            put_number(&actions, ((uint64_t)labs(delta) << 1) | (delta < 0));
+            put(target, source + from, length);
+            source_rel = from + length;
+            break;
+
+         case 2: /* TargetCopy, overlapping by 1 or 3 bytes */
+         case 3: /* TargetCopy, from anywhere before */
+            if (target->size < 16)
+               continue;
+            from = mode == 2 ? target->size - (rnd() & 1 ? 1 : 3)
+               : rnd() % (target->size - 8);
+            delta = (long)from - (long)target_rel;
+            put_number(&actions, ((length - 1) << 2) | 3);
+            put_number(&actions, ((uint64_t)labs(delta) << 1) | (delta < 0));
+            for (i = 0; i < length; i++)
+               put8(target, target->data[from + i]);
+            target_rel = from + length;
+            break;
+
+         default: /* SourceRead */
+            length *= 16;
+            put_number(&actions, (length - 1) << 2);
+            put(target, source + target->size, length);
+            break;
+      }
+   }
+
+   put(patch, "BPS1", 4);
+   put_number(patch, source_size);
+   put_number(patch, target->size);
+   put_number(patch, 5);
+   put(patch, "hello", 5);
+   put(patch, actions.data, actions.size);
+   put_le32(patch, zlib_crc(source, source_size));
+   put_le32(patch, zlib_crc(target->data, target->size));
+   put_le32(patch, zlib_crc(patch->data, patch->size));
+
+   free(actions.data);
+}
+
+/* Changes scattered bytes and runs, and grows the target. */
+static void build_ups(const uint8_t *source, size_t source_size,
+      struct buffer *target, struct buffer *patch)
+{
+   size_t i, pos, target_size = source_size + 1000;
+
+   put(target, source, source_size);
+   for (i = 0; i < 1000; i++)
+      put8(target, i % 3 ? 0 : rnd());
+   for (i = 0; i < 20000; i++)
+   {
+      size_t run = 1 + rnd() % 64;
+      pos = rnd() % (target_size - run);
+      while (run--)
+         target->data[pos++] = rnd();
+   }
+
+   put(patch, "UPS1", 4);
+   put_number(patch, source_size);
+   put_number(patch, target_size);
+
+   pos = 0;
+   while (pos < target_size)
+   {
+      size_t next = pos;
+      while (next < target_size && target->data[next]
+            == (next < source_size ? source[next] : 0))
+         next++;
+      if (next == target_size)
+         break;
+
+      put_number(patch, next - pos);
+      while (next < target_size)
+      {
+         uint8_t x = target->data[next]
+            ^ (next < source_size ? source[next] : 0);
+         if (!x)
+            break;
+         put8(patch, x);
+         next++;
+      }
+      put8(patch, 0);
+      pos = next + 1;
+   }
+
+   put_le32(patch, zlib_crc(source, source_size));
+   put_le32(patch, zlib_crc(target->data, target_size));
+   put_le32(patch, zlib_crc(patch->data, patch->size));
+}
+
+static void put_ips_record(struct buffer *patch, struct buffer *target,
+      uint32_t address, unsigned length, bool rle)
+{
+   unsigned i;
+   uint8_t byte = rnd();
+
+   if (address + length > target->size)
+   {
+      size_t old = target->size;
+      for (i = old; i < address + length; i++)
+         put8(target, 0);
+   }
+
+   put8(patch, address >> 16);
+   put8(patch, address >> 8);
+   put8(patch, address);
+
+   if (rle)
+   {
+      put8(patch, 0);
+      put8(patch, 0);
+      put8(patch, length >> 8);
+      put8(patch, length);
+      put8(patch, byte);
+      memset(target->data + address, byte, length);
+   }
+   else
+   {
+      put8(patch, length >> 8);
+      put8(patch, length);
+      for (i = 0; i < length; i++)
+      {
+         byte = rnd();
+         put8(patch, byte);
+         target->data[address + i] = byte;
+      }
+   }
+}
+
+/* IPS only addresses 16 MB, and may grow or truncate the target. */
+static void build_ips(const uint8_t *source, size_t source_size,
+      struct buffer *target, struct buffer *patch, uint32_t truncate)
+{
+   unsigned i;
+
+   put(target, source, source_size);
+   put(patch, "PATCH", 5);
+
+   for (i = 0; i < 5000; i++)
+   {
+      unsigned length = 1 + rnd() % 2000;
+      uint32_t address = rnd() % (source_size - length);
+      put_ips_record(patch, target, address, length, rnd() & 1);
+   }
+
+   /* Past the end, leaving a gap of zeroes. */
+   put_ips_record(patch, target, source_size + 100, 50, false);
+
+   put(patch, "EOF", 3);
+   if (truncate)
+   {
+      put8(patch, truncate >> 16);
+      put8(patch, truncate >> 8);
+      put8(patch, truncate);
+      target->size = truncate;
+   }
+}
+
+/* An IPS record longer than the rest of the patch. The patch ends
+ * right before an inaccessible page, so reading past it crashes. */
+static void check_ips_overrun(const uint8_t *source)
+{
+   static const uint8_t record[14] = {
+      'P', 'A', 'T', 'C', 'H',
+      0x00, 0x00, 0x10, /* address */
+      0x01, 0x00,       /* length */
+      0xaa, 'E', 'O', 'F'
+   };
+   size_t page = sysconf(_SC_PAGESIZE);
+   size_t size = 0x200;
+   uint8_t out[0x200];
+   uint8_t *pages = (uint8_t*)mmap(NULL, 2 * page,
+         PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+   uint8_t *patch = pages + page - sizeof(record);
+
+   if (pages == MAP_FAILED || mprotect(pages + page, page, PROT_NONE))
+      fail("guard page");
+
+   memcpy(patch, record, sizeof(record));
+   if (ips_apply_patch(patch, sizeof(record), source, 16, out, &size)
+         == PATCH_SUCCESS)
+      fail("IPS record past the end of the patch");
+
+   munmap(pages, 2 * page);
+}
+
+int main(void)
+{
+   size_t i;
+   double bps_time, ups_time, ips_time;
+   struct buffer bps = {0}, bps_target = {0};
+   struct buffer ups = {0}, ups_target = {0};
+   struct buffer ips = {0}, ips_target = {0};
+   struct buffer ips_cut = {0}, ips_cut_target = {0};
+   uint8_t *source = (uint8_t*)malloc(TEST_SIZE);
+   size_t ips_size = 4 * 1024 * 1024;
+
+   if (!source)
+      fail("out of memory");
+
+   test_crc();
+
+   /* Compressible-ish, like real content. */
+   for (i = 0; i < TEST_SIZE; i++)
+      source[i] = (i & 0x100) ? rnd() : (uint8_t)i;
+
+   build_bps(source, TEST_SIZE, &bps_target, &bps);
+   bps_time = check("BPS", bps_apply_patch, bps_get_target_size, &bps,
+         source, TEST_SIZE, &bps_target);
+
+   build_ups(source, TEST_SIZE, &ups_target, &ups);
+   ups_time = check("UPS", ups_apply_patch, ups_get_target_size, &ups,
+         source, TEST_SIZE, &ups_target);
+
+   build_ips(source, ips_size, &ips_target, &ips, 0);
+   ips_time = check("IPS", ips_apply_patch, ips_get_target_size, &ips,
+         source, ips_size, &ips_target);
+
+   /* Truncated target, the records still need room. */
+   build_ips(source, ips_size, &ips_cut_target, &ips_cut, ips_size / 2);
+   {
+      size_t size = ips_get_target_size(ips_cut.data, ips_cut.size, ips_size);
+      uint8_t *out = (uint8_t*)malloc(size);
+      if (size < ips_size + 150)
+         fail("IPS target size too small for its records");
+      if (ips_apply_patch(ips_cut.data, ips_cut.size, source, ips_size,
+               out, &size) != PATCH_SUCCESS || size != ips_size / 2
+            || memcmp(out, ips_cut_target.data, size))
+         fail("truncating IPS patch");
+      free(out);
+   }
+
+   check_ips_overrun(source);
+
+   check_broken("BPS", bps_apply_patch, &bps, source, TEST_SIZE,
+         bps_target.size);
+   check_broken("UPS", ups_apply_patch, &ups, source, TEST_SIZE,
+         ups_target.size);
+
+   printf("Patched %u MB: BPS %.1f ms, UPS %.1f ms, IPS (%u MB) %.1f ms.\n",
+         TEST_SIZE >> 20, bps_time * 1000.0, ups_time * 1000.0,
+         (unsigned)(ips_size >> 20), ips_time * 1000.0);
+
+   free(bps.data);
+   free(bps_target.data);
+   free(ups.data);
+   free(ups_target.data);
+   free(ips.data);
+   free(ips_target.data);
+   free(ips_cut.data);
+   free(ips_cut_target.data);
+   free(source);
+   printf("Patches match.\n");
+   return 0;
+}
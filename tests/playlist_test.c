@@ -0,0 +1,284 @@
+/*  RetroArch - A frontend for libretro.
+ *  Copyright (C) 2010-2014 - Hans-Kristian Arntzen
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Checks the indexed playlist against a plain MRU list, across
+ * reopening, journal replay, text import and a damaged journal,
+ * then times a large playlist. */
+
+#include "../playlist.h"
+#include "../general.h"
+#include "../file_path.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <time.h>
+
+#define TEST_PATH "playlist_test.lpl"
+
+struct settings g_settings;
+struct global g_extern;
+
+struct ref_entry
+{
+   char path[64];
+   char core_path[32];
+   char core_name[32];
+   uint32_t crc32;
+};
+
+static struct ref_entry *ref;
+static size_t ref_size;
+
+static void ref_push(size_t cap, const char *path, const char *core_path,
+      const char *core_name, uint32_t crc32)
+{
+   size_t i;
+   struct ref_entry tmp;
+
+   for (i = 0; i < ref_size; i++)
+   {
+      if (!strcmp(ref[i].path, path ? path : "")
+            && !strcmp(ref[i].core_path, core_path))
+         break;
+   }
+
+   if (i == ref_size)
+   {
+      if (ref_size == cap)
+         ref_size--;
+      i = ref_size++;
+      snprintf(tmp.path, sizeof(tmp.path), "%s", path ? path : "");
+      snprintf(tmp.core_path, sizeof(tmp.core_path), "%s", core_path);
+      snprintf(tmp.core_name, sizeof(tmp.core_name), "%s", core_name);
+      tmp.crc32 = crc32;
+   }
+   else
+   {
+      tmp = ref[i];
+      if (crc32)
+         tmp.crc32 = crc32;
+   }
+
+   memmove(ref + 1, ref, i * sizeof(*ref));
+   ref[0] = tmp;
+}
+
+static const char *ref_basename(const char *path)
+{
+   const char *slash = strrchr(path, '/');
+   return slash ? slash + 1 : path;
+}
+
+static bool ref_prefix(const char *name, const char *prefix)
+{
+   for (; *prefix; name++, prefix++)
+      if (tolower((unsigned char)*name) != tolower((unsigned char)*prefix))
+         return false;
+   return true;
+}
+
+static int ref_name_cmp(const void *a_, const void *b_)
+{
+   size_t a = *(const size_t*)a_, b = *(const size_t*)b_;
+   int ret = strcasecmp(ref_basename(ref[a].path), ref_basename(ref[b].path));
+   if (ret)
+      return ret;
+   return a < b ? -1 : a > b;
+}
+
+static void fail(const char *msg, size_t i)
+{
+   fprintf(stderr, "FAIL: %s (%u).\n", msg, (unsigned)i);
+   exit(1);
+}
+
+static void check(content_playlist_t *playlist)
+{
+   size_t i, j, indices[64], count;
+   static size_t expected[60000];
+
+   if (content_playlist_size(playlist) != ref_size)
+      fail("size", content_playlist_size(playlist));
+
+   for (i = 0; i < ref_size; i++)
+   {
+      const char *path, *core_path, *core_name;
+      content_playlist_get_index(playlist, i, &path, &core_path, &core_name);
+
+      if (strcmp(path ? path : "", ref[i].path)
+            || strcmp(core_path, ref[i].core_path)
+            || strcmp(core_name, ref[i].core_name))
+         fail("entry", i);
+   }
+
+   /* Expected: matching names in order, ties by MRU position. */
+   count = content_playlist_find_prefix(playlist, "GAME 1", indices, 64);
+   for (i = 0, j = 0; i < ref_size; i++)
+   {
+      if (ref_prefix(ref_basename(ref[i].path), "GAME 1"))
+         expected[j++] = i;
+   }
+   qsort(expected, j, sizeof(*expected), ref_name_cmp);
+
+   if (count != (j < 64 ? j : 64))
+      fail("find_prefix count", count);
+   for (i = 0; i < count; i++)
+   {
+      if (indices[i] != expected[i])
+         fail("find_prefix", i);
+   }
+}
+
+static double get_time(void)
+{
+   struct timespec tv;
+   clock_gettime(CLOCK_MONOTONIC, &tv);
+   return tv.tv_sec + tv.tv_nsec / 1000000000.0;
+}
+
+static void random_push(content_playlist_t *playlist, size_t cap,
+      unsigned range)
+{
+   char path[64], core_path[32], core_name[32];
+   unsigned game = rand() % range;
+   unsigned core = rand() % 4;
+   uint32_t crc  = (rand() % 3) ? game * 2654435761u + 1 : 0;
+
+   snprintf(path, sizeof(path), "/roms/sys%u/Game %u.bin", game % 7, game);
+   snprintf(core_path, sizeof(core_path), "/cores/core%u.so", core);
+   snprintf(core_name, sizeof(core_name), "Core %u v%u", core, rand() % 2);
+
+   if (!(rand() % 50))
+   {
+      content_playlist_push(playlist, NULL, core_path, core_name, 0);
+      ref_push(cap, NULL, core_path, core_name, 0);
+      return;
+   }
+
+   content_playlist_push(playlist, path, core_path, core_name, crc);
+   ref_push(cap, path, core_path, core_name, crc);
+}
+
+int main(int argc, char *argv[])
+{
+   size_t i, cap = 500;
+   unsigned round;
+   FILE *file;
+   double start;
+   content_playlist_t *playlist;
+   unsigned large = argc > 1 ? strtoul(argv[1], NULL, 0) : 50000;
+
+   (void)argc;
+   ref = (struct ref_entry*)calloc(large + 1, sizeof(*ref));
+
+   /* Old text format, newest first. */
+   remove(TEST_PATH);
+   file = fopen(TEST_PATH, "w");
+   fprintf(file, "/roms/a.bin\n/cores/x.so\nX\n"
+         "\n/cores/y.so\nY\n"
+         "/roms/b.bin\r\n/cores/x.so\r\nX\r\n"
+         "/roms/broken.bin\n\nX\n");
+   fclose(file);
+
+   playlist = content_playlist_init(TEST_PATH, cap);
+   ref_push(cap, "/roms/b.bin", "/cores/x.so", "X", 0);
+   ref_push(cap, NULL, "/cores/y.so", "Y", 0);
+   ref_push(cap, "/roms/a.bin", "/cores/x.so", "X", 0);
+   check(playlist);
+
+   for (round = 0; round < 200; round++)
+   {
+      unsigned ops = rand() % 40;
+
+      for (i = 0; i < ops; i++)
+         random_push(playlist, cap, 800);
+
+      if (!(rand() % 60))
+      {
+         content_playlist_clear(playlist);
+         ref_size = 0;
+      }
+
+      check(playlist);
+
+      /* Simulate a crash half way through a journal write. */
+      if (!(rand() % 20))
+      {
+         content_playlist_free(playlist);
+         file = fopen(TEST_PATH, "ab");
+         fwrite("\x01\x00\x00\x00\x40\x00\x00\x00garbage", 1, 15, file);
+         fclose(file);
+      }
+      else
+         content_playlist_free(playlist);
+
+      playlist = content_playlist_init(TEST_PATH, cap);
+      check(playlist);
+   }
+   content_playlist_free(playlist);
+
+   /* A large library. */
+   remove(TEST_PATH);
+   write_empty_file(TEST_PATH);
+   ref_size = 0;
+   playlist = content_playlist_init(TEST_PATH, large);
+
+   start = get_time();
+   for (i = 0; i < large; i++)
+   {
+      char path[64];
+      snprintf(path, sizeof(path), "/roms/sys%u/Game %u.bin",
+            (unsigned)(i % 7), (unsigned)i);
+      content_playlist_push(playlist, path, "/cores/core.so",
+            "Core", (uint32_t)i + 1);
+
+      /* All new, so no need to search the reference. */
+      snprintf(ref[large - 1 - i].path, sizeof(ref->path), "%s", path);
+      strcpy(ref[large - 1 - i].core_path, "/cores/core.so");
+      strcpy(ref[large - 1 - i].core_name, "Core");
+      ref[large - 1 - i].crc32 = (uint32_t)i + 1;
+   }
+   ref_size = large;
+   printf("%u pushes: %.3f s.\n", large, get_time() - start);
+
+   start = 0.0;
+   for (i = 0; i < 1000; i++)
+   {
+      char path[64];
+      double push_start;
+      snprintf(path, sizeof(path), "/roms/sys%u/Game %u.bin",
+            (unsigned)(i * 37 % large % 7), (unsigned)(i * 37 % large));
+
+      push_start = get_time();
+      content_playlist_push(playlist, path, "/cores/core.so", "Core", 0);
+      start += get_time() - push_start;
+
+      ref_push(large, path, "/cores/core.so", "Core", 0);
+   }
+   printf("1000 repeat pushes: %.3f ms.\n", start * 1000.0);
+   content_playlist_free(playlist);
+
+   start = get_time();
+   playlist = content_playlist_init(TEST_PATH, large);
+   printf("Open: %.3f ms.\n", (get_time() - start) * 1000.0);
+   check(playlist);
+   content_playlist_free(playlist);
+
+   remove(TEST_PATH);
+   free(ref);
+   printf("Playlist matches reference.\n");
+   return 0;
+}
@@ -0,0 +1,192 @@
+/*  RetroArch - A frontend for libretro.
+ *  Copyright (C) 2010-2014 - Hans-Kristian Arntzen
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Round trips states through the writer, compressed and not,
+ * loads a legacy raw state, checks that a failed write leaves the
+ * old state alone and that truncated or wrongly sized states are
+ * rejected, then times how long the caller is held up compared to a
+ * synchronous write. */
+
+#include "../savestate.h"
+#include "../general.h"
+#include "../file_path.h"
+#include "../performance.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define TEST_PATH "savestate_test.state"
+#define TEST_SIZE (16 * 1024 * 1024)
+
+struct settings g_settings;
+struct global g_extern;
+
+static size_t serialize_size(void)
+{
+   return TEST_SIZE;
+}
+
+size_t (*pretro_serialize_size)(void) = serialize_size;
+
+retro_time_t rarch_get_time_usec(void)
+{
+   struct timespec tv;
+   clock_gettime(CLOCK_MONOTONIC, &tv);
+   return (retro_time_t)tv.tv_sec * 1000000 + tv.tv_nsec / 1000;
+}
+
+static void fail(const char *msg)
+{
+   fprintf(stderr, "FAIL: %s.\n", msg);
+   exit(1);
+}
+
+/* Mostly zeroes with some noise, like emulated RAM. */
+static void fill_state(uint8_t *data, size_t size, unsigned seed)
+{
+   size_t i;
+   memset(data, 0, size);
+   srand(seed);
+   for (i = 0; i < size; i += 1 + rand() % 16)
+      data[i] = rand();
+}
+
+static void check_load(const char *path, const uint8_t *expected,
+      size_t size)
+{
+   struct savestate_data state;
+
+   if (!savestate_open(&state, path))
+      fail("open");
+   if (state.size != size || memcmp(state.data, expected, size))
+      fail("contents");
+   savestate_close(&state);
+}
+
+static void save(savestate_writer_t *writer, const char *path,
+      const uint8_t *data, size_t size, bool compress)
+{
+   void *buf = savestate_writer_buffer(writer, size);
+   if (!buf)
+      fail("buffer");
+   memcpy(buf, data, size);
+   if (!savestate_writer_submit(writer, path, size, compress))
+      fail("submit");
+}
+
+int main(void)
+{
+   unsigned i;
+   long len;
+   void *file = NULL;
+   char path[PATH_MAX];
+   retro_time_t start, stall = 0, sync = 0;
+   uint8_t *data = (uint8_t*)malloc(TEST_SIZE);
+   uint8_t *other = (uint8_t*)malloc(TEST_SIZE);
+   savestate_writer_t *writer = savestate_writer_new();
+
+   if (!data || !other || !writer)
+      fail("alloc");
+
+   fill_state(data, TEST_SIZE, 1);
+   fill_state(other, TEST_SIZE, 2);
+
+   /* Legacy states are plain serialized data. */
+   remove(TEST_PATH);
+   if (!write_file(TEST_PATH, data, TEST_SIZE))
+      fail("write_file");
+   check_load(TEST_PATH, data, TEST_SIZE);
+
+   save(writer, TEST_PATH, other, TEST_SIZE, true);
+   savestate_writer_flush(writer);
+   check_load(TEST_PATH, other, TEST_SIZE);
+
+   len = read_file(TEST_PATH, &file);
+   if (len <= SAVESTATE_HEADER_SIZE || len >= TEST_SIZE
+         || memcmp(file, SAVESTATE_MAGIC, 8))
+      fail("compressed header");
+   printf("Compressed %u -> %ld bytes.\n", TEST_SIZE, len);
+
+   /* Cut off half way, must not load. */
+   write_file(TEST_PATH, file, len / 2);
+   {
+      struct savestate_data state;
+      if (savestate_open(&state, TEST_PATH))
+         fail("truncated state loaded");
+   }
+
+   /* Claims a size the core doesn't use, must not load. */
+   ((uint8_t*)file)[18] ^= 0x80;
+   write_file(TEST_PATH, file, len);
+   free(file);
+   {
+      struct savestate_data state;
+      if (savestate_open(&state, TEST_PATH))
+         fail("state of the wrong size loaded");
+   }
+
+   /* Uncompressed states are written without a header. */
+   save(writer, TEST_PATH, data, TEST_SIZE, false);
+   /* Queued behind the first one. */
+   save(writer, TEST_PATH, other, TEST_SIZE, false);
+   savestate_writer_flush(writer);
+   if (savestate_writer_failed(writer, NULL, 0))
+      fail("write failed");
+   len = read_file(TEST_PATH, &file);
+   if (len != TEST_SIZE || memcmp(file, other, TEST_SIZE))
+      fail("uncompressed");
+   free(file);
+
+   /* The temporary file can't be created, the old state stays. */
+   snprintf(path, sizeof(path), "%s.tmp", TEST_PATH);
+   mkdir(path, 0755);
+   save(writer, TEST_PATH, data, TEST_SIZE, true);
+   savestate_writer_flush(writer);
+   if (!savestate_writer_failed(writer, path, sizeof(path))
+         || strcmp(path, TEST_PATH))
+      fail("failure not reported");
+   if (savestate_writer_failed(writer, NULL, 0))
+      fail("failure reported twice");
+   check_load(TEST_PATH, other, TEST_SIZE);
+   snprintf(path, sizeof(path), "%s.tmp", TEST_PATH);
+   rmdir(path);
+
+   /* Time the caller, up to the point emulation would resume. */
+   for (i = 0; i < 8; i++)
+   {
+      start = rarch_get_time_usec();
+      save(writer, TEST_PATH, (i & 1) ? data : other, TEST_SIZE, true);
+      stall += rarch_get_time_usec() - start;
+
+      /* As if the player saved again a few seconds later. */
+      savestate_writer_flush(writer);
+
+      start = rarch_get_time_usec();
+      write_file(TEST_PATH, (i & 1) ? data : other, TEST_SIZE);
+      sync += rarch_get_time_usec() - start;
+   }
+   printf("Caller held up: %.2f ms threaded, %.2f ms synchronous.\n",
+         stall / 8000.0, sync / 8000.0);
+
+   savestate_writer_free(writer);
+   remove(TEST_PATH);
+   free(data);
+   free(other);
+   printf("Savestates match.\n");
+   return 0;
+}
@@ -0,0 +1,302 @@
+/*  RetroArch - A frontend for libretro.
+ *  Copyright (C) 2010-2014 - Hans-Kristian Arntzen
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Checks the state tracker against a straightforward per-import
+ * evaluation and benchmarks it with a large set of imports. */
+
+#include "../gfx/state_tracker.h"
+#include "../general.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define NUM_IMPORTS 256
+#define NUM_ADDRESSES 64
+#define WRAM_SIZE 0x2000
+
+struct settings g_settings;
+struct global g_extern;
+driver_t driver;
+
+static uint16_t player2_state;
+
+size_t strlcpy(char *dest, const char *source, size_t size)
+{
+   size_t src_size = strlen(source);
+   if (size)
+   {
+      size_t len = src_size < size - 1 ? src_size : size - 1;
+      memcpy(dest, source, len);
+      dest[len] = '\0';
+   }
+   return src_size;
+}
+
+void input_push_analog_dpad(struct retro_keybind *binds, unsigned mode)
+{
+   (void)binds;
+   (void)mode;
+}
+
+void input_pop_analog_dpad(struct retro_keybind *binds)
+{
+   (void)binds;
+}
+
+static int16_t test_input_state(void *data,
+      const struct retro_keybind **binds, unsigned port,
+      unsigned device, unsigned index, unsigned id)
+{
+   (void)data;
+   (void)binds;
+   (void)device;
+   (void)index;
+   if (port == 0)
+      return (g_extern.frame_input >> id) & 1;
+   return port == 1 && (player2_state & (1 << id));
+}
+
+static input_driver_t test_input;
+
+/* The tracker as it was before imports were compiled. */
+struct reference
+{
+   const struct state_tracker_uniform_info *info;
+   uint32_t prev[2];
+   int frame_count;
+   int frame_count_prev;
+   uint32_t old_value;
+   int transition_count;
+};
+
+static const unsigned buttons[] = {
+   RETRO_DEVICE_ID_JOYPAD_R,
+   RETRO_DEVICE_ID_JOYPAD_L,
+   RETRO_DEVICE_ID_JOYPAD_X,
+   RETRO_DEVICE_ID_JOYPAD_A,
+   RETRO_DEVICE_ID_JOYPAD_RIGHT,
+   RETRO_DEVICE_ID_JOYPAD_LEFT,
+   RETRO_DEVICE_ID_JOYPAD_DOWN,
+   RETRO_DEVICE_ID_JOYPAD_UP,
+   RETRO_DEVICE_ID_JOYPAD_START,
+   RETRO_DEVICE_ID_JOYPAD_SELECT,
+   RETRO_DEVICE_ID_JOYPAD_Y,
+   RETRO_DEVICE_ID_JOYPAD_B,
+};
+
+static uint16_t reference_fetch(const struct reference *ref,
+      const uint8_t *wram, const uint16_t *input)
+{
+   uint16_t val = 0;
+   uint16_t mask = ref->info->mask ? ref->info->mask : 0xffff;
+
+   switch (ref->info->ram_type)
+   {
+      case RARCH_STATE_WRAM:
+         val = wram[ref->info->addr];
+         break;
+      case RARCH_STATE_INPUT_SLOT1:
+         val = input[0];
+         break;
+      case RARCH_STATE_INPUT_SLOT2:
+         val = input[1];
+         break;
+      default:
+         break;
+   }
+
+   val &= mask;
+   if (ref->info->equal && val != ref->info->equal)
+      val = 0;
+   return val;
+}
+
+static float reference_update(struct reference *ref,
+      const uint8_t *wram, const uint16_t *input, unsigned frame_count)
+{
+   uint16_t val = reference_fetch(ref, wram, input);
+
+   switch (ref->info->type)
+   {
+      case RARCH_STATE_CAPTURE:
+         return val;
+
+      case RARCH_STATE_CAPTURE_PREV:
+         if (ref->prev[0] != val)
+         {
+            ref->prev[1] = ref->prev[0];
+            ref->prev[0] = val;
+         }
+         return ref->prev[1];
+
+      case RARCH_STATE_TRANSITION:
+         if (ref->old_value != val)
+         {
+            ref->old_value = val;
+            ref->frame_count = frame_count;
+         }
+         return ref->frame_count;
+
+      case RARCH_STATE_TRANSITION_COUNT:
+         if (ref->old_value != val)
+         {
+            ref->old_value = val;
+            ref->transition_count++;
+         }
+         return ref->transition_count;
+
+      case RARCH_STATE_TRANSITION_PREV:
+         if (ref->old_value != val)
+         {
+            ref->old_value = val;
+            ref->frame_count_prev = ref->frame_count;
+            ref->frame_count = frame_count;
+         }
+         return ref->frame_count_prev;
+
+      default:
+         return 0.0f;
+   }
+}
+
+static double get_time(void)
+{
+   struct timespec tv;
+   clock_gettime(CLOCK_MONOTONIC, &tv);
+   return tv.tv_sec + tv.tv_nsec / 1000000000.0;
+}
+
+static void set_input(unsigned frame)
+{
+   g_extern.frame_input = (frame / 3) & 0xfff;
+   player2_state = (frame / 5) & 0xfff;
+}
+
+/* Queries both players for every button, like the tracker used to. */
+static void reference_input(uint16_t *input)
+{
+   unsigned i;
+
+   input[0] = input[1] = 0;
+   for (i = 4; i < 16; i++)
+   {
+      input[0] |= (driver.input->input_state(driver.input_data, NULL, 0,
+               RETRO_DEVICE_JOYPAD, 0, buttons[i - 4]) ? 1 : 0) << i;
+      input[1] |= (driver.input->input_state(driver.input_data, NULL, 1,
+               RETRO_DEVICE_JOYPAD, 0, buttons[i - 4]) ? 1 : 0) << i;
+   }
+}
+
+int main(int argc, char *argv[])
+{
+   unsigned i, frame;
+   unsigned frames = argc > 1 ? strtoul(argv[1], NULL, 0) : 100000;
+   static uint8_t wram[WRAM_SIZE];
+   static struct state_tracker_uniform_info imports[NUM_IMPORTS];
+   static struct reference refs[NUM_IMPORTS];
+   static struct state_tracker_uniform uniforms[NUM_IMPORTS];
+   struct state_tracker_info info = {0};
+   state_tracker_t *tracker;
+   uint16_t input[2];
+   double start, tracker_time, reference_time;
+   volatile float sink = 0.0f;
+
+   test_input.input_state = test_input_state;
+   driver.input = &test_input;
+
+   srand(0);
+   for (i = 0; i < NUM_IMPORTS; i++)
+   {
+      snprintf(imports[i].id, sizeof(imports[i].id), "import%u", i);
+      imports[i].type = (enum state_tracker_type)
+         (rand() % (RARCH_STATE_TRANSITION_PREV + 1));
+      imports[i].ram_type = (i % 16 == 0) ? RARCH_STATE_INPUT_SLOT1 :
+         (i % 16 == 1) ? RARCH_STATE_INPUT_SLOT2 : RARCH_STATE_WRAM;
+      imports[i].addr = (rand() % NUM_ADDRESSES) * 97 % WRAM_SIZE;
+      imports[i].mask = (rand() % 4) ? 0 : 0x0f;
+      imports[i].equal = (rand() % 8) ? 0 : 3;
+      refs[i].info = &imports[i];
+   }
+
+   info.wram = wram;
+   info.info = imports;
+   info.info_elem = NUM_IMPORTS;
+
+   tracker = state_tracker_init(&info);
+   if (!tracker)
+   {
+      fprintf(stderr, "Failed to create state tracker.\n");
+      return 1;
+   }
+
+   for (frame = 0; frame < 10000; frame++)
+   {
+      wram[(rand() % NUM_ADDRESSES) * 97 % WRAM_SIZE] = rand();
+      set_input(frame);
+      reference_input(input);
+
+      if (state_get_uniform(tracker, uniforms,
+               NUM_IMPORTS, frame) != NUM_IMPORTS)
+      {
+         fprintf(stderr, "Wrong number of uniforms.\n");
+         return 1;
+      }
+
+      for (i = 0; i < NUM_IMPORTS; i++)
+      {
+         float expected = reference_update(&refs[i], wram, input, frame);
+         if (strcmp(uniforms[i].id, imports[i].id) ||
+               uniforms[i].value != expected)
+         {
+            fprintf(stderr, "Frame %u, %s (type %d): got %s = %f, expected %f.\n",
+                  frame, imports[i].id, imports[i].type,
+                  uniforms[i].id, uniforms[i].value, expected);
+            return 1;
+         }
+      }
+   }
+
+   start = get_time();
+   for (frame = 0; frame < frames; frame++)
+   {
+      wram[frame % WRAM_SIZE] = frame;
+      set_input(frame);
+      state_get_uniform(tracker, uniforms, NUM_IMPORTS, frame);
+      sink += uniforms[frame % NUM_IMPORTS].value;
+   }
+   tracker_time = get_time() - start;
+
+   start = get_time();
+   for (frame = 0; frame < frames; frame++)
+   {
+      wram[frame % WRAM_SIZE] = frame;
+      set_input(frame);
+      reference_input(input);
+      for (i = 0; i < NUM_IMPORTS; i++)
+         uniforms[i].value = reference_update(&refs[i], wram, input, frame);
+      sink += uniforms[frame % NUM_IMPORTS].value;
+   }
+   reference_time = get_time() - start;
+
+   printf("%u imports, %u frames.\n", NUM_IMPORTS, frames);
+   printf("State tracker: %8.1f ns/frame.\n", 1e9 * tracker_time / frames);
+   printf("Reference:     %8.1f ns/frame (%.2fx).\n",
+         1e9 * reference_time / frames, reference_time / tracker_time);
+   printf("Compiled imports match per-import evaluation.\n");
+
+   state_tracker_free(tracker);
+   return 0;
+}
@@ -0,0 +1,106 @@
+#!/bin/sh
+##########
+# Runs a libretro core headless through a matrix of frontend features
+# with --benchmark and collects one JSON report per run.
+#
+# Usage: tools/retroarch-benchmark.sh [-n frames] [-o outdir] [-L core [content]]
+#
+# Without -L, libretro-test is built and used, which makes the numbers
+# comparable between frontend revisions. Netplay is only initialized for
+# cores with content, and rewind is refused for cores using threaded audio,
+# so those runs need a real core to be meaningful.
+##########
+
+FRAMES=3600
+OUTDIR=benchmark
+CORE=
+CONTENT=
+RETROARCH=./retroarch
+PORT=55436
+
+die()
+{
+   echo "$@" >&2
+   exit 1
+}
+
+while getopts "n:o:L:" opt; do
+   case "$opt" in
+      n) FRAMES="$OPTARG" ;;
+      o) OUTDIR="$OPTARG" ;;
+      L) CORE="$OPTARG" ;;
+      *) die "Usage: $0 [-n frames] [-o outdir] [-L core [content]]" ;;
+   esac
+done
+shift $((OPTIND - 1))
+CONTENT="$1"
+
+[ -x "$RETROARCH" ] || die "Run this from the top of a built RetroArch tree."
+
+if [ -z "$CORE" ]; then
+   make -C libretro-test >/dev/null || die "Failed to build libretro-test."
+   CORE=libretro-test/test_libretro.so
+fi
+
+mkdir -p "$OUTDIR" || die "Failed to create $OUTDIR."
+
+BASE="$OUTDIR/common.cfg"
+cat > "$BASE" <<CFG
+video_driver = "null"
+audio_driver = "null"
+input_driver = "null"
+input_joypad_driver = "null"
+config_save_on_exit = "false"
+savefile_directory = "$OUTDIR"
+savestate_directory = "$OUTDIR"
+CFG
+
+# run <name> <extra config lines> [retroarch args ...]
+run()
+{
+   name="$1"
+   extra="$2"
+   shift 2
+
+   cfg="$OUTDIR/$name.cfg"
+   cp "$BASE" "$cfg"
+   [ -n "$extra" ] && printf '%b\n' "$extra" >> "$cfg"
+
+   echo "=== $name"
+   "$RETROARCH" -c "$cfg" -L "$CORE" --max-frames "$FRAMES" \
+      --benchmark "$OUTDIR/$name.json" "$@" ${CONTENT:+"$CONTENT"} >"$OUTDIR/$name.log" 2>&1 \
+      || echo "$name failed, see $OUTDIR/$name.log" >&2
+}
+
+run base ""
+run rewind "rewind_enable = \"true\""
+run resampler-cc "audio_resampler = \"CC\""
+run resampler-nearest "audio_resampler = \"nearest\""
+
+if make -C gfx/filters >/dev/null 2>&1; then
+   run softfilter "video_filter = \"gfx/filters/Scale2x.filt\""
+else
+   echo "Skipping softfilter, failed to build gfx/filters." >&2
+fi
+
+if make -C audio/filters >/dev/null 2>&1; then
+   run dsp "audio_dsp_plugin = \"audio/filters/Echo.dsp\""
+else
+   echo "Skipping dsp, failed to build audio/filters." >&2
+fi
+
+run record "" --record "$OUTDIR/record.rlv"
+rm -f "$OUTDIR/record.rlv"
+
+# Netplay runs both peers over loopback, the host report is netplay.json.
+if [ -n "$CONTENT" ]; then
+   run netplay "" -H --port "$PORT" &
+   HOST=$!
+   sleep 1
+   run netplay-client "" -C 127.0.0.1 --port "$PORT"
+   wait "$HOST"
+else
+   echo "Skipping netplay, it needs content to be loaded." >&2
+fi
+
+echo "Reports written to $OUTDIR."
@@ -0,0 +1,184 @@
+#!/bin/sh
+##########
+# Replays BSV movies headless and in parallel, and checks them against
+# golden state hashes. Useful for testing cores for determinism and the
+# frontend for regressions.
+#
+# Usage: tools/retroarch-replay.sh [-j workers] [-n interval] [-o outdir] [-u] jobfile
+#
+# Every line of jobfile is a job: "core content movie [golden]", separated
+# by whitespace, so paths can't contain any. Lines starting with # are
+# skipped. golden defaults to the movie path with .golden appended.
+#
+# Each job runs in its own RetroArch process with null drivers and no frame
+# limiting, and writes a CRC32 of the core's state every interval frames
+# (default 60). These are compared to the golden file, and the first
+# checkpoint which differs is reported. With -u, the golden files are
+# written from this run instead.
+#
+# Exits with 1 if any job failed or diverged.
+##########
+
+RETROARCH="${RETROARCH:-./retroarch}"
+WORKERS=
+INTERVAL=60
+OUTDIR=replay
+UPDATE=0
+
+die()
+{
+   echo "$@" >&2
+   exit 1
+}
+
+# Worker, runs one job: retroarch-replay.sh -x <job number>.
+# Setup is passed on from the main invocation through the environment.
+if [ "$1" = "-x" ]; then
+   n="$2"
+   set -- $(sed -n "${n}p" "$REPLAY_OUTDIR/jobs.txt")
+   "$RETROARCH" -c "$REPLAY_OUTDIR/replay.cfg" -L "$1" -M noload-nosave \
+      -P "$3" --eof-exit --benchmark "$REPLAY_OUTDIR/$n.json" \
+      --checkpoints "$REPLAY_OUTDIR/$n.chk" \
+      --checkpoint-interval "$REPLAY_INTERVAL" "$2" \
+      >"$REPLAY_OUTDIR/$n.log" 2>&1
+   echo $? > "$REPLAY_OUTDIR/$n.status"
+   exit 0
+fi
+
+while getopts "j:n:o:u" opt; do
+   case "$opt" in
+      j) WORKERS="$OPTARG" ;;
+      n) INTERVAL="$OPTARG" ;;
+      o) OUTDIR="$OPTARG" ;;
+      u) UPDATE=1 ;;
+      *) die "Usage: $0 [-j workers] [-n interval] [-o outdir] [-u] jobfile" ;;
+   esac
+done
+shift $((OPTIND - 1))
+JOBFILE="$1"
+
+[ -n "$JOBFILE" ] || die "Usage: $0 [-j workers] [-n interval] [-o outdir] [-u] jobfile"
+[ -r "$JOBFILE" ] || die "Can't read $JOBFILE."
+[ -x "$RETROARCH" ] || die "Run this from the top of a built RetroArch tree, or set RETROARCH."
+
+
+mkdir -p "$OUTDIR" || die "Failed to create $OUTDIR."
+rm -f "$OUTDIR"/*.chk "$OUTDIR"/*.json "$OUTDIR"/*.log "$OUTDIR"/*.status
+
+# One job per line, golden filled in.
+awk '!/^[ \t]*(#|$)/ {
+   if (NF < 3) { print "Bad job on line " NR ": " $0 > "/dev/stderr"; exit 1 }
+   print $1, $2, $3, (NF > 3 ? $4 : $3 ".golden")
+}' "$JOBFILE" > "$OUTDIR/jobs.txt" || die "Failed to read jobs."
+
+JOBS=$(wc -l < "$OUTDIR/jobs.txt")
+[ "$JOBS" -gt 0 ] || die "No jobs in $JOBFILE."
+
+if [ -z "$WORKERS" ]; then
+   WORKERS=$(getconf _NPROCESSORS_ONLN 2>/dev/null || echo 1)
+fi
+[ "$WORKERS" -gt "$JOBS" ] && WORKERS="$JOBS"
+
+cat > "$OUTDIR/replay.cfg" <<CFG
+video_driver = "null"
+audio_driver = "null"
+input_driver = "null"
+input_joypad_driver = "null"
+config_save_on_exit = "false"
+rewind_enable = "false"
+savestate_auto_load = "false"
+savefile_directory = "$OUTDIR"
+savestate_directory = "$OUTDIR"
+CFG
+
+echo "Replaying $JOBS movies, $WORKERS at a time."
+
+REPLAY_OUTDIR="$OUTDIR"
+REPLAY_INTERVAL="$INTERVAL"
+export RETROARCH REPLAY_OUTDIR REPLAY_INTERVAL
+
+START=$(date +%s.%N)
+seq 1 "$JOBS" | xargs -P "$WORKERS" -n 1 sh "$0" -x
+END=$(date +%s.%N)
+
+# Prints "match", "diverged <last good> <first bad>", "short <frame>"
+# or "long <frame>" for a checkpoint file against its golden file.
+# Only frames checkpointed in both are compared, so the interval may differ.
+compare()
+{
+   awk '
+      NR == FNR { golden[$1] = $2; last = $1; next }
+      $1 > last { result = "long " $1; exit }
+      $1 in golden {
+         if (golden[$1] != $2) { result = "diverged " good " " $1; exit }
+         good = $1
+      }
+      { ran = $1 }
+      END {
+         if (result == "" && ran < last)
+            result = "short " ran
+         print (result == "" ? "match" : result)
+      }' good=0 ran=0 "$1" "$2"
+}
+
+# Pulls a number out of the benchmark report.
+json_value()
+{
+   sed -n "s/^  \"$2\": \"\{0,1\}\([^\",]*\).*/\1/p" "$1"
+}
+
+FAILED=0
+: > "$OUTDIR/throughput.txt"
+
+n=0
+while read -r core content movie golden; do
+   n=$((n + 1))
+   chk="$OUTDIR/$n.chk"
+   status=$(cat "$OUTDIR/$n.status" 2>/dev/null || echo 1)
+
+   if [ "$status" -ne 0 ] || [ ! -s "$chk" ]; then
+      result="FAILED, see $OUTDIR/$n.log"
+      FAILED=1
+   elif [ "$UPDATE" -eq 1 ]; then
+      cp "$chk" "$golden" && result="golden written to $golden"
+   elif [ ! -f "$golden" ]; then
+      result="no golden file $golden"
+      FAILED=1
+   else
+      set -- $(compare "$golden" "$chk")
+      case "$1" in
+         match) result="match" ;;
+         diverged) result="DIVERGED between frames $2 and $3" ;;
+         short) result="DIVERGED, ended after frame $2" ;;
+         long) result="DIVERGED, ran past the golden file at frame $2" ;;
+      esac
+      [ "$1" = match ] || FAILED=1
+   fi
+
+   frames=0
+   seconds=0
+   if [ -f "$OUTDIR/$n.json" ]; then
+      frames=$(json_value "$OUTDIR/$n.json" frames)
+      seconds=$(json_value "$OUTDIR/$n.json" seconds)
+      name=$(json_value "$OUTDIR/$n.json" core)
+      printf '%s\t%s\t%s\n' "${name:-$core}" "$frames" "$seconds" \
+         >> "$OUTDIR/throughput.txt"
+   fi
+
+   printf '%s: %s (%s frames, %s s)\n' "$movie" "$result" "$frames" "$seconds"
+done < "$OUTDIR/jobs.txt"
+
+echo
+echo "Throughput:"
+awk -F '\t' -v wall="$(echo "$END $START" | awk '{ print $1 - $2 }')" -v workers="$WORKERS" '
+   { frames[$1] += $2; seconds[$1] += $3; total += $2 }
+   END {
+      for (core in frames)
+         printf "  %s: %d frames, %.1f frames/s per process\n", core,
+            frames[core], (seconds[core] > 0 ? frames[core] / seconds[core] : 0)
+      if (wall > 0)
+         printf "  All: %d frames in %.2f s, %.1f frames/s, %.1f frames/s per worker\n",
+            total, wall, total / wall, total / wall / workers
+   }' "$OUTDIR/throughput.txt"
+
+exit "$FAILED"
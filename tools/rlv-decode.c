@@ -0,0 +1,497 @@
+/*  RetroArch - A frontend for libretro.
+ *  Copyright (C) 2010-2014 - Hans-Kristian Arntzen
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Decodes and verifies .rlv recordings made by the built-in
+ * recording backend. Frames can be dumped as raw video,
+ * audio as raw S16 PCM, for use with e.g. ffmpeg -f rawvideo. */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <zlib.h>
+#include "../compat/getopt_rarch.h"
+#include "../boolean.h"
+#include "../record/ffemu.h"
+#include "../record/rlv.h"
+
+static char *g_in_path = NULL;
+static char *g_video_path = NULL;
+static char *g_audio_path = NULL;
+static bool g_verbose = false;
+
+struct rlv_decoder
+{
+   FILE *file;
+   FILE *video_out;
+   FILE *audio_out;
+
+   unsigned pix_fmt;
+   size_t pix_size;
+   unsigned channels;
+
+   z_stream stream;
+   uint8_t *payload;
+   size_t payload_size;
+   uint8_t *frame;
+   size_t frame_size;
+   unsigned width;
+   unsigned height;
+   bool has_frame;
+
+   unsigned frames;
+   unsigned keyframes;
+   unsigned deltas;
+   unsigned dupes;
+   uint64_t audio_frames;
+   uint64_t compressed_video;
+};
+
+static void print_help(void)
+{
+   puts("============");
+   puts(" rlv-decode");
+   puts("============");
+   puts("Usage: rlv-decode [ options ... ] file.rlv");
+   puts("");
+   puts("Decodes a lossless recording and verifies the checksum of every frame.");
+   puts("-v/--video: Writes decoded frames as tightly packed raw video to file.");
+   puts("\tDupe frames are written out again, so the frame rate stays constant.");
+   puts("-a/--audio: Writes decoded audio as raw interleaved S16 native endian PCM to file.");
+   puts("-V/--verbose: Prints every packet.");
+   puts("-h/--help: This help.");
+}
+
+static uint32_t read_le32(const uint8_t *buf)
+{
+   return (uint32_t)buf[0] | ((uint32_t)buf[1] << 8) |
+      ((uint32_t)buf[2] << 16) | ((uint32_t)buf[3] << 24);
+}
+
+static double read_le64_double(const uint8_t *buf)
+{
+   double val;
+   uint64_t bits = read_le32(buf) | ((uint64_t)read_le32(buf + 4) << 32);
+   memcpy(&val, &bits, sizeof(val));
+   return val;
+}
+
+static const char *pix_fmt_name(unsigned pix_fmt)
+{
+   switch (pix_fmt)
+   {
+      case FFEMU_PIX_RGB565:
+         return "rgb565le";
+      case FFEMU_PIX_BGR24:
+         return "bgr24";
+      case FFEMU_PIX_ARGB8888:
+         return "bgra";
+      default:
+         return "unknown";
+   }
+}
+
+static bool grow_buffer(uint8_t **buf, size_t *buf_size, size_t size)
+{
+   uint8_t *new_buf;
+   if (size <= *buf_size)
+      return true;
+
+   new_buf = (uint8_t*)realloc(*buf, size);
+   if (!new_buf)
+      return false;
+
+   *buf = new_buf;
+   *buf_size = size;
+   return true;
+}
+
+static bool decode_video(struct rlv_decoder *dec, unsigned type,
+      uint32_t crc, size_t size)
+{
+   size_t i, frame_size;
+   unsigned width, height;
+   bool keyframe = type == RLV_PACKET_KEYFRAME;
+
+   if (size < RLV_VIDEO_HEADER_SIZE)
+   {
+      fprintf(stderr, "Truncated video packet.\n");
+      return false;
+   }
+
+   width  = read_le32(dec->payload + 0);
+   height = read_le32(dec->payload + 4);
+   frame_size = (size_t)width * height * dec->pix_size;
+
+   if (!keyframe && (!dec->has_frame ||
+            width != dec->width || height != dec->height))
+   {
+      fprintf(stderr, "Delta frame %u has no matching reference frame.\n",
+            dec->frames);
+      return false;
+   }
+
+   if (!grow_buffer(&dec->frame, &dec->frame_size, frame_size))
+      return false;
+
+   /* Deltas are decoded into the reference frame in place, by XOR-ing
+    * the inflated output. Keyframes inflate straight into it. */
+   if (inflateReset(&dec->stream) != Z_OK)
+      return false;
+
+   dec->stream.next_in  = dec->payload + RLV_VIDEO_HEADER_SIZE;
+   dec->stream.avail_in = size - RLV_VIDEO_HEADER_SIZE;
+
+   if (keyframe)
+   {
+      dec->stream.next_out  = dec->frame;
+      dec->stream.avail_out = frame_size;
+      if (inflate(&dec->stream, Z_FINISH) != Z_STREAM_END ||
+            dec->stream.total_out != frame_size)
+      {
+         fprintf(stderr, "Corrupt keyframe %u.\n", dec->frames);
+         return false;
+      }
+   }
+   else
+   {
+      size_t pos = 0;
+      int ret    = Z_OK;
+      uint8_t chunk[16 * 1024];
+
+      while (ret != Z_STREAM_END)
+      {
+         size_t got;
+         dec->stream.next_out  = chunk;
+         dec->stream.avail_out = sizeof(chunk);
+
+         ret = inflate(&dec->stream, Z_NO_FLUSH);
+         if (ret != Z_OK && ret != Z_STREAM_END)
+            break;
+
+         got = sizeof(chunk) - dec->stream.avail_out;
+         if (pos + got > frame_size)
+            break;
+
+         for (i = 0; i < got; i++)
+            dec->frame[pos + i] ^= chunk[i];
+         pos += got;
+
+         if (ret == Z_OK && !got && !dec->stream.avail_in)
+            break;
+      }
+
+      if (ret != Z_STREAM_END || pos != frame_size)
+      {
+         fprintf(stderr, "Corrupt delta frame %u.\n", dec->frames);
+         return false;
+      }
+   }
+
+   if (crc32(0, dec->frame, frame_size) != crc)
+   {
+      fprintf(stderr, "Checksum mismatch in frame %u.\n", dec->frames);
+      return false;
+   }
+
+   if (g_verbose)
+      fprintf(stderr, "Frame %u: %s %ux%u, %u bytes.\n", dec->frames,
+            keyframe ? "keyframe" : "delta", width, height, (unsigned)size);
+
+   if (keyframe)
+      dec->keyframes++;
+   else
+      dec->deltas++;
+
+   dec->width     = width;
+   dec->height    = height;
+   dec->has_frame = true;
+   dec->compressed_video += size;
+   return true;
+}
+
+static bool write_frame(struct rlv_decoder *dec)
+{
+   size_t size;
+   if (!dec->video_out)
+      return true;
+
+   size = (size_t)dec->width * dec->height * dec->pix_size;
+   if (fwrite(dec->frame, 1, size, dec->video_out) != size)
+   {
+      fprintf(stderr, "Failed to write video.\n");
+      return false;
+   }
+   return true;
+}
+
+static bool decode_packet(struct rlv_decoder *dec, unsigned type,
+      uint32_t crc, size_t size, bool *end)
+{
+   switch (type)
+   {
+      case RLV_PACKET_KEYFRAME:
+      case RLV_PACKET_DELTA:
+         if (!decode_video(dec, type, crc, size) || !write_frame(dec))
+            return false;
+         dec->frames++;
+         break;
+
+      case RLV_PACKET_DUPE:
+         if (!dec->has_frame || crc32(0, dec->frame,
+                  (size_t)dec->width * dec->height * dec->pix_size) != crc)
+         {
+            fprintf(stderr, "Dupe frame %u does not match previous frame.\n",
+                  dec->frames);
+            return false;
+         }
+         if (g_verbose)
+            fprintf(stderr, "Frame %u: dupe.\n", dec->frames);
+         if (!write_frame(dec))
+            return false;
+         dec->dupes++;
+         dec->frames++;
+         break;
+
+      case RLV_PACKET_AUDIO:
+         if (size % (dec->channels * sizeof(int16_t)) ||
+               crc32(0, dec->payload, size) != crc)
+         {
+            fprintf(stderr, "Corrupt audio packet.\n");
+            return false;
+         }
+         dec->audio_frames += size / (dec->channels * sizeof(int16_t));
+
+         if (dec->audio_out)
+         {
+            /* Stored as little endian, convert in place for big endian hosts. */
+            size_t i;
+            int16_t *samples = (int16_t*)dec->payload;
+            for (i = 0; i < size / sizeof(int16_t); i++)
+               samples[i] = (int16_t)(dec->payload[2 * i] |
+                     (dec->payload[2 * i + 1] << 8));
+
+            if (fwrite(dec->payload, 1, size, dec->audio_out) != size)
+            {
+               fprintf(stderr, "Failed to write audio.\n");
+               return false;
+            }
+         }
+         break;
+
+      case RLV_PACKET_END:
+         if (size < 4 || read_le32(dec->payload) != dec->frames)
+         {
+            fprintf(stderr, "Frame count mismatch, file is damaged.\n");
+            return false;
+         }
+         *end = true;
+         break;
+
+      default:
+         fprintf(stderr, "Unknown packet type %u.\n", type);
+         return false;
+   }
+
+   return true;
+}
+
+static bool decode_file(struct rlv_decoder *dec)
+{
+   uint8_t header[RLV_HEADER_SIZE];
+   double fps, samplerate;
+   bool end = false;
+
+   if (fread(header, 1, sizeof(header), dec->file) != sizeof(header) ||
+         memcmp(header, RLV_MAGIC, 4) != 0)
+   {
+      fprintf(stderr, "Not an RLV file.\n");
+      return false;
+   }
+
+   dec->pix_fmt  = read_le32(header + 4);
+   dec->channels = read_le32(header + 8);
+   fps           = read_le64_double(header + 16);
+   samplerate    = read_le64_double(header + 24);
+
+   switch (dec->pix_fmt)
+   {
+      case FFEMU_PIX_RGB565:
+         dec->pix_size = sizeof(uint16_t);
+         break;
+      case FFEMU_PIX_BGR24:
+         dec->pix_size = 3;
+         break;
+      case FFEMU_PIX_ARGB8888:
+         dec->pix_size = sizeof(uint32_t);
+         break;
+      default:
+         fprintf(stderr, "Unknown pixel format %u.\n", dec->pix_fmt);
+         return false;
+   }
+
+   if (!dec->channels)
+   {
+      fprintf(stderr, "Invalid channel count.\n");
+      return false;
+   }
+
+   fprintf(stderr, "Format: %s, %.3f FPS, aspect %.4f.\n",
+         pix_fmt_name(dec->pix_fmt), fps,
+         read_le32(header + 12) / 1000000.0);
+   fprintf(stderr, "Audio: %u channels, %.1f Hz.\n", dec->channels, samplerate);
+
+   while (!end)
+   {
+      uint8_t packet[RLV_PACKET_SIZE];
+      unsigned type;
+      uint32_t size, crc;
+
+      if (fread(packet, 1, sizeof(packet), dec->file) != sizeof(packet))
+      {
+         fprintf(stderr, "Unexpected end of file, recording was not finalized.\n");
+         return false;
+      }
+
+      type = read_le32(packet + 0);
+      size = read_le32(packet + 4);
+      crc  = read_le32(packet + 8);
+
+      if (!grow_buffer(&dec->payload, &dec->payload_size, size) ||
+            fread(dec->payload, 1, size, dec->file) != size)
+      {
+         fprintf(stderr, "Truncated packet.\n");
+         return false;
+      }
+
+      if (!decode_packet(dec, type, crc, size, &end))
+         return false;
+   }
+
+   fprintf(stderr, "Frames: %u (%u keyframes, %u deltas, %u dupes).\n",
+         dec->frames, dec->keyframes, dec->deltas, dec->dupes);
+   if (dec->has_frame)
+      fprintf(stderr, "Last frame: %ux%u.\n", dec->width, dec->height);
+   if (dec->keyframes + dec->deltas)
+      fprintf(stderr, "Average compressed frame: %.1f kB.\n",
+            dec->compressed_video / (1024.0 * (dec->keyframes + dec->deltas)));
+   fprintf(stderr, "Duration: %.3f s video, %.3f s audio.\n",
+         fps > 0.0 ? dec->frames / fps : 0.0,
+         samplerate > 0.0 ? dec->audio_frames / samplerate : 0.0);
+   return true;
+}
+
+static void parse_input(int argc, char *argv[])
+{
+   char optstring[] = "v:a:Vh";
+   struct option opts[] = {
+      { "video", 1, NULL, 'v' },
+      { "audio", 1, NULL, 'a' },
+      { "verbose", 0, NULL, 'V' },
+      { "help", 0, NULL, 'h' },
+      { NULL, 0, NULL, 0 }
+   };
+
+   int option_index = 0;
+   for (;;)
+   {
+      int c = getopt_long(argc, argv, optstring, opts, &option_index);
+      if (c == -1)
+         break;
+
+      switch (c)
+      {
+         case 'h':
+            print_help();
+            exit(0);
+
+         case 'v':
+            g_video_path = strdup(optarg);
+            break;
+
+         case 'a':
+            g_audio_path = strdup(optarg);
+            break;
+
+         case 'V':
+            g_verbose = true;
+            break;
+
+         default:
+            break;
+      }
+   }
+
+   if (optind != argc - 1)
+   {
+      print_help();
+      exit(1);
+   }
+
+   g_in_path = strdup(argv[optind]);
+}
+
+int main(int argc, char *argv[])
+{
+   int ret = 1;
+   struct rlv_decoder dec;
+
+   parse_input(argc, argv);
+   memset(&dec, 0, sizeof(dec));
+
+   if (inflateInit2(&dec.stream, -MAX_WBITS) != Z_OK)
+      return 1;
+
+   dec.file = fopen(g_in_path, "rb");
+   if (!dec.file)
+   {
+      fprintf(stderr, "Failed to open %s.\n", g_in_path);
+      goto end;
+   }
+
+   if (g_video_path && !(dec.video_out = fopen(g_video_path, "wb")))
+   {
+      fprintf(stderr, "Failed to open %s.\n", g_video_path);
+      goto end;
+   }
+
+   if (g_audio_path && !(dec.audio_out = fopen(g_audio_path, "wb")))
+   {
+      fprintf(stderr, "Failed to open %s.\n", g_audio_path);
+      goto end;
+   }
+
+   if (decode_file(&dec))
+      ret = 0;
+
+end:
+   inflateEnd(&dec.stream);
+   if (dec.file)
+      fclose(dec.file);
+   if (dec.video_out && fclose(dec.video_out) != 0)
+      ret = 1;
+   if (dec.audio_out && fclose(dec.audio_out) != 0)
+      ret = 1;
+   free(dec.payload);
+   free(dec.frame);
+   free(g_in_path);
+   free(g_video_path);
+   free(g_audio_path);
+   return ret;
+}